@@ -59,6 +59,14 @@ err_t dhcp_start(struct netif *netif);
 
 #define THREAD_STACKSIZE ((8*1024)/sizeof(size_t)) /* 8KB */
 
+/* Per transfer logging in the I/O callbacks. Printing to the UART for every
+ * record limits TLS throughput, so it is only built with DEBUG_NETWORKING_IO */
+#ifdef DEBUG_NETWORKING_IO
+    #define NET_IO_LOG(...) xil_printf(__VA_ARGS__)
+#else
+    #define NET_IO_LOG(...) do {} while (0)
+#endif
+
 static struct netif server_netif;
 struct netif *echo_netif;
 int network_ready = 0;
@@ -241,6 +249,12 @@ int SockIORecv(WOLFSSL* ssl, char* buff, int sz, void* ctx)
     if ((recvd = (int)recv(sockCtx->fd, buff, sz, 0)) == -1) {
         /* error encountered. Be responsible and report it in wolfSSL terms */
 
+        /* non-blocking sockets end up here on every poll, so don't log it */
+        if ((errno == EWOULDBLOCK || errno == EAGAIN) &&
+                wolfSSL_get_using_nonblock(ssl)) {
+            return WOLFSSL_CBIO_ERR_WANT_READ;
+        }
+
         xil_printf("IO RECEIVE ERROR: ");
         switch (errno) {
     #if EAGAIN != EWOULDBLOCK
@@ -286,10 +300,8 @@ int SockIORecv(WOLFSSL* ssl, char* buff, int sz, void* ctx)
     }
 #endif
 
-#ifdef DEBUG_WOLFTPM
     /* successful receive */
-    xil_printf("SockIORecv: received %d bytes from %d\r\n", sz, sockCtx->fd);
-#endif
+    NET_IO_LOG("SockIORecv: received %d bytes from %d\r\n", recvd, sockCtx->fd);
 
     return recvd;
 }
@@ -305,6 +317,12 @@ int SockIOSend(WOLFSSL* ssl, char* buff, int sz, void* ctx)
     if ((sent = (int)send(sockCtx->fd, buff, sz, 0)) == -1) {
         /* error encountered. Be responsible and report it in wolfSSL terms */
 
+        /* non-blocking sockets end up here when the TCP window is full */
+        if ((errno == EWOULDBLOCK || errno == EAGAIN) &&
+                wolfSSL_get_using_nonblock(ssl)) {
+            return WOLFSSL_CBIO_ERR_WANT_WRITE;
+        }
+
         xil_printf("IO SEND ERROR: ");
         switch (errno) {
     #if EAGAIN != EWOULDBLOCK
@@ -312,7 +330,7 @@ int SockIOSend(WOLFSSL* ssl, char* buff, int sz, void* ctx)
     #endif
         case EWOULDBLOCK:
             xil_printf("would block\r\n");
-            return WOLFSSL_CBIO_ERR_WANT_READ;
+            return WOLFSSL_CBIO_ERR_WANT_WRITE;
         case ECONNRESET:
             xil_printf("connection reset\r\n");
             return WOLFSSL_CBIO_ERR_CONN_RST;
@@ -332,10 +350,8 @@ int SockIOSend(WOLFSSL* ssl, char* buff, int sz, void* ctx)
         return 0;
     }
 
-#ifdef DEBUG_WOLFTPM
     /* successful send */
-    xil_printf("SockIOSend: sent %d bytes to %d\r\n", sz, sockCtx->fd);
-#endif
+    NET_IO_LOG("SockIOSend: sent %d bytes to %d\r\n", sent, sockCtx->fd);
 
     return sent;
 }
@@ -394,6 +410,42 @@ int SocketWaitClient(SockIoCbCtx* sockIoCtx)
     return 0;
 }
 
+/* Puts a socket into non-blocking mode (used by the multi-connection server) */
+int SocketSetNonBlocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        xil_printf("ERROR: failed to set non-blocking\r\n");
+        return -1;
+    }
+    return 0;
+}
+
+/* Accepts a pending connection on a non-blocking listen socket.
+ * Returns 0 with connFd set, WOLFSSL_CBIO_ERR_WANT_READ if no connection is
+ * pending or -1 on error */
+int SocketAcceptNonBlocking(SockIoCbCtx* sockIoCtx, int* connFd)
+{
+    int connd;
+    struct sockaddr_in clientAddr;
+    socklen_t          size = sizeof(clientAddr);
+
+    connd = accept(sockIoCtx->listenFd, (struct sockaddr*)&clientAddr, &size);
+    if (connd == -1) {
+        if (errno == EWOULDBLOCK || errno == EAGAIN) {
+            return WOLFSSL_CBIO_ERR_WANT_READ;
+        }
+        xil_printf("ERROR: failed to accept the connection\r\n");
+        return -1;
+    }
+    if (SocketSetNonBlocking(connd) != 0) {
+        close(connd);
+        return -1;
+    }
+    *connFd = connd;
+    return 0;
+}
+
 int SetupSocketAndConnect(SockIoCbCtx* sockIoCtx, const char* host,
     word32 port)
 {
@@ -449,3 +501,165 @@ void CloseAndCleanupSocket(SockIoCbCtx* sockIoCtx)
         sockIoCtx->listenFd = -1;
     }
 }
+
+
+/* LWIP netconn Handling for wolf (no socket layer) */
+static int NetconnIOError(WOLFSSL* ssl, const char* op, err_t err,
+    int wouldBlock)
+{
+    /* non-blocking connections end up here on every poll, so don't log it */
+    if (err == ERR_WOULDBLOCK && wolfSSL_get_using_nonblock(ssl)) {
+        return wouldBlock;
+    }
+
+    xil_printf("IO %s ERROR: ", op);
+    switch (err) {
+    case ERR_WOULDBLOCK:
+        xil_printf("would block\r\n");
+        return wouldBlock;
+    case ERR_TIMEOUT:
+        xil_printf("timeout\r\n");
+        return WOLFSSL_CBIO_ERR_TIMEOUT;
+    case ERR_RST:
+        xil_printf("connection reset\r\n");
+        return WOLFSSL_CBIO_ERR_CONN_RST;
+    case ERR_CLSD:
+        xil_printf("connection closed\r\n");
+        return WOLFSSL_CBIO_ERR_CONN_CLOSE;
+    case ERR_ABRT:
+        xil_printf("connection aborted\r\n");
+        return WOLFSSL_CBIO_ERR_CONN_CLOSE;
+    default:
+        xil_printf("general error %d\r\n", err);
+        return WOLFSSL_CBIO_ERR_GENERAL;
+    }
+}
+
+int NetconnIORecv(WOLFSSL* ssl, char* buff, int sz, void* ctx)
+{
+    NetconnIoCbCtx* netCtx = (NetconnIoCbCtx*)ctx;
+    err_t err;
+    int recvd;
+
+    /* only wait on lwIP once the previous chain is used up */
+    if (netCtx->rx == NULL) {
+        err = netconn_recv_tcp_pbuf(netCtx->conn, &netCtx->rx);
+        if (err != ERR_OK) {
+            netCtx->rx = NULL;
+            return NetconnIOError(ssl, "RECEIVE", err,
+                WOLFSSL_CBIO_ERR_WANT_READ);
+        }
+    }
+
+    /* copy from the pbuf payloads directly into the wolfSSL input buffer and
+     * release the pbufs that are fully read */
+    recvd = (sz < netCtx->rx->tot_len) ? sz : netCtx->rx->tot_len;
+    recvd = (int)pbuf_copy_partial(netCtx->rx, buff, (u16_t)recvd, 0);
+    netCtx->rx = pbuf_free_header(netCtx->rx, (u16_t)recvd);
+
+    NET_IO_LOG("NetconnIORecv: received %d bytes\r\n", recvd);
+
+    return recvd;
+}
+
+int NetconnIOSend(WOLFSSL* ssl, char* buff, int sz, void* ctx)
+{
+    NetconnIoCbCtx* netCtx = (NetconnIoCbCtx*)ctx;
+    err_t err;
+    size_t sent = 0;
+
+    /* wolfSSL reuses its output buffer as soon as this returns, so lwIP copies
+     * the record into the TCP segments (there is no other copy) */
+    err = netconn_write_partly(netCtx->conn, buff, (size_t)sz, NETCONN_COPY,
+        &sent);
+    if (err != ERR_OK && sent == 0) {
+        return NetconnIOError(ssl, "SEND", err, WOLFSSL_CBIO_ERR_WANT_WRITE);
+    }
+
+    NET_IO_LOG("NetconnIOSend: sent %d bytes\r\n", (int)sent);
+
+    return (int)sent;
+}
+
+int NetconnListen(NetconnIoCbCtx* netIoCtx, word32 port)
+{
+    netIoCtx->listenConn = netconn_new(NETCONN_TCP);
+    if (netIoCtx->listenConn == NULL) {
+        xil_printf("ERROR: failed to create the netconn\r\n");
+        return -1;
+    }
+
+    /* allow reuse */
+    ip_set_option(netIoCtx->listenConn->pcb.tcp, SOF_REUSEADDR);
+
+    if (netconn_bind(netIoCtx->listenConn, IP_ADDR_ANY, (u16_t)port) != ERR_OK) {
+        xil_printf("ERROR: failed to bind\r\n");
+        return -1;
+    }
+
+    if (netconn_listen(netIoCtx->listenConn) != ERR_OK) {
+        xil_printf("ERROR: failed to listen\r\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+int NetconnWaitClient(NetconnIoCbCtx* netIoCtx)
+{
+    if (netconn_accept(netIoCtx->listenConn, &netIoCtx->conn) != ERR_OK) {
+        xil_printf("ERROR: failed to accept the connection\r\n");
+        netIoCtx->conn = NULL;
+        return -1;
+    }
+    netIoCtx->rx = NULL;
+    return 0;
+}
+
+int NetconnConnect(NetconnIoCbCtx* netIoCtx, const char* host, word32 port)
+{
+    ip_addr_t addr;
+    err_t err = ERR_ARG;
+
+#if defined(LWIP_DNS) && LWIP_DNS == 1
+    /* Resolve host */
+    err = netconn_gethostbyname(host, &addr);
+#endif
+    if (err != ERR_OK && !ipaddr_aton(host, &addr)) {
+        xil_printf("ERROR: failed to resolve %s\r\n", host);
+        return -1;
+    }
+
+    netIoCtx->rx = NULL;
+    netIoCtx->conn = netconn_new(NETCONN_TCP);
+    if (netIoCtx->conn == NULL) {
+        xil_printf("ERROR: failed to create the netconn\r\n");
+        return -1;
+    }
+
+    /* Connect to the server */
+    if (netconn_connect(netIoCtx->conn, &addr, (u16_t)port) != ERR_OK) {
+        xil_printf("ERROR: failed to connect\r\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+void NetconnCloseAndCleanup(NetconnIoCbCtx* netIoCtx)
+{
+    if (netIoCtx->rx != NULL) {
+        pbuf_free(netIoCtx->rx);
+        netIoCtx->rx = NULL;
+    }
+    if (netIoCtx->conn != NULL) {
+        netconn_close(netIoCtx->conn);
+        netconn_delete(netIoCtx->conn);
+        netIoCtx->conn = NULL;
+    }
+    if (netIoCtx->listenConn != NULL) {
+        netconn_close(netIoCtx->listenConn);
+        netconn_delete(netIoCtx->listenConn);
+        netIoCtx->listenConn = NULL;
+    }
+}
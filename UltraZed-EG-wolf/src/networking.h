@@ -5,6 +5,8 @@
 #include <wolfssl/wolfcrypt/settings.h>
 #include <wolfssl/ssl.h>
 
+#include "lwip/api.h"
+#include "lwip/pbuf.h"
 
 #ifdef __cplusplus
     extern "C" {
@@ -15,6 +17,14 @@ typedef struct SockIoCbCtx {
     int fd;
 } SockIoCbCtx;
 
+/* lwIP netconn I/O context. The unread part of the last received pbuf chain
+ * is kept here and wolfSSL reads its records straight from the payloads */
+typedef struct NetconnIoCbCtx {
+    struct netconn* listenConn;
+    struct netconn* conn;
+    struct pbuf*    rx;
+} NetconnIoCbCtx;
+
 
 void networking_start(void* p);
 
@@ -27,6 +37,15 @@ void CloseAndCleanupSocket(SockIoCbCtx* sockIoCtx);
 
 int SetupSocketAndListen(SockIoCbCtx* sockIoCtx, word32 port);
 int SocketWaitClient(SockIoCbCtx* sockIoCtx);
+int SocketSetNonBlocking(int fd);
+int SocketAcceptNonBlocking(SockIoCbCtx* sockIoCtx, int* connFd);
+
+int NetconnIORecv(struct WOLFSSL* ssl, char* buff, int sz, void* ctx);
+int NetconnIOSend(struct WOLFSSL* ssl, char* buff, int sz, void* ctx);
+int NetconnConnect(NetconnIoCbCtx* netIoCtx, const char* host, word32 port);
+int NetconnListen(NetconnIoCbCtx* netIoCtx, word32 port);
+int NetconnWaitClient(NetconnIoCbCtx* netIoCtx);
+void NetconnCloseAndCleanup(NetconnIoCbCtx* netIoCtx);
 
 
 
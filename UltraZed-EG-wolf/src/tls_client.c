@@ -28,6 +28,7 @@
 
 #include "tpm_io.h"
 #include "tpm_test.h"
+#include "wolf_port.h"
 #include "tls_common.h"
 #include "tls_client.h"
 
@@ -109,7 +110,7 @@ int TPM2_TLS_Client(void* userCtx)
     xil_printf("TPM2 TLS Client Example\r\n");
 
     /* Init the TPM2 device */
-    rc = wolfTPM2_Init(&dev, TPM2_IoCb, userCtx);
+    rc = wolf_tpm_init(userCtx);
     if (rc != 0) {
         wolfSSL_Cleanup();
         return rc;
@@ -471,7 +472,7 @@ exit:
     wolfTPM2_UnloadHandle(&dev, &eccKey.handle);
 #endif
 
-    wolfTPM2_Cleanup(&dev);
+    wolf_tpm_cleanup();
 
     return rc;
 }
@@ -479,3 +480,160 @@ exit:
 /******************************************************************************/
 /* --- END TPM TLS Client Example -- */
 /******************************************************************************/
+
+
+/******************************************************************************/
+/* --- BEGIN TLS Client Throughput Benchmark -- */
+/******************************************************************************/
+
+/* Bulk transfer per record size. The peer echoes the data back, for example
+ * ./examples/server/server -b -d -i -p 11111 -B 1048576 */
+#ifndef TLS_THROUGHPUT_BYTES
+    #define TLS_THROUGHPUT_BYTES (1024 * 1024)
+#endif
+#define TLS_THROUGHPUT_MAX_REC (16 * 1024)
+
+static int TLS_Throughput_Run(WOLFSSL_CTX* ctx, int useNetconn, int recSz,
+    byte* buf)
+{
+    int rc;
+    int xfer, len, rx;
+    SockIoCbCtx sockIoCtx;
+    NetconnIoCbCtx netIoCtx;
+    WOLFSSL* ssl;
+    double start, txSecs = 0, rxSecs = 0;
+
+    XMEMSET(&sockIoCtx, 0, sizeof(sockIoCtx));
+    sockIoCtx.fd = -1;
+    sockIoCtx.listenFd = -1;
+    XMEMSET(&netIoCtx, 0, sizeof(netIoCtx));
+
+    if ((ssl = wolfSSL_new(ctx)) == NULL) {
+        return MEMORY_E;
+    }
+
+    if (useNetconn) {
+        wolfSSL_SSLSetIORecv(ssl, NetconnIORecv);
+        wolfSSL_SSLSetIOSend(ssl, NetconnIOSend);
+        wolfSSL_SetIOReadCtx(ssl, &netIoCtx);
+        wolfSSL_SetIOWriteCtx(ssl, &netIoCtx);
+        rc = NetconnConnect(&netIoCtx, TLS_HOST, TLS_PORT);
+    }
+    else {
+        wolfSSL_SSLSetIORecv(ssl, SockIORecv);
+        wolfSSL_SSLSetIOSend(ssl, SockIOSend);
+        wolfSSL_SetIOReadCtx(ssl, &sockIoCtx);
+        wolfSSL_SetIOWriteCtx(ssl, &sockIoCtx);
+        rc = SetupSocketAndConnect(&sockIoCtx, TLS_HOST, TLS_PORT);
+    }
+    if (rc == 0 && wolfSSL_connect(ssl) != WOLFSSL_SUCCESS) {
+        rc = wolfSSL_get_error(ssl, 0);
+    }
+
+    for (xfer = 0; rc == 0 && xfer < TLS_THROUGHPUT_BYTES; xfer += len) {
+        len = TLS_THROUGHPUT_BYTES - xfer;
+        if (len > recSz)
+            len = recSz;
+
+        start = gettime_secs(1);
+        if (wolfSSL_write(ssl, buf, len) != len) {
+            rc = wolfSSL_get_error(ssl, 0);
+            break;
+        }
+        txSecs += gettime_secs(0) - start;
+
+        start = gettime_secs(1);
+        for (rx = 0; rx < len; rx += rc) {
+            rc = wolfSSL_read(ssl, buf + rx, len - rx);
+            if (rc <= 0) {
+                rc = wolfSSL_get_error(ssl, 0);
+                break;
+            }
+        }
+        rxSecs += gettime_secs(0) - start;
+        if (rx == len)
+            rc = 0;
+    }
+
+    if (rc == 0) {
+        xil_printf("%-7s %5d byte records: TX %9.3f Mbit/s, RX %9.3f Mbit/s\r\n",
+            useNetconn ? "netconn" : "socket", recSz,
+            (double)TLS_THROUGHPUT_BYTES * 8 / txSecs / 1000000,
+            (double)TLS_THROUGHPUT_BYTES * 8 / rxSecs / 1000000);
+    }
+    else {
+        xil_printf("Throughput %s %d failed %d: %s\r\n",
+            useNetconn ? "netconn" : "socket", recSz, rc,
+            wolfSSL_ERR_reason_error_string(rc));
+    }
+
+    wolfSSL_shutdown(ssl);
+    wolfSSL_free(ssl);
+    if (useNetconn)
+        NetconnCloseAndCleanup(&netIoCtx);
+    else
+        CloseAndCleanupSocket(&sockIoCtx);
+
+    return rc;
+}
+
+/* Measures bulk TLS transfer (Mbit/s) with 1KB and 16KB records using the
+ * BSD socket and the lwIP netconn I/O callbacks. Uses software keys, since
+ * only the record layer and network path are being measured */
+int TLS_Client_Throughput(void)
+{
+    int rc = 0;
+    int i, useNetconn;
+    WOLFSSL_CTX* ctx;
+    byte* buf;
+    static const int recSizes[] = { 1024, TLS_THROUGHPUT_MAX_REC };
+
+    xil_printf("TLS Client Throughput to %s:%d (%d bytes)\r\n",
+        TLS_HOST, TLS_PORT, TLS_THROUGHPUT_BYTES);
+
+    if ((ctx = wolfSSL_CTX_new(wolfTLSv1_2_client_method())) == NULL) {
+        return MEMORY_E;
+    }
+    wolfSSL_CTX_set_verify(ctx, WOLFSSL_VERIFY_PEER, myVerify);
+#if !defined(NO_RSA) && !defined(TLS_USE_ECC)
+    if (wolfSSL_CTX_load_verify_buffer(ctx,
+            ca_cert_der_2048, sizeof_ca_cert_der_2048,
+            WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS) {
+        xil_printf("Error loading ca_cert_der_2048 DER cert\r\n");
+    }
+#elif defined(HAVE_ECC)
+    if (wolfSSL_CTX_load_verify_buffer(ctx,
+            ca_ecc_cert_der_256, sizeof_ca_ecc_cert_der_256,
+            WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS) {
+        xil_printf("Error loading ca_ecc_cert_der_256 DER cert\r\n");
+    }
+#endif
+#ifdef TLS_CIPHER_SUITE
+    wolfSSL_CTX_set_cipher_list(ctx, TLS_CIPHER_SUITE);
+#endif
+
+    buf = (byte*)XMALLOC(TLS_THROUGHPUT_MAX_REC, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+    if (buf == NULL) {
+        wolfSSL_CTX_free(ctx);
+        return MEMORY_E;
+    }
+    for (i = 0; i < TLS_THROUGHPUT_MAX_REC; i++) {
+        buf[i] = (byte)i;
+    }
+
+    for (i = 0; i < (int)(sizeof(recSizes)/sizeof(recSizes[0])); i++) {
+        for (useNetconn = 0; useNetconn <= 1; useNetconn++) {
+            if (TLS_Throughput_Run(ctx, useNetconn, recSizes[i], buf) != 0)
+                rc = -1;
+        }
+    }
+
+    XFREE(buf, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+    wolfSSL_CTX_free(ctx);
+
+    return rc;
+}
+
+/******************************************************************************/
+/* --- END TLS Client Throughput Benchmark -- */
+/******************************************************************************/
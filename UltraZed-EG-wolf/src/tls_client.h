@@ -28,6 +28,7 @@
 
 int TPM2_TLS_Client(void* userCtx);
 int TLS_Client(void);
+int TLS_Client_Throughput(void);
 
 #ifdef __cplusplus
     }  /* extern "C" */
@@ -22,6 +22,9 @@
 
 #include <wolfssl/wolfcrypt/settings.h>
 #include <wolfssl/ssl.h>
+#include <wolfssl/wolfcrypt/hmac.h>
+#include <wolfssl/wolfcrypt/random.h>
+#include <wolfssl/wolfcrypt/chacha20_poly1305.h>
 
 #include <wolftpm/tpm2.h>
 #include <wolftpm/tpm2_wrap.h>
@@ -30,6 +33,16 @@
 #include "tpm_test.h"
 #include "tls_common.h"
 #include "tls_client.h"
+#include "tls_server.h"
+#include "wolf_port.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "lwip/sockets.h"
+#include "lwip/sys.h"
+#include "xparameters.h"
+#include "xuartps_hw.h"
 
 #include <stdio.h>
 
@@ -65,12 +78,55 @@
 
 extern WOLFTPM2_DEV dev;
 
-/******************************************************************************/
-/* --- BEGIN TLS SERVER Example -- */
-/******************************************************************************/
-int TPM2_TLS_Server(void* userCtx)
-{
-    int rc;
+/*
+ * Session Resumption
+ *
+ * Returning clients resume using the wolfSSL session cache (session ID) or a
+ * session ticket (TLS v1.2 RFC 5077 / TLS v1.3 PSK), which skips the TPM
+ * signature. Ticket keys are derived using HKDF from a TPM generated master
+ * secret and a TPM random key name. The key is rotated every
+ * TLS_TICKET_KEY_LIFETIME seconds and tickets using the previous key are still
+ * accepted (and re-issued with the current key).
+ */
+#ifndef TLS_SESSION_TIMEOUT
+    #define TLS_SESSION_TIMEOUT      3600 /* seconds */
+#endif
+#ifndef TLS_TICKET_KEY_LIFETIME
+    #define TLS_TICKET_KEY_LIFETIME  3600 /* seconds */
+#endif
+
+#ifdef HAVE_SESSION_TICKET
+typedef struct TlsTicketKey {
+    byte   name[WOLFSSL_TICKET_NAME_SZ];
+    byte   key[CHACHA20_POLY1305_AEAD_KEYSIZE];
+    double created;
+} TlsTicketKey;
+#endif
+
+typedef struct TlsResumeStats {
+    word32 full;          /* full handshakes (cache miss) */
+    word32 resumed;       /* resumed handshakes (cache hit) */
+    word32 ticketsIssued;
+    word32 ticketHits;
+    word32 ticketRejects; /* unknown / expired key or failed decrypt */
+    double fullSec;       /* total handshake time */
+    double resumedSec;
+} TlsResumeStats;
+
+typedef struct TlsResume {
+    wolfSSL_Mutex  lock;
+    int            lockInit;
+#ifdef HAVE_SESSION_TICKET
+    byte           master[WC_SHA256_DIGEST_SIZE];
+    TlsTicketKey   keys[2]; /* current and previous */
+    int            keyCount;
+#endif
+    TlsResumeStats stats;
+} TlsResume;
+
+/* TPM backed keys used by the TLS server. These are loaded once and shared
+ * by every WOLFSSL session created from the same WOLFSSL_CTX */
+typedef struct TlsServerKeys {
     WOLFTPM2_KEY storageKey;
 #ifndef NO_RSA
     WOLFTPM2_KEY rsaKey;
@@ -83,66 +139,45 @@ int TPM2_TLS_Server(void* userCtx)
     WOLFTPM2_KEY ecdhKey;
     #endif
 #endif
-    TPMT_PUBLIC publicTemplate;
     TpmCryptoDevCtx tpmCtx;
-    SockIoCbCtx sockIoCtx;
     int tpmDevId;
-    WOLFSSL_CTX* ctx = NULL;
-    WOLFSSL* ssl = NULL;
-#ifndef TLS_BENCH_MODE
-    const char webServerMsg[] =
-        "HTTP/1.1 200 OK\r\n"
-        "Content-Type: text/html\r\n"
-        "Connection: close\r\n"
-        "\r\n"
-        "<html>\r\n"
-        "<head>\r\n"
-        "<title>Welcome to wolfSSL!</title>\r\n"
-        "</head>\r\n"
-        "<body>\r\n"
-        "<p>wolfSSL has successfully performed handshake!</p>\r\n"
-        "</body>\r\n"
-        "</html>\r\n";
-#endif
-    char msg[MAX_MSG_SZ];
-    int msgSz = 0;
-#ifdef TLS_BENCH_MODE
-    int total_size;
-#endif
+    TlsResume resume;
+} TlsServerKeys;
 
-    /* initialize variables */
-    XMEMSET(&sockIoCtx, 0, sizeof(sockIoCtx));
-    sockIoCtx.fd = -1;
+/******************************************************************************/
+/* --- BEGIN TLS SERVER Setup -- */
+/******************************************************************************/
+static int TLS_Server_LoadKeys(TlsServerKeys* keys, void* userCtx)
+{
+    int rc;
+    TPMT_PUBLIC publicTemplate;
 
-    xil_printf("TPM2 TLS Server Example\r\n");
+    XMEMSET(keys, 0, sizeof(*keys));
 
     /* Init the TPM2 device */
-    rc = wolfTPM2_Init(&dev, TPM2_IoCb, userCtx);
+    rc = wolf_tpm_init(userCtx);
     if (rc != 0) {
-        wolfSSL_Cleanup();
         return rc;
     }
 
     /* Setup the wolf crypto device callback */
-    XMEMSET(&tpmCtx, 0, sizeof(tpmCtx));
 #ifndef NO_RSA
-    XMEMSET(&wolfRsaKey, 0, sizeof(wolfRsaKey));
-    tpmCtx.rsaKey = &rsaKey;
+    keys->tpmCtx.rsaKey = &keys->rsaKey;
 #endif
 #ifdef HAVE_ECC
-    XMEMSET(&wolfEccKey, 0, sizeof(wolfEccKey));
-    tpmCtx.eccKey = &eccKey;
+    keys->tpmCtx.eccKey = &keys->eccKey;
 #endif
-    tpmCtx.checkKeyCb = myTpmCheckKey; /* detects if using "dummy" key */
-    tpmCtx.storageKey = &storageKey;
+    keys->tpmCtx.checkKeyCb = myTpmCheckKey; /* detects if using "dummy" key */
+    keys->tpmCtx.storageKey = &keys->storageKey;
 #ifdef WOLFTPM_USE_SYMMETRIC
-    tpmCtx.useSymmetricOnTPM = 1;
+    keys->tpmCtx.useSymmetricOnTPM = 1;
 #endif
-    rc = wolfTPM2_SetCryptoDevCb(&dev, wolfTPM2_CryptoDevCb, &tpmCtx, &tpmDevId);
-    if (rc != 0) goto exit;
+    rc = wolfTPM2_SetCryptoDevCb(&dev, wolfTPM2_CryptoDevCb, &keys->tpmCtx,
+        &keys->tpmDevId);
+    if (rc != 0) return rc;
 
     /* See if primary storage key already exists */
-    rc = wolfTPM2_ReadPublicKey(&dev, &storageKey,
+    rc = wolfTPM2_ReadPublicKey(&dev, &keys->storageKey,
         TPM2_DEMO_STORAGE_KEY_HANDLE);
     if (rc != 0) {
         /* Create primary storage key */
@@ -150,105 +185,316 @@ int TPM2_TLS_Server(void* userCtx)
             TPMA_OBJECT_fixedTPM | TPMA_OBJECT_fixedParent |
             TPMA_OBJECT_sensitiveDataOrigin | TPMA_OBJECT_userWithAuth |
             TPMA_OBJECT_restricted | TPMA_OBJECT_decrypt | TPMA_OBJECT_noDA);
-        if (rc != 0) goto exit;
-        rc = wolfTPM2_CreatePrimaryKey(&dev, &storageKey, TPM_RH_OWNER,
+        if (rc != 0) return rc;
+        rc = wolfTPM2_CreatePrimaryKey(&dev, &keys->storageKey, TPM_RH_OWNER,
             &publicTemplate, (byte*)gStorageKeyAuth, sizeof(gStorageKeyAuth)-1);
-        if (rc != 0) goto exit;
+        if (rc != 0) return rc;
 
         /* Move this key into persistent storage */
-        rc = wolfTPM2_NVStoreKey(&dev, TPM_RH_OWNER, &storageKey,
+        rc = wolfTPM2_NVStoreKey(&dev, TPM_RH_OWNER, &keys->storageKey,
             TPM2_DEMO_STORAGE_KEY_HANDLE);
-        if (rc != 0) goto exit;
+        if (rc != 0) return rc;
     }
     else {
         /* specify auth password for storage key */
-        storageKey.handle.auth.size = sizeof(gStorageKeyAuth)-1;
-        XMEMCPY(storageKey.handle.auth.buffer, gStorageKeyAuth,
-            storageKey.handle.auth.size);
+        keys->storageKey.handle.auth.size = sizeof(gStorageKeyAuth)-1;
+        XMEMCPY(keys->storageKey.handle.auth.buffer, gStorageKeyAuth,
+            keys->storageKey.handle.auth.size);
     }
 
 #ifndef NO_RSA
     /* Create/Load RSA key for TLS authentication */
-    rc = wolfTPM2_ReadPublicKey(&dev, &rsaKey, TPM2_DEMO_RSA_KEY_HANDLE);
+    rc = wolfTPM2_ReadPublicKey(&dev, &keys->rsaKey, TPM2_DEMO_RSA_KEY_HANDLE);
     if (rc != 0) {
         rc = wolfTPM2_GetKeyTemplate_RSA(&publicTemplate,
             TPMA_OBJECT_sensitiveDataOrigin | TPMA_OBJECT_userWithAuth |
             TPMA_OBJECT_decrypt | TPMA_OBJECT_sign | TPMA_OBJECT_noDA);
-        if (rc != 0) goto exit;
-        rc = wolfTPM2_CreateAndLoadKey(&dev, &rsaKey, &storageKey.handle,
-            &publicTemplate, (byte*)gKeyAuth, sizeof(gKeyAuth)-1);
-        if (rc != 0) goto exit;
+        if (rc != 0) return rc;
+        rc = wolfTPM2_CreateAndLoadKey(&dev, &keys->rsaKey,
+            &keys->storageKey.handle, &publicTemplate,
+            (byte*)gKeyAuth, sizeof(gKeyAuth)-1);
+        if (rc != 0) return rc;
 
         /* Move this key into persistent storage */
-        rc = wolfTPM2_NVStoreKey(&dev, TPM_RH_OWNER, &rsaKey,
+        rc = wolfTPM2_NVStoreKey(&dev, TPM_RH_OWNER, &keys->rsaKey,
             TPM2_DEMO_RSA_KEY_HANDLE);
-        if (rc != 0) goto exit;
+        if (rc != 0) return rc;
     }
     else {
         /* specify auth password for rsa key */
-        rsaKey.handle.auth.size = sizeof(gKeyAuth)-1;
-        XMEMCPY(rsaKey.handle.auth.buffer, gKeyAuth, rsaKey.handle.auth.size);
+        keys->rsaKey.handle.auth.size = sizeof(gKeyAuth)-1;
+        XMEMCPY(keys->rsaKey.handle.auth.buffer, gKeyAuth,
+            keys->rsaKey.handle.auth.size);
     }
 
     /* setup wolf RSA key with TPM deviceID, so crypto callbacks are used */
-    rc = wc_InitRsaKey_ex(&wolfRsaKey, NULL, tpmDevId);
-    if (rc != 0) goto exit;
+    rc = wc_InitRsaKey_ex(&keys->wolfRsaKey, NULL, keys->tpmDevId);
+    if (rc != 0) return rc;
     /* load public portion of key into wolf RSA Key */
-    rc = wolfTPM2_RsaKey_TpmToWolf(&dev, &rsaKey, &wolfRsaKey);
-    if (rc != 0) goto exit;
+    rc = wolfTPM2_RsaKey_TpmToWolf(&dev, &keys->rsaKey, &keys->wolfRsaKey);
+    if (rc != 0) return rc;
 #endif /* !NO_RSA */
 
 #ifdef HAVE_ECC
     /* Create/Load ECC key for TLS authentication */
-    rc = wolfTPM2_ReadPublicKey(&dev, &eccKey, TPM2_DEMO_ECC_KEY_HANDLE);
+    rc = wolfTPM2_ReadPublicKey(&dev, &keys->eccKey, TPM2_DEMO_ECC_KEY_HANDLE);
     if (rc != 0) {
         rc = wolfTPM2_GetKeyTemplate_ECC(&publicTemplate,
             TPMA_OBJECT_sensitiveDataOrigin | TPMA_OBJECT_userWithAuth |
             TPMA_OBJECT_sign | TPMA_OBJECT_noDA,
             TPM_ECC_NIST_P256, TPM_ALG_ECDSA);
-        if (rc != 0) goto exit;
-        rc = wolfTPM2_CreateAndLoadKey(&dev, &eccKey, &storageKey.handle,
-            &publicTemplate, (byte*)gKeyAuth, sizeof(gKeyAuth)-1);
-        if (rc != 0) goto exit;
+        if (rc != 0) return rc;
+        rc = wolfTPM2_CreateAndLoadKey(&dev, &keys->eccKey,
+            &keys->storageKey.handle, &publicTemplate,
+            (byte*)gKeyAuth, sizeof(gKeyAuth)-1);
+        if (rc != 0) return rc;
 
         /* Move this key into persistent storage */
-        rc = wolfTPM2_NVStoreKey(&dev, TPM_RH_OWNER, &eccKey,
+        rc = wolfTPM2_NVStoreKey(&dev, TPM_RH_OWNER, &keys->eccKey,
             TPM2_DEMO_ECC_KEY_HANDLE);
-        if (rc != 0) goto exit;
+        if (rc != 0) return rc;
     }
     else {
         /* specify auth password for ECC key */
-        eccKey.handle.auth.size = sizeof(gKeyAuth)-1;
-        XMEMCPY(eccKey.handle.auth.buffer, gKeyAuth, eccKey.handle.auth.size);
+        keys->eccKey.handle.auth.size = sizeof(gKeyAuth)-1;
+        XMEMCPY(keys->eccKey.handle.auth.buffer, gKeyAuth,
+            keys->eccKey.handle.auth.size);
     }
 
     /* setup wolf ECC key with TPM deviceID, so crypto callbacks are used */
-    rc = wc_ecc_init_ex(&wolfEccKey, NULL, tpmDevId);
-    if (rc != 0) goto exit;
+    rc = wc_ecc_init_ex(&keys->wolfEccKey, NULL, keys->tpmDevId);
+    if (rc != 0) return rc;
     /* load public portion of key into wolf ECC Key */
-    rc = wolfTPM2_EccKey_TpmToWolf(&dev, &eccKey, &wolfEccKey);
-    if (rc != 0) goto exit;
+    rc = wolfTPM2_EccKey_TpmToWolf(&dev, &keys->eccKey, &keys->wolfEccKey);
+    if (rc != 0) return rc;
 
     #ifndef WOLFTPM2_USE_SW_ECDHE
     /* Ephemeral Key */
-    XMEMSET(&ecdhKey, 0, sizeof(ecdhKey));
-    tpmCtx.ecdhKey = &ecdhKey;
+    keys->tpmCtx.ecdhKey = &keys->ecdhKey;
     #endif
 #endif /* HAVE_ECC */
 
+    return rc;
+}
 
-    /* Setup the WOLFSSL context (factory) */
-    if ((ctx = wolfSSL_CTX_new(wolfTLSv1_2_server_method())) == NULL) {
-        rc = MEMORY_E; goto exit;
+/******************************************************************************/
+/* --- BEGIN TLS SERVER Session Resumption -- */
+/******************************************************************************/
+#ifdef HAVE_SESSION_TICKET
+/* must be called with resume lock held */
+static int TLS_Resume_NewTicketKey(TlsResume* resume)
+{
+    int rc;
+    TlsTicketKey key;
+    static const char info[] = "wolfTPM TLS ticket key";
+
+    rc = wolfTPM2_GetRandom(&dev, key.name, sizeof(key.name));
+    if (rc == 0) {
+        rc = wc_HKDF(WC_SHA256, resume->master, sizeof(resume->master),
+            key.name, sizeof(key.name), (const byte*)info, sizeof(info)-1,
+            key.key, sizeof(key.key));
     }
+    if (rc == 0) {
+        key.created = gettime_secs(0);
+        resume->keys[1] = resume->keys[0];
+        resume->keys[0] = key;
+        if (resume->keyCount < 2)
+            resume->keyCount++;
+    }
+    XMEMSET(&key, 0, sizeof(key));
+    return rc;
+}
 
-    /* Setup DevID */
-    wolfSSL_CTX_SetDevId(ctx, tpmDevId);
+static int TLS_Resume_TicketEncCb(WOLFSSL* ssl,
+    byte key_name[WOLFSSL_TICKET_NAME_SZ], byte iv[WOLFSSL_TICKET_IV_SZ],
+    byte mac[WOLFSSL_TICKET_MAC_SZ], int enc, byte* ticket, int inLen,
+    int* outLen, void* userCtx)
+{
+    int rc, i, ret = WOLFSSL_TICKET_RET_OK;
+    TlsResume* resume = (TlsResume*)userCtx;
+    byte key[CHACHA20_POLY1305_AEAD_KEYSIZE];
+    byte aad[WOLFSSL_TICKET_NAME_SZ + WOLFSSL_TICKET_IV_SZ + 2];
+    double now = gettime_secs(0);
 
-    /* Setup IO Callbacks */
-    wolfSSL_CTX_SetIORecv(ctx, SockIORecv);
-    wolfSSL_CTX_SetIOSend(ctx, SockIOSend);
+    (void)ssl;
+
+    if (enc) {
+        /* IV from this task's DRBG, outside the resume lock */
+        WC_RNG* rng = wolf_rng_task();
+        if (rng == NULL ||
+                wc_RNG_GenerateBlock(rng, iv, WOLFSSL_TICKET_IV_SZ) != 0) {
+            return WOLFSSL_TICKET_RET_FATAL;
+        }
+    }
+
+    if (wc_LockMutex(&resume->lock) != 0)
+        return WOLFSSL_TICKET_RET_FATAL;
+
+    if (enc) {
+        rc = 0;
+        if (resume->keyCount == 0 ||
+                now - resume->keys[0].created >= TLS_TICKET_KEY_LIFETIME) {
+            rc = TLS_Resume_NewTicketKey(resume);
+        }
+        if (rc != 0) {
+            wc_UnLockMutex(&resume->lock);
+            return WOLFSSL_TICKET_RET_FATAL;
+        }
+        XMEMCPY(key_name, resume->keys[0].name, WOLFSSL_TICKET_NAME_SZ);
+        XMEMCPY(key, resume->keys[0].key, sizeof(key));
+        resume->stats.ticketsIssued++;
+    }
+    else {
+        /* previous key remains valid for one more lifetime */
+        for (i = 0; i < resume->keyCount; i++) {
+            if (XMEMCMP(key_name, resume->keys[i].name,
+                    WOLFSSL_TICKET_NAME_SZ) == 0 &&
+                now - resume->keys[i].created < (i+1) * TLS_TICKET_KEY_LIFETIME)
+                break;
+        }
+        if (i == resume->keyCount) {
+            resume->stats.ticketRejects++;
+            wc_UnLockMutex(&resume->lock);
+            return WOLFSSL_TICKET_RET_REJECT;
+        }
+        XMEMCPY(key, resume->keys[i].key, sizeof(key));
+        if (i > 0)
+            ret = WOLFSSL_TICKET_RET_CREATE; /* re-issue with current key */
+    }
+    wc_UnLockMutex(&resume->lock);
 
+    /* authenticate key name, IV and ticket length */
+    XMEMCPY(aad, key_name, WOLFSSL_TICKET_NAME_SZ);
+    XMEMCPY(aad + WOLFSSL_TICKET_NAME_SZ, iv, WOLFSSL_TICKET_IV_SZ);
+    aad[sizeof(aad)-2] = (byte)(inLen >> 8);
+    aad[sizeof(aad)-1] = (byte)inLen;
+
+    if (enc) {
+        XMEMSET(mac, 0, WOLFSSL_TICKET_MAC_SZ);
+        rc = wc_ChaCha20Poly1305_Encrypt(key, iv, aad, sizeof(aad),
+            ticket, inLen, ticket, mac);
+    }
+    else {
+        rc = wc_ChaCha20Poly1305_Decrypt(key, iv, aad, sizeof(aad),
+            ticket, inLen, mac, ticket);
+    }
+    XMEMSET(key, 0, sizeof(key));
+    if (rc != 0) {
+        if (!enc && wc_LockMutex(&resume->lock) == 0) {
+            resume->stats.ticketRejects++;
+            wc_UnLockMutex(&resume->lock);
+        }
+        return enc ? WOLFSSL_TICKET_RET_FATAL : WOLFSSL_TICKET_RET_REJECT;
+    }
+    if (!enc && wc_LockMutex(&resume->lock) == 0) {
+        resume->stats.ticketHits++;
+        wc_UnLockMutex(&resume->lock);
+    }
+    *outLen = inLen;
+
+    return ret;
+}
+#endif /* HAVE_SESSION_TICKET */
+
+static int TLS_Resume_Init(TlsResume* resume, WOLFSSL_CTX* ctx)
+{
+    int rc;
+
+    XMEMSET(resume, 0, sizeof(*resume));
+    rc = wc_InitMutex(&resume->lock);
+    if (rc != 0)
+        return rc;
+    resume->lockInit = 1;
+
+    /* bounded session ID cache (see SESSION_CACHE sizes in ssl.c) */
+    wolfSSL_CTX_set_timeout(ctx, TLS_SESSION_TIMEOUT);
+
+#ifdef HAVE_SESSION_TICKET
+    /* ticket key master secret from the TPM */
+    rc = wolfTPM2_GetRandom(&dev, resume->master, sizeof(resume->master));
+    if (rc != 0)
+        return rc;
+
+    wolfSSL_CTX_set_TicketEncCb(ctx, TLS_Resume_TicketEncCb);
+    wolfSSL_CTX_set_TicketEncCtx(ctx, resume);
+    wolfSSL_CTX_set_TicketHint(ctx, TLS_TICKET_KEY_LIFETIME);
+#endif
+
+    return 0;
+}
+
+static void TLS_Resume_Free(TlsResume* resume)
+{
+#ifdef HAVE_SESSION_TICKET
+    XMEMSET(resume->master, 0, sizeof(resume->master));
+    XMEMSET(resume->keys, 0, sizeof(resume->keys));
+#endif
+    if (resume->lockInit)
+        wc_FreeMutex(&resume->lock);
+    resume->lockInit = 0;
+}
+
+/* Counts a completed handshake as a cache hit (resumed) or miss (full) */
+static void TLS_Resume_Record(TlsResume* resume, WOLFSSL* ssl, double sec)
+{
+    if (wc_LockMutex(&resume->lock) != 0)
+        return;
+    if (wolfSSL_session_reused(ssl)) {
+        resume->stats.resumed++;
+        resume->stats.resumedSec += sec;
+    }
+    else {
+        resume->stats.full++;
+        resume->stats.fullSec += sec;
+    }
+    wc_UnLockMutex(&resume->lock);
+}
+
+static void TLS_Resume_Report(TlsResume* resume)
+{
+    TlsResumeStats stats;
+
+    if (wc_LockMutex(&resume->lock) != 0)
+        return;
+    stats = resume->stats;
+    wc_UnLockMutex(&resume->lock);
+
+    xil_printf("Session cache: %u hits (resumed), %u misses (full)\r\n",
+        stats.resumed, stats.full);
+#ifdef HAVE_SESSION_TICKET
+    xil_printf("Tickets: %u issued, %u accepted, %u rejected\r\n",
+        stats.ticketsIssued, stats.ticketHits, stats.ticketRejects);
+#endif
+#ifdef TLS_BENCH_MODE
+    xil_printf("Handshake: full %9.3f ms avg, resumed %9.3f ms avg\r\n",
+        stats.full ? stats.fullSec * 1000 / stats.full : 0.0,
+        stats.resumed ? stats.resumedSec * 1000 / stats.resumed : 0.0);
+#endif
+}
+
+/******************************************************************************/
+/* --- END TLS SERVER Session Resumption -- */
+/******************************************************************************/
+
+static void TLS_Server_FreeKeys(TlsServerKeys* keys)
+{
+#ifndef NO_RSA
+    wc_FreeRsaKey(&keys->wolfRsaKey);
+    wolfTPM2_UnloadHandle(&dev, &keys->rsaKey.handle);
+#endif
+#ifdef HAVE_ECC
+    wc_ecc_free(&keys->wolfEccKey);
+    wolfTPM2_UnloadHandle(&dev, &keys->eccKey.handle);
+#endif
+    TLS_Resume_Free(&keys->resume);
+
+    wolf_tpm_cleanup();
+}
+
+/* Loads the CA and server certificates and the "dummy" private key, so the
+ * crypto callbacks use the TPM key handles */
+static int TLS_Server_LoadCerts(WOLFSSL_CTX* ctx)
+{
     /* Server certificate validation */
 #if 0
     /* skip server cert validation for this test */
@@ -260,7 +506,7 @@ int TPM2_TLS_Server(void* userCtx)
     #if 0
         if (wolfSSL_CTX_load_verify(ctx, ca.buffer, (long)ca.size,
             WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS) }
-            goto exit;
+            return WOLFSSL_FATAL_ERROR;
         }
     #endif
 #else
@@ -269,23 +515,23 @@ int TPM2_TLS_Server(void* userCtx)
     if (wolfSSL_CTX_load_verify_locations(ctx, "./certs/ca-rsa-cert.pem",
         0) != WOLFSSL_SUCCESS) {
         xil_printf("Error loading ca-rsa-cert.pem cert\r\n");
-        goto exit;
+        return WOLFSSL_FATAL_ERROR;
     }
     if (wolfSSL_CTX_load_verify_locations(ctx, "./certs/wolf-ca-rsa-cert.pem",
         0) != WOLFSSL_SUCCESS) {
         xil_printf("Error loading wolf-ca-rsa-cert.pem cert\r\n");
-        goto exit;
+        return WOLFSSL_FATAL_ERROR;
     }
     #elif defined(HAVE_ECC)
     if (wolfSSL_CTX_load_verify_locations(ctx, "./certs/ca-ecc-cert.pem",
         0) != WOLFSSL_SUCCESS) {
         xil_printf("Error loading ca-ecc-cert.pem cert\r\n");
-        goto exit;
+        return WOLFSSL_FATAL_ERROR;
     }
     if (wolfSSL_CTX_load_verify_locations(ctx, "./certs/wolf-ca-ecc-cert.pem",
         0) != WOLFSSL_SUCCESS) {
         xil_printf("Error loading wolf-ca-ecc-cert.pem cert\r\n");
-        goto exit;
+        return WOLFSSL_FATAL_ERROR;
     }
     #endif
 #endif /* !NO_FILESYSTEM */
@@ -296,7 +542,7 @@ int TPM2_TLS_Server(void* userCtx)
     #if 0
         if (wolfSSL_CTX_use_certificate_buffer(ctx, cert.buffer, (long)cert.size,
                                         WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS) {
-            goto exit;
+            return WOLFSSL_FATAL_ERROR;
         }
     #endif
 #else
@@ -304,10 +550,10 @@ int TPM2_TLS_Server(void* userCtx)
 #if !defined(NO_RSA) && !defined(TLS_USE_ECC)
     xil_printf("Loading RSA certificate and dummy key\r\n");
 
-    if ((rc = wolfSSL_CTX_use_certificate_file(ctx, "./certs/server-rsa-cert.pem",
-        WOLFSSL_FILETYPE_PEM)) != WOLFSSL_SUCCESS) {
+    if (wolfSSL_CTX_use_certificate_file(ctx, "./certs/server-rsa-cert.pem",
+        WOLFSSL_FILETYPE_PEM) != WOLFSSL_SUCCESS) {
         xil_printf("Error loading RSA client cert\r\n");
-        goto exit;
+        return WOLFSSL_FATAL_ERROR;
     }
 
     /* Private key is on TPM and crypto dev callbacks are used */
@@ -315,15 +561,15 @@ int TPM2_TLS_Server(void* userCtx)
     if (wolfSSL_CTX_use_PrivateKey_buffer(ctx, DUMMY_RSA_KEY,
             sizeof(DUMMY_RSA_KEY), WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS) {
         xil_printf("Failed to set key!\r\n");
-        goto exit;
+        return WOLFSSL_FATAL_ERROR;
     }
 #elif defined(HAVE_ECC)
     xil_printf("Loading ECC certificate and dummy key\r\n");
 
-    if ((rc = wolfSSL_CTX_use_certificate_file(ctx, "./certs/server-ecc-cert.pem",
-        WOLFSSL_FILETYPE_PEM)) != WOLFSSL_SUCCESS) {
+    if (wolfSSL_CTX_use_certificate_file(ctx, "./certs/server-ecc-cert.pem",
+        WOLFSSL_FILETYPE_PEM) != WOLFSSL_SUCCESS) {
         xil_printf("Error loading ECC client cert\r\n");
-        goto exit;
+        return WOLFSSL_FATAL_ERROR;
     }
 
     /* Private key is on TPM and crypto dev callbacks are used */
@@ -331,19 +577,107 @@ int TPM2_TLS_Server(void* userCtx)
     if (wolfSSL_CTX_use_PrivateKey_buffer(ctx, DUMMY_ECC_KEY,
             sizeof(DUMMY_ECC_KEY), WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS) {
         xil_printf("Failed to set key!\r\n");
-        goto exit;
+        return WOLFSSL_FATAL_ERROR;
     }
 #endif
 #endif /* !NO_FILESYSTEM */
 
 #if 0
     /* Optionally choose the cipher suite */
-    rc = wolfSSL_CTX_set_cipher_list(ctx, "ECDHE-RSA-AES128-GCM-SHA256");
-    if (rc != WOLFSSL_SUCCESS) {
-        goto exit;
+    if (wolfSSL_CTX_set_cipher_list(ctx, "ECDHE-RSA-AES128-GCM-SHA256")
+            != WOLFSSL_SUCCESS) {
+        return WOLFSSL_FATAL_ERROR;
     }
 #endif
 
+    return 0;
+}
+
+/* Creates the WOLFSSL_CTX (factory) bound to the TPM crypto callbacks */
+static int TLS_Server_NewCtx(TlsServerKeys* keys, WOLFSSL_CTX** pCtx)
+{
+    int rc;
+    WOLFSSL_CTX* ctx;
+
+    /* Setup the WOLFSSL context (factory) */
+#ifdef WOLFSSL_TLS13
+    /* TLS v1.2 or v1.3 */
+    ctx = wolfSSL_CTX_new(wolfSSLv23_server_method());
+#else
+    ctx = wolfSSL_CTX_new(wolfTLSv1_2_server_method());
+#endif
+    if (ctx == NULL) {
+        return MEMORY_E;
+    }
+
+    /* Setup DevID */
+    wolfSSL_CTX_SetDevId(ctx, keys->tpmDevId);
+
+    /* Setup IO Callbacks */
+    wolfSSL_CTX_SetIORecv(ctx, SockIORecv);
+    wolfSSL_CTX_SetIOSend(ctx, SockIOSend);
+
+    rc = TLS_Server_LoadCerts(ctx);
+    if (rc == 0)
+        rc = TLS_Resume_Init(&keys->resume, ctx);
+    if (rc != 0) {
+        wolfSSL_CTX_free(ctx);
+        ctx = NULL;
+    }
+    *pCtx = ctx;
+    return rc;
+}
+
+/******************************************************************************/
+/* --- END TLS SERVER Setup -- */
+/******************************************************************************/
+
+
+/******************************************************************************/
+/* --- BEGIN TLS SERVER Example -- */
+/******************************************************************************/
+int TPM2_TLS_Server(void* userCtx)
+{
+    int rc;
+    TlsServerKeys keys;
+    SockIoCbCtx sockIoCtx;
+    WOLFSSL_CTX* ctx = NULL;
+    WOLFSSL* ssl = NULL;
+#ifndef TLS_BENCH_MODE
+    const char webServerMsg[] =
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: text/html\r\n"
+        "Connection: close\r\n"
+        "\r\n"
+        "<html>\r\n"
+        "<head>\r\n"
+        "<title>Welcome to wolfSSL!</title>\r\n"
+        "</head>\r\n"
+        "<body>\r\n"
+        "<p>wolfSSL has successfully performed handshake!</p>\r\n"
+        "</body>\r\n"
+        "</html>\r\n";
+#endif
+    char msg[MAX_MSG_SZ];
+    int msgSz = 0;
+    double hsStart;
+#ifdef TLS_BENCH_MODE
+    int total_size;
+#endif
+
+    /* initialize variables */
+    XMEMSET(&sockIoCtx, 0, sizeof(sockIoCtx));
+    sockIoCtx.fd = -1;
+    sockIoCtx.listenFd = -1;
+
+    xil_printf("TPM2 TLS Server Example\r\n");
+
+    rc = TLS_Server_LoadKeys(&keys, userCtx);
+    if (rc != 0) goto exit;
+
+    rc = TLS_Server_NewCtx(&keys, &ctx);
+    if (rc != 0) goto exit;
+
     /* Create wolfSSL object/session */
     if ((ssl = wolfSSL_new(ctx)) == NULL) {
         rc = wolfSSL_get_error(ssl, 0);
@@ -366,9 +700,7 @@ int TPM2_TLS_Server(void* userCtx)
     if (rc != 0) goto exit;
 
     /* perform accept */
-#ifdef TLS_BENCH_MODE
-    benchStart = gettime_secs(1);
-#endif
+    hsStart = gettime_secs(1);
     do {
         rc = wolfSSL_accept(ssl);
         if (rc != WOLFSSL_SUCCESS) {
@@ -378,9 +710,11 @@ int TPM2_TLS_Server(void* userCtx)
     if (rc != WOLFSSL_SUCCESS) {
         goto exit;
     }
+    hsStart = gettime_secs(0) - hsStart;
+    TLS_Resume_Record(&keys.resume, ssl, hsStart);
 #ifdef TLS_BENCH_MODE
-    benchStart = gettime_secs(0) - benchStart;
-    xil_printf("Accept: %9.3f sec (%9.3f CPS)\r\n", benchStart, 1/benchStart);
+    xil_printf("Accept: %9.3f sec (%9.3f CPS) %s\r\n", hsStart, 1/hsStart,
+        wolfSSL_session_reused(ssl) ? "resumed" : "full");
 #endif
 
 #ifdef TLS_BENCH_MODE
@@ -455,20 +789,527 @@ exit:
     wolfSSL_free(ssl);
     wolfSSL_CTX_free(ctx);
 
-#ifndef NO_RSA
-    wc_FreeRsaKey(&wolfRsaKey);
-    wolfTPM2_UnloadHandle(&dev, &rsaKey.handle);
+    TLS_Server_FreeKeys(&keys);
+
+    return rc;
+}
+
+/******************************************************************************/
+/* --- END TLS Server Example -- */
+/******************************************************************************/
+
+
+/******************************************************************************/
+/* --- BEGIN TLS SERVER Pool -- */
+/******************************************************************************/
+
+/*
+ * Multi-connection TLS server
+ *
+ * A single long lived WOLFSSL_CTX with the TPM backed keys is shared by a pool
+ * of worker tasks. The calling (menu) task owns the non-blocking listen
+ * socket and hands accepted connections to the least loaded worker through a
+ * FreeRTOS queue. Each worker services up to TLS_POOL_SESSIONS_PER_WORKER
+ * non-blocking sessions using select().
+ *
+ * When every worker slot is busy the acceptor stops calling accept(), so new
+ * clients wait in the TCP listen backlog (backpressure) instead of being
+ * dropped.
+ *
+ * Press any key on the UART to stop the server.
+ */
+
+#ifndef TLS_POOL_WORKERS
+    #define TLS_POOL_WORKERS              2
 #endif
-#ifdef HAVE_ECC
-    wc_ecc_free(&wolfEccKey);
-    wolfTPM2_UnloadHandle(&dev, &eccKey.handle);
+#ifndef TLS_POOL_SESSIONS_PER_WORKER
+    #define TLS_POOL_SESSIONS_PER_WORKER  4
+#endif
+#ifndef TLS_POOL_STACK_SIZE
+    #define TLS_POOL_STACK_SIZE           (32*1024)
+#endif
+#ifndef TLS_POOL_LISTEN_BACKLOG
+    #define TLS_POOL_LISTEN_BACKLOG       5
 #endif
+#ifndef TLS_POOL_POLL_MS
+    #define TLS_POOL_POLL_MS              10
+#endif
+#ifndef TLS_POOL_REPORT_SEC
+    #define TLS_POOL_REPORT_SEC           5
+#endif
+
+enum TlsPoolSessionState {
+    TLS_POOL_SESS_FREE = 0,
+    TLS_POOL_SESS_ACCEPT,
+    TLS_POOL_SESS_READ,
+    TLS_POOL_SESS_WRITE,
+};
+
+typedef struct TlsPoolStats {
+    word32 accepted;      /* TCP connections handed to a worker */
+    word32 handshakes;    /* successful TLS handshakes */
+    word32 failures;      /* handshake or I/O failures */
+    word32 deferred;      /* times the acceptor paused because pool was full */
+    word64 bytesIn;
+    word64 bytesOut;
+} TlsPoolStats;
+
+typedef struct TlsPoolSession {
+    SockIoCbCtx sock;
+    WOLFSSL*    ssl;
+    int         state;
+    int         wantWrite;
+    int         msgSz;
+    double      hsStart;
+    char        msg[MAX_MSG_SZ];
+} TlsPoolSession;
+
+struct TlsPool;
+
+typedef struct TlsPoolWorker {
+    struct TlsPool* pool;
+    QueueHandle_t   newConns;    /* accepted socket fd's */
+    volatile int    active;      /* sessions in use including queued,
+                                  * protected by pool statsLock */
+    int             id;
+    int             started;     /* worker task was created */
+    TlsPoolSession  sess[TLS_POOL_SESSIONS_PER_WORKER];
+} TlsPoolWorker;
+
+typedef struct TlsPool {
+    WOLFSSL_CTX*    ctx;
+    TlsResume*      resume;
+    volatile int    running;
+    volatile int    workersDone; /* protected by statsLock */
+    wolfSSL_Mutex   statsLock;
+    TlsPoolStats    stats;
+    TlsPoolWorker   workers[TLS_POOL_WORKERS];
+} TlsPool;
+
+static const char gPoolServerMsg[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/html\r\n"
+    "Connection: close\r\n"
+    "\r\n"
+    "<html>\r\n"
+    "<body>\r\n"
+    "<p>wolfSSL pooled server has successfully performed handshake!</p>\r\n"
+    "</body>\r\n"
+    "</html>\r\n";
+
+static void TLS_Pool_StatAdd(TlsPool* pool, word32* stat, word32 val)
+{
+    if (wc_LockMutex(&pool->statsLock) == 0) {
+        *stat += val;
+        wc_UnLockMutex(&pool->statsLock);
+    }
+}
+
+static void TLS_Pool_StatAddBytes(TlsPool* pool, word64* stat, int val)
+{
+    if (wc_LockMutex(&pool->statsLock) == 0) {
+        *stat += (word64)val;
+        wc_UnLockMutex(&pool->statsLock);
+    }
+}
 
-    wolfTPM2_Cleanup(&dev);
+static void TLS_Pool_AdjustActive(TlsPoolWorker* worker, int delta)
+{
+    if (wc_LockMutex(&worker->pool->statsLock) == 0) {
+        worker->active += delta;
+        wc_UnLockMutex(&worker->pool->statsLock);
+    }
+}
+
+static int TLS_Pool_SessionStart(TlsPoolWorker* worker, int fd)
+{
+    int i;
+    TlsPoolSession* sess = NULL;
+
+    for (i = 0; i < TLS_POOL_SESSIONS_PER_WORKER; i++) {
+        if (worker->sess[i].state == TLS_POOL_SESS_FREE) {
+            sess = &worker->sess[i];
+            break;
+        }
+    }
+    if (sess == NULL || (sess->ssl = wolfSSL_new(worker->pool->ctx)) == NULL) {
+        close(fd);
+        return MEMORY_E;
+    }
+
+    sess->sock.listenFd = -1;
+    sess->sock.fd = fd;
+    sess->wantWrite = 0;
+    sess->msgSz = 0;
+    sess->hsStart = gettime_secs(0);
+    wolfSSL_set_using_nonblock(sess->ssl, 1);
+    wolfSSL_SetIOReadCtx(sess->ssl, &sess->sock);
+    wolfSSL_SetIOWriteCtx(sess->ssl, &sess->sock);
+    sess->state = TLS_POOL_SESS_ACCEPT;
+
+    return 0;
+}
+
+static void TLS_Pool_SessionEnd(TlsPoolWorker* worker, TlsPoolSession* sess)
+{
+    if (sess->ssl != NULL) {
+        wolfSSL_shutdown(sess->ssl);
+        wolfSSL_free(sess->ssl);
+        sess->ssl = NULL;
+    }
+    CloseAndCleanupSocket(&sess->sock);
+    sess->state = TLS_POOL_SESS_FREE;
+    TLS_Pool_AdjustActive(worker, -1);
+}
+
+/* Advances the session state machine as far as the socket allows.
+ * Returns 0 to keep the session, 1 when complete or a negative error */
+static int TLS_Pool_SessionStep(TlsPool* pool, TlsPoolSession* sess)
+{
+    int rc;
+
+    sess->wantWrite = 0;
+    for (;;) {
+        switch (sess->state) {
+            case TLS_POOL_SESS_ACCEPT:
+                rc = wolfSSL_accept(sess->ssl);
+                if (rc != WOLFSSL_SUCCESS) {
+                    break;
+                }
+                TLS_Pool_StatAdd(pool, &pool->stats.handshakes, 1);
+                TLS_Resume_Record(pool->resume, sess->ssl,
+                    gettime_secs(0) - sess->hsStart);
+                sess->state = TLS_POOL_SESS_READ;
+                continue;
+
+            case TLS_POOL_SESS_READ:
+                rc = wolfSSL_read(sess->ssl, sess->msg, sizeof(sess->msg));
+                if (rc <= 0) {
+                    break;
+                }
+                TLS_Pool_StatAddBytes(pool, &pool->stats.bytesIn, rc);
+            #ifdef TLS_BENCH_MODE
+                sess->msgSz = rc; /* echo data back for throughput */
+            #else
+                sess->msgSz = (int)sizeof(gPoolServerMsg);
+                XMEMCPY(sess->msg, gPoolServerMsg, sess->msgSz);
+            #endif
+                sess->state = TLS_POOL_SESS_WRITE;
+                continue;
+
+            case TLS_POOL_SESS_WRITE:
+                rc = wolfSSL_write(sess->ssl, sess->msg, sess->msgSz);
+                if (rc != sess->msgSz) {
+                    break;
+                }
+                TLS_Pool_StatAddBytes(pool, &pool->stats.bytesOut, rc);
+            #ifdef TLS_BENCH_MODE
+                sess->state = TLS_POOL_SESS_READ;
+                continue;
+            #else
+                return 1; /* single request / response */
+            #endif
+
+            default:
+                return BAD_FUNC_ARG;
+        }
+
+        /* operation did not complete */
+        rc = wolfSSL_get_error(sess->ssl, 0);
+        if (rc == WOLFSSL_ERROR_WANT_READ) {
+            return 0;
+        }
+        if (rc == WOLFSSL_ERROR_WANT_WRITE) {
+            sess->wantWrite = 1;
+            return 0;
+        }
+        if (rc == WOLFSSL_ERROR_ZERO_RETURN ||
+                (sess->state == TLS_POOL_SESS_READ && rc == SOCKET_PEER_CLOSED_E)) {
+            return 1; /* peer closed */
+        }
+        return rc;
+    }
+}
+
+static void TLS_Pool_WorkerThread(void* p)
+{
+    TlsPoolWorker* worker = (TlsPoolWorker*)p;
+    TlsPool* pool = worker->pool;
+    TlsPoolSession* sess;
+    fd_set rfds, wfds;
+    struct timeval tv;
+    int i, rc, fd, maxFd, inUse;
+
+    while (pool->running) {
+        /* count local sessions */
+        inUse = 0;
+        for (i = 0; i < TLS_POOL_SESSIONS_PER_WORKER; i++) {
+            if (worker->sess[i].state != TLS_POOL_SESS_FREE)
+                inUse++;
+        }
+
+        /* pick up new connections, block briefly when idle */
+        while (inUse < TLS_POOL_SESSIONS_PER_WORKER &&
+               xQueueReceive(worker->newConns, &fd,
+                    inUse == 0 ? pdMS_TO_TICKS(TLS_POOL_POLL_MS) : 0) == pdTRUE) {
+            if (TLS_Pool_SessionStart(worker, fd) != 0) {
+                TLS_Pool_StatAdd(pool, &pool->stats.failures, 1);
+                TLS_Pool_AdjustActive(worker, -1);
+                continue;
+            }
+            inUse++;
+        }
+        if (inUse == 0) {
+            continue;
+        }
+
+        /* wait for socket activity */
+        FD_ZERO(&rfds);
+        FD_ZERO(&wfds);
+        maxFd = -1;
+        tv.tv_sec = 0;
+        tv.tv_usec = TLS_POOL_POLL_MS * 1000;
+        for (i = 0; i < TLS_POOL_SESSIONS_PER_WORKER; i++) {
+            sess = &worker->sess[i];
+            if (sess->state == TLS_POOL_SESS_FREE)
+                continue;
+            /* decrypted data already buffered, don't wait on the socket */
+            if (wolfSSL_pending(sess->ssl) > 0)
+                tv.tv_usec = 0;
+            FD_SET(sess->sock.fd, sess->wantWrite ? &wfds : &rfds);
+            if (sess->sock.fd > maxFd)
+                maxFd = sess->sock.fd;
+        }
+        if (select(maxFd + 1, &rfds, &wfds, NULL, &tv) < 0) {
+            vTaskDelay(1);
+            continue;
+        }
+
+        /* service ready sessions */
+        for (i = 0; i < TLS_POOL_SESSIONS_PER_WORKER; i++) {
+            sess = &worker->sess[i];
+            if (sess->state == TLS_POOL_SESS_FREE)
+                continue;
+            if (!FD_ISSET(sess->sock.fd, &rfds) &&
+                !FD_ISSET(sess->sock.fd, &wfds) &&
+                wolfSSL_pending(sess->ssl) == 0)
+                continue;
+
+            rc = TLS_Pool_SessionStep(pool, sess);
+            if (rc != 0) {
+                if (rc < 0) {
+                    TLS_Pool_StatAdd(pool, &pool->stats.failures, 1);
+                #ifdef DEBUG_WOLFTPM
+                    xil_printf("Worker %d: session failure %d\r\n",
+                        worker->id, rc);
+                #endif
+                }
+                TLS_Pool_SessionEnd(worker, sess);
+            }
+        }
+    }
+
+    /* shutting down: close remaining sessions and queued connections */
+    for (i = 0; i < TLS_POOL_SESSIONS_PER_WORKER; i++) {
+        if (worker->sess[i].state != TLS_POOL_SESS_FREE)
+            TLS_Pool_SessionEnd(worker, &worker->sess[i]);
+    }
+    while (xQueueReceive(worker->newConns, &fd, 0) == pdTRUE) {
+        close(fd);
+        TLS_Pool_AdjustActive(worker, -1);
+    }
+
+    if (wc_LockMutex(&pool->statsLock) == 0) {
+        pool->workersDone++;
+        wc_UnLockMutex(&pool->statsLock);
+    }
+    wolf_rng_task_free();
+    vTaskDelete(NULL);
+}
+
+/* Returns the least loaded worker with a free session slot or NULL if the
+ * pool is saturated */
+static TlsPoolWorker* TLS_Pool_PickWorker(TlsPool* pool)
+{
+    int i;
+    TlsPoolWorker* best = NULL;
+
+    for (i = 0; i < TLS_POOL_WORKERS; i++) {
+        TlsPoolWorker* worker = &pool->workers[i];
+        if (!worker->started ||
+                worker->active >= TLS_POOL_SESSIONS_PER_WORKER)
+            continue;
+        if (best == NULL || worker->active < best->active)
+            best = worker;
+    }
+    return best;
+}
+
+static void TLS_Pool_Report(TlsPool* pool, double elapsed)
+{
+    TlsPoolStats stats;
+
+    if (wc_LockMutex(&pool->statsLock) != 0)
+        return;
+    stats = pool->stats;
+    wc_UnLockMutex(&pool->statsLock);
+
+    if (elapsed <= 0)
+        return;
+
+    xil_printf("Pool: %u conns, %u handshakes (%9.3f CPS), %u failures, "
+        "%u deferred\r\n", stats.accepted, stats.handshakes,
+        stats.handshakes / elapsed, stats.failures, stats.deferred);
+    xil_printf("Pool: in %9.3f KB/sec, out %9.3f KB/sec\r\n",
+        (double)stats.bytesIn / elapsed / 1024,
+        (double)stats.bytesOut / elapsed / 1024);
+    TLS_Resume_Report(pool->resume);
+}
+
+int TPM2_TLS_ServerPool(void* userCtx)
+{
+    int rc;
+    int i, fd, started = 0, stalled = 0;
+    TlsServerKeys keys;
+    SockIoCbCtx listenCtx;
+    TlsPool* pool;
+    TlsPoolWorker* worker;
+    fd_set rfds;
+    struct timeval tv;
+    double start, lastReport;
+
+    xil_printf("TPM2 TLS Server Pool: %d workers x %d sessions\r\n",
+        TLS_POOL_WORKERS, TLS_POOL_SESSIONS_PER_WORKER);
+
+    XMEMSET(&listenCtx, 0, sizeof(listenCtx));
+    listenCtx.fd = -1;
+    listenCtx.listenFd = -1;
+
+    pool = (TlsPool*)XMALLOC(sizeof(TlsPool), NULL, DYNAMIC_TYPE_TMP_BUFFER);
+    if (pool == NULL) {
+        return MEMORY_E;
+    }
+    XMEMSET(pool, 0, sizeof(TlsPool));
+    if (wc_InitMutex(&pool->statsLock) != 0) {
+        XFREE(pool, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+        return BAD_MUTEX_E;
+    }
+
+    rc = TLS_Server_LoadKeys(&keys, userCtx);
+    if (rc != 0) goto exit;
+
+    /* one long lived context shared by all sessions */
+    rc = TLS_Server_NewCtx(&keys, &pool->ctx);
+    if (rc != 0) goto exit;
+    pool->resume = &keys.resume;
+
+    rc = SetupSocketAndListen(&listenCtx, TLS_PORT);
+    if (rc == 0)
+        rc = SocketSetNonBlocking(listenCtx.listenFd);
+    if (rc != 0) goto exit;
+
+    /* start workers */
+    pool->running = 1;
+    for (i = 0; i < TLS_POOL_WORKERS; i++) {
+        worker = &pool->workers[i];
+        worker->pool = pool;
+        worker->id = i;
+        worker->newConns = xQueueCreate(TLS_POOL_SESSIONS_PER_WORKER,
+            sizeof(int));
+        if (worker->newConns == NULL) {
+            rc = MEMORY_E;
+            break;
+        }
+        /* lwIP socket users are created with sys_thread_new (NULL when
+         * the task could not be created) */
+        if (sys_thread_new("tlsw", TLS_Pool_WorkerThread, worker,
+                (TLS_POOL_STACK_SIZE / sizeof(size_t)),
+                DEFAULT_THREAD_PRIO) == NULL) {
+            xil_printf("TLS pool worker %d start failed\r\n", i);
+            continue;
+        }
+        worker->started = 1;
+        started++;
+    }
+    if (rc == 0 && started == 0)
+        rc = MEMORY_E;
+    if (rc != 0) goto exit;
+
+    xil_printf("Waiting on client connections (press any key to stop)\r\n");
+    start = lastReport = gettime_secs(1);
+
+    while (!XUartPs_IsReceiveData(STDIN_BASEADDRESS)) {
+        worker = TLS_Pool_PickWorker(pool);
+        if (worker == NULL) {
+            /* backpressure: leave clients in the listen backlog */
+            if (!stalled) {
+                TLS_Pool_StatAdd(pool, &pool->stats.deferred, 1);
+                stalled = 1;
+            }
+            vTaskDelay(pdMS_TO_TICKS(TLS_POOL_POLL_MS));
+            continue;
+        }
+        stalled = 0;
+
+        FD_ZERO(&rfds);
+        FD_SET(listenCtx.listenFd, &rfds);
+        tv.tv_sec = 0;
+        tv.tv_usec = 100 * 1000;
+        if (select(listenCtx.listenFd + 1, &rfds, NULL, NULL, &tv) > 0) {
+            rc = SocketAcceptNonBlocking(&listenCtx, &fd);
+            if (rc == 0) {
+                TLS_Pool_AdjustActive(worker, 1);
+                if (xQueueSend(worker->newConns, &fd, 0) != pdTRUE) {
+                    TLS_Pool_AdjustActive(worker, -1);
+                    close(fd);
+                    TLS_Pool_StatAdd(pool, &pool->stats.failures, 1);
+                }
+                else {
+                    TLS_Pool_StatAdd(pool, &pool->stats.accepted, 1);
+                }
+            }
+            rc = 0;
+        }
+
+    #ifdef TLS_BENCH_MODE
+        if (gettime_secs(0) - lastReport >= TLS_POOL_REPORT_SEC) {
+            lastReport = gettime_secs(0);
+            TLS_Pool_Report(pool, lastReport - start);
+        }
+    #endif
+    }
+    (void)XUartPs_RecvByte(STDIN_BASEADDRESS);
+
+    TLS_Pool_Report(pool, gettime_secs(0) - start);
+    (void)lastReport;
+
+exit:
+
+    if (rc != 0) {
+        xil_printf("Failure %d (0x%x): %s\r\n", rc, rc, wolfTPM2_GetRCString(rc));
+    }
+
+    /* stop and wait for workers */
+    pool->running = 0;
+    while (pool->workersDone < started) {
+        vTaskDelay(pdMS_TO_TICKS(TLS_POOL_POLL_MS));
+    }
+    for (i = 0; i < TLS_POOL_WORKERS; i++) {
+        if (pool->workers[i].newConns != NULL)
+            vQueueDelete(pool->workers[i].newConns);
+    }
+
+    CloseAndCleanupSocket(&listenCtx);
+    wolfSSL_CTX_free(pool->ctx);
+
+    TLS_Server_FreeKeys(&keys);
+
+    wc_FreeMutex(&pool->statsLock);
+    XFREE(pool, NULL, DYNAMIC_TYPE_TMP_BUFFER);
 
     return rc;
 }
 
 /******************************************************************************/
-/* --- END TLS Server Example -- */
+/* --- END TLS Server Pool -- */
 /******************************************************************************/
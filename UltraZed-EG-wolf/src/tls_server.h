@@ -27,6 +27,7 @@
 #endif
 
 int TPM2_TLS_Server(void* userCtx);
+int TPM2_TLS_ServerPool(void* userCtx);
 
 #ifdef __cplusplus
     }  /* extern "C" */
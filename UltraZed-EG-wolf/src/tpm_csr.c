@@ -25,6 +25,7 @@
 
 #include "tpm_io.h"
 #include "tpm_test.h"
+#include "wolf_port.h"
 #include "tpm_csr.h"
 
 #include <wolfssl/wolfcrypt/asn_public.h>
@@ -155,7 +156,7 @@ int TPM2_CSR_Example(void* userCtx)
     printf("TPM2 CSR Example\r\n");
 
     /* Init the TPM2 device */
-    rc = wolfTPM2_Init(&dev, TPM2_IoCb, userCtx);
+    rc = wolf_tpm_init(userCtx);
     if (rc != 0) return rc;
 
     /* Setup the wolf crypto device callback */
@@ -282,7 +283,7 @@ exit:
     wolfTPM2_UnloadHandle(&dev, &eccKey.handle);
 #endif
 
-    wolfTPM2_Cleanup(&dev);
+    wolf_tpm_cleanup();
 
     return rc;
 }
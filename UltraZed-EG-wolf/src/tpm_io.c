@@ -28,6 +28,9 @@
 
 #include <stdio.h>
 #include "xil_printf.h"
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "xparameters.h"
 
 
 
@@ -38,12 +41,6 @@
 /* Configuration for the SPI interface */
 /* SPI Requirement: Mode 0 (CPOL=0, CPHA=0) */
 
-/* Use the max speed by default - see tpm2_types.h for chip specific max values */
-#ifndef TPM2_SPI_HZ
-    #define TPM2_SPI_HZ TPM2_SPI_MAX_HZ
-#endif
-
-
 #include "xspips.h"
 static int SpiInitDone;
 static XSpiPs SpiInstance;
@@ -64,16 +61,114 @@ static XSpiPs SpiInstance;
 #define XSpiPs_RecvByte(BaseAddress) \
     XSpiPs_In32((u32)((BaseAddress) + (u32)XSPIPS_RXD_OFFSET))
 
+/* SPI reference clock, the actual rate is this divided by prescaler 4-256 */
+#ifndef TPM2_SPI_REF_CLK_HZ
+    #ifdef XPAR_XSPIPS_0_SPI_CLK_FREQ_HZ
+        #define TPM2_SPI_REF_CLK_HZ XPAR_XSPIPS_0_SPI_CLK_FREQ_HZ
+    #else
+        #define TPM2_SPI_REF_CLK_HZ 200000000
+    #endif
+#endif
+static word32 SpiClockHz = TPM2_SPI_HZ;
+
+/* Interrupt driven transfer mode (TPM2_SPI_MODE_INTERRUPT). The SPI
+ * interrupt is connected to the FreeRTOS port XScuGic instance and the
+ * calling task blocks on a semaphore while the FIFO drains. Transfers smaller
+ * than TPM2_SPI_INTR_MIN_SZ are polled, since the interrupt and context
+ * switch cost more than the transfer itself. */
+#ifndef TPM2_SPI_INTR_ID
+    #define TPM2_SPI_INTR_ID      XPAR_XSPIPS_0_INTR
+#endif
+#ifndef TPM2_SPI_INTR_MIN_SZ
+    #define TPM2_SPI_INTR_MIN_SZ  32
+#endif
+#ifndef TPM2_SPI_INTR_TIMEOUT_MS
+    #define TPM2_SPI_INTR_TIMEOUT_MS 100
+#endif
+#ifdef TPM2_SPI_USE_INTERRUPT
+    static int SpiMode = TPM2_SPI_MODE_INTERRUPT;
+#else
+    static int SpiMode = TPM2_SPI_MODE_POLLED;
+#endif
+static int SpiIntrReady;
+static SemaphoreHandle_t SpiDoneSem;
+static volatile s32 SpiXferStatus;
+static volatile u32 SpiXferCount; /* bytes in the TX FIFO */
+
+/* Transport statistics, time is in CNTPCT ticks */
+static TpmSpiStats SpiStats;
+#ifndef XPAR_CPU_CORTEXA53_0_TIMESTAMP_CLK_FREQ
+    #define XPAR_CPU_CORTEXA53_0_TIMESTAMP_CLK_FREQ 50000000
+#endif
+
+static inline word64 TPM2_IoCb_Ticks(void)
+{
+    word64 cntPct = 0;
+    asm volatile("mrs %0, CNTPCT_EL0" : "=r" (cntPct));
+    return cntPct;
+}
+
+/* Fill the TX FIFO with as many bytes as it will take (or as many as we have
+ * to send). Returns the number of bytes queued */
+static u32 TPM2_IoCb_Xilinx_SPIFill(XSpiPs *InstancePtr)
+{
+    u32 TransCount = 0U;
+
+    while ((InstancePtr->RemainingBytes > (u32)0U) &&
+        (TransCount < (u32)XSPIPS_FIFO_DEPTH))
+    {
+        XSpiPs_SendByte(InstancePtr->Config.BaseAddress,
+            *InstancePtr->SendBufferPtr);
+        InstancePtr->SendBufferPtr += 1;
+        InstancePtr->RemainingBytes--;
+        ++TransCount;
+    }
+    return TransCount;
+}
+
+/* If master mode and manual start mode, issue manual start command to start
+ * the transfer. */
+static void TPM2_IoCb_Xilinx_SPIStart(XSpiPs *InstancePtr)
+{
+    u32 ConfigReg;
+
+    if ((XSpiPs_IsManualStart(InstancePtr) == TRUE) &&
+        (XSpiPs_IsMaster(InstancePtr) == TRUE))
+    {
+        ConfigReg = XSpiPs_ReadReg(InstancePtr->Config.BaseAddress,
+            XSPIPS_CR_OFFSET);
+        ConfigReg |= XSPIPS_CR_MANSTRT_MASK;
+        XSpiPs_WriteReg(InstancePtr->Config.BaseAddress,
+            XSPIPS_CR_OFFSET, ConfigReg);
+    }
+}
+
+/* Process received data for the transmit that just completed. Always get the
+ * received data, but only fill the receive buffer if it points to something
+ * (the upper layer software may not care to receive data). */
+static void TPM2_IoCb_Xilinx_SPIDrain(XSpiPs *InstancePtr, u32 TransCount)
+{
+    u8 TempData;
+
+    while (TransCount != (u32)0U) {
+        TempData = (u8)XSpiPs_RecvByte(InstancePtr->Config.BaseAddress);
+        if (InstancePtr->RecvBufferPtr != NULL) {
+            *(InstancePtr->RecvBufferPtr) = TempData;
+            InstancePtr->RecvBufferPtr += 1;
+        }
+        InstancePtr->RequestedBytes--;
+        --TransCount;
+    }
+}
+
 /* Modified version of XSpiPs_PolledTransfer that allows enable and CS to 
     * be used across multiple transfers */
 static s32 TPM2_IoCb_Xilinx_SPITransfer(XSpiPs *InstancePtr, u8 *SendBufPtr,
     u8 *RecvBufPtr, u32 ByteCount)
 {
     u32 StatusReg;
-    u32 ConfigReg;
     u32 TransCount;
     u32 CheckTransfer;
-    u8 TempData;
 
     /* Set up buffer pointers */
     InstancePtr->SendBufferPtr = SendBufPtr;
@@ -84,31 +179,8 @@ static s32 TPM2_IoCb_Xilinx_SPITransfer(XSpiPs *InstancePtr, u8 *SendBufPtr,
     while((InstancePtr->RemainingBytes > (u32)0U) ||
             (InstancePtr->RequestedBytes > (u32)0U))
     {
-        TransCount = 0U;
-
-        /* Fill the TXFIFO with as many bytes as it will take (or as
-            * many as we have to send). */
-        while ((InstancePtr->RemainingBytes > (u32)0U) && 
-            ((u32)TransCount < (u32)XSPIPS_FIFO_DEPTH))
-        {
-            XSpiPs_SendByte(InstancePtr->Config.BaseAddress, 
-                *InstancePtr->SendBufferPtr);
-            InstancePtr->SendBufferPtr += 1;
-            InstancePtr->RemainingBytes--;
-            ++TransCount;
-        }
-
-        /* If master mode and manual start mode, issue manual start
-            * command to start the transfer. */
-        if ((XSpiPs_IsManualStart(InstancePtr) == TRUE) && 
-            (XSpiPs_IsMaster(InstancePtr) == TRUE))
-        {
-            ConfigReg = XSpiPs_ReadReg(InstancePtr->Config.BaseAddress, 
-                XSPIPS_CR_OFFSET);
-            ConfigReg |= XSPIPS_CR_MANSTRT_MASK;
-            XSpiPs_WriteReg(InstancePtr->Config.BaseAddress, 
-                XSPIPS_CR_OFFSET, ConfigReg);
-        }
+        TransCount = TPM2_IoCb_Xilinx_SPIFill(InstancePtr);
+        TPM2_IoCb_Xilinx_SPIStart(InstancePtr);
 
         /* Wait for the transfer to finish by polling Tx fifo status. */
         CheckTransfer = (u32)0U;
@@ -124,36 +196,178 @@ static s32 TPM2_IoCb_Xilinx_SPITransfer(XSpiPs *InstancePtr, u8 *SendBufPtr,
             CheckTransfer = (StatusReg & XSPIPS_IXR_TXOW_MASK);
         }
 
-        /*
-            * A transmit has just completed. Process received data and
-            * check for more data to transmit.
-            * First get the data received as a result of the transmit
-            * that just completed. Receive data based on the
-            * count obtained while filling tx fifo. Always get the
-            * received data, but only fill the receive buffer if it
-            * points to something (the upper layer software may not
-            * care to receive data).
-            */
-        while (TransCount != (u32)0U) {
-            TempData = (u8)XSpiPs_RecvByte(InstancePtr->Config.BaseAddress);
-            if (InstancePtr->RecvBufferPtr != NULL) {
-                *(InstancePtr->RecvBufferPtr) = TempData;
-                InstancePtr->RecvBufferPtr += 1;
-            }
-            InstancePtr->RequestedBytes--;
-            --TransCount;
-        }
+        TPM2_IoCb_Xilinx_SPIDrain(InstancePtr, TransCount);
     }
 
     return (s32)XST_SUCCESS;
 }
 
+/* SPI interrupt: drain the completed FIFO, refill or signal the waiting task */
+static void TPM2_IoCb_Xilinx_SPIIsr(void* ref)
+{
+    XSpiPs *InstancePtr = (XSpiPs*)ref;
+    u32 BaseAddress = InstancePtr->Config.BaseAddress;
+    u32 StatusReg;
+    int done = 0;
+    BaseType_t woken = pdFALSE;
+
+    StatusReg = XSpiPs_ReadReg(BaseAddress, XSPIPS_SR_OFFSET);
+    XSpiPs_WriteReg(BaseAddress, XSPIPS_SR_OFFSET,
+        StatusReg & XSPIPS_IXR_WR_TO_CLR_MASK);
+
+    if ((StatusReg & XSPIPS_IXR_MODF_MASK) != 0U) {
+        SpiXferStatus = (s32)XST_SEND_ERROR;
+        done = 1;
+    }
+    else if ((StatusReg & XSPIPS_IXR_TXOW_MASK) != 0U) {
+        TPM2_IoCb_Xilinx_SPIDrain(InstancePtr, SpiXferCount);
+        if (InstancePtr->RemainingBytes > (u32)0U) {
+            SpiXferCount = TPM2_IoCb_Xilinx_SPIFill(InstancePtr);
+            TPM2_IoCb_Xilinx_SPIStart(InstancePtr);
+        }
+        else {
+            SpiXferStatus = (s32)XST_SUCCESS;
+            done = 1;
+        }
+    }
+
+    if (done) {
+        XSpiPs_WriteReg(BaseAddress, XSPIPS_IDR_OFFSET,
+            XSPIPS_IXR_MODF_MASK | XSPIPS_IXR_TXOW_MASK);
+        xSemaphoreGiveFromISR(SpiDoneSem, &woken);
+    }
+    portYIELD_FROM_ISR(woken);
+}
+
+/* Interrupt driven version of TPM2_IoCb_Xilinx_SPITransfer. The calling task
+ * blocks until the whole transfer has completed. */
+static s32 TPM2_IoCb_Xilinx_SPITransferIntr(XSpiPs *InstancePtr,
+    u8 *SendBufPtr, u8 *RecvBufPtr, u32 ByteCount)
+{
+    s32 status;
+    word64 start;
+
+    if (!SpiIntrReady || SpiMode != TPM2_SPI_MODE_INTERRUPT ||
+            ByteCount < TPM2_SPI_INTR_MIN_SZ) {
+        return TPM2_IoCb_Xilinx_SPITransfer(InstancePtr, SendBufPtr,
+            RecvBufPtr, ByteCount);
+    }
+
+    InstancePtr->SendBufferPtr = SendBufPtr;
+    InstancePtr->RecvBufferPtr = RecvBufPtr;
+    InstancePtr->RequestedBytes = ByteCount;
+    InstancePtr->RemainingBytes = ByteCount;
+    SpiXferStatus = (s32)XST_FAILURE;
+
+    SpiXferCount = TPM2_IoCb_Xilinx_SPIFill(InstancePtr);
+    XSpiPs_WriteReg(InstancePtr->Config.BaseAddress, XSPIPS_IER_OFFSET,
+        XSPIPS_IXR_MODF_MASK | XSPIPS_IXR_TXOW_MASK);
+    TPM2_IoCb_Xilinx_SPIStart(InstancePtr);
+
+    start = TPM2_IoCb_Ticks();
+    if (xSemaphoreTake(SpiDoneSem, pdMS_TO_TICKS(TPM2_SPI_INTR_TIMEOUT_MS))
+            != pdTRUE) {
+        XSpiPs_WriteReg(InstancePtr->Config.BaseAddress, XSPIPS_IDR_OFFSET,
+            XSPIPS_IXR_MODF_MASK | XSPIPS_IXR_TXOW_MASK);
+        /* clear a completion that raced the timeout */
+        (void)xSemaphoreTake(SpiDoneSem, 0);
+        status = (s32)XST_FAILURE;
+    }
+    else {
+        status = SpiXferStatus;
+    }
+    SpiStats.waitTicks += TPM2_IoCb_Ticks() - start;
+    SpiStats.intrXfers++;
+
+    return status;
+}
+
+static int TPM2_IoCb_Xilinx_SPIIntrInit(void)
+{
+    SpiDoneSem = xSemaphoreCreateBinary();
+    if (SpiDoneSem == NULL) {
+        return TPM_RC_FAILURE;
+    }
+    /* connect to the FreeRTOS port XScuGic instance */
+    if (xPortInstallInterruptHandler(TPM2_SPI_INTR_ID,
+            TPM2_IoCb_Xilinx_SPIIsr, &SpiInstance) != pdPASS) {
+        vSemaphoreDelete(SpiDoneSem);
+        SpiDoneSem = NULL;
+        return TPM_RC_FAILURE;
+    }
+    vPortEnableInterrupt(TPM2_SPI_INTR_ID);
+    SpiIntrReady = 1;
+    return TPM_RC_SUCCESS;
+}
+
+/* Returns the prescaler for the fastest clock not above hz */
+static u8 TPM2_IoCb_Xilinx_SPIPrescaler(word32 refHz, word32 hz,
+    word32* actualHz)
+{
+    u8 prescaler = XSPIPS_CLK_PRESCALE_4;
+    word32 div = 4;
+
+    if (hz > TPM2_SPI_MAX_HZ)
+        hz = TPM2_SPI_MAX_HZ;
+    while ((refHz / div) > hz && prescaler < XSPIPS_CLK_PRESCALE_256) {
+        div <<= 1;
+        prescaler++;
+    }
+    if (actualHz)
+        *actualHz = refHz / div;
+    return prescaler;
+}
+
+int TPM2_IoCb_SetSpiClock(word32 hz)
+{
+    word32 refHz = TPM2_SPI_REF_CLK_HZ;
+    word32 actualHz = 0;
+    u8 prescaler;
+
+    if (hz == 0)
+        return BAD_FUNC_ARG;
+    if (SpiInitDone && SpiInstance.Config.InputClockHz != 0)
+        refHz = SpiInstance.Config.InputClockHz;
+
+    prescaler = TPM2_IoCb_Xilinx_SPIPrescaler(refHz, hz, &actualHz);
+    SpiClockHz = hz;
+    if (SpiInitDone) {
+        if (XSpiPs_SetClkPrescaler(&SpiInstance, prescaler) != XST_SUCCESS)
+            return TPM_RC_FAILURE;
+    }
+    return (int)actualHz;
+}
+
+int TPM2_IoCb_SetSpiMode(int mode)
+{
+    if (mode != TPM2_SPI_MODE_POLLED && mode != TPM2_SPI_MODE_INTERRUPT)
+        return BAD_FUNC_ARG;
+    if (mode == TPM2_SPI_MODE_INTERRUPT && SpiInitDone && !SpiIntrReady) {
+        if (TPM2_IoCb_Xilinx_SPIIntrInit() != TPM_RC_SUCCESS)
+            return TPM_RC_FAILURE;
+    }
+    SpiMode = mode;
+    return TPM_RC_SUCCESS;
+}
+
+void TPM2_IoCb_GetSpiStats(TpmSpiStats* stats, int reset)
+{
+    if (stats != NULL) {
+        *stats = SpiStats;
+        stats->tickHz = XPAR_CPU_CORTEXA53_0_TIMESTAMP_CLK_FREQ;
+    }
+    if (reset) {
+        XMEMSET(&SpiStats, 0, sizeof(SpiStats));
+    }
+}
+
 static int TPM2_IoCb_Xilinx_SPI(TPM2_CTX* ctx, const byte* txBuf,
     byte* rxBuf, word16 xferSz, void* userCtx)
 {
     int ret = TPM_RC_FAILURE;
     int status;
     XSpiPs_Config *SpiConfig;
+    word64 start, waitTicks;
 #ifdef WOLFTPM_CHECK_WAIT_STATE
     int timeout = TPM_SPI_WAIT_RETRY;
 #endif
@@ -177,8 +391,19 @@ static int TPM2_IoCb_Xilinx_SPI(TPM2_CTX* ctx, const byte* txBuf,
         /* Set the SPI device as a master */
         XSpiPs_SetOptions(&SpiInstance, XSPIPS_MASTER_OPTION | 
             XSPIPS_FORCE_SSELECT_OPTION | XSPIPS_MANUAL_START_OPTION);
-        /* SPI Core Clock: 200MHz / 16 = 12.5 MHz */
-        XSpiPs_SetClkPrescaler(&SpiInstance, XSPIPS_CLK_PRESCALE_16);
+        /* SPI Core Clock: 200MHz / prescaler (4-256), limited to
+         * TPM2_SPI_MAX_HZ. For example 12.5 MHz = /16, 25 MHz = /8 */
+        XSpiPs_SetClkPrescaler(&SpiInstance, TPM2_IoCb_Xilinx_SPIPrescaler(
+            SpiConfig->InputClockHz ? SpiConfig->InputClockHz :
+                TPM2_SPI_REF_CLK_HZ, SpiClockHz, NULL));
+
+        /* Interrupt mode falls back to polled if the interrupt is not
+         * available */
+        if (SpiMode == TPM2_SPI_MODE_INTERRUPT &&
+                TPM2_IoCb_Xilinx_SPIIntrInit() != TPM_RC_SUCCESS) {
+            xil_printf("TPM SPI interrupt setup failed, using polled\r\n");
+            SpiMode = TPM2_SPI_MODE_POLLED;
+        }
 
         /* Setup the Reset line and set high */
         gpio_cfg = XGpioPs_LookupConfig(XPAR_PSU_GPIO_0_DEVICE_ID);
@@ -197,6 +422,9 @@ static int TPM2_IoCb_Xilinx_SPI(TPM2_CTX* ctx, const byte* txBuf,
         SpiInitDone = 1;
     }
 
+    start = TPM2_IoCb_Ticks();
+    waitTicks = SpiStats.waitTicks;
+
     XSpiPs_Enable(&SpiInstance);
     XSpiPs_SetSlaveSelect(&SpiInstance, TPM2_SPI_CHIPSELECT);
 
@@ -230,13 +458,13 @@ static int TPM2_IoCb_Xilinx_SPI(TPM2_CTX* ctx, const byte* txBuf,
     }
 
     /* Send remainder of payload */
-    status = TPM2_IoCb_Xilinx_SPITransfer(&SpiInstance,
+    status = TPM2_IoCb_Xilinx_SPITransferIntr(&SpiInstance,
         (byte*)&txBuf[TPM_TIS_HEADER_SZ],
         &rxBuf[TPM_TIS_HEADER_SZ],
         xferSz - TPM_TIS_HEADER_SZ);
 #else
     /* Send Entire Message - no wait states */
-    status = TPM2_IoCb_Xilinx_SPITransfer(&SpiInstance, 
+    status = TPM2_IoCb_Xilinx_SPITransferIntr(&SpiInstance, 
         (byte*)txBuf, rxBuf, xferSz);
 #endif /* WOLFTPM_CHECK_WAIT_STATE */
     if (status == XST_SUCCESS) {
@@ -246,6 +474,12 @@ static int TPM2_IoCb_Xilinx_SPI(TPM2_CTX* ctx, const byte* txBuf,
     XSpiPs_SetSlaveSelect(&SpiInstance, 0xF); /* deselect CS (set high) */
     XSpiPs_Disable(&SpiInstance);
 
+    /* CPU busy time excludes time blocked on the SPI interrupt */
+    SpiStats.xfers++;
+    SpiStats.bytes += xferSz;
+    SpiStats.busyTicks += (TPM2_IoCb_Ticks() - start) -
+        (SpiStats.waitTicks - waitTicks);
+
     (void)userCtx;
     (void)ctx;
 
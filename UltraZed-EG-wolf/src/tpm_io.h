@@ -37,6 +37,31 @@ int TPM2_IoCb(TPM2_CTX* ctx, const byte* txBuf, byte* rxBuf,
     word16 xferSz, void* userCtx);
 #endif
 
+/* Use the max speed by default - see tpm2_types.h for chip specific max values */
+#ifndef TPM2_SPI_HZ
+    #define TPM2_SPI_HZ TPM2_SPI_MAX_HZ
+#endif
+
+/* SPI transport modes */
+enum {
+    TPM2_SPI_MODE_POLLED = 0,     /* busy poll the SPI FIFO */
+    TPM2_SPI_MODE_INTERRUPT = 1,  /* block calling task until SPI interrupt */
+};
+
+typedef struct TpmSpiStats {
+    word32 xfers;      /* SPI transactions (chip select cycles) */
+    word32 intrXfers;  /* transfers completed using the interrupt */
+    word64 bytes;
+    word64 busyTicks;  /* CPU time spent in IO callback */
+    word64 waitTicks;  /* time blocked waiting on the SPI interrupt */
+    word32 tickHz;     /* tick rate for busyTicks / waitTicks */
+} TpmSpiStats;
+
+int TPM2_IoCb_SetSpiMode(int mode);
+/* Returns actual SPI clock (limited to TPM2_SPI_MAX_HZ) or negative error */
+int TPM2_IoCb_SetSpiClock(word32 hz);
+void TPM2_IoCb_GetSpiStats(TpmSpiStats* stats, int reset);
+
 #ifdef __cplusplus
     }  /* extern "C" */
 #endif
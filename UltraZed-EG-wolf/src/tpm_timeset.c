@@ -25,6 +25,7 @@
 
 #include "tpm_io.h"
 #include "tpm_test.h"
+#include "wolf_port.h"
 #include "tpm_timeset.h"
 
 #include <stdio.h>
@@ -49,7 +50,7 @@ int TPM2_ClockGet_Example(void* userCtx, UINT64* clockOut)
     TPM2_AUTH_SESSION session[MAX_SESSION_NUM];
 
     xil_printf("TPM2 Demo of setting the TPM clock forward\r\n");
-    rc = wolfTPM2_Init(&dev, TPM2_IoCb, userCtx);
+    rc = wolf_tpm_init(userCtx);
     if (rc != TPM_RC_SUCCESS) {
         xil_printf("wolfTPM2_Init failed 0x%x: %s\r\n", rc, TPM2_GetRCString(rc));
         goto exit;
@@ -88,7 +89,7 @@ exit:
         xil_printf("Failure 0x%x: %s\r\n", rc, wolfTPM2_GetRCString(rc));
     }
 
-    wolfTPM2_Cleanup(&dev);
+    wolf_tpm_cleanup();
 
     return rc;
 }
@@ -111,7 +112,7 @@ int TPM2_ClockSet_Example(void* userCtx, UINT64* newClock)
     UINT64 oldClock;
 
     xil_printf("TPM2 Demo of setting the TPM clock forward\r\n");
-    rc = wolfTPM2_Init(&dev, TPM2_IoCb, userCtx);
+    rc = wolf_tpm_init(userCtx);
     if (rc != TPM_RC_SUCCESS) {
         xil_printf("wolfTPM2_Init failed 0x%x: %s\r\n", rc, TPM2_GetRCString(rc));
         goto exit;
@@ -183,7 +184,7 @@ exit:
         xil_printf("Failure 0x%x: %s\r\n", rc, wolfTPM2_GetRCString(rc));
     }
 
-    wolfTPM2_Cleanup(&dev);
+    wolf_tpm_cleanup();
 
     return rc;
 }
@@ -27,6 +27,7 @@
 
 #include "tpm_io.h"
 #include "tpm_test.h"
+#include "wolf_port.h"
 #include "tpm_timestamp.h"
 
 #include <stdio.h>
@@ -73,7 +74,7 @@ int TPM2_Timestamp_Test(void* userCtx)
     XMEMSET(&rsaKey, 0, sizeof(rsaKey));
 
     xil_printf("TPM2 Demo of generating signed timestamp from the TPM\r\n");
-    rc = wolfTPM2_Init(&dev, TPM2_IoCb, userCtx);
+    rc = wolf_tpm_init(userCtx);
     if (rc != TPM_RC_SUCCESS) {
         xil_printf("wolfTPM2_Init failed 0x%x: %s\r\n", rc, TPM2_GetRCString(rc));
         goto exit;
@@ -284,7 +285,7 @@ exit:
     wolfTPM2_UnloadHandle(&dev, &rsaKey.handle);
     wolfTPM2_UnloadHandle(&dev, &endorse.handle);
 
-    wolfTPM2_Cleanup(&dev);
+    wolf_tpm_cleanup();
     return rc;
 }
 
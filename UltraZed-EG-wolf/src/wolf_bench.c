@@ -0,0 +1,510 @@
+/* wolf_bench.c
+ *
+ * Copyright (C) 2006-2020 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "xil_printf.h"
+
+#include "wolfssl/wolfcrypt/settings.h"
+#include "wolfssl/version.h"
+#include "wolfssl/wolfcrypt/error-crypt.h"
+#include "wolfssl/wolfcrypt/wc_port.h"
+#include "wolfssl/wolfcrypt/random.h"
+#include "wolfssl/wolfcrypt/aes.h"
+#include "wolfssl/wolfcrypt/sha256.h"
+#include "wolfssl/wolfcrypt/ecc.h"
+#include "wolfssl/wolfcrypt/rsa.h"
+#include "wolfssl/certs_test.h"
+
+#include "lwip/sys.h"
+#include "lwipopts.h"
+
+#include "networking.h"
+#include "wolf_bench.h"
+
+#ifndef NO_CRYPT_BENCHMARK
+
+#ifndef WOLF_BENCH_MT_STACK_SIZE
+    #define WOLF_BENCH_MT_STACK_SIZE (32*1024)
+#endif
+#define BENCH_MT_BLOCK_SZ 1024 /* bytes per symmetric operation */
+#define BENCH_MT_MAX_TASKS 16
+
+extern double current_time(int reset);
+
+enum {
+    BENCH_MT_AES_GCM = 0,
+    BENCH_MT_SHA256,
+    BENCH_MT_ECDSA_SIGN,
+    BENCH_MT_ECDSA_VERIFY,
+    BENCH_MT_RSA_PRIV,
+};
+
+typedef struct BenchMtAlgo {
+    const char* name;
+    int         id;
+    int         bytes;  /* bytes per operation (0 for asymmetric) */
+} BenchMtAlgo;
+
+static const BenchMtAlgo gBenchMtAlgos[] = {
+#ifdef HAVE_AESGCM
+    { "AES-256-GCM-enc",   BENCH_MT_AES_GCM,      BENCH_MT_BLOCK_SZ },
+#endif
+#ifndef NO_SHA256
+    { "SHA-256",           BENCH_MT_SHA256,       BENCH_MT_BLOCK_SZ },
+#endif
+#ifdef HAVE_ECC
+    { "ECDSA-P256-sign",   BENCH_MT_ECDSA_SIGN,   0 },
+    { "ECDSA-P256-verify", BENCH_MT_ECDSA_VERIFY, 0 },
+#endif
+#ifndef NO_RSA
+    { "RSA-2048-private",  BENCH_MT_RSA_PRIV,     0 },
+#endif
+};
+#define BENCH_MT_ALGO_COUNT (int)(sizeof(gBenchMtAlgos)/sizeof(gBenchMtAlgos[0]))
+
+struct BenchMt;
+
+/* All keys and objects are set up by the menu task before the workers start,
+ * so the workers only run the timed loop */
+typedef struct BenchMtWorker {
+    struct BenchMt* bench;
+    int       id;
+    int       ret;
+    word32    ops;
+    double    secs;
+    WC_RNG    rng;
+#ifdef HAVE_AESGCM
+    Aes       aes;
+    byte      iv[GCM_NONCE_MID_SZ];
+    byte      tag[AES_BLOCK_SIZE];
+#endif
+#ifndef NO_SHA256
+    wc_Sha256 sha;
+#endif
+#ifdef HAVE_ECC
+    ecc_key   ecc;
+    byte      sig[ECC_MAX_SIG_SIZE];
+    word32    sigSz;
+#endif
+#ifndef NO_RSA
+    RsaKey    rsa;
+#endif
+    byte      in[BENCH_MT_BLOCK_SZ];
+    byte      out[BENCH_MT_BLOCK_SZ];
+} BenchMtWorker;
+
+typedef struct BenchMt {
+    volatile int   go;      /* start barrier */
+    volatile int   done;    /* finished workers, protected by lock */
+    int            algo;
+    int            format;
+    wolfSSL_Mutex  lock;
+    BenchMtWorker* workers[BENCH_MT_MAX_TASKS];
+#ifdef WOLF_BENCH_MT_TCP_PORT
+    SockIoCbCtx    sock;
+#endif
+    char           line[256];
+} BenchMt;
+
+/* Prints a report line to the UART and the TCP report client */
+static void bench_mt_print(BenchMt* bench, const char* fmt, ...)
+{
+    va_list args;
+    int len;
+
+    va_start(args, fmt);
+    len = vsnprintf(bench->line, sizeof(bench->line), fmt, args);
+    va_end(args);
+    if (len < 0)
+        return;
+    if (len >= (int)sizeof(bench->line))
+        len = (int)sizeof(bench->line) - 1;
+
+    xil_printf("%s", bench->line);
+#ifdef WOLF_BENCH_MT_TCP_PORT
+    if (bench->sock.fd != -1)
+        send(bench->sock.fd, bench->line, len, 0);
+#endif
+}
+
+static int bench_mt_op(BenchMtWorker* w, int algo)
+{
+    int ret = NOT_COMPILED_IN;
+    word32 outSz = sizeof(w->out);
+#ifdef HAVE_ECC
+    int verified = 0;
+#endif
+
+    switch (algo) {
+#ifdef HAVE_AESGCM
+    case BENCH_MT_AES_GCM:
+        ret = wc_AesGcmEncrypt(&w->aes, w->out, w->in, BENCH_MT_BLOCK_SZ,
+            w->iv, sizeof(w->iv), w->tag, sizeof(w->tag), NULL, 0);
+        break;
+#endif
+#ifndef NO_SHA256
+    case BENCH_MT_SHA256:
+        ret = wc_Sha256Update(&w->sha, w->in, BENCH_MT_BLOCK_SZ);
+        break;
+#endif
+#ifdef HAVE_ECC
+    case BENCH_MT_ECDSA_SIGN:
+        ret = wc_ecc_sign_hash(w->in, WC_SHA256_DIGEST_SIZE, w->out, &outSz,
+            &w->rng, &w->ecc);
+        break;
+    case BENCH_MT_ECDSA_VERIFY:
+        ret = wc_ecc_verify_hash(w->sig, w->sigSz, w->in,
+            WC_SHA256_DIGEST_SIZE, &verified, &w->ecc);
+        if (ret == 0 && verified != 1)
+            ret = SIG_VERIFY_E;
+        break;
+#endif
+#ifndef NO_RSA
+    case BENCH_MT_RSA_PRIV:
+        ret = wc_RsaSSL_Sign(w->in, WC_SHA256_DIGEST_SIZE, w->out, outSz,
+            &w->rsa, &w->rng);
+        if (ret > 0)
+            ret = 0;
+        break;
+#endif
+    default:
+        break;
+    }
+    (void)outSz;
+
+    return ret;
+}
+
+static void bench_mt_worker(void* p)
+{
+    BenchMtWorker* w = (BenchMtWorker*)p;
+    BenchMt* bench = w->bench;
+    double start, now;
+    word32 ops = 0;
+    int ret;
+
+    while (!bench->go) {
+        vTaskDelay(1);
+    }
+
+    start = current_time(1);
+    do {
+        ret = bench_mt_op(w, bench->algo);
+        ops++;
+        now = current_time(0);
+    } while (ret == 0 && (now - start) < WOLF_BENCH_MT_SECS);
+
+    w->ops = ops;
+    w->secs = now - start;
+    w->ret = ret;
+
+    wc_LockMutex(&bench->lock);
+    bench->done++;
+    wc_UnLockMutex(&bench->lock);
+
+    vTaskDelete(NULL);
+}
+
+static void bench_mt_start_task(BenchMtWorker* w)
+{
+#if defined(configUSE_CORE_AFFINITY) && configUSE_CORE_AFFINITY == 1 && \
+    defined(configNUM_CORES) && configNUM_CORES > 1
+    /* SMP FreeRTOS: pin one worker per core */
+    xTaskCreateAffinitySet(bench_mt_worker, "bmt",
+        WOLF_BENCH_MT_STACK_SIZE / sizeof(StackType_t), w, DEFAULT_THREAD_PRIO,
+        (UBaseType_t)1 << (w->id % configNUM_CORES), NULL);
+#else
+    sys_thread_new("bmt", bench_mt_worker, w,
+        WOLF_BENCH_MT_STACK_SIZE / sizeof(size_t), DEFAULT_THREAD_PRIO);
+#endif
+}
+
+static int bench_mt_worker_init(BenchMtWorker* w)
+{
+    int ret, i;
+    word32 idx;
+#ifdef HAVE_AESGCM
+    static const byte key[AES_256_KEY_SIZE] = {
+        0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef,
+        0xfe, 0xde, 0xba, 0x98, 0x76, 0x54, 0x32, 0x10,
+        0x89, 0xab, 0xcd, 0xef, 0x01, 0x23, 0x45, 0x67,
+        0x76, 0x54, 0x32, 0x10, 0xfe, 0xde, 0xba, 0x98
+    };
+#endif
+
+    for (i = 0; i < BENCH_MT_BLOCK_SZ; i++) {
+        w->in[i] = (byte)i;
+    }
+
+    /* seeding may use the TPM, so done here and not on the workers */
+    ret = wc_InitRng(&w->rng);
+#ifdef HAVE_AESGCM
+    if (ret == 0)
+        ret = wc_AesInit(&w->aes, NULL, INVALID_DEVID);
+    if (ret == 0)
+        ret = wc_AesGcmSetKey(&w->aes, key, sizeof(key));
+    XMEMSET(w->iv, w->id, sizeof(w->iv));
+#endif
+#ifndef NO_SHA256
+    if (ret == 0)
+        ret = wc_InitSha256(&w->sha);
+#endif
+#ifdef HAVE_ECC
+    if (ret == 0)
+        ret = wc_ecc_init(&w->ecc);
+    if (ret == 0) {
+        idx = 0;
+        ret = wc_EccPrivateKeyDecode(ecc_key_der_256, &idx, &w->ecc,
+            sizeof_ecc_key_der_256);
+    }
+    if (ret == 0) {
+        /* signature for the verify test */
+        w->sigSz = sizeof(w->sig);
+        ret = wc_ecc_sign_hash(w->in, WC_SHA256_DIGEST_SIZE, w->sig,
+            &w->sigSz, &w->rng, &w->ecc);
+    }
+#endif
+#ifndef NO_RSA
+    if (ret == 0)
+        ret = wc_InitRsaKey(&w->rsa, NULL);
+    if (ret == 0) {
+        idx = 0;
+        ret = wc_RsaPrivateKeyDecode(client_key_der_2048, &idx, &w->rsa,
+            sizeof_client_key_der_2048);
+    }
+    #ifdef WC_RSA_BLINDING
+    if (ret == 0)
+        ret = wc_RsaSetRNG(&w->rsa, &w->rng);
+    #endif
+#endif
+    (void)idx;
+
+    return ret;
+}
+
+static void bench_mt_worker_free(BenchMtWorker* w)
+{
+#ifdef HAVE_AESGCM
+    wc_AesFree(&w->aes);
+#endif
+#ifndef NO_SHA256
+    wc_Sha256Free(&w->sha);
+#endif
+#ifdef HAVE_ECC
+    wc_ecc_free(&w->ecc);
+#endif
+#ifndef NO_RSA
+    wc_FreeRsaKey(&w->rsa);
+#endif
+    wc_FreeRng(&w->rng);
+}
+
+/* Runs one primitive on numTasks workers. Returns the aggregate ops/sec */
+static int bench_mt_run(BenchMt* bench, int algo, int numTasks,
+    double* opsSec)
+{
+    int i, ret = 0;
+
+    bench->algo = algo;
+    bench->go = 0;
+    bench->done = 0;
+    for (i = 0; i < numTasks; i++) {
+        bench->workers[i]->ops = 0;
+        bench->workers[i]->ret = 0;
+        bench_mt_start_task(bench->workers[i]);
+    }
+    /* let the workers reach the barrier, then release them together */
+    vTaskDelay(pdMS_TO_TICKS(10));
+    bench->go = 1;
+    while (bench->done < numTasks) {
+        vTaskDelay(pdMS_TO_TICKS(50));
+    }
+
+    *opsSec = 0;
+    for (i = 0; i < numTasks; i++) {
+        if (bench->workers[i]->ret != 0)
+            ret = bench->workers[i]->ret;
+        else if (bench->workers[i]->secs > 0)
+            *opsSec += bench->workers[i]->ops / bench->workers[i]->secs;
+    }
+    return ret;
+}
+
+static const char* bench_mt_config(void)
+{
+    return ""
+#ifdef WOLFSSL_SP_ARM64_ASM
+        "sp-arm64 "
+#endif
+#ifdef WOLFSSL_ARMASM
+        "armasm "
+#endif
+#ifdef WOLFSSL_XILINX_CRYPT
+        "xilinx-crypt "
+#endif
+#if defined(configUSE_CORE_AFFINITY) && configUSE_CORE_AFFINITY == 1
+        "smp-affinity "
+#endif
+        "wolfSSL " LIBWOLFSSL_VERSION_STRING;
+}
+
+static void bench_mt_report_header(BenchMt* bench, int numTasks)
+{
+    if (bench->format == WOLF_BENCH_FMT_CSV) {
+        bench_mt_print(bench, "build,config,algorithm,bytes,tasks,"
+            "ops_sec_1,ops_sec_n,speedup,efficiency\r\n");
+    }
+    else if (bench->format == WOLF_BENCH_FMT_JSON) {
+        bench_mt_print(bench, "{\"build\":\"%s %s\",\"config\":\"%s\","
+            "\"tasks\":%d,\"seconds\":%.3f,\"results\":[\r\n",
+            __DATE__, __TIME__, bench_mt_config(), numTasks,
+            (double)WOLF_BENCH_MT_SECS);
+    }
+    else {
+        bench_mt_print(bench, "Multi-core benchmark: %d tasks, %.1f sec each, "
+            "%s\r\n", numTasks, (double)WOLF_BENCH_MT_SECS, bench_mt_config());
+        bench_mt_print(bench, "%-18s %14s %14s %8s %10s\r\n", "Algorithm",
+            "1 task ops/s", "N task ops/s", "Speedup", "Efficiency");
+    }
+}
+
+static void bench_mt_report(BenchMt* bench, const BenchMtAlgo* algo,
+    int numTasks, double single, double multi, int last)
+{
+    int i;
+    double speedup = (single > 0) ? multi / single : 0;
+    double eff = speedup * 100 / numTasks;
+
+    if (bench->format == WOLF_BENCH_FMT_CSV) {
+        bench_mt_print(bench, "%s %s,%s,%s,%d,%d,%.3f,%.3f,%.3f,%.1f\r\n",
+            __DATE__, __TIME__, bench_mt_config(), algo->name, algo->bytes,
+            numTasks, single, multi, speedup, eff);
+    }
+    else if (bench->format == WOLF_BENCH_FMT_JSON) {
+        bench_mt_print(bench, "{\"algorithm\":\"%s\",\"bytes\":%d,"
+            "\"ops_sec_1\":%.3f,\"ops_sec_n\":%.3f,\"speedup\":%.3f,"
+            "\"efficiency\":%.1f,\"per_task\":[", algo->name, algo->bytes,
+            single, multi, speedup, eff);
+        for (i = 0; i < numTasks; i++) {
+            bench_mt_print(bench, "%s%.3f", (i == 0) ? "" : ",",
+                (bench->workers[i]->secs > 0) ?
+                    bench->workers[i]->ops / bench->workers[i]->secs : 0);
+        }
+        bench_mt_print(bench, "]}%s\r\n", last ? "" : ",");
+    }
+    else {
+        bench_mt_print(bench, "%-18s %14.3f %14.3f %8.2f %9.1f%%\r\n",
+            algo->name, single, multi, speedup, eff);
+        if (algo->bytes > 0) {
+            bench_mt_print(bench, "%-18s %11.3f MB/s %9.3f MB/s\r\n", "",
+                single * algo->bytes / (1024 * 1024),
+                multi * algo->bytes / (1024 * 1024));
+        }
+    }
+}
+
+int wolf_bench_mt(int numTasks, int format)
+{
+    int ret = 0, i, created = 0;
+    double single, multi;
+    BenchMt* bench;
+
+    if (numTasks <= 0)
+        numTasks = WOLF_BENCH_MT_TASKS;
+    if (numTasks > BENCH_MT_MAX_TASKS)
+        numTasks = BENCH_MT_MAX_TASKS;
+
+    bench = (BenchMt*)XMALLOC(sizeof(BenchMt), NULL, DYNAMIC_TYPE_TMP_BUFFER);
+    if (bench == NULL)
+        return MEMORY_E;
+    XMEMSET(bench, 0, sizeof(BenchMt));
+    bench->format = format;
+#ifdef WOLF_BENCH_MT_TCP_PORT
+    bench->sock.fd = -1;
+    bench->sock.listenFd = -1;
+#endif
+    if (wc_InitMutex(&bench->lock) != 0) {
+        XFREE(bench, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+        return BAD_MUTEX_E;
+    }
+
+    for (i = 0; i < numTasks && ret == 0; i++) {
+        bench->workers[i] = (BenchMtWorker*)XMALLOC(sizeof(BenchMtWorker),
+            NULL, DYNAMIC_TYPE_TMP_BUFFER);
+        if (bench->workers[i] == NULL) {
+            ret = MEMORY_E;
+            break;
+        }
+        XMEMSET(bench->workers[i], 0, sizeof(BenchMtWorker));
+        bench->workers[i]->bench = bench;
+        bench->workers[i]->id = i;
+        created++;
+        ret = bench_mt_worker_init(bench->workers[i]);
+    }
+
+#ifdef WOLF_BENCH_MT_TCP_PORT
+    if (ret == 0) {
+        xil_printf("Waiting for report client on port %d\r\n",
+            WOLF_BENCH_MT_TCP_PORT);
+        if (SetupSocketAndListen(&bench->sock, WOLF_BENCH_MT_TCP_PORT) != 0 ||
+                SocketWaitClient(&bench->sock) != 0) {
+            CloseAndCleanupSocket(&bench->sock); /* UART only */
+        }
+    }
+#endif
+
+    if (ret == 0) {
+        bench_mt_report_header(bench, numTasks);
+        for (i = 0; i < BENCH_MT_ALGO_COUNT && ret == 0; i++) {
+            ret = bench_mt_run(bench, gBenchMtAlgos[i].id, 1, &single);
+            if (ret == 0)
+                ret = bench_mt_run(bench, gBenchMtAlgos[i].id, numTasks,
+                    &multi);
+            if (ret == 0) {
+                bench_mt_report(bench, &gBenchMtAlgos[i], numTasks, single,
+                    multi, i == BENCH_MT_ALGO_COUNT - 1);
+            }
+            else {
+                xil_printf("Benchmark %s failed %d\r\n", gBenchMtAlgos[i].name,
+                    ret);
+            }
+        }
+        if (format == WOLF_BENCH_FMT_JSON)
+            bench_mt_print(bench, "]}\r\n");
+    }
+
+#ifdef WOLF_BENCH_MT_TCP_PORT
+    CloseAndCleanupSocket(&bench->sock);
+#endif
+    for (i = 0; i < created; i++) {
+        bench_mt_worker_free(bench->workers[i]);
+        XFREE(bench->workers[i], NULL, DYNAMIC_TYPE_TMP_BUFFER);
+    }
+    wc_FreeMutex(&bench->lock);
+    XFREE(bench, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+
+    return ret;
+}
+
+#endif /* !NO_CRYPT_BENCHMARK */
@@ -0,0 +1,62 @@
+/* wolf_bench.h
+ *
+ * Copyright (C) 2006-2020 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#ifndef _WOLF_BENCH_H_
+#define _WOLF_BENCH_H_
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+/* Multi-core wolfCrypt benchmark
+ *
+ * Runs each primitive on one task, then on numTasks concurrent tasks (pinned
+ * one per core with SMP FreeRTOS) and reports the aggregate ops/sec and
+ * scaling efficiency. The report can be printed as text, CSV or JSON for
+ * comparing builds. Define WOLF_BENCH_MT_TCP_PORT to also send the report to
+ * a TCP client (for example `nc <board> <port> > build.json`).
+ */
+
+#ifndef WOLF_BENCH_MT_TASKS
+    #ifdef configNUM_CORES
+        #define WOLF_BENCH_MT_TASKS configNUM_CORES
+    #else
+        #define WOLF_BENCH_MT_TASKS 4 /* Cortex-A53 cores */
+    #endif
+#endif
+#ifndef WOLF_BENCH_MT_SECS
+    #define WOLF_BENCH_MT_SECS 1.0 /* run time per primitive and task count */
+#endif
+
+enum {
+    WOLF_BENCH_FMT_TEXT = 0,
+    WOLF_BENCH_FMT_CSV,
+    WOLF_BENCH_FMT_JSON,
+};
+
+/* numTasks <= 0 uses WOLF_BENCH_MT_TASKS */
+int wolf_bench_mt(int numTasks, int format);
+
+#ifdef __cplusplus
+    }  /* extern "C" */
+#endif
+
+#endif /* _WOLF_BENCH_H_ */
@@ -22,6 +22,7 @@
 #include <stdio.h>
 #include "FreeRTOS.h"
 #include "task.h"
+#include "semphr.h"
 
 #include "xparameters.h"
 #include "xrtcpsu.h"
@@ -33,18 +34,27 @@
 #include "wolfssl/wolfcrypt/settings.h"
 #include "wolfssl/ssl.h"
 #include "wolfssl/wolfcrypt/error-crypt.h"
+#include "wolfssl/wolfcrypt/sha256.h"
 #include "wolfcrypt/test/test.h"
 #include "wolfcrypt/benchmark/benchmark.h"
 
 #include "wolftpm/tpm2_wrap.h"
+#include "wolftpm/tpm2_async.h"
+#include "wolftpm/tpm2_tis.h"
+
+#include "lwip/sys.h"
+#include "lwipopts.h"
 
 #include "tpm_io.h"
+#include "tpm_test.h"
 #include "tpm_csr.h"
 #include "tpm_timestamp.h"
 #include "tpm_timeset.h"
 #include "tls_client.h"
 #include "tls_server.h"
 #include "cert_verify.h"
+#include "wolf_bench.h"
+#include "wolf_port.h"
 int echo_application(void);
 int network_ready; /* global variable in networking.c */
 
@@ -52,6 +62,15 @@ int network_ready; /* global variable in networking.c */
 
 
 WOLFTPM2_DEV dev;
+#ifdef WOLFTPM_STATS
+TPM2_STATS tpmStats; /* TPM command statistics since boot or last dump */
+static TPM2_STATS tpmStatsDump;
+static char tpmStatsJson[8192];
+#endif
+#ifdef WOLFTPM_ASYNC_QUEUE
+static TPM2_ASYNC_QUEUE tpmAsyncQueue;
+static SemaphoreHandle_t tpmAsyncSem; /* given on submit and stop */
+#endif
 
 typedef struct func_args {
 	int argc;
@@ -62,20 +81,286 @@ typedef struct func_args {
 static const char menu1[] = "\r\n"
 		"\tt. wolfCrypt Test\r\n"
 		"\tb. wolfCrypt Benchmark\r\n"
+		"\tk. wolfCrypt Benchmark (multi-core)\r\n"
 		"\ts. wolfSSL TLS Server\r\n"
+		"\tm. wolfSSL TLS Server (multi-connection pool)\r\n"
 		"\tc. wolfSSL TLS Client\r\n"
+		"\tn. wolfSSL TLS Client Throughput (socket vs netconn I/O)\r\n"
 		"\te. Xilinx TCP Echo Server\r\n"
 		"\tr. TPM Generate Certificate Signing Request (CSR)\r\n"
 		"\tg. TPM Get/Set Time\r\n"
 		"\tp. TPM Signed Timestamp\r\n"
 		"\tv. Certification Chain Validate Test\r\n"
-		"\tl. TPM Clear (reset TPM)\r\n";
+		"\tl. TPM Clear (reset TPM)\r\n"
+		"\ti. TPM SPI Transport Benchmark (polled vs interrupt)\r\n"
+#ifdef WOLF_RNG_POOL
+		"\tx. RNG Seed Pool Test / Statistics\r\n"
+#endif
+#ifdef WOLFTPM_ASYNC_QUEUE
+		"\ta. TPM Async Queue Test / Statistics\r\n"
+#endif
+#ifdef WOLFTPM_STATS
+		"\ty. TPM Command Statistics (JSON)\r\n"
+#endif
+		;
 
 static char get_stdin_char(void)
 {
 	 return XUartPs_RecvByte(STDIN_BASEADDRESS);
 }
 
+#define TPM_SPI_BENCH_CMDS 20
+
+/* Compares CPU time per TPM command for polled and interrupt SPI transfers */
+static int tpm_spi_bench(void)
+{
+	int rc = 0, i, m, c, hz;
+	TpmSpiStats stats;
+	byte rng[MAX_RNG_REQ_SIZE];
+	double start, elapsed;
+	static const word32 clocks[] = { 12500000, TPM2_SPI_MAX_HZ };
+	static const char* modes[] = { "polled", "interrupt" };
+#ifdef WOLFTPM_TIS_STATS
+	static TPM2_TIS_STATS tisStats;
+	TPM2_TIS_CC_STATS* ccStats;
+#endif
+
+	for (c = 0; c < (int)(sizeof(clocks)/sizeof(clocks[0])) && rc == 0; c++) {
+		hz = TPM2_IoCb_SetSpiClock(clocks[c]);
+		for (m = TPM2_SPI_MODE_POLLED; m <= TPM2_SPI_MODE_INTERRUPT; m++) {
+			if (hz < 0 || TPM2_IoCb_SetSpiMode(m) != 0) {
+				xil_printf("SPI %s mode not available\r\n", modes[m]);
+				continue;
+			}
+			TPM2_IoCb_GetSpiStats(NULL, 1);
+		#ifdef WOLFTPM_TIS_STATS
+			TPM2_TIS_SetStats(&dev.ctx, &tisStats);
+		#endif
+			start = gettime_secs(1);
+			for (i = 0; i < TPM_SPI_BENCH_CMDS && rc == 0; i++) {
+				rc = wolfTPM2_GetRandom(&dev, rng, sizeof(rng));
+			}
+			elapsed = gettime_secs(0) - start;
+			TPM2_IoCb_GetSpiStats(&stats, 0);
+			if (rc != 0 || stats.tickHz == 0)
+				break;
+			xil_printf("SPI %d kHz %-9s: %9.3f ms/cmd, CPU busy %9.3f ms/cmd, "
+				"%d xfers/cmd (%d intr)\r\n", hz / 1000, modes[m],
+				elapsed * 1000 / TPM_SPI_BENCH_CMDS,
+				(double)stats.busyTicks * 1000 / stats.tickHz / TPM_SPI_BENCH_CMDS,
+				stats.xfers / TPM_SPI_BENCH_CMDS,
+				stats.intrXfers / TPM_SPI_BENCH_CMDS);
+		#ifdef WOLFTPM_TIS_STATS
+			ccStats = TPM2_TIS_GetCcStats(&tisStats, TPM_CC_GetRandom);
+			if (ccStats->cmds > 0) {
+				xil_printf("  TIS GetRandom: %d xfers/cmd, %d bytes/cmd\r\n",
+					ccStats->xfers / ccStats->cmds,
+					ccStats->bytes / ccStats->cmds);
+			}
+		#endif
+		}
+	}
+#ifdef WOLFTPM_TIS_STATS
+	TPM2_TIS_SetStats(&dev.ctx, NULL);
+#endif
+
+	/* restore defaults */
+	TPM2_IoCb_SetSpiClock(TPM2_SPI_HZ);
+#ifdef TPM2_SPI_USE_INTERRUPT
+	TPM2_IoCb_SetSpiMode(TPM2_SPI_MODE_INTERRUPT);
+#else
+	TPM2_IoCb_SetSpiMode(TPM2_SPI_MODE_POLLED);
+#endif
+	return rc;
+}
+
+#ifdef WOLFTPM_ASYNC_QUEUE
+#define TPM_ASYNC_IDLE_MS 10
+#define TPM_ASYNC_TEST_REQS 4
+#define TPM_ASYNC_TEST_LOOPS 25
+
+/* XTPM_ASYNC_IDLE: block the service task until a request is submitted */
+void wolf_tpm_async_idle(void)
+{
+	if (tpmAsyncSem != NULL)
+		(void)xSemaphoreTake(tpmAsyncSem, pdMS_TO_TICKS(TPM_ASYNC_IDLE_MS));
+	else
+		vTaskDelay(1);
+}
+
+/* XTPM_ASYNC_WAKE */
+void wolf_tpm_async_wake(void)
+{
+	if (tpmAsyncSem != NULL)
+		(void)xSemaphoreGive(tpmAsyncSem);
+}
+
+/* XTPM_ASYNC_YIELD: request wait and stop join */
+void wolf_tpm_async_yield(void)
+{
+	vTaskDelay(1);
+}
+
+/* TPM2_Async_ServiceTask returns after TPM2_Async_Stop, a task must not */
+static void tpm_async_task(void* arg)
+{
+	TPM2_Async_ServiceTask(arg);
+	vTaskDelete(NULL);
+}
+
+/* TPM2_Async_Start task create callback */
+static int tpm_async_create(TPM2_CTX* ctx, void* userCtx)
+{
+	(void)userCtx;
+	if (xTaskCreate(tpm_async_task, "tpm", THREAD_STACKSIZE/sizeof(StackType_t),
+			ctx, DEFAULT_THREAD_PRIO, NULL) != pdPASS) {
+		return MEMORY_E;
+	}
+	return 0;
+}
+
+/* Overlaps TPM GetRandom requests with software SHA-256 work on this task */
+static int tpm_async_test(void)
+{
+	int rc = 0, i, loop;
+	TPM2_ASYNC_REQ req[TPM_ASYNC_TEST_REQS];
+	GetRandom_In in[TPM_ASYNC_TEST_REQS];
+	GetRandom_Out out[TPM_ASYNC_TEST_REQS];
+	TPM2_ASYNC_STATS stats;
+	byte work[sizeof(out[0].randomBytes.buffer)];
+	wc_Sha256 sha;
+	byte digest[WC_SHA256_DIGEST_SIZE];
+	double start = gettime_secs(1);
+
+	XMEMSET(work, 0, sizeof(work));
+	wc_InitSha256(&sha);
+	for (loop = 0; loop < TPM_ASYNC_TEST_LOOPS && rc == 0; loop++) {
+		for (i = 0; i < TPM_ASYNC_TEST_REQS && rc == 0; i++) {
+			in[i].bytesRequested = sizeof(out[i].randomBytes.buffer);
+			rc = TPM2_Async_GetRandom(&dev.ctx, &req[i], &in[i], &out[i], NULL);
+		}
+		/* software work while the TPM is busy, out is owned by the service
+		 * task until each wait returns */
+		for (i = 0; i < 64; i++) {
+			wc_Sha256Update(&sha, work, sizeof(work));
+		}
+		for (i = 0; i < TPM_ASYNC_TEST_REQS && rc == 0; i++) {
+			rc = TPM2_Async_Wait(&dev.ctx, &req[i]);
+		}
+		if (rc == 0) {
+			XMEMCPY(work, out[0].randomBytes.buffer, sizeof(work));
+		}
+	}
+	wc_Sha256Final(&sha, digest);
+	wc_Sha256Free(&sha);
+	xil_printf("Async test %d requests, %d ms\r\n",
+		loop * TPM_ASYNC_TEST_REQS, (int)((gettime_secs(0) - start) * 1000));
+
+	if (TPM2_Async_GetStats(&dev.ctx, &stats) == 0) {
+		xil_printf("Queue: submitted %d, completed %d, rejected %d, "
+			"depth %d, max depth %d\r\n", stats.submitted, stats.completed,
+			stats.rejected, stats.depth, stats.maxDepth);
+		for (i = 0; i < WOLFTPM_ASYNC_STATS_CMDS; i++) {
+			if (stats.cmd[i].count == 0)
+				break;
+			xil_printf("  CC 0x%x: count %d, avg wait %d us, avg exec %d us, "
+				"max exec %d us\r\n", stats.cmd[i].cmdCode, stats.cmd[i].count,
+				stats.cmd[i].waitUs / stats.cmd[i].count,
+				stats.cmd[i].execUs / stats.cmd[i].count,
+				stats.cmd[i].maxExecUs);
+		}
+	}
+	return rc;
+}
+#endif /* WOLFTPM_ASYNC_QUEUE */
+
+#ifdef WOLF_RNG_POOL
+#define RNG_POOL_TEST_INITS 20
+
+/* Seeds DRBG instances (each takes a full seed) and prints the pool stats */
+static int rng_pool_test(void)
+{
+	int rc = 0, i;
+	WC_RNG rng;
+	WolfRngPoolStats stats;
+	double start;
+
+	wolf_rng_pool_stats(&stats, 1);
+	start = gettime_secs(1);
+	for (i = 0; i < RNG_POOL_TEST_INITS && rc == 0; i++) {
+		rc = wc_InitRng(&rng);
+		if (rc == 0)
+			wc_FreeRng(&rng);
+	}
+	xil_printf("%d DRBG seeds: %d ms\r\n", i,
+		(int)((gettime_secs(0) - start) * 1000));
+
+	wolf_rng_pool_stats(&stats, 0);
+	xil_printf("Pool: level %d/%d slots, refills %d, requests %d, "
+		"underflows %d\r\n", stats.level, WOLF_RNG_POOL_SLOTS, stats.refills,
+		stats.requests, stats.underflows);
+	xil_printf("Bytes: pool %d, direct TPM %d\r\n", stats.poolBytes,
+		stats.directBytes);
+	xil_printf("Seed latency: p50 %d us, p90 %d us, p99 %d us, max %d us\r\n",
+		stats.p50Us, stats.p90Us, stats.p99Us, stats.maxUs);
+	return rc;
+}
+#endif /* WOLF_RNG_POOL */
+
+/* Stops the tasks that run commands on the shared TPM device. Init clears
+ * the context (and its lock) under them */
+static void wolf_tpm_stop_tasks(void)
+{
+#ifdef WOLF_RNG_POOL
+	wolf_rng_pool_stop();
+#endif
+#ifdef WOLFTPM_ASYNC_QUEUE
+	if (dev.ctx.asyncQueue != NULL) {
+		TPM2_Async_Cleanup(&dev.ctx); /* joins the service task */
+	}
+#endif
+}
+
+/* Initializes the shared TPM device, or again for an example. The statistics
+ * and async queue are attached to the new context and the RNG pool refill
+ * task is restarted */
+int wolf_tpm_init(void* userCtx)
+{
+	int rc;
+
+	wolf_tpm_stop_tasks();
+	rc = wolfTPM2_Init(&dev, TPM2_IoCb, userCtx);
+#ifdef WOLFTPM_STATS
+	if (rc == 0) {
+		rc = TPM2_SetStats(&dev.ctx, &tpmStats);
+	}
+#endif
+#ifdef WOLFTPM_ASYNC_QUEUE
+	if (rc == 0) {
+		if (tpmAsyncSem == NULL)
+			tpmAsyncSem = xSemaphoreCreateBinary();
+		rc = TPM2_Async_Init(&dev.ctx, &tpmAsyncQueue);
+	}
+	if (rc == 0 && TPM2_Async_Start(&dev.ctx, tpm_async_create, NULL) != 0) {
+		/* queued requests run on the task that waits for them */
+		xil_printf("TPM async service task start failed\r\n");
+	}
+#endif
+#ifdef WOLF_RNG_POOL
+	if (rc == 0 && wolf_rng_pool_start() != 0) {
+		xil_printf("RNG pool start failed, seeding directly from TPM\r\n");
+	}
+#endif
+	return rc;
+}
+
+/* Stops the tasks using the shared TPM device and cleans it up */
+int wolf_tpm_cleanup(void)
+{
+	wolf_tpm_stop_tasks();
+	return wolfTPM2_Cleanup(&dev);
+}
+
 void wolfmenu_thread(void* p)
 {
 	int rc;
@@ -106,7 +391,7 @@ void wolfmenu_thread(void* p)
 	xil_printf("Demonstrating wolfSSL software implementation\r\n");
 #endif
 
-    rc = wolfTPM2_Init(&dev, TPM2_IoCb, NULL);
+    rc = wolf_tpm_init(NULL);
 	if (rc != 0) {
 		xil_printf("TPM Startup Error %d\r\n", rc);
 	}
@@ -154,12 +439,28 @@ void wolfmenu_thread(void* p)
         #endif
 			break;
 
+		case 'k':
+        #ifndef NO_CRYPT_BENCHMARK
+			xil_printf("Output format (t=text, c=csv, j=json):\r\n");
+			cmd = get_stdin_char();
+			rc = wolf_bench_mt(WOLF_BENCH_MT_TASKS,
+				(cmd == 'c') ? WOLF_BENCH_FMT_CSV :
+				(cmd == 'j') ? WOLF_BENCH_FMT_JSON : WOLF_BENCH_FMT_TEXT);
+        #endif
+			break;
+
 		case 's':
 			rc = TPM2_TLS_Server(NULL);
 			break;
+		case 'm':
+			rc = TPM2_TLS_ServerPool(NULL);
+			break;
 		case 'c':
 			rc = TPM2_TLS_Client(NULL);
 			break;
+		case 'n':
+			rc = TLS_Client_Throughput();
+			break;
 		case 'e':
 			rc = echo_application();
 			break;
@@ -185,16 +486,57 @@ void wolfmenu_thread(void* p)
 		case 'l':
 			rc = wolfTPM2_Clear(&dev);
 			break;
+		case 'i':
+			rc = tpm_spi_bench();
+			break;
+	#ifdef WOLFTPM_ASYNC_QUEUE
+		case 'a':
+			rc = tpm_async_test();
+			break;
+	#endif
+	#ifdef WOLF_RNG_POOL
+		case 'x':
+			rc = rng_pool_test();
+			break;
+	#endif
+	#ifdef WOLFTPM_STATS
+		case 'y':
+			/* dump and reset, latency histogram buckets are log2 us */
+			rc = wolfTPM2_GetStats(&dev, &tpmStatsDump);
+			if (rc == 0) {
+				rc = wolfTPM2_StatsToJson(&tpmStatsDump, tpmStatsJson,
+					sizeof(tpmStatsJson));
+			}
+			if (rc > 0) {
+				xil_printf("%s\r\n", tpmStatsJson);
+				rc = wolfTPM2_StatsInit(&dev, &tpmStats);
+			}
+			break;
+	#endif
 		default:
 			xil_printf("\n\rSelection out of range\r\n");
 			break;
 		}
 
 		xil_printf("Return code %d\r\n", rc);
+
+		/* examples clean up the shared TPM device when done */
+		if (TPM2_GetActiveCtx() != &dev.ctx) {
+			rc = wolf_tpm_init(NULL);
+			if (rc != 0) {
+				xil_printf("TPM Startup Error %d\r\n", rc);
+			}
+		}
 	}
 
+	wolf_tpm_cleanup();
+#ifdef WOLFTPM_ASYNC_QUEUE
+	if (tpmAsyncSem != NULL) {
+		vSemaphoreDelete(tpmAsyncSem);
+		tpmAsyncSem = NULL;
+	}
+#endif
     wolfSSL_Cleanup();
-	wolfTPM2_Cleanup(&dev);
 
 	vTaskDelete(NULL);
     return;
@@ -37,6 +37,7 @@
 #include "tpm_io.h"
 
 #include "compile_time.h"
+#include "wolf_port.h"
 
 extern WOLFTPM2_DEV dev;
 
@@ -90,14 +91,23 @@ word32 TimeNowInMilliseconds(void)
 }
 #endif
 
-#ifndef NO_CRYPT_BENCHMARK
-/* This is used by wolfCrypt benchmark tool only */
 #ifndef XPAR_CPU_CORTEXA53_0_TIMESTAMP_CLK_FREQ
     #define XPAR_CPU_CORTEXA53_0_TIMESTAMP_CLK_FREQ 50000000
 #endif
 #ifndef COUNTS_PER_SECOND
     #define COUNTS_PER_SECOND     XPAR_CPU_CORTEXA53_0_TIMESTAMP_CLK_FREQ
 #endif
+
+/* Microsecond counter (wraps), used for TPM latency statistics */
+unsigned int my_time_us(void)
+{
+    uint64_t cntPct = 0;
+    asm volatile("mrs %0, CNTPCT_EL0" : "=r" (cntPct));
+    return (unsigned int)(cntPct / (COUNTS_PER_SECOND / 1000000));
+}
+
+#ifndef NO_CRYPT_BENCHMARK
+/* This is used by wolfCrypt benchmark tool only */
 double current_time(int reset)
 {
     double timer;
@@ -113,7 +123,233 @@ double current_time(int reset)
 #endif
 
 /* RNG Seed Function */
+#ifdef WOLF_RNG_POOL
+#define RNG_POOL_MASK      (WOLF_RNG_POOL_SLOTS - 1)
+#define RNG_POOL_SLOT_DATA (WOLF_RNG_POOL_LINE_SZ - sizeof(word32))
+
+/* One slot per cache line. seq is the ring position the slot is ready for:
+ * pos when free for the producer and pos + 1 when filled (bounded MPMC
+ * ring, with a single producer) */
+typedef struct RngPoolSlot {
+    volatile word32 seq;
+    byte            data[RNG_POOL_SLOT_DATA];
+} __attribute__((aligned(WOLF_RNG_POOL_LINE_SZ))) RngPoolSlot;
+
+typedef struct RngPool {
+    RngPoolSlot slot[WOLF_RNG_POOL_SLOTS];
+    /* consumer and producer positions on their own cache lines */
+    volatile word32 tail __attribute__((aligned(WOLF_RNG_POOL_LINE_SZ)));
+    volatile word32 head __attribute__((aligned(WOLF_RNG_POOL_LINE_SZ)));
+    volatile int    running;
+    WolfRngPoolStats stats;
+    volatile word32 latIdx;
+    word32          lat[WOLF_RNG_LAT_SAMPLES];
+} RngPool;
+
+static RngPool gRngPool;
+
+static void rng_pool_zero(byte* p, word32 sz)
+{
+    volatile byte* z = (volatile byte*)p;
+    while (sz--)
+        *z++ = 0;
+}
+
+static void rng_pool_task(void* arg)
+{
+    RngPoolSlot* slot;
+    word32 head = gRngPool.head;
+
+    (void)arg;
+
+    while (gRngPool.running) {
+        slot = &gRngPool.slot[head & RNG_POOL_MASK];
+        if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != head ||
+                wolfTPM2_GetRandom(&dev, slot->data, RNG_POOL_SLOT_DATA) != 0) {
+            /* ring full (or TPM busy / error) */
+            vTaskDelay(pdMS_TO_TICKS(WOLF_RNG_POOL_IDLE_MS));
+            continue;
+        }
+        __atomic_store_n(&slot->seq, head + 1, __ATOMIC_RELEASE);
+        head++;
+        __atomic_store_n(&gRngPool.head, head, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&gRngPool.stats.refills, 1, __ATOMIC_RELAXED);
+    }
+    gRngPool.running = -1; /* stopped */
+    vTaskDelete(NULL);
+}
+
+/* Takes whole slots from the ring, returns the bytes copied */
+static word32 rng_pool_take(byte* output, word32 sz)
+{
+    RngPoolSlot* slot;
+    word32 pos, seq, n, got = 0;
+
+    while (got < sz) {
+        pos = __atomic_load_n(&gRngPool.tail, __ATOMIC_RELAXED);
+        slot = &gRngPool.slot[pos & RNG_POOL_MASK];
+        seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        if ((int)(seq - (pos + 1)) < 0)
+            break; /* empty */
+        if (seq != pos + 1 || !__atomic_compare_exchange_n(&gRngPool.tail,
+                &pos, pos + 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            continue; /* taken by another task, retry */
+        }
+
+        n = sz - got;
+        if (n > RNG_POOL_SLOT_DATA)
+            n = RNG_POOL_SLOT_DATA;
+        XMEMCPY(output + got, slot->data, n);
+        rng_pool_zero(slot->data, RNG_POOL_SLOT_DATA);
+        got += n;
+
+        /* hand the slot back to the producer for the next lap */
+        __atomic_store_n(&slot->seq, pos + WOLF_RNG_POOL_SLOTS,
+            __ATOMIC_RELEASE);
+    }
+    return got;
+}
+
+int wolf_rng_pool_start(void)
+{
+    word32 i;
+
+    if (gRngPool.running > 0)
+        return 0;
+
+    XMEMSET(&gRngPool, 0, sizeof(gRngPool));
+    for (i = 0; i < WOLF_RNG_POOL_SLOTS; i++) {
+        gRngPool.slot[i].seq = i;
+    }
+    gRngPool.running = 1;
+    if (xTaskCreate(rng_pool_task, "rngpool", (4*1024)/sizeof(StackType_t),
+            NULL, tskIDLE_PRIORITY + 1, NULL) != pdPASS) {
+        gRngPool.running = 0;
+        return MEMORY_E;
+    }
+    return 0;
+}
+
+void wolf_rng_pool_stop(void)
+{
+    if (gRngPool.running > 0) {
+        gRngPool.running = 0;
+        while (gRngPool.running == 0) {
+            vTaskDelay(pdMS_TO_TICKS(WOLF_RNG_POOL_IDLE_MS));
+        }
+    }
+}
+
+void wolf_rng_pool_stats(WolfRngPoolStats* stats, int reset)
+{
+    word32 lat[WOLF_RNG_LAT_SAMPLES];
+    word32 i, j, n, v;
+
+    XMEMCPY(stats, &gRngPool.stats, sizeof(*stats));
+    stats->level = gRngPool.head - gRngPool.tail;
+    if (stats->level > WOLF_RNG_POOL_SLOTS)
+        stats->level = 0; /* not started */
+
+    /* sort the recent samples for the percentiles */
+    n = gRngPool.latIdx;
+    if (n > WOLF_RNG_LAT_SAMPLES)
+        n = WOLF_RNG_LAT_SAMPLES;
+    XMEMCPY(lat, gRngPool.lat, n * sizeof(word32));
+    for (i = 1; i < n; i++) {
+        v = lat[i];
+        for (j = i; j > 0 && lat[j-1] > v; j--)
+            lat[j] = lat[j-1];
+        lat[j] = v;
+    }
+    if (n > 0) {
+        stats->p50Us = lat[(n * 50) / 100];
+        stats->p90Us = lat[(n * 90) / 100];
+        stats->p99Us = lat[(n * 99) / 100];
+        stats->maxUs = lat[n - 1];
+    }
+
+    if (reset) {
+        XMEMSET(&gRngPool.stats, 0, sizeof(gRngPool.stats));
+        gRngPool.latIdx = 0;
+    }
+}
+#endif /* WOLF_RNG_POOL */
+
 int my_rng_seed_gen(byte* output, word32 sz)
 {
+#ifdef WOLF_RNG_POOL
+    int rc = 0;
+    word32 got = 0, start = my_time_us();
+
+    if (gRngPool.running > 0)
+        got = rng_pool_take(output, sz);
+    if (got < sz) {
+        /* pool not started or empty, read the rest from the TPM now */
+        rc = wolfTPM2_GetRandom(&dev, output + got, sz - got);
+        if (gRngPool.running > 0)
+            __atomic_fetch_add(&gRngPool.stats.underflows, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&gRngPool.stats.directBytes, sz - got,
+            __ATOMIC_RELAXED);
+    }
+    __atomic_fetch_add(&gRngPool.stats.requests, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&gRngPool.stats.poolBytes, got, __ATOMIC_RELAXED);
+    gRngPool.lat[__atomic_fetch_add(&gRngPool.latIdx, 1, __ATOMIC_RELAXED) %
+        WOLF_RNG_LAT_SAMPLES] = my_time_us() - start;
+
+    return rc;
+#else
     return wolfTPM2_GetRandom(&dev, output, sz);
+#endif
+}
+
+/* Per task DRBG table. Entries are claimed with a compare and swap on the
+ * owner, so lookups don't lock */
+typedef struct RngTaskEntry {
+    TaskHandle_t volatile owner;
+    int                   init;
+    WC_RNG                rng;
+} RngTaskEntry;
+
+static RngTaskEntry gRngTask[WOLF_RNG_TASK_MAX];
+
+WC_RNG* wolf_rng_task(void)
+{
+    int i;
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    TaskHandle_t none;
+
+    for (i = 0; i < WOLF_RNG_TASK_MAX; i++) {
+        if (gRngTask[i].owner == self)
+            return &gRngTask[i].rng;
+    }
+    for (i = 0; i < WOLF_RNG_TASK_MAX; i++) {
+        none = NULL;
+        if (__atomic_compare_exchange_n(&gRngTask[i].owner, &none, self, 0,
+                __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            if (wc_InitRng(&gRngTask[i].rng) != 0) {
+                __atomic_store_n(&gRngTask[i].owner, NULL, __ATOMIC_RELEASE);
+                return NULL;
+            }
+            gRngTask[i].init = 1;
+            return &gRngTask[i].rng;
+        }
+    }
+    return NULL; /* table full */
+}
+
+void wolf_rng_task_free(void)
+{
+    int i;
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+
+    for (i = 0; i < WOLF_RNG_TASK_MAX; i++) {
+        if (gRngTask[i].owner == self) {
+            if (gRngTask[i].init) {
+                wc_FreeRng(&gRngTask[i].rng);
+                gRngTask[i].init = 0;
+            }
+            __atomic_store_n(&gRngTask[i].owner, NULL, __ATOMIC_RELEASE);
+            break;
+        }
+    }
 }
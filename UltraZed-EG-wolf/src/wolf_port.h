@@ -0,0 +1,90 @@
+/* wolf_port.h
+ *
+ * Copyright (C) 2006-2020 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#ifndef _WOLF_PORT_H_
+#define _WOLF_PORT_H_
+
+#include "wolfssl/wolfcrypt/settings.h"
+#include "wolfssl/wolfcrypt/random.h"
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+/* Shared TPM device "dev" (wolf_menu.c). Examples use these instead of
+ * wolfTPM2_Init / wolfTPM2_Cleanup, so the tasks running commands on dev are
+ * stopped first and the menu state is attached to the new context */
+int wolf_tpm_init(void* userCtx);
+int wolf_tpm_cleanup(void);
+
+#ifdef WOLF_RNG_POOL
+/* TPM entropy pool for CUSTOM_RAND_GENERATE_SEED
+ *
+ * A low priority task keeps a ring of cache line sized slots filled with TPM
+ * random. my_rng_seed_gen() takes whole slots without locking (each slot is
+ * used once) and reads from the TPM directly only when the ring runs dry
+ * (an underflow).
+ */
+#ifndef WOLF_RNG_POOL_SLOTS
+    #define WOLF_RNG_POOL_SLOTS  64 /* must be power of 2 */
+#endif
+#ifndef WOLF_RNG_POOL_LINE_SZ
+    #define WOLF_RNG_POOL_LINE_SZ 64 /* Cortex-A53 cache line */
+#endif
+#ifndef WOLF_RNG_POOL_IDLE_MS
+    #define WOLF_RNG_POOL_IDLE_MS 10 /* refill task poll when ring is full */
+#endif
+#define WOLF_RNG_LAT_SAMPLES 128 /* seed latencies kept for percentiles */
+
+typedef struct WolfRngPoolStats {
+    word32 requests;    /* seed requests */
+    word32 underflows;  /* requests the ring could not fully serve */
+    word32 poolBytes;   /* bytes served from the ring */
+    word32 directBytes; /* bytes read from the TPM by the requesting task */
+    word32 refills;     /* slots filled by the refill task */
+    word32 level;       /* filled slots */
+    word32 p50Us;       /* seed latency percentiles (recent samples) */
+    word32 p90Us;
+    word32 p99Us;
+    word32 maxUs;
+} WolfRngPoolStats;
+
+/* Starts the refill task, call after the TPM is initialized. The task uses
+ * dev, stop it before dev is initialized again or cleaned up (wolf_tpm_init
+ * and wolf_tpm_cleanup do) */
+int  wolf_rng_pool_start(void);
+void wolf_rng_pool_stop(void);
+void wolf_rng_pool_stats(WolfRngPoolStats* stats, int reset);
+#endif /* WOLF_RNG_POOL */
+
+/* Per task Hash_DRBG, so tasks don't share (and lock) one WC_RNG. Seeded on
+ * first use. A task must call wolf_rng_task_free() before it deletes itself */
+#ifndef WOLF_RNG_TASK_MAX
+    #define WOLF_RNG_TASK_MAX 8
+#endif
+WC_RNG* wolf_rng_task(void);
+void    wolf_rng_task_free(void);
+
+#ifdef __cplusplus
+    }  /* extern "C" */
+#endif
+
+#endif /* _WOLF_PORT_H_ */
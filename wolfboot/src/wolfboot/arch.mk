@@ -130,6 +130,21 @@ ifeq ($(ARCH),RISCV)
   ARCH_FLASH_OFFSET=0x20010000
 endif
 
+ifeq ($(TARGET),zynq)
+  # GQSPI DMA reads, overlapped with image hashing
+  EXT_FLASH_ASYNC?=1
+  ifeq ($(EXT_FLASH_ASYNC),1)
+    CFLAGS+=-DEXT_FLASH_ASYNC
+  endif
+  ifneq ($(EXT_READ_BLOCK_SIZE),)
+    CFLAGS+=-DWOLFBOOT_EXT_READ_BLOCK_SIZE=$(EXT_READ_BLOCK_SIZE)
+  endif
+endif
+
+ifeq ($(BOOT_TIME),1)
+  CFLAGS+=-DWOLFBOOT_BOOT_TIME
+endif
+
 ifeq ($(TARGET),kinetis)
   CFLAGS+= -I$(MCUXPRESSO_DRIVERS)/drivers -I$(MCUXPRESSO_DRIVERS) -DCPU_$(MCUXPRESSO_CPU) -I$(MCUXPRESSO_CMSIS)/Include -DDEBUG_CONSOLE_ASSERT_DISABLE=1
   OBJS+= $(MCUXPRESSO_DRIVERS)/drivers/fsl_clock.o $(MCUXPRESSO_DRIVERS)/drivers/fsl_ftfx_flash.o $(MCUXPRESSO_DRIVERS)/drivers/fsl_ftfx_cache.o $(MCUXPRESSO_DRIVERS)/drivers/fsl_ftfx_controller.o
@@ -28,6 +28,7 @@
 
 #include <target.h>
 #include "image.h"
+#include "hal.h"
 #include "printf.h"
 #ifndef ARCH_AARCH64
 #   error "wolfBoot zynq HAL: wrong architecture selected. Please compile with ARCH=AARCH64."
@@ -65,10 +66,13 @@
 #define GQSPI_XFER_STS     (*((volatile uint32_t*)(QSPI_BASE + 0x15C))) /* transfer status register. */
 #define QSPI_DATA_DLY_ADJ  (*((volatile uint32_t*)(QSPI_BASE + 0x1F8))) /* adjusting the internal receive data delay for read data capturing */
 #define GQSPI_MOD_ID       (*((volatile uint32_t*)(QSPI_BASE + 0x1FC)))
+#define QSPIDMA_DST_ADDR   (*((volatile uint32_t*)(QSPI_BASE + 0x800))) /* DMA destination address (bits 31:2) */
+#define QSPIDMA_DST_SIZE   (*((volatile uint32_t*)(QSPI_BASE + 0x804))) /* DMA transfer size in bytes (bits 28:2) */
 #define QSPIDMA_DST_STS    (*((volatile uint32_t*)(QSPI_BASE + 0x808)))
 #define QSPIDMA_DST_CTRL   (*((volatile uint32_t*)(QSPI_BASE + 0x80C)))
 #define QSPIDMA_DST_I_STS  (*((volatile uint32_t*)(QSPI_BASE + 0x814)))
 #define QSPIDMA_DST_CTRL2  (*((volatile uint32_t*)(QSPI_BASE + 0x824)))
+#define QSPIDMA_DST_ADDR_MSB (*((volatile uint32_t*)(QSPI_BASE + 0x828))) /* DMA destination address (bits 43:32) */
 
 /* GQSPI Registers */
 /* GQSPI_CFG: Configuration registers */
@@ -146,6 +150,8 @@
 #define QSPIDMA_DST_STS_WTC   0xE000U
 
 /* QSPIDMA_DST_I_STS */
+#define QSPIDMA_DST_I_STS_DONE     (1UL << 1)
+#define QSPIDMA_DST_I_STS_ERR_MASK 0xDCU /* AXI, timeout, APB and overflow errors */
 #define QSPIDMA_DST_I_STS_ALL_MASK 0xFEU
 
 /* IOP System-level Control */
@@ -165,6 +171,8 @@
 #define GQSPI_DUMMY_READ       10 /* Number of dummy clock cycles for reads */
 #define GQSPI_FIFO_WORD_SZ     4
 #define GQSPI_TIMEOUT_TRIES    100000
+#define GQSPI_DMA_TIMEOUT_TRIES 10000000
+#define GQSPI_DMA_ALIGN        64 /* Cortex-A53 cache line */
 #define QSPI_FLASH_READY_TRIES 1000
 
 /* Flash Parameters:
@@ -218,6 +226,18 @@ typedef struct QspiDev {
 
 static QspiDev_t mDev;
 
+#if defined(EXT_FLASH_ASYNC) && !defined(USE_QNX)
+/* Outstanding GQSPI DMA read (ext_flash_read_start) */
+typedef struct QspiDma {
+    uint8_t* data;
+    uint32_t len;
+    int      busy;
+    int      ret; /* result of a read that did not use DMA */
+} QspiDma_t;
+
+static QspiDma_t mDma;
+#endif
+
 #ifdef TEST_FLASH
 static int test_flash(QspiDev_t* dev);
 #endif
@@ -599,6 +619,124 @@ static int qspi_transfer(QspiDev_t* pDev,
     return ret;
 }
 
+#ifdef EXT_FLASH_ASYNC
+/* Clean and invalidate the data cache lines covering a DMA buffer */
+static void dcache_flush_range(uintptr_t addr, uint32_t sz)
+{
+    uintptr_t end = addr + sz;
+    addr &= ~((uintptr_t)GQSPI_DMA_ALIGN - 1);
+    while (addr < end) {
+        __asm__ volatile("dc civac, %0" : : "r" (addr) : "memory");
+        addr += GQSPI_DMA_ALIGN;
+    }
+    __asm__ volatile("dsb sy" : : : "memory");
+}
+
+/* Queues a read using the generic FIFO in DMA mode and returns without
+ * waiting. The RX data goes directly to rxData (rxSz multiple of 4) */
+static int qspi_dma_read_start(QspiDev_t* pDev,
+    const uint8_t* cmdData, uint32_t cmdSz,
+    uint8_t* rxData, uint32_t rxSz, uint32_t dummySz)
+{
+    int ret = GQSPI_CODE_SUCCESS;
+    uint32_t reg_genfifo, xferSz, exp;
+
+    dcache_flush_range((uintptr_t)rxData, rxSz);
+
+    /* Route RX FIFO to the DMA */
+    GQSPI_CFG = (GQSPI_CFG & ~GQSPI_CFG_MODE_EN_MASK) | GQSPI_CFG_MODE_EN_DMA;
+    QSPIDMA_DST_I_STS = QSPIDMA_DST_I_STS_ALL_MASK; /* clear status */
+    QSPIDMA_DST_ADDR = (uint32_t)((uintptr_t)rxData);
+    QSPIDMA_DST_ADDR_MSB = (uint32_t)((uint64_t)(uintptr_t)rxData >> 32);
+    QSPIDMA_DST_SIZE = rxSz;
+
+    GQSPI_EN = 1; /* Enable device */
+    qspi_cs(pDev, 1); /* Select slave */
+
+    reg_genfifo = ((pDev->bus & GQSPI_GEN_FIFO_BUS_MASK) |
+                   (pDev->cs & GQSPI_GEN_FIFO_CS_MASK) |
+                    GQSPI_GEN_FIFO_MODE_SPI);
+
+    /* Cmd Data */
+    while (ret == GQSPI_CODE_SUCCESS && cmdSz > 0) {
+        reg_genfifo |= GQSPI_GEN_FIFO_TX;
+        reg_genfifo &= ~(GQSPI_GEN_FIFO_RX | GQSPI_GEN_FIFO_IMM_MASK);
+        reg_genfifo |= GQSPI_GEN_FIFO_IMM(*cmdData); /* IMM is data */
+        ret = qspi_gen_fifo_write(reg_genfifo);
+        cmdSz--;
+        cmdData++;
+    }
+
+    /* Set desired data mode and stripe */
+    reg_genfifo |= (pDev->mode & GQSPI_GEN_FIFO_MODE_MASK);
+    reg_genfifo |= (pDev->stripe & GQSPI_GEN_FIFO_STRIPE);
+
+    /* Dummy clocks (Disable TX & RX) */
+    if (ret == GQSPI_CODE_SUCCESS && dummySz) {
+        reg_genfifo &= ~(GQSPI_GEN_FIFO_TX | GQSPI_GEN_FIFO_RX |
+                         GQSPI_GEN_FIFO_IMM_MASK | GQSPI_GEN_FIFO_EXP_MASK);
+        reg_genfifo |= GQSPI_GEN_FIFO_IMM(dummySz);
+        ret = qspi_gen_fifo_write(reg_genfifo);
+    }
+
+    /* RX Data: largest power of 2 chunks, then the remainder */
+    while (ret == GQSPI_CODE_SUCCESS && rxSz > 0) {
+        reg_genfifo &= ~(GQSPI_GEN_FIFO_TX | GQSPI_GEN_FIFO_IMM_MASK |
+                         GQSPI_GEN_FIFO_EXP_MASK);
+        reg_genfifo |= (GQSPI_GEN_FIFO_RX | GQSPI_GEN_FIFO_DATA_XFER);
+        if (rxSz > GQSPI_GEN_FIFO_IMM_MASK) {
+            exp = 8;
+            while (exp < 28 && (1UL << (exp + 1)) <= rxSz)
+                exp++;
+            xferSz = (1UL << exp);
+            reg_genfifo |= GQSPI_GEN_FIFO_EXP_MASK;
+            reg_genfifo |= GQSPI_GEN_FIFO_IMM(exp); /* IMM is exponent */
+        }
+        else {
+            xferSz = rxSz;
+            reg_genfifo |= GQSPI_GEN_FIFO_IMM(xferSz); /* IMM is length */
+        }
+        ret = qspi_gen_fifo_write(reg_genfifo);
+        rxSz -= xferSz;
+    }
+
+    qspi_cs(pDev, 0); /* Deselect Slave (after the data) */
+
+    return ret;
+}
+
+/* Waits for the DMA done interrupt status and restores I/O mode */
+static int qspi_dma_read_wait(uint8_t* rxData, uint32_t rxSz)
+{
+    int ret = GQSPI_CODE_SUCCESS;
+    uint32_t timeout = 0, status;
+
+    while (((status = QSPIDMA_DST_I_STS) & QSPIDMA_DST_I_STS_DONE) == 0) {
+        if (++timeout == GQSPI_DMA_TIMEOUT_TRIES) {
+            ret = GQSPI_CODE_TIMEOUT;
+            break;
+        }
+    }
+    if (status & QSPIDMA_DST_I_STS_ERR_MASK)
+        ret = GQSPI_CODE_FAILED;
+    QSPIDMA_DST_I_STS = status; /* clear */
+
+    /* wait for the CS deassert entry */
+    if (qspi_isr_wait(GQSPI_IXR_GEN_FIFO_EMPTY, 0) && ret == GQSPI_CODE_SUCCESS)
+        ret = GQSPI_CODE_TIMEOUT;
+    GQSPI_EN = 0; /* Disable Device */
+    GQSPI_CFG = (GQSPI_CFG & ~GQSPI_CFG_MODE_EN_MASK) | GQSPI_CFG_MODE_EN_IO;
+
+    /* drop lines speculatively loaded while the DMA was running */
+    dcache_flush_range((uintptr_t)rxData, rxSz);
+
+#if defined(DEBUG_ZYNQ) && DEBUG_ZYNQ >= 2
+    wolfBoot_printf("DMA Read: Ret %d, Sts %08x\n", ret, status);
+#endif
+    return ret;
+}
+#endif /* EXT_FLASH_ASYNC */
+
 #if 0
 static void qspi_dump_regs(void)
 {
@@ -967,6 +1105,18 @@ void hal_prepare_boot(void)
     zynq_exit();
 }
 
+#ifdef WOLFBOOT_BOOT_TIME
+uint32_t hal_get_timer_us(void)
+{
+    uint64_t cntpct, cntfrq;
+    __asm__ volatile("mrs %0, cntpct_el0" : "=r" (cntpct));
+    __asm__ volatile("mrs %0, cntfrq_el0" : "=r" (cntfrq));
+    if (cntfrq == 0) /* not set (only writable at EL3) */
+        cntfrq = CORTEXA53_0_TIMESTAMP_CLK_FREQ;
+    return (uint32_t)((cntpct * 1000000ULL) / cntfrq);
+}
+#endif
+
 /* Flash functions must be relocated to RAM for execution */
 int RAMFUNCTION hal_flash_write(uint32_t address, const uint8_t *data, int len)
 {
@@ -1041,6 +1191,10 @@ int RAMFUNCTION ext_flash_read(uintptr_t address, uint8_t *data, int len)
     uint8_t cmd[5];
     uint32_t idx = 0;
 
+#if defined(EXT_FLASH_ASYNC) && !defined(USE_QNX)
+    ext_flash_read_wait(); /* finish any outstanding DMA read */
+#endif
+
     if (mDev.stripe) {
         /* For dual parallel the address divide by 2 */
         address /= 2;
@@ -1062,6 +1216,70 @@ int RAMFUNCTION ext_flash_read(uintptr_t address, uint8_t *data, int len)
     return ret;
 }
 
+#ifdef EXT_FLASH_ASYNC
+/* Starts a read and returns, the data is valid after ext_flash_read_wait().
+ * DMA is used when data and len are cache line aligned, otherwise (and with
+ * QNX) the read is done here and ext_flash_read_wait() returns its result */
+int RAMFUNCTION ext_flash_read_start(uintptr_t address, uint8_t *data, int len)
+{
+#ifndef USE_QNX
+    int ret;
+    uint8_t cmd[5];
+    uint32_t idx = 0;
+
+    ext_flash_read_wait();
+
+    if (len > 0 && ((uintptr_t)data % GQSPI_DMA_ALIGN) == 0 &&
+            (len % GQSPI_DMA_ALIGN) == 0) {
+        if (mDev.stripe) {
+            /* For dual parallel the address divide by 2 */
+            address /= 2;
+        }
+        cmd[idx++] = FAST_READ_CMD;
+    #if GQPI_USE_4BYTE_ADDR == 1
+        cmd[idx++] = ((address >> 24) & 0xFF);
+    #endif
+        cmd[idx++] = ((address >> 16) & 0xFF);
+        cmd[idx++] = ((address >> 8)  & 0xFF);
+        cmd[idx++] = ((address >> 0)  & 0xFF);
+        ret = qspi_dma_read_start(&mDev, cmd, idx, data, len,
+            GQSPI_DUMMY_READ);
+        mDma.data = data;
+        mDma.len = len;
+        mDma.busy = 1;
+        mDma.ret = ret;
+        if (ret != GQSPI_CODE_SUCCESS)
+            ext_flash_read_wait(); /* restore I/O mode */
+        return ret;
+    }
+    mDma.ret = ext_flash_read(address, data, len);
+    return mDma.ret;
+#else
+    return ext_flash_read(address, data, len);
+#endif
+}
+
+int RAMFUNCTION ext_flash_read_wait(void)
+{
+#ifndef USE_QNX
+    if (!mDma.busy)
+        return mDma.ret;
+    mDma.busy = 0;
+    if (mDma.ret == GQSPI_CODE_SUCCESS) {
+        mDma.ret = qspi_dma_read_wait(mDma.data, mDma.len);
+    }
+    else {
+        /* queuing failed, back to I/O mode */
+        GQSPI_EN = 0;
+        GQSPI_CFG = (GQSPI_CFG & ~GQSPI_CFG_MODE_EN_MASK) | GQSPI_CFG_MODE_EN_IO;
+    }
+    return mDma.ret;
+#else
+    return 0;
+#endif
+}
+#endif /* EXT_FLASH_ASYNC */
+
 /* Issues a sector erase based on flash address */
 /* Assumes len is not > sector size */
 int RAMFUNCTION ext_flash_erase(uintptr_t address, int len)
@@ -48,6 +48,11 @@ void hal_prepare_boot(void);
     void hal_flash_dualbank_swap(void);
 #endif
 
+#ifdef WOLFBOOT_BOOT_TIME
+    /* free running microsecond counter, used for the boot time breakdown */
+    uint32_t hal_get_timer_us(void);
+#endif
+
 #ifndef SPI_FLASH
     /* user supplied external flash interfaces */
     int  ext_flash_write(uintptr_t address, const uint8_t *data, int len);
@@ -55,6 +60,12 @@ void hal_prepare_boot(void);
     int  ext_flash_erase(uintptr_t address, int len);
     void ext_flash_lock(void);
     void ext_flash_unlock(void);
+    #ifdef EXT_FLASH_ASYNC
+    /* optional non-blocking read, used to hash one block while the next
+     * one is read. Only one read is outstanding at a time. */
+    int  ext_flash_read_start(uintptr_t address, uint8_t *data, int len);
+    int  ext_flash_read_wait(void);
+    #endif
 #else
     #include "spi_flash.h"
     #define ext_flash_lock() do{}while(0)
@@ -23,6 +23,7 @@
 #include "image.h"
 #include "hal.h"
 #include "spi_drv.h"
+#include "printf.h"
 
 #include <wolfssl/wolfcrypt/settings.h>
 
@@ -314,6 +315,87 @@ static uint8_t *get_sha_block(struct wolfBoot_image *img, uint32_t offset)
         return (uint8_t *)(img->fw_base + offset);
 }
 
+/* encrypted partitions are read through ext_flash_decrypt_read */
+#if defined(EXT_FLASH) && defined(EXT_FLASH_ASYNC) && !defined(EXT_ENCRYPTED)
+#   define EXT_HASH_PIPELINE
+#endif
+
+#ifdef EXT_HASH_PIPELINE
+/* Pipelined hashing of an external partition: the HAL fills one block
+ * (ext_flash_read_start) while the other one is hashed, so the time spent is
+ * close to max(read, hash) instead of read + hash. */
+#ifndef WOLFBOOT_EXT_READ_BLOCK_SIZE
+#   define WOLFBOOT_EXT_READ_BLOCK_SIZE (4096)
+#endif
+#if (WOLFBOOT_EXT_READ_BLOCK_SIZE % 64) != 0
+#   error "WOLFBOOT_EXT_READ_BLOCK_SIZE must be a multiple of 64"
+#endif
+static uint8_t ext_read_block[2][WOLFBOOT_EXT_READ_BLOCK_SIZE]
+    __attribute__((aligned(64))); /* cache line aligned for DMA */
+
+typedef int (*hash_update_cb)(void *ctx, const uint8_t *data, int len);
+
+static int ext_hash_pipelined(struct wolfBoot_image *img,
+    hash_update_cb update, void *ctx)
+{
+    uintptr_t base = (uintptr_t)img->fw_base;
+    uint32_t position = 0, next;
+    int blksz, cur = 0;
+#ifdef WOLFBOOT_BOOT_TIME
+    uint32_t t_start, t, wait_us = 0, hash_us = 0, blocks = 0;
+    t_start = hal_get_timer_us();
+#endif
+
+    if (img->fw_size == 0)
+        return 0;
+    if (ext_flash_read_start(base, ext_read_block[0],
+            WOLFBOOT_EXT_READ_BLOCK_SIZE) < 0)
+        return -1;
+    while (position < img->fw_size) {
+    #ifdef WOLFBOOT_BOOT_TIME
+        t = hal_get_timer_us();
+    #endif
+        if (ext_flash_read_wait() < 0)
+            return -1;
+    #ifdef WOLFBOOT_BOOT_TIME
+        wait_us += hal_get_timer_us() - t;
+    #endif
+        blksz = WOLFBOOT_EXT_READ_BLOCK_SIZE;
+        if (position + blksz > img->fw_size)
+            blksz = img->fw_size - position;
+
+        /* start the next read before hashing the current block */
+        next = position + blksz;
+        if (next < img->fw_size) {
+            if (ext_flash_read_start(base + next, ext_read_block[cur ^ 1],
+                    WOLFBOOT_EXT_READ_BLOCK_SIZE) < 0)
+                return -1;
+        }
+    #ifdef WOLFBOOT_BOOT_TIME
+        t = hal_get_timer_us();
+    #endif
+        if (update(ctx, ext_read_block[cur], blksz) != 0) {
+            if (next < img->fw_size)
+                ext_flash_read_wait();
+            return -1;
+        }
+    #ifdef WOLFBOOT_BOOT_TIME
+        hash_us += hal_get_timer_us() - t;
+        blocks++;
+    #endif
+        position = next;
+        cur ^= 1;
+    }
+#ifdef WOLFBOOT_BOOT_TIME
+    wolfBoot_printf("Hash %d bytes: %d blocks of %d, "
+        "read wait %d us, hash %d us, total %d us\n",
+        (int)img->fw_size, (int)blocks, WOLFBOOT_EXT_READ_BLOCK_SIZE,
+        (int)wait_us, (int)hash_us, (int)(hal_get_timer_us() - t_start));
+#endif
+    return 0;
+}
+#endif /* EXT_HASH_PIPELINE */
+
 #ifdef EXT_FLASH
 static uint8_t hdr_cpy[IMAGE_HEADER_SIZE];
 static int hdr_cpy_done = 0;
@@ -347,6 +429,20 @@ static uint8_t *get_img_hdr(struct wolfBoot_image *img)
 
 #if defined(WOLFBOOT_HASH_SHA256)
 #include <wolfssl/wolfcrypt/sha256.h>
+#ifdef EXT_HASH_PIPELINE
+#if defined(WOLFBOOT_TPM) && defined(WOLFBOOT_HASH_TPM)
+static int tpm_hash_update(void *ctx, const uint8_t *data, int len)
+{
+    return wolfTPM2_HashUpdate(&wolftpm_dev, (WOLFTPM2_HASH *)ctx, data, len);
+}
+#else
+static int sha256_update(void *ctx, const uint8_t *data, int len)
+{
+    return wc_Sha256Update((wc_Sha256 *)ctx, data, len);
+}
+#endif
+#endif /* EXT_HASH_PIPELINE */
+
 static int image_sha256(struct wolfBoot_image *img, uint8_t *hash)
 {
 #if defined(WOLFBOOT_TPM) && defined(WOLFBOOT_HASH_TPM)
@@ -378,6 +474,12 @@ static int image_sha256(struct wolfBoot_image *img, uint8_t *hash)
         wolfTPM2_HashUpdate(&wolftpm_dev, &tpmHash, p, blksz);
         p += blksz;
     }
+#ifdef EXT_HASH_PIPELINE
+    if (PART_IS_EXT(img)) {
+        if (ext_hash_pipelined(img, tpm_hash_update, &tpmHash) != 0)
+            return -1;
+    } else
+#endif
     do {
         p = get_sha_block(img, position);
         if (p == NULL)
@@ -411,6 +513,12 @@ static int image_sha256(struct wolfBoot_image *img, uint8_t *hash)
         wc_Sha256Update(&sha256_ctx, p, blksz);
         p += blksz;
     }
+#ifdef EXT_HASH_PIPELINE
+    if (PART_IS_EXT(img)) {
+        if (ext_hash_pipelined(img, sha256_update, &sha256_ctx) != 0)
+            return -1;
+    } else
+#endif
     do {
         p = get_sha_block(img, position);
         if (p == NULL)
@@ -471,6 +579,13 @@ static void key_sha256(uint8_t *hash)
 
 #include <wolfssl/wolfcrypt/sha3.h>
 
+#ifdef EXT_HASH_PIPELINE
+static int sha3_384_update(void *ctx, const uint8_t *data, int len)
+{
+    return wc_Sha3_384_Update((wc_Sha3 *)ctx, data, len);
+}
+#endif
+
 static int image_sha3_384(struct wolfBoot_image *img, uint8_t *hash)
 {
     uint8_t *stored_sha, *end_sha;
@@ -494,6 +609,12 @@ static int image_sha3_384(struct wolfBoot_image *img, uint8_t *hash)
         wc_Sha3_384_Update(&sha3_ctx, p, blksz);
         p += blksz;
     }
+#ifdef EXT_HASH_PIPELINE
+    if (PART_IS_EXT(img)) {
+        if (ext_hash_pipelined(img, sha3_384_update, &sha3_ctx) != 0)
+            return -1;
+    } else
+#endif
     do {
         p = get_sha_block(img, position);
         if (p == NULL)
@@ -652,11 +773,21 @@ int wolfBoot_verify_integrity(struct wolfBoot_image *img)
 {
     uint8_t *stored_sha;
     uint16_t stored_sha_len;
+#ifdef WOLFBOOT_BOOT_TIME
+    uint32_t t;
+#endif
     stored_sha_len = get_header(img, WOLFBOOT_SHA_HDR, &stored_sha);
     if (stored_sha_len != WOLFBOOT_SHA_DIGEST_SIZE)
         return -1;
+#ifdef WOLFBOOT_BOOT_TIME
+    t = hal_get_timer_us();
+#endif
     if (image_hash(img, digest) != 0)
         return -1;
+#ifdef WOLFBOOT_BOOT_TIME
+    wolfBoot_printf("Integrity: part %d, %d us\n", img->part,
+        (int)(hal_get_timer_us() - t));
+#endif
     if (memcmp(digest, stored_sha, stored_sha_len) != 0)
         return -1;
     img->sha_ok = 1;
@@ -674,6 +805,9 @@ int wolfBoot_verify_authenticity(struct wolfBoot_image *img)
     uint8_t *image_type_buf;
     uint16_t image_type;
     uint16_t image_type_size;
+#ifdef WOLFBOOT_BOOT_TIME
+    uint32_t t;
+#endif
 
     stored_signature_size = get_header(img, HDR_SIGNATURE, &stored_signature);
     if (stored_signature_size != IMAGE_SIGNATURE_SIZE)
@@ -695,7 +829,15 @@ int wolfBoot_verify_authenticity(struct wolfBoot_image *img)
             return -1;
         img->sha_hash = digest;
     }
-    if ((ret = wolfBoot_verify_signature(img->sha_hash, stored_signature)) != 0)
+#ifdef WOLFBOOT_BOOT_TIME
+    t = hal_get_timer_us();
+#endif
+    ret = wolfBoot_verify_signature(img->sha_hash, stored_signature);
+#ifdef WOLFBOOT_BOOT_TIME
+    wolfBoot_printf("Signature: part %d, %d us\n", img->part,
+        (int)(hal_get_timer_us() - t));
+#endif
+    if (ret != 0)
         return ret;
     img->signature_ok = 1;
     return 0;
@@ -38,6 +38,7 @@ ifeq ($(ARCH),)
   PSOC6_CRYPTO?=1
   WOLFTPM?=0
   TZEN?=0
+  BOOT_TIME?=0
   WOLFBOOT_PARTITION_SIZE?=0x20000
   WOLFBOOT_SECTOR_SIZE?=0x20000
   WOLFBOOT_PARTITION_BOOT_ADDRESS?=0x20000
@@ -55,6 +56,7 @@ CONFIG_VARS:= ARCH TARGET SIGN HASH MCUXPRESSO MCUXPRESSO_CPU MCUXPRESSO_DRIVERS
 	CORTEX_M0 CORTEX_M33 NO_ASM EXT_FLASH SPI_FLASH NO_XIP UART_FLASH ALLOW_DOWNGRADE NVM_FLASH_WRITEONCE \
 	DISABLE_BACKUP WOLFBOOT_VERSION V NO_MPU ENCRYPT FLAGS_HOME FLAGS_INVERT \
 	SPMATH RAM_CODE DUALBANK_SWAP IMAGE_HEADER_SIZE PKA TZEN PSOC6_CRYPTO WOLFTPM \
+	BOOT_TIME EXT_FLASH_ASYNC EXT_READ_BLOCK_SIZE \
 	WOLFBOOT_PARTITION_SIZE WOLFBOOT_SECTOR_SIZE  \
 	WOLFBOOT_PARTITION_BOOT_ADDRESS WOLFBOOT_PARTITION_UPDATE_ADDRESS \
 	WOLFBOOT_PARTITION_SWAP_ADDRESS WOLFBOOT_LOAD_ADDRESS \
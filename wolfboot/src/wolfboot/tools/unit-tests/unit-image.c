@@ -0,0 +1,298 @@
+/* unit-image.c
+ *
+ * Unit test for the pipelined external flash hashing in image.c
+ * (EXT_FLASH_ASYNC). The external flash is backed by a temporary file and
+ * reads started with ext_flash_read_start() only land in the buffer when
+ * ext_flash_read_wait() is called, so hashing a block before waiting for it
+ * produces a wrong digest.
+ *
+ *
+ * Copyright (C) 2020 wolfSSL Inc.
+ *
+ * This file is part of wolfBoot.
+ *
+ * wolfBoot is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfBoot is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "image.c"
+#include <check.h>
+
+#define TEST_BLK WOLFBOOT_EXT_READ_BLOCK_SIZE
+
+/* File backed external flash */
+static FILE *ext_file;
+static struct {
+    uintptr_t address;
+    uint8_t *data;
+    int len;
+    int busy;
+} ext_pending;
+static int ext_reads;
+static int ext_fail_at; /* fail this read (1 based), 0 = never */
+
+static int ext_file_read(uintptr_t address, uint8_t *data, int len)
+{
+    ssize_t ret;
+    memset(data, 0xFF, len);
+    ret = pread(fileno(ext_file), data, len,
+            address - WOLFBOOT_PARTITION_BOOT_ADDRESS);
+    return (ret < 0) ? -1 : 0;
+}
+
+/* Mocks */
+void hal_init(void)
+{
+}
+int hal_flash_write(uint32_t address, const uint8_t *data, int len)
+{
+    return 0;
+}
+int hal_flash_erase(uint32_t address, int len)
+{
+    return 0;
+}
+void hal_flash_unlock(void)
+{
+}
+void hal_flash_lock(void)
+{
+}
+void hal_prepare_boot(void)
+{
+}
+int ext_flash_write(uintptr_t address, const uint8_t *data, int len)
+{
+    return 0;
+}
+int ext_flash_erase(uintptr_t address, int len)
+{
+    return 0;
+}
+void ext_flash_lock(void)
+{
+}
+void ext_flash_unlock(void)
+{
+}
+int ext_flash_read(uintptr_t address, uint8_t *data, int len)
+{
+    fail_if(ext_pending.busy, "Synchronous read with a read in progress\n");
+    return ext_file_read(address, data, len);
+}
+int ext_flash_read_start(uintptr_t address, uint8_t *data, int len)
+{
+    fail_if(ext_pending.busy, "More than one read in progress\n");
+    fail_if(len > TEST_BLK, "Read larger than the block size\n");
+    ext_pending.address = address;
+    ext_pending.data = data;
+    ext_pending.len = len;
+    ext_pending.busy = 1;
+    memset(data, 0xA5, len); /* "DMA" in progress */
+    return 0;
+}
+int ext_flash_read_wait(void)
+{
+    if (!ext_pending.busy)
+        return 0;
+    ext_pending.busy = 0;
+    if (++ext_reads == ext_fail_at)
+        return -1;
+    return ext_file_read(ext_pending.address, ext_pending.data,
+            ext_pending.len);
+}
+uint32_t hal_get_timer_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000000UL + ts.tv_nsec / 1000);
+}
+const unsigned char ed25519_pub_key[32];
+unsigned int ed25519_pub_key_len = 32;
+int wc_ed25519_init(ed25519_key *key)
+{
+    return 0;
+}
+int wc_ed25519_import_public(const byte *in, word32 inLen, ed25519_key *key)
+{
+    return 0;
+}
+int wc_ed25519_verify_msg(const byte *sig, word32 sigLen, const byte *msg,
+    word32 msgLen, int *stat, ed25519_key *key)
+{
+    *stat = 0;
+    return 0;
+}
+/* End Mocks */
+
+Suite *wolfboot_suite(void);
+
+/* Writes a boot image with fw_size bytes of firmware and its SHA256 */
+static void make_image(uint32_t fw_size)
+{
+    uint8_t hdr[IMAGE_HEADER_SIZE];
+    uint8_t fw[TEST_BLK];
+    uint32_t i, magic = WOLFBOOT_MAGIC, sz;
+    wc_Sha256 sha;
+
+    if (ext_file)
+        fclose(ext_file);
+    ext_file = tmpfile();
+    fail_if(ext_file == NULL, "Cannot create the flash file\n");
+
+    memset(hdr, 0xFF, sizeof(hdr));
+    memcpy(hdr, &magic, sizeof(magic));
+    memcpy(hdr + 4, &fw_size, sizeof(fw_size));
+    hdr[8] = HDR_SHA256;
+    hdr[9] = 0;
+    hdr[10] = WOLFBOOT_SHA_DIGEST_SIZE;
+    hdr[11] = 0;
+    hdr[12 + WOLFBOOT_SHA_DIGEST_SIZE] = 0; /* HDR_END */
+    hdr[13 + WOLFBOOT_SHA_DIGEST_SIZE] = 0;
+
+    wc_InitSha256(&sha);
+    wc_Sha256Update(&sha, hdr, 8);
+    fseek(ext_file, IMAGE_HEADER_SIZE, SEEK_SET);
+    for (i = 0; i < fw_size; i += sz) {
+        uint32_t j;
+        sz = fw_size - i;
+        if (sz > sizeof(fw))
+            sz = sizeof(fw);
+        for (j = 0; j < sz; j++)
+            fw[j] = (uint8_t)((i + j) * 7 + ((i + j) >> 8));
+        wc_Sha256Update(&sha, fw, sz);
+        fwrite(fw, 1, sz, ext_file);
+    }
+    wc_Sha256Final(&sha, hdr + 12);
+    fseek(ext_file, 0, SEEK_SET);
+    fwrite(hdr, 1, sizeof(hdr), ext_file);
+    fflush(ext_file);
+
+    memset(&ext_pending, 0, sizeof(ext_pending));
+    ext_reads = 0;
+    ext_fail_at = 0;
+}
+
+static void flip_byte(uint32_t offset)
+{
+    uint8_t b;
+    fseek(ext_file, IMAGE_HEADER_SIZE + offset, SEEK_SET);
+    fread(&b, 1, 1, ext_file);
+    b ^= 0x01;
+    fseek(ext_file, IMAGE_HEADER_SIZE + offset, SEEK_SET);
+    fwrite(&b, 1, 1, ext_file);
+    fflush(ext_file);
+}
+
+START_TEST (test_pipeline_sunny)
+{
+    struct wolfBoot_image img;
+    const uint32_t sizes[] = {
+        1, TEST_BLK - 1, TEST_BLK, TEST_BLK + 1, 3 * TEST_BLK + 100
+    };
+    unsigned int i;
+
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        make_image(sizes[i]);
+        fail_if(wolfBoot_open_image(&img, PART_BOOT) != 0,
+            "Cannot open image\n");
+        fail_if(img.fw_size != sizes[i], "Wrong image size\n");
+        fail_if(wolfBoot_verify_integrity(&img) != 0,
+            "Integrity check failed for %d bytes\n", sizes[i]);
+        fail_unless(ext_reads == (int)((sizes[i] + TEST_BLK - 1) / TEST_BLK),
+            "Unexpected number of reads %d\n", ext_reads);
+        fail_if(ext_pending.busy, "Read left in progress\n");
+    }
+}
+END_TEST
+
+START_TEST (test_pipeline_corrupt)
+{
+    struct wolfBoot_image img;
+    uint32_t fw_size = 3 * TEST_BLK + 100;
+
+    /* first, middle and last block */
+    make_image(fw_size);
+    flip_byte(0);
+    fail_if(wolfBoot_open_image(&img, PART_BOOT) != 0, "Cannot open image\n");
+    fail_unless(wolfBoot_verify_integrity(&img) != 0,
+        "Corrupted first block not detected\n");
+
+    make_image(fw_size);
+    flip_byte(TEST_BLK + 3);
+    fail_if(wolfBoot_open_image(&img, PART_BOOT) != 0, "Cannot open image\n");
+    fail_unless(wolfBoot_verify_integrity(&img) != 0,
+        "Corrupted block not detected\n");
+
+    make_image(fw_size);
+    flip_byte(fw_size - 1);
+    fail_if(wolfBoot_open_image(&img, PART_BOOT) != 0, "Cannot open image\n");
+    fail_unless(wolfBoot_verify_integrity(&img) != 0,
+        "Corrupted last block not detected\n");
+}
+END_TEST
+
+START_TEST (test_pipeline_read_error)
+{
+    struct wolfBoot_image img;
+
+    make_image(3 * TEST_BLK);
+    ext_fail_at = 2;
+    fail_if(wolfBoot_open_image(&img, PART_BOOT) != 0, "Cannot open image\n");
+    fail_unless(wolfBoot_verify_integrity(&img) != 0,
+        "Read error not reported\n");
+    fail_if(ext_pending.busy, "Read left in progress\n");
+}
+END_TEST
+
+Suite *wolfboot_suite(void)
+{
+
+    /* Suite initialization */
+    Suite *s = suite_create("wolfBoot");
+
+    /* Test cases */
+    TCase *pipeline_sunny = tcase_create("Pipelined hash Sunny-day case");
+    TCase *pipeline_corrupt = tcase_create("Pipelined hash corrupted image");
+    TCase *pipeline_error = tcase_create("Pipelined hash read error");
+
+    /* Test function <-> Test case */
+    tcase_add_test(pipeline_sunny, test_pipeline_sunny);
+    tcase_add_test(pipeline_corrupt, test_pipeline_corrupt);
+    tcase_add_test(pipeline_error, test_pipeline_read_error);
+
+    /* Set parameters + add to suite */
+    tcase_set_timeout(pipeline_sunny, 20);
+    suite_add_tcase(s, pipeline_sunny);
+    suite_add_tcase(s, pipeline_corrupt);
+    suite_add_tcase(s, pipeline_error);
+
+    return s;
+}
+
+
+int main(void)
+{
+    int fails;
+    Suite *s = wolfboot_suite();
+    SRunner *sr = srunner_create(s);
+    srunner_run_all(sr, CK_NORMAL);
+    fails = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return fails;
+}
@@ -47,6 +47,10 @@
 #define HAVE_ENCRYPT_THEN_MAC
 #define NO_OLD_TLS
 #define WOLFSSL_TLS13
+#define HAVE_SESSION_TICKET /* TLS server resumption (tls_server.c) */
+#define WOLFSSL_SESSION_CACHE_SHARDED /* per row session cache locks */
+#define WOLFSSL_CA_INDEX /* CA lookups by index, no caLock */
+#define WOLFSSL_CHAIN_CACHE /* skip re-verifying a peer chain seen before */
 #define WOLFSSL_CERT_GEN
 #define WOLFSSL_CERT_REQ
 #define WOLFSSL_CERT_EXT
@@ -69,6 +73,36 @@
 #define TPM_TIMEOUT_TRIES 6000000 /* about 60 seconds */
 #include "sleep.h" /* for usleep() used for network startup wait */
 #define XTPM_WAIT() usleep(10)
+#define XTPM_WAIT_N(n) usleep(10 * (n))
+/* SPI clock (200MHz / 16), limited to TPM2_SPI_MAX_HZ. Runtime change with
+ * TPM2_IoCb_SetSpiClock() */
+#define TPM2_SPI_HZ 12500000
+/* Block the calling task on the SPI interrupt instead of polling the FIFO */
+//#define TPM2_SPI_USE_INTERRUPT
+
+/* Asynchronous TPM command queue, serviced by a dedicated task */
+//#define WOLFTPM_ASYNC_QUEUE
+extern unsigned int my_time_us(void);
+#define XTPM_ASYNC_TIME_US() my_time_us()
+/* Service task blocks on a semaphore given on submit (see wolf_menu.c) */
+extern void wolf_tpm_async_idle(void);
+extern void wolf_tpm_async_wake(void);
+extern void wolf_tpm_async_yield(void);
+#define XTPM_ASYNC_IDLE(queue) wolf_tpm_async_idle()
+#define XTPM_ASYNC_WAKE(queue) wolf_tpm_async_wake()
+#define XTPM_ASYNC_YIELD()     wolf_tpm_async_yield()
+/* Swap transient TPM keys LRU with ContextSave/ContextLoad (see
+ * wolfTPM2_KeyCacheInit) */
+//#define WOLFTPM_KEY_CACHE
+/* Read TIS status and burst count together, reuse the burst count across
+ * FIFO frames and back off while polling */
+//#define WOLFTPM_TIS_COALESCE
+/* SPI transaction and byte counters per TPM command (see TPM2_TIS_SetStats) */
+//#define WOLFTPM_TIS_STATS
+/* Per command TPM latency histograms, menu option y dumps them as JSON */
+//#define WOLFTPM_STATS
+/* Keep the HMAC pad hash states of each TPM auth session */
+//#define WOLFTPM_SESSION_CACHE
 
 
 /* Math */
@@ -84,12 +118,16 @@
 #define WOLFSSL_HAVE_SP_DH
 #define WOLFSSL_SP_384
 #define WOLFSSL_SP_4096
+/* Cache tables for the CA and firmware signing keys used to verify */
+#define WOLFSSL_SP_VERIFY_CACHE
 #define HAVE_DH_DEFAULT_PARAMS
 
 /* Random: HashDRGB / P-RNG (SHA256) */
 #define HAVE_HASHDRBG
 extern int my_rng_seed_gen(unsigned char* output, unsigned int sz);
 #define CUSTOM_RAND_GENERATE_SEED  my_rng_seed_gen
+/* Seeds come from a ring refilled by a background TPM task (wolf_port.c) */
+#define WOLF_RNG_POOL
 
 /* Override Current Time */
 /* Allows custom "custom_time()" function to be used for benchmark */
@@ -133,6 +171,7 @@ extern unsigned long my_time(unsigned long* timer);
 #define WOLFSSL_SHA384
 #define WOLFSSL_SHA3
 #define WOLFSSL_NO_HASH_RAW /* not supported with ARMASM */
+#define WOLFSSL_SHA256_MULTI /* multi-buffer SHA-256 (PBKDF2) */
 
 /* chacha20 / poly1305 suites */
 #define HAVE_CHACHA
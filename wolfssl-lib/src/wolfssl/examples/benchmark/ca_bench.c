@@ -0,0 +1,288 @@
+/* ca_bench.c
+ *
+ * Copyright (C) 2006-2020 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* CA signer lookup benchmark (Linux / pthreads)
+ *
+ * Makes a trust store of N self signed ECC CAs, each with its own subject
+ * name and subject key ID, and loads it as one DER bundle with
+ * wolfSSL_CertManagerLoadCABundle(). Then the threads look up random CAs by
+ * key ID and by name, as chain building does for each issuer. The bundle load
+ * time and lookups/sec are reported for store sizes 16 to 4096 with 1 and 4
+ * threads, so builds with and without WOLFSSL_CA_INDEX can be compared.
+ *
+ * GetCA() and GetCAByName() are library internals, so build against a static
+ * host build of the library, for example:
+ *   gcc -O2 -DWOLFSSL_USER_SETTINGS -I<user_settings dir> -I<wolfssl root> \
+ *       examples/benchmark/ca_bench.c libwolfssl.a -lpthread -lm \
+ *       -o ca_bench
+ *
+ * Needs WOLFSSL_CERT_GEN and WOLFSSL_CERT_EXT.
+ *
+ * Usage: ca_bench [-t seconds] [-n max CAs]
+ */
+
+#ifdef HAVE_CONFIG_H
+    #include <config.h>
+#endif
+#ifndef WOLFSSL_USER_SETTINGS
+    #include <wolfssl/options.h>
+#endif
+#include <wolfssl/wolfcrypt/settings.h>
+#include <wolfssl/ssl.h>
+#include <wolfssl/internal.h>
+#include <wolfssl/wolfcrypt/asn.h>
+#include <wolfssl/wolfcrypt/asn_public.h>
+#include <wolfssl/wolfcrypt/ecc.h>
+#include <wolfssl/wolfcrypt/random.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#define BENCH_THREADS       4
+#define BENCH_DEF_SECS      1
+#define BENCH_DEF_CAS       4096
+#define BENCH_MIN_CAS       16
+#define BENCH_CERT_SZ       1024
+
+/* lookup keys of one CA */
+typedef struct BenchCA {
+    byte keyId[SIGNER_DIGEST_SIZE];
+    byte name[SIGNER_DIGEST_SIZE];
+} BenchCA;
+
+typedef struct BenchThread {
+    pthread_t tid;
+    unsigned int seed;
+    int secs;
+    int cas;
+    long lookups;
+    int ret;
+} BenchThread;
+
+static WOLFSSL_CERT_MANAGER* cm;
+static BenchCA* caKeys;
+static pthread_barrier_t benchStart;
+
+static double now_sec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+}
+
+/* Makes self signed CA number n into der, returns the size or < 0 */
+static int make_ca(int n, ecc_key* key, WC_RNG* rng, byte* der, BenchCA* ca)
+{
+    Cert cert;
+    DecodedCert dCert;
+    int ret;
+
+    wc_InitCert(&cert);
+    snprintf(cert.subject.commonName, CTC_NAME_SIZE, "Bench CA %d", n);
+    strncpy(cert.subject.org, "wolfSSL", CTC_NAME_SIZE);
+    cert.isCA = 1;
+    cert.selfSigned = 1;
+    cert.sigType = CTC_SHA256wECDSA;
+    /* the key is shared, so make the key ID unique */
+    memset(cert.skid, 0, KEYID_SIZE);
+    memcpy(cert.skid, &n, sizeof(n));
+    cert.skidSz = KEYID_SIZE;
+
+    ret = wc_MakeCert(&cert, der, BENCH_CERT_SZ, NULL, key, rng);
+    if (ret > 0)
+        ret = wc_SignCert(cert.bodySz, cert.sigType, der, BENCH_CERT_SZ, NULL,
+                          key, rng);
+    if (ret <= 0)
+        return ret;
+
+    InitDecodedCert(&dCert, der, (word32)ret, NULL);
+    if (ParseCert(&dCert, CERT_TYPE, NO_VERIFY, NULL) != 0)
+        ret = -1;
+    else {
+        memcpy(ca->keyId, dCert.extSubjKeyId, SIGNER_DIGEST_SIZE);
+        memcpy(ca->name, dCert.subjectHash, SIGNER_DIGEST_SIZE);
+    }
+    FreeDecodedCert(&dCert);
+
+    return ret;
+}
+
+static void* bench_thread(void* arg)
+{
+    BenchThread* t = (BenchThread*)arg;
+    double end;
+    int i;
+
+    pthread_barrier_wait(&benchStart);
+    end = now_sec() + t->secs;
+
+    while (now_sec() < end) {
+        for (i = 0; i < 1000; i++) {
+            BenchCA* ca = &caKeys[rand_r(&t->seed) % t->cas];
+
+            if (GetCA(cm, ca->keyId) == NULL
+        #ifndef NO_SKID
+                || GetCAByName(cm, ca->name) == NULL
+        #endif
+                ) {
+                t->ret = -1;
+                return NULL;
+            }
+        }
+        t->lookups += i;
+    }
+
+    return NULL;
+}
+
+static int bench_run(int threads, int cas, int secs, double* rate)
+{
+    BenchThread t[BENCH_THREADS];
+    double start, elapsed;
+    long lookups = 0;
+    int i, ret = 0;
+
+    memset(t, 0, sizeof(t));
+    pthread_barrier_init(&benchStart, NULL, threads + 1);
+
+    for (i = 0; i < threads; i++) {
+        t[i].seed = (unsigned int)i + 1;
+        t[i].cas  = cas;
+        t[i].secs = secs;
+        if (pthread_create(&t[i].tid, NULL, bench_thread, &t[i]) != 0) {
+            fprintf(stderr, "pthread_create failed\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    pthread_barrier_wait(&benchStart);
+    start = now_sec();
+
+    for (i = 0; i < threads; i++) {
+        pthread_join(t[i].tid, NULL);
+        lookups += t[i].lookups;
+        if (t[i].ret != 0)
+            ret = t[i].ret;
+    }
+    elapsed = now_sec() - start;
+    pthread_barrier_destroy(&benchStart);
+
+#ifndef NO_SKID
+    lookups *= 2;
+#endif
+    *rate = (double)lookups / elapsed;
+
+    return ret;
+}
+
+int main(int argc, char** argv)
+{
+    int secs = BENCH_DEF_SECS;
+    int maxCas = BENCH_DEF_CAS;
+    int i, cas, made = 0, ret = 0;
+    byte* bundle;
+    long bundleSz = 0;
+    ecc_key key;
+    WC_RNG rng;
+    double start, load, rate1, rate4;
+
+    for (i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "-t") == 0)
+            secs = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-n") == 0)
+            maxCas = atoi(argv[i + 1]);
+        else
+            break;
+    }
+    if (i < argc || secs <= 0 || maxCas < BENCH_MIN_CAS) {
+        printf("usage: %s [-t seconds] [-n max CAs]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    wolfSSL_Init();
+
+    bundle = (byte*)malloc((size_t)maxCas * BENCH_CERT_SZ);
+    caKeys = (BenchCA*)malloc((size_t)maxCas * sizeof(BenchCA));
+    if (bundle == NULL || caKeys == NULL ||
+            wc_InitRng(&rng) != 0 || wc_ecc_init(&key) != 0 ||
+            wc_ecc_make_key(&rng, 32, &key) != 0) {
+        fprintf(stderr, "Setup failed\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("CA signer table: %s, %d sec per run\n",
+#ifdef WOLFSSL_CA_INDEX
+           "index",
+#else
+           "hash rows",
+#endif
+           secs);
+    printf("    CAs   load ms  lookups/sec 1 thread  %d threads\n",
+           BENCH_THREADS);
+
+    for (cas = BENCH_MIN_CAS; cas <= maxCas && ret == 0; cas *= 4) {
+        /* grow the bundle to cas certs */
+        for (; made < cas; made++) {
+            ret = make_ca(made, &key, &rng, bundle + bundleSz, &caKeys[made]);
+            if (ret <= 0) {
+                fprintf(stderr, "Making CA %d failed %d\n", made, ret);
+                return EXIT_FAILURE;
+            }
+            bundleSz += ret;
+        }
+        ret = 0;
+
+        cm = wolfSSL_CertManagerNew();
+        if (cm == NULL) {
+            fprintf(stderr, "CertManagerNew failed\n");
+            return EXIT_FAILURE;
+        }
+        start = now_sec();
+        if (wolfSSL_CertManagerLoadCABundle(cm, bundle, bundleSz)
+                != WOLFSSL_SUCCESS) {
+            fprintf(stderr, "Bundle load failed\n");
+            return EXIT_FAILURE;
+        }
+        load = (now_sec() - start) * 1000;
+
+        ret = bench_run(1, cas, secs, &rate1);
+        if (ret == 0)
+            ret = bench_run(BENCH_THREADS, cas, secs, &rate4);
+        if (ret == 0)
+            printf("%7d %9.1f %21.0f %11.0f\n", cas, load, rate1, rate4);
+
+        wolfSSL_CertManagerFree(cm);
+    }
+
+    wc_ecc_free(&key);
+    wc_FreeRng(&rng);
+    free(caKeys);
+    free(bundle);
+    wolfSSL_Cleanup();
+
+    if (ret != 0)
+        fprintf(stderr, "Benchmark failed %d\n", ret);
+    return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
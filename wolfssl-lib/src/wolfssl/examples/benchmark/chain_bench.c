@@ -0,0 +1,371 @@
+/* chain_bench.c
+ *
+ * Copyright (C) 2006-2020 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* Verified chain cache benchmark (Linux)
+ *
+ * Makes an ECC P-256 chain of a root CA, -d intermediate CAs and a server
+ * cert, then runs client/server handshakes over memory buffers with the
+ * client verifying the server's chain. The client's CPU time per handshake is
+ * reported with the chain cache cold (flushed before each handshake, so every
+ * chain cert is decoded and its signature checked) and warm (the chain was
+ * verified before, only the server cert is decoded).
+ *
+ * Build against a host build of the library, for example:
+ *   gcc -O2 -DWOLFSSL_USER_SETTINGS -I<user_settings dir> -I<wolfssl root> \
+ *       examples/benchmark/chain_bench.c libwolfssl.a -lpthread -lm \
+ *       -o chain_bench
+ *
+ * Needs WOLFSSL_CHAIN_CACHE, WOLFSSL_CERT_GEN and WOLFSSL_CERT_EXT.
+ *
+ * Usage: chain_bench [-n handshakes] [-d intermediates] [-v 2|3]
+ */
+
+#ifdef HAVE_CONFIG_H
+    #include <config.h>
+#endif
+#ifndef WOLFSSL_USER_SETTINGS
+    #include <wolfssl/options.h>
+#endif
+#include <wolfssl/wolfcrypt/settings.h>
+#include <wolfssl/ssl.h>
+#include <wolfssl/wolfio.h>
+#include <wolfssl/wolfcrypt/asn_public.h>
+#include <wolfssl/wolfcrypt/ecc.h>
+#include <wolfssl/wolfcrypt/random.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef WOLFSSL_CHAIN_CACHE
+    #error chain_bench needs WOLFSSL_CHAIN_CACHE
+#endif
+
+#define BENCH_DEF_HANDSHAKES 200
+#define BENCH_DEF_DEPTH     1
+#define BENCH_MAX_DEPTH     4
+#define BENCH_BUF_SZ        (32 * 1024)
+#define BENCH_CERT_SZ       1024
+#define BENCH_CIPHER        "ECDHE-ECDSA-AES128-GCM-SHA256"
+
+/* one direction of the memory transport */
+typedef struct MemPipe {
+    unsigned char buf[BENCH_BUF_SZ];
+    int len;
+    int pos;
+} MemPipe;
+
+typedef struct MemConn {
+    MemPipe toServer;
+    MemPipe toClient;
+} MemConn;
+
+typedef struct MemSide {
+    MemPipe* in;
+    MemPipe* out;
+} MemSide;
+
+/* a cert of the chain and its key */
+typedef struct BenchCert {
+    byte der[BENCH_CERT_SZ];
+    int derSz;
+    ecc_key key;
+} BenchCert;
+
+static MemConn conn;
+
+
+static int MemRecv(WOLFSSL* ssl, char* buf, int sz, void* ctx)
+{
+    MemPipe* p = ((MemSide*)ctx)->in;
+
+    (void)ssl;
+
+    if (p->pos == p->len)
+        return WOLFSSL_CBIO_ERR_WANT_READ;
+    if (sz > p->len - p->pos)
+        sz = p->len - p->pos;
+    memcpy(buf, p->buf + p->pos, sz);
+    p->pos += sz;
+    if (p->pos == p->len)
+        p->pos = p->len = 0;
+
+    return sz;
+}
+
+static int MemSend(WOLFSSL* ssl, char* buf, int sz, void* ctx)
+{
+    MemPipe* p = ((MemSide*)ctx)->out;
+
+    (void)ssl;
+
+    if (sz > BENCH_BUF_SZ - p->len)
+        sz = BENCH_BUF_SZ - p->len;
+    if (sz == 0)
+        return WOLFSSL_CBIO_ERR_WANT_WRITE;
+    memcpy(p->buf + p->len, buf, sz);
+    p->len += sz;
+
+    return sz;
+}
+
+static double cpu_sec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+}
+
+/* Makes cert n of the chain signed by issuer, or self signed when issuer is
+ * NULL. Returns 0 on success */
+static int make_cert(int n, int isCA, BenchCert* c, BenchCert* issuer,
+                     WC_RNG* rng)
+{
+    Cert cert;
+    ecc_key* signKey = (issuer != NULL) ? &issuer->key : &c->key;
+    int ret;
+
+    ret = wc_ecc_init(&c->key);
+    if (ret == 0)
+        ret = wc_ecc_make_key(rng, 32, &c->key);
+    if (ret == 0)
+        ret = wc_InitCert(&cert);
+    if (ret != 0)
+        return ret;
+
+    if (isCA)
+        snprintf(cert.subject.commonName, CTC_NAME_SIZE, "Bench CA %d", n);
+    else
+        strncpy(cert.subject.commonName, "localhost", CTC_NAME_SIZE);
+    strncpy(cert.subject.org, "wolfSSL", CTC_NAME_SIZE);
+    cert.isCA = isCA;
+    cert.sigType = CTC_SHA256wECDSA;
+
+    ret = wc_SetSubjectKeyIdFromPublicKey_ex(&cert, ECC_TYPE, &c->key);
+    /* chain CAs need keyCertSign to be added as signers */
+    if (ret == 0 && isCA)
+        ret = wc_SetKeyUsage(&cert, "keyCertSign,cRLSign");
+    if (ret == 0 && issuer != NULL) {
+        ret = wc_SetIssuerBuffer(&cert, issuer->der, issuer->derSz);
+        if (ret == 0)
+            ret = wc_SetAuthKeyIdFromCert(&cert, issuer->der, issuer->derSz);
+    }
+    else if (ret == 0) {
+        cert.selfSigned = 1;
+        ret = wc_SetAuthKeyIdFromPublicKey_ex(&cert, ECC_TYPE, &c->key);
+    }
+    if (ret == 0)
+        ret = wc_MakeCert(&cert, c->der, BENCH_CERT_SZ, NULL, &c->key, rng);
+    if (ret > 0)
+        ret = wc_SignCert(cert.bodySz, cert.sigType, c->der, BENCH_CERT_SZ,
+                          NULL, signKey, rng);
+    if (ret <= 0)
+        return ret < 0 ? ret : -1;
+
+    c->derSz = ret;
+    return 0;
+}
+
+/* One client/server handshake over memory, adds the client's CPU time to
+ * cliTime. Returns 0 on success */
+static int bench_handshake(WOLFSSL_CTX* cliCtx, WOLFSSL_CTX* srvCtx,
+                           double* cliTime)
+{
+    int ret = -1;
+    int cliDone = 0, srvDone = 0;
+    int loops;
+    double start;
+    WOLFSSL* cli = NULL;
+    WOLFSSL* srv = NULL;
+    MemSide cliSide, srvSide;
+
+    memset(&conn, 0, sizeof(conn));
+    cliSide.in  = &conn.toClient;
+    cliSide.out = &conn.toServer;
+    srvSide.in  = &conn.toServer;
+    srvSide.out = &conn.toClient;
+
+    cli = wolfSSL_new(cliCtx);
+    srv = wolfSSL_new(srvCtx);
+    if (cli == NULL || srv == NULL)
+        goto exit;
+
+    wolfSSL_SetIOReadCtx(cli, &cliSide);
+    wolfSSL_SetIOWriteCtx(cli, &cliSide);
+    wolfSSL_SetIOReadCtx(srv, &srvSide);
+    wolfSSL_SetIOWriteCtx(srv, &srvSide);
+
+    for (loops = 0; loops < 100 && !(cliDone && srvDone); loops++) {
+        int err;
+
+        if (!cliDone) {
+            start = cpu_sec();
+            if (wolfSSL_connect(cli) == WOLFSSL_SUCCESS)
+                cliDone = 1;
+            else if ((err = wolfSSL_get_error(cli, 0)) !=
+                                                WOLFSSL_ERROR_WANT_READ) {
+                fprintf(stderr, "connect error %d\n", err);
+                goto exit;
+            }
+            *cliTime += cpu_sec() - start;
+        }
+        if (!srvDone) {
+            if (wolfSSL_accept(srv) == WOLFSSL_SUCCESS)
+                srvDone = 1;
+            else if ((err = wolfSSL_get_error(srv, 0)) !=
+                                                WOLFSSL_ERROR_WANT_READ) {
+                fprintf(stderr, "accept error %d\n", err);
+                goto exit;
+            }
+        }
+    }
+    if (cliDone && srvDone)
+        ret = 0;
+
+exit:
+    wolfSSL_free(cli);
+    wolfSSL_free(srv);
+    return ret;
+}
+
+int main(int argc, char** argv)
+{
+    int handshakes = BENCH_DEF_HANDSHAKES;
+    int depth = BENCH_DEF_DEPTH;
+    int version = 3;
+    int i, n, ret = 0;
+    BenchCert* certs;
+    byte* chain;
+    int chainSz = 0;
+    byte key[ECC_BUFSIZE];
+    int keySz;
+    WC_RNG rng;
+    WOLFSSL_CTX* cliCtx;
+    WOLFSSL_CTX* srvCtx;
+    WOLFSSL_CERT_MANAGER* cm;
+    double cold = 0, warm = 0;
+
+    for (i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "-n") == 0)
+            handshakes = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-d") == 0)
+            depth = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-v") == 0)
+            version = atoi(argv[i + 1]);
+        else
+            break;
+    }
+    if (i < argc || handshakes <= 0 || depth < 0 || depth > BENCH_MAX_DEPTH ||
+            (version != 2 && version != 3)) {
+        printf("usage: %s [-n handshakes] [-d intermediates] [-v 2|3]\n",
+               argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    wolfSSL_Init();
+
+    /* certs[0] is the root, certs[depth + 1] the server */
+    certs = (BenchCert*)malloc((depth + 2) * sizeof(BenchCert));
+    chain = (byte*)malloc((depth + 1) * BENCH_CERT_SZ);
+    if (certs == NULL || chain == NULL || wc_InitRng(&rng) != 0) {
+        fprintf(stderr, "Setup failed\n");
+        return EXIT_FAILURE;
+    }
+    for (i = 0; i < depth + 2 && ret == 0; i++) {
+        ret = make_cert(i, i <= depth, &certs[i], i > 0 ? &certs[i - 1] : NULL,
+                        &rng);
+    }
+    /* server cert first, then the intermediates up to the root */
+    for (i = depth + 1; i > 0 && ret == 0; i--) {
+        memcpy(chain + chainSz, certs[i].der, certs[i].derSz);
+        chainSz += certs[i].derSz;
+    }
+    keySz = (ret == 0) ?
+        wc_EccKeyToDer(&certs[depth + 1].key, key, sizeof(key)) : -1;
+    if (keySz <= 0) {
+        fprintf(stderr, "Making chain failed %d\n", ret);
+        return EXIT_FAILURE;
+    }
+
+#ifdef WOLFSSL_TLS13
+    if (version == 3) {
+        cliCtx = wolfSSL_CTX_new(wolfTLSv1_3_client_method());
+        srvCtx = wolfSSL_CTX_new(wolfTLSv1_3_server_method());
+    }
+    else
+#endif
+    {
+        cliCtx = wolfSSL_CTX_new(wolfTLSv1_2_client_method());
+        srvCtx = wolfSSL_CTX_new(wolfTLSv1_2_server_method());
+        version = 2;
+    }
+    if (cliCtx == NULL || srvCtx == NULL ||
+        wolfSSL_CTX_use_certificate_chain_buffer_format(srvCtx, chain,
+                chainSz, WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS ||
+        wolfSSL_CTX_use_PrivateKey_buffer(srvCtx, key, keySz,
+                WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS ||
+        wolfSSL_CTX_load_verify_buffer(cliCtx, certs[0].der, certs[0].derSz,
+                WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS ||
+        (version == 2 &&
+         wolfSSL_CTX_set_cipher_list(cliCtx, BENCH_CIPHER)
+                                                    != WOLFSSL_SUCCESS)) {
+        fprintf(stderr, "CTX setup failed\n");
+        return EXIT_FAILURE;
+    }
+    wolfSSL_CTX_set_verify(cliCtx, WOLFSSL_VERIFY_PEER, NULL);
+    wolfSSL_SetIORecv(cliCtx, MemRecv);
+    wolfSSL_SetIOSend(cliCtx, MemSend);
+    wolfSSL_SetIORecv(srvCtx, MemRecv);
+    wolfSSL_SetIOSend(srvCtx, MemSend);
+    cm = wolfSSL_CTX_GetCertManager(cliCtx);
+
+    /* cold: every handshake verifies the whole chain */
+    for (n = 0; n < handshakes && ret == 0; n++) {
+        wolfSSL_CertManagerFlushChainCache(cm);
+        ret = bench_handshake(cliCtx, srvCtx, &cold);
+    }
+    /* warm: the chain from the last cold handshake is cached */
+    for (n = 0; n < handshakes && ret == 0; n++)
+        ret = bench_handshake(cliCtx, srvCtx, &warm);
+
+    if (ret == 0) {
+        printf("TLS 1.%d handshakes: %d per run, chain of %d certs "
+               "(%d intermediates)\n", version, handshakes, depth + 2, depth);
+        printf("chain cache  client CPU us/handshake\n");
+        printf("cold         %10.1f\n", cold * 1000000 / handshakes);
+        printf("warm         %10.1f\n", warm * 1000000 / handshakes);
+    }
+
+    wolfSSL_CTX_free(cliCtx);
+    wolfSSL_CTX_free(srvCtx);
+    for (i = 0; i < depth + 2; i++)
+        wc_ecc_free(&certs[i].key);
+    wc_FreeRng(&rng);
+    free(chain);
+    free(certs);
+    wolfSSL_Cleanup();
+
+    if (ret != 0)
+        fprintf(stderr, "Benchmark failed %d\n", ret);
+    return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,366 @@
+/* crl_bench.c
+ *
+ * Copyright (C) 2006-2020 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* CRL load and lookup benchmark (Linux)
+ *
+ * Makes an ECC CA and a CRL it signs with N revoked 16 byte serials, then
+ * reports the time to load the DER CRL and the average CRL check time for
+ * revoked and good serials, for N from 1k to 1M. With WOLFSSL_CRL_INDEX the
+ * CRL is also saved with wolfSSL_CertManagerSaveCRLIndex() and the time to
+ * load the index (no parse) is shown, so builds with and without the option
+ * can be compared.
+ *
+ * CheckCertCRL() is a library internal, so build against a static host build
+ * of the library (HAVE_CRL, WOLFSSL_CERT_GEN and WOLFSSL_CERT_EXT), e.g.:
+ *   gcc -O2 -DWOLFSSL_USER_SETTINGS -I<user_settings dir> -I<wolfssl root> \
+ *       examples/benchmark/crl_bench.c libwolfssl.a -lm -o crl_bench
+ *
+ * Usage: crl_bench [-t seconds per lookup run] [-n max entries]
+ */
+
+#ifdef HAVE_CONFIG_H
+    #include <config.h>
+#endif
+#ifndef WOLFSSL_USER_SETTINGS
+    #include <wolfssl/options.h>
+#endif
+#include <wolfssl/wolfcrypt/settings.h>
+#include <wolfssl/ssl.h>
+#include <wolfssl/internal.h>
+#include <wolfssl/crl.h>
+#include <wolfssl/error-ssl.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+#include <wolfssl/wolfcrypt/asn.h>
+#include <wolfssl/wolfcrypt/asn_public.h>
+#include <wolfssl/wolfcrypt/ecc.h>
+#include <wolfssl/wolfcrypt/sha256.h>
+#include <wolfssl/wolfcrypt/random.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_DEF_SECS      1
+#define BENCH_MIN_ENTRIES   1000
+#define BENCH_DEF_ENTRIES   1000000
+#define BENCH_SERIAL_SZ     16
+#define BENCH_ENTRY_SZ      (2 + 2 + BENCH_SERIAL_SZ + 2 + 13)
+#define BENCH_CERT_SZ       1024
+
+static const byte ecdsaSha256Algo[] = {
+    0x30, 0x0a, 0x06, 0x08, 0x2a, 0x86, 0x48, 0xce, 0x3d, 0x04, 0x03, 0x02
+};
+static const char thisUpdate[] = "260101000000Z";    /* UTCTime */
+static const char nextUpdate[] = "20991231000000Z";  /* GeneralizedTime */
+
+static byte caDer[BENCH_CERT_SZ];
+static int  caDerSz;
+static byte caName[256];
+static int  caNameSz;
+static byte caHash[SIGNER_DIGEST_SIZE];
+
+static double now_sec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+}
+
+/* Serial of revoked entry i, good serials are odd i */
+static void make_serial(word32 i, byte* serial)
+{
+    word64 x = (word64)i * 0x9E3779B97F4A7C15ULL;
+    int j;
+
+    for (j = 0; j < BENCH_SERIAL_SZ; j++) {
+        x ^= x >> 29;
+        x *= 0xBF58476D1CE4E5B9ULL;
+        serial[j] = (byte)(x >> 56);
+    }
+    serial[0] = (byte)((serial[0] & 0x7f) | 0x01); /* positive, no pad */
+}
+
+static word32 put_hdr(byte* out, byte tag, word32 len)
+{
+    word32 i = 0;
+
+    out[i++] = tag;
+    if (len < 0x80)
+        out[i++] = (byte)len;
+    else if (len < 0x100) {
+        out[i++] = 0x81;
+        out[i++] = (byte)len;
+    }
+    else if (len < 0x10000) {
+        out[i++] = 0x82;
+        out[i++] = (byte)(len >> 8);
+        out[i++] = (byte)len;
+    }
+    else if (len < 0x1000000) {
+        out[i++] = 0x83;
+        out[i++] = (byte)(len >> 16);
+        out[i++] = (byte)(len >> 8);
+        out[i++] = (byte)len;
+    }
+    else {
+        out[i++] = 0x84;
+        out[i++] = (byte)(len >> 24);
+        out[i++] = (byte)(len >> 16);
+        out[i++] = (byte)(len >> 8);
+        out[i++] = (byte)len;
+    }
+
+    return i;
+}
+
+static int make_ca(ecc_key* key, WC_RNG* rng)
+{
+    Cert cert;
+    DecodedCert dCert;
+    int ret;
+
+    wc_InitCert(&cert);
+    strncpy(cert.subject.commonName, "CRL Bench CA", CTC_NAME_SIZE);
+    strncpy(cert.subject.org, "wolfSSL", CTC_NAME_SIZE);
+    cert.isCA = 1;
+    cert.selfSigned = 1;
+    cert.sigType = CTC_SHA256wECDSA;
+    if (wc_SetKeyUsage(&cert, "keyCertSign,cRLSign") != 0)
+        return -1;
+
+    ret = wc_MakeCert(&cert, caDer, sizeof(caDer), NULL, key, rng);
+    if (ret > 0)
+        ret = wc_SignCert(cert.bodySz, cert.sigType, caDer, sizeof(caDer),
+                          NULL, key, rng);
+    if (ret <= 0)
+        return ret;
+    caDerSz = ret;
+
+    InitDecodedCert(&dCert, caDer, (word32)caDerSz, NULL);
+    ret = ParseCert(&dCert, CERT_TYPE, NO_VERIFY, NULL);
+    if (ret == 0) {
+        caNameSz = (int)put_hdr(caName, ASN_SEQUENCE | ASN_CONSTRUCTED,
+                                dCert.subjectRawLen);
+        memcpy(caName + caNameSz, dCert.subjectRaw, dCert.subjectRawLen);
+        caNameSz += dCert.subjectRawLen;
+        memcpy(caHash, dCert.subjectHash, SIGNER_DIGEST_SIZE);
+    }
+    FreeDecodedCert(&dCert);
+
+    return ret;
+}
+
+/* Makes a signed DER CRL with entries revoked serials, returns size or < 0 */
+static long make_crl(int entries, ecc_key* key, WC_RNG* rng, byte* out)
+{
+    word32 listSz = (word32)entries * BENCH_ENTRY_SZ;
+    word32 tbsSz, hdrSz, idx, i;
+    byte   hash[WC_SHA256_DIGEST_SIZE];
+    byte   sig[MAX_ENCODED_SIG_SZ];
+    word32 sigSz = sizeof(sig);
+    byte*  tbs;
+
+    tbsSz = 3 + sizeof(ecdsaSha256Algo) + caNameSz + 2 + 13 + 2 + 15;
+    tbsSz += put_hdr(hash, ASN_SEQUENCE | ASN_CONSTRUCTED, listSz) + listSz;
+
+    /* room for the outer header, filled in last */
+    tbs = out + 16;
+    idx = put_hdr(tbs, ASN_SEQUENCE | ASN_CONSTRUCTED, tbsSz);
+    tbs[idx++] = ASN_INTEGER; tbs[idx++] = 1; tbs[idx++] = 1; /* v2 */
+    memcpy(tbs + idx, ecdsaSha256Algo, sizeof(ecdsaSha256Algo));
+    idx += sizeof(ecdsaSha256Algo);
+    memcpy(tbs + idx, caName, caNameSz);
+    idx += caNameSz;
+    idx += put_hdr(tbs + idx, ASN_UTC_TIME, 13);
+    memcpy(tbs + idx, thisUpdate, 13);
+    idx += 13;
+    idx += put_hdr(tbs + idx, ASN_GENERALIZED_TIME, 15);
+    memcpy(tbs + idx, nextUpdate, 15);
+    idx += 15;
+    idx += put_hdr(tbs + idx, ASN_SEQUENCE | ASN_CONSTRUCTED, listSz);
+    for (i = 0; i < (word32)entries; i++) {
+        idx += put_hdr(tbs + idx, ASN_SEQUENCE | ASN_CONSTRUCTED,
+                       BENCH_ENTRY_SZ - 2);
+        idx += put_hdr(tbs + idx, ASN_INTEGER, BENCH_SERIAL_SZ);
+        make_serial(2 * i, tbs + idx);
+        idx += BENCH_SERIAL_SZ;
+        idx += put_hdr(tbs + idx, ASN_UTC_TIME, 13);
+        memcpy(tbs + idx, thisUpdate, 13);
+        idx += 13;
+    }
+    tbsSz = idx;
+
+    if (wc_Sha256Hash(tbs, tbsSz, hash) != 0 ||
+            wc_ecc_sign_hash(hash, sizeof(hash), sig, &sigSz, rng, key) != 0)
+        return -1;
+
+    memcpy(tbs + idx, ecdsaSha256Algo, sizeof(ecdsaSha256Algo));
+    idx += sizeof(ecdsaSha256Algo);
+    idx += put_hdr(tbs + idx, ASN_BIT_STRING, sigSz + 1);
+    tbs[idx++] = 0;
+    memcpy(tbs + idx, sig, sigSz);
+    idx += sigSz;
+
+    hdrSz = put_hdr(hash, ASN_SEQUENCE | ASN_CONSTRUCTED, idx);
+    memmove(out + hdrSz, tbs, idx);
+    memcpy(out, hash, hdrSz);
+
+    return (long)(idx + hdrSz);
+}
+
+/* Average CRL check time in ns, good serials when good is set */
+static double bench_lookup(WOLFSSL_CERT_MANAGER* cm, int entries, int good,
+                           int secs)
+{
+    DecodedCert cert;
+    double start, elapsed;
+    long   n = 0;
+    word32 i = 1;
+    int    expect = good ? 0 : CRL_CERT_REVOKED;
+
+    memset(&cert, 0, sizeof(cert));
+    memcpy(cert.issuerHash, caHash, SIGNER_DIGEST_SIZE);
+    cert.serialSz = BENCH_SERIAL_SZ;
+
+    start = now_sec();
+    do {
+        int k;
+
+        for (k = 0; k < 16; k++) {
+            i = (i * 1103515245 + 12345) & 0x7fffffff;
+            make_serial(2 * (i % entries) + (good ? 1 : 0), cert.serial);
+            if (CheckCertCRL(cm->crl, &cert) != expect) {
+                fprintf(stderr, "Unexpected CRL check result\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        n += k;
+        elapsed = now_sec() - start;
+    } while (elapsed < secs);
+
+    return elapsed * 1000000000.0 / n;
+}
+
+int main(int argc, char** argv)
+{
+    int secs = BENCH_DEF_SECS;
+    int maxEntries = BENCH_DEF_ENTRIES;
+    int i, entries;
+    byte* crl;
+    long crlSz;
+    ecc_key key;
+    WC_RNG rng;
+    WOLFSSL_CERT_MANAGER* cm;
+    double start, load, revoked, good;
+
+    for (i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "-t") == 0)
+            secs = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-n") == 0)
+            maxEntries = atoi(argv[i + 1]);
+        else
+            break;
+    }
+    if (i < argc || secs <= 0 || maxEntries < BENCH_MIN_ENTRIES) {
+        printf("usage: %s [-t seconds] [-n max entries]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    wolfSSL_Init();
+
+    crl = (byte*)malloc((size_t)maxEntries * BENCH_ENTRY_SZ + 1024);
+    if (crl == NULL || wc_InitRng(&rng) != 0 || wc_ecc_init(&key) != 0 ||
+            wc_ecc_make_key(&rng, 32, &key) != 0 || make_ca(&key, &rng) != 0) {
+        fprintf(stderr, "Setup failed\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("CRL revoked serials: %s\n",
+#ifdef WOLFSSL_CRL_INDEX
+           "sorted table"
+#else
+           "list"
+#endif
+           );
+    printf("  entries  DER load ms  index load ms  revoked ns  good ns\n");
+
+    for (entries = BENCH_MIN_ENTRIES; entries <= maxEntries; entries *= 10) {
+        double indexLoad = 0;
+
+        crlSz = make_crl(entries, &key, &rng, crl);
+        cm = wolfSSL_CertManagerNew();
+        if (crlSz <= 0 || cm == NULL ||
+                wolfSSL_CertManagerLoadCABuffer(cm, caDer, caDerSz,
+                    WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS ||
+                wolfSSL_CertManagerEnableCRL(cm, 0) != WOLFSSL_SUCCESS) {
+            fprintf(stderr, "CRL setup failed\n");
+            return EXIT_FAILURE;
+        }
+
+        start = now_sec();
+        if (wolfSSL_CertManagerLoadCRLBuffer(cm, crl, crlSz,
+                WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS) {
+            fprintf(stderr, "CRL load failed\n");
+            return EXIT_FAILURE;
+        }
+        load = (now_sec() - start) * 1000;
+
+    #ifdef WOLFSSL_CRL_INDEX
+        {
+            /* save the index over the DER CRL buffer and load it back */
+            word32 indexSz = 0;
+
+            if (wolfSSL_CertManagerSaveCRLIndex(cm, NULL, &indexSz) !=
+                    LENGTH_ONLY_E || indexSz > (word32)crlSz + 1024 ||
+                    wolfSSL_CertManagerSaveCRLIndex(cm, crl, &indexSz) !=
+                    WOLFSSL_SUCCESS) {
+                fprintf(stderr, "CRL index save failed\n");
+                return EXIT_FAILURE;
+            }
+            wolfSSL_CertManagerFreeCRL(cm);
+            wolfSSL_CertManagerEnableCRL(cm, 0);
+            start = now_sec();
+            if (wolfSSL_CertManagerLoadCRLIndex(cm, crl, indexSz) !=
+                    WOLFSSL_SUCCESS) {
+                fprintf(stderr, "CRL index load failed\n");
+                return EXIT_FAILURE;
+            }
+            indexLoad = (now_sec() - start) * 1000;
+        }
+    #endif
+
+        revoked = bench_lookup(cm, entries, 0, secs);
+        good = bench_lookup(cm, entries, 1, secs);
+        printf("%9d %12.1f %14.2f %11.0f %8.0f\n", entries, load, indexLoad,
+               revoked, good);
+
+        wolfSSL_CertManagerFree(cm);
+    }
+
+    wc_ecc_free(&key);
+    wc_FreeRng(&rng);
+    free(crl);
+    wolfSSL_Cleanup();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,455 @@
+/* mem_bench.c
+ *
+ * Copyright (C) 2006-2020 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* Static memory handshake benchmark (Linux)
+ *
+ * Runs client/server handshakes over memory buffers with each side's CTX on
+ * its own static memory pool, in three layouts:
+ *   general - general buckets only (WOLFMEM_GENERAL)
+ *   arena   - general buckets plus handshake arenas (WOLFMEM_ARENA)
+ *   sys     - handshake arenas only, the rest from malloc
+ * For each layout the handshakes/sec and, per connection, the allocations,
+ * peak bytes, arena allocations, arena peak and system heap allocations are
+ * reported. With -p the allocations of the last handshake are printed per
+ * phase (connectState / acceptState value) with the top call sites.
+ *
+ * The layouts take turns in rounds of BENCH_ROUND handshakes after one
+ * untimed handshake each, and the rate is from process CPU time. Run one
+ * after the other on wall clock time, the first layout also paid for the
+ * cache warm-up and any other load on the system skewed one layout only.
+ *
+ * Build against a host build of the library, for example:
+ *   gcc -O2 -DWOLFSSL_USER_SETTINGS -I<user_settings dir> -I<wolfssl root> \
+ *       examples/benchmark/mem_bench.c libwolfssl.a -lpthread -lm \
+ *       -o mem_bench
+ *
+ * Needs WOLFSSL_STATIC_MEMORY and WOLFSSL_MEM_PROFILE. Build the library
+ * with WOLFSSL_DEBUG_MEMORY too for function:line call sites, otherwise sites
+ * are DYNAMIC_TYPE_ values.
+ *
+ * Usage: mem_bench [-n handshakes] [-v 2|3] [-p 0|1]
+ */
+
+#ifdef HAVE_CONFIG_H
+    #include <config.h>
+#endif
+#ifndef WOLFSSL_USER_SETTINGS
+    #include <wolfssl/options.h>
+#endif
+#include <wolfssl/wolfcrypt/settings.h>
+#include <wolfssl/ssl.h>
+#include <wolfssl/wolfio.h>
+#include <wolfssl/wolfcrypt/memory.h>
+#include <wolfssl/wolfcrypt/error-crypt.h>
+#include <wolfssl/certs_test.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if !defined(WOLFSSL_STATIC_MEMORY) || !defined(WOLFSSL_MEM_PROFILE)
+    #error mem_bench needs WOLFSSL_STATIC_MEMORY and WOLFSSL_MEM_PROFILE
+#endif
+
+#define BENCH_DEF_HANDSHAKES 100
+#define BENCH_ROUND         10
+#define BENCH_BUF_SZ        (32 * 1024)
+#define BENCH_GENERAL_SZ    (512 * 1024)
+#define BENCH_ARENAS        2
+#define BENCH_ARENA_POOL_SZ (BENCH_ARENAS * (WOLFMEM_ARENA_SZ + 256) + 1024)
+#define BENCH_TOP_SITES     8
+#define BENCH_CIPHER        "ECDHE-ECDSA-AES128-GCM-SHA256"
+
+/* one direction of the memory transport */
+typedef struct MemPipe {
+    unsigned char buf[BENCH_BUF_SZ];
+    int len;
+    int pos;
+} MemPipe;
+
+typedef struct MemConn {
+    MemPipe toServer;
+    MemPipe toClient;
+} MemConn;
+
+typedef struct MemSide {
+    MemPipe* in;
+    MemPipe* out;
+} MemSide;
+
+/* static memory layout of a run */
+typedef struct BenchLayout {
+    const char* name;
+    int general;
+    int arena;
+} BenchLayout;
+
+static const BenchLayout layouts[] = {
+    { "general", 1, 0 },
+    { "arena",   1, 1 },
+    { "sys",     0, 1 },
+};
+#define BENCH_LAYOUTS  (int)(sizeof(layouts) / sizeof(layouts[0]))
+#define BENCH_POOLS_SZ (2 * (BENCH_GENERAL_SZ + BENCH_ARENA_POOL_SZ))
+
+/* state of a layout's run */
+typedef struct BenchRun {
+    WOLFSSL_CTX* cliCtx;
+    WOLFSSL_CTX* srvCtx;
+    double       cpu; /* seconds of timed handshakes */
+    int          handshakes;
+    WOLFSSL_MEM_CONN_PROFILE cliProf;
+    WOLFSSL_MEM_CONN_PROFILE srvProf;
+} BenchRun;
+
+static MemConn conn;
+
+
+static int MemRecv(WOLFSSL* ssl, char* buf, int sz, void* ctx)
+{
+    MemPipe* p = ((MemSide*)ctx)->in;
+
+    (void)ssl;
+
+    if (p->pos == p->len)
+        return WOLFSSL_CBIO_ERR_WANT_READ;
+    if (sz > p->len - p->pos)
+        sz = p->len - p->pos;
+    memcpy(buf, p->buf + p->pos, sz);
+    p->pos += sz;
+    if (p->pos == p->len)
+        p->pos = p->len = 0;
+
+    return sz;
+}
+
+static int MemSend(WOLFSSL* ssl, char* buf, int sz, void* ctx)
+{
+    MemPipe* p = ((MemSide*)ctx)->out;
+
+    (void)ssl;
+
+    if (sz > BENCH_BUF_SZ - p->len)
+        sz = BENCH_BUF_SZ - p->len;
+    if (sz == 0)
+        return WOLFSSL_CBIO_ERR_WANT_WRITE;
+    memcpy(p->buf + p->len, buf, sz);
+    p->len += sz;
+
+    return sz;
+}
+
+static double cpu_sec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+}
+
+/* Loads the layout's pools into a new CTX, returns NULL on error */
+static WOLFSSL_CTX* bench_ctx(const BenchLayout* l, wolfSSL_method_func method,
+                              unsigned char* general, unsigned char* arena)
+{
+    WOLFSSL_CTX* ctx = NULL;
+
+    if (l->general && wolfSSL_CTX_load_static_memory(&ctx, method, general,
+                BENCH_GENERAL_SZ, WOLFMEM_GENERAL | WOLFMEM_TRACK_PROFILE,
+                1) != WOLFSSL_SUCCESS) {
+        return NULL;
+    }
+    if (l->arena && wolfSSL_CTX_load_static_memory(&ctx, method, arena,
+                BENCH_ARENA_POOL_SZ, WOLFMEM_ARENA | WOLFMEM_TRACK_PROFILE,
+                BENCH_ARENAS) != WOLFSSL_SUCCESS) {
+        wolfSSL_CTX_free(ctx);
+        return NULL;
+    }
+    wolfSSL_SetIORecv(ctx, MemRecv);
+    wolfSSL_SetIOSend(ctx, MemSend);
+
+    return ctx;
+}
+
+/* One client/server handshake over memory, the profiles of both sides are
+ * saved in run before the connections are freed. Returns 0 on success */
+static int bench_handshake(BenchRun* run)
+{
+    int ret = -1;
+    int cliDone = 0, srvDone = 0;
+    int loops;
+    WOLFSSL* cli = NULL;
+    WOLFSSL* srv = NULL;
+    MemSide cliSide, srvSide;
+
+    memset(&conn, 0, sizeof(conn));
+    cliSide.in  = &conn.toClient;
+    cliSide.out = &conn.toServer;
+    srvSide.in  = &conn.toServer;
+    srvSide.out = &conn.toClient;
+
+    cli = wolfSSL_new(run->cliCtx);
+    srv = wolfSSL_new(run->srvCtx);
+    if (cli == NULL || srv == NULL)
+        goto exit;
+
+    wolfSSL_SetIOReadCtx(cli, &cliSide);
+    wolfSSL_SetIOWriteCtx(cli, &cliSide);
+    wolfSSL_SetIOReadCtx(srv, &srvSide);
+    wolfSSL_SetIOWriteCtx(srv, &srvSide);
+
+    for (loops = 0; loops < 100 && !(cliDone && srvDone); loops++) {
+        int err;
+
+        if (!cliDone) {
+            if (wolfSSL_connect(cli) == WOLFSSL_SUCCESS)
+                cliDone = 1;
+            else if ((err = wolfSSL_get_error(cli, 0)) !=
+                                                WOLFSSL_ERROR_WANT_READ) {
+                fprintf(stderr, "connect error %d\n", err);
+                goto exit;
+            }
+        }
+        if (!srvDone) {
+            if (wolfSSL_accept(srv) == WOLFSSL_SUCCESS)
+                srvDone = 1;
+            else if ((err = wolfSSL_get_error(srv, 0)) !=
+                                                WOLFSSL_ERROR_WANT_READ) {
+                fprintf(stderr, "accept error %d\n", err);
+                goto exit;
+            }
+        }
+    }
+    if (cliDone && srvDone &&
+            wolfSSL_GetMemProfile(cli, &run->cliProf) == 1 &&
+            wolfSSL_GetMemProfile(srv, &run->srvProf) == 1) {
+        ret = 0;
+    }
+
+exit:
+    wolfSSL_free(cli);
+    wolfSSL_free(srv);
+    return ret;
+}
+
+/* the test certs may be out of date, the rest of the checks still apply */
+static int VerifyDate(int preverify, WOLFSSL_X509_STORE_CTX* store)
+{
+    if (!preverify && (store->error == ASN_BEFORE_DATE_E ||
+                       store->error == ASN_AFTER_DATE_E)) {
+        return 1;
+    }
+    return preverify;
+}
+
+static void print_row(const char* layout, const char* side, double rate,
+                      const WOLFSSL_MEM_CONN_PROFILE* p)
+{
+    printf("%-8s %-6s %9.1f %7u %9u %7u %9u %6u\n", layout, side, rate,
+           p->alloc, p->peakMem, p->arenaAlloc, p->arenaPeak, p->sysAlloc);
+}
+
+static int site_cmp(const void* a, const void* b)
+{
+    const WOLFSSL_MEM_SITE* x = (const WOLFSSL_MEM_SITE*)a;
+    const WOLFSSL_MEM_SITE* y = (const WOLFSSL_MEM_SITE*)b;
+
+    return (x->bytes < y->bytes) - (x->bytes > y->bytes);
+}
+
+static void print_profile(const char* side, const WOLFSSL_MEM_CONN_PROFILE* p)
+{
+    WOLFSSL_MEM_SITE sites[WOLFMEM_PROFILE_SITES];
+    int i;
+
+    printf("\n%s allocations by phase\n", side);
+    printf("  phase  allocs     bytes   peak bytes\n");
+    for (i = 0; i < WOLFMEM_PROFILE_PHASES; i++) {
+        if (p->phase[i].alloc == 0)
+            continue;
+        printf("  %5d %7u %9u %12u\n", i, p->phase[i].alloc,
+               p->phase[i].bytes, p->phase[i].peakMem);
+    }
+
+    memcpy(sites, p->site, sizeof(sites));
+    qsort(sites, WOLFMEM_PROFILE_SITES, sizeof(sites[0]), site_cmp);
+    printf("%s top call sites\n", side);
+    printf("  phase  allocs     bytes  site\n");
+    for (i = 0; i < BENCH_TOP_SITES && sites[i].alloc > 0; i++) {
+        if (sites[i].func != NULL)
+            printf("  %5d %7u %9u  %s:%u\n", sites[i].phase, sites[i].alloc,
+                   sites[i].bytes, sites[i].func, sites[i].line);
+        else
+            printf("  %5d %7u %9u  type %u\n", sites[i].phase,
+                   sites[i].alloc, sites[i].bytes, sites[i].line);
+    }
+}
+
+/* Sets up the CTXs of layout l on pools, returns 0 on success */
+static int bench_setup(const BenchLayout* l, BenchRun* run,
+                       wolfSSL_method_func cliMethod,
+                       wolfSSL_method_func srvMethod, int version,
+                       unsigned char* pools)
+{
+    memset(pools, 0, BENCH_POOLS_SZ);
+    run->cliCtx = bench_ctx(l, cliMethod, pools, pools + BENCH_GENERAL_SZ);
+    run->srvCtx = bench_ctx(l, srvMethod,
+                            pools + BENCH_GENERAL_SZ + BENCH_ARENA_POOL_SZ,
+                            pools + 2 * BENCH_GENERAL_SZ + BENCH_ARENA_POOL_SZ);
+    if (run->cliCtx == NULL || run->srvCtx == NULL ||
+        wolfSSL_CTX_use_certificate_buffer(run->srvCtx, serv_ecc_der_256,
+            sizeof_serv_ecc_der_256, WOLFSSL_FILETYPE_ASN1)
+                                                    != WOLFSSL_SUCCESS ||
+        wolfSSL_CTX_use_PrivateKey_buffer(run->srvCtx, ecc_key_der_256,
+            sizeof_ecc_key_der_256, WOLFSSL_FILETYPE_ASN1)
+                                                    != WOLFSSL_SUCCESS ||
+        wolfSSL_CTX_load_verify_buffer_ex(run->cliCtx, ca_ecc_cert_der_256,
+            sizeof_ca_ecc_cert_der_256, WOLFSSL_FILETYPE_ASN1, 0,
+            WOLFSSL_LOAD_FLAG_DATE_ERR_OKAY) != WOLFSSL_SUCCESS ||
+        (version == 2 &&
+         wolfSSL_CTX_set_cipher_list(run->cliCtx, BENCH_CIPHER)
+                                                    != WOLFSSL_SUCCESS)) {
+        return -1;
+    }
+    wolfSSL_CTX_set_verify(run->cliCtx, WOLFSSL_VERIFY_PEER, VerifyDate);
+
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    int handshakes = BENCH_DEF_HANDSHAKES;
+    int version = 3;
+    int profile = 0;
+    int i, n, ret = 0;
+    unsigned char* pools;
+    wolfSSL_method_func cliMethod, srvMethod;
+    BenchRun runs[BENCH_LAYOUTS];
+
+    for (i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "-n") == 0)
+            handshakes = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-v") == 0)
+            version = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-p") == 0)
+            profile = atoi(argv[i + 1]);
+        else
+            break;
+    }
+    if (i < argc || handshakes <= 0 || (version != 2 && version != 3)) {
+        printf("usage: %s [-n handshakes] [-v 2|3] [-p 0|1]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+#ifdef WOLFSSL_TLS13
+    if (version == 3) {
+        cliMethod = wolfTLSv1_3_client_method_ex;
+        srvMethod = wolfTLSv1_3_server_method_ex;
+    }
+    else
+#endif
+    {
+        cliMethod = wolfTLSv1_2_client_method_ex;
+        srvMethod = wolfTLSv1_2_server_method_ex;
+        version = 2;
+    }
+
+    wolfSSL_Init();
+
+    /* general and arena pools of the client and the server, per layout */
+    pools = (unsigned char*)malloc(BENCH_LAYOUTS * BENCH_POOLS_SZ);
+    if (pools == NULL) {
+        fprintf(stderr, "Setup failed\n");
+        return EXIT_FAILURE;
+    }
+
+    memset(runs, 0, sizeof(runs));
+    for (i = 0; i < BENCH_LAYOUTS && ret == 0; i++) {
+        if (bench_setup(&layouts[i], &runs[i], cliMethod, srvMethod, version,
+                        pools + i * BENCH_POOLS_SZ) != 0) {
+            fprintf(stderr, "CTX setup failed for %s\n", layouts[i].name);
+            ret = -1;
+        }
+        /* untimed, warms up the caches and the library state */
+        else if ((ret = bench_handshake(&runs[i])) != 0) {
+            fprintf(stderr, "Warm-up handshake failed for %s\n",
+                    layouts[i].name);
+        }
+    }
+
+    /* layouts take turns so each sees the same system load */
+    for (n = 0; n < handshakes && ret == 0; n += BENCH_ROUND) {
+        for (i = 0; i < BENCH_LAYOUTS && ret == 0; i++) {
+            BenchRun* run = &runs[i];
+            double start = cpu_sec();
+            int k;
+
+            for (k = 0; k < BENCH_ROUND && n + k < handshakes && ret == 0;
+                                                                       k++) {
+                ret = bench_handshake(run);
+                run->handshakes++;
+            }
+            run->cpu += cpu_sec() - start;
+        }
+    }
+
+    if (ret == 0) {
+        printf("TLS 1.%d handshakes: %d per layout, arena size %d\n",
+               version, handshakes, WOLFMEM_ARENA_SZ);
+        printf("layout   side   hs/sec  allocs peak bytes  arena  "
+               "arena peak    sys\n");
+    }
+    for (i = 0; i < BENCH_LAYOUTS && ret == 0; i++) {
+        const BenchLayout* l = &layouts[i];
+        BenchRun* run = &runs[i];
+        WOLFSSL_MEM_STATS stats;
+        double rate = run->cpu > 0 ? run->handshakes / run->cpu : 0;
+
+        print_row(l->name, "client", rate, &run->cliProf);
+        print_row("", "server", rate, &run->srvProf);
+
+        /* every arena is back in the pool once the connections are gone */
+        if (l->arena &&
+                (wolfSSL_CTX_is_static_memory(run->cliCtx, &stats) != 1 ||
+                 stats.avaArena != BENCH_ARENAS ||
+                 wolfSSL_CTX_is_static_memory(run->srvCtx, &stats) != 1 ||
+                 stats.avaArena != BENCH_ARENAS)) {
+            fprintf(stderr, "Handshake arena not returned\n");
+            ret = -1;
+        }
+
+        if (ret == 0 && profile && i + 1 == BENCH_LAYOUTS) {
+            print_profile("Client", &run->cliProf);
+            print_profile("Server", &run->srvProf);
+        }
+    }
+
+    for (i = 0; i < BENCH_LAYOUTS; i++) {
+        wolfSSL_CTX_free(runs[i].cliCtx);
+        wolfSSL_CTX_free(runs[i].srvCtx);
+    }
+    free(pools);
+    wolfSSL_Cleanup();
+
+    if (ret != 0)
+        fprintf(stderr, "Benchmark failed %d\n", ret);
+    return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,333 @@
+/* send_bench.c
+ *
+ * Copyright (C) 2006-2020 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* TLS send throughput benchmark (Linux / pthreads)
+ *
+ * A client and a server thread do a TLS handshake over a local socket pair,
+ * then the client sends N MB of application data per run with wolfSSL_write()
+ * and wolfSSL_writev() in 1k to 256k writes. The send callback counts the
+ * send() calls, so MB/sec and send() calls per MB are reported and builds with
+ * and without WOLFSSL_SEND_COALESCE can be compared. With WOLFSSL_SEND_COALESCE
+ * the writes are also run with a caller output region set by
+ * wolfSSL_SetOutputBuffer().
+ *
+ * Build against a host build of the library, for example:
+ *   gcc -O2 -DWOLFSSL_USER_SETTINGS -I<user_settings dir> -I<wolfssl root> \
+ *       examples/benchmark/send_bench.c libwolfssl.a -lpthread -lm \
+ *       -o send_bench
+ *
+ * Usage: send_bench [-m MB per run] [-v 2|3]
+ */
+
+#ifdef HAVE_CONFIG_H
+    #include <config.h>
+#endif
+#ifndef WOLFSSL_USER_SETTINGS
+    #include <wolfssl/options.h>
+#endif
+#include <wolfssl/wolfcrypt/settings.h>
+#include <wolfssl/ssl.h>
+#include <wolfssl/wolfio.h>
+#include <wolfssl/certs_test.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#define BENCH_DEF_MB        64
+#define BENCH_MAX_WRITE     (256 * 1024)
+#define BENCH_READ_SZ       (16 * 1024)
+#define BENCH_IOV_CNT       4
+#define BENCH_OUT_SZ        (80 * 1024)  /* caller output region */
+#define BENCH_CIPHER        "ECDHE-ECDSA-AES128-GCM-SHA256"
+#define BENCH_CIPHER13      "TLS13-AES128-GCM-SHA256"
+
+static const int writeSizes[] = { 1024, 16 * 1024, 64 * 1024, 256 * 1024 };
+
+typedef struct BenchServer {
+    pthread_t tid;
+    WOLFSSL*  ssl;
+    long      runSz;
+    int       runs;
+    int       ret;
+} BenchServer;
+
+static long sendCalls;
+
+
+static double now_sec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+}
+
+/* default socket send, counting the calls */
+static int CountSend(WOLFSSL* ssl, char* buf, int sz, void* ctx)
+{
+    sendCalls++;
+    return EmbedSend(ssl, buf, sz, ctx);
+}
+
+/* Accepts, then reads runSz bytes and answers with one byte for each run */
+static void* server_thread(void* arg)
+{
+    BenchServer* s = (BenchServer*)arg;
+    unsigned char* buf;
+    unsigned char ack = 0;
+    int run;
+
+    buf = (unsigned char*)malloc(BENCH_READ_SZ);
+    if (buf == NULL || wolfSSL_accept(s->ssl) != WOLFSSL_SUCCESS) {
+        s->ret = -1;
+        free(buf);
+        return NULL;
+    }
+
+    for (run = 0; run < s->runs; run++) {
+        long got = 0;
+
+        while (got < s->runSz) {
+            int ret = wolfSSL_read(s->ssl, buf, BENCH_READ_SZ);
+            if (ret <= 0) {
+                s->ret = wolfSSL_get_error(s->ssl, ret);
+                free(buf);
+                return NULL;
+            }
+            got += ret;
+        }
+        if (wolfSSL_write(s->ssl, &ack, 1) != 1) {
+            s->ret = -1;
+            break;
+        }
+    }
+
+    free(buf);
+    return NULL;
+}
+
+/* Sends runSz bytes in writeSz writes, vectored when iov is set, and waits
+ * for the server to have read them. Returns 0 on success. */
+static int bench_run(WOLFSSL* ssl, const unsigned char* data, long runSz,
+                     int writeSz, int iov, double* mbSec, double* callsMb)
+{
+    double start, elapsed;
+    long left = runSz;
+    unsigned char ack;
+
+    sendCalls = 0;
+    start = now_sec();
+
+    while (left > 0) {
+        int sz = (left < writeSz) ? (int)left : writeSz;
+        int ret;
+
+    #ifndef NO_WRITEV
+        if (iov) {
+            struct iovec vec[BENCH_IOV_CNT];
+            int i, part = sz / BENCH_IOV_CNT;
+
+            for (i = 0; i < BENCH_IOV_CNT; i++) {
+                vec[i].iov_base = (void*)(data + i * part);
+                vec[i].iov_len  = (i == BENCH_IOV_CNT - 1) ?
+                                  (size_t)(sz - i * part) : (size_t)part;
+            }
+            ret = wolfSSL_writev(ssl, vec, BENCH_IOV_CNT);
+        }
+        else
+    #endif
+            ret = wolfSSL_write(ssl, data, sz);
+
+        if (ret != sz) {
+            fprintf(stderr, "write error %d\n", wolfSSL_get_error(ssl, ret));
+            return -1;
+        }
+        left -= sz;
+    }
+
+    if (wolfSSL_read(ssl, &ack, 1) != 1)
+        return -1;
+    elapsed = now_sec() - start;
+
+    *mbSec   = (double)runSz / (1024 * 1024) / elapsed;
+    *callsMb = (double)sendCalls / ((double)runSz / (1024 * 1024));
+
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    int mb = BENCH_DEF_MB;
+    int version = 2;
+    int i, w, mode, modes, ret = 0;
+    int sv[2];
+    long runSz;
+    unsigned char* data;
+    WOLFSSL_CTX* srvCtx;
+    WOLFSSL_CTX* cliCtx;
+    WOLFSSL* cli;
+    BenchServer srv;
+    double mbSec, callsMb;
+    static const char* modeNames[] = { "write", "writev", "write+outbuf" };
+#ifdef WOLFSSL_SEND_COALESCE
+    unsigned char* outBuf;
+#endif
+
+    for (i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "-m") == 0)
+            mb = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-v") == 0)
+            version = atoi(argv[i + 1]);
+        else
+            break;
+    }
+    if (i < argc || mb <= 0 || (version != 2 && version != 3)) {
+        printf("usage: %s [-m MB per run] [-v 2|3]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    runSz = (long)mb * 1024 * 1024;
+
+    modes = 1;
+#ifndef NO_WRITEV
+    modes = 2;
+#endif
+#ifdef WOLFSSL_SEND_COALESCE
+    modes = 3;
+#endif
+
+    wolfSSL_Init();
+
+    data = (unsigned char*)malloc(BENCH_MAX_WRITE);
+    if (data == NULL || socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) {
+        fprintf(stderr, "Setup failed\n");
+        return EXIT_FAILURE;
+    }
+    memset(data, 0xa5, BENCH_MAX_WRITE);
+
+#ifdef WOLFSSL_TLS13
+    if (version == 3) {
+        srvCtx = wolfSSL_CTX_new(wolfTLSv1_3_server_method());
+        cliCtx = wolfSSL_CTX_new(wolfTLSv1_3_client_method());
+    }
+    else
+#endif
+    {
+        version = 2;
+        srvCtx = wolfSSL_CTX_new(wolfTLSv1_2_server_method());
+        cliCtx = wolfSSL_CTX_new(wolfTLSv1_2_client_method());
+    }
+    if (srvCtx == NULL || cliCtx == NULL) {
+        fprintf(stderr, "CTX new failed\n");
+        return EXIT_FAILURE;
+    }
+    if (wolfSSL_CTX_use_certificate_buffer(srvCtx, serv_ecc_der_256,
+            sizeof_serv_ecc_der_256, WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS ||
+        wolfSSL_CTX_use_PrivateKey_buffer(srvCtx, ecc_key_der_256,
+            sizeof_ecc_key_der_256, WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS ||
+        wolfSSL_CTX_set_cipher_list(srvCtx, version == 3 ? BENCH_CIPHER13 :
+                                    BENCH_CIPHER) != WOLFSSL_SUCCESS) {
+        fprintf(stderr, "CTX setup failed\n");
+        return EXIT_FAILURE;
+    }
+    wolfSSL_CTX_set_verify(cliCtx, WOLFSSL_VERIFY_NONE, NULL);
+    wolfSSL_SetIOSend(cliCtx, CountSend);
+
+    memset(&srv, 0, sizeof(srv));
+    srv.ssl   = wolfSSL_new(srvCtx);
+    srv.runSz = runSz;
+    srv.runs  = modes * (int)(sizeof(writeSizes) / sizeof(writeSizes[0]));
+    cli = wolfSSL_new(cliCtx);
+    if (srv.ssl == NULL || cli == NULL ||
+            wolfSSL_set_fd(srv.ssl, sv[0]) != WOLFSSL_SUCCESS ||
+            wolfSSL_set_fd(cli, sv[1]) != WOLFSSL_SUCCESS) {
+        fprintf(stderr, "SSL setup failed\n");
+        return EXIT_FAILURE;
+    }
+    if (pthread_create(&srv.tid, NULL, server_thread, &srv) != 0) {
+        fprintf(stderr, "pthread_create failed\n");
+        return EXIT_FAILURE;
+    }
+    if (wolfSSL_connect(cli) != WOLFSSL_SUCCESS) {
+        fprintf(stderr, "connect error %d\n", wolfSSL_get_error(cli, 0));
+        return EXIT_FAILURE;
+    }
+
+    printf("TLS send: %s, TLS 1.%d %s, %d MB per run\n",
+#ifdef WOLFSSL_SEND_COALESCE
+           "coalesce",
+#else
+           "record per send",
+#endif
+           version, wolfSSL_get_cipher(cli), mb);
+    printf("        api  write sz     MB/sec  sends/MB\n");
+
+    for (mode = 0; mode < modes && ret == 0; mode++) {
+    #ifdef WOLFSSL_SEND_COALESCE
+        outBuf = NULL;
+        if (mode == 2) {
+            outBuf = (unsigned char*)malloc(BENCH_OUT_SZ);
+            if (outBuf == NULL || wolfSSL_SetOutputBuffer(cli, outBuf,
+                                         BENCH_OUT_SZ) != WOLFSSL_SUCCESS) {
+                fprintf(stderr, "SetOutputBuffer failed\n");
+                return EXIT_FAILURE;
+            }
+        }
+    #endif
+        for (w = 0; w < (int)(sizeof(writeSizes) / sizeof(writeSizes[0])) &&
+                    ret == 0; w++) {
+            ret = bench_run(cli, data, runSz, writeSizes[w], mode == 1,
+                            &mbSec, &callsMb);
+            if (ret == 0)
+                printf("%12s %8dk %10.1f %9.1f\n", modeNames[mode],
+                       writeSizes[w] / 1024, mbSec, callsMb);
+        }
+    #ifdef WOLFSSL_SEND_COALESCE
+        if (outBuf != NULL) {
+            wolfSSL_SetOutputBuffer(cli, NULL, 0);
+            free(outBuf);
+        }
+    #endif
+    }
+
+    if (ret != 0)
+        shutdown(sv[1], SHUT_RDWR);  /* unblock the server */
+    pthread_join(srv.tid, NULL);
+    if (ret == 0 && srv.ret != 0)
+        ret = srv.ret;
+
+    wolfSSL_free(cli);
+    wolfSSL_free(srv.ssl);
+    close(sv[0]);
+    close(sv[1]);
+    wolfSSL_CTX_free(cliCtx);
+    wolfSSL_CTX_free(srvCtx);
+    free(data);
+    wolfSSL_Cleanup();
+
+    if (ret != 0)
+        fprintf(stderr, "Benchmark failed %d\n", ret);
+    return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
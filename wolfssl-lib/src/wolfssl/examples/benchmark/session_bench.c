@@ -0,0 +1,365 @@
+/* session_bench.c
+ *
+ * Copyright (C) 2006-2020 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* Multi-threaded TLS session cache benchmark (Linux / pthreads)
+ *
+ * Each thread runs a client and a server over memory buffers. It does one
+ * full TLS 1.2 handshake per server ID, then resumes those sessions (client
+ * cache lookup by server ID, server cache lookup by session ID) for the run
+ * time. Resumptions/sec are reported for 1, 2, 4 and 8 threads, so builds with
+ * and without WOLFSSL_SESSION_CACHE_SHARDED can be compared.
+ *
+ * Build against a host build of the library, for example:
+ *   gcc -O2 -DWOLFSSL_USER_SETTINGS -I<user_settings dir> -I<wolfssl root> \
+ *       examples/benchmark/session_bench.c libwolfssl.a -lpthread -lm \
+ *       -o session_bench
+ *
+ * Use a cache big enough for threads * ids sessions (MEDIUM_SESSION_CACHE or
+ * -r/-c with the sharded cache), otherwise evictions show up as "full".
+ *
+ * Usage: session_bench [-t seconds] [-i ids per thread] [-r rows] [-c cols]
+ */
+
+#ifdef HAVE_CONFIG_H
+    #include <config.h>
+#endif
+#ifndef WOLFSSL_USER_SETTINGS
+    #include <wolfssl/options.h>
+#endif
+#include <wolfssl/wolfcrypt/settings.h>
+#include <wolfssl/ssl.h>
+#include <wolfssl/wolfio.h>
+#include <wolfssl/certs_test.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#define BENCH_MAX_THREADS   8
+#define BENCH_DEF_SECS      2
+#define BENCH_DEF_IDS       8
+#define BENCH_BUF_SZ        (16 * 1024)
+#define BENCH_CIPHER        "ECDHE-ECDSA-AES128-GCM-SHA256"
+
+/* one direction of the memory transport */
+typedef struct MemPipe {
+    unsigned char buf[BENCH_BUF_SZ];
+    int len;
+    int pos;
+} MemPipe;
+
+typedef struct MemConn {
+    MemPipe toServer;
+    MemPipe toClient;
+} MemConn;
+
+typedef struct MemSide {
+    MemPipe* in;
+    MemPipe* out;
+} MemSide;
+
+typedef struct BenchThread {
+    pthread_t tid;
+    int       id;
+    int       ids;
+    long      resumed;
+    long      full;
+    int       secs;
+    int       ret;
+} BenchThread;
+
+static WOLFSSL_CTX* srvCtx;
+static WOLFSSL_CTX* cliCtx;
+static pthread_barrier_t benchStart;
+
+
+static int MemRecv(WOLFSSL* ssl, char* buf, int sz, void* ctx)
+{
+    MemPipe* p = ((MemSide*)ctx)->in;
+
+    (void)ssl;
+
+    if (p->pos == p->len)
+        return WOLFSSL_CBIO_ERR_WANT_READ;
+    if (sz > p->len - p->pos)
+        sz = p->len - p->pos;
+    memcpy(buf, p->buf + p->pos, sz);
+    p->pos += sz;
+    if (p->pos == p->len)
+        p->pos = p->len = 0;
+
+    return sz;
+}
+
+static int MemSend(WOLFSSL* ssl, char* buf, int sz, void* ctx)
+{
+    MemPipe* p = ((MemSide*)ctx)->out;
+
+    (void)ssl;
+
+    if (sz > BENCH_BUF_SZ - p->len)
+        sz = BENCH_BUF_SZ - p->len;
+    if (sz == 0)
+        return WOLFSSL_CBIO_ERR_WANT_WRITE;
+    memcpy(p->buf + p->len, buf, sz);
+    p->len += sz;
+
+    return sz;
+}
+
+static double now_sec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+}
+
+/* One client/server handshake over memory, the client resumes the session
+ * cached for serverId when there is one. Returns 1 resumed, 0 full, < 0 on
+ * error */
+static int bench_handshake(MemConn* conn, const char* serverId)
+{
+    int ret = -1;
+    int cliDone = 0, srvDone = 0;
+    int loops;
+    WOLFSSL* cli = NULL;
+    WOLFSSL* srv = NULL;
+    MemSide cliSide, srvSide;
+
+    memset(conn, 0, sizeof(*conn));
+    cliSide.in  = &conn->toClient;
+    cliSide.out = &conn->toServer;
+    srvSide.in  = &conn->toServer;
+    srvSide.out = &conn->toClient;
+
+    cli = wolfSSL_new(cliCtx);
+    srv = wolfSSL_new(srvCtx);
+    if (cli == NULL || srv == NULL)
+        goto exit;
+
+    wolfSSL_SetIOReadCtx(cli, &cliSide);
+    wolfSSL_SetIOWriteCtx(cli, &cliSide);
+    wolfSSL_SetIOReadCtx(srv, &srvSide);
+    wolfSSL_SetIOWriteCtx(srv, &srvSide);
+
+    if (wolfSSL_SetServerID(cli, (const unsigned char*)serverId,
+                            (int)strlen(serverId), 0) != WOLFSSL_SUCCESS) {
+        goto exit;
+    }
+
+    for (loops = 0; loops < 100 && !(cliDone && srvDone); loops++) {
+        int err;
+
+        if (!cliDone) {
+            if (wolfSSL_connect(cli) == WOLFSSL_SUCCESS)
+                cliDone = 1;
+            else if ((err = wolfSSL_get_error(cli, 0)) !=
+                                                WOLFSSL_ERROR_WANT_READ) {
+                fprintf(stderr, "connect error %d\n", err);
+                goto exit;
+            }
+        }
+        if (!srvDone) {
+            if (wolfSSL_accept(srv) == WOLFSSL_SUCCESS)
+                srvDone = 1;
+            else if ((err = wolfSSL_get_error(srv, 0)) !=
+                                                WOLFSSL_ERROR_WANT_READ) {
+                fprintf(stderr, "accept error %d\n", err);
+                goto exit;
+            }
+        }
+    }
+    if (cliDone && srvDone)
+        ret = wolfSSL_session_reused(cli) && wolfSSL_session_reused(srv);
+
+exit:
+    wolfSSL_free(cli);
+    wolfSSL_free(srv);
+    return ret;
+}
+
+static void* bench_thread(void* arg)
+{
+    BenchThread* t = (BenchThread*)arg;
+    MemConn* conn;
+    char serverId[32];
+    int i, ret;
+    double end;
+
+    conn = (MemConn*)malloc(sizeof(MemConn));
+    if (conn == NULL) {
+        t->ret = -1;
+        pthread_barrier_wait(&benchStart);
+        return NULL;
+    }
+
+    /* full handshakes to fill the cache */
+    for (i = 0; i < t->ids; i++) {
+        snprintf(serverId, sizeof(serverId), "server-%d-%d", t->id, i);
+        if (bench_handshake(conn, serverId) < 0)
+            t->ret = -1;
+    }
+
+    pthread_barrier_wait(&benchStart);
+    end = now_sec() + t->secs;
+
+    for (i = 0; t->ret == 0 && now_sec() < end; i = (i + 1) % t->ids) {
+        snprintf(serverId, sizeof(serverId), "server-%d-%d", t->id, i);
+        ret = bench_handshake(conn, serverId);
+        if (ret < 0)
+            t->ret = ret;
+        else if (ret)
+            t->resumed++;
+        else
+            t->full++;
+    }
+
+    free(conn);
+    return NULL;
+}
+
+static int bench_run(int threads, int ids, int secs, long* resumed,
+                     long* full, double* rate)
+{
+    BenchThread t[BENCH_MAX_THREADS];
+    double start, elapsed;
+    int i, ret = 0;
+
+    memset(t, 0, sizeof(t));
+    pthread_barrier_init(&benchStart, NULL, threads + 1);
+    *resumed = *full = 0;
+
+    for (i = 0; i < threads; i++) {
+        t[i].id  = i;
+        t[i].ids = ids;
+        t[i].secs = secs;
+        if (pthread_create(&t[i].tid, NULL, bench_thread, &t[i]) != 0) {
+            fprintf(stderr, "pthread_create failed\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    pthread_barrier_wait(&benchStart);
+    start = now_sec();
+
+    for (i = 0; i < threads; i++) {
+        pthread_join(t[i].tid, NULL);
+        *resumed += t[i].resumed;
+        *full    += t[i].full;
+        if (t[i].ret != 0)
+            ret = t[i].ret;
+    }
+    elapsed = now_sec() - start;
+    pthread_barrier_destroy(&benchStart);
+
+    *rate = (double)*resumed / elapsed;
+
+    return ret;
+}
+
+int main(int argc, char** argv)
+{
+    int secs = BENCH_DEF_SECS;
+    int ids = BENCH_DEF_IDS;
+    unsigned int rows = 0, cols = 0;
+    int i, threads, ret = 0;
+    long resumed, full;
+    double rate, base = 0;
+
+    for (i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "-t") == 0)
+            secs = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-i") == 0)
+            ids = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-r") == 0)
+            rows = (unsigned int)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-c") == 0)
+            cols = (unsigned int)atoi(argv[i + 1]);
+        else
+            break;
+    }
+    if (i < argc || secs <= 0 || ids <= 0) {
+        printf("usage: %s [-t seconds] [-i ids per thread] [-r rows] "
+               "[-c cols]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+#ifdef WOLFSSL_SESSION_CACHE_SHARDED
+    if (wolfSSL_SetSessionCacheSize(rows, cols) != WOLFSSL_SUCCESS) {
+        fprintf(stderr, "Bad session cache size\n");
+        return EXIT_FAILURE;
+    }
+#else
+    if (rows != 0 || cols != 0)
+        printf("-r/-c need WOLFSSL_SESSION_CACHE_SHARDED, ignored\n");
+#endif
+
+    wolfSSL_Init();
+
+    srvCtx = wolfSSL_CTX_new(wolfTLSv1_2_server_method());
+    cliCtx = wolfSSL_CTX_new(wolfTLSv1_2_client_method());
+    if (srvCtx == NULL || cliCtx == NULL) {
+        fprintf(stderr, "CTX new failed\n");
+        return EXIT_FAILURE;
+    }
+    if (wolfSSL_CTX_use_certificate_buffer(srvCtx, serv_ecc_der_256,
+            sizeof_serv_ecc_der_256, WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS ||
+        wolfSSL_CTX_use_PrivateKey_buffer(srvCtx, ecc_key_der_256,
+            sizeof_ecc_key_der_256, WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS ||
+        wolfSSL_CTX_set_cipher_list(srvCtx, BENCH_CIPHER) != WOLFSSL_SUCCESS ||
+        wolfSSL_CTX_set_cipher_list(cliCtx, BENCH_CIPHER) != WOLFSSL_SUCCESS) {
+        fprintf(stderr, "CTX setup failed\n");
+        return EXIT_FAILURE;
+    }
+    wolfSSL_CTX_set_verify(cliCtx, WOLFSSL_VERIFY_NONE, NULL);
+    wolfSSL_SetIORecv(srvCtx, MemRecv);
+    wolfSSL_SetIOSend(srvCtx, MemSend);
+    wolfSSL_SetIORecv(cliCtx, MemRecv);
+    wolfSSL_SetIOSend(cliCtx, MemSend);
+
+    printf("TLS session cache: %s, %d ids per thread, %d sec per run\n",
+#ifdef WOLFSSL_SESSION_CACHE_SHARDED
+           "sharded",
+#else
+           "global lock",
+#endif
+           ids, secs);
+    printf("threads  resumes/sec   speedup   resumed      full\n");
+
+    for (threads = 1; threads <= BENCH_MAX_THREADS && ret == 0; threads *= 2) {
+        ret = bench_run(threads, ids, secs, &resumed, &full, &rate);
+        if (threads == 1)
+            base = rate;
+        printf("%7d %12.0f %8.2fx %9ld %9ld\n", threads, rate,
+               base > 0 ? rate / base : 0.0, resumed, full);
+    }
+
+    wolfSSL_CTX_free(cliCtx);
+    wolfSSL_CTX_free(srvCtx);
+    wolfSSL_Cleanup();
+
+    if (ret != 0)
+        fprintf(stderr, "Benchmark failed %d\n", ret);
+    return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
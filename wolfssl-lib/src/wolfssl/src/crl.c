@@ -34,6 +34,13 @@
 #include <wolfssl/internal.h>
 #include <wolfssl/error-ssl.h>
 
+#ifdef NO_INLINE
+    #include <wolfssl/wolfcrypt/misc.h>
+#else
+    #define WOLFSSL_MISC_INCLUDED
+    #include <wolfcrypt/src/misc.c>
+#endif
+
 #include <string.h>
 
 #ifdef HAVE_CRL_MONITOR
@@ -91,6 +98,11 @@ static int InitCRL_Entry(CRL_Entry* crle, DecodedCRL* dcrl, const byte* buff,
 
     crle->certs = dcrl->certs;   /* take ownsership */
     dcrl->certs = NULL;
+#ifdef WOLFSSL_CRL_INDEX
+    crle->serials = dcrl->serials;
+    dcrl->serials = NULL;
+    crle->serialsMapped = 0;
+#endif
     crle->totalCerts = dcrl->totalCerts;
     crle->verified = verified;
     if (!verified) {
@@ -140,6 +152,10 @@ static void FreeCRL_Entry(CRL_Entry* crle, void* heap)
         XFREE(tmp, heap, DYNAMIC_TYPE_REVOKED);
         tmp = next;
     }
+#ifdef WOLFSSL_CRL_INDEX
+    if (crle->serials != NULL && !crle->serialsMapped)
+        XFREE(crle->serials, heap, DYNAMIC_TYPE_REVOKED);
+#endif
     if (crle->signature != NULL)
         XFREE(crle->signature, heap, DYNAMIC_TYPE_REVOKED);
     if (crle->toBeSigned != NULL)
@@ -186,6 +202,30 @@ void FreeCRL(WOLFSSL_CRL* crl, int dynamic)
 }
 
 
+#ifdef WOLFSSL_CRL_INDEX
+/* Binary search of the sorted serial table, 1 if serial is in it */
+static int FindRevokedSerial(const RevokedSerial* serials, int n,
+                             const byte* serial, int serialSz)
+{
+    int lo = 0, hi = n - 1;
+
+    while (lo <= hi) {
+        int mid = lo + (hi - lo) / 2;
+        int cmp = CompareRevokedSerial(&serials[mid], serial, serialSz);
+
+        if (cmp == 0)
+            return 1;
+        if (cmp < 0)
+            lo = mid + 1;
+        else
+            hi = mid - 1;
+    }
+
+    return 0;
+}
+#endif
+
+
 static int CheckCertCRLList(WOLFSSL_CRL* crl, DecodedCert* cert, int *pFoundEntry)
 {
     CRL_Entry* crle;
@@ -314,6 +354,14 @@ static int CheckCertCRLList(WOLFSSL_CRL* crl, DecodedCert* cert, int *pFoundEntr
         crle = crle->next;
     }
 
+#ifdef WOLFSSL_CRL_INDEX
+    if (foundEntry && crle->serials != NULL &&
+            FindRevokedSerial(crle->serials, crle->totalCerts, cert->serial,
+                              cert->serialSz)) {
+        WOLFSSL_MSG("Cert revoked");
+        ret = CRL_CERT_REVOKED;
+    }
+#endif
     if (foundEntry) {
         RevokedCert* rc = crle->certs;
 
@@ -489,6 +537,189 @@ int BufferLoadCRL(WOLFSSL_CRL* crl, const byte* buff, long sz, int type,
     return ret ? ret : WOLFSSL_SUCCESS; /* convert 0 to WOLFSSL_SUCCESS */
 }
 
+#ifdef WOLFSSL_CRL_INDEX
+/* Saved CRL index, one record per CRL:
+ *   magic[4] version digestSz serialSz lastDateFormat nextDateFormat
+ *   issuerHash[CRL_DIGEST_SIZE] lastDate[MAX_DATE_SIZE]
+ *   nextDate[MAX_DATE_SIZE] count[4, big endian] RevokedSerial[count]
+ * All bytes, so the serial table is searched where it is loaded (a mapped
+ * file or flash) without parsing or copying. */
+#define CRL_INDEX_MAGIC    "wCRI"
+#define CRL_INDEX_VERSION  1
+#define CRL_INDEX_HDR_SZ   (9 + CRL_DIGEST_SIZE + 2 * MAX_DATE_SIZE + 4)
+
+/* Save the verified CRLs as an index, WOLFSSL_SUCCESS on ok.
+ * With out NULL sets outSz and returns LENGTH_ONLY_E */
+int SaveCRLIndex(WOLFSSL_CRL* crl, byte* out, word32* outSz)
+{
+    CRL_Entry* crle;
+    word32     sz = 0;
+    word32     idx = 0;
+    int        ret = WOLFSSL_SUCCESS;
+
+    WOLFSSL_ENTER("SaveCRLIndex");
+
+    if (crl == NULL || outSz == NULL)
+        return BAD_FUNC_ARG;
+
+    if (wc_LockMutex(&crl->crlLock) != 0) {
+        WOLFSSL_MSG("wc_LockMutex failed");
+        return BAD_MUTEX_E;
+    }
+
+    for (crle = crl->crlList; crle != NULL; crle = crle->next) {
+        /* unverified CRLs and ones without a table are left out */
+        if (crle->verified == 1 &&
+                (crle->serials != NULL || crle->totalCerts == 0))
+            sz += CRL_INDEX_HDR_SZ + crle->totalCerts * sizeof(RevokedSerial);
+    }
+
+    if (out == NULL)
+        ret = LENGTH_ONLY_E;
+    else if (*outSz < sz)
+        ret = BUFFER_E;
+
+    for (crle = crl->crlList; ret == WOLFSSL_SUCCESS && crle != NULL;
+                                                          crle = crle->next) {
+        word32 serialsSz = crle->totalCerts * sizeof(RevokedSerial);
+
+        if (crle->verified != 1 ||
+                (crle->serials == NULL && crle->totalCerts != 0))
+            continue;
+
+        XMEMCPY(out + idx, CRL_INDEX_MAGIC, 4);
+        out[idx + 4] = CRL_INDEX_VERSION;
+        out[idx + 5] = CRL_DIGEST_SIZE;
+        out[idx + 6] = (byte)sizeof(RevokedSerial);
+        out[idx + 7] = crle->lastDateFormat;
+        out[idx + 8] = crle->nextDateFormat;
+        idx += 9;
+        XMEMCPY(out + idx, crle->issuerHash, CRL_DIGEST_SIZE);
+        idx += CRL_DIGEST_SIZE;
+        XMEMCPY(out + idx, crle->lastDate, MAX_DATE_SIZE);
+        idx += MAX_DATE_SIZE;
+        XMEMCPY(out + idx, crle->nextDate, MAX_DATE_SIZE);
+        idx += MAX_DATE_SIZE;
+        c32toa((word32)crle->totalCerts, out + idx);
+        idx += 4;
+        if (serialsSz > 0)
+            XMEMCPY(out + idx, crle->serials, serialsSz);
+        idx += serialsSz;
+    }
+
+    wc_UnLockMutex(&crl->crlLock);
+
+    *outSz = sz;
+
+    return ret;
+}
+
+
+/* Load a saved CRL index, WOLFSSL_SUCCESS on ok. The serial tables are used
+ * in place, so buff must stay until the CRLs are freed. The index is trusted
+ * like the CRLs it was saved from, the signatures are not checked again. */
+int BufferLoadCRLIndex(WOLFSSL_CRL* crl, const byte* buff, long sz)
+{
+    CRL_Entry* head = NULL;
+    CRL_Entry* tail = NULL;
+    CRL_Entry* crle;
+    word32     idx = 0;
+    int        ret = 0;
+
+    WOLFSSL_ENTER("BufferLoadCRLIndex");
+
+    if (crl == NULL || buff == NULL || sz <= 0)
+        return BAD_FUNC_ARG;
+
+    while (ret == 0 && idx < (word32)sz) {
+        word32 cnt, i;
+        const RevokedSerial* serials;
+
+        if ((word32)sz - idx < CRL_INDEX_HDR_SZ ||
+                XMEMCMP(buff + idx, CRL_INDEX_MAGIC, 4) != 0 ||
+                buff[idx + 4] != CRL_INDEX_VERSION ||
+                buff[idx + 5] != CRL_DIGEST_SIZE ||
+                buff[idx + 6] != sizeof(RevokedSerial)) {
+            WOLFSSL_MSG("Bad CRL index header");
+            ret = ASN_PARSE_E;
+            break;
+        }
+        ato32(buff + idx + CRL_INDEX_HDR_SZ - 4, &cnt);
+        if (cnt > ((word32)sz - idx - CRL_INDEX_HDR_SZ) /
+                                                    sizeof(RevokedSerial)) {
+            WOLFSSL_MSG("CRL index truncated");
+            ret = BUFFER_E;
+            break;
+        }
+        serials = (const RevokedSerial*)(buff + idx + CRL_INDEX_HDR_SZ);
+        /* the search needs the table in order */
+        for (i = 0; i < cnt; i++) {
+            if (serials[i].serialSz > EXTERNAL_SERIAL_SIZE ||
+                    (i > 0 && CompareRevokedSerial(&serials[i - 1],
+                            serials[i].serialNumber,
+                            serials[i].serialSz) > 0)) {
+                break;
+            }
+        }
+        if (i < cnt) {
+            WOLFSSL_MSG("CRL index serials not in order");
+            ret = ASN_PARSE_E;
+            break;
+        }
+
+        crle = (CRL_Entry*)XMALLOC(sizeof(CRL_Entry), crl->heap,
+                                   DYNAMIC_TYPE_CRL_ENTRY);
+        if (crle == NULL) {
+            ret = MEMORY_E;
+            break;
+        }
+        XMEMSET(crle, 0, sizeof(CRL_Entry));
+        crle->lastDateFormat = buff[idx + 7];
+        crle->nextDateFormat = buff[idx + 8];
+        idx += 9;
+        XMEMCPY(crle->issuerHash, buff + idx, CRL_DIGEST_SIZE);
+        idx += CRL_DIGEST_SIZE;
+        XMEMCPY(crle->lastDate, buff + idx, MAX_DATE_SIZE);
+        idx += MAX_DATE_SIZE;
+        XMEMCPY(crle->nextDate, buff + idx, MAX_DATE_SIZE);
+        idx += MAX_DATE_SIZE + 4;
+        crle->totalCerts = (int)cnt;
+        crle->serials = (cnt > 0) ? (RevokedSerial*)(buff + idx) : NULL;
+        crle->serialsMapped = 1;
+        crle->verified = 1;
+        idx += cnt * sizeof(RevokedSerial);
+
+        if (tail == NULL)
+            head = crle;
+        else
+            tail->next = crle;
+        tail = crle;
+    }
+
+    if (ret == 0 && head != NULL) {
+        if (wc_LockMutex(&crl->crlLock) != 0) {
+            WOLFSSL_MSG("wc_LockMutex failed");
+            ret = BAD_MUTEX_E;
+        }
+        else {
+            tail->next = crl->crlList;
+            crl->crlList = head;
+            wc_UnLockMutex(&crl->crlLock);
+            head = NULL;
+        }
+    }
+
+    while (head != NULL) {
+        crle = head->next;
+        FreeCRL_Entry(head, crl->heap);
+        XFREE(head, crl->heap, DYNAMIC_TYPE_CRL_ENTRY);
+        head = crle;
+    }
+
+    return ret ? ret : WOLFSSL_SUCCESS;
+}
+#endif /* WOLFSSL_CRL_INDEX */
+
 #if defined(OPENSSL_EXTRA) && defined(HAVE_CRL)
 /* helper function to create a new dynamic WOLFSSL_X509_CRL structure */
 static WOLFSSL_X509_CRL* wolfSSL_X509_crl_new(WOLFSSL_CERT_MANAGER* cm)
@@ -562,6 +793,20 @@ static CRL_Entry* DupCRL_Entry(const CRL_Entry* ent, void* heap)
     dup->lastDateFormat = ent->lastDateFormat;
     dup->nextDateFormat = ent->nextDateFormat;
     dup->certs = DupRevokedCertList(ent->certs, heap);
+#ifdef WOLFSSL_CRL_INDEX
+    if (ent->serials != NULL && ent->totalCerts > 0) {
+        dup->serials = (RevokedSerial*)XMALLOC(
+                ent->totalCerts * sizeof(RevokedSerial), heap,
+                DYNAMIC_TYPE_REVOKED);
+        if (dup->serials == NULL) {
+            FreeCRL_Entry(dup, heap);
+            XFREE(dup, heap, DYNAMIC_TYPE_CRL_ENTRY);
+            return NULL;
+        }
+        XMEMCPY(dup->serials, ent->serials,
+                ent->totalCerts * sizeof(RevokedSerial));
+    }
+#endif
 
     dup->totalCerts = ent->totalCerts;
     dup->verified = ent->verified;
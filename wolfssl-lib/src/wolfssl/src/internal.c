@@ -1573,6 +1573,25 @@ void InitSSL_Method(WOLFSSL_METHOD* method, ProtocolVersion pv)
     method->downgrade  = 0;
 }
 
+#if defined(WOLFSSL_STATIC_MEMORY) && defined(WOLFSSL_MEM_PROFILE)
+/* allocations are profiled by the handshake state of the side */
+static void SetMemProfilePhase(WOLFSSL* ssl)
+{
+    WOLFSSL_HEAP_HINT* hint = (WOLFSSL_HEAP_HINT*)ssl->heap;
+
+    if (hint == NULL
+    #ifdef WOLFSSL_HEAP_TEST
+            || ssl->heap == (void*)WOLFSSL_HEAP_TEST
+    #endif
+            || hint->profile == NULL) {
+        return;
+    }
+
+    hint->phase = (ssl->options.side == WOLFSSL_CLIENT_END) ?
+                  &ssl->options.connectState : &ssl->options.acceptState;
+}
+#endif
+
 #if defined(OPENSSL_EXTRA) || defined(WOLFSSL_EITHER_SIDE)
 int InitSSL_Side(WOLFSSL* ssl, word16 side)
 {
@@ -1581,6 +1600,9 @@ int InitSSL_Side(WOLFSSL* ssl, word16 side)
 
     /* set side */
     ssl->options.side = side;
+#if defined(WOLFSSL_STATIC_MEMORY) && defined(WOLFSSL_MEM_PROFILE)
+    SetMemProfilePhase(ssl);
+#endif
 
     /* reset options that are side specific */
 #ifdef HAVE_NTRU
@@ -5575,6 +5597,31 @@ int InitSSL(WOLFSSL* ssl, WOLFSSL_CTX* ctx, int writeDup)
             XMEMSET(ssl_hint->stats, 0, sizeof(WOLFSSL_MEM_CONN_STATS));
         }
 
+    #ifdef WOLFSSL_MEM_PROFILE
+        /* check if profiling allocations */
+        if (ctx_hint->memory->flag & WOLFMEM_TRACK_PROFILE) {
+            ssl_hint->profile = (WOLFSSL_MEM_CONN_PROFILE*)XMALLOC(
+                         sizeof(WOLFSSL_MEM_CONN_PROFILE), ctx->heap,
+                         DYNAMIC_TYPE_SSL);
+            if (ssl_hint->profile == NULL) {
+                return MEMORY_E;
+            }
+            XMEMSET(ssl_hint->profile, 0, sizeof(WOLFSSL_MEM_CONN_PROFILE));
+        }
+    #endif
+
+        /* check if using a handshake arena, general memory if none free */
+        if (ctx_hint->memory->flag & WOLFMEM_ARENA) {
+            if (wc_LockMutex(&(ctx_hint->memory->memory_mutex)) != 0) {
+                WOLFSSL_MSG("Bad memory_mutex lock");
+                return BAD_MUTEX_E;
+            }
+            if (SetArena(ctx_hint->memory, &(ssl_hint->arena)) != 1) {
+                WOLFSSL_MSG("No free handshake arena");
+            }
+            wc_UnLockMutex(&(ctx_hint->memory->memory_mutex));
+        }
+
         /* check if using fixed IO buffers */
         if (ctx_hint->memory->flag & WOLFMEM_IO_POOL_FIXED) {
             if (wc_LockMutex(&(ctx_hint->memory->memory_mutex)) != 0) {
@@ -5908,6 +5955,10 @@ int InitSSL(WOLFSSL* ssl, WOLFSSL_CTX* ctx, int writeDup)
     }
 #endif /* HAVE_SECURE_RENEGOTIATION */
 
+#if defined(WOLFSSL_STATIC_MEMORY) && defined(WOLFSSL_MEM_PROFILE)
+    SetMemProfilePhase(ssl);
+#endif
+
     return 0;
 }
 
@@ -6454,12 +6505,18 @@ void SSL_ResourceFree(WOLFSSL* ssl)
         if (ssl_hint->haFlag) { /* check if handshake count has been decreased*/
             ctx_heap->curHa--;
         }
+        if (ReleaseArena(ctx_heap, &(ssl_hint->arena)) != 1) {
+            WOLFSSL_MSG("Error releasing handshake arena");
+        }
         wc_UnLockMutex(&(ctx_heap->memory_mutex));
 
         /* check if tracking stats */
         if (ctx_heap->flag & WOLFMEM_TRACK_STATS) {
             XFREE(ssl_hint->stats, heap, DYNAMIC_TYPE_SSL);
         }
+    #ifdef WOLFSSL_MEM_PROFILE
+        XFREE(ssl_hint->profile, heap, DYNAMIC_TYPE_SSL);
+    #endif
         XFREE(ssl->heap, heap, DYNAMIC_TYPE_SSL);
     #ifdef WOLFSSL_HEAP_TEST
     }
@@ -6684,6 +6741,10 @@ void FreeHandshakeResources(WOLFSSL* ssl)
         }
         ctx_heap->curHa--;
         ssl_hint->haFlag = 0; /* set to zero since handshake has been dec */
+        /* handshake memory goes back to the pool as a whole */
+        if (ReleaseArena(ctx_heap, &(ssl_hint->arena)) != 1) {
+            WOLFSSL_MSG("Error releasing handshake arena");
+        }
         wc_UnLockMutex(&(ctx_heap->memory_mutex));
     #ifdef WOLFSSL_HEAP_TEST
     }
@@ -8003,8 +8064,18 @@ void ShrinkOutputBuffer(WOLFSSL* ssl)
     WOLFSSL_MSG("Shrinking output buffer\n");
     XFREE(ssl->buffers.outputBuffer.buffer - ssl->buffers.outputBuffer.offset,
           ssl->heap, DYNAMIC_TYPE_OUT_BUFFER);
-    ssl->buffers.outputBuffer.buffer = ssl->buffers.outputBuffer.staticBuffer;
-    ssl->buffers.outputBuffer.bufferSize  = STATIC_BUFFER_LEN;
+#ifdef WOLFSSL_SEND_COALESCE
+    if (ssl->buffers.userOutput != NULL) {
+        ssl->buffers.outputBuffer.buffer     = ssl->buffers.userOutput;
+        ssl->buffers.outputBuffer.bufferSize = ssl->buffers.userOutputSz;
+    }
+    else
+#endif
+    {
+        ssl->buffers.outputBuffer.buffer =
+                                        ssl->buffers.outputBuffer.staticBuffer;
+        ssl->buffers.outputBuffer.bufferSize = STATIC_BUFFER_LEN;
+    }
     ssl->buffers.outputBuffer.dynamicFlag = 0;
     ssl->buffers.outputBuffer.offset      = 0;
 }
@@ -10289,6 +10360,126 @@ static void FreeProcPeerCertArgs(WOLFSSL* ssl, void* pArgs)
     }
 }
 
+#ifdef WOLFSSL_CHAIN_CACHE
+#ifndef NO_ASN_TIME
+#define CHAIN_CACHE_DATE_SZ 14 /* YYYYMMDDHHMMSS */
+
+/* Make a UTC or generalized time comparable with memcmp, returns 0 on success */
+static int ChainCacheDate(const byte* date, byte format, int length, byte* out)
+{
+    if (format == ASN_UTC_TIME && length >= CHAIN_CACHE_DATE_SZ - 2) {
+        out[0] = (date[0] >= '5') ? '1' : '2';
+        out[1] = (date[0] >= '5') ? '9' : '0';
+        XMEMCPY(out + 2, date, CHAIN_CACHE_DATE_SZ - 2);
+        return 0;
+    }
+    if (format == ASN_GENERALIZED_TIME && length >= CHAIN_CACHE_DATE_SZ) {
+        XMEMCPY(out, date, CHAIN_CACHE_DATE_SZ);
+        return 0;
+    }
+    return ASN_TIME_E;
+}
+#endif /* !NO_ASN_TIME */
+
+/* Keep the earliest expiry of the chain certs, the cached chain is good
+ * until then */
+static void ChainCacheNotAfter(ProcPeerCertArgs* args)
+{
+#ifndef NO_ASN_TIME
+    const byte* date;
+    byte format;
+    int length;
+    byte next[CHAIN_CACHE_DATE_SZ];
+    byte first[CHAIN_CACHE_DATE_SZ];
+
+    if (wc_GetDateInfo(args->dCert->afterDate, args->dCert->afterDateLen,
+                       &date, &format, &length) != 0 ||
+            length > MAX_DATE_SIZE ||
+            ChainCacheDate(date, format, length, next) != 0) {
+        args->chainCache = 0; /* can't tell when to drop it */
+        return;
+    }
+    if (args->chain.notAfterFormat != 0 &&
+            ChainCacheDate(args->chain.notAfter, args->chain.notAfterFormat,
+                           MAX_DATE_SIZE, first) == 0 &&
+            XMEMCMP(first, next, CHAIN_CACHE_DATE_SZ) <= 0) {
+        return;
+    }
+    XMEMSET(args->chain.notAfter, 0, MAX_DATE_SIZE);
+    XMEMCPY(args->chain.notAfter, date, length);
+    args->chain.notAfterFormat = format;
+#else
+    (void)args;
+#endif
+}
+
+/* Hash the peer's chain and look for it in the verified chains. Intermediate
+ * revocation and verify callbacks see each chain cert, so no caching then. */
+static void ChainCacheLookup(WOLFSSL* ssl, ProcPeerCertArgs* args)
+{
+    WOLFSSL_CERT_MANAGER* cm = ssl->ctx->cm;
+    wc_Sha256 sha;
+    byte len[OPAQUE32_LEN];
+    int i, ret;
+
+    XMEMSET(&args->chain, 0, sizeof(args->chain));
+    args->chainCache = 0;
+    args->chainCached = 0;
+
+    if (args->count == 0 || ssl->options.verifyNone ||
+            ssl->verifyCallback != NULL
+    #ifdef OPENSSL_ALL
+            || ssl->ctx->verifyCertCb != NULL
+    #endif
+    #ifndef NO_WOLFSSL_CM_VERIFY
+            || cm->verifyCallback != NULL
+    #endif
+    #ifdef HAVE_OCSP
+            || (cm->ocspEnabled && cm->ocspCheckAll)
+    #endif
+    #ifdef HAVE_CRL
+            || (cm->crlEnabled && cm->crlCheckAll)
+    #endif
+    #ifdef HAVE_CERTIFICATE_STATUS_REQUEST_V2
+            || ssl->status_request_v2
+    #endif
+            ) {
+        return;
+    }
+
+    /* chain certs are checked against the minimum key sizes too */
+    ret = wc_InitSha256_ex(&sha, ssl->heap, ssl->devId);
+    if (ret != 0)
+        return;
+#ifndef NO_RSA
+    c16toa((word16)ssl->options.minRsaKeySz, len);
+    ret = wc_Sha256Update(&sha, len, OPAQUE16_LEN);
+#endif
+#if defined(HAVE_ECC) || defined(HAVE_ED25519) || defined(HAVE_ED448)
+    if (ret == 0) {
+        c16toa((word16)ssl->options.minEccKeySz, len);
+        ret = wc_Sha256Update(&sha, len, OPAQUE16_LEN);
+    }
+#endif
+    for (i = 0; ret == 0 && i < args->count; i++) {
+        c32toa(args->certs[i].length, len);
+        ret = wc_Sha256Update(&sha, len, OPAQUE32_LEN);
+        if (ret == 0)
+            ret = wc_Sha256Update(&sha, args->certs[i].buffer,
+                                  args->certs[i].length);
+    }
+    if (ret == 0)
+        ret = wc_Sha256Final(&sha, args->chain.hash);
+    wc_Sha256Free(&sha);
+
+    if (ret == 0) {
+        args->chainCache = 1;
+        args->chainCached = (byte)ChainCacheGet(cm, args->chain.hash,
+                                                &args->chain);
+    }
+}
+#endif /* WOLFSSL_CHAIN_CACHE */
+
 static int ProcessPeerCertParse(WOLFSSL* ssl, ProcPeerCertArgs* args,
     int certType, int verify, byte** pSubjectHash, int* pAlreadySigner)
 {
@@ -10401,6 +10592,10 @@ static int ProcessPeerCertParse(WOLFSSL* ssl, ProcPeerCertArgs* args,
     if (ret == 0)
         ret = sigRet;
 #endif
+#ifdef WOLFSSL_CHAIN_CACHE
+    if (ret == 0 && args->chainCache)
+        ChainCacheNotAfter(args);
+#endif
 
     if (pSubjectHash)
         *pSubjectHash = subjectHash;
@@ -10742,6 +10937,10 @@ int ProcessPeerCerts(WOLFSSL* ssl, byte* input, word32* inOutIdx,
             XMEMSET(args->dCert, 0, sizeof(DecodedCert));
         #endif
 
+        #ifdef WOLFSSL_CHAIN_CACHE
+            ChainCacheLookup(ssl, args);
+        #endif
+
             /* Advance state and proceed */
             ssl->options.asyncState = TLS_ASYNC_BUILD;
         } /* case TLS_ASYNC_BEGIN */
@@ -10801,6 +11000,18 @@ int ProcessPeerCerts(WOLFSSL* ssl, byte* input, word32* inOutIdx,
                 }
             #endif /* WOLFSSL_TRUST_PEER_CERT || OPENSSL_EXTRA */
 
+            #ifdef WOLFSSL_CHAIN_CACHE
+                if (args->chainCached) {
+                    /* chain verified before and its CAs were added */
+                    WOLFSSL_MSG("Peer chain found in verified chain cache");
+                #if defined(OPENSSL_EXTRA) || defined(OPENSSL_EXTRA_X509_SMALL)
+                    if (args->chain.untrustedDepth > args->untrustedDepth)
+                        args->untrustedDepth = args->chain.untrustedDepth;
+                #endif
+                    args->count = 1;
+                }
+            #endif
+
                 /* check certificate up to peer's first */
                 /* do not verify chain if trusted peer cert found */
                 while (args->count > 1
@@ -10900,6 +11111,11 @@ int ProcessPeerCerts(WOLFSSL* ssl, byte* input, word32* inOutIdx,
                     }
             #endif /* HAVE_OCSP || HAVE_CRL */
 
+                #ifdef WOLFSSL_CHAIN_CACHE
+                    if (ret != 0)
+                        args->chainCache = 0;
+                #endif
+
                     /* Do verify callback */
                     ret = DoVerifyCallback(ssl->ctx->cm, ssl, ret, args);
                     if (ssl->options.verifyNone &&
@@ -10962,6 +11178,9 @@ int ProcessPeerCerts(WOLFSSL* ssl, byte* input, word32* inOutIdx,
 
                     /* Handle error codes */
                     if (ret != 0) {
+                    #ifdef WOLFSSL_CHAIN_CACHE
+                        args->chainCache = 0;
+                    #endif
                         if (!ssl->options.verifyNone) {
                             DoCertFatalAlert(ssl, ret);
                         }
@@ -10998,6 +11217,14 @@ int ProcessPeerCerts(WOLFSSL* ssl, byte* input, word32* inOutIdx,
                 /* select peer cert (first one) */
                 args->certIdx = 0;
 
+            #ifdef WOLFSSL_CHAIN_CACHE
+                /* signature known good, still check the dates and signer */
+                if (args->chainCached) {
+                    ret = ProcessPeerCertParse(ssl, args, CERT_TYPE,
+                            VERIFY_NAME, &subjectHash, &alreadySigner);
+                }
+                else
+            #endif
                 ret = ProcessPeerCertParse(ssl, args, CERT_TYPE,
                         !ssl->options.verifyNone ? VERIFY : NO_VERIFY,
                         &subjectHash, &alreadySigner);
@@ -11605,6 +11832,22 @@ int ProcessPeerCerts(WOLFSSL* ssl, byte* input, word32* inOutIdx,
                 ret = ssl->error = 0;
             }
 
+        #ifdef WOLFSSL_CHAIN_CACHE
+            if (ret == 0 && args->chainCache && !args->chainCached
+            #ifdef WOLFSSL_TRUST_PEER_CERT
+                    && !args->haveTrustPeer
+            #endif
+            #ifdef WOLFSSL_ALT_CERT_CHAINS
+                    && !ssl->options.usingAltCertChain
+            #endif
+                    ) {
+            #if defined(OPENSSL_EXTRA) || defined(OPENSSL_EXTRA_X509_SMALL)
+                args->chain.untrustedDepth = args->untrustedDepth;
+            #endif
+                ChainCacheAdd(ssl->ctx->cm, &args->chain);
+            }
+        #endif
+
             if (ret != 0) {
                 if (!ssl->options.verifyNone) {
                     DoCertFatalAlert(ssl, ret);
@@ -16291,7 +16534,9 @@ int BuildMessage(WOLFSSL* ssl, byte* output, int outSz, const byte* input,
                                         min(args->ivSz, MAX_IV_SZ));
                 args->idx += args->ivSz;
             }
-            XMEMCPY(output + args->idx, input, inSz);
+            /* input may already be in place, see SendData() */
+            if (input != output + args->idx)
+                XMEMCPY(output + args->idx, input, inSz);
             args->idx += inSz;
 
             ssl->options.buildMsgState = BUILD_MSG_HASH;
@@ -17615,6 +17860,99 @@ static WC_INLINE int IsSCR(WOLFSSL* ssl)
     return 0;
 }
 
+#ifdef WOLFSSL_SEND_COALESCE
+/* Returns the output size to reserve for a batch of records holding up to
+ * WOLFSSL_SEND_COALESCE_SZ of the sz plain text bytes left. Each record holds
+ * at most len bytes and needs recSz bytes of output. A caller output region
+ * caps the batch at its free space so the buffer isn't grown. */
+static int SendCoalesceSize(WOLFSSL* ssl, int sz, int len, int recSz)
+{
+    int batch = sz;
+    int total;
+
+    if (batch > WOLFSSL_SEND_COALESCE_SZ)
+        batch = WOLFSSL_SEND_COALESCE_SZ;
+    total = batch + ((batch + len - 1) / len) * (recSz - len);
+
+    if (ssl->buffers.userOutput != NULL) {
+        int room = (int)(ssl->buffers.outputBuffer.bufferSize -
+                         ssl->buffers.outputBuffer.length);
+        if (total > room)
+            total = (room > recSz) ? room : recSz;
+    }
+
+    return total;
+}
+
+/* A record of the batch could not be built. The records before it used their
+ * sequence numbers so they can't be dropped: send them and return the plain
+ * text sent so far. The next write carries on from there. */
+static int SendCoalescePending(WOLFSSL* ssl, int sent, int pending)
+{
+    WOLFSSL_MSG("Sending records built before the failed one");
+    if ( (ssl->error = SendBuffered(ssl)) < 0) {
+        WOLFSSL_ERROR(ssl->error);
+        ssl->buffers.plainSz  = pending;
+        ssl->buffers.prevSent = sent;
+        if (ssl->error == SOCKET_ERROR_E && (ssl->options.connReset ||
+                                             ssl->options.isClosed)) {
+            ssl->error = SOCKET_PEER_CLOSED_E;
+            WOLFSSL_ERROR(ssl->error);
+            return 0;  /* peer reset or closed */
+        }
+        return ssl->error;
+    }
+
+    return sent + pending;
+}
+#endif /* WOLFSSL_SEND_COALESCE */
+
+#ifdef WOLFSSL_SEND_IOV
+/* Offset of the plain text in a record made by BuildMessage() or
+ * BuildTls13Message() with the current keys, not for DTLS */
+static int RecordPayloadOffset(WOLFSSL* ssl)
+{
+    int idx = RECORD_HEADER_SZ;
+
+    if (ssl->options.tls1_3)
+        return idx;
+#ifndef WOLFSSL_AEAD_ONLY
+    if (ssl->specs.cipher_type == block && ssl->options.tls1_1)
+        idx += ssl->specs.block_size;
+#endif
+#ifdef HAVE_AEAD
+    if (ssl->specs.cipher_type == aead &&
+            ssl->specs.bulk_cipher_algorithm != wolfssl_chacha)
+        idx += AESGCM_EXP_IV_SZ;
+#endif
+
+    return idx;
+}
+
+/* Copy sz bytes, from offset off of the wolfSSL_writev() vectors, to out */
+static void GatherSendIov(WOLFSSL* ssl, byte* out, int off, int sz)
+{
+    const struct iovec* iov = ssl->buffers.sendIov;
+    int i;
+
+    for (i = 0; i < ssl->buffers.sendIovCnt && sz > 0; i++) {
+        int vecSz = (int)iov[i].iov_len;
+
+        if (off >= vecSz) {
+            off -= vecSz;
+            continue;
+        }
+        vecSz -= off;
+        if (vecSz > sz)
+            vecSz = sz;
+        XMEMCPY(out, (const byte*)iov[i].iov_base + off, vecSz);
+        out += vecSz;
+        sz  -= vecSz;
+        off  = 0;
+    }
+}
+#endif /* WOLFSSL_SEND_IOV */
+
 
 int SendData(WOLFSSL* ssl, const void* data, int sz)
 {
@@ -17623,6 +17961,13 @@ int SendData(WOLFSSL* ssl, const void* data, int sz)
         ret,
         dtlsExtra = 0;
     int groupMsgs = 0;
+#ifdef WOLFSSL_SEND_COALESCE
+    int pending = 0;   /* plain text in records built but not sent yet */
+    int coalesce;
+    int inPlace = 0;
+#else
+    const int pending = 0;
+#endif
 
     if (ssl->error == WANT_WRITE
     #ifdef WOLFSSL_ASYNC_CRYPT
@@ -17703,19 +18048,37 @@ int SendData(WOLFSSL* ssl, const void* data, int sz)
     }
 #endif
 
+#ifdef WOLFSSL_SEND_COALESCE
+    /* build records back to back and hand them to one send */
+    coalesce = !ssl->options.dtls && !ssl->options.partialWrite;
+    #ifdef WOLFSSL_SEND_IOV
+    /* gather into the record and encrypt there when the layout is known */
+    if (ssl->buffers.sendIov != NULL && !ssl->options.dtls && !IsSCR(ssl)
+        #ifdef HAVE_LIBZ
+            && !ssl->options.usingCompression
+        #endif
+            ) {
+        inPlace = 1;
+    }
+    #endif
+#endif
+
     for (;;) {
         int   len;
         byte* out;
-        byte* sendBuffer = (byte*)data + sent;  /* may switch on comp */
-        int   buffSz;                           /* may switch on comp */
+        byte* sendBuffer = (byte*)data + sent + pending; /* may switch on comp */
+        int   buffSz;                                    /* may switch on comp */
         int   outputSz;
+#ifdef WOLFSSL_SEND_COALESCE
+        int   recSz;
+#endif
 #ifdef HAVE_LIBZ
         byte  comp[MAX_RECORD_SIZE + MAX_COMP_EXTRA];
 #endif
 
         if (sent == sz) break;
 
-        len = wolfSSL_GetMaxRecordSize(ssl, sz - sent);
+        len = wolfSSL_GetMaxRecordSize(ssl, sz - sent - pending);
 
 #if defined(WOLFSSL_DTLS) && !defined(WOLFSSL_NO_DTLS_SIZE_CHECK)
         if (ssl->options.dtls && (len < sz - sent)) {
@@ -17728,17 +18091,41 @@ int SendData(WOLFSSL* ssl, const void* data, int sz)
 
         /* check for available size */
         outputSz = len + COMP_EXTRA + dtlsExtra + MAX_MSG_EXTRA;
+#ifdef WOLFSSL_SEND_COALESCE
+        recSz = outputSz;
+    #ifdef WOLFSSL_SEND_IOV
+        if (ssl->buffers.sendIov != NULL && !inPlace)
+            recSz += len;                  /* gathered after the record */
+    #endif
+        ret = CheckAvailableSize(ssl, (coalesce && pending == 0) ?
+                           SendCoalesceSize(ssl, sz - sent, len, recSz) : recSz);
+        if (ret != 0 && pending > 0)
+            return SendCoalescePending(ssl, sent, pending);
+        if (ret != 0)
+#else
         if ((ret = CheckAvailableSize(ssl, outputSz)) != 0)
+#endif
             return ssl->error = ret;
 
         /* get output buffer */
         out = ssl->buffers.outputBuffer.buffer +
               ssl->buffers.outputBuffer.length;
 
+#ifdef WOLFSSL_SEND_IOV
+        if (ssl->buffers.sendIov != NULL) {
+            sendBuffer = out + (inPlace ? RecordPayloadOffset(ssl) : outputSz);
+            GatherSendIov(ssl, sendBuffer, sent + pending, len);
+        }
+#endif
+
 #ifdef HAVE_LIBZ
         if (ssl->options.usingCompression) {
             buffSz = myCompress(ssl, sendBuffer, buffSz, comp, sizeof(comp));
             if (buffSz < 0) {
+            #ifdef WOLFSSL_SEND_COALESCE
+                if (pending > 0)
+                    return SendCoalescePending(ssl, sent, pending);
+            #endif
                 return buffSz;
             }
             sendBuffer = comp;
@@ -17760,12 +18147,36 @@ int SendData(WOLFSSL* ssl, const void* data, int sz)
         #ifdef WOLFSSL_ASYNC_CRYPT
             if (sendSz == WC_PENDING_E)
                 ssl->error = sendSz;
+        #endif
+        #ifdef WOLFSSL_SEND_COALESCE
+            if (pending > 0)
+                return SendCoalescePending(ssl, sent, pending);
         #endif
             return BUILD_MSG_ERROR;
         }
 
         ssl->buffers.outputBuffer.length += sendSz;
 
+#ifdef WOLFSSL_SEND_COALESCE
+        /* keep building while there is data and room for the next record */
+        if (coalesce && sent + pending + len < sz &&
+                pending + len < WOLFSSL_SEND_COALESCE_SZ) {
+            int next = wolfSSL_GetMaxRecordSize(ssl, sz - sent - pending - len);
+            int nextSz = next + COMP_EXTRA + dtlsExtra + MAX_MSG_EXTRA;
+        #ifdef WOLFSSL_SEND_IOV
+            if (ssl->buffers.sendIov != NULL && !inPlace)
+                nextSz += next;
+        #endif
+            if (ssl->buffers.outputBuffer.bufferSize -
+                    ssl->buffers.outputBuffer.length >= (word32)nextSz) {
+                pending += len;
+                continue;
+            }
+        }
+        len += pending;  /* plain text in this send */
+        pending = 0;
+#endif
+
         if ( (ssl->error = SendBuffered(ssl)) < 0) {
             WOLFSSL_ERROR(ssl->error);
             /* store for next call if WANT_WRITE or user embedSend() that
@@ -26933,17 +27344,17 @@ static int DoSessionTicket(WOLFSSL* ssl, const byte* input, word32* inOutIdx,
             WOLFSSL_MSG("Session lookup for resume failed");
             ssl->options.resuming = 0;
         }
-        else if (session->haveEMS != ssl->options.haveEMS) {
+        else if (ssl->session.haveEMS != ssl->options.haveEMS) {
             /* RFC 7627, 5.3, server-side */
             /* if old sess didn't have EMS, but new does, full handshake */
-            if (!session->haveEMS && ssl->options.haveEMS) {
+            if (!ssl->session.haveEMS && ssl->options.haveEMS) {
                 WOLFSSL_MSG("Attempting to resume a session that didn't "
                             "use EMS with a new session with EMS. Do full "
                             "handshake.");
                 ssl->options.resuming = 0;
             }
             /* if old sess used EMS, but new doesn't, MUST abort */
-            else if (session->haveEMS && !ssl->options.haveEMS) {
+            else if (ssl->session.haveEMS && !ssl->options.haveEMS) {
                 WOLFSSL_MSG("Trying to resume a session with EMS without "
                             "using EMS");
             #ifdef WOLFSSL_EXTRA_ALERTS
@@ -26964,8 +27375,8 @@ static int DoSessionTicket(WOLFSSL* ssl, const byte* input, word32* inOutIdx,
 
             /* Check client suites include the one in session */
             for (j = 0; j < clSuites->suiteSz; j += 2) {
-                if (clSuites->suites[j] == session->cipherSuite0 &&
-                                clSuites->suites[j+1] == session->cipherSuite) {
+                if (clSuites->suites[j] == ssl->session.cipherSuite0 &&
+                          clSuites->suites[j+1] == ssl->session.cipherSuite) {
                     break;
                 }
             }
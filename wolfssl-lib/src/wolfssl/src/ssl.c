@@ -1595,6 +1595,30 @@ int wolfSSL_is_static_memory(WOLFSSL* ssl, WOLFSSL_MEM_CONN_STATS* mem_stats)
 }
 
 
+#ifdef WOLFSSL_MEM_PROFILE
+/* Copies out the allocation profile of the connection. Needs the
+ * WOLFMEM_TRACK_PROFILE flag when loading the static memory.
+ * returns 1 on success */
+int wolfSSL_GetMemProfile(WOLFSSL* ssl, WOLFSSL_MEM_CONN_PROFILE* profile)
+{
+    WOLFSSL_HEAP_HINT* hint;
+
+    if (ssl == NULL || profile == NULL) {
+        return BAD_FUNC_ARG;
+    }
+    WOLFSSL_ENTER("wolfSSL_GetMemProfile");
+
+    hint = (WOLFSSL_HEAP_HINT*)ssl->heap;
+    if (hint == NULL || hint->profile == NULL) {
+        return 0;
+    }
+    XMEMCPY(profile, hint->profile, sizeof(WOLFSSL_MEM_CONN_PROFILE));
+
+    return 1;
+}
+#endif
+
+
 int wolfSSL_CTX_is_static_memory(WOLFSSL_CTX* ctx, WOLFSSL_MEM_STATS* mem_stats)
 {
     if (ctx == NULL) {
@@ -3570,6 +3594,10 @@ WOLFSSL_CERT_MANAGER* wolfSSL_CTX_GetCertManager(WOLFSSL_CTX* ctx)
     return cm;
 }
 
+#ifdef WOLFSSL_CA_INDEX
+static void CaIndexFree(WOLFSSL_CERT_MANAGER* cm);
+#endif
+
 WOLFSSL_CERT_MANAGER* wolfSSL_CertManagerNew_ex(void* heap)
 {
     WOLFSSL_CERT_MANAGER* cm;
@@ -3595,6 +3623,14 @@ WOLFSSL_CERT_MANAGER* wolfSSL_CertManagerNew_ex(void* heap)
         }
         #endif
 
+        #ifdef WOLFSSL_CHAIN_CACHE
+        if (wc_InitMutex(&cm->chainLock) != 0) {
+            WOLFSSL_MSG("Bad mutex init");
+            wolfSSL_CertManagerFree(cm);
+            return NULL;
+        }
+        #endif
+
         /* set default minimum key size allowed */
         #ifndef NO_RSA
             cm->minRsaKeySz = MIN_RSAKEY_SZ;
@@ -3635,6 +3671,9 @@ void wolfSSL_CertManagerFree(WOLFSSL_CERT_MANAGER* cm)
                 FreeOCSP(cm->ocsp_stapling, 1);
         #endif
         #endif
+    #ifdef WOLFSSL_CA_INDEX
+        CaIndexFree(cm);
+    #endif
         FreeSignerTable(cm->caTable, CA_TABLE_SIZE, cm->heap);
         wc_FreeMutex(&cm->caLock);
 
@@ -3643,6 +3682,10 @@ void wolfSSL_CertManagerFree(WOLFSSL_CERT_MANAGER* cm)
         wc_FreeMutex(&cm->tpLock);
         #endif
 
+        #ifdef WOLFSSL_CHAIN_CACHE
+        wc_FreeMutex(&cm->chainLock);
+        #endif
+
         XFREE(cm, cm->heap, DYNAMIC_TYPE_CERT_MANAGER);
     }
 
@@ -3855,10 +3898,17 @@ int wolfSSL_CertManagerUnloadCAs(WOLFSSL_CERT_MANAGER* cm)
     if (wc_LockMutex(&cm->caLock) != 0)
         return BAD_MUTEX_E;
 
+#ifdef WOLFSSL_CA_INDEX
+    CaIndexFree(cm); /* no lookup can reach the signers after this */
+#endif
     FreeSignerTable(cm->caTable, CA_TABLE_SIZE, cm->heap);
 
     wc_UnLockMutex(&cm->caLock);
 
+#ifdef WOLFSSL_CHAIN_CACHE
+    /* cached chains may lead to a CA that is gone */
+    ChainCacheFlush(cm);
+#endif
 
     return WOLFSSL_SUCCESS;
 }
@@ -4156,6 +4206,252 @@ static WC_INLINE word32 HashSigner(const byte* hash)
     return MakeWordFromHash(hash) % CA_TABLE_SIZE;
 }
 
+#ifdef WOLFSSL_CA_INDEX
+/* First slot to look in for the hash. Mixed since key IDs that are not
+ * SHA-1 of the key can have structure in the first bytes. */
+static WC_INLINE word32 CaIndexSlot(word32 size, const byte* hash)
+{
+    word32 w = MakeWordFromHash(hash) * 0x9E3779B1U;
+
+    return (w ^ (w >> 16)) & (size - 1);
+}
+
+/* Subject key ID hash (byName 0) or subject name hash (byName 1) */
+static WC_INLINE const byte* CaIndexHash(const Signer* signer, int byName)
+{
+#ifndef NO_SKID
+    if (!byName)
+        return signer->subjectKeyIdHash;
+#endif
+    (void)byName;
+    return signer->subjectNameHash;
+}
+
+/* Put signer in the slot of one with the same hash (a re-issued CA, newest
+ * wins like the caTable row head) or the first empty slot, table has space */
+static void CaIndexPut(Signer** table, word32 size, Signer* signer,
+                       int byName)
+{
+    const byte* hash = CaIndexHash(signer, byName);
+    word32 i = CaIndexSlot(size, hash);
+
+    while (table[i] != NULL) {
+        if (XMEMCMP(hash, CaIndexHash(table[i], byName),
+                    SIGNER_DIGEST_SIZE) == 0)
+            break;
+        i = (i + 1) & (size - 1);
+    }
+    CA_INDEX_STORE(table[i], signer);
+}
+
+static void CaIndexAddSigner(CaIndex* idx, Signer* signer)
+{
+#ifndef NO_SKID
+    CaIndexPut(idx->byKeyId, idx->size, signer, 0);
+#endif
+    CaIndexPut(idx->byName, idx->size, signer, 1);
+    idx->count++;
+}
+
+/* Make sure the index has room for n more signers, have caLock.
+ * A bigger index is filled before it is published so lookups never see a
+ * partial one, the old one is kept on the retired list. */
+static int CaIndexReserve(WOLFSSL_CERT_MANAGER* cm, word32 n)
+{
+    CaIndex* idx = cm->caIndex;
+    CaIndex* grown;
+    word32   count = (idx != NULL) ? idx->count : 0;
+    word32   size = (idx != NULL) ? idx->size : CA_INDEX_MIN_SZ;
+    word32   tables = 1;
+    word32   i;
+
+    while ((count + n) * 2 > size)
+        size *= 2;
+    if (idx != NULL && size == idx->size)
+        return 0;
+
+#ifndef NO_SKID
+    tables = 2;
+#endif
+    grown = (CaIndex*)XMALLOC(sizeof(CaIndex) + tables * size * sizeof(Signer*),
+                              cm->heap, DYNAMIC_TYPE_CA);
+    if (grown == NULL)
+        return MEMORY_E;
+    XMEMSET(grown, 0, sizeof(CaIndex) + tables * size * sizeof(Signer*));
+    grown->size = size;
+    grown->byName = (Signer**)(grown + 1);
+#ifndef NO_SKID
+    grown->byKeyId = grown->byName + size;
+#endif
+
+    if (idx != NULL) {
+        /* copy each table, a shadowed signer is only in one of them */
+        for (i = 0; i < idx->size; i++) {
+        #ifndef NO_SKID
+            if (idx->byKeyId[i] != NULL)
+                CaIndexPut(grown->byKeyId, size, idx->byKeyId[i], 0);
+        #endif
+            if (idx->byName[i] != NULL)
+                CaIndexPut(grown->byName, size, idx->byName[i], 1);
+        }
+        grown->count = idx->count;
+        grown->retired = idx;
+    }
+    CA_INDEX_STORE(cm->caIndex, grown);
+
+    return 0;
+}
+
+/* Add a new signer to the index, have caLock */
+static int CaIndexAdd(WOLFSSL_CERT_MANAGER* cm, Signer* signer)
+{
+    int ret = CaIndexReserve(cm, 1);
+
+    if (ret == 0)
+        CaIndexAddSigner(cm->caIndex, signer);
+
+    return ret;
+}
+
+/* Free the index and the ones it replaced, have caLock or cm is going.
+ * Returns once no lookup is probing it, call before freeing the signers */
+static void CaIndexFree(WOLFSSL_CERT_MANAGER* cm)
+{
+    CaIndex* idx = cm->caIndex;
+
+    CA_INDEX_DETACH(cm);
+    while (idx != NULL) {
+        CaIndex* next = idx->retired;
+        XFREE(idx, cm->heap, DYNAMIC_TYPE_CA);
+        idx = next;
+    }
+}
+
+/* Find the signer with the key ID hash (byName 0) or name hash (byName 1) */
+static Signer* CaIndexFind(WOLFSSL_CERT_MANAGER* cm, const byte* hash,
+                           int byName)
+{
+    CaIndex* idx;
+    Signer** table;
+    Signer*  signer = NULL;
+    word32   i;
+
+#ifdef CA_INDEX_LOCK_LOOKUP
+    if (wc_LockMutex(&cm->caLock) != 0)
+        return NULL;
+#endif
+    CA_INDEX_ENTER(cm, idx);
+    if (idx != NULL) {
+    #ifndef NO_SKID
+        table = byName ? idx->byName : idx->byKeyId;
+    #else
+        table = idx->byName;
+    #endif
+        i = CaIndexSlot(idx->size, hash);
+        while ((signer = CA_INDEX_LOAD(table[i])) != NULL) {
+            if (XMEMCMP(hash, CaIndexHash(signer, byName),
+                        SIGNER_DIGEST_SIZE) == 0)
+                break;
+            i = (i + 1) & (idx->size - 1);
+        }
+    }
+    CA_INDEX_LEAVE(cm);
+#ifdef CA_INDEX_LOCK_LOOKUP
+    wc_UnLockMutex(&cm->caLock);
+#endif
+
+    return signer;
+}
+#endif /* WOLFSSL_CA_INDEX */
+
+#ifdef WOLFSSL_CHAIN_CACHE
+/* Copy out the verified chain with hash, returns 1 when found and not
+ * expired, else 0 */
+int ChainCacheGet(WOLFSSL_CERT_MANAGER* cm, const byte* hash,
+                  ChainCacheEntry* entry)
+{
+    ChainCacheEntry* e;
+    int found = 0;
+    int i;
+
+    if (wc_LockMutex(&cm->chainLock) != 0)
+        return 0;
+
+    for (i = 0; i < WOLFSSL_CHAIN_CACHE_SZ; i++) {
+        e = &cm->chainCache[i];
+        if (e->lastUse == 0 ||
+                XMEMCMP(e->hash, hash, WC_SHA256_DIGEST_SIZE) != 0)
+            continue;
+    #ifndef NO_ASN_TIME
+        if (!XVALIDATE_DATE(e->notAfter, e->notAfterFormat, AFTER)) {
+            WOLFSSL_MSG("Cached chain has expired");
+            XMEMSET(e, 0, sizeof(ChainCacheEntry));
+            break;
+        }
+    #endif
+        e->lastUse = ++cm->chainCacheUse;
+        cm->chainCacheHits++;
+        XMEMCPY(entry, e, sizeof(ChainCacheEntry));
+        found = 1;
+        break;
+    }
+
+    wc_UnLockMutex(&cm->chainLock);
+
+    return found;
+}
+
+/* Store a verified chain, replacing the least recently used one */
+void ChainCacheAdd(WOLFSSL_CERT_MANAGER* cm, const ChainCacheEntry* entry)
+{
+    ChainCacheEntry* e = &cm->chainCache[0];
+    int i;
+
+    if (wc_LockMutex(&cm->chainLock) != 0)
+        return;
+
+    for (i = 0; i < WOLFSSL_CHAIN_CACHE_SZ; i++) {
+        ChainCacheEntry* c = &cm->chainCache[i];
+
+        if (c->lastUse == 0 ||
+                XMEMCMP(c->hash, entry->hash, WC_SHA256_DIGEST_SIZE) == 0) {
+            e = c;
+            break;
+        }
+        if (c->lastUse < e->lastUse)
+            e = c;
+    }
+    XMEMCPY(e, entry, sizeof(ChainCacheEntry));
+    e->lastUse = ++cm->chainCacheUse;
+
+    wc_UnLockMutex(&cm->chainLock);
+}
+
+/* Forget all verified chains */
+void ChainCacheFlush(WOLFSSL_CERT_MANAGER* cm)
+{
+    if (wc_LockMutex(&cm->chainLock) != 0)
+        return;
+
+    XMEMSET(cm->chainCache, 0, sizeof(cm->chainCache));
+    cm->chainCacheUse = 0;
+
+    wc_UnLockMutex(&cm->chainLock);
+}
+
+int wolfSSL_CertManagerFlushChainCache(WOLFSSL_CERT_MANAGER* cm)
+{
+    WOLFSSL_ENTER("wolfSSL_CertManagerFlushChainCache");
+
+    if (cm == NULL)
+        return BAD_FUNC_ARG;
+
+    ChainCacheFlush(cm);
+
+    return WOLFSSL_SUCCESS;
+}
+#endif /* WOLFSSL_CHAIN_CACHE */
+
 
 /* does CA already exist on signer list */
 int AlreadySigner(WOLFSSL_CERT_MANAGER* cm, byte* hash)
@@ -4168,6 +4464,11 @@ int AlreadySigner(WOLFSSL_CERT_MANAGER* cm, byte* hash)
         return ret;
     }
 
+#ifdef WOLFSSL_CA_INDEX
+    (void)signers;
+    (void)row;
+    return CaIndexFind(cm, hash, 0) != NULL;
+#else
     row = HashSigner(hash);
 
     if (wc_LockMutex(&cm->caLock) != 0) {
@@ -4192,6 +4493,7 @@ int AlreadySigner(WOLFSSL_CERT_MANAGER* cm, byte* hash)
     wc_UnLockMutex(&cm->caLock);
 
     return ret;
+#endif /* WOLFSSL_CA_INDEX */
 }
 
 
@@ -4312,6 +4614,12 @@ Signer* GetCA(void* vp, byte* hash)
     if (cm == NULL)
         return NULL;
 
+#ifdef WOLFSSL_CA_INDEX
+    (void)ret;
+    (void)signers;
+    (void)row;
+    return CaIndexFind(cm, hash, 0);
+#else
     if (wc_LockMutex(&cm->caLock) != 0)
         return ret;
 
@@ -4332,6 +4640,7 @@ Signer* GetCA(void* vp, byte* hash)
     wc_UnLockMutex(&cm->caLock);
 
     return ret;
+#endif /* WOLFSSL_CA_INDEX */
 }
 
 
@@ -4347,6 +4656,12 @@ Signer* GetCAByName(void* vp, byte* hash)
     if (cm == NULL)
         return NULL;
 
+#ifdef WOLFSSL_CA_INDEX
+    (void)ret;
+    (void)signers;
+    (void)row;
+    return CaIndexFind(cm, hash, 1);
+#else
     if (wc_LockMutex(&cm->caLock) != 0)
         return ret;
 
@@ -4363,6 +4678,7 @@ Signer* GetCAByName(void* vp, byte* hash)
     wc_UnLockMutex(&cm->caLock);
 
     return ret;
+#endif /* WOLFSSL_CA_INDEX */
 }
 #endif
 
@@ -4659,10 +4975,20 @@ int AddCA(WOLFSSL_CERT_MANAGER* cm, DerBuffer** pDer, int type, int verify)
     #endif
 
         if (wc_LockMutex(&cm->caLock) == 0) {
-            signer->next = cm->caTable[row];
-            cm->caTable[row] = signer;   /* takes ownership */
+        #ifdef WOLFSSL_CA_INDEX
+            ret = CaIndexAdd(cm, signer);
+            if (ret != 0) {
+                FreeSigner(signer, cm->heap);
+                signer = NULL;
+            }
+            else
+        #endif
+            {
+                signer->next = cm->caTable[row];
+                cm->caTable[row] = signer;   /* takes ownership */
+            }
             wc_UnLockMutex(&cm->caLock);
-            if (cm->caCacheCallback)
+            if (ret == 0 && cm->caCacheCallback)
                 cm->caCacheCallback(der->buffer, (int)der->length, type);
         }
         else {
@@ -4752,6 +5078,39 @@ int AddCA(WOLFSSL_CERT_MANAGER* cm, DerBuffer** pDer, int type, int verify)
         #define SESSION_ROWS 11
     #endif
 
+#ifdef WOLFSSL_SESSION_CACHE_SHARDED
+    /* Sharded cache: each row has its own lock, so lookups and inserts that
+       hash to different rows run in parallel. The table is allocated by
+       wolfSSL_Init(), the presets above only give the default size, see
+       wolfSSL_SetSessionCacheSize(). A full row evicts an expired session
+       first, otherwise the least recently used one. */
+    #ifdef PERSIST_SESSION_CACHE
+        #error PERSIST_SESSION_CACHE not supported with a sharded session cache
+    #endif
+
+    static const word32 SessionRowsDefault   = SESSION_ROWS;
+    static const word32 SessionsPerRowDefault = SESSIONS_PER_ROW;
+    static WOLFSSL_GLOBAL word32 SessionRows    = SESSION_ROWS;
+    static WOLFSSL_GLOBAL word32 SessionsPerRow = SESSIONS_PER_ROW;
+
+    #undef  SESSION_ROWS
+    #undef  SESSIONS_PER_ROW
+    #define SESSION_ROWS     SessionRows
+    #define SESSIONS_PER_ROW SessionsPerRow
+
+    typedef struct SessionRow {
+        int totalCount;                        /* sessions ever on this row */
+        word32 useTick;                        /* row LRU clock             */
+        word32* lastUse;               /* useTick at last use, 0 when free  */
+        WOLFSSL_SESSION* Sessions;
+        wolfSSL_Mutex lock;            /* row and same ClientCache row      */
+    } SessionRow;
+
+    static WOLFSSL_GLOBAL SessionRow* SessionCache = NULL;
+    static WOLFSSL_GLOBAL WOLFSSL_SESSION* SessionStore = NULL; /* all rows */
+
+    #define SESSION_ROW_MUTEX(row) (&SessionCache[(row)].lock)
+#else
     typedef struct SessionRow {
         int nextIdx;                           /* where to place next one   */
         int totalCount;                        /* sessions ever on this row */
@@ -4760,6 +5119,9 @@ int AddCA(WOLFSSL_CERT_MANAGER* cm, DerBuffer** pDer, int type, int verify)
 
     static WOLFSSL_GLOBAL SessionRow SessionCache[SESSION_ROWS];
 
+    #define SESSION_ROW_MUTEX(row) (&session_mutex)
+#endif /* WOLFSSL_SESSION_CACHE_SHARDED */
+
     #if defined(WOLFSSL_SESSION_STATS) && defined(WOLFSSL_PEAK_SESSIONS)
         static WOLFSSL_GLOBAL word32 PeakSessions;
     #endif
@@ -4773,6 +5135,17 @@ int AddCA(WOLFSSL_CERT_MANAGER* cm, DerBuffer** pDer, int type, int verify)
             word16 serverIdx;            /* SessionCache Idx (column) */
         } ClientSession;
 
+    #ifdef WOLFSSL_SESSION_CACHE_SHARDED
+        typedef struct ClientRow {
+            int nextIdx;                /* where to place next one   */
+            int totalCount;             /* sessions ever on this row */
+            ClientSession* Clients;
+        } ClientRow;
+
+        static WOLFSSL_GLOBAL ClientRow* ClientCache = NULL;
+                                                     /* Client Cache */
+                                                     /* uses row mutex */
+    #else
         typedef struct ClientRow {
             int nextIdx;                /* where to place next one   */
             int totalCount;             /* sessions ever on this row */
@@ -4782,8 +5155,224 @@ int AddCA(WOLFSSL_CERT_MANAGER* cm, DerBuffer** pDer, int type, int verify)
         static WOLFSSL_GLOBAL ClientRow ClientCache[SESSION_ROWS];
                                                      /* Client Cache */
                                                      /* uses session mutex */
+    #endif
     #endif  /* NO_CLIENT_CACHE */
 
+#ifdef WOLFSSL_SESSION_CACHE_SHARDED
+static void FreeSessionCacheMem(void)
+{
+    /* lastUse columns share the SessionCache allocation */
+    XFREE(SessionCache, NULL, DYNAMIC_TYPE_SESSION);
+    XFREE(SessionStore, NULL, DYNAMIC_TYPE_SESSION);
+    SessionCache = NULL;
+    SessionStore = NULL;
+#ifndef NO_CLIENT_CACHE
+    XFREE(ClientCache, NULL, DYNAMIC_TYPE_SESSION);
+    ClientCache = NULL;
+#endif
+}
+
+static int FreeSessionCache(void)
+{
+    int    ret = 0;
+    word32 i;
+
+    if (SessionCache == NULL)
+        return 0;
+
+    for (i = 0; i < SESSION_ROWS; i++) {
+        if (wc_FreeMutex(&SessionCache[i].lock) != 0)
+            ret = BAD_MUTEX_E;
+    }
+#ifdef HAVE_SESSION_TICKET
+    for (i = 0; i < SESSION_ROWS * SESSIONS_PER_ROW; i++) {
+        if (SessionStore[i].isDynamic)
+            XFREE(SessionStore[i].ticket, NULL, DYNAMIC_TYPE_SESSION_TICK);
+    }
+#endif
+    FreeSessionCacheMem();
+
+    return ret;
+}
+
+static int InitSessionCache(void)
+{
+    word32 i;
+    word32 cols   = SESSION_ROWS * SESSIONS_PER_ROW;
+    word32 rowsSz = SESSION_ROWS * (word32)sizeof(SessionRow);
+    word32 useSz  = cols * (word32)sizeof(word32);
+#ifndef NO_CLIENT_CACHE
+    word32 clSz   = SESSION_ROWS * (word32)sizeof(ClientRow) +
+                    cols * (word32)sizeof(ClientSession);
+    ClientSession* clients;
+#endif
+
+    SessionCache = (SessionRow*)XMALLOC(rowsSz + useSz, NULL,
+                                        DYNAMIC_TYPE_SESSION);
+    SessionStore = (WOLFSSL_SESSION*)XMALLOC(cols * sizeof(WOLFSSL_SESSION),
+                                             NULL, DYNAMIC_TYPE_SESSION);
+#ifndef NO_CLIENT_CACHE
+    ClientCache = (ClientRow*)XMALLOC(clSz, NULL, DYNAMIC_TYPE_SESSION);
+    if (ClientCache == NULL) {
+        FreeSessionCacheMem();
+        return MEMORY_E;
+    }
+    XMEMSET(ClientCache, 0, clSz);
+    clients = (ClientSession*)(ClientCache + SESSION_ROWS);
+#endif
+    if (SessionCache == NULL || SessionStore == NULL) {
+        FreeSessionCacheMem();
+        return MEMORY_E;
+    }
+    XMEMSET(SessionCache, 0, rowsSz + useSz);
+    XMEMSET(SessionStore, 0, cols * sizeof(WOLFSSL_SESSION));
+
+    for (i = 0; i < SESSION_ROWS; i++) {
+        SessionCache[i].lastUse  = (word32*)((byte*)SessionCache + rowsSz) +
+                                   i * SESSIONS_PER_ROW;
+        SessionCache[i].Sessions = SessionStore + i * SESSIONS_PER_ROW;
+    #ifndef NO_CLIENT_CACHE
+        ClientCache[i].Clients   = clients + i * SESSIONS_PER_ROW;
+    #endif
+        if (wc_InitMutex(&SessionCache[i].lock) != 0) {
+            WOLFSSL_MSG("Bad Init Mutex session row");
+            while (i-- > 0)
+                wc_FreeMutex(&SessionCache[i].lock);
+            FreeSessionCacheMem();
+            return BAD_MUTEX_E;
+        }
+    }
+
+    return 0;
+}
+
+/* Returns the column of id in a locked row, or -1 */
+static int FindSessionInRow(SessionRow* sessRow, const byte* id)
+{
+    word32 i;
+
+    for (i = 0; i < SESSIONS_PER_ROW; i++) {
+        if (sessRow->lastUse[i] != 0 &&
+                XMEMCMP(sessRow->Sessions[i].sessionID, id, ID_LEN) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+/* Marks a column of a locked row as most recently used */
+static WC_INLINE void TouchSession(SessionRow* sessRow, word32 idx)
+{
+    if (++sessRow->useTick == 0)
+        sessRow->useTick = 1; /* 0 means free */
+    sessRow->lastUse[idx] = sessRow->useTick;
+}
+
+/* Column to store a new session in a locked row: a free one, else the first
+ * expired one, else the least recently used one */
+static word32 EvictSessionInRow(SessionRow* sessRow, word32 now)
+{
+    word32 i;
+    word32 lru = 0;
+
+    for (i = 0; i < SESSIONS_PER_ROW; i++) {
+        WOLFSSL_SESSION* current = &sessRow->Sessions[i];
+
+        if (sessRow->lastUse[i] == 0)
+            return i;
+        if (now >= current->bornOn + current->timeout) {
+            WOLFSSL_MSG("Evicting expired session");
+            return i;
+        }
+        /* distance back from the row clock, so wrap around is ok */
+        if (sessRow->useTick - sessRow->lastUse[i] >
+                                  sessRow->useTick - sessRow->lastUse[lru]) {
+            lru = i;
+        }
+    }
+    WOLFSSL_MSG("Evicting least recently used session");
+    return lru;
+}
+
+
+/* Size of the sharded session cache, rows of sessionsPerRow sessions each.
+ * Call before wolfSSL_Init(), 0 restores the compile time default.
+ * Returns WOLFSSL_SUCCESS, BAD_FUNC_ARG or BAD_STATE_E after wolfSSL_Init() */
+int wolfSSL_SetSessionCacheSize(word32 rows, word32 sessionsPerRow)
+{
+    WOLFSSL_ENTER("wolfSSL_SetSessionCacheSize");
+
+    if (rows == 0)
+        rows = SessionRowsDefault;
+    if (sessionsPerRow == 0)
+        sessionsPerRow = SessionsPerRowDefault;
+
+    /* ClientSession stores row and column as word16 */
+    if (rows > 0xFFFF || sessionsPerRow > 0xFFFF)
+        return BAD_FUNC_ARG;
+#ifdef SESSION_INDEX
+    if (rows > (0x7FFFFFFF >> SESSIDX_ROW_SHIFT) ||
+                                        sessionsPerRow > SESSIDX_IDX_MASK + 1)
+        return BAD_FUNC_ARG;
+#endif
+
+    if (initRefCount != 0 || SessionCache != NULL)
+        return BAD_STATE_E;
+
+    SESSION_ROWS     = rows;
+    SESSIONS_PER_ROW = sessionsPerRow;
+
+    return WOLFSSL_SUCCESS;
+}
+#endif /* WOLFSSL_SESSION_CACHE_SHARDED */
+
+/* Lock protecting a session, the row lock when it is in the cache */
+static WC_INLINE wolfSSL_Mutex* SessionMutex(const WOLFSSL_SESSION* session)
+{
+#ifdef WOLFSSL_SESSION_CACHE_SHARDED
+    if (SessionStore != NULL && session >= SessionStore &&
+                    session < SessionStore + SESSION_ROWS * SESSIONS_PER_ROW) {
+        return SESSION_ROW_MUTEX((word32)(session - SessionStore) /
+                                                             SESSIONS_PER_ROW);
+    }
+#endif
+    (void)session;
+    return &session_mutex;
+}
+
+/* Locks the cache rows for a session and its client cache entry, in row
+ * order when they have different locks. Returns 0 or BAD_MUTEX_E */
+static int LockSessionRows(word32 row, word32 clientRow)
+{
+    wolfSSL_Mutex* first  = SESSION_ROW_MUTEX(min(row, clientRow));
+    wolfSSL_Mutex* second = SESSION_ROW_MUTEX(max(row, clientRow));
+
+    (void)clientRow;
+
+    if (wc_LockMutex(first) != 0)
+        return BAD_MUTEX_E;
+    if (second != first && wc_LockMutex(second) != 0) {
+        wc_UnLockMutex(first);
+        return BAD_MUTEX_E;
+    }
+    return 0;
+}
+
+static int UnLockSessionRows(word32 row, word32 clientRow)
+{
+    int ret = 0;
+    wolfSSL_Mutex* first  = SESSION_ROW_MUTEX(row);
+    wolfSSL_Mutex* second = SESSION_ROW_MUTEX(clientRow);
+
+    (void)clientRow;
+
+    if (second != first && wc_UnLockMutex(second) != 0)
+        ret = BAD_MUTEX_E;
+    if (wc_UnLockMutex(first) != 0)
+        ret = BAD_MUTEX_E;
+    return ret;
+}
+
 #endif /* NO_SESSION_CACHE */
 
 WOLFSSL_ABI
@@ -4810,6 +5399,12 @@ int wolfSSL_Init(void)
             WOLFSSL_MSG("Bad Init Mutex session");
             return BAD_MUTEX_E;
         }
+    #ifdef WOLFSSL_SESSION_CACHE_SHARDED
+        if (InitSessionCache() != 0) {
+            WOLFSSL_MSG("Session cache init failed");
+            return WC_INIT_E;
+        }
+    #endif
 #endif
         if (wc_InitMutex(&count_mutex) != 0) {
             WOLFSSL_MSG("Bad Init Mutex count");
@@ -5946,6 +6541,73 @@ int wolfSSL_CertManagerLoadCABuffer(WOLFSSL_CERT_MANAGER* cm,
     return ret;
 }
 
+/* Load a bundle of concatenated DER CA certs, stops at the first bad one.
+ * The CTX is made once for the bundle and the index is sized up front.
+ * return WOLFSSL_SUCCESS on success */
+int wolfSSL_CertManagerLoadCABundle(WOLFSSL_CERT_MANAGER* cm,
+                                    const unsigned char* in, long sz)
+{
+    int ret = WOLFSSL_FATAL_ERROR;
+    WOLFSSL_CTX* tmp;
+    word32 idx = 0;
+    word32 certs = 0;
+    int len;
+
+    WOLFSSL_ENTER("wolfSSL_CertManagerLoadCABundle");
+
+    if (cm == NULL || in == NULL || sz <= 0) {
+        WOLFSSL_MSG("Bad CA bundle argument");
+        return BAD_FUNC_ARG;
+    }
+
+    /* count the certs */
+    while (idx < (word32)sz) {
+        if (GetSequence(in, &idx, &len, (word32)sz) < 0)
+            return ASN_PARSE_E;
+        idx += len;
+        certs++;
+    }
+
+#ifdef WOLFSSL_CA_INDEX
+    if (wc_LockMutex(&cm->caLock) != 0)
+        return BAD_MUTEX_E;
+    ret = CaIndexReserve(cm, certs);
+    wc_UnLockMutex(&cm->caLock);
+    if (ret != 0)
+        return ret;
+#endif
+
+    tmp = wolfSSL_CTX_new(cm_pick_method());
+    if (tmp == NULL) {
+        WOLFSSL_MSG("CTX new failed");
+        return WOLFSSL_FATAL_ERROR;
+    }
+
+    /* for tmp use */
+    wolfSSL_CertManagerFree(tmp->cm);
+    tmp->cm = cm;
+
+    ret = WOLFSSL_SUCCESS;
+    for (idx = 0; ret == WOLFSSL_SUCCESS && idx < (word32)sz; idx += len) {
+        word32 start = idx;
+
+        if (GetSequence(in, &idx, &len, (word32)sz) < 0) {
+            ret = ASN_PARSE_E;
+            break;
+        }
+        len += (int)(idx - start);
+        idx = start;
+        ret = wolfSSL_CTX_load_verify_buffer(tmp, in + idx, len,
+                                             WOLFSSL_FILETYPE_ASN1);
+    }
+
+    /* don't loose our good one */
+    tmp->cm = NULL;
+    wolfSSL_CTX_free(tmp);
+
+    return ret;
+}
+
 #ifdef HAVE_CRL
 
 int wolfSSL_CertManagerLoadCRLBuffer(WOLFSSL_CERT_MANAGER* cm,
@@ -5965,6 +6627,39 @@ int wolfSSL_CertManagerLoadCRLBuffer(WOLFSSL_CERT_MANAGER* cm,
     return BufferLoadCRL(cm->crl, buff, sz, type, VERIFY);
 }
 
+#ifdef WOLFSSL_CRL_INDEX
+/* Load CRLs saved with wolfSSL_CertManagerSaveCRLIndex(), the revoked serial
+ * tables are used in place so buff must stay until the CRLs are freed */
+int wolfSSL_CertManagerLoadCRLIndex(WOLFSSL_CERT_MANAGER* cm,
+                                    const unsigned char* buff, long sz)
+{
+    WOLFSSL_ENTER("wolfSSL_CertManagerLoadCRLIndex");
+    if (cm == NULL)
+        return BAD_FUNC_ARG;
+
+    if (cm->crl == NULL) {
+        if (wolfSSL_CertManagerEnableCRL(cm, 0) != WOLFSSL_SUCCESS) {
+            WOLFSSL_MSG("Enable CRL failed");
+            return WOLFSSL_FATAL_ERROR;
+        }
+    }
+
+    return BufferLoadCRLIndex(cm->crl, buff, sz);
+}
+
+/* Save the verified CRLs as an index that loads without parsing.
+ * With buff NULL sets sz and returns LENGTH_ONLY_E */
+int wolfSSL_CertManagerSaveCRLIndex(WOLFSSL_CERT_MANAGER* cm,
+                                    unsigned char* buff, word32* sz)
+{
+    WOLFSSL_ENTER("wolfSSL_CertManagerSaveCRLIndex");
+    if (cm == NULL || cm->crl == NULL)
+        return BAD_FUNC_ARG;
+
+    return SaveCRLIndex(cm->crl, buff, sz);
+}
+#endif /* WOLFSSL_CRL_INDEX */
+
 int wolfSSL_CertManagerFreeCRL(WOLFSSL_CERT_MANAGER* cm)
 {
     WOLFSSL_ENTER("wolfSSL_CertManagerFreeCRL");
@@ -10939,6 +11634,12 @@ static WC_INLINE int RestoreCertRow(WOLFSSL_CERT_MANAGER* cm, byte* current,
             idx += SIGNER_DIGEST_SIZE;
         #endif
 
+    #ifdef WOLFSSL_CA_INDEX
+        if (CaIndexAdd(cm, signer) != 0) {
+            FreeSigner(signer, cm->heap);
+            return MEMORY_E;
+        }
+    #endif
         signer->next = cm->caTable[row];
         cm->caTable[row] = signer;
 
@@ -11177,6 +11878,9 @@ int CM_MemRestoreCertCache(WOLFSSL_CERT_MANAGER* cm, const void* mem, int sz)
         return BAD_MUTEX_E;
     }
 
+#ifdef WOLFSSL_CA_INDEX
+    CaIndexFree(cm); /* no lookup can reach the signers after this */
+#endif
     FreeSignerTable(cm->caTable, CA_TABLE_SIZE, cm->heap);
 
     for (i = 0; i < CA_TABLE_SIZE; ++i) {
@@ -12490,6 +13194,10 @@ int wolfSSL_Cleanup(void)
 #ifndef NO_SESSION_CACHE
     if (wc_FreeMutex(&session_mutex) != 0)
         ret = BAD_MUTEX_E;
+    #ifdef WOLFSSL_SESSION_CACHE_SHARDED
+    if (FreeSessionCache() != 0)
+        ret = BAD_MUTEX_E;
+    #endif
 #endif
     if (wc_FreeMutex(&count_mutex) != 0)
         ret = BAD_MUTEX_E;
@@ -12532,9 +13240,36 @@ static WC_INLINE word32 HashSession(const byte* sessionID, word32 len, int* erro
 WOLFSSL_ABI
 void wolfSSL_flush_sessions(WOLFSSL_CTX* ctx, long tm)
 {
+#ifdef WOLFSSL_SESSION_CACHE_SHARDED
+    /* free the columns of sessions expired at time tm, so they are reused
+     * before any live session is evicted */
+    word32 i, j;
+
+    (void)ctx;
+
+    if (SessionCache == NULL)
+        return;
+
+    for (i = 0; i < SESSION_ROWS; i++) {
+        SessionRow* sessRow = &SessionCache[i];
+
+        if (wc_LockMutex(&sessRow->lock) != 0)
+            continue;
+        for (j = 0; j < SESSIONS_PER_ROW; j++) {
+            WOLFSSL_SESSION* current = &sessRow->Sessions[j];
+
+            if (sessRow->lastUse[j] != 0 &&
+                    (word32)tm >= current->bornOn + current->timeout) {
+                sessRow->lastUse[j] = 0;
+            }
+        }
+        wc_UnLockMutex(&sessRow->lock);
+    }
+#else
     /* static table now, no flushing needed */
     (void)ctx;
     (void)tm;
+#endif
 }
 
 
@@ -12607,7 +13342,7 @@ WOLFSSL_SESSION* GetSessionClient(WOLFSSL* ssl, const byte* id, int len)
         return NULL;
     }
 
-    if (wc_LockMutex(&session_mutex) != 0) {
+    if (wc_LockMutex(SESSION_ROW_MUTEX(row)) != 0) {
         WOLFSSL_MSG("Lock session mutex failed");
         return NULL;
     }
@@ -12618,11 +13353,12 @@ WOLFSSL_SESSION* GetSessionClient(WOLFSSL* ssl, const byte* id, int len)
     if (idx < 0)
         idx = SESSIONS_PER_ROW - 1; /* if back to front, the previous was end */
 
-    for (; count > 0; --count, idx = idx ? idx - 1 : SESSIONS_PER_ROW - 1) {
+    for (; count > 0;
+                  --count, idx = idx ? idx - 1 : (int)SESSIONS_PER_ROW - 1) {
         WOLFSSL_SESSION* current;
         ClientSession   clSess;
 
-        if (idx >= SESSIONS_PER_ROW || idx < 0) { /* sanity check */
+        if (idx >= (int)SESSIONS_PER_ROW || idx < 0) { /* sanity check */
             WOLFSSL_MSG("Bad idx");
             break;
         }
@@ -12630,6 +13366,30 @@ WOLFSSL_SESSION* GetSessionClient(WOLFSSL* ssl, const byte* id, int len)
         clSess = ClientCache[row].Clients[idx];
 
         current = &SessionCache[clSess.serverRow].Sessions[clSess.serverIdx];
+    #ifdef WOLFSSL_SESSION_CACHE_SHARDED
+        /* check the server session under its own row lock, only one row
+         * lock is held at a time */
+        wc_UnLockMutex(SESSION_ROW_MUTEX(row));
+        if (wc_LockMutex(SESSION_ROW_MUTEX(clSess.serverRow)) != 0) {
+            WOLFSSL_MSG("Lock session mutex failed");
+            return NULL;
+        }
+        if (SessionCache[clSess.serverRow].lastUse[clSess.serverIdx] != 0 &&
+                XMEMCMP(current->serverID, id, len) == 0 &&
+                LowResTimer() < (current->bornOn + current->timeout)) {
+            WOLFSSL_MSG("Session valid");
+            TouchSession(&SessionCache[clSess.serverRow], clSess.serverIdx);
+            ret = current;
+        }
+        wc_UnLockMutex(SESSION_ROW_MUTEX(clSess.serverRow));
+        if (ret != NULL)
+            return ret;
+        if (wc_LockMutex(SESSION_ROW_MUTEX(row)) != 0) {
+            WOLFSSL_MSG("Lock session mutex failed");
+            return NULL;
+        }
+        continue;
+    #endif
         if (XMEMCMP(current->serverID, id, len) == 0) {
             WOLFSSL_MSG("Found a serverid match for client");
             if (LowResTimer() < (current->bornOn + current->timeout)) {
@@ -12644,7 +13404,7 @@ WOLFSSL_SESSION* GetSessionClient(WOLFSSL* ssl, const byte* id, int len)
         }
     }
 
-    wc_UnLockMutex(&session_mutex);
+    wc_UnLockMutex(SESSION_ROW_MUTEX(row));
 
     return ret;
 }
@@ -12666,6 +13426,9 @@ static WC_INLINE void RestoreSession(WOLFSSL* ssl, WOLFSSL_SESSION* session,
 
     if (masterSecret)
         XMEMCPY(masterSecret, session->masterSecret, SECRET_LEN);
+    /* copied under the cache lock, the cached session can change once the
+     * lock is released */
+    ssl->session.haveEMS = session->haveEMS;
 #ifdef SESSION_CERTS
     /* If set, we should copy the session certs into the ssl object
      * from the session we are returning so we can resume */
@@ -12734,9 +13497,27 @@ WOLFSSL_SESSION* GetSession(WOLFSSL* ssl, byte* masterSecret,
         return NULL;
     }
 
-    if (wc_LockMutex(&session_mutex) != 0)
+    if (wc_LockMutex(SESSION_ROW_MUTEX(row)) != 0)
         return 0;
 
+#ifdef WOLFSSL_SESSION_CACHE_SHARDED
+    (void)count;
+    idx = FindSessionInRow(&SessionCache[row], id);
+    if (idx >= 0) {
+        WOLFSSL_SESSION* current = &SessionCache[row].Sessions[idx];
+
+        WOLFSSL_MSG("Found a session match");
+        if (LowResTimer() < (current->bornOn + current->timeout)) {
+            WOLFSSL_MSG("Session valid");
+            TouchSession(&SessionCache[row], (word32)idx);
+            ret = current;
+            RestoreSession(ssl, ret, masterSecret, restoreSessionCerts);
+        } else {
+            WOLFSSL_MSG("Session timed out");
+            SessionCache[row].lastUse[idx] = 0; /* free for reuse */
+        }
+    }
+#else
     /* start from most recently used */
     count = min((word32)SessionCache[row].totalCount, SESSIONS_PER_ROW);
     idx = SessionCache[row].nextIdx - 1;
@@ -12766,8 +13547,9 @@ WOLFSSL_SESSION* GetSession(WOLFSSL* ssl, byte* masterSecret,
             WOLFSSL_MSG("SessionID not a match at this idx");
         }
     }
+#endif /* WOLFSSL_SESSION_CACHE_SHARDED */
 
-    wc_UnLockMutex(&session_mutex);
+    wc_UnLockMutex(SESSION_ROW_MUTEX(row));
 
     return ret;
 }
@@ -12780,6 +13562,7 @@ static int GetDeepCopySession(WOLFSSL* ssl, WOLFSSL_SESSION* copyFrom)
     int ticketLen             = 0;
     int doDynamicCopy         = 0;
     int ret                   = WOLFSSL_SUCCESS;
+    wolfSSL_Mutex* mutex;
 
     (void)ticketLen;
     (void)doDynamicCopy;
@@ -12788,6 +13571,8 @@ static int GetDeepCopySession(WOLFSSL* ssl, WOLFSSL_SESSION* copyFrom)
     if (!ssl || !copyFrom)
         return BAD_FUNC_ARG;
 
+    mutex = SessionMutex(copyFrom);
+
 #ifdef HAVE_SESSION_TICKET
     /* Free old dynamic ticket if we had one to avoid leak */
     if (copyInto->isDynamic) {
@@ -12797,7 +13582,7 @@ static int GetDeepCopySession(WOLFSSL* ssl, WOLFSSL_SESSION* copyFrom)
     }
 #endif
 
-    if (wc_LockMutex(&session_mutex) != 0)
+    if (wc_LockMutex(mutex) != 0)
         return BAD_MUTEX_E;
 
 #ifdef HAVE_SESSION_TICKET
@@ -12819,13 +13604,13 @@ static int GetDeepCopySession(WOLFSSL* ssl, WOLFSSL_SESSION* copyFrom)
     copyInto->cipherSuite    = copyFrom->cipherSuite;
 #endif
 
-    if (wc_UnLockMutex(&session_mutex) != 0) {
+    if (wc_UnLockMutex(mutex) != 0) {
         return BAD_MUTEX_E;
     }
 
 #ifdef HAVE_SESSION_TICKET
 #ifdef WOLFSSL_TLS13
-    if (wc_LockMutex(&session_mutex) != 0) {
+    if (wc_LockMutex(mutex) != 0) {
         XFREE(tmpBuff, ssl->heap, DYNAMIC_TYPE_SESSION_TICK);
         return BAD_MUTEX_E;
     }
@@ -12844,7 +13629,7 @@ static int GetDeepCopySession(WOLFSSL* ssl, WOLFSSL_SESSION* copyFrom)
 #endif
     XMEMCPY(copyInto->masterSecret, copyFrom->masterSecret, SECRET_LEN);
 
-    if (wc_UnLockMutex(&session_mutex) != 0) {
+    if (wc_UnLockMutex(mutex) != 0) {
         if (ret == WOLFSSL_SUCCESS)
             ret = BAD_MUTEX_E;
     }
@@ -12857,7 +13642,7 @@ static int GetDeepCopySession(WOLFSSL* ssl, WOLFSSL_SESSION* copyFrom)
         if (!tmpBuff)
             return MEMORY_ERROR;
 
-        if (wc_LockMutex(&session_mutex) != 0) {
+        if (wc_LockMutex(mutex) != 0) {
             XFREE(tmpBuff, ssl->heap, DYNAMIC_TYPE_SESSION_TICK);
             return BAD_MUTEX_E;
         }
@@ -12880,7 +13665,7 @@ static int GetDeepCopySession(WOLFSSL* ssl, WOLFSSL_SESSION* copyFrom)
     }
 
     if (doDynamicCopy) {
-        if (wc_UnLockMutex(&session_mutex) != 0) {
+        if (wc_UnLockMutex(mutex) != 0) {
             if (ret == WOLFSSL_SUCCESS)
                 ret = BAD_MUTEX_E;
         }
@@ -12945,6 +13730,7 @@ int AddSession(WOLFSSL* ssl)
 {
     word32 row = 0;
     word32 idx = 0;
+    word32 clientRow = 0;
     int    error = 0;
     const byte* id = NULL;
 #ifdef HAVE_SESSION_TICKET
@@ -12955,6 +13741,8 @@ int AddSession(WOLFSSL* ssl)
     int i;
     int overwrite = 0;
 
+    (void)overwrite;
+
     if (ssl->options.sessionCacheOff)
         return 0;
 
@@ -13013,13 +13801,39 @@ int AddSession(WOLFSSL* ssl)
             return error;
         }
 
-        if (wc_LockMutex(&session_mutex) != 0) {
+        clientRow = row;
+#ifndef NO_CLIENT_CACHE
+        if (ssl->options.side == WOLFSSL_CLIENT_END && ssl->session.idLen) {
+            clientRow = HashSession(ssl->session.serverID,
+                    ssl->session.idLen, &error) % SESSION_ROWS;
+            if (error != 0) {
+                WOLFSSL_MSG("Hash session failed");
+#ifdef HAVE_SESSION_TICKET
+                XFREE(tmpBuff, ssl->heap, DYNAMIC_TYPE_SESSION_TICK);
+#endif
+                return error;
+            }
+        }
+#endif
+
+        if (LockSessionRows(row, clientRow) != 0) {
 #ifdef HAVE_SESSION_TICKET
             XFREE(tmpBuff, ssl->heap, DYNAMIC_TYPE_SESSION_TICK);
 #endif
             return BAD_MUTEX_E;
         }
 
+#ifdef WOLFSSL_SESSION_CACHE_SHARDED
+        i = FindSessionInRow(&SessionCache[row], id);
+        if (i >= 0) {
+            WOLFSSL_MSG("Session already exists. Overwriting.");
+            overwrite = 1;
+            idx = (word32)i;
+        }
+        else {
+            idx = EvictSessionInRow(&SessionCache[row], LowResTimer());
+        }
+#else
         for (i=0; i<SESSIONS_PER_ROW; i++) {
             if (XMEMCMP(id, SessionCache[row].Sessions[i].sessionID, ID_LEN) == 0) {
                 WOLFSSL_MSG("Session already exists. Overwriting.");
@@ -13032,6 +13846,7 @@ int AddSession(WOLFSSL* ssl)
         if (!overwrite) {
             idx = SessionCache[row].nextIdx++;
         }
+#endif
 #ifdef SESSION_INDEX
         ssl->sessionIndex = (row << SESSIDX_ROW_SHIFT) | idx;
 #endif
@@ -13146,14 +13961,23 @@ int AddSession(WOLFSSL* ssl)
     {
         if (error == 0) {
             SessionCache[row].totalCount++;
+#ifdef WOLFSSL_SESSION_CACHE_SHARDED
+            TouchSession(&SessionCache[row], idx);
+#else
             if (SessionCache[row].nextIdx == SESSIONS_PER_ROW)
                 SessionCache[row].nextIdx = 0;
+#endif
+        }
+#ifdef WOLFSSL_SESSION_CACHE_SHARDED
+        else {
+            SessionCache[row].lastUse[idx] = 0; /* partly written */
         }
+#endif
     }
 #ifndef NO_CLIENT_CACHE
     if (error == 0) {
         if (ssl->options.side == WOLFSSL_CLIENT_END && ssl->session.idLen) {
-            word32 clientRow, clientIdx;
+            word32 clientIdx;
 
             WOLFSSL_MSG("Adding client cache entry");
 
@@ -13165,22 +13989,16 @@ int AddSession(WOLFSSL* ssl)
             if (!ssl->options.internalCacheOff)
 #endif
             {
-                clientRow = HashSession(ssl->session.serverID,
-                        ssl->session.idLen, &error) % SESSION_ROWS;
-                if (error != 0) {
-                    WOLFSSL_MSG("Hash session failed");
-                } else {
-                    clientIdx = ClientCache[clientRow].nextIdx++;
+                clientIdx = ClientCache[clientRow].nextIdx++;
 
-                    ClientCache[clientRow].Clients[clientIdx].serverRow =
-                                                                   (word16)row;
-                    ClientCache[clientRow].Clients[clientIdx].serverIdx =
-                                                                   (word16)idx;
+                ClientCache[clientRow].Clients[clientIdx].serverRow =
+                                                               (word16)row;
+                ClientCache[clientRow].Clients[clientIdx].serverIdx =
+                                                               (word16)idx;
 
-                    ClientCache[clientRow].totalCount++;
-                    if (ClientCache[clientRow].nextIdx == SESSIONS_PER_ROW)
-                        ClientCache[clientRow].nextIdx = 0;
-                }
+                ClientCache[clientRow].totalCount++;
+                if (ClientCache[clientRow].nextIdx == (int)SESSIONS_PER_ROW)
+                    ClientCache[clientRow].nextIdx = 0;
             }
         }
         else
@@ -13188,6 +14006,14 @@ int AddSession(WOLFSSL* ssl)
     }
 #endif /* NO_CLIENT_CACHE */
 
+#ifdef HAVE_EXT_CACHE
+    if (!ssl->options.internalCacheOff)
+#endif
+    {
+        if (UnLockSessionRows(row, clientRow) != 0)
+            return BAD_MUTEX_E;
+    }
+
 #if defined(WOLFSSL_SESSION_STATS) && defined(WOLFSSL_PEAK_SESSIONS)
 #ifdef HAVE_EXT_CACHE
     if (!ssl->options.internalCacheOff)
@@ -13196,25 +14022,21 @@ int AddSession(WOLFSSL* ssl)
         if (error == 0) {
             word32 active = 0;
 
-            error = get_locked_session_stats(&active, NULL, NULL);
+            /* counting takes every row lock, so not while holding one */
+            error = wolfSSL_get_session_stats(&active, NULL, NULL, NULL);
             if (error == WOLFSSL_SUCCESS) {
                 error = 0;  /* back to this function ok */
 
+                if (wc_LockMutex(&session_mutex) != 0)
+                    return BAD_MUTEX_E;
                 if (active > PeakSessions)
                     PeakSessions = active;
+                wc_UnLockMutex(&session_mutex);
             }
         }
     }
 #endif /* defined(WOLFSSL_SESSION_STATS) && defined(WOLFSSL_PEAK_SESSIONS) */
 
-#ifdef HAVE_EXT_CACHE
-    if (!ssl->options.internalCacheOff)
-#endif
-    {
-        if (wc_UnLockMutex(&session_mutex) != 0)
-            return BAD_MUTEX_E;
-    }
-
 #ifdef HAVE_EXT_CACHE
     if (error == 0 && ssl->ctx->new_sess_cb != NULL)
         ssl->ctx->new_sess_cb(ssl, session);
@@ -13245,18 +14067,24 @@ int wolfSSL_GetSessionAtIndex(int idx, WOLFSSL_SESSION* session)
     row = idx >> SESSIDX_ROW_SHIFT;
     col = idx & SESSIDX_IDX_MASK;
 
-    if (wc_LockMutex(&session_mutex) != 0) {
+    if (row < 0 || row >= (int)SESSION_ROWS)
+        return WOLFSSL_FAILURE;
+
+    if (wc_LockMutex(SESSION_ROW_MUTEX(row)) != 0) {
         return BAD_MUTEX_E;
     }
 
-    if (row < SESSION_ROWS &&
-        col < (int)min(SessionCache[row].totalCount, SESSIONS_PER_ROW)) {
+#ifdef WOLFSSL_SESSION_CACHE_SHARDED
+    if (col < (int)SESSIONS_PER_ROW && SessionCache[row].lastUse[col] != 0) {
+#else
+    if (col < (int)min(SessionCache[row].totalCount, SESSIONS_PER_ROW)) {
+#endif
         XMEMCPY(session,
                  &SessionCache[row].Sessions[col], sizeof(WOLFSSL_SESSION));
         result = WOLFSSL_SUCCESS;
     }
 
-    if (wc_UnLockMutex(&session_mutex) != 0)
+    if (wc_UnLockMutex(SESSION_ROW_MUTEX(row)) != 0)
         result = BAD_MUTEX_E;
 
     WOLFSSL_LEAVE("wolfSSL_GetSessionAtIndex", result);
@@ -13310,7 +14138,8 @@ WOLFSSL_X509* wolfSSL_SESSION_get0_peer(WOLFSSL_SESSION* session)
 
 #ifdef WOLFSSL_SESSION_STATS
 
-/* requires session_mutex lock held, WOLFSSL_SUCCESS on ok */
+/* requires session_mutex lock held, WOLFSSL_SUCCESS on ok
+ * (with a sharded cache it takes each row lock in turn instead) */
 static int get_locked_session_stats(word32* active, word32* total, word32* peak)
 {
     int result = WOLFSSL_SUCCESS;
@@ -13325,6 +14154,32 @@ static int get_locked_session_stats(word32* active, word32* total, word32* peak)
 
     WOLFSSL_ENTER("get_locked_session_stats");
 
+#ifdef WOLFSSL_SESSION_CACHE_SHARDED
+    (void)count;
+    (void)idx;
+
+    if (SessionCache == NULL)
+        return BAD_STATE_E;
+
+    for (i = 0; i < (int)SESSION_ROWS; i++) {
+        word32 j;
+
+        if (wc_LockMutex(SESSION_ROW_MUTEX(i)) != 0)
+            return BAD_MUTEX_E;
+
+        seen += SessionCache[i].totalCount;
+        for (j = 0; active != NULL && j < SESSIONS_PER_ROW; j++) {
+            /* if not expired then good */
+            if (SessionCache[i].lastUse[j] != 0 &&
+                    ticks < (SessionCache[i].Sessions[j].bornOn +
+                             SessionCache[i].Sessions[j].timeout)) {
+                now++;
+            }
+        }
+
+        wc_UnLockMutex(SESSION_ROW_MUTEX(i));
+    }
+#else
     for (i = 0; i < SESSION_ROWS; i++) {
         seen += SessionCache[i].totalCount;
 
@@ -13349,6 +14204,7 @@ static int get_locked_session_stats(word32* active, word32* total, word32* peak)
             }
         }
     }
+#endif /* WOLFSSL_SESSION_CACHE_SHARDED */
 
     if (active)
         *active = now;
@@ -13357,8 +14213,16 @@ static int get_locked_session_stats(word32* active, word32* total, word32* peak)
         *total = seen;
 
 #ifdef WOLFSSL_PEAK_SESSIONS
-    if (peak)
+    if (peak) {
+    #ifdef WOLFSSL_SESSION_CACHE_SHARDED
+        if (wc_LockMutex(&session_mutex) != 0)
+            return BAD_MUTEX_E;
+        *peak = PeakSessions;
+        wc_UnLockMutex(&session_mutex);
+    #else
         *peak = PeakSessions;
+    #endif
+    }
 #endif
 
     WOLFSSL_LEAVE("get_locked_session_stats", result);
@@ -13386,6 +14250,9 @@ int wolfSSL_get_session_stats(word32* active, word32* total, word32* peak,
     if (active == NULL && total == NULL && peak == NULL)
         return BAD_FUNC_ARG;
 
+#ifdef WOLFSSL_SESSION_CACHE_SHARDED
+    result = get_locked_session_stats(active, total, peak);
+#else
     if (wc_LockMutex(&session_mutex) != 0) {
         return BAD_MUTEX_E;
     }
@@ -13394,6 +14261,7 @@ int wolfSSL_get_session_stats(word32* active, word32* total, word32* peak,
 
     if (wc_UnLockMutex(&session_mutex) != 0)
         result = BAD_MUTEX_E;
+#endif
 
     WOLFSSL_LEAVE("wolfSSL_get_session_stats", result);
 
@@ -13430,7 +14298,7 @@ int wolfSSL_get_session_stats(word32* active, word32* total, word32* peak,
 
         E = (double)totalSessionsSeen / SESSION_ROWS;
 
-        for (i = 0; i < SESSION_ROWS; i++) {
+        for (i = 0; i < (int)SESSION_ROWS; i++) {
             double diff = SessionCache[i].totalCount - E;
             diff *= diff;                /* square    */
             diff /= E;                   /* normalize */
@@ -13438,8 +14306,10 @@ int wolfSSL_get_session_stats(word32* active, word32* total, word32* peak,
             chiSquare += diff;
         }
         printf("  chi-square = %5.1f, d.f. = %d\n", chiSquare,
-                                                     SESSION_ROWS - 1);
-        #if (SESSION_ROWS == 11)
+                                                (int)SESSION_ROWS - 1);
+        #ifdef WOLFSSL_SESSION_CACHE_SHARDED
+            /* runtime sized, no table value */
+        #elif (SESSION_ROWS == 11)
             printf(" .05 p value =  18.3, chi-square should be less\n");
         #elif (SESSION_ROWS == 211)
             printf(".05 p value  = 244.8, chi-square should be less\n");
@@ -13522,7 +14392,34 @@ int wolfSSL_set_compression(WOLFSSL* ssl)
 
 
 #ifndef USE_WINDOWS_API
-    #ifndef NO_WRITEV
+    #ifdef WOLFSSL_SEND_IOV
+
+        /* writes like wolfSSL_write(), SendData() copies from the vectors
+           straight into each record instead of into a gather buffer */
+        int wolfSSL_writev(WOLFSSL* ssl, const struct iovec* iov, int iovcnt)
+        {
+            int sending = 0;
+            int i;
+            int ret;
+
+            WOLFSSL_ENTER("wolfSSL_writev");
+
+            if (ssl == NULL || iov == NULL || iovcnt < 0)
+                return BAD_FUNC_ARG;
+
+            for (i = 0; i < iovcnt; i++)
+                sending += (int)iov[i].iov_len;
+
+            ssl->buffers.sendIov    = iov;
+            ssl->buffers.sendIovCnt = iovcnt;
+            ret = wolfSSL_write(ssl, iov, sending);
+            ssl->buffers.sendIov    = NULL;
+            ssl->buffers.sendIovCnt = 0;
+
+            return ret;
+        }
+
+    #elif !defined(NO_WRITEV)
 
         /* simulate writev semantics, doesn't actually do block at a time though
            because of SSL_write behavior and because front adds may be small */
@@ -13570,6 +14467,44 @@ int wolfSSL_set_compression(WOLFSSL* ssl)
 #endif
 
 
+#ifdef WOLFSSL_SEND_COALESCE
+/* Use the caller's buf of sz bytes for outgoing records instead of allocating
+ * one for each write. Writes bigger than buf fall back to a dynamic buffer.
+ * buf must stay valid until unset with NULL or ssl is freed.
+ * returns WOLFSSL_SUCCESS on success */
+int wolfSSL_SetOutputBuffer(WOLFSSL* ssl, unsigned char* buf, unsigned int sz)
+{
+    WOLFSSL_ENTER("wolfSSL_SetOutputBuffer");
+
+    if (ssl == NULL || (buf == NULL && sz != 0) ||
+            (buf != NULL && sz < STATIC_BUFFER_LEN))
+        return BAD_FUNC_ARG;
+
+    /* can't move records that are waiting to be sent */
+    if (ssl->buffers.outputBuffer.length > 0)
+        return BUFFER_E;
+
+    ssl->buffers.userOutput   = buf;
+    ssl->buffers.userOutputSz = sz;
+
+    if (ssl->buffers.outputBuffer.dynamicFlag)
+        ShrinkOutputBuffer(ssl);
+    else if (buf != NULL) {
+        ssl->buffers.outputBuffer.buffer     = buf;
+        ssl->buffers.outputBuffer.bufferSize = sz;
+    }
+    else {
+        ssl->buffers.outputBuffer.buffer =
+                                        ssl->buffers.outputBuffer.staticBuffer;
+        ssl->buffers.outputBuffer.bufferSize = STATIC_BUFFER_LEN;
+    }
+    ssl->buffers.outputBuffer.idx = 0;
+
+    return WOLFSSL_SUCCESS;
+}
+#endif /* WOLFSSL_SEND_COALESCE */
+
+
 #ifdef WOLFSSL_CALLBACKS
 
     typedef struct itimerval Itimerval;
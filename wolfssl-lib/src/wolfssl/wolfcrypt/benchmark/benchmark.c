@@ -230,6 +230,7 @@
 #define BENCH_IDEA               0x00008000
 #define BENCH_AES_CFB            0x00010000
 #define BENCH_AES_OFB            0x00020000
+#define BENCH_AES_GCM_BULK       0x00040000
 /* Digest algorithms. */
 #define BENCH_MD5                0x00000001
 #define BENCH_POLY1305           0x00000002
@@ -249,6 +250,7 @@
 #define BENCH_RIPEMD             0x00001000
 #define BENCH_BLAKE2B            0x00002000
 #define BENCH_BLAKE2S            0x00004000
+#define BENCH_SHA256_MULTI       0x00008000
 
 /* MAC algorithms. */
 #define BENCH_CMAC               0x00000001
@@ -267,12 +269,14 @@
 #define BENCH_RSA_KEYGEN         0x00000001
 #define BENCH_RSA                0x00000002
 #define BENCH_RSA_SZ             0x00000004
+#define BENCH_ECC_VERIFY_CACHE   0x00000008
 #define BENCH_DH                 0x00000010
 #define BENCH_NTRU               0x00000100
 #define BENCH_NTRU_KEYGEN        0x00000200
 #define BENCH_ECC_MAKEKEY        0x00001000
 #define BENCH_ECC                0x00002000
 #define BENCH_ECC_ENCRYPT        0x00004000
+#define BENCH_ECC_VERIFY_BATCH   0x00008000
 #define BENCH_CURVE25519_KEYGEN  0x00010000
 #define BENCH_CURVE25519_KA      0x00020000
 #define BENCH_ED25519_KEYGEN     0x00040000
@@ -321,6 +325,7 @@ static const bench_alg bench_cipher_opt[] = {
 #endif
 #ifdef HAVE_AESGCM
     { "-aes-gcm",            BENCH_AES_GCM           },
+    { "-aes-gcm-bulk",       BENCH_AES_GCM_BULK      },
 #endif
 #ifdef WOLFSSL_AES_DIRECT
     { "-aes-ecb",            BENCH_AES_ECB           },
@@ -389,6 +394,9 @@ static const bench_alg bench_digest_opt[] = {
 #ifndef NO_SHA256
     { "-sha256",             BENCH_SHA256            },
 #endif
+#if !defined(NO_SHA256) && defined(WOLFSSL_SHA256_MULTI)
+    { "-sha256-multi",       BENCH_SHA256_MULTI      },
+#endif
 #ifdef WOLFSSL_SHA384
     { "-sha384",             BENCH_SHA384            },
 #endif
@@ -478,6 +486,13 @@ static const bench_alg bench_asym_opt[] = {
     #ifdef HAVE_ECC_ENCRYPT
     { "-ecc-enc",            BENCH_ECC_ENCRYPT       },
     #endif
+    #if !defined(NO_ASN) && defined(HAVE_ECC_SIGN) && defined(HAVE_ECC_VERIFY)
+    { "-ecc-verify-batch",   BENCH_ECC_VERIFY_BATCH  },
+    #endif
+    #if defined(WOLFSSL_SP_VERIFY_CACHE) && !defined(NO_ASN) && \
+        defined(HAVE_ECC_SIGN)
+    { "-ecc-verify-cache",   BENCH_ECC_VERIFY_CACHE  },
+    #endif
 #endif
 #ifdef HAVE_CURVE25519
     { "-curve25519-kg",      BENCH_CURVE25519_KEYGEN },
@@ -601,8 +616,15 @@ static const char* bench_desc_words[][9] = {
 #endif
 #endif
 
-#if defined(__GNUC__) && defined(__x86_64__) && !defined(NO_ASM) && !defined(WOLFSSL_SGX)
+#if defined(__GNUC__) && !defined(NO_ASM) && \
+    ((defined(__x86_64__) && !defined(WOLFSSL_SGX)) || \
+     (defined(__aarch64__) && !defined(LINUX_CYCLE_COUNT) && \
+      !defined(WOLFSSL_NO_BENCH_ARM_CYCLES)))
     #define HAVE_GET_CYCLES
+    #if defined(__aarch64__) && !defined(WOLFSSL_BENCH_CPU_MHZ)
+        /* CPU clock the generic timer count is scaled to */
+        #define WOLFSSL_BENCH_CPU_MHZ 1200
+    #endif
     static WC_INLINE word64 get_intel_cycles(void);
     static THREAD_LS_T word64 total_cycles;
     #define INIT_CYCLE_COUNTER
@@ -1452,6 +1474,16 @@ static void* benchmarks_do(void* args)
         bench_aesgcm(1);
     #endif
     }
+    #if !defined(NO_SW_BENCH) && !defined(WOLFSSL_AFALG_XILINX_AES) && \
+        !defined(WOLFSSL_XILINX_CRYPT)
+    if ((bench_cipher_algs & BENCH_AES_GCM_BULK)
+    #ifdef WOLFSSL_BENCH_AESGCM_BULK
+        || bench_all
+    #endif
+    ) {
+        bench_aesgcm_bulk();
+    }
+    #endif
 #endif
 #ifdef WOLFSSL_AES_DIRECT
     if (bench_all || (bench_cipher_algs & BENCH_AES_ECB)) {
@@ -1581,6 +1613,11 @@ static void* benchmarks_do(void* args)
         bench_sha256(1);
     #endif
     }
+    #if defined(WOLFSSL_SHA256_MULTI) && !defined(NO_SW_BENCH)
+    if (bench_all || (bench_digest_algs & BENCH_SHA256_MULTI)) {
+        bench_sha256_multi();
+    }
+    #endif
 #endif
 #ifdef WOLFSSL_SHA384
     if (bench_all || (bench_digest_algs & BENCH_SHA384)) {
@@ -1833,6 +1870,16 @@ static void* benchmarks_do(void* args)
     if (bench_all || (bench_asym_algs & BENCH_ECC_ENCRYPT))
         bench_eccEncrypt();
     #endif
+    #if !defined(NO_ASN) && defined(HAVE_ECC_SIGN) && \
+        defined(HAVE_ECC_VERIFY) && !defined(NO_SW_BENCH)
+    if (bench_all || (bench_asym_algs & BENCH_ECC_VERIFY_BATCH))
+        bench_ecc_verify_batch();
+    #endif
+    #if defined(WOLFSSL_SP_VERIFY_CACHE) && !defined(NO_ASN) && \
+        defined(HAVE_ECC_SIGN) && !defined(NO_SW_BENCH)
+    if (bench_all || (bench_asym_algs & BENCH_ECC_VERIFY_CACHE))
+        bench_ecc_verify_cache();
+    #endif
 #endif
 
 #ifdef HAVE_CURVE25519
@@ -2212,10 +2259,11 @@ void bench_aescbc(int doAsync)
 
 #ifdef HAVE_AESGCM
 static void bench_aesgcm_internal(int doAsync, const byte* key, word32 keySz,
-                                  const byte* iv, word32 ivSz,
+                                  const byte* iv, word32 ivSz, int inlineTag,
                                   const char* encLabel, const char* decLabel)
 {
     int    ret = 0, i, count = 0, times, pending = 0;
+    byte*  tag;
     Aes    enc[BENCH_MAX_PENDING];
 #ifdef HAVE_AES_DECRYPT
     Aes    dec[BENCH_MAX_PENDING];
@@ -2238,6 +2286,8 @@ static void bench_aesgcm_internal(int doAsync, const byte* key, word32 keySz,
     if (bench_tag)
 #endif
         XMEMSET(bench_tag, 0, AES_AUTH_TAG_SZ);
+    /* tag after the cipher text as in a TLS record */
+    tag = inlineTag ? bench_cipher + BENCH_SIZE : bench_tag;
 
     /* init keys */
     for (i = 0; i < BENCH_MAX_PENDING; i++) {
@@ -2265,7 +2315,7 @@ static void bench_aesgcm_internal(int doAsync, const byte* key, word32 keySz,
                 if (bench_async_check(&ret, BENCH_ASYNC_GET_DEV(&enc[i]), 0, &times, numBlocks, &pending)) {
                     ret = wc_AesGcmEncrypt(&enc[i], bench_cipher,
                         bench_plain, BENCH_SIZE,
-                        iv, ivSz, bench_tag, AES_AUTH_TAG_SZ,
+                        iv, ivSz, tag, AES_AUTH_TAG_SZ,
                         bench_additional, aesAuthAddSz);
                     if (!bench_async_handle(&ret, BENCH_ASYNC_GET_DEV(&enc[i]), 0, &times, &pending)) {
                         goto exit_aes_gcm;
@@ -2304,7 +2354,7 @@ exit_aes_gcm:
                 if (bench_async_check(&ret, BENCH_ASYNC_GET_DEV(&dec[i]), 0, &times, numBlocks, &pending)) {
                     ret = wc_AesGcmDecrypt(&dec[i], bench_plain,
                         bench_cipher, BENCH_SIZE,
-                        iv, ivSz, bench_tag, AES_AUTH_TAG_SZ,
+                        iv, ivSz, tag, AES_AUTH_TAG_SZ,
                         bench_additional, aesAuthAddSz);
                     if (!bench_async_handle(&ret, BENCH_ASYNC_GET_DEV(&dec[i]), 0, &times, &pending)) {
                         goto exit_aes_gcm_dec;
@@ -2342,19 +2392,127 @@ void bench_aesgcm(int doAsync)
 {
 #if defined(WOLFSSL_AES_128) && !defined(WOLFSSL_AFALG_XILINX_AES) \
 	&& !defined(WOLFSSL_XILINX_CRYPT)
-    bench_aesgcm_internal(doAsync, bench_key, 16, bench_iv, 12,
+    bench_aesgcm_internal(doAsync, bench_key, 16, bench_iv, 12, 0,
                           "AES-128-GCM-enc", "AES-128-GCM-dec");
 #endif
 #if defined(WOLFSSL_AES_192) && !defined(WOLFSSL_AFALG_XILINX_AES) \
 	&& !defined(WOLFSSL_XILINX_CRYPT)
-    bench_aesgcm_internal(doAsync, bench_key, 24, bench_iv, 12,
+    bench_aesgcm_internal(doAsync, bench_key, 24, bench_iv, 12, 0,
                           "AES-192-GCM-enc", "AES-192-GCM-dec");
 #endif
 #ifdef WOLFSSL_AES_256
-    bench_aesgcm_internal(doAsync, bench_key, 32, bench_iv, 12,
+    bench_aesgcm_internal(doAsync, bench_key, 32, bench_iv, 12, 0,
                           "AES-256-GCM-enc", "AES-256-GCM-dec");
+#ifdef WOLFSSL_XILINX_CRYPT
+    /* zero copy path of the CSU engine */
+    bench_aesgcm_internal(doAsync, bench_key, 32, bench_iv, 12, 1,
+                          "AES-256-GCM-enc-zc", "AES-256-GCM-dec-zc");
+#endif
+#endif
+}
+
+#if !defined(WOLFSSL_AFALG_XILINX_AES) && !defined(WOLFSSL_XILINX_CRYPT)
+/* Message sizes for the bulk AES-GCM benchmark: small record, typical
+ * packet and full TLS record */
+#define BENCH_AESGCM_BULK_SIZES 3
+static const word32 bench_aesgcm_bulk_sz[BENCH_AESGCM_BULK_SIZES] = {
+    64, 1024, 16384
+};
+#ifdef WOLFSSL_AES_128
+static const char* bench_aesgcm128_bulk_desc[BENCH_AESGCM_BULK_SIZES][2] = {
+    { "AES-128-GCM-enc-64",  "AES-128-GCM-dec-64"  },
+    { "AES-128-GCM-enc-1K",  "AES-128-GCM-dec-1K"  },
+    { "AES-128-GCM-enc-16K", "AES-128-GCM-dec-16K" },
+};
+#endif
+#ifdef WOLFSSL_AES_256
+static const char* bench_aesgcm256_bulk_desc[BENCH_AESGCM_BULK_SIZES][2] = {
+    { "AES-256-GCM-enc-64",  "AES-256-GCM-dec-64"  },
+    { "AES-256-GCM-enc-1K",  "AES-256-GCM-dec-1K"  },
+    { "AES-256-GCM-enc-16K", "AES-256-GCM-dec-16K" },
+};
+#endif
+
+static void bench_aesgcm_bulk_internal(const byte* key, word32 keySz,
+            const char* desc[BENCH_AESGCM_BULK_SIZES][2])
+{
+    int    ret = 0, i, count, times;
+    word32 j, sz;
+    Aes    aes;
+    byte*  plain;
+    byte*  cipher;
+    byte   tag[AES_AUTH_TAG_SZ];
+    double start;
+
+    sz = bench_aesgcm_bulk_sz[BENCH_AESGCM_BULK_SIZES - 1];
+    plain = (byte*)XMALLOC(sz, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    cipher = (byte*)XMALLOC(sz, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    if (plain == NULL || cipher == NULL) {
+        ret = MEMORY_E;
+        goto exit;
+    }
+    XMEMSET(plain, 0, sz);
+
+    ret = wc_AesInit(&aes, HEAP_HINT, INVALID_DEVID);
+    if (ret == 0)
+        ret = wc_AesGcmSetKey(&aes, key, keySz);
+    if (ret != 0) {
+        printf("AesGcmSetKey failed, ret = %d\n", ret);
+        goto exit;
+    }
+
+    for (j = 0; j < BENCH_AESGCM_BULK_SIZES; j++) {
+        sz = bench_aesgcm_bulk_sz[j];
+        /* same number of bytes between time checks for every size */
+        times = (int)((word32)numBlocks * bench_size / sz);
+        if (times == 0)
+            times = 1;
+
+        bench_stats_start(&count, &start);
+        do {
+            for (i = 0; i < times && ret == 0; i++) {
+                ret = wc_AesGcmEncrypt(&aes, cipher, plain, sz, bench_iv, 12,
+                                       tag, sizeof(tag), NULL, 0);
+            }
+            count += i;
+        } while (ret == 0 && bench_stats_sym_check(start));
+        bench_stats_sym_finish(desc[j][0], 0, count, (int)sz, start, ret);
+
+    #ifdef HAVE_AES_DECRYPT
+        bench_stats_start(&count, &start);
+        do {
+            for (i = 0; i < times && ret == 0; i++) {
+                ret = wc_AesGcmDecrypt(&aes, plain, cipher, sz, bench_iv, 12,
+                                       tag, sizeof(tag), NULL, 0);
+            }
+            count += i;
+        } while (ret == 0 && bench_stats_sym_check(start));
+        bench_stats_sym_finish(desc[j][1], 0, count, (int)sz, start, ret);
+    #endif
+        if (ret != 0)
+            break;
+    }
+
+exit:
+    if (ret < 0) {
+        printf("bench_aesgcm_bulk failed: %d\n", ret);
+    }
+    wc_AesFree(&aes);
+    XFREE(cipher, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+    XFREE(plain, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
+}
+
+/* AES-GCM throughput and cycles per byte by message size */
+void bench_aesgcm_bulk(void)
+{
+#ifdef WOLFSSL_AES_128
+    bench_aesgcm_bulk_internal(bench_key, 16, bench_aesgcm128_bulk_desc);
+#endif
+#ifdef WOLFSSL_AES_256
+    bench_aesgcm_bulk_internal(bench_key, 32, bench_aesgcm256_bulk_desc);
 #endif
 }
+#endif /* !WOLFSSL_AFALG_XILINX_AES && !WOLFSSL_XILINX_CRYPT */
 #endif /* HAVE_AESGCM */
 
 
@@ -3343,6 +3501,91 @@ exit:
 
     FREE_ARRAY(digest, BENCH_MAX_PENDING, HEAP_HINT);
 }
+
+#ifdef WOLFSSL_SHA256_MULTI
+#define BENCH_SHA256_MULTI_SIZES 2
+static const char* bench_sha256_multi_desc[BENCH_SHA256_MULTI_SIZES][2] = {
+    { "SHA-256 64B single", "SHA-256 64B multi" },
+    { "SHA-256 single",     "SHA-256 multi"     }
+};
+
+/* Independent messages hashed one after the other against
+ * WC_SHA256_MULTI_LANES at a time with the multi-buffer API */
+void bench_sha256_multi(void)
+{
+    wc_Sha256  hash[WC_SHA256_MULTI_LANES];
+    wc_Sha256* hashP[WC_SHA256_MULTI_LANES];
+    const byte* in[WC_SHA256_MULTI_LANES];
+    word32 inLen[WC_SHA256_MULTI_LANES];
+    byte*  out[WC_SHA256_MULTI_LANES];
+    byte   digest[WC_SHA256_MULTI_LANES][WC_SHA256_DIGEST_SIZE];
+    double start;
+    int    ret = 0, i, j, count = 0, times;
+    word32 sz;
+
+    XMEMSET(hash, 0, sizeof(hash));
+    for (i = 0; i < WC_SHA256_MULTI_LANES; i++) {
+        ret = wc_InitSha256_ex(&hash[i], HEAP_HINT, INVALID_DEVID);
+        if (ret != 0) {
+            printf("InitSha256_ex failed, ret = %d\n", ret);
+            goto exit;
+        }
+        hashP[i] = &hash[i];
+        out[i] = digest[i];
+    }
+
+    for (j = 0; j < BENCH_SHA256_MULTI_SIZES; j++) {
+        sz = (j == 0) ? WC_SHA256_BLOCK_SIZE : BENCH_SIZE;
+        for (i = 0; i < WC_SHA256_MULTI_LANES; i++) {
+            in[i] = bench_plain;
+            inLen[i] = sz;
+        }
+
+        bench_stats_start(&count, &start);
+        do {
+            for (times = 0; times < numBlocks; times++) {
+                for (i = 0; i < WC_SHA256_MULTI_LANES; i++) {
+                    ret = wc_Sha256Update(&hash[i], bench_plain, sz);
+                    if (ret == 0)
+                        ret = wc_Sha256Final(&hash[i], digest[i]);
+                    if (ret != 0)
+                        goto exit_single;
+                }
+            }
+            count += times;
+        } while (bench_stats_sym_check(start));
+    exit_single:
+        bench_stats_sym_finish(bench_sha256_multi_desc[j][0], 0, count,
+                               (int)(sz * WC_SHA256_MULTI_LANES), start, ret);
+        if (ret != 0)
+            break;
+
+        bench_stats_start(&count, &start);
+        do {
+            for (times = 0; times < numBlocks; times++) {
+                ret = wc_Sha256MultiUpdate(hashP, in, inLen,
+                                           WC_SHA256_MULTI_LANES);
+                if (ret == 0)
+                    ret = wc_Sha256MultiFinal(hashP, out,
+                                              WC_SHA256_MULTI_LANES);
+                if (ret != 0)
+                    goto exit_multi;
+            }
+            count += times;
+        } while (bench_stats_sym_check(start));
+    exit_multi:
+        bench_stats_sym_finish(bench_sha256_multi_desc[j][1], 0, count,
+                               (int)(sz * WC_SHA256_MULTI_LANES), start, ret);
+        if (ret != 0)
+            break;
+    }
+
+exit:
+    for (i = 0; i < WC_SHA256_MULTI_LANES; i++) {
+        wc_Sha256Free(&hash[i]);
+    }
+}
+#endif /* WOLFSSL_SHA256_MULTI */
 #endif
 
 #ifdef WOLFSSL_SHA384
@@ -3668,6 +3911,12 @@ exit:
 #endif /* WOLFSSL_NOSHA3_256 */
 
 #ifndef WOLFSSL_NOSHA3_384
+#ifndef BENCH_SHA3_COPY_SZ
+    #define BENCH_SHA3_COPY_SZ  4096 /* total message */
+#endif
+#ifndef BENCH_SHA3_COPY_UPD
+    #define BENCH_SHA3_COPY_UPD 256  /* each update */
+#endif
 void bench_sha3_384(int doAsync)
 {
     wc_Sha3   hash[BENCH_MAX_PENDING];
@@ -3728,6 +3977,7 @@ void bench_sha3_384(int doAsync)
                 ret = wc_InitSha3_384(hash, HEAP_HINT, INVALID_DEVID);
                 ret |= wc_Sha3_384_Update(hash, bench_plain, BENCH_SIZE);
                 ret |= wc_Sha3_384_Final(hash, digest[0]);
+                wc_Sha3_384_Free(hash);
                 if (ret != 0)
                     goto exit_sha3_384;
             } /* for times */
@@ -3737,6 +3987,37 @@ void bench_sha3_384(int doAsync)
 exit_sha3_384:
     bench_stats_sym_finish("SHA3-384", doAsync, count, bench_size, start, ret);
 
+    if (!doAsync && ret == 0) {
+        /* TLS transcript pattern: small updates each followed by a copy and
+         * final of the copy for the running hash */
+        wc_Sha3 copy;
+        word32  off;
+
+        bench_stats_start(&count, &start);
+        do {
+            for (times = 0; times < numBlocks && ret == 0; times++) {
+                ret = wc_InitSha3_384(hash, HEAP_HINT, INVALID_DEVID);
+                for (off = 0; ret == 0 && off < BENCH_SHA3_COPY_SZ;
+                                               off += BENCH_SHA3_COPY_UPD) {
+                    ret = wc_Sha3_384_Update(hash, bench_plain,
+                        BENCH_SHA3_COPY_UPD);
+                    if (ret == 0)
+                        ret = wc_Sha3_384_Copy(hash, &copy);
+                    if (ret == 0) {
+                        ret = wc_Sha3_384_Final(&copy, digest[0]);
+                        wc_Sha3_384_Free(&copy);
+                    }
+                }
+                if (ret == 0)
+                    ret = wc_Sha3_384_Final(hash, digest[0]);
+                wc_Sha3_384_Free(hash);
+            } /* for times */
+            count += times;
+        } while (ret == 0 && bench_stats_sym_check(start));
+        bench_stats_sym_finish("SHA3-384-copy", doAsync, count,
+            BENCH_SHA3_COPY_SZ, start, ret);
+    }
+
 exit:
 
     for (i = 0; i < BENCH_MAX_PENDING; i++) {
@@ -5438,6 +5719,207 @@ exit:
 }
 
 
+#if !defined(NO_ASN) && defined(HAVE_ECC_SIGN) && defined(HAVE_ECC_VERIFY)
+#define BENCH_ECC_BATCH_KEYS 8
+#define BENCH_ECC_BATCH_MAX  64
+static const int bench_ecc_batch_n[] = { 1, 2, 4, 8, 16, 32, 64 };
+static const char* bench_ecc_batch_desc[][2] = {
+    { "verify 1",  "batch 1"  },
+    { "verify 2",  "batch 2"  },
+    { "verify 4",  "batch 4"  },
+    { "verify 8",  "batch 8"  },
+    { "verify 16", "batch 16" },
+    { "verify 32", "batch 32" },
+    { "verify 64", "batch 64" }
+};
+
+/* N signatures verified one after the other against one call to
+ * wc_ecc_verify_hash_batch(). Ops/sec are signatures per second. */
+void bench_ecc_verify_batch(void)
+{
+    int ret = 0, i, j, n, count, times;
+    const int keySize = bench_ecc_size;
+    ecc_key* keys = NULL;
+    ecc_key* keyP[BENCH_ECC_BATCH_MAX];
+    byte*  sig = NULL;
+    byte*  digest = NULL;
+    const byte* sigP[BENCH_ECC_BATCH_MAX];
+    const byte* digestP[BENCH_ECC_BATCH_MAX];
+    word32 sigLen[BENCH_ECC_BATCH_MAX];
+    word32 digestLen[BENCH_ECC_BATCH_MAX];
+    int    res[BENCH_ECC_BATCH_MAX];
+    double start;
+
+    keys = (ecc_key*)XMALLOC(sizeof(ecc_key) * BENCH_ECC_BATCH_KEYS,
+                             HEAP_HINT, DYNAMIC_TYPE_ECC);
+    sig = (byte*)XMALLOC(ECC_MAX_SIG_SIZE * BENCH_ECC_BATCH_MAX, HEAP_HINT,
+                         DYNAMIC_TYPE_SIGNATURE);
+    digest = (byte*)XMALLOC(MAX_ECC_BYTES * BENCH_ECC_BATCH_MAX, HEAP_HINT,
+                            DYNAMIC_TYPE_DIGEST);
+    if (keys == NULL || sig == NULL || digest == NULL) {
+        ret = MEMORY_E;
+        goto exit;
+    }
+    XMEMSET(keys, 0, sizeof(ecc_key) * BENCH_ECC_BATCH_KEYS);
+
+    for (i = 0; i < BENCH_ECC_BATCH_KEYS; i++) {
+        ret = wc_ecc_init_ex(&keys[i], HEAP_HINT, INVALID_DEVID);
+        if (ret == 0)
+            ret = wc_ecc_make_key(&gRng, keySize, &keys[i]);
+        if (ret != 0)
+            goto exit;
+    }
+
+    /* each signature with its own message, keys shared round robin */
+    for (i = 0; i < BENCH_ECC_BATCH_MAX; i++) {
+        keyP[i] = &keys[i % BENCH_ECC_BATCH_KEYS];
+        digestP[i] = digest + i * MAX_ECC_BYTES;
+        digestLen[i] = (word32)keySize;
+        for (j = 0; j < keySize; j++) {
+            digest[i * MAX_ECC_BYTES + j] = (byte)(i + j);
+        }
+        sigP[i] = sig + i * ECC_MAX_SIG_SIZE;
+        sigLen[i] = ECC_MAX_SIG_SIZE;
+        ret = wc_ecc_sign_hash(digestP[i], digestLen[i],
+                               sig + i * ECC_MAX_SIG_SIZE, &sigLen[i], &gRng,
+                               keyP[i]);
+        if (ret != 0)
+            goto exit;
+    }
+
+    for (j = 0; j < (int)(sizeof(bench_ecc_batch_n) /
+                          sizeof(bench_ecc_batch_n[0])); j++) {
+        n = bench_ecc_batch_n[j];
+
+        bench_stats_start(&count, &start);
+        do {
+            for (times = 0; times < agreeTimes; times++) {
+                for (i = 0; i < n; i++) {
+                    ret = wc_ecc_verify_hash(sigP[i], sigLen[i], digestP[i],
+                                             digestLen[i], &res[i], keyP[i]);
+                    if (ret == 0 && res[i] != 1)
+                        ret = SIG_VERIFY_E;
+                    if (ret != 0)
+                        goto exit_seq;
+                }
+            }
+            count += times * n;
+        } while (bench_stats_sym_check(start));
+    exit_seq:
+        bench_stats_asym_finish("ECDSA", keySize * 8,
+                                bench_ecc_batch_desc[j][0], 0, count, start,
+                                ret);
+        if (ret != 0)
+            break;
+
+        bench_stats_start(&count, &start);
+        do {
+            for (times = 0; times < agreeTimes; times++) {
+                ret = wc_ecc_verify_hash_batch(sigP, sigLen, digestP,
+                                               digestLen, res, keyP, n);
+                for (i = 0; ret == 0 && i < n; i++) {
+                    if (res[i] != 1)
+                        ret = SIG_VERIFY_E;
+                }
+                if (ret != 0)
+                    goto exit_batch;
+            }
+            count += times * n;
+        } while (bench_stats_sym_check(start));
+    exit_batch:
+        bench_stats_asym_finish("ECDSA", keySize * 8,
+                                bench_ecc_batch_desc[j][1], 0, count, start,
+                                ret);
+        if (ret != 0)
+            break;
+    }
+
+exit:
+    if (ret != 0) {
+        printf("bench_ecc_verify_batch failed: %d\n", ret);
+    }
+    if (keys != NULL) {
+        for (i = 0; i < BENCH_ECC_BATCH_KEYS; i++) {
+            wc_ecc_free(&keys[i]);
+        }
+        XFREE(keys, HEAP_HINT, DYNAMIC_TYPE_ECC);
+    }
+    XFREE(sig, HEAP_HINT, DYNAMIC_TYPE_SIGNATURE);
+    XFREE(digest, HEAP_HINT, DYNAMIC_TYPE_DIGEST);
+}
+#endif /* !NO_ASN && HAVE_ECC_SIGN && HAVE_ECC_VERIFY */
+
+#if defined(WOLFSSL_SP_VERIFY_CACHE) && !defined(NO_ASN) && \
+    defined(HAVE_ECC_SIGN)
+/* Verify against one key with its table in the cache (hot) and with the
+ * cache emptied before each verify (cold) */
+void bench_ecc_verify_cache(void)
+{
+    int ret, i, count, times, verify = 0;
+    const int keySize = bench_ecc_size;
+    int curveId = (keySize == 48) ? ECC_SECP384R1 : ECC_SECP256R1;
+    ecc_key key;
+    ecc_verify_cache_stats stats;
+    byte   sig[ECC_MAX_SIG_SIZE];
+    byte   digest[MAX_ECC_BYTES];
+    word32 sigLen = sizeof(sig);
+    double start;
+
+    ret = wc_ecc_init_ex(&key, HEAP_HINT, INVALID_DEVID);
+    if (ret != 0)
+        return;
+    ret = wc_ecc_make_key(&gRng, keySize, &key);
+    for (i = 0; i < keySize; i++) {
+        digest[i] = (byte)i;
+    }
+    if (ret == 0)
+        ret = wc_ecc_sign_hash(digest, (word32)keySize, sig, &sigLen, &gRng,
+                               &key);
+    if (ret == 0)
+        ret = wc_ecc_verify_cache_clear(curveId);
+    if (ret != 0)
+        goto exit;
+
+    for (i = 0; i < 2; i++) {
+        (void)wc_ecc_verify_cache_stats(curveId, NULL, 1);
+
+        bench_stats_start(&count, &start);
+        do {
+            for (times = 0; times < agreeTimes; times++) {
+                if (i == 1)
+                    (void)wc_ecc_verify_cache_clear(curveId);
+                ret = wc_ecc_verify_hash(sig, sigLen, digest, (word32)keySize,
+                                         &verify, &key);
+                if (ret == 0 && verify != 1)
+                    ret = SIG_VERIFY_E;
+                if (ret != 0)
+                    goto exit_verify;
+            }
+            count += times;
+        } while (bench_stats_sym_check(start));
+    exit_verify:
+        bench_stats_asym_finish("ECDSA", keySize * 8,
+                                (i == 0) ? "vfy hot" : "vfy cold", 0, count,
+                                start, ret);
+        if (ret != 0)
+            break;
+
+        if (wc_ecc_verify_cache_stats(curveId, &stats, 0) == 0) {
+            printf("Verify cache: %u hits, %u misses, %u tables, "
+                   "%u/%u entries, %u bytes\n", stats.hits, stats.misses,
+                   stats.tables, stats.entries, stats.maxEntries,
+                   stats.bytes);
+        }
+    }
+
+exit:
+    if (ret != 0) {
+        printf("bench_ecc_verify_cache failed: %d\n", ret);
+    }
+    wc_ecc_free(&key);
+}
+#endif /* WOLFSSL_SP_VERIFY_CACHE && !NO_ASN && HAVE_ECC_SIGN */
+
 #ifdef HAVE_ECC_ENCRYPT
 void bench_eccEncrypt(void)
 {
@@ -6054,6 +6536,24 @@ exit_ed_verify:
 
 #if defined(HAVE_GET_CYCLES)
 
+#ifdef __aarch64__
+/* The PMU cycle counter is not readable from user mode (or under
+ * qemu-aarch64), so scale the generic timer count to the CPU clock */
+static WC_INLINE word64 get_intel_cycles(void)
+{
+    word64 cnt, frq;
+    __asm__ __volatile__ (
+        "isb\n\t"
+        "mrs %0, cntvct_el0\n\t"
+        "mrs %1, cntfrq_el0"
+            : "=r"(cnt), "=r"(frq)
+            :
+            : "memory");
+    if (frq < 1000000)
+        return cnt;
+    return cnt * WOLFSSL_BENCH_CPU_MHZ / (frq / 1000000);
+}
+#else
 static WC_INLINE word64 get_intel_cycles(void)
 {
     unsigned int lo_c, hi_c;
@@ -6065,6 +6565,7 @@ static WC_INLINE word64 get_intel_cycles(void)
             : "%ebx", "%ecx");         /* clobber */
     return ((word64)lo_c) | (((word64)hi_c) << 32);
 }
+#endif
 
 #endif /* HAVE_GET_CYCLES */
 
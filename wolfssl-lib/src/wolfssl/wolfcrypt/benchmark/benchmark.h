@@ -49,6 +49,7 @@ void bench_chacha(void);
 void bench_chacha20_poly1305_aead(void);
 void bench_aescbc(int);
 void bench_aesgcm(int);
+void bench_aesgcm_bulk(void);
 void bench_aesccm(void);
 void bench_aesecb(int);
 void bench_aesxts(void);
@@ -61,6 +62,7 @@ void bench_md5(int);
 void bench_sha(int);
 void bench_sha224(int);
 void bench_sha256(int);
+void bench_sha256_multi(void);
 void bench_sha384(int);
 void bench_sha512(int);
 void bench_sha3_224(int);
@@ -84,6 +86,8 @@ void bench_dh(int);
 void bench_eccMakeKey(int);
 void bench_ecc(int);
 void bench_eccEncrypt(void);
+void bench_ecc_verify_batch(void);
+void bench_ecc_verify_cache(void);
 void bench_curve25519KeyGen(void);
 void bench_curve25519KeyAgree(void);
 void bench_ed25519KeyGen(void);
@@ -7515,6 +7515,10 @@ int wc_AesInit(Aes* aes, void* heap, int devId)
     aes->alFd = -1;
     aes->rdFd = -1;
 #endif
+#ifdef WOLFSSL_XILINX_CRYPT
+    aes->xilBuf = NULL;
+    aes->xilBufSz = 0;
+#endif
 #if defined(WOLFSSL_DEVCRYPTO) && \
    (defined(WOLFSSL_DEVCRYPTO_AES) || defined(WOLFSSL_DEVCRYPTO_CBC))
     aes->ctx.cfd = -1;
@@ -7569,6 +7573,14 @@ void wc_AesFree(Aes* aes)
         close(aes->alFd);
     }
 #endif /* WOLFSSL_AFALG */
+#ifdef WOLFSSL_XILINX_CRYPT
+    if (aes->xilBuf != NULL) {
+        ForceZero(aes->xilBuf, aes->xilBufSz);
+        XFREE(aes->xilBuf, aes->heap, DYNAMIC_TYPE_TMP_BUFFER);
+        aes->xilBuf = NULL;
+        aes->xilBufSz = 0;
+    }
+#endif
 #if defined(WOLFSSL_DEVCRYPTO) && \
     (defined(WOLFSSL_DEVCRYPTO_AES) || defined(WOLFSSL_DEVCRYPTO_CBC))
     wc_DevCryptoFree(&aes->ctx);
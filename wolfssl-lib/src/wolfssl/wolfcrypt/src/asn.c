@@ -17135,7 +17135,107 @@ void FreeDecodedCRL(DecodedCRL* dcrl)
         XFREE(tmp, dcrl->heap, DYNAMIC_TYPE_REVOKED);
         tmp = next;
     }
+#ifdef WOLFSSL_CRL_INDEX
+    if (dcrl->serials != NULL)
+        XFREE(dcrl->serials, dcrl->heap, DYNAMIC_TYPE_REVOKED);
+#endif
+}
+
+
+#ifdef WOLFSSL_CRL_INDEX
+/* Order of the revoked serial table: by size then bytes.
+ * Returns < 0, 0 or > 0 as a is before, same as or after serial */
+int CompareRevokedSerial(const RevokedSerial* a, const byte* serial,
+                         int serialSz)
+{
+    if (a->serialSz != serialSz)
+        return (int)a->serialSz - serialSz;
+    return XMEMCMP(a->serialNumber, serial, serialSz);
+}
+
+static WC_INLINE void SwapRevokedSerial(RevokedSerial* a, RevokedSerial* b)
+{
+    RevokedSerial tmp = *a;
+
+    *a = *b;
+    *b = tmp;
+}
+
+#define REVOKED_SORT_SMALL 16 /* partitions this size use insertion sort */
+
+/* Quick sort, no recursion: the smaller side is sorted next and the larger
+ * is kept on a stack of at most log2(n) ranges */
+static void SortRevokedSerials(RevokedSerial* tbl, int n)
+{
+    int stackLo[32], stackHi[32];
+    int sp = 0;
+    int lo = 0, hi = n - 1;
+
+    for (;;) {
+        while (hi - lo >= REVOKED_SORT_SMALL) {
+            int mid = lo + (hi - lo) / 2;
+            int i = lo, j = hi;
+            RevokedSerial pivot;
+
+            /* median of three as pivot */
+            if (CompareRevokedSerial(&tbl[mid], tbl[lo].serialNumber,
+                                     tbl[lo].serialSz) < 0)
+                SwapRevokedSerial(&tbl[mid], &tbl[lo]);
+            if (CompareRevokedSerial(&tbl[hi], tbl[lo].serialNumber,
+                                     tbl[lo].serialSz) < 0)
+                SwapRevokedSerial(&tbl[hi], &tbl[lo]);
+            if (CompareRevokedSerial(&tbl[hi], tbl[mid].serialNumber,
+                                     tbl[mid].serialSz) < 0)
+                SwapRevokedSerial(&tbl[hi], &tbl[mid]);
+            pivot = tbl[mid];
+
+            while (i <= j) {
+                while (CompareRevokedSerial(&tbl[i], pivot.serialNumber,
+                                            pivot.serialSz) < 0)
+                    i++;
+                while (CompareRevokedSerial(&tbl[j], pivot.serialNumber,
+                                            pivot.serialSz) > 0)
+                    j--;
+                if (i <= j) {
+                    if (i != j)
+                        SwapRevokedSerial(&tbl[i], &tbl[j]);
+                    i++;
+                    j--;
+                }
+            }
+
+            if (j - lo < hi - i) {
+                stackLo[sp] = i; stackHi[sp] = hi; sp++;
+                hi = j;
+            }
+            else {
+                stackLo[sp] = lo; stackHi[sp] = j; sp++;
+                lo = i;
+            }
+        }
+
+        /* insertion sort of the small range */
+        {
+            int i, j;
+
+            for (i = lo + 1; i <= hi; i++) {
+                RevokedSerial tmp = tbl[i];
+
+                for (j = i; j > lo && CompareRevokedSerial(&tbl[j - 1],
+                                  tmp.serialNumber, tmp.serialSz) > 0; j--)
+                    tbl[j] = tbl[j - 1];
+                tbl[j] = tmp;
+            }
+        }
+
+        if (sp == 0)
+            break;
+        sp--;
+        lo = stackLo[sp];
+        hi = stackHi[sp];
+    }
 }
+#endif /* WOLFSSL_CRL_INDEX */
 
 
 /* Get Revoked Cert list, 0 on success */
@@ -17154,6 +17254,29 @@ static int GetRevoked(const byte* buff, word32* idx, DecodedCRL* dcrl,
 
     end = *idx + len;
 
+#ifdef WOLFSSL_CRL_INDEX
+    if (dcrl->serials != NULL) {
+        /* table sized by ParseCRL_CertList */
+        RevokedSerial* rs = &dcrl->serials[dcrl->totalCerts];
+        int serialSz = 0;
+
+        XMEMSET(rs, 0, sizeof(RevokedSerial));
+        if (GetSerialNumber(buff, idx, rs->serialNumber, &serialSz,
+                                                                maxIdx) < 0)
+            return ASN_PARSE_E;
+        rs->serialSz = (byte)serialSz;
+        dcrl->totalCerts++;
+
+        ret = GetDateInfo(buff, idx, NULL, &b, NULL, maxIdx);
+        if (ret < 0) {
+            WOLFSSL_MSG("Expecting Date");
+            return ret;
+        }
+        *idx = end;
+        return 0;
+    }
+#endif
+
     rc = (RevokedCert*)XMALLOC(sizeof(RevokedCert), dcrl->heap,
                                                           DYNAMIC_TYPE_REVOKED);
     if (rc == NULL) {
@@ -17292,10 +17415,37 @@ static int ParseCRL_CertList(DecodedCRL* dcrl, const byte* buf,
             return ASN_PARSE_E;
         len += idx;
 
+    #ifdef WOLFSSL_CRL_INDEX
+        {
+            /* count the entries so the table is one allocation */
+            word32 cntIdx = idx;
+            int    cnt = 0, entryLen;
+
+            while (cntIdx < (word32)len) {
+                if (GetSequence(buf, &cntIdx, &entryLen, len) < 0)
+                    return ASN_PARSE_E;
+                cntIdx += entryLen;
+                cnt++;
+            }
+            if (cnt > 0) {
+                dcrl->serials = (RevokedSerial*)XMALLOC(
+                        cnt * sizeof(RevokedSerial), dcrl->heap,
+                        DYNAMIC_TYPE_REVOKED);
+                if (dcrl->serials == NULL)
+                    return MEMORY_E;
+            }
+        }
+    #endif
+
         while (idx < (word32)len) {
             if (GetRevoked(buf, &idx, dcrl, len) < 0)
                 return ASN_PARSE_E;
         }
+
+    #ifdef WOLFSSL_CRL_INDEX
+        if (dcrl->serials != NULL)
+            SortRevokedSerials(dcrl->serials, dcrl->totalCerts);
+    #endif
     }
 
     *inOutIdx = idx;
@@ -6115,8 +6115,272 @@ int wc_ecc_verify_hash(const byte* sig, word32 siglen, const byte* hash,
 
     return err;
 }
+
+#if defined(WOLFSSL_SP_VERIFY_BATCH) && !defined(FREESCALE_LTC_ECC) && \
+    !defined(WOLFSSL_DSP) && !defined(WOLFSSL_STM32_PKA) && \
+    !defined(WOLFSSL_ATECC508A) && !defined(WOLFSSL_ATECC608A) && \
+    !defined(WOLFSSL_CRYPTOCELL) && \
+    (!defined(WOLFSSL_ASYNC_CRYPT) || !defined(WC_ASYNC_ENABLE_ECC))
+    #define ECC_VERIFY_BATCH_SP
+#endif
+
+#ifdef ECC_VERIFY_BATCH_SP
+/* Signatures of one curve passed to the SP batch verify at a time */
+typedef struct EccVerifyBatch {
+    mp_int      r[WC_ECC_VERIFY_BATCH_SZ];
+    mp_int      s[WC_ECC_VERIFY_BATCH_SZ];
+    mp_int*     rp[WC_ECC_VERIFY_BATCH_SZ];
+    mp_int*     sp[WC_ECC_VERIFY_BATCH_SZ];
+    mp_int*     x[WC_ECC_VERIFY_BATCH_SZ];
+    mp_int*     y[WC_ECC_VERIFY_BATCH_SZ];
+    mp_int*     z[WC_ECC_VERIFY_BATCH_SZ];
+    const byte* hash[WC_ECC_VERIFY_BATCH_SZ];
+    word32      hashLen[WC_ECC_VERIFY_BATCH_SZ];
+    int         res[WC_ECC_VERIFY_BATCH_SZ];
+    int         idx[WC_ECC_VERIFY_BATCH_SZ];  /* index in caller's arrays */
+    int         cnt;
+} EccVerifyBatch;
+
+/* Curve of key when it can be verified with the SP batch code, otherwise
+ * ECC_CURVE_INVALID */
+static int ecc_verify_batch_curve(ecc_key* key)
+{
+    int id;
+
+    if (key->idx == ECC_CUSTOM_IDX || key->type == ECC_PRIVATEKEY_ONLY) {
+        return ECC_CURVE_INVALID;
+    }
+#ifdef WOLF_CRYPTO_CB
+    if (key->devId != INVALID_DEVID) {
+        return ECC_CURVE_INVALID;
+    }
+#endif
+#ifdef WC_ECC_NONBLOCK
+    if (key->nb_ctx != NULL) {
+        return ECC_CURVE_INVALID;
+    }
+#endif
+
+    id = ecc_sets[key->idx].id;
+#ifndef WOLFSSL_SP_NO_256
+    if (id == ECC_SECP256R1) {
+        return id;
+    }
+#endif
+#ifdef WOLFSSL_SP_384
+    if (id == ECC_SECP384R1) {
+        return id;
+    }
+#endif
+    return ECC_CURVE_INVALID;
+}
+
+/* Verify the signatures collected in the batch and hand back the results */
+static int ecc_verify_batch_flush(EccVerifyBatch* b, int id, int* res,
+                                  void* heap)
+{
+    int err = MP_OKAY;
+    int k;
+
+    if (b->cnt == 0) {
+        return MP_OKAY;
+    }
+
+#ifndef WOLFSSL_SP_NO_256
+    if (id == ECC_SECP256R1) {
+        err = sp_ecc_verify_256_batch(b->cnt, b->hash, b->hashLen, b->x, b->y,
+            b->z, b->rp, b->sp, b->res, heap);
+    }
+#endif
+#ifdef WOLFSSL_SP_384
+    if (id == ECC_SECP384R1) {
+        err = sp_ecc_verify_384_batch(b->cnt, b->hash, b->hashLen, b->x, b->y,
+            b->z, b->rp, b->sp, b->res, heap);
+    }
+#endif
+
+    for (k = 0; k < b->cnt; k++) {
+        res[b->idx[k]] = (err == MP_OKAY) ? b->res[k] : 0;
+        mp_clear(&b->r[k]);
+        mp_clear(&b->s[k]);
+    }
+    b->cnt = 0;
+
+    return err;
+}
+#endif /* ECC_VERIFY_BATCH_SP */
+
+/**
+ Verify a batch of ECC signatures
+ P-256 and P-384 signatures are verified together with the SP code, sharing
+ one modular inversion per WC_ECC_VERIFY_BATCH_SZ signatures. Other keys are
+ verified one at a time with wc_ecc_verify_hash().
+ sig         The signatures to verify
+ siglen      The length of each signature (octets)
+ hash        The hash (message digest) that was signed for each signature
+ hashlen     The length of each hash (octets)
+ res         Result of each signature, 1==valid, 0==invalid
+ key         The corresponding public ECC key of each signature
+ n           The number of signatures
+ return      MP_OKAY if successful (even if signatures are not valid)
+ */
+int wc_ecc_verify_hash_batch(const byte** sig, const word32* siglen,
+                             const byte** hash, const word32* hashlen,
+                             int* res, ecc_key** key, int n)
+{
+    int err = MP_OKAY;
+    int i;
+#ifdef ECC_VERIFY_BATCH_SP
+    EccVerifyBatch* b = NULL;
+    void* heap = NULL;
+    int id;
+    int k;
+    static const int batchCurves[] = { ECC_SECP256R1, ECC_SECP384R1 };
+#endif
+
+    if (n < 0 || (n > 0 && (sig == NULL || siglen == NULL || hash == NULL ||
+                           hashlen == NULL || res == NULL || key == NULL))) {
+        return ECC_BAD_ARG_E;
+    }
+    for (i = 0; i < n; i++) {
+        if (sig[i] == NULL || hash[i] == NULL || key[i] == NULL) {
+            return ECC_BAD_ARG_E;
+        }
+    }
+
+#ifdef ECC_VERIFY_BATCH_SP
+    if (n > 1) {
+        heap = key[0]->heap;
+        b = (EccVerifyBatch*)XMALLOC(sizeof(EccVerifyBatch), heap,
+                                                              DYNAMIC_TYPE_ECC);
+        /* without the batch scratch (too big for a static memory bucket)
+           each signature is verified on its own */
+        if (b != NULL) {
+            XMEMSET(b, 0, sizeof(EccVerifyBatch));
+        }
+    }
+#endif
+
+    for (i = 0; err == MP_OKAY && i < n; i++) {
+    #ifdef ECC_VERIFY_BATCH_SP
+        if (b != NULL && ecc_verify_batch_curve(key[i]) != ECC_CURVE_INVALID) {
+            continue;
+        }
+    #endif
+        err = wc_ecc_verify_hash(sig[i], siglen[i], hash[i], hashlen[i],
+                                 &res[i], key[i]);
+        if (err != MP_OKAY) {
+            res[i] = 0;
+            if (err != MEMORY_E) {
+                err = MP_OKAY;
+            }
+        }
+    }
+
+#ifdef ECC_VERIFY_BATCH_SP
+    for (k = 0; b != NULL && k < (int)(sizeof(batchCurves) /
+                                       sizeof(batchCurves[0])); k++) {
+        id = batchCurves[k];
+        for (i = 0; err == MP_OKAY && i < n; i++) {
+            int c = b->cnt;
+
+            if (ecc_verify_batch_curve(key[i]) != id) {
+                continue;
+            }
+
+            /* DecodeECC_DSA_Sig() calls mp_init() on r and s */
+            if (DecodeECC_DSA_Sig(sig[i], siglen[i], &b->r[c], &b->s[c])
+                                                                      != 0) {
+                mp_clear(&b->r[c]);
+                mp_clear(&b->s[c]);
+                res[i] = 0;
+                continue;
+            }
+            b->rp[c] = &b->r[c];
+            b->sp[c] = &b->s[c];
+            b->x[c] = key[i]->pubkey.x;
+            b->y[c] = key[i]->pubkey.y;
+            b->z[c] = key[i]->pubkey.z;
+            b->hash[c] = hash[i];
+            b->hashLen[c] = hashlen[i];
+            b->idx[c] = i;
+            if (++b->cnt == WC_ECC_VERIFY_BATCH_SZ) {
+                err = ecc_verify_batch_flush(b, id, res, heap);
+            }
+        }
+        if (err == MP_OKAY) {
+            err = ecc_verify_batch_flush(b, id, res, heap);
+        }
+    }
+
+    if (b != NULL) {
+        for (k = 0; k < b->cnt; k++) {
+            mp_clear(&b->r[k]);
+            mp_clear(&b->s[k]);
+        }
+        XFREE(b, heap, DYNAMIC_TYPE_ECC);
+    }
+#endif
+
+    return err;
+}
 #endif /* !NO_ASN */
 
+#ifdef WOLFSSL_SP_VERIFY_CACHE
+/**
+ Get the counters of the SP verify public key table cache
+ curve_id    ECC_SECP256R1 or ECC_SECP384R1
+ stats       Counters and size of the cache
+ reset       Zero the counters after getting them
+ return      NOT_COMPILED_IN when the SP code has no cache for the curve
+ */
+int wc_ecc_verify_cache_stats(int curve_id, ecc_verify_cache_stats* stats,
+                              int reset)
+{
+#ifdef WOLFSSL_SP_HAVE_VERIFY_CACHE
+#ifndef WOLFSSL_SP_NO_256
+    if (curve_id == ECC_SECP256R1) {
+        return sp_ecc_verify_cache_stats_256(stats, reset);
+    }
+#endif
+#ifdef WOLFSSL_SP_384
+    if (curve_id == ECC_SECP384R1) {
+        return sp_ecc_verify_cache_stats_384(stats, reset);
+    }
+#endif
+#endif
+    (void)curve_id;
+    (void)stats;
+    (void)reset;
+    return NOT_COMPILED_IN;
+}
+
+/**
+ Empty the SP verify public key table cache of the curve
+ curve_id    ECC_SECP256R1 or ECC_SECP384R1
+ return      NOT_COMPILED_IN when the SP code has no cache for the curve
+ */
+int wc_ecc_verify_cache_clear(int curve_id)
+{
+#ifdef WOLFSSL_SP_HAVE_VERIFY_CACHE
+#ifndef WOLFSSL_SP_NO_256
+    if (curve_id == ECC_SECP256R1) {
+        sp_ecc_verify_cache_clear_256();
+        return 0;
+    }
+#endif
+#ifdef WOLFSSL_SP_384
+    if (curve_id == ECC_SECP384R1) {
+        sp_ecc_verify_cache_clear_384();
+        return 0;
+    }
+#endif
+#endif
+    (void)curve_id;
+    return NOT_COMPILED_IN;
+}
+#endif /* WOLFSSL_SP_VERIFY_CACHE */
+
 
 /**
    Verify an ECC signature
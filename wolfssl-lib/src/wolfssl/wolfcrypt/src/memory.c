@@ -244,6 +244,27 @@ struct wc_Memory {
     word32 sz;
 };
 
+/* Handshake arena of one connection. Allocations are bumped from buffer and
+ * the arena is reset when all of them are freed. */
+struct wc_Arena {
+    wc_Arena* next;
+    byte*  buffer;
+    word32 used;   /* bytes of buffer handed out */
+    word32 live;   /* allocations not freed yet */
+    word32 peak;   /* most bytes of buffer used */
+    byte   done;   /* handshake over, back to the pool when live is 0 */
+};
+
+#define ARENA_ALIGN(x)  (((x) + WOLFSSL_STATIC_ALIGN - 1) & \
+                                             ~(word32)(WOLFSSL_STATIC_ALIGN - 1))
+#define ARENA_HDR_SZ    ARENA_ALIGN((word32)sizeof(wc_Arena))
+#define ARENA_BUF_SZ    ARENA_ALIGN((word32)WOLFMEM_ARENA_SZ)
+#define ARENA_STRIDE    (ARENA_HDR_SZ + ARENA_BUF_SZ)
+
+/* pools with only arenas take the rest from the system heap */
+#define SYS_FALLBACK(mem) (!(mem)->general && !((mem)->flag & \
+                                     (WOLFMEM_IO_POOL | WOLFMEM_IO_POOL_FIXED)))
+
 
 /* returns amount of memory used on success. On error returns negative value
    wc_Memory** list is the list that new buckets are prepended to
@@ -289,6 +310,205 @@ static int create_memory_buckets(byte* buffer, word32 bufSz,
     return ret;
 }
 
+/* Carves handshake arenas out of buffer, returns the amount of memory used */
+static int create_arenas(byte* buffer, word32 bufSz, WOLFSSL_HEAP* heap)
+{
+    word32 used = 0;
+
+    while (ARENA_STRIDE <= bufSz - used) {
+        wc_Arena* arena = (wc_Arena*)(buffer + used);
+
+        XMEMSET(arena, 0, sizeof(wc_Arena));
+        arena->buffer = buffer + used + ARENA_HDR_SZ;
+        arena->next   = heap->arena;
+        heap->arena   = arena;
+        used += ARENA_STRIDE;
+    }
+    heap->arenaBase = buffer;
+    heap->arenaEnd  = buffer + used;
+
+    return (int)used;
+}
+
+/* returns 1 if ptr is in one of the heap's arenas */
+static WC_INLINE int ArenaOwns(WOLFSSL_HEAP* mem, const void* ptr)
+{
+    return (const byte*)ptr >= mem->arenaBase &&
+           (const byte*)ptr <  mem->arenaEnd;
+}
+
+/* Types that outlive the handshake are kept out of the arena, so it can be
+ * given back when the handshake is done. */
+static int ArenaType(int type)
+{
+    switch (type) {
+        case DYNAMIC_TYPE_SSL:
+        case DYNAMIC_TYPE_IN_BUFFER:
+        case DYNAMIC_TYPE_OUT_BUFFER:
+        case DYNAMIC_TYPE_CIPHER:
+        case DYNAMIC_TYPE_RNG:
+        case DYNAMIC_TYPE_X509:
+        case DYNAMIC_TYPE_TLSX:
+        case DYNAMIC_TYPE_ALPN:
+        case DYNAMIC_TYPE_DOMAIN:
+        case DYNAMIC_TYPE_SESSION:
+        case DYNAMIC_TYPE_SESSION_TICK:
+            return 0;
+        default:
+            return 1;
+    }
+}
+
+/* Bump allocates size bytes from arena, returns NULL if it doesn't fit */
+static wc_Memory* ArenaAlloc(wc_Arena* arena, size_t size)
+{
+    word32 memSz = (word32)sizeof(wc_Memory);
+    word32 padSz = -(int)memSz & (WOLFSSL_STATIC_ALIGN - 1);
+    word32 need;
+    wc_Memory* pt;
+
+    if (arena->done || size > ARENA_BUF_SZ) {
+        return NULL;
+    }
+    need = memSz + padSz + ARENA_ALIGN((word32)size);
+    if (need > ARENA_BUF_SZ - arena->used) {
+        return NULL;
+    }
+
+    pt = (wc_Memory*)(arena->buffer + arena->used);
+    pt->buffer = (byte*)pt + memSz + padSz;
+    pt->next   = NULL;
+    pt->sz     = ARENA_ALIGN((word32)size);
+
+    arena->used += need;
+    arena->live++;
+    if (arena->peak < arena->used) {
+        arena->peak = arena->used;
+    }
+
+    return pt;
+}
+
+/* Frees an arena allocation, the arena is reset when none are left */
+static void ArenaFree(WOLFSSL_HEAP* mem, wc_Memory* pt)
+{
+    word32 memSz = (word32)sizeof(wc_Memory);
+    word32 padSz = -(int)memSz & (WOLFSSL_STATIC_ALIGN - 1);
+    wc_Arena* arena = (wc_Arena*)(mem->arenaBase +
+             (word32)(pt->buffer - mem->arenaBase) / ARENA_STRIDE * ARENA_STRIDE);
+
+    /* last allocation can be given back right away */
+    if (pt->buffer + pt->sz == arena->buffer + arena->used) {
+        arena->used -= pt->sz + memSz + padSz;
+    }
+    if (arena->live > 0 && --arena->live == 0) {
+        arena->used = 0;
+        if (arena->done) {
+            arena->done = 0;
+            arena->next = mem->arena;
+            mem->arena  = arena;
+        }
+    }
+}
+
+/* system heap memory for pools without general buckets, with a bucket
+ * header so it's freed and resized like the rest */
+static wc_Memory* SysAlloc(size_t size)
+{
+#ifndef WOLFSSL_NO_MALLOC
+    word32 memSz = (word32)sizeof(wc_Memory);
+    word32 padSz = -(int)memSz & (WOLFSSL_STATIC_ALIGN - 1);
+    wc_Memory* pt;
+
+    #ifdef FREERTOS
+    pt = (wc_Memory*)pvPortMalloc(memSz + padSz + size);
+    #else
+    pt = (wc_Memory*)malloc(memSz + padSz + size);
+    #endif
+    if (pt != NULL) {
+        pt->buffer = (byte*)pt + memSz + padSz;
+        pt->next   = NULL;
+        pt->sz     = (word32)size;
+    }
+
+    return pt;
+#else
+    (void)size;
+    return NULL;
+#endif
+}
+
+static void SysFree(wc_Memory* pt)
+{
+#ifndef WOLFSSL_NO_MALLOC
+    #ifdef FREERTOS
+    vPortFree(pt);
+    #else
+    free(pt);
+    #endif
+#else
+    (void)pt;
+#endif
+}
+
+#ifdef WOLFSSL_MEM_PROFILE
+/* Counts an allocation of sz bytes against the connection's current phase
+ * and the call site */
+static void ProfileAlloc(WOLFSSL_HEAP_HINT* hint, word32 sz, const char* func,
+                         word32 line)
+{
+    WOLFSSL_MEM_CONN_PROFILE* prof = hint->profile;
+    WOLFSSL_MEM_SITE* site = NULL;
+    WOLFSSL_MEM_SITE* low  = &prof->site[0];
+    byte phase = (hint->phase != NULL) ? *hint->phase : 0;
+    int i;
+
+    if (phase >= WOLFMEM_PROFILE_PHASES) {
+        phase = WOLFMEM_PROFILE_PHASES - 1;
+    }
+
+    prof->alloc++;
+    prof->curMem += sz;
+    if (prof->peakMem < prof->curMem) {
+        prof->peakMem = prof->curMem;
+    }
+    prof->phase[phase].alloc++;
+    prof->phase[phase].bytes += sz;
+    if (prof->phase[phase].peakMem < prof->curMem) {
+        prof->phase[phase].peakMem = prof->curMem;
+    }
+
+    for (i = 0; i < WOLFMEM_PROFILE_SITES; i++) {
+        WOLFSSL_MEM_SITE* s = &prof->site[i];
+
+        if (s->alloc > 0 && s->phase == phase && s->line == line &&
+                                                             s->func == func) {
+            site = s;
+            break;
+        }
+        if (s->alloc < low->alloc) {
+            low = s;
+        }
+    }
+    if (site == NULL) {
+        /* replace the least used site, keeping its counts */
+        site = low;
+        site->func  = func;
+        site->line  = line;
+        site->phase = phase;
+    }
+    site->alloc++;
+    site->bytes += sz;
+}
+
+static void ProfileFree(WOLFSSL_HEAP_HINT* hint, word32 sz)
+{
+    WOLFSSL_MEM_CONN_PROFILE* prof = hint->profile;
+
+    prof->curMem = (prof->curMem > sz) ? prof->curMem - sz : 0;
+}
+#endif /* WOLFSSL_MEM_PROFILE */
+
 int wolfSSL_init_memory_heap(WOLFSSL_HEAP* heap)
 {
     word32 wc_MemSz[WOLFMEM_DEF_BUCKETS] = { WOLFMEM_BUCKETS };
@@ -402,6 +622,26 @@ int wolfSSL_load_static_memory(byte* buffer, word32 sz, int flag,
     printf("Allocated %d bytes for static memory @ %p\n", ava, pt);
 #endif
 
+    /* one region of handshake arenas per heap */
+    if (flag & WOLFMEM_ARENA) {
+        if (heap->arenaBase != NULL) {
+            WOLFSSL_MSG("Handshake arenas already loaded");
+            return BAD_FUNC_ARG;
+        }
+        if (create_arenas(pt, ava, heap) == 0) {
+            WOLFSSL_MSG("Not enough memory for a handshake arena");
+            return BUFFER_E;
+        }
+        return 1;
+    }
+
+    /* a pool of only arenas may already hold system heap memory, which would
+     * then be freed as static memory */
+    if (heap->arenaBase != NULL && SYS_FALLBACK(heap)) {
+        WOLFSSL_MSG("Load general and IO memory before the arenas");
+        return BAD_FUNC_ARG;
+    }
+
     /* divide into chunks of memory and add them to available list */
     while (ava >= (heap->sizeList[0] + padSz + memSz)) {
         int i;
@@ -424,6 +664,7 @@ int wolfSSL_load_static_memory(byte* buffer, word32 sz, int flag,
             ava -= ret;
         }
         else {
+            heap->general = 1;
             /* start at largest and move to smaller buckets */
             for (i = (WOLFMEM_MAX_BUCKETS - 1); i >= 0; i--) {
                 if ((heap->sizeList[i] + padSz + memSz) <= ava) {
@@ -480,8 +721,11 @@ int wolfSSL_StaticBufferSz(byte* buffer, word32 sz, int flag)
         ava--;
     }
 
+    if (flag & WOLFMEM_ARENA) {
+        ava = ava % ARENA_STRIDE;
+    }
     /* creating only IO buffers from memory passed in, max TLS is 16k */
-    if (flag & WOLFMEM_IO_POOL || flag & WOLFMEM_IO_POOL_FIXED) {
+    else if (flag & WOLFMEM_IO_POOL || flag & WOLFMEM_IO_POOL_FIXED) {
         if (ava < (memSz + padSz + WOLFMEM_IO_SZ)) {
             return 0; /* not enough room for even one bucket */
         }
@@ -555,10 +799,60 @@ int SetFixedIO(WOLFSSL_HEAP* heap, wc_Memory** io)
 }
 
 
+/* Takes a handshake arena from the heap for a connection, returns 1 on
+ * success and 0 when none are free. Call with the heap locked. */
+int SetArena(WOLFSSL_HEAP* heap, wc_Arena** arena)
+{
+    WOLFSSL_MSG("Setting handshake arena for SSL");
+    if (heap == NULL) {
+        return MEMORY_E;
+    }
+
+    *arena = heap->arena;
+    if (*arena == NULL) {
+        return 0;
+    }
+    heap->arena    = (*arena)->next;
+    (*arena)->next = NULL;
+    (*arena)->done = 0;
+
+    return 1;
+}
+
+
+/* Gives a connection's arena back to the heap. If allocations in it are still
+ * in use it goes back when the last one is freed. Call with the heap
+ * locked. */
+int ReleaseArena(WOLFSSL_HEAP* heap, wc_Arena** arena)
+{
+    if (*arena == NULL) {
+        return 1;
+    }
+    if (heap == NULL) {
+        WOLFSSL_MSG("No heap to return handshake arena too");
+        return MEMORY_E;
+    }
+
+    if ((*arena)->live == 0) {
+        (*arena)->used = 0;
+        (*arena)->next = heap->arena;
+        heap->arena    = *arena;
+    }
+    else {
+        WOLFSSL_MSG("Handshake arena still in use, release on last free");
+        (*arena)->done = 1;
+    }
+    *arena = NULL;
+
+    return 1;
+}
+
+
 int wolfSSL_GetMemStats(WOLFSSL_HEAP* heap, WOLFSSL_MEM_STATS* stats)
 {
         word32     i;
         wc_Memory* pt;
+        wc_Arena*  arena;
 
         XMEMSET(stats, 0, sizeof(WOLFSSL_MEM_STATS));
 
@@ -577,6 +871,9 @@ int wolfSSL_GetMemStats(WOLFSSL_HEAP* heap, WOLFSSL_MEM_STATS* stats)
         for (pt = heap->io; pt != NULL; pt = pt->next) {
             stats->avaIO++;
         }
+        for (arena = heap->arena; arena != NULL; arena = arena->next) {
+            stats->avaArena++;
+        }
 
         stats->flag       = heap->flag; /* flag used */
 
@@ -638,8 +935,23 @@ void* wolfSSL_Malloc(size_t size, void* heap, int type)
             return NULL;
         }
 
+        /* handshake memory from the connection's arena */
+        if (hint->arena != NULL && ArenaType(type)) {
+            pt = ArenaAlloc(hint->arena, size);
+        }
+
         /* case of using fixed IO buffers */
-        if (mem->flag & WOLFMEM_IO_POOL_FIXED &&
+        if (pt != NULL) {
+        #ifdef WOLFSSL_MEM_PROFILE
+            if (hint->profile != NULL) {
+                hint->profile->arenaAlloc++;
+                if (hint->profile->arenaPeak < hint->arena->peak) {
+                    hint->profile->arenaPeak = hint->arena->peak;
+                }
+            }
+        #endif
+        }
+        else if (mem->flag & WOLFMEM_IO_POOL_FIXED &&
                                              (type == DYNAMIC_TYPE_OUT_BUFFER ||
                                               type == DYNAMIC_TYPE_IN_BUFFER)) {
             if (type == DYNAMIC_TYPE_OUT_BUFFER) {
@@ -678,6 +990,16 @@ void* wolfSSL_Malloc(size_t size, void* heap, int type)
                     }
                 }
             }
+
+            /* pool of only arenas, the rest is from the system heap */
+            if (pt == NULL && SYS_FALLBACK(mem)) {
+                pt = SysAlloc(size);
+            #ifdef WOLFSSL_MEM_PROFILE
+                if (pt != NULL && hint->profile != NULL) {
+                    hint->profile->sysAlloc++;
+                }
+            #endif
+            }
         }
 
         if (pt != NULL) {
@@ -685,6 +1007,16 @@ void* wolfSSL_Malloc(size_t size, void* heap, int type)
             mem->alloc += 1;
             res = pt->buffer;
 
+        #ifdef WOLFSSL_MEM_PROFILE
+            if (hint->profile != NULL) {
+            #ifdef WOLFSSL_DEBUG_MEMORY
+                ProfileAlloc(hint, pt->sz, func, line);
+            #else
+                ProfileAlloc(hint, pt->sz, NULL, (word32)type);
+            #endif
+            }
+        #endif
+
         #ifdef WOLFSSL_DEBUG_MEMORY
             printf("Alloc: %p -> %u at %s:%d\n", pt->buffer, pt->sz, func, line);
         #endif
@@ -775,14 +1107,27 @@ void wolfSSL_Free(void *ptr, void* heap, int type)
             word32 padSz = -(int)sizeof(wc_Memory) & (WOLFSSL_STATIC_ALIGN - 1);
 
             /* get memory struct and add it to available list */
+            wc_Memory* sysPt = NULL;
+
             pt = (wc_Memory*)((byte*)ptr - sizeof(wc_Memory) - padSz);
             if (wc_LockMutex(&(mem->memory_mutex)) != 0) {
                 WOLFSSL_MSG("Bad memory_mutex lock");
+                /* the CTX is freed after the heap's mutex, system heap
+                 * memory still has to be given back */
+                if (!ArenaOwns(mem, ptr) && SYS_FALLBACK(mem)) {
+                    SysFree(pt);
+                }
                 return;
             }
 
+            if (ArenaOwns(mem, ptr)) {
+                ArenaFree(mem, pt);
+            }
+            else if (SYS_FALLBACK(mem)) {
+                sysPt = pt; /* freed after the stats are updated */
+            }
             /* case of using fixed IO buffers */
-            if (mem->flag & WOLFMEM_IO_POOL_FIXED &&
+            else if (mem->flag & WOLFMEM_IO_POOL_FIXED &&
                                              (type == DYNAMIC_TYPE_OUT_BUFFER ||
                                               type == DYNAMIC_TYPE_IN_BUFFER)) {
                 /* fixed IO pools are free'd at the end of SSL lifetime
@@ -828,7 +1173,16 @@ void wolfSSL_Free(void *ptr, void* heap, int type)
                     stats->totalFr++;
                 }
             }
+        #ifdef WOLFSSL_MEM_PROFILE
+            if (hint->profile != NULL) {
+                ProfileFree(hint, pt->sz);
+            }
+        #endif
             wc_UnLockMutex(&(mem->memory_mutex));
+
+            if (sysPt != NULL) {
+                SysFree(sysPt);
+            }
         }
     }
 
@@ -878,6 +1232,25 @@ void* wolfSSL_Realloc(void *ptr, size_t size, void* heap, int type)
         #endif
         }
 
+        /* arena and system heap memory is moved with a new allocation */
+        if (ArenaOwns(mem, ptr) || SYS_FALLBACK(mem)) {
+            prvSz = ((wc_Memory*)((byte*)ptr - padSz - sizeof(wc_Memory)))->sz;
+        #ifdef WOLFSSL_DEBUG_MEMORY
+            res = wolfSSL_Malloc(size, heap, type, func, line);
+        #else
+            res = wolfSSL_Malloc(size, heap, type);
+        #endif
+            if (res != NULL) {
+                XMEMCPY(res, ptr, (prvSz < size) ? prvSz : size);
+            #ifdef WOLFSSL_DEBUG_MEMORY
+                wolfSSL_Free(ptr, heap, type, func, line);
+            #else
+                wolfSSL_Free(ptr, heap, type);
+            #endif
+            }
+            return res;
+        }
+
         if (wc_LockMutex(&(mem->memory_mutex)) != 0) {
             WOLFSSL_MSG("Bad memory_mutex lock");
             return NULL;
@@ -43,6 +43,9 @@
     #define WOLFSSL_MISC_INCLUDED
     #include <wolfcrypt/src/misc.c>
 #endif
+#ifdef WOLFSSL_AESGCM_STITCH
+    #include <arm_neon.h>
+#endif
 
 #ifdef _MSC_VER
     /* 4127 warning constant while(1)  */
@@ -1507,6 +1510,177 @@ void GHASH(Aes* aes, const byte* a, word32 aSz,
 }
 
 
+#ifdef WOLFSSL_AESGCM_STITCH
+/* Stitched AES-GCM, 8 blocks at a time.
+ *
+ * The GHASH values are bit reflected within each byte (RBIT) like aes->H, so
+ * the 64-bit lanes are polynomials for PMULL and the reduction is by
+ * x^128 = x^7 + x^2 + x + 1 (0x87), as in GMULT.
+ * The 8 products (X ^ C0).H^8 + C1.H^7 + ... + C7.H are summed unreduced and
+ * reduced once (aggregated reduction), with the multiplies interleaved
+ * between the AES rounds of the 8 counter blocks.
+ */
+
+/* a * b added, unreduced, to lo, mid and hi */
+static WC_INLINE void GcmMulAcc(uint8x16_t a, uint8x16_t b, uint8x16_t* lo,
+                                uint8x16_t* mid, uint8x16_t* hi)
+{
+    poly64x2_t pa = vreinterpretq_p64_u8(a);
+    poly64x2_t pb = vreinterpretq_p64_u8(b);
+    poly64x2_t ps = vreinterpretq_p64_u8(vextq_u8(b, b, 8)); /* b1b0 */
+    poly64_t   a0 = vgetq_lane_p64(pa, 0);
+
+    *lo  = veorq_u8(*lo, vreinterpretq_u8_p128(
+                                    vmull_p64(a0, vgetq_lane_p64(pb, 0))));
+    *hi  = veorq_u8(*hi, vreinterpretq_u8_p128(vmull_high_p64(pa, pb)));
+    *mid = veorq_u8(*mid, vreinterpretq_u8_p128(
+                                    vmull_p64(a0, vgetq_lane_p64(ps, 0))));
+    *mid = veorq_u8(*mid, vreinterpretq_u8_p128(vmull_high_p64(pa, ps)));
+}
+
+/* Reduces the 256-bit lo, mid, hi sum to 128 bits (Algorithm 5 of
+ * "Implementing GCM on ARMv8" by Conrado P.L. Gouvea and Julio Lopez) */
+static WC_INLINE uint8x16_t GcmReduce(uint8x16_t lo, uint8x16_t mid,
+                                      uint8x16_t hi)
+{
+    const uint8x16_t zero = vdupq_n_u8(0);
+    const poly64x2_t r = vreinterpretq_p64_u64(vdupq_n_u64(0x87));
+    uint8x16_t t;
+
+    lo = veorq_u8(lo, vextq_u8(zero, mid, 8));
+    hi = veorq_u8(hi, vextq_u8(mid, zero, 8));
+
+    t  = vreinterpretq_u8_p128(vmull_high_p64(vreinterpretq_p64_u8(hi), r));
+    hi = veorq_u8(hi, vextq_u8(t, zero, 8));
+    lo = veorq_u8(lo, vextq_u8(zero, t, 8));
+    t  = vreinterpretq_u8_p128(vmull_p64(
+                vgetq_lane_p64(vreinterpretq_p64_u8(hi), 0),
+                vgetq_lane_p64(r, 0)));
+    return veorq_u8(lo, t);
+}
+
+/* Stores H^1 .. H^8 in aes->Hpow, called when the GCM key is set */
+static void AesGcmStitchSetKey(Aes* aes)
+{
+    const uint8x16_t zero = vdupq_n_u8(0);
+    uint8x16_t h = vld1q_u8(aes->H);
+    uint8x16_t p = h;
+    int i;
+
+    vst1q_u8(aes->Hpow[0], h);
+    for (i = 1; i < GCM_STITCH_BLOCKS; i++) {
+        uint8x16_t lo = zero, mid = zero, hi = zero;
+
+        GcmMulAcc(p, h, &lo, &mid, &hi);
+        p = GcmReduce(lo, mid, hi);
+        vst1q_u8(aes->Hpow[i], p);
+    }
+}
+
+/* AES-CTR encrypts or decrypts blocks (a multiple of GCM_STITCH_BLOCKS) and
+ * hashes the cipher text into x.
+ * ctr: last counter used, updated to the last counter of these blocks
+ * x:   GHASH value (not reflected), updated
+ * enc: when encrypting the cipher text of a group is hashed while the next
+ *      group is encrypted, when decrypting the group being decrypted is hashed
+ */
+static void AesGcmStitch(Aes* aes, byte* out, const byte* in, word32 blocks,
+                         byte* ctr, byte* x, int enc)
+{
+    uint8x16_t rk[15];
+    uint8x16_t hp[GCM_STITCH_BLOCKS];
+    uint8x16_t s[GCM_STITCH_BLOCKS];
+    uint8x16_t c[GCM_STITCH_BLOCKS];
+    uint8x16_t lo, mid, hi, xr;
+    const uint8x16_t zero = vdupq_n_u8(0);
+    uint32x4_t iv = vreinterpretq_u32_u8(vld1q_u8(ctr));
+    word32 n = ByteReverseWord32(vgetq_lane_u32(iv, 3));
+    int nr = (int)aes->rounds;
+    int hash = !enc; /* nothing to hash before the first encrypted group */
+    int i, r;
+
+    for (i = 0; i <= nr; i++)
+        rk[i] = vld1q_u8((const byte*)aes->key + i * AES_BLOCK_SIZE);
+    for (i = 0; i < GCM_STITCH_BLOCKS; i++) {
+        /* block i is multiplied by H^(8-i) */
+        hp[i] = vld1q_u8(aes->Hpow[GCM_STITCH_BLOCKS - 1 - i]);
+        c[i] = zero;
+    }
+    xr = vrbitq_u8(vld1q_u8(x));
+
+    for (; blocks >= GCM_STITCH_BLOCKS; blocks -= GCM_STITCH_BLOCKS) {
+        for (i = 0; i < GCM_STITCH_BLOCKS; i++) {
+            s[i] = vreinterpretq_u8_u32(
+                        vsetq_lane_u32(ByteReverseWord32(++n), iv, 3));
+        }
+        if (!enc) {
+            for (i = 0; i < GCM_STITCH_BLOCKS; i++)
+                c[i] = vrbitq_u8(vld1q_u8(in + i * AES_BLOCK_SIZE));
+        }
+        c[0] = veorq_u8(c[0], xr);
+        lo = mid = hi = zero;
+
+        /* at least 9 full rounds, one GHASH multiply in each of the first 8 */
+        for (r = 0; r < nr - 1; r++) {
+            for (i = 0; i < GCM_STITCH_BLOCKS; i++)
+                s[i] = vaesmcq_u8(vaeseq_u8(s[i], rk[r]));
+            if (hash && r < GCM_STITCH_BLOCKS)
+                GcmMulAcc(c[r], hp[r], &lo, &mid, &hi);
+        }
+        for (i = 0; i < GCM_STITCH_BLOCKS; i++)
+            s[i] = veorq_u8(vaeseq_u8(s[i], rk[nr - 1]), rk[nr]);
+        if (hash)
+            xr = GcmReduce(lo, mid, hi);
+
+        for (i = 0; i < GCM_STITCH_BLOCKS; i++) {
+            s[i] = veorq_u8(s[i], vld1q_u8(in + i * AES_BLOCK_SIZE));
+            vst1q_u8(out + i * AES_BLOCK_SIZE, s[i]);
+            if (enc)
+                c[i] = vrbitq_u8(s[i]);
+        }
+        in  += GCM_STITCH_BLOCKS * AES_BLOCK_SIZE;
+        out += GCM_STITCH_BLOCKS * AES_BLOCK_SIZE;
+        hash = 1;
+    }
+
+    if (enc && hash) {
+        /* hash the last encrypted group */
+        c[0] = veorq_u8(c[0], xr);
+        lo = mid = hi = zero;
+        for (i = 0; i < GCM_STITCH_BLOCKS; i++)
+            GcmMulAcc(c[i], hp[i], &lo, &mid, &hi);
+        xr = GcmReduce(lo, mid, hi);
+    }
+
+    vst1q_u8(x, vrbitq_u8(xr));
+    vst1q_u8(ctr, vreinterpretq_u8_u32(
+                        vsetq_lane_u32(ByteReverseWord32(n), iv, 3)));
+}
+
+#ifdef HAVE_AES_DECRYPT
+/* Hashes data into x, a partial last block is zero padded */
+static void GcmHashUpdate(Aes* aes, byte* x, const byte* data, word32 sz)
+{
+    byte scratch[AES_BLOCK_SIZE];
+    word32 blocks = sz / AES_BLOCK_SIZE;
+    word32 partial = sz % AES_BLOCK_SIZE;
+
+    while (blocks--) {
+        xorbuf(x, data, AES_BLOCK_SIZE);
+        GMULT(x, aes->H);
+        data += AES_BLOCK_SIZE;
+    }
+    if (partial != 0) {
+        XMEMSET(scratch, 0, AES_BLOCK_SIZE);
+        XMEMCPY(scratch, data, partial);
+        xorbuf(x, scratch, AES_BLOCK_SIZE);
+        GMULT(x, aes->H);
+    }
+}
+#endif /* HAVE_AES_DECRYPT */
+#endif /* WOLFSSL_AESGCM_STITCH */
+
+
 #ifdef WOLFSSL_AES_128
 /* internal function : see wc_AesGcmEncrypt */
 static int Aes128GcmEncrypt(Aes* aes, byte* out, const byte* in, word32 sz,
@@ -1566,6 +1740,16 @@ static int Aes128GcmEncrypt(Aes* aes, byte* out, const byte* in, word32 sz,
     /* do as many blocks as possible */
     blocks = sz / AES_BLOCK_SIZE;
     partial = sz % AES_BLOCK_SIZE;
+#ifdef WOLFSSL_AESGCM_STITCH
+    if (blocks >= GCM_STITCH_BLOCKS) {
+        word32 done = blocks - (blocks % GCM_STITCH_BLOCKS);
+
+        AesGcmStitch(aes, out, in, done, counter, x, 1);
+        in  += done * AES_BLOCK_SIZE;
+        out += done * AES_BLOCK_SIZE;
+        blocks -= done;
+    }
+#endif
     if (blocks > 0) {
         keyPt  = (byte*)aes->key;
         __asm__ __volatile__ (
@@ -1884,6 +2068,16 @@ static int Aes192GcmEncrypt(Aes* aes, byte* out, const byte* in, word32 sz,
     /* do as many blocks as possible */
     blocks = sz / AES_BLOCK_SIZE;
     partial = sz % AES_BLOCK_SIZE;
+#ifdef WOLFSSL_AESGCM_STITCH
+    if (blocks >= GCM_STITCH_BLOCKS) {
+        word32 done = blocks - (blocks % GCM_STITCH_BLOCKS);
+
+        AesGcmStitch(aes, out, in, done, counter, x, 1);
+        in  += done * AES_BLOCK_SIZE;
+        out += done * AES_BLOCK_SIZE;
+        blocks -= done;
+    }
+#endif
     if (blocks > 0) {
         keyPt  = (byte*)aes->key;
         __asm__ __volatile__ (
@@ -2217,6 +2411,16 @@ static int Aes256GcmEncrypt(Aes* aes, byte* out, const byte* in, word32 sz,
     /* do as many blocks as possible */
     blocks = sz / AES_BLOCK_SIZE;
     partial = sz % AES_BLOCK_SIZE;
+#ifdef WOLFSSL_AESGCM_STITCH
+    if (blocks >= GCM_STITCH_BLOCKS) {
+        word32 done = blocks - (blocks % GCM_STITCH_BLOCKS);
+
+        AesGcmStitch(aes, out, in, done, counter, x, 1);
+        in  += done * AES_BLOCK_SIZE;
+        out += done * AES_BLOCK_SIZE;
+        blocks -= done;
+    }
+#endif
     if (blocks > 0) {
         keyPt  = (byte*)aes->key;
         __asm__ __volatile__ (
@@ -2621,15 +2825,43 @@ int  wc_AesGcmDecrypt(Aes* aes, byte* out, const byte* in, word32 sz,
     {
         byte Tprime[AES_BLOCK_SIZE];
         byte EKY0[AES_BLOCK_SIZE];
-
-        GHASH(aes, authIn, authInSz, in, sz, Tprime, sizeof(Tprime));
+    #ifdef WOLFSSL_AESGCM_STITCH
+        word32 done = 0;
+
+        if (blocks >= GCM_STITCH_BLOCKS) {
+            /* decrypt while hashing the cipher text, the plain text is
+             * cleared if the tag does not match */
+            done = blocks - (blocks % GCM_STITCH_BLOCKS);
+            XMEMSET(Tprime, 0, sizeof(Tprime));
+            if (authInSz != 0 && authIn != NULL)
+                GcmHashUpdate(aes, Tprime, authIn, authInSz);
+            AesGcmStitch(aes, p, c, done, ctr, Tprime, 0);
+            GcmHashUpdate(aes, Tprime, c + done * AES_BLOCK_SIZE,
+                          sz - done * AES_BLOCK_SIZE);
+            FlattenSzInBits(&scratch[0], authInSz);
+            FlattenSzInBits(&scratch[8], sz);
+            xorbuf(Tprime, scratch, sizeof(Tprime));
+        }
+        else
+    #endif
+        {
+            GHASH(aes, authIn, authInSz, in, sz, Tprime, sizeof(Tprime));
+        }
         GMULT(Tprime, aes->H);
-        wc_AesEncrypt(aes, ctr, EKY0);
+        wc_AesEncrypt(aes, initialCounter, EKY0);
         xorbuf(Tprime, EKY0, sizeof(Tprime));
 
         if (ConstantCompare(authTag, Tprime, authTagSz) != 0) {
+        #ifdef WOLFSSL_AESGCM_STITCH
+            ForceZero(out, done * AES_BLOCK_SIZE);
+        #endif
             return AES_GCM_AUTH_E;
         }
+    #ifdef WOLFSSL_AESGCM_STITCH
+        c += done * AES_BLOCK_SIZE;
+        p += done * AES_BLOCK_SIZE;
+        blocks -= done;
+    #endif
     }
 
     /* do as many blocks as possible */
@@ -4608,6 +4840,9 @@ int wc_AesGcmSetKey(Aes* aes, const byte* key, word32 len)
                 : "cc", "memory", "v0"
             );
         }
+    #ifdef WOLFSSL_AESGCM_STITCH
+        AesGcmStitchSetKey(aes);
+    #endif
     #else
         {
             word32* pt = (word32*)aes->H;
@@ -39,6 +39,9 @@
     #define WOLFSSL_MISC_INCLUDED
     #include <wolfcrypt/src/misc.c>
 #endif
+#if defined(WOLFSSL_SHA256_MULTI) && defined(__aarch64__)
+    #include <arm_neon.h>
+#endif
 
 
 static const ALIGN32 word32 K[64] = {
@@ -1376,6 +1379,222 @@ int wc_Sha256Copy(wc_Sha256* src, wc_Sha256* dst)
     return ret;
 }
 
+#ifdef WOLFSSL_SHA256_MULTI
+#ifdef __aarch64__
+
+/* One block on each of two lanes. The SHA256H/SHA256H2 chains of the two
+ * lanes are independent, so interleaving them keeps the SHA pipeline full
+ * where a single stream waits on each instruction's latency. */
+static void Transform_Sha256_Multi2(word32* d0, word32* d1, const byte* b0,
+                                    const byte* b1)
+{
+    uint32x4_t abcd0, efgh0, abcd1, efgh1;
+    uint32x4_t save0, save1, save2, save3;
+    uint32x4_t m0[4], m1[4];
+    int i;
+
+    abcd0 = vld1q_u32(d0);
+    efgh0 = vld1q_u32(d0 + 4);
+    abcd1 = vld1q_u32(d1);
+    efgh1 = vld1q_u32(d1 + 4);
+    save0 = abcd0; save1 = efgh0;
+    save2 = abcd1; save3 = efgh1;
+
+    for (i = 0; i < 4; i++) {
+    #ifdef LITTLE_ENDIAN_ORDER
+        m0[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(b0 + 16 * i)));
+        m1[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(b1 + 16 * i)));
+    #else
+        m0[i] = vreinterpretq_u32_u8(vld1q_u8(b0 + 16 * i));
+        m1[i] = vreinterpretq_u32_u8(vld1q_u8(b1 + 16 * i));
+    #endif
+    }
+
+    /* 4 rounds per step, the message schedule runs 4 words ahead */
+    for (i = 0; i < 16; i++) {
+        uint32x4_t k = vld1q_u32(&K[4 * i]);
+        uint32x4_t wk0 = vaddq_u32(m0[i & 3], k);
+        uint32x4_t wk1 = vaddq_u32(m1[i & 3], k);
+        uint32x4_t t0 = abcd0;
+        uint32x4_t t1 = abcd1;
+
+        if (i < 12) {
+            m0[i & 3] = vsha256su1q_u32(
+                vsha256su0q_u32(m0[i & 3], m0[(i + 1) & 3]),
+                m0[(i + 2) & 3], m0[(i + 3) & 3]);
+            m1[i & 3] = vsha256su1q_u32(
+                vsha256su0q_u32(m1[i & 3], m1[(i + 1) & 3]),
+                m1[(i + 2) & 3], m1[(i + 3) & 3]);
+        }
+        abcd0 = vsha256hq_u32(abcd0, efgh0, wk0);
+        abcd1 = vsha256hq_u32(abcd1, efgh1, wk1);
+        efgh0 = vsha256h2q_u32(efgh0, t0, wk0);
+        efgh1 = vsha256h2q_u32(efgh1, t1, wk1);
+    }
+
+    vst1q_u32(d0,     vaddq_u32(abcd0, save0));
+    vst1q_u32(d0 + 4, vaddq_u32(efgh0, save1));
+    vst1q_u32(d1,     vaddq_u32(abcd1, save2));
+    vst1q_u32(d1 + 4, vaddq_u32(efgh1, save3));
+}
+
+/* up to WC_SHA256_MULTI_LANES contexts, loLen counts the hashed blocks only
+ * (buffered bytes are added in the final) like Sha256Update above */
+static int Sha256MultiUpdate(wc_Sha256** sha256, const byte** data,
+                             const word32* len, int n)
+{
+    int i, cnt;
+    word32 fill;
+    const byte* in[WC_SHA256_MULTI_LANES];
+    word32 left[WC_SHA256_MULTI_LANES];
+    wc_Sha256* lane[WC_SHA256_MULTI_LANES];
+    ALIGN16 byte blk[WC_SHA256_MULTI_LANES][WC_SHA256_BLOCK_SIZE];
+    ALIGN16 word32 spare[WC_SHA256_DIGEST_SIZE / sizeof(word32)];
+
+    for (i = 0; i < n; i++) {
+        in[i] = data[i];
+        left[i] = len[i];
+    }
+
+    /* gather the next block of every lane that has one */
+    do {
+        cnt = 0;
+        for (i = 0; i < n; i++) {
+            wc_Sha256* s = sha256[i];
+            if (s->buffLen + left[i] < WC_SHA256_BLOCK_SIZE)
+                continue;
+            fill = WC_SHA256_BLOCK_SIZE - s->buffLen;
+            XMEMCPY(blk[cnt], s->buffer, s->buffLen);
+            XMEMCPY(blk[cnt] + s->buffLen, in[i], fill);
+            AddLength(s, WC_SHA256_BLOCK_SIZE);
+            s->buffLen = 0;
+            in[i] += fill;
+            left[i] -= fill;
+            lane[cnt++] = s;
+        }
+        for (i = 0; i + 1 < cnt; i += 2) {
+            Transform_Sha256_Multi2(lane[i]->digest, lane[i + 1]->digest,
+                                    blk[i], blk[i + 1]);
+        }
+        if (i < cnt) {
+            /* odd lane out, pair it with a throwaway state */
+            XMEMCPY(spare, lane[i]->digest, sizeof(spare));
+            Transform_Sha256_Multi2(lane[i]->digest, spare, blk[i], blk[i]);
+        }
+    } while (cnt > 0);
+
+    /* buffer the tails */
+    for (i = 0; i < n; i++) {
+        if (left[i] > 0) {
+            XMEMCPY((byte*)sha256[i]->buffer + sha256[i]->buffLen, in[i],
+                    left[i]);
+            sha256[i]->buffLen += left[i];
+        }
+    }
+
+    return 0;
+}
+#endif /* __aarch64__ */
+
+int wc_Sha256MultiUpdate(wc_Sha256** sha256, const byte** data,
+                         const word32* len, int n)
+{
+    int ret = 0;
+    int i;
+
+    if (sha256 == NULL || data == NULL || len == NULL || n < 0) {
+        return BAD_FUNC_ARG;
+    }
+    for (i = 0; i < n; i++) {
+        if (sha256[i] == NULL || (data[i] == NULL && len[i] > 0))
+            return BAD_FUNC_ARG;
+        if (sha256[i]->buffLen >= WC_SHA256_BLOCK_SIZE)
+            return BUFFER_E;
+    }
+
+#ifdef __aarch64__
+    for (i = 0; ret == 0 && i < n; i += WC_SHA256_MULTI_LANES) {
+        ret = Sha256MultiUpdate(sha256 + i, data + i, len + i,
+                                min(n - i, WC_SHA256_MULTI_LANES));
+    }
+#else
+    for (i = 0; ret == 0 && i < n; i++) {
+        ret = Sha256Update(sha256[i], data[i], len[i]);
+    }
+#endif
+
+    return ret;
+}
+
+int wc_Sha256MultiFinal(wc_Sha256** sha256, byte** hash, int n)
+{
+    int ret = 0;
+    int i;
+#ifdef __aarch64__
+    int g, j, cnt;
+    word32 hi, lo;
+    wc_Sha256* lane[WC_SHA256_MULTI_LANES];
+    byte* out[WC_SHA256_MULTI_LANES];
+    const byte* pad[WC_SHA256_MULTI_LANES];
+    word32 padLen[WC_SHA256_MULTI_LANES];
+    byte padBuf[WC_SHA256_MULTI_LANES][2 * WC_SHA256_BLOCK_SIZE];
+#endif
+
+    if (sha256 == NULL || hash == NULL || n < 0) {
+        return BAD_FUNC_ARG;
+    }
+    for (i = 0; i < n; i++) {
+        if (sha256[i] == NULL || hash[i] == NULL)
+            return BAD_FUNC_ARG;
+    }
+
+#ifdef __aarch64__
+    for (g = 0; ret == 0 && g < n; g += WC_SHA256_MULTI_LANES) {
+        cnt = 0;
+        for (i = g; i < n && i < g + WC_SHA256_MULTI_LANES; i++) {
+            wc_Sha256* s = sha256[i];
+            if (s->buffLen >= WC_SHA256_BLOCK_SIZE)
+                return BUFFER_E;
+
+            /* 0x80, zeros and the big endian bit length, ending on a block
+             * boundary */
+            AddLength(s, s->buffLen);
+            padLen[cnt] = ((s->buffLen < WC_SHA256_PAD_SIZE) ?
+                WC_SHA256_PAD_SIZE : WC_SHA256_PAD_SIZE +
+                WC_SHA256_BLOCK_SIZE) - s->buffLen + 2 * sizeof(word32);
+            hi = (s->loLen >> (8 * sizeof(s->loLen) - 3)) + (s->hiLen << 3);
+            lo = s->loLen << 3;
+            XMEMSET(padBuf[cnt], 0, padLen[cnt]);
+            padBuf[cnt][0] = 0x80;
+            for (j = 0; j < 4; j++) {
+                padBuf[cnt][padLen[cnt] - 8 + j] = (byte)(hi >> (24 - 8*j));
+                padBuf[cnt][padLen[cnt] - 4 + j] = (byte)(lo >> (24 - 8*j));
+            }
+            pad[cnt] = padBuf[cnt];
+            lane[cnt] = s;
+            out[cnt++] = hash[i];
+        }
+
+        ret = Sha256MultiUpdate(lane, pad, padLen, cnt);
+        for (i = 0; ret == 0 && i < cnt; i++) {
+        #if defined(LITTLE_ENDIAN_ORDER)
+            ByteReverseWords(lane[i]->digest, lane[i]->digest,
+                             WC_SHA256_DIGEST_SIZE);
+        #endif
+            XMEMCPY(out[i], lane[i]->digest, WC_SHA256_DIGEST_SIZE);
+            ret = InitSha256(lane[i]);  /* reset state */
+        }
+    }
+#else
+    for (i = 0; ret == 0 && i < n; i++) {
+        ret = wc_Sha256Final(sha256[i], hash[i]);
+    }
+#endif
+
+    return ret;
+}
+#endif /* WOLFSSL_SHA256_MULTI */
+
 #endif /* !NO_SHA256 */
 
 
@@ -44,13 +44,153 @@
     #include <wolfcrypt/src/misc.c>
 #endif
 
-#include "xparameters.h"
+#ifndef WOLFSSL_XILINX_CRYPT_MODEL
+    #include "xparameters.h"
+#endif
 
 enum {
     AEAD_NONCE_SZ       = 12,
     AES_GCM_AUTH_SZ     = 16, /* AES-GCM Auth Tag length    */
 };
 
+/* Largest amount of data given to the CSU DMA in one update. Must be a
+ * multiple of AES_BLOCK_SIZE. */
+#ifndef WOLFSSL_XILINX_AES_CHUNK_SZ
+    #define WOLFSSL_XILINX_AES_CHUNK_SZ (16 * 1024)
+#endif
+#if (WOLFSSL_XILINX_AES_CHUNK_SZ % 16) != 0
+    #error WOLFSSL_XILINX_AES_CHUNK_SZ must be a multiple of AES_BLOCK_SIZE
+#endif
+
+
+static word64 XilGcmLoad64(const byte* in)
+{
+    return ((word64)in[0] << 56) | ((word64)in[1] << 48) |
+           ((word64)in[2] << 40) | ((word64)in[3] << 32) |
+           ((word64)in[4] << 24) | ((word64)in[5] << 16) |
+           ((word64)in[6] <<  8) |  (word64)in[7];
+}
+
+static void XilGcmStore64(byte* out, word64 in)
+{
+    int i;
+    for (i = 7; i >= 0; i--) {
+        out[i] = (byte)in;
+        in >>= 8;
+    }
+}
+
+/* GF(2^128) multiply X = X * Y, constant time */
+static void XilGcmMul(byte* X, const byte* Y)
+{
+    word64 z0 = 0, z1 = 0;
+    word64 v0 = XilGcmLoad64(X);
+    word64 v1 = XilGcmLoad64(X + 8);
+    word64 y, mask;
+    int i, j;
+
+    for (i = 0; i < 2; i++) {
+        y = XilGcmLoad64(Y + 8 * i);
+        for (j = 0; j < 64; j++) {
+            mask = (word64)0 - (y >> 63);
+            z0 ^= v0 & mask;
+            z1 ^= v1 & mask;
+            mask = (word64)0 - (v1 & 1);
+            v1 = (v1 >> 1) | (v0 << 63);
+            v0 = (v0 >> 1) ^ (W64LIT(0xE100000000000000) & mask);
+            y <<= 1;
+        }
+    }
+    XilGcmStore64(X, z0);
+    XilGcmStore64(X + 8, z1);
+}
+
+/* The CSU engine has no AAD input, its tag only covers the ciphertext. GHASH
+ * is linear so the AAD contribution is added to the hardware tag afterwards
+ * instead of hashing the ciphertext again in software:
+ *
+ *   T = T_hw ^ (X_A * H^n ^ L_A) * H
+ *
+ * X_A is the GHASH state after the AAD blocks, n the number of ciphertext
+ * blocks and L_A the length block with only the AAD bit length set. Cost is
+ * the AAD blocks plus about 2*log2(n) multiplies.
+ *
+ * delta [out] value to XOR with the hardware tag (or an expected tag)
+ */
+static void XilGcmAadDelta(Aes* aes, const byte* authIn, word32 authInSz,
+    word32 sz, byte* delta)
+{
+    byte   hn[AES_BLOCK_SIZE];
+    byte   scratch[AES_BLOCK_SIZE];
+    word32 n = (sz + AES_BLOCK_SIZE - 1) / AES_BLOCK_SIZE;
+    word32 bit, i, len;
+
+    /* X_A */
+    XMEMSET(delta, 0, AES_BLOCK_SIZE);
+    for (i = 0; i < authInSz; i += len) {
+        len = min(authInSz - i, AES_BLOCK_SIZE);
+        XMEMSET(scratch, 0, AES_BLOCK_SIZE);
+        XMEMCPY(scratch, authIn + i, len);
+        xorbuf(delta, scratch, AES_BLOCK_SIZE);
+        XilGcmMul(delta, aes->H);
+    }
+
+    /* H^n by square and multiply, n is at least 1 */
+    XMEMCPY(hn, aes->H, AES_BLOCK_SIZE);
+    for (bit = 31; bit > 0 && ((n >> bit) & 1) == 0; bit--);
+    while (bit-- > 0) {
+        XMEMCPY(scratch, hn, AES_BLOCK_SIZE);
+        XilGcmMul(hn, scratch);
+        if ((n >> bit) & 1)
+            XilGcmMul(hn, aes->H);
+    }
+    XilGcmMul(delta, hn);
+
+    /* L_A */
+    XMEMSET(scratch, 0, AES_BLOCK_SIZE);
+    XilGcmStore64(scratch, (word64)authInSz * 8);
+    xorbuf(delta, scratch, AES_BLOCK_SIZE);
+    XilGcmMul(delta, aes->H);
+
+    ForceZero(hn, sizeof(hn));
+}
+
+/* Tag for an empty message (GMAC), the engine needs at least one block so
+ * this is done in software */
+static void XilGcmSoftTag(Aes* aes, const byte* iv, const byte* authIn,
+    word32 authInSz, byte* tag)
+{
+    byte scratch[AES_BLOCK_SIZE];
+    byte initalCounter[AES_BLOCK_SIZE];
+
+    XMEMSET(initalCounter, 0, AES_BLOCK_SIZE);
+    XMEMCPY(initalCounter, iv, AEAD_NONCE_SZ);
+    initalCounter[AES_BLOCK_SIZE - 1] = 1;
+    GHASH(aes, authIn, authInSz, NULL, 0, tag, AES_GCM_AUTH_SZ);
+    wc_AesEncryptDirect(aes, scratch, initalCounter);
+    xorbuf(tag, scratch, AES_GCM_AUTH_SZ);
+}
+
+/* Output staging buffer, kept with the key and reused between calls */
+static int XilGcmGetBuffer(Aes* aes, word32 sz)
+{
+    if (aes->xilBuf != NULL && aes->xilBufSz >= sz)
+        return 0;
+
+    if (aes->xilBuf != NULL) {
+        ForceZero(aes->xilBuf, aes->xilBufSz);
+        XFREE(aes->xilBuf, aes->heap, DYNAMIC_TYPE_TMP_BUFFER);
+    }
+    aes->xilBuf = (byte*)XMALLOC(sz, aes->heap, DYNAMIC_TYPE_TMP_BUFFER);
+    if (aes->xilBuf == NULL) {
+        aes->xilBufSz = 0;
+        return MEMORY_E;
+    }
+    aes->xilBufSz = sz;
+
+    return 0;
+}
+
 
 int  wc_AesGcmSetKey_ex(Aes* aes, const byte* key, word32 len, word32 kup)
 {
@@ -86,18 +226,24 @@ int  wc_AesGcmSetKey_ex(Aes* aes, const byte* key, word32 len, word32 kup)
 
 
 
+/* When the tag directly follows the output (as in a TLS record) the CSU
+ * engine writes ciphertext and tag in place. Otherwise the output is staged
+ * in a buffer kept with the key. Large input is given to the DMA in chunks of
+ * WOLFSSL_XILINX_AES_CHUNK_SZ. */
 int  wc_AesGcmEncrypt(Aes* aes, byte* out,
                                    const byte* in, word32 sz,
                                    const byte* iv, word32 ivSz,
                                    byte* authTag, word32 authTagSz,
                                    const byte* authIn, word32 authInSz)
 {
-    byte* tmp;
-    byte scratch[AES_BLOCK_SIZE];
-    byte initalCounter[AES_BLOCK_SIZE];
-
-    if ((in == NULL && sz > 0) || iv == NULL || authTag == NULL ||
-            authTagSz > AES_GCM_AUTH_SZ) {
+    int    ret;
+    byte*  dst;
+    word32 idx, len;
+    byte   delta[AES_BLOCK_SIZE];
+
+    if (aes == NULL || (in == NULL && sz > 0) || (out == NULL && sz > 0) ||
+            iv == NULL || authTag == NULL || authTagSz > AES_GCM_AUTH_SZ ||
+            (authIn == NULL && authInSz > 0)) {
         return BAD_FUNC_ARG;
     }
 
@@ -106,57 +252,80 @@ int  wc_AesGcmEncrypt(Aes* aes, byte* out,
         return BAD_FUNC_ARG;
     }
 
-    /* API expects that output is size of input + 16 byte tag. A temporary
-     * buffer is created to keep AES encrypt from writing over the end of
-     * out buffer. */
-    if (in != NULL) {
-        if (aes->keylen != 32) {
-            WOLFSSL_MSG("Expecting 256 bit AES key");
-            return BAD_FUNC_ARG;
-        }
+    if (aes->keylen != 32) {
+        WOLFSSL_MSG("Expecting 256 bit AES key");
+        return BAD_FUNC_ARG;
+    }
 
-        tmp = (byte*)XMALLOC(sz + AES_GCM_AUTH_SZ, aes->heap,
-            DYNAMIC_TYPE_TMP_BUFFER);
-        if (tmp == NULL) {
-            return MEMORY_E;
-        }
+    if (sz == 0) {
+        XilGcmSoftTag(aes, iv, authIn, authInSz, delta);
+        XMEMCPY(authTag, delta, authTagSz);
+        return 0;
+    }
 
-        XSecure_AesInitialize(&(aes->xilAes), &(aes->dma), aes->kup, (word32*)iv,
-            aes->key_init);
-        XSecure_AesEncryptData(&(aes->xilAes), tmp, in, sz);
-        XMEMCPY(out, tmp, sz);
-        XMEMCPY(authTag, tmp + sz, authTagSz);
-        XFREE(tmp, aes->heap, DYNAMIC_TYPE_TMP_BUFFER);
+    if (authTag == out + sz && authTagSz == AES_GCM_AUTH_SZ) {
+        dst = out;
+    }
+    else {
+        ret = XilGcmGetBuffer(aes, sz + AES_GCM_AUTH_SZ);
+        if (ret != 0)
+            return ret;
+        dst = aes->xilBuf;
     }
 
+    /* the CSU AES engine is shared */
+    ret = wolfSSL_CryptHwMutexLock();
+    if (ret != 0)
+        return ret;
+    if (XSecure_AesInitialize(&(aes->xilAes), &(aes->dma), aes->kup,
+                (word32*)iv, aes->key_init) != XST_SUCCESS ||
+            XSecure_AesEncryptInit(&(aes->xilAes), dst, sz) != XST_SUCCESS) {
+        WOLFSSL_MSG("Failed to start AES-GCM encrypt");
+        ret = WC_HW_E;
+    }
+    for (idx = 0; idx < sz && ret == 0; idx += len) {
+        len = min(sz - idx, WOLFSSL_XILINX_AES_CHUNK_SZ);
+        if (XSecure_AesEncryptUpdate(&(aes->xilAes), in + idx, len) !=
+                XST_SUCCESS) {
+            WOLFSSL_MSG("AES-GCM encrypt update failed");
+            ret = WC_HW_E;
+        }
+    }
+    wolfSSL_CryptHwMutexUnLock();
+    if (ret != 0)
+        return ret;
+
     /* handle completing tag with any additional data */
-    if (authIn != NULL) {
-        /* @TODO avoid hashing out again since Xilinx call already does */
-        XMEMSET(initalCounter, 0, AES_BLOCK_SIZE);
-        XMEMCPY(initalCounter, iv, ivSz);
-        initalCounter[AES_BLOCK_SIZE - 1] = 1;
-        GHASH(aes, authIn, authInSz, out, sz, authTag, authTagSz);
-        wc_AesEncryptDirect(aes, scratch, initalCounter);
-        xorbuf(authTag, scratch, authTagSz);
+    if (authInSz > 0) {
+        XilGcmAadDelta(aes, authIn, authInSz, sz, delta);
+        xorbuf(dst + sz, delta, AES_GCM_AUTH_SZ);
+    }
+
+    if (dst != out) {
+        XMEMCPY(out, dst, sz);
+        XMEMCPY(authTag, dst + sz, authTagSz);
     }
 
     return 0;
 }
 
 
+/* Data is decrypted straight into out. With additional data the expected tag
+ * is adjusted to what the engine computes over the ciphertext alone, so the
+ * engine still performs the only tag check. */
 int  wc_AesGcmDecrypt(Aes* aes, byte* out,
                                    const byte* in, word32 sz,
                                    const byte* iv, word32 ivSz,
                                    const byte* authTag, word32 authTagSz,
                                    const byte* authIn, word32 authInSz)
 {
-    byte* tag;
-    byte buf[AES_GCM_AUTH_SZ];
-    byte scratch[AES_BLOCK_SIZE];
-    byte initalCounter[AES_BLOCK_SIZE];
+    int    ret = XST_SUCCESS;
+    word32 idx, len;
+    byte   tag[AES_GCM_AUTH_SZ];
 
-    if (in == NULL || iv == NULL || authTag == NULL ||
-            authTagSz < AES_GCM_AUTH_SZ) {
+    if (aes == NULL || (in == NULL && sz > 0) || (out == NULL && sz > 0) ||
+            iv == NULL || authTag == NULL || authTagSz < AES_GCM_AUTH_SZ ||
+            (authIn == NULL && authInSz > 0)) {
         return BAD_FUNC_ARG;
     }
 
@@ -165,37 +334,46 @@ int  wc_AesGcmDecrypt(Aes* aes, byte* out,
         return BAD_FUNC_ARG;
     }
 
-    /* account for additional data */
-    if (authIn != NULL && authInSz > 0) {
-        XMEMSET(initalCounter, 0, AES_BLOCK_SIZE);
-        XMEMCPY(initalCounter, iv, ivSz);
-        initalCounter[AES_BLOCK_SIZE - 1] = 1;
-        tag = buf;
-        GHASH(aes, NULL, 0, in, sz, tag, AES_GCM_AUTH_SZ);
-        wc_AesEncryptDirect(aes, scratch, initalCounter);
-        xorbuf(tag, scratch, AES_GCM_AUTH_SZ);
+    if (sz == 0) {
+        XilGcmSoftTag(aes, iv, authIn, authInSz, tag);
+        if (ConstantCompare(authTag, tag, AES_GCM_AUTH_SZ) != 0)
+            return AES_GCM_AUTH_E;
+        return 0;
     }
-    else {
-        tag = authTag;
+
+    /* account for additional data */
+    XMEMCPY(tag, authTag, AES_GCM_AUTH_SZ);
+    if (authInSz > 0) {
+        byte delta[AES_BLOCK_SIZE];
+        XilGcmAadDelta(aes, authIn, authInSz, sz, delta);
+        xorbuf(tag, delta, AES_GCM_AUTH_SZ);
     }
 
-    /* calls to hardened crypto */
-    XSecure_AesInitialize(&(aes->xilAes), &(aes->dma), aes->kup,
-                (word32*)iv, aes->key_init);
-    XSecure_AesDecryptData(&(aes->xilAes), out, in, sz, tag);
+    /* calls to hardened crypto, the CSU AES engine is shared */
+    if (wolfSSL_CryptHwMutexLock() != 0)
+        return BAD_MUTEX_E;
+    if (XSecure_AesInitialize(&(aes->xilAes), &(aes->dma), aes->kup,
+                (word32*)iv, aes->key_init) != XST_SUCCESS ||
+            XSecure_AesDecryptInit(&(aes->xilAes), out, sz, tag) !=
+                XST_SUCCESS) {
+        ret = WC_HW_E;
+    }
+    for (idx = 0; idx < sz && ret == XST_SUCCESS; idx += len) {
+        len = min(sz - idx, WOLFSSL_XILINX_AES_CHUNK_SZ);
+        ret = XSecure_AesDecryptUpdate(&(aes->xilAes), (byte*)in + idx, len);
+    }
+    wolfSSL_CryptHwMutexUnLock();
 
-    /* account for additional data */
-    if (authIn != NULL && authInSz > 0) {
-        GHASH(aes, authIn, authInSz, in, sz, tag, AES_GCM_AUTH_SZ);
-        wc_AesEncryptDirect(aes, scratch, initalCounter);
-        xorbuf(tag, scratch, AES_GCM_AUTH_SZ);
-        if (ConstantCompare(authTag, tag, authTagSz) != 0) {
-            return AES_GCM_AUTH_E;
-        }
+    if (ret == XSECURE_CSU_AES_GCM_TAG_MISMATCH) {
+        ForceZero(out, sz);
+        return AES_GCM_AUTH_E;
+    }
+    if (ret != XST_SUCCESS) {
+        WOLFSSL_MSG("AES-GCM decrypt update failed");
+        return WC_HW_E;
     }
 
     return 0;
-
 }
 #endif /* HAVE_AESGCM */
 
@@ -0,0 +1,413 @@
+/* xil-model.c
+ *
+ * Copyright (C) 2006-2020 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+
+#ifdef HAVE_CONFIG_H
+    #include <config.h>
+#endif
+
+#include <wolfssl/wolfcrypt/settings.h>
+
+#if defined(WOLFSSL_XILINX_CRYPT) && defined(WOLFSSL_XILINX_CRYPT_MODEL)
+
+/* Host software model of the xilsecure CSU calls used by xil-aesgcm.c and
+ * xil-sha3.c. The AES model follows the streaming semantics of the hardware:
+ * the destination is set by the Init call, each Update continues at the next
+ * output position and the 16 byte GCM tag is written directly after the last
+ * output byte. The SHA3 model holds a single Keccak state per instance just
+ * as the engine does, so it can not be copied or saved. */
+
+#include <wolfssl/wolfcrypt/port/xilinx/xil-model.h>
+#include <wolfssl/wolfcrypt/aes.h>
+
+#ifdef NO_INLINE
+    #include <wolfssl/wolfcrypt/misc.h>
+#else
+    #define WOLFSSL_MISC_INCLUDED
+    #include <wolfcrypt/src/misc.c>
+#endif
+
+#define XIL_MODEL_BLOCK_SZ 16
+
+static XCsuDma_Config xilModelDmaConfig = { 0, 0xFFC80000UL };
+
+
+XCsuDma_Config* XCsuDma_LookupConfig(u16 DeviceId)
+{
+    if (DeviceId != 0)
+        return NULL;
+    return &xilModelDmaConfig;
+}
+
+s32 XCsuDma_CfgInitialize(XCsuDma* InstancePtr, XCsuDma_Config* CfgPtr,
+    UINTPTR EffectiveAddr)
+{
+    if (InstancePtr == NULL || CfgPtr == NULL)
+        return XST_FAILURE;
+    InstancePtr->Config = *CfgPtr;
+    InstancePtr->Config.BaseAddress = EffectiveAddr;
+    InstancePtr->IsReady = 1;
+    return XST_SUCCESS;
+}
+
+
+/* GF(2^128) multiply X = X * Y as used by GHASH */
+static void XilModel_GfMul(u8* X, const u8* Y)
+{
+    u8 Z[XIL_MODEL_BLOCK_SZ];
+    u8 V[XIL_MODEL_BLOCK_SZ];
+    int i, j, k;
+
+    XMEMSET(Z, 0, sizeof(Z));
+    XMEMCPY(V, X, sizeof(V));
+    for (i = 0; i < XIL_MODEL_BLOCK_SZ; i++) {
+        u8 y = Y[i];
+        for (j = 0; j < 8; j++) {
+            u8 lsb = V[XIL_MODEL_BLOCK_SZ - 1] & 0x01;
+            if (y & 0x80)
+                xorbuf(Z, V, XIL_MODEL_BLOCK_SZ);
+            for (k = XIL_MODEL_BLOCK_SZ - 1; k > 0; k--)
+                V[k] = (u8)((V[k] >> 1) | (V[k-1] << 7));
+            V[0] >>= 1;
+            if (lsb)
+                V[0] ^= 0xE1;
+            y <<= 1;
+        }
+    }
+    XMEMCPY(X, Z, sizeof(Z));
+}
+
+static int XilModel_SetKey(XSecure_Aes* InstancePtr, Aes* aes)
+{
+    if (InstancePtr->KeySel != XSECURE_CSU_AES_KEY_SRC_KUP ||
+            InstancePtr->Key == NULL) {
+        return XST_FAILURE; /* device keys are not modeled */
+    }
+    if (wc_AesInit(aes, NULL, INVALID_DEVID) != 0)
+        return XST_FAILURE;
+    if (wc_AesSetKey(aes, (const byte*)InstancePtr->Key, 32, NULL,
+            AES_ENCRYPTION) != 0) {
+        wc_AesFree(aes);
+        return XST_FAILURE;
+    }
+    return XST_SUCCESS;
+}
+
+static s32 XilModel_Start(XSecure_Aes* InstancePtr, u8* Dst, u32 Size,
+    u8* Tag)
+{
+    Aes aes;
+    u8  zero[XIL_MODEL_BLOCK_SZ];
+
+    if (InstancePtr == NULL || InstancePtr->Iv == NULL || Dst == NULL)
+        return XST_FAILURE;
+    if (XilModel_SetKey(InstancePtr, &aes) != XST_SUCCESS)
+        return XST_FAILURE;
+
+    InstancePtr->Destination = Dst;
+    InstancePtr->GcmTag = Tag;
+    InstancePtr->SizeofData = Size;
+    InstancePtr->Done = 0;
+
+    XMEMSET(zero, 0, sizeof(zero));
+    wc_AesEncryptDirect(&aes, InstancePtr->H, zero);
+
+    XMEMCPY(InstancePtr->Ctr, InstancePtr->Iv, 12);
+    InstancePtr->Ctr[12] = 0;
+    InstancePtr->Ctr[13] = 0;
+    InstancePtr->Ctr[14] = 0;
+    InstancePtr->Ctr[15] = 1;
+    wc_AesEncryptDirect(&aes, InstancePtr->Ej0, InstancePtr->Ctr);
+    XMEMSET(InstancePtr->Ghash, 0, sizeof(InstancePtr->Ghash));
+    wc_AesFree(&aes);
+
+    return XST_SUCCESS;
+}
+
+/* CTR + GHASH over one Update call, enc selects which side is hashed */
+static s32 XilModel_Update(XSecure_Aes* InstancePtr, const u8* Data, u32 Size,
+    int enc)
+{
+    Aes aes;
+    u8  ks[XIL_MODEL_BLOCK_SZ];
+    u8  blk[XIL_MODEL_BLOCK_SZ];
+    u8* out;
+    u32 i, n;
+    int k;
+
+    if (InstancePtr == NULL || (Data == NULL && Size > 0) ||
+            InstancePtr->Done + Size > InstancePtr->SizeofData) {
+        return XST_FAILURE;
+    }
+    /* only the last chunk may end on a partial block */
+    if ((Size % XIL_MODEL_BLOCK_SZ) != 0 &&
+            InstancePtr->Done + Size != InstancePtr->SizeofData) {
+        return XST_FAILURE;
+    }
+    if (XilModel_SetKey(InstancePtr, &aes) != XST_SUCCESS)
+        return XST_FAILURE;
+
+    out = InstancePtr->Destination + InstancePtr->Done;
+    for (i = 0; i < Size; i += n) {
+        n = Size - i;
+        if (n > XIL_MODEL_BLOCK_SZ)
+            n = XIL_MODEL_BLOCK_SZ;
+
+        for (k = XIL_MODEL_BLOCK_SZ - 1; k >= 12; k--) {
+            if (++InstancePtr->Ctr[k] != 0)
+                break;
+        }
+        wc_AesEncryptDirect(&aes, ks, InstancePtr->Ctr);
+
+        /* hash ciphertext before writing so in place decrypt works */
+        XMEMSET(blk, 0, sizeof(blk));
+        XMEMCPY(blk, Data + i, n);
+        if (!enc) {
+            xorbuf(InstancePtr->Ghash, blk, XIL_MODEL_BLOCK_SZ);
+            XilModel_GfMul(InstancePtr->Ghash, InstancePtr->H);
+        }
+        xorbuf(blk, ks, n);
+        XMEMCPY(out + i, blk, n);
+        if (enc) {
+            XMEMSET(blk + n, 0, XIL_MODEL_BLOCK_SZ - n);
+            xorbuf(InstancePtr->Ghash, blk, XIL_MODEL_BLOCK_SZ);
+            XilModel_GfMul(InstancePtr->Ghash, InstancePtr->H);
+        }
+    }
+    InstancePtr->Done += Size;
+    wc_AesFree(&aes);
+
+    if (InstancePtr->Done == InstancePtr->SizeofData) {
+        /* length block, the engine has no AAD so only the C length is set */
+        word64 bits = (word64)InstancePtr->SizeofData * 8;
+        XMEMSET(blk, 0, sizeof(blk));
+        for (k = 0; k < 8; k++)
+            blk[15 - k] = (u8)(bits >> (8 * k));
+        xorbuf(InstancePtr->Ghash, blk, XIL_MODEL_BLOCK_SZ);
+        XilModel_GfMul(InstancePtr->Ghash, InstancePtr->H);
+        xorbuf(InstancePtr->Ghash, InstancePtr->Ej0, XIL_MODEL_BLOCK_SZ);
+
+        if (enc) {
+            XMEMCPY(InstancePtr->Destination + InstancePtr->SizeofData,
+                InstancePtr->Ghash, XSECURE_SECURE_GCM_TAG_SIZE);
+        }
+        else if (InstancePtr->GcmTag == NULL ||
+                ConstantCompare(InstancePtr->Ghash, InstancePtr->GcmTag,
+                    XSECURE_SECURE_GCM_TAG_SIZE) != 0) {
+            return XSECURE_CSU_AES_GCM_TAG_MISMATCH;
+        }
+    }
+
+    return XST_SUCCESS;
+}
+
+
+s32 XSecure_AesInitialize(XSecure_Aes* InstancePtr, XCsuDma* CsuDmaPtr,
+    u32 KeySel, u32* Iv, u32* Key)
+{
+    if (InstancePtr == NULL || CsuDmaPtr == NULL || !CsuDmaPtr->IsReady)
+        return XST_FAILURE;
+
+    XMEMSET(InstancePtr, 0, sizeof(XSecure_Aes));
+    InstancePtr->CsuDmaPtr = CsuDmaPtr;
+    InstancePtr->KeySel = KeySel;
+    InstancePtr->Iv = Iv;
+    InstancePtr->Key = Key;
+
+    return XST_SUCCESS;
+}
+
+s32 XSecure_AesEncryptInit(XSecure_Aes* InstancePtr, u8* EncData, u32 Size)
+{
+    return XilModel_Start(InstancePtr, EncData, Size, NULL);
+}
+
+s32 XSecure_AesEncryptUpdate(XSecure_Aes* InstancePtr, const u8* Data,
+    u32 Size)
+{
+    return XilModel_Update(InstancePtr, Data, Size, 1);
+}
+
+s32 XSecure_AesEncryptData(XSecure_Aes* InstancePtr, u8* Dst, const u8* Src,
+    u32 Len)
+{
+    s32 ret = XSecure_AesEncryptInit(InstancePtr, Dst, Len);
+    if (ret == XST_SUCCESS)
+        ret = XSecure_AesEncryptUpdate(InstancePtr, Src, Len);
+    return ret;
+}
+
+s32 XSecure_AesDecryptInit(XSecure_Aes* InstancePtr, u8* DecData, u32 Size,
+    u8* GcmTagAddr)
+{
+    return XilModel_Start(InstancePtr, DecData, Size, GcmTagAddr);
+}
+
+s32 XSecure_AesDecryptUpdate(XSecure_Aes* InstancePtr, u8* EncData, u32 Size)
+{
+    return XilModel_Update(InstancePtr, EncData, Size, 0);
+}
+
+s32 XSecure_AesDecryptData(XSecure_Aes* InstancePtr, u8* Dst, const u8* Src,
+    u32 Len, u8* Tag)
+{
+    s32 ret = XSecure_AesDecryptInit(InstancePtr, Dst, Len, Tag);
+    if (ret == XST_SUCCESS)
+        ret = XSecure_AesDecryptUpdate(InstancePtr, (u8*)Src, Len);
+    return ret;
+}
+
+
+#ifdef WOLFSSL_SHA3
+
+#define XIL_MODEL_SHA3_RATE   104   /* (1600 - 2 * 384) / 8 */
+#define XIL_MODEL_SHA3_LEN    48
+
+static void XilModel_Keccak(word64* s)
+{
+    static const word64 rc[24] = {
+        W64LIT(0x0000000000000001), W64LIT(0x0000000000008082),
+        W64LIT(0x800000000000808a), W64LIT(0x8000000080008000),
+        W64LIT(0x000000000000808b), W64LIT(0x0000000080000001),
+        W64LIT(0x8000000080008081), W64LIT(0x8000000000008009),
+        W64LIT(0x000000000000008a), W64LIT(0x0000000000000088),
+        W64LIT(0x0000000080008009), W64LIT(0x000000008000000a),
+        W64LIT(0x000000008000808b), W64LIT(0x800000000000008b),
+        W64LIT(0x8000000000008089), W64LIT(0x8000000000008003),
+        W64LIT(0x8000000000008002), W64LIT(0x8000000000000080),
+        W64LIT(0x000000000000800a), W64LIT(0x800000008000000a),
+        W64LIT(0x8000000080008081), W64LIT(0x8000000000008080),
+        W64LIT(0x0000000080000001), W64LIT(0x8000000080008008)
+    };
+    static const byte rotc[24] = {
+        1, 3, 6, 10, 15, 21, 28, 36, 45, 55, 2, 14,
+        27, 41, 56, 8, 25, 43, 62, 18, 39, 61, 20, 44
+    };
+    static const byte piln[24] = {
+        10, 7, 11, 17, 18, 3, 5, 16, 8, 21, 24, 4,
+        15, 23, 19, 13, 12, 2, 20, 14, 22, 9, 6, 1
+    };
+    word64 bc[5], t;
+    int i, j, r;
+
+    for (r = 0; r < 24; r++) {
+        /* theta */
+        for (i = 0; i < 5; i++)
+            bc[i] = s[i] ^ s[i + 5] ^ s[i + 10] ^ s[i + 15] ^ s[i + 20];
+        for (i = 0; i < 5; i++) {
+            t = bc[(i + 4) % 5] ^ rotlFixed64(bc[(i + 1) % 5], 1);
+            for (j = 0; j < 25; j += 5)
+                s[j + i] ^= t;
+        }
+        /* rho and pi */
+        t = s[1];
+        for (i = 0; i < 24; i++) {
+            j = piln[i];
+            bc[0] = s[j];
+            s[j] = rotlFixed64(t, rotc[i]);
+            t = bc[0];
+        }
+        /* chi */
+        for (j = 0; j < 25; j += 5) {
+            for (i = 0; i < 5; i++)
+                bc[i] = s[j + i];
+            for (i = 0; i < 5; i++)
+                s[j + i] ^= (~bc[(i + 1) % 5]) & bc[(i + 2) % 5];
+        }
+        /* iota */
+        s[0] ^= rc[r];
+    }
+}
+
+static void XilModel_Sha3Absorb(XSecure_Sha3* InstancePtr, const u8* block)
+{
+    int i;
+    for (i = 0; i < XIL_MODEL_SHA3_RATE; i++)
+        InstancePtr->State[i / 8] ^= (word64)block[i] << (8 * (i % 8));
+    XilModel_Keccak(InstancePtr->State);
+}
+
+s32 XSecure_Sha3Initialize(XSecure_Sha3* InstancePtr, XCsuDma* CsuDmaPtr)
+{
+    if (InstancePtr == NULL || CsuDmaPtr == NULL || !CsuDmaPtr->IsReady)
+        return XST_FAILURE;
+    XMEMSET(InstancePtr, 0, sizeof(XSecure_Sha3));
+    InstancePtr->CsuDmaPtr = CsuDmaPtr;
+    return XST_SUCCESS;
+}
+
+void XSecure_Sha3Start(XSecure_Sha3* InstancePtr)
+{
+    XMEMSET(InstancePtr->State, 0, sizeof(InstancePtr->State));
+    InstancePtr->PartialLen = 0;
+    InstancePtr->Started = 1;
+}
+
+u32 XSecure_Sha3Update(XSecure_Sha3* InstancePtr, const u8* Data,
+    const u32 Size)
+{
+    u32 i = 0, n;
+
+    if (InstancePtr == NULL || !InstancePtr->Started ||
+            (Data == NULL && Size > 0)) {
+        return XST_FAILURE;
+    }
+
+    while (i < Size) {
+        n = min(Size - i, XIL_MODEL_SHA3_RATE - InstancePtr->PartialLen);
+        XMEMCPY(InstancePtr->Partial + InstancePtr->PartialLen, Data + i, n);
+        InstancePtr->PartialLen += n;
+        i += n;
+        if (InstancePtr->PartialLen == XIL_MODEL_SHA3_RATE) {
+            XilModel_Sha3Absorb(InstancePtr, InstancePtr->Partial);
+            InstancePtr->PartialLen = 0;
+        }
+    }
+
+    return XST_SUCCESS;
+}
+
+void XSecure_Sha3_ReadHash(XSecure_Sha3* InstancePtr, u8* Hash)
+{
+    int i;
+    for (i = 0; i < XIL_MODEL_SHA3_LEN; i++)
+        Hash[i] = (u8)(InstancePtr->State[i / 8] >> (8 * (i % 8)));
+}
+
+u32 XSecure_Sha3Finish(XSecure_Sha3* InstancePtr, u8* Hash)
+{
+    if (InstancePtr == NULL || !InstancePtr->Started || Hash == NULL)
+        return XST_FAILURE;
+
+    XMEMSET(InstancePtr->Partial + InstancePtr->PartialLen, 0,
+        XIL_MODEL_SHA3_RATE - InstancePtr->PartialLen);
+    InstancePtr->Partial[InstancePtr->PartialLen] ^= 0x06;
+    InstancePtr->Partial[XIL_MODEL_SHA3_RATE - 1] ^= 0x80;
+    XilModel_Sha3Absorb(InstancePtr, InstancePtr->Partial);
+    XSecure_Sha3_ReadHash(InstancePtr, Hash);
+    InstancePtr->Started = 0;
+
+    return XST_SUCCESS;
+}
+
+#endif /* WOLFSSL_SHA3 */
+
+#endif /* WOLFSSL_XILINX_CRYPT && WOLFSSL_XILINX_CRYPT_MODEL */
@@ -38,6 +38,206 @@
     #error sizes of SHA3 other than 384 are not supported
 #endif
 
+#ifdef NO_INLINE
+    #include <wolfssl/wolfcrypt/misc.h>
+#else
+    #define WOLFSSL_MISC_INCLUDED
+    #include <wolfcrypt/src/misc.c>
+#endif
+
+/* Largest message kept in a context. Contexts under this size can be copied
+ * and share the engine. Must be at least WOLFSSL_XILINX_SHA3_BUF_MIN. */
+#ifndef WOLFSSL_XILINX_SHA3_BUF_MAX
+    #define WOLFSSL_XILINX_SHA3_BUF_MAX (16 * 1024)
+#endif
+/* first allocation of the message buffer, doubled as needed */
+#ifndef WOLFSSL_XILINX_SHA3_BUF_MIN
+    #define WOLFSSL_XILINX_SHA3_BUF_MIN 256
+#endif
+
+/* values of wc_Sha3.streaming */
+#define SHA3_XIL_STREAM_HW 1 /* owns the engine */
+#define SHA3_XIL_STREAM_SW 2 /* engine was held, hashing in software */
+
+/* context streaming to the engine, only it may use the engine until Final.
+ * Protected by the crypto hardware mutex. */
+static wc_Sha3* xilSha3Owner = NULL;
+
+
+/* Lock the engine for one operation
+ *
+ * avail [out] 1 when sha may use the engine, 0 when a streaming context
+ *       owns it (mutex is still held)
+ */
+static int Sha3Xil_Lock(wc_Sha3* sha, int* avail)
+{
+    int ret = wolfSSL_CryptHwMutexLock();
+    if (ret != 0) {
+        return ret;
+    }
+    *avail = (xilSha3Owner == NULL || xilSha3Owner == sha);
+    if (!*avail) {
+        WOLFSSL_MSG("SHA3 engine is in use by a streaming hash, software");
+    }
+    return 0;
+}
+
+static void Sha3Xil_FreeMsg(wc_Sha3* sha)
+{
+    if (sha->msg != NULL) {
+        ForceZero(sha->msg, sha->msgMax);
+        XFREE(sha->msg, sha->heap, DYNAMIC_TYPE_TMP_BUFFER);
+    }
+    sha->msg = NULL;
+    sha->msgSz = 0;
+    sha->msgMax = 0;
+}
+
+/* Append data to the buffered message, caller checks the size limit */
+static int Sha3Xil_Buffer(wc_Sha3* sha, const byte* data, word32 len)
+{
+    if (sha->msgSz + len > sha->msgMax) {
+        byte*  tmp;
+        word32 sz = (sha->msgMax == 0) ? WOLFSSL_XILINX_SHA3_BUF_MIN :
+                                         sha->msgMax;
+        while (sz < sha->msgSz + len)
+            sz *= 2;
+        if (sz > WOLFSSL_XILINX_SHA3_BUF_MAX)
+            sz = WOLFSSL_XILINX_SHA3_BUF_MAX;
+
+        tmp = (byte*)XMALLOC(sz, sha->heap, DYNAMIC_TYPE_TMP_BUFFER);
+        if (tmp == NULL) {
+            return MEMORY_E;
+        }
+        if (sha->msg != NULL) {
+            XMEMCPY(tmp, sha->msg, sha->msgSz);
+            ForceZero(sha->msg, sha->msgMax);
+            XFREE(sha->msg, sha->heap, DYNAMIC_TYPE_TMP_BUFFER);
+        }
+        sha->msg = tmp;
+        sha->msgMax = sz;
+    }
+    XMEMCPY(sha->msg + sha->msgSz, data, len);
+    sha->msgSz += len;
+
+    return 0;
+}
+
+/* Hash the buffered message, context is unchanged. Uses software when a
+ * streaming context holds the engine. */
+static int Sha3Xil_HashMsg(wc_Sha3* sha, byte* out)
+{
+    int avail;
+    int ret = Sha3Xil_Lock(sha, &avail);
+    if (ret != 0) {
+        return ret;
+    }
+
+    if (avail) {
+        XSecure_Sha3Initialize(&(sha->hw), &(sha->dma));
+        XSecure_Sha3Start(&(sha->hw));
+        if (sha->msgSz > 0) {
+            XSecure_Sha3Update(&(sha->hw), sha->msg, sha->msgSz);
+        }
+        XSecure_Sha3Finish(&(sha->hw), out);
+    }
+    wolfSSL_CryptHwMutexUnLock();
+
+    if (!avail) {
+        wc_Sha3Sw sw;
+
+        ret = wc_Sha3Sw_Init(&sw);
+        if (ret == 0 && sha->msgSz > 0) {
+            ret = wc_Sha3Sw_Update(&sw, sha->msg, sha->msgSz);
+        }
+        if (ret == 0) {
+            ret = wc_Sha3Sw_Final(&sw, out);
+        }
+        ForceZero(&sw, sizeof(sw));
+    }
+
+    return ret;
+}
+
+/* Feed the engine keeping all but the last update a multiple of 4 bytes,
+ * engine must be owned by sha */
+static void Sha3Xil_Feed(wc_Sha3* sha, const byte* data, word32 len)
+{
+    word32 n;
+
+    if (sha->tailSz > 0) {
+        n = min(len, sizeof(sha->tail) - sha->tailSz);
+        XMEMCPY(sha->tail + sha->tailSz, data, n);
+        sha->tailSz += n;
+        data += n;
+        len -= n;
+        if (sha->tailSz < sizeof(sha->tail)) {
+            return;
+        }
+        XSecure_Sha3Update(&(sha->hw), sha->tail, sha->tailSz);
+        sha->tailSz = 0;
+    }
+
+    n = len & ~(word32)(sizeof(sha->tail) - 1);
+    if (n > 0) {
+        XSecure_Sha3Update(&(sha->hw), (byte*)data, n);
+    }
+    sha->tailSz = len - n;
+    XMEMCPY(sha->tail, data + n, sha->tailSz);
+}
+
+/* Message no longer fits the buffer: take the engine and stream to it, or
+ * stream in software when another context holds the engine */
+static int Sha3Xil_StartStream(wc_Sha3* sha)
+{
+    int avail;
+    int ret = Sha3Xil_Lock(sha, &avail);
+    if (ret != 0) {
+        return ret;
+    }
+
+    sha->tailSz = 0;
+    if (avail) {
+        xilSha3Owner = sha;
+        sha->streaming = SHA3_XIL_STREAM_HW;
+        XSecure_Sha3Initialize(&(sha->hw), &(sha->dma));
+        XSecure_Sha3Start(&(sha->hw));
+        if (sha->msgSz > 0) {
+            Sha3Xil_Feed(sha, sha->msg, sha->msgSz);
+        }
+    }
+    wolfSSL_CryptHwMutexUnLock();
+
+    if (!avail) {
+        ret = wc_Sha3Sw_Init(&(sha->sw));
+        if (ret == 0 && sha->msgSz > 0) {
+            ret = wc_Sha3Sw_Update(&(sha->sw), sha->msg, sha->msgSz);
+        }
+        if (ret != 0) {
+            return ret;
+        }
+        sha->streaming = SHA3_XIL_STREAM_SW;
+    }
+
+    Sha3Xil_FreeMsg(sha);
+
+    return 0;
+}
+
+static void Sha3Xil_Reset(wc_Sha3* sha)
+{
+    if (sha->msg != NULL) {
+        ForceZero(sha->msg, sha->msgSz);
+    }
+    sha->msgSz = 0; /* buffer is kept for the next message */
+    sha->tailSz = 0;
+    if (sha->streaming == SHA3_XIL_STREAM_SW) {
+        ForceZero(&(sha->sw), sizeof(sha->sw));
+    }
+    sha->streaming = 0;
+}
+
+
 /* Initialize hardware for SHA3 operations
  *
  * sha   SHA3 structure to initialize
@@ -48,7 +248,6 @@ int wc_InitSha3_384(wc_Sha3* sha, void* heap, int devId)
 {
     XCsuDma_Config* con;
 
-    (void)heap;
     (void)devId;
 
     if (sha == NULL) {
@@ -67,8 +266,12 @@ int wc_InitSha3_384(wc_Sha3* sha, void* heap, int devId)
         return BAD_STATE_E;
     }
 
-    XSecure_Sha3Initialize(&(sha->hw), &(sha->dma));
-    XSecure_Sha3Start(&(sha->hw));
+    sha->heap = heap;
+    sha->msg = NULL;
+    sha->msgSz = 0;
+    sha->msgMax = 0;
+    sha->tailSz = 0;
+    sha->streaming = 0;
 
     return 0;
 }
@@ -82,12 +285,36 @@ int wc_InitSha3_384(wc_Sha3* sha, void* heap, int devId)
  */
 int wc_Sha3_384_Update(wc_Sha3* sha, const byte* data, word32 len)
 {
+    int ret;
+
     if (sha == NULL ||  (data == NULL && len > 0)) {
         return BAD_FUNC_ARG;
     }
-    XSecure_Sha3Update(&(sha->hw), (byte*)data, len);
+    if (len == 0) {
+        return 0;
+    }
 
-    return 0;
+    if (!sha->streaming) {
+        if (len <= WOLFSSL_XILINX_SHA3_BUF_MAX - sha->msgSz) {
+            return Sha3Xil_Buffer(sha, data, len);
+        }
+        ret = Sha3Xil_StartStream(sha);
+        if (ret != 0) {
+            return ret;
+        }
+    }
+
+    if (sha->streaming == SHA3_XIL_STREAM_SW) {
+        return wc_Sha3Sw_Update(&(sha->sw), data, len);
+    }
+
+    ret = wolfSSL_CryptHwMutexLock();
+    if (ret == 0) {
+        Sha3Xil_Feed(sha, data, len);
+        wolfSSL_CryptHwMutexUnLock();
+    }
+
+    return ret;
 }
 
 
@@ -98,12 +325,40 @@ int wc_Sha3_384_Update(wc_Sha3* sha, const byte* data, word32 len)
  */
 int wc_Sha3_384_Final(wc_Sha3* sha, byte* out)
 {
+    int ret;
+
     if (sha == NULL || out == NULL) {
         return BAD_FUNC_ARG;
     }
-    XSecure_Sha3Finish(&(sha->hw), out);
 
-    return wc_InitSha3_384(sha, NULL, INVALID_DEVID);
+    if (sha->streaming == SHA3_XIL_STREAM_SW) {
+        ret = wc_Sha3Sw_Final(&(sha->sw), out);
+        if (ret != 0) {
+            return ret;
+        }
+    }
+    else if (sha->streaming) {
+        ret = wolfSSL_CryptHwMutexLock();
+        if (ret != 0) {
+            return ret;
+        }
+        if (sha->tailSz > 0) {
+            XSecure_Sha3Update(&(sha->hw), sha->tail, sha->tailSz);
+        }
+        XSecure_Sha3Finish(&(sha->hw), out);
+        xilSha3Owner = NULL;
+        wolfSSL_CryptHwMutexUnLock();
+    }
+    else {
+        ret = Sha3Xil_HashMsg(sha, out);
+        if (ret != 0) {
+            return ret;
+        }
+    }
+
+    Sha3Xil_Reset(sha);
+
+    return 0;
 }
 
 
@@ -113,8 +368,20 @@ int wc_Sha3_384_Final(wc_Sha3* sha, byte* out)
  */
 void wc_Sha3_384_Free(wc_Sha3* sha)
 {
-    (void)sha;
-    /* nothing to free yet */
+    if (sha == NULL) {
+        return;
+    }
+
+    if (sha->streaming == SHA3_XIL_STREAM_HW &&
+            wolfSSL_CryptHwMutexLock() == 0) {
+        /* abandoned stream, release the engine */
+        if (xilSha3Owner == sha) {
+            xilSha3Owner = NULL;
+        }
+        wolfSSL_CryptHwMutexUnLock();
+    }
+    Sha3Xil_FreeMsg(sha);
+    Sha3Xil_Reset(sha);
 }
 
 
@@ -125,22 +392,26 @@ void wc_Sha3_384_Free(wc_Sha3* sha)
  */
 int wc_Sha3_384_GetHash(wc_Sha3* sha, byte* out)
 {
-    wc_Sha3 s;
-
     if (sha == NULL || out == NULL) {
         return BAD_FUNC_ARG;
     }
-#ifdef WOLFSSL_XILINX_CRYPTO_OLD
-        if (wc_Sha3_384_Copy(sha, &s) != 0) {
-            WOLFSSL_MSG("Unable to copy SHA3 structure");
-            return MEMORY_E;
-        }
 
-        return wc_Sha3_384_Final(&s, out);
-#else
-    XSecure_Sha3_ReadHash(&(sha->hw), out);
-    return 0;
-#endif
+    if (sha->streaming == SHA3_XIL_STREAM_SW) {
+        wc_Sha3Sw sw;
+        int       ret;
+
+        XMEMCPY(&sw, &(sha->sw), sizeof(sw));
+        ret = wc_Sha3Sw_Final(&sw, out);
+        ForceZero(&sw, sizeof(sw));
+        return ret;
+    }
+    if (sha->streaming) {
+        WOLFSSL_MSG("SHA3 GetHash not supported above "
+                    "WOLFSSL_XILINX_SHA3_BUF_MAX");
+        return BAD_STATE_E;
+    }
+
+    return Sha3Xil_HashMsg(sha, out);
 }
 
 
@@ -151,17 +422,31 @@ int wc_Sha3_384_GetHash(wc_Sha3* sha, byte* out)
  */
 int wc_Sha3_384_Copy(wc_Sha3* src, wc_Sha3* dst)
 {
-    if (src == NULL || dst== NULL) {
+    if (src == NULL || dst == NULL) {
         return BAD_FUNC_ARG;
     }
 
-#ifdef WOLFSSL_XILINX_CRYPTO_OLD
-    XMEMCPY((byte*)dst, (byte*)src, sizeof(wc_Sha3));
+    if (src->streaming == SHA3_XIL_STREAM_HW) {
+        WOLFSSL_MSG("SHA3 Copy not supported above "
+                    "WOLFSSL_XILINX_SHA3_BUF_MAX");
+        return BAD_STATE_E;
+    }
+
+    XMEMCPY(dst, src, sizeof(wc_Sha3));
+    dst->msg = NULL;
+    dst->msgMax = 0;
+    if (src->msg != NULL) {
+        dst->msg = (byte*)XMALLOC(src->msgMax, src->heap,
+            DYNAMIC_TYPE_TMP_BUFFER);
+        if (dst->msg == NULL) {
+            dst->msgSz = 0;
+            return MEMORY_E;
+        }
+        XMEMCPY(dst->msg, src->msg, src->msgSz);
+        dst->msgMax = src->msgMax;
+    }
+
     return 0;
-#else
-    WOLFSSL_MSG("Copy of SHA3 struct not supported with this build");
-    return -1;
-#endif
 }
 
 #endif
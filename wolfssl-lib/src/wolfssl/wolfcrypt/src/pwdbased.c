@@ -171,6 +171,186 @@ int wc_PBKDF1(byte* output, const byte* passwd, int pLen, const byte* salt,
 
 #ifdef HAVE_PBKDF2
 
+#if defined(WOLFSSL_SHA256_MULTI) && !defined(NO_SHA256)
+/* PBKDF2-HMAC-SHA256 state for up to WC_SHA256_MULTI_LANES output blocks */
+typedef struct Pbkdf2Sha256 {
+    wc_Sha256 pad[3];   /* hashed ipad, opad and ipad || salt blocks */
+    wc_Sha256 inner[WC_SHA256_MULTI_LANES];
+    wc_Sha256 outer[WC_SHA256_MULTI_LANES];
+    byte      u[WC_SHA256_MULTI_LANES][WC_SHA256_DIGEST_SIZE];
+    byte      t[WC_SHA256_MULTI_LANES][WC_SHA256_DIGEST_SIZE];
+} Pbkdf2Sha256;
+
+static int Pbkdf2Sha256Load(Pbkdf2Sha256* p, int pad, wc_Sha256* lanes, int n)
+{
+    int ret = 0, l;
+
+    for (l = 0; ret == 0 && l < n; l++) {
+        wc_Sha256Free(&lanes[l]); /* release a cached W before overwriting */
+        ret = wc_Sha256Copy(&p->pad[pad], &lanes[l]);
+    }
+    return ret;
+}
+
+/* u = HMAC(msg) on n lanes, starting from the saved inPad and opad states */
+static int Pbkdf2Sha256Hmac(Pbkdf2Sha256* p, int inPad, const byte** msg,
+                            const word32* msgLen, int n)
+{
+    int ret, l;
+    wc_Sha256* in[WC_SHA256_MULTI_LANES];
+    wc_Sha256* out[WC_SHA256_MULTI_LANES];
+    byte* u[WC_SHA256_MULTI_LANES];
+    const byte* uc[WC_SHA256_MULTI_LANES];
+    word32 uLen[WC_SHA256_MULTI_LANES];
+
+    for (l = 0; l < n; l++) {
+        in[l] = &p->inner[l];
+        out[l] = &p->outer[l];
+        u[l] = p->u[l];
+        uc[l] = p->u[l];
+        uLen[l] = WC_SHA256_DIGEST_SIZE;
+    }
+
+    ret = Pbkdf2Sha256Load(p, inPad, p->inner, n);
+    if (ret == 0)
+        ret = Pbkdf2Sha256Load(p, 1, p->outer, n);
+    if (ret == 0)
+        ret = wc_Sha256MultiUpdate(in, msg, msgLen, n);
+    if (ret == 0)
+        ret = wc_Sha256MultiFinal(in, u, n);
+    if (ret == 0)
+        ret = wc_Sha256MultiUpdate(out, uc, uLen, n);
+    if (ret == 0)
+        ret = wc_Sha256MultiFinal(out, u, n);
+    return ret;
+}
+
+/* PBKDF2 with HMAC-SHA256. The HMAC pads are hashed once (two lanes) instead
+ * of in every iteration, and up to WC_SHA256_MULTI_LANES output blocks run
+ * their iterations in lockstep as multi-buffer lanes. */
+static int PBKDF2_Sha256Multi(byte* output, const byte* passwd, int pLen,
+    const byte* salt, int sLen, int iterations, int kLen, void* heap)
+{
+    int ret = 0;
+    int i, j, l, n;
+    word32 blk = 1;
+    byte key[WC_SHA256_BLOCK_SIZE];
+    byte ipad[WC_SHA256_BLOCK_SIZE];
+    byte opad[WC_SHA256_BLOCK_SIZE];
+    byte first[WC_SHA256_MULTI_LANES][4 + 64]; /* salt tail and INT(i) */
+    wc_Sha256* padP[3];
+    const byte* msg[WC_SHA256_MULTI_LANES];
+    word32 msgLen[WC_SHA256_MULTI_LANES];
+#ifdef WOLFSSL_SMALL_STACK
+    Pbkdf2Sha256* p;
+#else
+    Pbkdf2Sha256  p[1];
+#endif
+
+    (void)heap;
+
+#ifdef WOLFSSL_SMALL_STACK
+    p = (Pbkdf2Sha256*)XMALLOC(sizeof(Pbkdf2Sha256), heap,
+                               DYNAMIC_TYPE_TMP_BUFFER);
+    if (p == NULL)
+        return MEMORY_E;
+#endif
+
+    XMEMSET(key, 0, sizeof(key));
+    if (pLen > WC_SHA256_BLOCK_SIZE)
+        ret = wc_Sha256Hash(passwd, (word32)pLen, key);
+    else if (pLen > 0)
+        XMEMCPY(key, passwd, pLen);
+    for (i = 0; i < WC_SHA256_BLOCK_SIZE; i++) {
+        ipad[i] = key[i] ^ 0x36;
+        opad[i] = key[i] ^ 0x5c;
+    }
+
+    for (i = 0; i < 3; i++) {
+        if (ret == 0)
+            ret = wc_InitSha256_ex(&p->pad[i], heap, INVALID_DEVID);
+        padP[i] = &p->pad[i];
+    }
+    for (l = 0; l < WC_SHA256_MULTI_LANES; l++) {
+        if (ret == 0)
+            ret = wc_InitSha256_ex(&p->inner[l], heap, INVALID_DEVID);
+        if (ret == 0)
+            ret = wc_InitSha256_ex(&p->outer[l], heap, INVALID_DEVID);
+    }
+    if (ret == 0) {
+        msg[0] = ipad; msg[1] = opad;
+        msgLen[0] = msgLen[1] = WC_SHA256_BLOCK_SIZE;
+        ret = wc_Sha256MultiUpdate(padP, msg, msgLen, 2);
+    }
+
+    /* the salt is the same on every lane, hash its whole blocks once */
+    if (ret == 0)
+        ret = wc_Sha256Copy(&p->pad[0], &p->pad[2]);
+    if (ret == 0) {
+        word32 whole = (word32)sLen & ~(WC_SHA256_BLOCK_SIZE - 1);
+        ret = wc_Sha256Update(&p->pad[2], salt, whole);
+        salt += whole;
+        sLen -= (int)whole;
+    }
+
+    while (ret == 0 && kLen > 0) {
+        n = (kLen + WC_SHA256_DIGEST_SIZE - 1) / WC_SHA256_DIGEST_SIZE;
+        if (n > WC_SHA256_MULTI_LANES)
+            n = WC_SHA256_MULTI_LANES;
+
+        /* U1 = HMAC(P, S || INT(i)) */
+        for (l = 0; l < n; l++) {
+            XMEMCPY(first[l], salt, sLen);
+            for (j = 0; j < 4; j++)
+                first[l][sLen + j] = (byte)((blk + l) >> ((3 - j) * 8));
+            msg[l] = first[l];
+            msgLen[l] = (word32)sLen + 4;
+        }
+        ret = Pbkdf2Sha256Hmac(p, 2, msg, msgLen, n);
+        if (ret != 0)
+            break;
+        XMEMCPY(p->t, p->u, n * WC_SHA256_DIGEST_SIZE);
+
+        /* Uj = HMAC(P, Uj-1), T ^= Uj */
+        for (l = 0; l < n; l++) {
+            msg[l] = p->u[l];
+            msgLen[l] = WC_SHA256_DIGEST_SIZE;
+        }
+        for (i = 1; ret == 0 && i < iterations; i++) {
+            ret = Pbkdf2Sha256Hmac(p, 0, msg, msgLen, n);
+            for (l = 0; ret == 0 && l < n; l++)
+                xorbuf(p->t[l], p->u[l], WC_SHA256_DIGEST_SIZE);
+        }
+        if (ret != 0)
+            break;
+
+        for (l = 0; l < n && kLen > 0; l++) {
+            int currentLen = min(kLen, WC_SHA256_DIGEST_SIZE);
+            XMEMCPY(output, p->t[l], currentLen);
+            output += currentLen;
+            kLen   -= currentLen;
+        }
+        blk += (word32)n;
+    }
+
+    for (i = 0; i < 3; i++)
+        wc_Sha256Free(&p->pad[i]);
+    for (l = 0; l < WC_SHA256_MULTI_LANES; l++) {
+        wc_Sha256Free(&p->inner[l]);
+        wc_Sha256Free(&p->outer[l]);
+    }
+    ForceZero(key, sizeof(key));
+    ForceZero(ipad, sizeof(ipad));
+    ForceZero(opad, sizeof(opad));
+    ForceZero(p, sizeof(Pbkdf2Sha256));
+#ifdef WOLFSSL_SMALL_STACK
+    XFREE(p, heap, DYNAMIC_TYPE_TMP_BUFFER);
+#endif
+
+    return ret;
+}
+#endif /* WOLFSSL_SHA256_MULTI && !NO_SHA256 */
+
 int wc_PBKDF2_ex(byte* output, const byte* passwd, int pLen, const byte* salt,
            int sLen, int iterations, int kLen, int hashType, void* heap, int devId)
 {
@@ -198,6 +378,13 @@ int wc_PBKDF2_ex(byte* output, const byte* passwd, int pLen, const byte* salt,
     if (hLen < 0)
         return BAD_FUNC_ARG;
 
+#if defined(WOLFSSL_SHA256_MULTI) && !defined(NO_SHA256)
+    if (hashT == WC_HASH_TYPE_SHA256 && devId == INVALID_DEVID) {
+        return PBKDF2_Sha256Multi(output, passwd, pLen, salt, sLen, iterations,
+                                  kLen, heap);
+    }
+#endif
+
 #ifdef WOLFSSL_SMALL_STACK
     buffer = (byte*)XMALLOC(WC_MAX_DIGEST_SIZE, heap, DYNAMIC_TYPE_TMP_BUFFER);
     if (buffer == NULL)
@@ -1250,6 +1250,41 @@ static int InitSha256(wc_Sha256* sha256)
         return InitSha256(sha256);  /* reset state */
     }
 
+#ifdef WOLFSSL_SHA256_MULTI
+    /* Multi-buffer API, the lanes run one after the other here (the ARMv8
+     * port interleaves them) */
+    int wc_Sha256MultiUpdate(wc_Sha256** sha256, const byte** data,
+                             const word32* len, int n)
+    {
+        int ret = 0;
+        int i;
+
+        if (sha256 == NULL || data == NULL || len == NULL || n < 0) {
+            return BAD_FUNC_ARG;
+        }
+        for (i = 0; ret == 0 && i < n; i++) {
+            ret = wc_Sha256Update(sha256[i], data[i], len[i]);
+        }
+
+        return ret;
+    }
+
+    int wc_Sha256MultiFinal(wc_Sha256** sha256, byte** hash, int n)
+    {
+        int ret = 0;
+        int i;
+
+        if (sha256 == NULL || hash == NULL || n < 0) {
+            return BAD_FUNC_ARG;
+        }
+        for (i = 0; ret == 0 && i < n; i++) {
+            ret = wc_Sha256Final(sha256[i], hash[i]);
+        }
+
+        return ret;
+    }
+#endif /* WOLFSSL_SHA256_MULTI */
+
 #endif /* XTRANSFORM */
 
 #ifdef WOLFSSL_SHA224
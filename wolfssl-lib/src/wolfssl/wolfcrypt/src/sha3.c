@@ -26,8 +26,7 @@
 
 #include <wolfssl/wolfcrypt/settings.h>
 
-#if defined(WOLFSSL_SHA3) && !defined(WOLFSSL_XILINX_CRYPT) && \
-   !defined(WOLFSSL_AFALG_XILINX_SHA3)
+#if defined(WOLFSSL_SHA3) && !defined(WOLFSSL_AFALG_XILINX_SHA3)
 
 #if defined(HAVE_FIPS) && \
 	defined(HAVE_FIPS_VERSION) && (HAVE_FIPS_VERSION >= 2)
@@ -52,6 +51,14 @@
     #include <wolfcrypt/src/misc.c>
 #endif
 
+#ifdef WOLFSSL_XILINX_CRYPT
+    /* Only the Keccak code is built, as the software fallback of the CSU
+     * port (xil-sha3.c) */
+    #define SHA3_STATE wc_Sha3Sw
+#else
+    #define SHA3_STATE wc_Sha3
+#endif
+
 
 #ifdef WOLFSSL_SHA3_SMALL
 /* Rotate a 64-bit value left.
@@ -563,14 +570,15 @@ static word64 Load64BitBigEndian(const byte* a)
  * sha3   wc_Sha3 object holding state.
  * returns 0 on success.
  */
-static int InitSha3(wc_Sha3* sha3)
+static int InitSha3(SHA3_STATE* sha3)
 {
     int i;
 
     for (i = 0; i < 25; i++)
         sha3->s[i] = 0;
     sha3->i = 0;
-#if defined(WOLFSSL_HASH_FLAGS) || defined(WOLF_CRYPTO_CB)
+#if (defined(WOLFSSL_HASH_FLAGS) || defined(WOLF_CRYPTO_CB)) && \
+    !defined(WOLFSSL_XILINX_CRYPT)
     sha3->flags = 0;
 #endif
 
@@ -585,7 +593,8 @@ static int InitSha3(wc_Sha3* sha3)
  * p     Number of 64-bit numbers in a block of data to process.
  * returns 0 on success.
  */
-static int Sha3Update(wc_Sha3* sha3, const byte* data, word32 len, byte p)
+static int Sha3Update(SHA3_STATE* sha3, const byte* data, word32 len,
+    byte p)
 {
     byte i;
     byte l;
@@ -636,13 +645,14 @@ static int Sha3Update(wc_Sha3* sha3, const byte* data, word32 len, byte p)
  * len   Number of bytes in output.
  * returns 0 on success.
  */
-static int Sha3Final(wc_Sha3* sha3, byte padChar, byte* hash, byte p, byte l)
+static int Sha3Final(SHA3_STATE* sha3, byte padChar, byte* hash, byte p,
+    byte l)
 {
     byte i;
     byte *s8 = (byte *)sha3->s;
 
     sha3->t[p * 8 - 1]  = 0x00;
-#ifdef WOLFSSL_HASH_FLAGS
+#if defined(WOLFSSL_HASH_FLAGS) && !defined(WOLFSSL_XILINX_CRYPT)
     if (p == WC_SHA3_256_COUNT && sha3->flags & WC_HASH_SHA3_KECCAK256) {
         padChar = 0x01;
     }
@@ -663,6 +673,32 @@ static int Sha3Final(wc_Sha3* sha3, byte padChar, byte* hash, byte p, byte l)
     return 0;
 }
 
+#ifdef WOLFSSL_XILINX_CRYPT
+/* Software SHA3-384 for the CSU port, when the engine is streaming another
+ * context's message
+ *
+ * sha3  wc_Sha3Sw object holding state.
+ * returns 0 on success.
+ */
+int wc_Sha3Sw_Init(wc_Sha3Sw* sha3)
+{
+    return InitSha3(sha3);
+}
+
+int wc_Sha3Sw_Update(wc_Sha3Sw* sha3, const byte* data, word32 len)
+{
+    return Sha3Update(sha3, data, len, WC_SHA3_384_COUNT);
+}
+
+/* Writes the digest, the state must be initialized again before reuse */
+int wc_Sha3Sw_Final(wc_Sha3Sw* sha3, byte* hash)
+{
+    return Sha3Final(sha3, 0x06, hash, WC_SHA3_384_COUNT,
+                     WC_SHA3_384_DIGEST_SIZE);
+}
+
+#else
+
 /* Initialize the state for a SHA-3 hash operation.
  *
  * sha3   wc_Sha3 object holding state.
@@ -1223,4 +1259,6 @@ int wc_Shake256_Copy(wc_Shake* src, wc_Shake* dst)
 }
 #endif
 
+#endif /* !WOLFSSL_XILINX_CRYPT */
+
 #endif /* WOLFSSL_SHA3 */
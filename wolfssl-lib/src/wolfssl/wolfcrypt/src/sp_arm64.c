@@ -21225,7 +21225,7 @@ static void sp_256_proj_point_add_qz1_4(sp_point_256* r, const sp_point_256* p,
     }
 }
 
-#ifdef FP_ECC
+#if defined(FP_ECC) || defined(WOLFSSL_SP_HAVE_VERIFY_CACHE)
 /* Convert the projective point to affine.
  * Ordinates are in Montgomery form.
  *
@@ -21329,8 +21329,9 @@ static int sp_256_gen_stripe_table_4(const sp_point_256* a,
     return err;
 }
 
-#endif /* FP_ECC */
-#if defined(FP_ECC) || defined(WOLFSSL_SP_SMALL)
+#endif /* FP_ECC || WOLFSSL_SP_HAVE_VERIFY_CACHE */
+#if defined(FP_ECC) || defined(WOLFSSL_SP_SMALL) || \
+    defined(WOLFSSL_SP_HAVE_VERIFY_CACHE)
 #ifndef WC_NO_CACHE_RESISTANT
 /* Touch each possible entry that could be being copied.
  *
@@ -21473,7 +21474,7 @@ static int sp_256_ecc_mulmod_stripe_4(sp_point_256* r, const sp_point_256* g,
     return err;
 }
 
-#endif /* FP_ECC || WOLFSSL_SP_SMALL */
+#endif /* FP_ECC || WOLFSSL_SP_SMALL || WOLFSSL_SP_HAVE_VERIFY_CACHE */
 #ifdef FP_ECC
 #ifndef FP_ENTRIES
     #define FP_ENTRIES 16
@@ -21607,7 +21608,7 @@ static int sp_256_ecc_mulmod_4(sp_point_256* r, const sp_point_256* g, const sp_
 #else
 #if defined(FP_ECC) || defined(WOLFSSL_SP_SMALL)
 #endif /* FP_ECC || WOLFSSL_SP_SMALL */
-#ifdef FP_ECC
+#if defined(FP_ECC) || defined(WOLFSSL_SP_HAVE_VERIFY_CACHE)
 /* Generate the pre-computed table of points for the base point.
  *
  * a      The base point.
@@ -21689,8 +21690,9 @@ static int sp_256_gen_stripe_table_4(const sp_point_256* a,
     return err;
 }
 
-#endif /* FP_ECC */
-#if defined(FP_ECC) || defined(WOLFSSL_SP_SMALL)
+#endif /* FP_ECC || WOLFSSL_SP_HAVE_VERIFY_CACHE */
+#if defined(FP_ECC) || defined(WOLFSSL_SP_SMALL) || \
+    defined(WOLFSSL_SP_HAVE_VERIFY_CACHE)
 #ifndef WC_NO_CACHE_RESISTANT
 /* Touch each possible entry that could be being copied.
  *
@@ -21833,7 +21835,7 @@ static int sp_256_ecc_mulmod_stripe_4(sp_point_256* r, const sp_point_256* g,
     return err;
 }
 
-#endif /* FP_ECC || WOLFSSL_SP_SMALL */
+#endif /* FP_ECC || WOLFSSL_SP_SMALL || WOLFSSL_SP_HAVE_VERIFY_CACHE */
 #ifdef FP_ECC
 #ifndef FP_ENTRIES
     #define FP_ENTRIES 16
@@ -21965,6 +21967,209 @@ static int sp_256_ecc_mulmod_4(sp_point_256* r, const sp_point_256* g, const sp_
 }
 
 #endif /* !WC_NO_CACHE_RESISTANT */
+#ifdef WOLFSSL_SP_HAVE_VERIFY_CACHE
+/* Pre-computed tables of the public keys used to verify signatures.
+ * Entries are looked up by a hash of the point and the least recently used
+ * entry is replaced. A table is only generated the second time a key is seen
+ * so one-off keys don't evict the long-lived ones.
+ */
+typedef struct sp_verify_cache_256_t {
+    sp_table_entry_256 table[64];
+    sp_digit x[4];
+    sp_digit y[4];
+    word32 hash;
+    word32 lastUse;
+    int cnt;    /* 0 - empty, 1 - seen once, 2 - table generated */
+    int inUse;  /* multiplications using the table now */
+} sp_verify_cache_256_t;
+
+#define SP_VERIFY_CACHE_256_ENTRIES \
+    ((WOLFSSL_SP_VERIFY_CACHE_SZ / sizeof(sp_verify_cache_256_t)) > 0 ? \
+     (WOLFSSL_SP_VERIFY_CACHE_SZ / sizeof(sp_verify_cache_256_t)) : 1)
+
+static sp_verify_cache_256_t sp_verify_cache_256[SP_VERIFY_CACHE_256_ENTRIES];
+static word32 sp_verify_cache_256_clock = 0;
+static ecc_verify_cache_stats sp_verify_cache_256_stats;
+static volatile int initVerifyCacheMutex_256 = 0;
+static wolfSSL_Mutex sp_verify_cache_256_lock;
+
+static int sp_verify_cache_256_lock_get(void)
+{
+    if (initVerifyCacheMutex_256 == 0) {
+        if (wc_InitMutex(&sp_verify_cache_256_lock) != 0)
+            return BAD_MUTEX_E;
+        initVerifyCacheMutex_256 = 1;
+    }
+    if (wc_LockMutex(&sp_verify_cache_256_lock) != 0)
+        return BAD_MUTEX_E;
+    return MP_OKAY;
+}
+
+/* Hash of the point to find cache entries. */
+static word32 sp_256_point_hash_4(const sp_point_256* g)
+{
+    word32 h = 0;
+    int i;
+
+    for (i = 0; i < 4; i++) {
+        h = (h << 5) ^ (h >> 27) ^ (word32)g->x[i] ^ (word32)(g->x[i] >> 32);
+        h = (h << 5) ^ (h >> 27) ^ (word32)g->y[i] ^ (word32)(g->y[i] >> 32);
+    }
+
+    return h;
+}
+
+/* Find the cache entry for the point, adding it when not found.
+ * Must be called with the lock held.
+ *
+ * g      Point to find.
+ * tmp    Temporary data for generating a table.
+ * heap   Heap to use for allocation.
+ * returns the entry with a table or NULL when there is no table (yet).
+ */
+static sp_verify_cache_256_t* sp_verify_cache_256_find(const sp_point_256* g,
+        sp_digit* tmp, void* heap)
+{
+    sp_verify_cache_256_t* e = NULL;
+    word32 h = sp_256_point_hash_4(g);
+    int i;
+
+    for (i = 0; i < (int)SP_VERIFY_CACHE_256_ENTRIES; i++) {
+        sp_verify_cache_256_t* c = &sp_verify_cache_256[i];
+
+        if (c->cnt != 0 && c->hash == h &&
+                (sp_256_cmp_equal_4(g->x, c->x) &
+                 sp_256_cmp_equal_4(g->y, c->y))) {
+            e = c;
+            break;
+        }
+    }
+
+    if (e != NULL) {
+        e->lastUse = ++sp_verify_cache_256_clock;
+        if (e->cnt == 2) {
+            sp_verify_cache_256_stats.hits++;
+        }
+        else {
+            sp_verify_cache_256_stats.misses++;
+            if (sp_256_gen_stripe_table_4(g, e->table, tmp, heap) != MP_OKAY)
+                return NULL;
+            sp_verify_cache_256_stats.tables++;
+            e->cnt = 2;
+        }
+        e->inUse++;
+        return e;
+    }
+
+    /* Empty entry or least recently used one not being used. */
+    sp_verify_cache_256_stats.misses++;
+    for (i = 0; i < (int)SP_VERIFY_CACHE_256_ENTRIES; i++) {
+        sp_verify_cache_256_t* c = &sp_verify_cache_256[i];
+
+        if (c->cnt == 0) {
+            e = c;
+            break;
+        }
+        if (c->inUse == 0 && (e == NULL || c->lastUse < e->lastUse)) {
+            e = c;
+        }
+    }
+    if (e != NULL) {
+        if (e->cnt != 0)
+            sp_verify_cache_256_stats.evictions++;
+        XMEMCPY(e->x, g->x, sizeof(e->x));
+        XMEMCPY(e->y, g->y, sizeof(e->y));
+        e->hash = h;
+        e->lastUse = ++sp_verify_cache_256_clock;
+        e->cnt = 1;
+    }
+
+    return NULL;
+}
+
+/* Multiply the public key point by the scalar in verification, using the
+ * cached table of the key when there is one.
+ *
+ * r     Resulting point.
+ * g     Point to multiply.
+ * k     Scalar to multiply by.
+ * heap  Heap to use for allocation.
+ * returns MEMORY_E when memory allocation fails and MP_OKAY on success.
+ */
+static int sp_256_ecc_mulmod_verify_4(sp_point_256* r, const sp_point_256* g,
+        const sp_digit* k, void* heap)
+{
+    sp_digit tmp[2 * 4 * 5];
+    sp_verify_cache_256_t* e = NULL;
+    int err;
+
+    err = sp_verify_cache_256_lock_get();
+    if (err == MP_OKAY) {
+        e = sp_verify_cache_256_find(g, tmp, heap);
+        wc_UnLockMutex(&sp_verify_cache_256_lock);
+    }
+    if (e == NULL) {
+        /* Public values only - not constant time. */
+        return sp_256_ecc_mulmod_4(r, g, k, 0, 0, heap);
+    }
+
+    err = sp_256_ecc_mulmod_stripe_4(r, g, e->table, k, 0, 0, heap);
+
+    if (sp_verify_cache_256_lock_get() == MP_OKAY) {
+        e->inUse--;
+        wc_UnLockMutex(&sp_verify_cache_256_lock);
+    }
+
+    return err;
+}
+
+/* Get the verify cache counters.
+ *
+ * stats  Counters and size of the cache.
+ * reset  Zero the counters after getting them.
+ * returns BAD_MUTEX_E when locking fails and MP_OKAY otherwise.
+ */
+int sp_ecc_verify_cache_stats_256(ecc_verify_cache_stats* stats, int reset)
+{
+    int err = sp_verify_cache_256_lock_get();
+    int i;
+
+    if (err == MP_OKAY) {
+        if (stats != NULL) {
+            *stats = sp_verify_cache_256_stats;
+            stats->entries = 0;
+            for (i = 0; i < (int)SP_VERIFY_CACHE_256_ENTRIES; i++) {
+                if (sp_verify_cache_256[i].cnt == 2)
+                    stats->entries++;
+            }
+            stats->maxEntries = (word32)SP_VERIFY_CACHE_256_ENTRIES;
+            stats->bytes = (word32)sizeof(sp_verify_cache_256);
+        }
+        if (reset) {
+            XMEMSET(&sp_verify_cache_256_stats, 0,
+                    sizeof(sp_verify_cache_256_stats));
+        }
+        wc_UnLockMutex(&sp_verify_cache_256_lock);
+    }
+
+    return err;
+}
+
+/* Empty the verify cache. Tables in use are left for their users. */
+void sp_ecc_verify_cache_clear_256(void)
+{
+    int i;
+
+    if (sp_verify_cache_256_lock_get() == MP_OKAY) {
+        for (i = 0; i < (int)SP_VERIFY_CACHE_256_ENTRIES; i++) {
+            if (sp_verify_cache_256[i].inUse == 0)
+                sp_verify_cache_256[i].cnt = 0;
+        }
+        wc_UnLockMutex(&sp_verify_cache_256_lock);
+    }
+}
+#endif /* WOLFSSL_SP_HAVE_VERIFY_CACHE */
+
 /* Multiply the point by the scalar and return the result.
  * If map is true then convert result to affine coordinates.
  *
@@ -37436,7 +37641,11 @@ int sp_ecc_verify_256(const byte* hash, word32 hashLen, mp_int* pX,
             err = sp_256_ecc_mulmod_base_4(p1, u1, 0, 0, heap);
     }
     if (err == MP_OKAY) {
+#ifdef WOLFSSL_SP_HAVE_VERIFY_CACHE
+            err = sp_256_ecc_mulmod_verify_4(p2, p2, u2, heap);
+#else
             err = sp_256_ecc_mulmod_4(p2, p2, u2, 0, 0, heap);
+#endif
     }
 
     if (err == MP_OKAY) {
@@ -37503,6 +37712,206 @@ int sp_ecc_verify_256(const byte* hash, word32 hashLen, mp_int* pX,
 }
 #endif /* HAVE_ECC_VERIFY */
 
+#if defined(HAVE_ECC_VERIFY) && defined(WOLFSSL_SP_VERIFY_BATCH)
+/* Verify a batch of ECDSA signatures over P-256.
+ *
+ * The s values of all the signatures are inverted with one modular inversion
+ * (Montgomery's trick: 3(n-1) multiplications instead of n-1 inversions). The
+ * base point multiplications of all the signatures then run back to back,
+ * sharing the precomputed table while it is in cache, followed by the public
+ * key multiplications and the checks. A zero s is invalid and does not take
+ * part in the shared inversion.
+ *
+ * n        Number of signatures.
+ * hash     Hash of each message, truncated to the curve size.
+ * hashLen  Length of each hash.
+ * pX       X ordinate of each public key.
+ * pY       Y ordinate of each public key.
+ * pZ       Z ordinate of each public key.
+ * r        R value of each signature.
+ * sm       S value of each signature.
+ * res      Result of each signature, 1 when valid and 0 otherwise.
+ * heap     Heap to use for allocation.
+ * returns MEMORY_E when memory allocation fails and MP_OKAY otherwise.
+ */
+int sp_ecc_verify_256_batch(int n, const byte** hash, const word32* hashLen,
+    mp_int** pX, mp_int** pY, mp_int** pZ, mp_int** r, mp_int** sm, int* res,
+    void* heap)
+{
+    sp_digit* d = NULL;
+    sp_point_256* p1 = NULL;
+    sp_point_256* p2 = NULL;
+    sp_digit* u1;
+    sp_digit* u2;
+    sp_digit* s;
+    sp_digit* acc;
+    sp_digit* inv;
+    sp_digit* tmp;
+    sp_digit carry;
+    int64_t c;
+    word32 len;
+    int err = MP_OKAY;
+    int i, j;
+
+    if (n <= 0) {
+        return MP_OKAY;
+    }
+
+    d = (sp_digit*)XMALLOC(sizeof(sp_digit) * 2 * 4 * (4 * n + 6), heap,
+                                                              DYNAMIC_TYPE_ECC);
+    p1 = (sp_point_256*)XMALLOC(sizeof(sp_point_256) * (n + 1), heap,
+                                                              DYNAMIC_TYPE_ECC);
+    if (d == NULL || p1 == NULL) {
+        err = MEMORY_E;
+    }
+
+    if (err == MP_OKAY) {
+        u1  = d;
+        u2  = u1  + 2 * 4 * n;
+        s   = u2  + 2 * 4 * n;
+        acc = s   + 2 * 4 * n;
+        inv = acc + 2 * 4 * n;
+        tmp = inv + 2 * 4;
+        p2  = p1 + n;
+        XMEMSET(p1, 0, sizeof(sp_point_256) * (n + 1));
+
+        /* s in Montgomery form and the running products */
+        for (i = 0; err == MP_OKAY && i < n; i++) {
+            sp_digit* si = s + 2 * 4 * i;
+
+            sp_256_from_mp(si, 4, sm[i]);
+            sp_256_mul_4(si, si, p256_norm_order);
+            err = sp_256_mod_4(si, si, p256_order);
+            if (err != MP_OKAY) {
+                break;
+            }
+            sp_256_norm_4(si);
+            res[i] = !sp_256_iszero_4(si);
+            if (!res[i]) {
+                /* Montgomery form of 1 keeps the product invertible */
+                XMEMSET(si, 0, sizeof(sp_digit) * 2 * 4);
+                XMEMCPY(si, p256_norm_order, sizeof(p256_norm_order));
+            }
+            if (i == 0) {
+                XMEMCPY(acc, si, sizeof(sp_digit) * 2 * 4);
+            }
+            else {
+                sp_256_mont_mul_order_4(acc + 2 * 4 * i,
+                                       acc + 2 * 4 * (i - 1), si);
+            }
+        }
+    }
+    if (err == MP_OKAY) {
+        /* one inversion, then s[i]^-1 = inv(acc[n-1]) . acc[i-1] walking
+         * back through the products */
+        sp_256_mont_inv_order_4(inv, acc + 2 * 4 * (n - 1), tmp);
+        for (i = n - 1; i > 0; i--) {
+            sp_digit* si = s + 2 * 4 * i;
+
+            sp_256_mont_mul_order_4(tmp, inv, acc + 2 * 4 * (i - 1));
+            sp_256_mont_mul_order_4(inv, inv, si);
+            XMEMCPY(si, tmp, sizeof(sp_digit) * 2 * 4);
+        }
+        XMEMCPY(s, inv, sizeof(sp_digit) * 2 * 4);
+
+        for (i = 0; i < n; i++) {
+            len = hashLen[i];
+            if (len > 32U) {
+                len = 32U;
+            }
+            sp_256_from_bin(u1 + 2 * 4 * i, 4, hash[i], (int)len);
+            sp_256_from_mp(u2 + 2 * 4 * i, 4, r[i]);
+            sp_256_mont_mul_order_4(u1 + 2 * 4 * i, u1 + 2 * 4 * i,
+                                   s + 2 * 4 * i);
+            sp_256_mont_mul_order_4(u2 + 2 * 4 * i, u2 + 2 * 4 * i,
+                                   s + 2 * 4 * i);
+        }
+    }
+
+    /* u1.G for all the signatures */
+    for (i = 0; err == MP_OKAY && i < n; i++) {
+        if (res[i]) {
+            err = sp_256_ecc_mulmod_base_4(&p1[i], u1 + 2 * 4 * i, 0, 0,
+                                                                         heap);
+        }
+    }
+
+    for (i = 0; err == MP_OKAY && i < n; i++) {
+        sp_digit* v1 = u1 + 2 * 4 * i;
+        sp_digit* v2 = u2 + 2 * 4 * i;
+
+        if (!res[i]) {
+            continue;
+        }
+
+        sp_256_from_mp(p2->x, 4, pX[i]);
+        sp_256_from_mp(p2->y, 4, pY[i]);
+        sp_256_from_mp(p2->z, 4, pZ[i]);
+#ifdef WOLFSSL_SP_HAVE_VERIFY_CACHE
+        err = sp_256_ecc_mulmod_verify_4(p2, p2, v2, heap);
+#else
+        err = sp_256_ecc_mulmod_4(p2, p2, v2, 0, 0, heap);
+#endif
+        if (err != MP_OKAY) {
+            break;
+        }
+
+        sp_256_proj_point_add_4(&p1[i], &p1[i], p2, tmp);
+        if (sp_256_iszero_4(p1[i].z)) {
+            if (sp_256_iszero_4(p1[i].x) && sp_256_iszero_4(p1[i].y)) {
+                sp_256_proj_point_dbl_4(&p1[i], p2, tmp);
+            }
+            else {
+                /* Y ordinate is not used from here - don't set. */
+                for (j = 0; j < 4; j++) {
+                    p1[i].x[j] = 0;
+                }
+                XMEMCPY(p1[i].z, p256_norm_mod, sizeof(p256_norm_mod));
+            }
+        }
+
+        /* (r + n*order).z'.z' mod prime == (u1.G + u2.Q)->x' */
+        sp_256_from_mp(v2, 4, r[i]);
+        err = sp_256_mod_mul_norm_4(v2, v2, p256_mod);
+        if (err != MP_OKAY) {
+            break;
+        }
+        sp_256_mont_sqr_4(p1[i].z, p1[i].z, p256_mod, p256_mp_mod);
+        sp_256_mont_mul_4(v1, v2, p1[i].z, p256_mod, p256_mp_mod);
+        res[i] = (int)(sp_256_cmp_4(p1[i].x, v1) == 0);
+        if (res[i] == 0) {
+            sp_256_from_mp(v2, 4, r[i]);
+            carry = sp_256_add_4(v2, v2, p256_order);
+            if (carry == 0) {
+                sp_256_norm_4(v2);
+                c = sp_256_cmp_4(v2, p256_mod);
+                if (c < 0) {
+                    err = sp_256_mod_mul_norm_4(v2, v2, p256_mod);
+                    if (err == MP_OKAY) {
+                        sp_256_mont_mul_4(v1, v2, p1[i].z, p256_mod,
+                                                                  p256_mp_mod);
+                        res[i] = (int)(sp_256_cmp_4(p1[i].x, v1) == 0);
+                    }
+                }
+            }
+        }
+    }
+
+    if (err != MP_OKAY) {
+        for (i = 0; i < n; i++) {
+            res[i] = 0;
+        }
+    }
+
+    if (d != NULL)
+        XFREE(d, heap, DYNAMIC_TYPE_ECC);
+    if (p1 != NULL)
+        XFREE(p1, heap, DYNAMIC_TYPE_ECC);
+
+    return err;
+}
+#endif /* HAVE_ECC_VERIFY && WOLFSSL_SP_VERIFY_BATCH */
+
 #ifdef HAVE_ECC_CHECK_KEY
 /* Check that the x and y oridinates are a valid point on the curve.
  *
@@ -40788,7 +41197,7 @@ static void sp_384_proj_point_add_qz1_6(sp_point_384* r, const sp_point_384* p,
     }
 }
 
-#ifdef FP_ECC
+#if defined(FP_ECC) || defined(WOLFSSL_SP_HAVE_VERIFY_CACHE)
 /* Convert the projective point to affine.
  * Ordinates are in Montgomery form.
  *
@@ -40892,7 +41301,7 @@ static int sp_384_gen_stripe_table_6(const sp_point_384* a,
     return err;
 }
 
-#endif /* FP_ECC */
+#endif /* FP_ECC || WOLFSSL_SP_HAVE_VERIFY_CACHE */
 #ifndef WC_NO_CACHE_RESISTANT
 /* Touch each possible entry that could be being copied.
  *
@@ -41173,6 +41582,209 @@ static int sp_384_ecc_mulmod_6(sp_point_384* r, const sp_point_384* g, const sp_
 #endif
 }
 
+#ifdef WOLFSSL_SP_HAVE_VERIFY_CACHE
+/* Pre-computed tables of the public keys used to verify signatures.
+ * Entries are looked up by a hash of the point and the least recently used
+ * entry is replaced. A table is only generated the second time a key is seen
+ * so one-off keys don't evict the long-lived ones.
+ */
+typedef struct sp_verify_cache_384_t {
+    sp_table_entry_384 table[256];
+    sp_digit x[6];
+    sp_digit y[6];
+    word32 hash;
+    word32 lastUse;
+    int cnt;    /* 0 - empty, 1 - seen once, 2 - table generated */
+    int inUse;  /* multiplications using the table now */
+} sp_verify_cache_384_t;
+
+#define SP_VERIFY_CACHE_384_ENTRIES \
+    ((WOLFSSL_SP_VERIFY_CACHE_SZ / sizeof(sp_verify_cache_384_t)) > 0 ? \
+     (WOLFSSL_SP_VERIFY_CACHE_SZ / sizeof(sp_verify_cache_384_t)) : 1)
+
+static sp_verify_cache_384_t sp_verify_cache_384[SP_VERIFY_CACHE_384_ENTRIES];
+static word32 sp_verify_cache_384_clock = 0;
+static ecc_verify_cache_stats sp_verify_cache_384_stats;
+static volatile int initVerifyCacheMutex_384 = 0;
+static wolfSSL_Mutex sp_verify_cache_384_lock;
+
+static int sp_verify_cache_384_lock_get(void)
+{
+    if (initVerifyCacheMutex_384 == 0) {
+        if (wc_InitMutex(&sp_verify_cache_384_lock) != 0)
+            return BAD_MUTEX_E;
+        initVerifyCacheMutex_384 = 1;
+    }
+    if (wc_LockMutex(&sp_verify_cache_384_lock) != 0)
+        return BAD_MUTEX_E;
+    return MP_OKAY;
+}
+
+/* Hash of the point to find cache entries. */
+static word32 sp_384_point_hash_6(const sp_point_384* g)
+{
+    word32 h = 0;
+    int i;
+
+    for (i = 0; i < 6; i++) {
+        h = (h << 5) ^ (h >> 27) ^ (word32)g->x[i] ^ (word32)(g->x[i] >> 32);
+        h = (h << 5) ^ (h >> 27) ^ (word32)g->y[i] ^ (word32)(g->y[i] >> 32);
+    }
+
+    return h;
+}
+
+/* Find the cache entry for the point, adding it when not found.
+ * Must be called with the lock held.
+ *
+ * g      Point to find.
+ * tmp    Temporary data for generating a table.
+ * heap   Heap to use for allocation.
+ * returns the entry with a table or NULL when there is no table (yet).
+ */
+static sp_verify_cache_384_t* sp_verify_cache_384_find(const sp_point_384* g,
+        sp_digit* tmp, void* heap)
+{
+    sp_verify_cache_384_t* e = NULL;
+    word32 h = sp_384_point_hash_6(g);
+    int i;
+
+    for (i = 0; i < (int)SP_VERIFY_CACHE_384_ENTRIES; i++) {
+        sp_verify_cache_384_t* c = &sp_verify_cache_384[i];
+
+        if (c->cnt != 0 && c->hash == h &&
+                (sp_384_cmp_equal_6(g->x, c->x) &
+                 sp_384_cmp_equal_6(g->y, c->y))) {
+            e = c;
+            break;
+        }
+    }
+
+    if (e != NULL) {
+        e->lastUse = ++sp_verify_cache_384_clock;
+        if (e->cnt == 2) {
+            sp_verify_cache_384_stats.hits++;
+        }
+        else {
+            sp_verify_cache_384_stats.misses++;
+            if (sp_384_gen_stripe_table_6(g, e->table, tmp, heap) != MP_OKAY)
+                return NULL;
+            sp_verify_cache_384_stats.tables++;
+            e->cnt = 2;
+        }
+        e->inUse++;
+        return e;
+    }
+
+    /* Empty entry or least recently used one not being used. */
+    sp_verify_cache_384_stats.misses++;
+    for (i = 0; i < (int)SP_VERIFY_CACHE_384_ENTRIES; i++) {
+        sp_verify_cache_384_t* c = &sp_verify_cache_384[i];
+
+        if (c->cnt == 0) {
+            e = c;
+            break;
+        }
+        if (c->inUse == 0 && (e == NULL || c->lastUse < e->lastUse)) {
+            e = c;
+        }
+    }
+    if (e != NULL) {
+        if (e->cnt != 0)
+            sp_verify_cache_384_stats.evictions++;
+        XMEMCPY(e->x, g->x, sizeof(e->x));
+        XMEMCPY(e->y, g->y, sizeof(e->y));
+        e->hash = h;
+        e->lastUse = ++sp_verify_cache_384_clock;
+        e->cnt = 1;
+    }
+
+    return NULL;
+}
+
+/* Multiply the public key point by the scalar in verification, using the
+ * cached table of the key when there is one.
+ *
+ * r     Resulting point.
+ * g     Point to multiply.
+ * k     Scalar to multiply by.
+ * heap  Heap to use for allocation.
+ * returns MEMORY_E when memory allocation fails and MP_OKAY on success.
+ */
+static int sp_384_ecc_mulmod_verify_6(sp_point_384* r, const sp_point_384* g,
+        const sp_digit* k, void* heap)
+{
+    sp_digit tmp[2 * 6 * 7];
+    sp_verify_cache_384_t* e = NULL;
+    int err;
+
+    err = sp_verify_cache_384_lock_get();
+    if (err == MP_OKAY) {
+        e = sp_verify_cache_384_find(g, tmp, heap);
+        wc_UnLockMutex(&sp_verify_cache_384_lock);
+    }
+    if (e == NULL) {
+        /* Public values only - not constant time. */
+        return sp_384_ecc_mulmod_6(r, g, k, 0, 0, heap);
+    }
+
+    err = sp_384_ecc_mulmod_stripe_6(r, g, e->table, k, 0, 0, heap);
+
+    if (sp_verify_cache_384_lock_get() == MP_OKAY) {
+        e->inUse--;
+        wc_UnLockMutex(&sp_verify_cache_384_lock);
+    }
+
+    return err;
+}
+
+/* Get the verify cache counters.
+ *
+ * stats  Counters and size of the cache.
+ * reset  Zero the counters after getting them.
+ * returns BAD_MUTEX_E when locking fails and MP_OKAY otherwise.
+ */
+int sp_ecc_verify_cache_stats_384(ecc_verify_cache_stats* stats, int reset)
+{
+    int err = sp_verify_cache_384_lock_get();
+    int i;
+
+    if (err == MP_OKAY) {
+        if (stats != NULL) {
+            *stats = sp_verify_cache_384_stats;
+            stats->entries = 0;
+            for (i = 0; i < (int)SP_VERIFY_CACHE_384_ENTRIES; i++) {
+                if (sp_verify_cache_384[i].cnt == 2)
+                    stats->entries++;
+            }
+            stats->maxEntries = (word32)SP_VERIFY_CACHE_384_ENTRIES;
+            stats->bytes = (word32)sizeof(sp_verify_cache_384);
+        }
+        if (reset) {
+            XMEMSET(&sp_verify_cache_384_stats, 0,
+                    sizeof(sp_verify_cache_384_stats));
+        }
+        wc_UnLockMutex(&sp_verify_cache_384_lock);
+    }
+
+    return err;
+}
+
+/* Empty the verify cache. Tables in use are left for their users. */
+void sp_ecc_verify_cache_clear_384(void)
+{
+    int i;
+
+    if (sp_verify_cache_384_lock_get() == MP_OKAY) {
+        for (i = 0; i < (int)SP_VERIFY_CACHE_384_ENTRIES; i++) {
+            if (sp_verify_cache_384[i].inUse == 0)
+                sp_verify_cache_384[i].cnt = 0;
+        }
+        wc_UnLockMutex(&sp_verify_cache_384_lock);
+    }
+}
+#endif /* WOLFSSL_SP_HAVE_VERIFY_CACHE */
+
 /* Multiply the point by the scalar and return the result.
  * If map is true then convert result to affine coordinates.
  *
@@ -43881,7 +44493,11 @@ int sp_ecc_verify_384(const byte* hash, word32 hashLen, mp_int* pX,
             err = sp_384_ecc_mulmod_base_6(p1, u1, 0, 0, heap);
     }
     if (err == MP_OKAY) {
+#ifdef WOLFSSL_SP_HAVE_VERIFY_CACHE
+            err = sp_384_ecc_mulmod_verify_6(p2, p2, u2, heap);
+#else
             err = sp_384_ecc_mulmod_6(p2, p2, u2, 0, 0, heap);
+#endif
     }
 
     if (err == MP_OKAY) {
@@ -43950,6 +44566,206 @@ int sp_ecc_verify_384(const byte* hash, word32 hashLen, mp_int* pX,
 }
 #endif /* HAVE_ECC_VERIFY */
 
+#if defined(HAVE_ECC_VERIFY) && defined(WOLFSSL_SP_VERIFY_BATCH)
+/* Verify a batch of ECDSA signatures over P-384.
+ *
+ * The s values of all the signatures are inverted with one modular inversion
+ * (Montgomery's trick: 3(n-1) multiplications instead of n-1 inversions). The
+ * base point multiplications of all the signatures then run back to back,
+ * sharing the precomputed table while it is in cache, followed by the public
+ * key multiplications and the checks. A zero s is invalid and does not take
+ * part in the shared inversion.
+ *
+ * n        Number of signatures.
+ * hash     Hash of each message, truncated to the curve size.
+ * hashLen  Length of each hash.
+ * pX       X ordinate of each public key.
+ * pY       Y ordinate of each public key.
+ * pZ       Z ordinate of each public key.
+ * r        R value of each signature.
+ * sm       S value of each signature.
+ * res      Result of each signature, 1 when valid and 0 otherwise.
+ * heap     Heap to use for allocation.
+ * returns MEMORY_E when memory allocation fails and MP_OKAY otherwise.
+ */
+int sp_ecc_verify_384_batch(int n, const byte** hash, const word32* hashLen,
+    mp_int** pX, mp_int** pY, mp_int** pZ, mp_int** r, mp_int** sm, int* res,
+    void* heap)
+{
+    sp_digit* d = NULL;
+    sp_point_384* p1 = NULL;
+    sp_point_384* p2 = NULL;
+    sp_digit* u1;
+    sp_digit* u2;
+    sp_digit* s;
+    sp_digit* acc;
+    sp_digit* inv;
+    sp_digit* tmp;
+    sp_digit carry;
+    int64_t c;
+    word32 len;
+    int err = MP_OKAY;
+    int i, j;
+
+    if (n <= 0) {
+        return MP_OKAY;
+    }
+
+    d = (sp_digit*)XMALLOC(sizeof(sp_digit) * 2 * 6 * (4 * n + 6), heap,
+                                                              DYNAMIC_TYPE_ECC);
+    p1 = (sp_point_384*)XMALLOC(sizeof(sp_point_384) * (n + 1), heap,
+                                                              DYNAMIC_TYPE_ECC);
+    if (d == NULL || p1 == NULL) {
+        err = MEMORY_E;
+    }
+
+    if (err == MP_OKAY) {
+        u1  = d;
+        u2  = u1  + 2 * 6 * n;
+        s   = u2  + 2 * 6 * n;
+        acc = s   + 2 * 6 * n;
+        inv = acc + 2 * 6 * n;
+        tmp = inv + 2 * 6;
+        p2  = p1 + n;
+        XMEMSET(p1, 0, sizeof(sp_point_384) * (n + 1));
+
+        /* s in Montgomery form and the running products */
+        for (i = 0; err == MP_OKAY && i < n; i++) {
+            sp_digit* si = s + 2 * 6 * i;
+
+            sp_384_from_mp(si, 6, sm[i]);
+            sp_384_mul_6(si, si, p384_norm_order);
+            err = sp_384_mod_6(si, si, p384_order);
+            if (err != MP_OKAY) {
+                break;
+            }
+            sp_384_norm_6(si);
+            res[i] = !sp_384_iszero_6(si);
+            if (!res[i]) {
+                /* Montgomery form of 1 keeps the product invertible */
+                XMEMSET(si, 0, sizeof(sp_digit) * 2 * 6);
+                XMEMCPY(si, p384_norm_order, sizeof(p384_norm_order));
+            }
+            if (i == 0) {
+                XMEMCPY(acc, si, sizeof(sp_digit) * 2 * 6);
+            }
+            else {
+                sp_384_mont_mul_order_6(acc + 2 * 6 * i,
+                                       acc + 2 * 6 * (i - 1), si);
+            }
+        }
+    }
+    if (err == MP_OKAY) {
+        /* one inversion, then s[i]^-1 = inv(acc[n-1]) . acc[i-1] walking
+         * back through the products */
+        sp_384_mont_inv_order_6(inv, acc + 2 * 6 * (n - 1), tmp);
+        for (i = n - 1; i > 0; i--) {
+            sp_digit* si = s + 2 * 6 * i;
+
+            sp_384_mont_mul_order_6(tmp, inv, acc + 2 * 6 * (i - 1));
+            sp_384_mont_mul_order_6(inv, inv, si);
+            XMEMCPY(si, tmp, sizeof(sp_digit) * 2 * 6);
+        }
+        XMEMCPY(s, inv, sizeof(sp_digit) * 2 * 6);
+
+        for (i = 0; i < n; i++) {
+            len = hashLen[i];
+            if (len > 48U) {
+                len = 48U;
+            }
+            sp_384_from_bin(u1 + 2 * 6 * i, 6, hash[i], (int)len);
+            sp_384_from_mp(u2 + 2 * 6 * i, 6, r[i]);
+            sp_384_mont_mul_order_6(u1 + 2 * 6 * i, u1 + 2 * 6 * i,
+                                   s + 2 * 6 * i);
+            sp_384_mont_mul_order_6(u2 + 2 * 6 * i, u2 + 2 * 6 * i,
+                                   s + 2 * 6 * i);
+        }
+    }
+
+    /* u1.G for all the signatures */
+    for (i = 0; err == MP_OKAY && i < n; i++) {
+        if (res[i]) {
+            err = sp_384_ecc_mulmod_base_6(&p1[i], u1 + 2 * 6 * i, 0, 0,
+                                                                         heap);
+        }
+    }
+
+    for (i = 0; err == MP_OKAY && i < n; i++) {
+        sp_digit* v1 = u1 + 2 * 6 * i;
+        sp_digit* v2 = u2 + 2 * 6 * i;
+
+        if (!res[i]) {
+            continue;
+        }
+
+        sp_384_from_mp(p2->x, 6, pX[i]);
+        sp_384_from_mp(p2->y, 6, pY[i]);
+        sp_384_from_mp(p2->z, 6, pZ[i]);
+#ifdef WOLFSSL_SP_HAVE_VERIFY_CACHE
+        err = sp_384_ecc_mulmod_verify_6(p2, p2, v2, heap);
+#else
+        err = sp_384_ecc_mulmod_6(p2, p2, v2, 0, 0, heap);
+#endif
+        if (err != MP_OKAY) {
+            break;
+        }
+
+        sp_384_proj_point_add_6(&p1[i], &p1[i], p2, tmp);
+        if (sp_384_iszero_6(p1[i].z)) {
+            if (sp_384_iszero_6(p1[i].x) && sp_384_iszero_6(p1[i].y)) {
+                sp_384_proj_point_dbl_6(&p1[i], p2, tmp);
+            }
+            else {
+                /* Y ordinate is not used from here - don't set. */
+                for (j = 0; j < 6; j++) {
+                    p1[i].x[j] = 0;
+                }
+                XMEMCPY(p1[i].z, p384_norm_mod, sizeof(p384_norm_mod));
+            }
+        }
+
+        /* (r + n*order).z'.z' mod prime == (u1.G + u2.Q)->x' */
+        sp_384_from_mp(v2, 6, r[i]);
+        err = sp_384_mod_mul_norm_6(v2, v2, p384_mod);
+        if (err != MP_OKAY) {
+            break;
+        }
+        sp_384_mont_sqr_6(p1[i].z, p1[i].z, p384_mod, p384_mp_mod);
+        sp_384_mont_mul_6(v1, v2, p1[i].z, p384_mod, p384_mp_mod);
+        res[i] = (int)(sp_384_cmp_6(p1[i].x, v1) == 0);
+        if (res[i] == 0) {
+            sp_384_from_mp(v2, 6, r[i]);
+            carry = sp_384_add_6(v2, v2, p384_order);
+            if (carry == 0) {
+                sp_384_norm_6(v2);
+                c = sp_384_cmp_6(v2, p384_mod);
+                if (c < 0) {
+                    err = sp_384_mod_mul_norm_6(v2, v2, p384_mod);
+                    if (err == MP_OKAY) {
+                        sp_384_mont_mul_6(v1, v2, p1[i].z, p384_mod,
+                                                                  p384_mp_mod);
+                        res[i] = (int)(sp_384_cmp_6(p1[i].x, v1) == 0);
+                    }
+                }
+            }
+        }
+    }
+
+    if (err != MP_OKAY) {
+        for (i = 0; i < n; i++) {
+            res[i] = 0;
+        }
+    }
+
+    if (d != NULL)
+        XFREE(d, heap, DYNAMIC_TYPE_ECC);
+    if (p1 != NULL)
+        XFREE(p1, heap, DYNAMIC_TYPE_ECC);
+
+    return err;
+}
+#endif /* HAVE_ECC_VERIFY && WOLFSSL_SP_VERIFY_BATCH */
+
 #ifdef HAVE_ECC_CHECK_KEY
 /* Check that the x and y oridinates are a valid point on the curve.
  *
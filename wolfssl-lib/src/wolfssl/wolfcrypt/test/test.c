@@ -211,6 +211,24 @@
     #pragma warning(disable: 4996)
 #endif
 
+#if !defined(WOLFCRYPT_ONLY) && !defined(NO_CERTS) && \
+    (defined(WOLFSSL_CA_INDEX) || defined(WOLFSSL_CHAIN_CACHE) || \
+     defined(WOLFSSL_SEND_COALESCE) || defined(WOLFSSL_SESSION_CACHE_SHARDED) || \
+     defined(WOLFSSL_CRL_INDEX))
+    #include <wolfssl/ssl.h> /* certificate manager and TLS tests */
+    #include <wolfssl/error-ssl.h>
+  #if defined(WOLFSSL_CHAIN_CACHE) || defined(WOLFSSL_SEND_COALESCE)
+    #include <wolfssl/internal.h> /* chain cache entries, output buffer */
+  #endif
+#endif
+#if defined(WOLFSSL_STATIC_MEMORY) && !defined(WOLFCRYPT_ONLY) && \
+    !defined(NO_WOLFSSL_CLIENT) && !defined(WOLFSSL_NO_TLS12) && \
+    !defined(WOLFSSL_NO_MALLOC)
+    #include <wolfssl/ssl.h> /* handshake arena tests */
+    #include <wolfssl/internal.h> /* connection heap hint */
+    #define MEM_TEST_ARENA
+#endif
+
 #ifdef OPENSSL_EXTRA
   #ifndef WOLFCRYPT_ONLY
     #include <wolfssl/openssl/evp.h>
@@ -399,6 +417,36 @@ int  certext_test(void);
     defined(WOLFSSL_CERT_EXT) && defined(WOLFSSL_CERT_GEN)
 int decodedCertCache_test(void);
 #endif
+/* certificate manager tests make their ECC certs */
+#if !defined(WOLFCRYPT_ONLY) && !defined(NO_CERTS) && \
+    defined(WOLFSSL_CERT_GEN) && defined(WOLFSSL_CERT_EXT) && \
+    defined(HAVE_ECC) && defined(HAVE_ECC_SIGN) && !defined(NO_ECC256) && \
+    !defined(NO_ASN_TIME) && \
+    (defined(WOLFSSL_CA_INDEX) || defined(WOLFSSL_CHAIN_CACHE) || \
+     defined(WOLFSSL_SEND_COALESCE) || defined(WOLFSSL_SESSION_CACHE_SHARDED) || \
+     (defined(WOLFSSL_CRL_INDEX) && defined(HAVE_CRL)))
+    #define CM_TEST_CERTS
+#endif
+#if defined(WOLFSSL_CA_INDEX) && defined(CM_TEST_CERTS)
+int ca_index_test(void);
+#endif
+#if defined(WOLFSSL_CHAIN_CACHE) && defined(CM_TEST_CERTS) && \
+    !defined(NO_WOLFSSL_CLIENT) && !defined(NO_WOLFSSL_SERVER)
+int chain_cache_test(void);
+#endif
+#if defined(WOLFSSL_SEND_COALESCE) && defined(CM_TEST_CERTS) && \
+    !defined(NO_WOLFSSL_CLIENT) && !defined(NO_WOLFSSL_SERVER)
+int send_coalesce_test(void);
+#endif
+#if defined(WOLFSSL_SESSION_CACHE_SHARDED) && defined(CM_TEST_CERTS) && \
+    !defined(NO_WOLFSSL_CLIENT) && !defined(NO_WOLFSSL_SERVER) && \
+    !defined(WOLFSSL_NO_TLS12) && !defined(NO_SESSION_CACHE) && \
+    !defined(NO_CLIENT_CACHE)
+int session_cache_test(void);
+#endif
+#if defined(WOLFSSL_CRL_INDEX) && defined(HAVE_CRL) && defined(CM_TEST_CERTS)
+int crl_index_test(void);
+#endif
 #ifdef HAVE_IDEA
 int idea_test(void);
 #endif
@@ -1049,6 +1097,46 @@ initDefaultName();
         test_pass("DECODED CERT CACHE test passed!\n");
 #endif
 
+#if defined(WOLFSSL_CA_INDEX) && defined(CM_TEST_CERTS)
+    if ( (ret = ca_index_test()) != 0)
+        return err_sys("CA INDEX test failed!\n", ret);
+    else
+        test_pass("CA INDEX test passed!\n");
+#endif
+
+#if defined(WOLFSSL_CHAIN_CACHE) && defined(CM_TEST_CERTS) && \
+    !defined(NO_WOLFSSL_CLIENT) && !defined(NO_WOLFSSL_SERVER)
+    if ( (ret = chain_cache_test()) != 0)
+        return err_sys("CHAIN CACHE test failed!\n", ret);
+    else
+        test_pass("CHAIN CACHE test passed!\n");
+#endif
+
+#if defined(WOLFSSL_SEND_COALESCE) && defined(CM_TEST_CERTS) && \
+    !defined(NO_WOLFSSL_CLIENT) && !defined(NO_WOLFSSL_SERVER)
+    if ( (ret = send_coalesce_test()) != 0)
+        return err_sys("SEND COALESCE test failed!\n", ret);
+    else
+        test_pass("SEND COALESCE test passed!\n");
+#endif
+
+#if defined(WOLFSSL_SESSION_CACHE_SHARDED) && defined(CM_TEST_CERTS) && \
+    !defined(NO_WOLFSSL_CLIENT) && !defined(NO_WOLFSSL_SERVER) && \
+    !defined(WOLFSSL_NO_TLS12) && !defined(NO_SESSION_CACHE) && \
+    !defined(NO_CLIENT_CACHE)
+    if ( (ret = session_cache_test()) != 0)
+        return err_sys("SESSION CACHE test failed!\n", ret);
+    else
+        test_pass("SESSION CACHE test passed!\n");
+#endif
+
+#if defined(WOLFSSL_CRL_INDEX) && defined(HAVE_CRL) && defined(CM_TEST_CERTS)
+    if ( (ret = crl_index_test()) != 0)
+        return err_sys("CRL INDEX test failed!\n", ret);
+    else
+        test_pass("CRL INDEX test passed!\n");
+#endif
+
 #ifdef HAVE_CURVE25519
     if ( (ret = curve25519_test()) != 0)
         return err_sys("CURVE25519 test failed!\n", ret);
@@ -2299,6 +2387,82 @@ exit:
 
 
 #ifndef NO_SHA256
+#ifdef WOLFSSL_SHA256_MULTI
+/* multi-buffer digests must match the single stream ones, including odd
+ * lane counts and updates that leave partial blocks behind */
+static int sha256_multi_test(void)
+{
+    #define SHA256_MULTI_TEST_N 7
+    static const word32 msgLen[SHA256_MULTI_TEST_N] = {
+        0, 3, 55, 56, 64, 119, 1000
+    };
+    static const word32 split[SHA256_MULTI_TEST_N] = {
+        0, 1, 54, 0, 63, 64, 129
+    };
+    int ret = 0, i, j;
+    byte msg[1024];
+    byte hash[SHA256_MULTI_TEST_N][WC_SHA256_DIGEST_SIZE];
+    byte expect[WC_SHA256_DIGEST_SIZE];
+    wc_Sha256 sha[SHA256_MULTI_TEST_N];
+    wc_Sha256* shaP[SHA256_MULTI_TEST_N];
+    const byte* in[SHA256_MULTI_TEST_N];
+    word32 inLen[SHA256_MULTI_TEST_N];
+    byte* out[SHA256_MULTI_TEST_N];
+
+    for (i = 0; i < (int)sizeof(msg); i++)
+        msg[i] = (byte)(i * 31 + (i >> 3));
+
+    for (i = 0; i < SHA256_MULTI_TEST_N; i++) {
+        ret = wc_InitSha256_ex(&sha[i], HEAP_HINT, devId);
+        if (ret != 0)
+            return -2311;
+        shaP[i] = &sha[i];
+        out[i] = hash[i];
+    }
+
+    /* twice, the second time with the contexts reset by the final */
+    for (j = 0; j < 2; j++) {
+        for (i = 0; i < SHA256_MULTI_TEST_N; i++) {
+            in[i] = msg + i;
+            inLen[i] = split[i];
+        }
+        ret = wc_Sha256MultiUpdate(shaP, in, inLen, SHA256_MULTI_TEST_N);
+        if (ret != 0)
+            ERROR_OUT(-2312, exit);
+        for (i = 0; i < SHA256_MULTI_TEST_N; i++) {
+            in[i] = msg + i + split[i];
+            inLen[i] = msgLen[i] - split[i];
+        }
+        ret = wc_Sha256MultiUpdate(shaP, in, inLen, SHA256_MULTI_TEST_N);
+        if (ret != 0)
+            ERROR_OUT(-2313, exit);
+        ret = wc_Sha256MultiFinal(shaP, out, SHA256_MULTI_TEST_N);
+        if (ret != 0)
+            ERROR_OUT(-2314, exit);
+
+        for (i = 0; i < SHA256_MULTI_TEST_N; i++) {
+            ret = wc_Sha256Hash(msg + i, msgLen[i], expect);
+            if (ret != 0)
+                ERROR_OUT(-2315, exit);
+            if (XMEMCMP(hash[i], expect, WC_SHA256_DIGEST_SIZE) != 0)
+                ERROR_OUT(-2316, exit);
+        }
+    }
+
+    if (wc_Sha256MultiUpdate(NULL, in, inLen, 1) != BAD_FUNC_ARG)
+        ERROR_OUT(-2317, exit);
+    if (wc_Sha256MultiFinal(shaP, NULL, 1) != BAD_FUNC_ARG)
+        ERROR_OUT(-2318, exit);
+
+exit:
+    for (i = 0; i < SHA256_MULTI_TEST_N; i++)
+        wc_Sha256Free(&sha[i]);
+
+    return ret;
+    #undef SHA256_MULTI_TEST_N
+}
+#endif /* WOLFSSL_SHA256_MULTI */
+
 int sha256_test(void)
 {
     wc_Sha256 sha, shaCopy;
@@ -2402,6 +2566,12 @@ int sha256_test(void)
         ERROR_OUT(-2310, exit);
     } /* END LARGE HASH TEST */
 
+#ifdef WOLFSSL_SHA256_MULTI
+    ret = sha256_multi_test();
+    if (ret != 0)
+        goto exit;
+#endif
+
 exit:
 
     wc_Sha256Free(&sha);
@@ -2913,6 +3083,46 @@ static int sha3_384_test(void)
     #endif
     }
 
+#ifndef NO_INTM_HASH_TEST
+    /* BEGIN COPY TEST */ {
+    /* interleaved contexts and a copy taken part way through the message */
+    wc_Sha3 sha2, shaCopy;
+    word32  half = (word32)c.inLen / 2;
+
+    XMEMSET(&shaCopy, 0, sizeof(shaCopy));
+    ret = wc_InitSha3_384(&sha2, HEAP_HINT, devId);
+    if (ret != 0)
+        ERROR_OUT(-2809, exit);
+    ret = wc_Sha3_384_Update(&sha, (byte*)c.input, half);
+    if (ret == 0)
+        ret = wc_Sha3_384_Update(&sha2, (byte*)b.input, (word32)b.inLen);
+    if (ret == 0)
+        ret = wc_Sha3_384_Copy(&sha, &shaCopy);
+    if (ret == 0)
+        ret = wc_Sha3_384_Update(&sha, (byte*)c.input + half,
+            (word32)c.inLen - half);
+    if (ret == 0)
+        ret = wc_Sha3_384_Final(&sha2, hashcopy);
+    if (ret == 0 && XMEMCMP(hashcopy, b.output, WC_SHA3_384_DIGEST_SIZE) != 0)
+        ret = -2810;
+    if (ret == 0)
+        ret = wc_Sha3_384_Final(&sha, hash);
+    if (ret == 0 && XMEMCMP(hash, c.output, WC_SHA3_384_DIGEST_SIZE) != 0)
+        ret = -2811;
+    if (ret == 0)
+        ret = wc_Sha3_384_Update(&shaCopy, (byte*)c.input + half,
+            (word32)c.inLen - half);
+    if (ret == 0)
+        ret = wc_Sha3_384_Final(&shaCopy, hashcopy);
+    if (ret == 0 && XMEMCMP(hashcopy, c.output, WC_SHA3_384_DIGEST_SIZE) != 0)
+        ret = -2812;
+    wc_Sha3_384_Free(&shaCopy);
+    wc_Sha3_384_Free(&sha2);
+    if (ret != 0)
+        ERROR_OUT((ret < -2800 && ret > -2813) ? ret : -2813, exit);
+    } /* END COPY TEST */
+#endif /* NO_INTM_HASH_TEST */
+
     /* BEGIN LARGE HASH TEST */ {
     byte large_input[1024];
     const char* large_digest =
@@ -2929,6 +3139,61 @@ static int sha3_384_test(void)
             (word32)sizeof(large_input));
         if (ret != 0)
             ERROR_OUT(-2806, exit);
+    #ifdef WOLFSSL_XILINX_CRYPT
+        if (i == times / 2) {
+            /* sha streams to the engine, other contexts hash in software */
+            wc_Sha3 sha2, shaCopy;
+            int     j;
+
+            XMEMSET(&shaCopy, 0, sizeof(shaCopy));
+            ret = wc_InitSha3_384(&sha2, HEAP_HINT, devId);
+            if (ret != 0)
+                ERROR_OUT(-2814, exit);
+            ret = wc_Sha3_384_Update(&sha2, (byte*)c.input, (word32)c.inLen);
+            if (ret == 0)
+                ret = wc_Sha3_384_GetHash(&sha2, hashcopy);
+            if (ret == 0 &&
+                    XMEMCMP(hashcopy, c.output, WC_SHA3_384_DIGEST_SIZE) != 0)
+                ret = -2815;
+            if (ret == 0)
+                ret = wc_Sha3_384_Final(&sha2, hashcopy);
+            if (ret == 0 &&
+                    XMEMCMP(hashcopy, c.output, WC_SHA3_384_DIGEST_SIZE) != 0)
+                ret = -2816;
+            for (j = 0; ret == 0 && j < times; j++) {
+                ret = wc_Sha3_384_Update(&sha2, (byte*)large_input,
+                    (word32)sizeof(large_input));
+                if (ret == 0 && j == times / 2)
+                    ret = wc_Sha3_384_Copy(&sha2, &shaCopy);
+            }
+            if (ret == 0)
+                ret = wc_Sha3_384_GetHash(&sha2, hashcopy);
+            if (ret == 0 &&
+                    XMEMCMP(hashcopy, large_digest,
+                            WC_SHA3_384_DIGEST_SIZE) != 0)
+                ret = -2817;
+            if (ret == 0)
+                ret = wc_Sha3_384_Final(&sha2, hashcopy);
+            if (ret == 0 &&
+                    XMEMCMP(hashcopy, large_digest,
+                            WC_SHA3_384_DIGEST_SIZE) != 0)
+                ret = -2818;
+            for (j = times / 2 + 1; ret == 0 && j < times; j++) {
+                ret = wc_Sha3_384_Update(&shaCopy, (byte*)large_input,
+                    (word32)sizeof(large_input));
+            }
+            if (ret == 0)
+                ret = wc_Sha3_384_Final(&shaCopy, hashcopy);
+            if (ret == 0 &&
+                    XMEMCMP(hashcopy, large_digest,
+                            WC_SHA3_384_DIGEST_SIZE) != 0)
+                ret = -2819;
+            wc_Sha3_384_Free(&shaCopy);
+            wc_Sha3_384_Free(&sha2);
+            if (ret != 0)
+                ERROR_OUT((ret < -2813 && ret > -2820) ? ret : -2820, exit);
+        }
+    #endif
     }
     ret = wc_Sha3_384_Final(&sha, hash);
     if (ret != 0)
@@ -8421,6 +8686,128 @@ int aesgcm_default_test(void)
 	return 0;
 }
 
+#if !defined(BENCH_EMBEDDED)
+/* Multi block messages, as used by the 8 block AArch64 path plus leftover
+ * blocks and a partial block. Tags generated with the C implementation. */
+static int aesgcm_bulk_test(void)
+{
+    Aes  enc;
+    Aes  dec;
+    int  result = 0;
+    int  i;
+    word32 j;
+    byte resultT[AES_BLOCK_SIZE];
+    byte input[1024];
+    byte output[1024];
+    byte outdec[1024];
+
+    const byte key[] =
+    {
+        0xfe, 0xff, 0xe9, 0x92, 0x86, 0x65, 0x73, 0x1c,
+        0x6d, 0x6a, 0x8f, 0x94, 0x67, 0x30, 0x83, 0x08,
+        0xfe, 0xff, 0xe9, 0x92, 0x86, 0x65, 0x73, 0x1c,
+        0x6d, 0x6a, 0x8f, 0x94, 0x67, 0x30, 0x83, 0x08
+    };
+    const byte iv[] =
+    {
+        0xca, 0xfe, 0xba, 0xbe, 0xfa, 0xce, 0xdb, 0xad,
+        0xde, 0xca, 0xf8, 0x88
+    };
+    const byte a[] =
+    {
+        0xfe, 0xed, 0xfa, 0xce, 0xde, 0xad, 0xbe, 0xef,
+        0xfe, 0xed, 0xfa, 0xce, 0xde, 0xad, 0xbe, 0xef,
+        0xab, 0xad, 0xda, 0xd2
+    };
+    const struct {
+        word32 keySz;
+        word32 sz;
+        byte   tag[AES_BLOCK_SIZE];
+    } tv[] = {
+#if defined(WOLFSSL_AES_128) && !defined(WOLFSSL_AFALG_XILINX_AES) && \
+    !defined(WOLFSSL_XILINX_CRYPT)
+        { 16, 128,  { 0xcb, 0x21, 0x96, 0xc0, 0x34, 0x38, 0x8e, 0x01,
+                      0xaa, 0x83, 0x84, 0xc2, 0x4c, 0x24, 0x28, 0xdc } },
+        { 16, 277,  { 0xd8, 0x73, 0xd2, 0xb4, 0x16, 0x63, 0x5e, 0xf7,
+                      0x74, 0x4c, 0xa1, 0x45, 0xe0, 0x03, 0x33, 0xb7 } },
+        { 16, 1024, { 0x76, 0x72, 0xb2, 0x3e, 0x15, 0x83, 0x25, 0x06,
+                      0xa8, 0x70, 0xc1, 0x3f, 0xf3, 0xec, 0xd4, 0x3c } },
+#endif
+#if defined(WOLFSSL_AES_192) && !defined(WOLFSSL_AFALG_XILINX_AES) && \
+    !defined(WOLFSSL_XILINX_CRYPT)
+        { 24, 128,  { 0x6e, 0x9b, 0x1a, 0xe5, 0x04, 0x87, 0x27, 0x96,
+                      0x4a, 0xd6, 0xe8, 0xc5, 0x7f, 0x14, 0x8d, 0x9e } },
+        { 24, 277,  { 0x36, 0x4c, 0x13, 0xcc, 0xc6, 0x3d, 0x4f, 0x49,
+                      0xd7, 0x6c, 0xf0, 0xfe, 0x7a, 0x6e, 0x7e, 0xbe } },
+        { 24, 1024, { 0x8f, 0xb8, 0x96, 0x6b, 0x2b, 0x29, 0x45, 0xe8,
+                      0x92, 0xa9, 0x75, 0x9b, 0x77, 0xc3, 0x13, 0x37 } },
+#endif
+#ifdef WOLFSSL_AES_256
+        { 32, 128,  { 0xf1, 0x3b, 0xfd, 0x6f, 0x9b, 0x03, 0x02, 0xd1,
+                      0x3d, 0xd3, 0x54, 0x1c, 0x43, 0x87, 0x73, 0x2c } },
+        { 32, 277,  { 0xa5, 0xe1, 0xf8, 0xbb, 0x1b, 0x36, 0xf0, 0x7a,
+                      0x8a, 0x09, 0x62, 0xd2, 0x7e, 0x57, 0x6d, 0xec } },
+        { 32, 1024, { 0xed, 0x5f, 0xe1, 0x8a, 0xf2, 0xda, 0xae, 0xd7,
+                      0x93, 0x2a, 0x10, 0xe2, 0x98, 0xf8, 0xda, 0x86 } },
+#endif
+        { 0, 0, { 0 } }
+    };
+
+    for (j = 0; j < (word32)sizeof(input); j++)
+        input[j] = (byte)j;
+
+    if (wc_AesInit(&enc, HEAP_HINT, devId) != 0)
+        return -6147;
+    if (wc_AesInit(&dec, HEAP_HINT, devId) != 0)
+        return -6148;
+
+    for (i = 0; tv[i].keySz != 0; i++) {
+        result = wc_AesGcmSetKey(&enc, key, tv[i].keySz);
+        if (result != 0)
+            return -6149;
+        result = wc_AesGcmEncrypt(&enc, output, input, tv[i].sz, iv,
+                           sizeof(iv), resultT, sizeof(resultT), a, sizeof(a));
+    #if defined(WOLFSSL_ASYNC_CRYPT)
+        result = wc_AsyncWait(result, &enc.asyncDev, WC_ASYNC_FLAG_NONE);
+    #endif
+        if (result != 0)
+            return -6150;
+        if (XMEMCMP(tv[i].tag, resultT, sizeof(resultT)))
+            return -6151;
+
+    #ifdef HAVE_AES_DECRYPT
+        result = wc_AesGcmSetKey(&dec, key, tv[i].keySz);
+        if (result != 0)
+            return -6152;
+        result = wc_AesGcmDecrypt(&dec, outdec, output, tv[i].sz, iv,
+                           sizeof(iv), resultT, sizeof(resultT), a, sizeof(a));
+    #if defined(WOLFSSL_ASYNC_CRYPT)
+        result = wc_AsyncWait(result, &dec.asyncDev, WC_ASYNC_FLAG_NONE);
+    #endif
+        if (result != 0)
+            return -6153;
+        if (XMEMCMP(input, outdec, tv[i].sz))
+            return -6154;
+
+        /* changed cipher text in the last block */
+        output[tv[i].sz - 1] ^= 0x80;
+        result = wc_AesGcmDecrypt(&dec, outdec, output, tv[i].sz, iv,
+                           sizeof(iv), resultT, sizeof(resultT), a, sizeof(a));
+    #if defined(WOLFSSL_ASYNC_CRYPT)
+        result = wc_AsyncWait(result, &dec.asyncDev, WC_ASYNC_FLAG_NONE);
+    #endif
+        if (result != AES_GCM_AUTH_E)
+            return -6155;
+    #endif /* HAVE_AES_DECRYPT */
+    }
+
+    wc_AesFree(&enc);
+    wc_AesFree(&dec);
+
+    return 0;
+}
+#endif /* !BENCH_EMBEDDED */
+
 int aesgcm_test(void)
 {
     Aes enc;
@@ -8676,6 +9063,35 @@ int aesgcm_test(void)
     if (XMEMCMP(large_input, large_outdec, BENCH_AESGCM_LARGE))
         return -6111;
 #endif /* HAVE_AES_DECRYPT */
+
+#ifdef WOLFSSL_XILINX_CRYPT
+    /* tag directly after the output is written in place by the engine */
+    XMEMCPY(large_output, large_input, BENCH_AESGCM_LARGE);
+    result = wc_AesGcmEncrypt(&enc, large_output, large_output,
+                              BENCH_AESGCM_LARGE, iv1, sizeof(iv1),
+                              large_output + BENCH_AESGCM_LARGE,
+                              sizeof(resultT), a, sizeof(a));
+    if (result != 0)
+        return -6142;
+    if (XMEMCMP(resultT, large_output + BENCH_AESGCM_LARGE, sizeof(resultT)))
+        return -6143;
+#ifdef HAVE_AES_DECRYPT
+    resultT[0] ^= 0x01;
+    result = wc_AesGcmDecrypt(&dec, large_outdec, large_output,
+                              BENCH_AESGCM_LARGE, iv1, sizeof(iv1), resultT,
+                              sizeof(resultT), a, sizeof(a));
+    resultT[0] ^= 0x01;
+    if (result != AES_GCM_AUTH_E)
+        return -6144;
+    result = wc_AesGcmDecrypt(&dec, large_output, large_output,
+                              BENCH_AESGCM_LARGE, iv1, sizeof(iv1), resultT,
+                              sizeof(resultT), a, sizeof(a));
+    if (result != 0)
+        return -6145;
+    if (XMEMCMP(large_input, large_output, BENCH_AESGCM_LARGE))
+        return -6146;
+#endif /* HAVE_AES_DECRYPT */
+#endif /* WOLFSSL_XILINX_CRYPT */
 #endif /* BENCH_AESGCM_LARGE */
 #if defined(ENABLE_NON_12BYTE_IV_TEST) && defined(WOLFSSL_AES_256)
     /* Variable IV length test */
@@ -8946,6 +9362,12 @@ int aesgcm_test(void)
     wc_AesFree(&enc);
     wc_AesFree(&dec);
 
+#if !defined(BENCH_EMBEDDED)
+    result = aesgcm_bulk_test();
+    if (result != 0)
+        return result;
+#endif
+
     return 0;
 }
 
@@ -10176,6 +10598,207 @@ static int simple_mem_test(int sz)
 }
 #endif
 
+#ifdef MEM_TEST_ARENA
+#define ARENA_TEST_GENERAL_SZ (256 * 1024)
+#define ARENA_TEST_POOL_SZ    (WOLFMEM_ARENA_SZ + 1024) /* one arena */
+
+#define ARENA_TEST_IN(p, buf, sz) \
+    ((byte*)(p) >= (buf) && (byte*)(p) < (buf) + (sz))
+
+/* Handshake arenas of a connection's static memory pool: arena allocation,
+ * release deferred while arena memory is in use, realloc into and out of the
+ * arena, and system heap memory only for pools without general memory */
+static int arena_mem_test(void)
+{
+    int ret = 0, i;
+    byte* general;
+    byte* arena;
+    byte* a = NULL;
+    byte* b = NULL;
+    byte* fill[WOLFMEM_ARENA_SZ / 4096 + 1];
+    WOLFSSL_CTX* ctx = NULL;
+    WOLFSSL* ssl = NULL;
+    WOLFSSL* ssl2 = NULL;
+    WOLFSSL_MEM_STATS stats;
+
+    XMEMSET(fill, 0, sizeof(fill));
+    /* a new CTX would init the library for good */
+    wolfSSL_Init();
+    /* pools from the system heap, too large for the test pool */
+    general = (byte*)XMALLOC(ARENA_TEST_GENERAL_SZ, NULL,
+                             DYNAMIC_TYPE_TMP_BUFFER);
+    arena = (byte*)XMALLOC(ARENA_TEST_POOL_SZ, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+    if (general == NULL || arena == NULL)
+        ERROR_OUT(-7018, done);
+
+    /* general buckets plus one arena */
+    if (wolfSSL_CTX_load_static_memory(&ctx, wolfTLSv1_2_client_method_ex,
+            general, ARENA_TEST_GENERAL_SZ, WOLFMEM_GENERAL, 1)
+                                                          != WOLFSSL_SUCCESS)
+        ERROR_OUT(-7019, done);
+    if (wolfSSL_CTX_load_static_memory(&ctx, NULL, arena, ARENA_TEST_POOL_SZ,
+            WOLFMEM_ARENA, 1) != WOLFSSL_SUCCESS)
+        ERROR_OUT(-7020, done);
+    if (wolfSSL_CTX_is_static_memory(ctx, &stats) != 1 || stats.avaArena != 1)
+        ERROR_OUT(-7021, done);
+
+    /* the connection takes the arena */
+    ssl = wolfSSL_new(ctx);
+    if (ssl == NULL)
+        ERROR_OUT(-7022, done);
+    if (wolfSSL_CTX_is_static_memory(ctx, &stats) != 1 || stats.avaArena != 0)
+        ERROR_OUT(-7023, done);
+
+    /* handshake memory from the arena, long lived types from the buckets */
+    a = (byte*)XMALLOC(100, ssl->heap, DYNAMIC_TYPE_TMP_BUFFER);
+    b = (byte*)XMALLOC(100, ssl->heap, DYNAMIC_TYPE_SSL);
+    if (a == NULL || !ARENA_TEST_IN(a, arena, ARENA_TEST_POOL_SZ))
+        ERROR_OUT(-7024, done);
+    if (b == NULL || !ARENA_TEST_IN(b, general, ARENA_TEST_GENERAL_SZ))
+        ERROR_OUT(-7025, done);
+    XFREE(b, ssl->heap, DYNAMIC_TYPE_SSL);
+    b = NULL;
+
+    /* with the arena full, handshake memory comes from the buckets */
+    for (i = 0; i < (int)(sizeof(fill) / sizeof(fill[0])); i++) {
+        fill[i] = (byte*)XMALLOC(4096, ssl->heap, DYNAMIC_TYPE_TMP_BUFFER);
+        if (fill[i] == NULL)
+            ERROR_OUT(-7026, done);
+        if (!ARENA_TEST_IN(fill[i], arena, ARENA_TEST_POOL_SZ))
+            break;
+    }
+    if (i == (int)(sizeof(fill) / sizeof(fill[0])) ||
+            !ARENA_TEST_IN(fill[i], general, ARENA_TEST_GENERAL_SZ))
+        ERROR_OUT(-7027, done);
+
+    /* a grown arena allocation moves out of the full arena */
+    for (i = 0; i < 100; i++)
+        a[i] = (byte)i;
+    b = (byte*)XREALLOC(a, 4096, ssl->heap, DYNAMIC_TYPE_TMP_BUFFER);
+    if (b == NULL)
+        ERROR_OUT(-7028, done);
+    a = b;
+    b = NULL;
+    if (!ARENA_TEST_IN(a, general, ARENA_TEST_GENERAL_SZ))
+        ERROR_OUT(-7029, done);
+    for (i = 0; i < 100; i++) {
+        if (a[i] != (byte)i)
+            ERROR_OUT(-7030, done);
+    }
+
+    /* no system heap with general memory loaded, too large is an error */
+    b = (byte*)XMALLOC(WOLFMEM_ARENA_SZ + 64, ssl->heap,
+                       DYNAMIC_TYPE_TMP_BUFFER);
+    if (b != NULL)
+        ERROR_OUT(-7031, done);
+
+    for (i = 0; i < (int)(sizeof(fill) / sizeof(fill[0])); i++) {
+        XFREE(fill[i], ssl->heap, DYNAMIC_TYPE_TMP_BUFFER);
+        fill[i] = NULL;
+    }
+    XFREE(a, ssl->heap, DYNAMIC_TYPE_TMP_BUFFER);
+
+    /* arena memory still in use when the connection goes, the arena is
+     * released on its last free */
+    a = (byte*)XMALLOC(100, ssl->heap, DYNAMIC_TYPE_TMP_BUFFER);
+    if (a == NULL || !ARENA_TEST_IN(a, arena, ARENA_TEST_POOL_SZ))
+        ERROR_OUT(-7032, done);
+    wolfSSL_free(ssl);
+    ssl = NULL;
+    if (wolfSSL_CTX_is_static_memory(ctx, &stats) != 1 || stats.avaArena != 0)
+        ERROR_OUT(-7033, done);
+    /* meanwhile a new connection uses the buckets */
+    ssl2 = wolfSSL_new(ctx);
+    if (ssl2 == NULL)
+        ERROR_OUT(-7034, done);
+    b = (byte*)XMALLOC(100, ssl2->heap, DYNAMIC_TYPE_TMP_BUFFER);
+    if (b == NULL || !ARENA_TEST_IN(b, general, ARENA_TEST_GENERAL_SZ))
+        ERROR_OUT(-7035, done);
+    XFREE(b, ssl2->heap, DYNAMIC_TYPE_TMP_BUFFER);
+    b = NULL;
+    wolfSSL_free(ssl2);
+    ssl2 = NULL;
+    XFREE(a, ctx->heap, DYNAMIC_TYPE_TMP_BUFFER);
+    a = NULL;
+    if (wolfSSL_CTX_is_static_memory(ctx, &stats) != 1 || stats.avaArena != 1)
+        ERROR_OUT(-7036, done);
+    wolfSSL_CTX_free(ctx);
+    ctx = NULL;
+
+    /* only an arena, the rest is from the system heap */
+    if (wolfSSL_CTX_load_static_memory(&ctx, wolfTLSv1_2_client_method_ex,
+            arena, ARENA_TEST_POOL_SZ, WOLFMEM_ARENA, 1) != WOLFSSL_SUCCESS)
+        ERROR_OUT(-7037, done);
+    /* the CTX is system heap memory, buckets can't be added now */
+    if (wolfSSL_CTX_load_static_memory(&ctx, NULL, general,
+            ARENA_TEST_GENERAL_SZ, WOLFMEM_GENERAL, 1) == WOLFSSL_SUCCESS)
+        ERROR_OUT(-7038, done);
+    ssl = wolfSSL_new(ctx);
+    if (ssl == NULL)
+        ERROR_OUT(-7039, done);
+    b = (byte*)XMALLOC(100, ssl->heap, DYNAMIC_TYPE_SSL);
+    if (b == NULL || ARENA_TEST_IN(b, arena, ARENA_TEST_POOL_SZ))
+        ERROR_OUT(-7040, done);
+    XFREE(b, ssl->heap, DYNAMIC_TYPE_SSL);
+    b = NULL;
+
+    /* realloc out of the arena to the system heap and back */
+    a = (byte*)XMALLOC(100, ssl->heap, DYNAMIC_TYPE_TMP_BUFFER);
+    if (a == NULL || !ARENA_TEST_IN(a, arena, ARENA_TEST_POOL_SZ))
+        ERROR_OUT(-7041, done);
+    for (i = 0; i < 100; i++)
+        a[i] = (byte)i;
+    b = (byte*)XREALLOC(a, WOLFMEM_ARENA_SZ + 64, ssl->heap,
+                        DYNAMIC_TYPE_TMP_BUFFER);
+    if (b == NULL)
+        ERROR_OUT(-7042, done);
+    a = b;
+    b = NULL;
+    if (ARENA_TEST_IN(a, arena, ARENA_TEST_POOL_SZ))
+        ERROR_OUT(-7043, done);
+    b = (byte*)XREALLOC(a, 50, ssl->heap, DYNAMIC_TYPE_TMP_BUFFER);
+    if (b == NULL)
+        ERROR_OUT(-7044, done);
+    a = b;
+    b = NULL;
+    if (!ARENA_TEST_IN(a, arena, ARENA_TEST_POOL_SZ))
+        ERROR_OUT(-7045, done);
+    for (i = 0; i < 50; i++) {
+        if (a[i] != (byte)i)
+            ERROR_OUT(-7046, done);
+    }
+    XFREE(a, ssl->heap, DYNAMIC_TYPE_TMP_BUFFER);
+    a = NULL;
+
+    wolfSSL_free(ssl);
+    ssl = NULL;
+    if (wolfSSL_CTX_is_static_memory(ctx, &stats) != 1 || stats.avaArena != 1)
+        ERROR_OUT(-7047, done);
+
+done:
+    for (i = 0; i < (int)(sizeof(fill) / sizeof(fill[0])); i++) {
+        if (ssl != NULL)
+            XFREE(fill[i], ssl->heap, DYNAMIC_TYPE_TMP_BUFFER);
+    }
+    if (ssl != NULL) {
+        XFREE(a, ssl->heap, DYNAMIC_TYPE_TMP_BUFFER);
+        XFREE(b, ssl->heap, DYNAMIC_TYPE_TMP_BUFFER);
+    }
+    else if (ctx != NULL) {
+        XFREE(a, ctx->heap, DYNAMIC_TYPE_TMP_BUFFER);
+        XFREE(b, ctx->heap, DYNAMIC_TYPE_TMP_BUFFER);
+    }
+    wolfSSL_free(ssl2);
+    wolfSSL_free(ssl);
+    wolfSSL_CTX_free(ctx);
+    XFREE(arena, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+    XFREE(general, NULL, DYNAMIC_TYPE_TMP_BUFFER);
+    wolfSSL_Cleanup();
+
+    return ret;
+}
+#endif /* MEM_TEST_ARENA */
+
 int memory_test(void)
 {
     int ret = 0;
@@ -10309,6 +10932,10 @@ int memory_test(void)
     XFREE(b, HEAP_HINT, DYNAMIC_TYPE_TMP_BUFFER);
 #endif
 
+#ifdef MEM_TEST_ARENA
+    ret = arena_mem_test();
+#endif
+
     return ret;
 }
 
@@ -13976,85 +14603,1403 @@ exit_rsa:
 
 #endif /* !NO_RSA */
 
+#ifdef CM_TEST_CERTS
+#define CM_TEST_CERT_SZ 1024
 
-#ifndef NO_DH
+#ifdef WOLFSSL_STATIC_MEMORY
+    /* the CA index fill and the handshake pipes outgrow the test pool */
+    #define CM_TEST_HEAP NULL
+#else
+    #define CM_TEST_HEAP HEAP_HINT
+#endif
 
-static int dh_fips_generate_test(WC_RNG *rng)
+typedef struct cm_test_cert {
+    byte    der[CM_TEST_CERT_SZ];
+    int     derSz;
+    ecc_key key;
+} cm_test_cert;
+
+/* Makes a P-256 cert with a new key, signed by issuer or self signed. With
+ * akid the cert names its issuer's key ID, else the issuer is found by name.
+ * days may be negative for an expired cert. serial may be NULL for a random
+ * one. The key is freed by the caller */
+static int cm_test_make_cert_ex(cm_test_cert* c, const char* cn, int isCA,
+    int days, cm_test_cert* issuer, int akid, const byte* serial, int serialSz,
+    WC_RNG* rng)
 {
-    int    ret = 0;
-    DhKey  key;
-    static byte p[] = {
-        0xc5, 0x7c, 0xa2, 0x4f, 0x4b, 0xd6, 0x8c, 0x3c,
-        0xda, 0xc7, 0xba, 0xaa, 0xea, 0x2e, 0x5c, 0x1e,
-        0x18, 0xb2, 0x7b, 0x8c, 0x55, 0x65, 0x9f, 0xea,
-        0xe0, 0xa1, 0x36, 0x53, 0x2b, 0x36, 0xe0, 0x4e,
-        0x3e, 0x64, 0xa9, 0xe4, 0xfc, 0x8f, 0x32, 0x62,
-        0x97, 0xe4, 0xbe, 0xf7, 0xc1, 0xde, 0x07, 0x5a,
-        0x89, 0x28, 0xf3, 0xfe, 0x4f, 0xfe, 0x68, 0xbc,
-        0xfb, 0x0a, 0x7c, 0xa4, 0xb3, 0x14, 0x48, 0x89,
-        0x9f, 0xaf, 0xb8, 0x43, 0xe2, 0xa0, 0x62, 0x5c,
-        0xb4, 0x88, 0x3f, 0x06, 0x50, 0x11, 0xfe, 0x65,
-        0x8d, 0x49, 0xd2, 0xf5, 0x4b, 0x74, 0x79, 0xdb,
-        0x06, 0x62, 0x92, 0x89, 0xed, 0xda, 0xcb, 0x87,
-        0x37, 0x16, 0xd2, 0xa1, 0x7a, 0xe8, 0xde, 0x92,
-        0xee, 0x3e, 0x41, 0x4a, 0x91, 0x5e, 0xed, 0xf3,
-        0x6c, 0x6b, 0x7e, 0xfd, 0x15, 0x92, 0x18, 0xfc,
-        0xa7, 0xac, 0x42, 0x85, 0x57, 0xe9, 0xdc, 0xda,
-        0x55, 0xc9, 0x8b, 0x28, 0x9e, 0xc1, 0xc4, 0x46,
-        0x4d, 0x88, 0xed, 0x62, 0x8e, 0xdb, 0x3f, 0xb9,
-        0xd7, 0xc8, 0xe3, 0xcf, 0xb8, 0x34, 0x2c, 0xd2,
-        0x6f, 0x28, 0x06, 0x41, 0xe3, 0x66, 0x8c, 0xfc,
-        0x72, 0xff, 0x26, 0x3b, 0x6b, 0x6c, 0x6f, 0x73,
-        0xde, 0xf2, 0x90, 0x29, 0xe0, 0x61, 0x32, 0xc4,
-        0x12, 0x74, 0x09, 0x52, 0xec, 0xf3, 0x1b, 0xa6,
-        0x45, 0x98, 0xac, 0xf9, 0x1c, 0x65, 0x8e, 0x3a,
-        0x91, 0x84, 0x4b, 0x23, 0x8a, 0xb2, 0x3c, 0xc9,
-        0xfa, 0xea, 0xf1, 0x38, 0xce, 0xd8, 0x05, 0xe0,
-        0xfa, 0x44, 0x68, 0x1f, 0xeb, 0xd9, 0x57, 0xb8,
-        0x4a, 0x97, 0x5b, 0x88, 0xc5, 0xf1, 0xbb, 0xb0,
-        0x49, 0xc3, 0x91, 0x7c, 0xd3, 0x13, 0xb9, 0x47,
-        0xbb, 0x91, 0x8f, 0xe5, 0x26, 0x07, 0xab, 0xa9,
-        0xc5, 0xd0, 0x3d, 0x95, 0x41, 0x26, 0x92, 0x9d,
-        0x13, 0x67, 0xf2, 0x7e, 0x11, 0x88, 0xdc, 0x2d
-    };
-    static byte g[] = {
-        0x4a, 0x1a, 0xf3, 0xa4, 0x92, 0xe9, 0xee, 0x74,
-        0x6e, 0x57, 0xd5, 0x8c, 0x2c, 0x5b, 0x41, 0x41,
-        0x5e, 0xd4, 0x55, 0x19, 0xdc, 0xd9, 0x32, 0x91,
-        0xf7, 0xfd, 0xc2, 0x57, 0xff, 0x03, 0x14, 0xdb,
-        0xf1, 0xb7, 0x60, 0x0c, 0x43, 0x59, 0x3f, 0xff,
-        0xac, 0xf1, 0x80, 0x9a, 0x15, 0x6f, 0xd8, 0x6e,
-        0xb7, 0x85, 0x18, 0xc8, 0xec, 0x4e, 0x59, 0x4a,
-        0xe2, 0x91, 0x43, 0x4c, 0xeb, 0x95, 0xb6, 0x2e,
-        0x9a, 0xea, 0x53, 0x68, 0x80, 0x64, 0x69, 0x40,
-        0xf9, 0xec, 0xbd, 0x85, 0x89, 0x26, 0x97, 0x67,
-        0xaf, 0xb0, 0xad, 0x00, 0x1b, 0xd4, 0xfd, 0x94,
-        0xd3, 0xe9, 0x92, 0xb1, 0xb4, 0xbc, 0x5a, 0xaa,
-        0x92, 0x80, 0x89, 0x3b, 0x39, 0x05, 0x6c, 0x22,
-        0x26, 0xfe, 0x5a, 0x28, 0x6c, 0x37, 0x50, 0x5a,
-        0x38, 0x99, 0xcf, 0xf3, 0xc1, 0x96, 0x45, 0xdc,
-        0x01, 0xcb, 0x20, 0x87, 0xa5, 0x00, 0x8c, 0xf5,
-        0x4d, 0xc2, 0xef, 0xb8, 0x9b, 0xd1, 0x87, 0xbe,
-        0xed, 0xd5, 0x0a, 0x29, 0x15, 0x34, 0x59, 0x4c,
-        0x3a, 0x05, 0x22, 0x05, 0x44, 0x4f, 0x9f, 0xc8,
-        0x47, 0x12, 0x24, 0x8e, 0xa8, 0x79, 0xe4, 0x67,
-        0xba, 0x4d, 0x5b, 0x75, 0x56, 0x95, 0xeb, 0xe8,
-        0x8a, 0xfa, 0x8e, 0x01, 0x8c, 0x1b, 0x74, 0x63,
-        0xd9, 0x2f, 0xf7, 0xd3, 0x44, 0x8f, 0xa8, 0xf5,
-        0xaf, 0x6c, 0x4f, 0xdb, 0xe7, 0xc9, 0x6c, 0x71,
-        0x22, 0xa3, 0x1d, 0xf1, 0x40, 0xb2, 0xe0, 0x9a,
-        0xb6, 0x72, 0xc9, 0xc0, 0x13, 0x16, 0xa2, 0x4a,
-        0xe1, 0x92, 0xc7, 0x54, 0x23, 0xab, 0x9d, 0xa1,
-        0xa1, 0xe5, 0x0b, 0xed, 0xba, 0xe8, 0x84, 0x37,
-        0xb2, 0xe7, 0xfe, 0x32, 0x8d, 0xfa, 0x1c, 0x53,
-        0x77, 0x97, 0xc7, 0xf3, 0x48, 0xc9, 0xdb, 0x2d,
-        0x75, 0x52, 0x9d, 0x42, 0x51, 0x78, 0x62, 0x68,
-        0x05, 0x45, 0x15, 0xf8, 0xa2, 0x4e, 0xf3, 0x0b
-    };
-    static byte q[] = {
-        0xe0, 0x35, 0x37, 0xaf, 0xb2, 0x50, 0x91, 0x8e,
-        0xf2, 0x62, 0x2b, 0xd9, 0x9f, 0x6c, 0x11, 0x75,
-        0xec, 0x24, 0x5d, 0x78, 0x59, 0xe7, 0x8d, 0xb5,
+    int ret;
+    Cert cert;
+    ecc_key* signKey = (issuer != NULL) ? &issuer->key : &c->key;
+
+    ret = wc_ecc_init_ex(&c->key, CM_TEST_HEAP, devId);
+    if (ret == 0)
+        ret = wc_ecc_make_key(rng, 32, &c->key);
+    if (ret == 0)
+        ret = wc_InitCert(&cert);
+    if (ret != 0)
+        return ret;
+
+    XSTRNCPY(cert.subject.commonName, cn, CTC_NAME_SIZE);
+    XSTRNCPY(cert.subject.org, "wolfSSL", CTC_NAME_SIZE);
+    if (serial != NULL) {
+        XMEMCPY(cert.serial, serial, serialSz);
+        cert.serialSz = serialSz;
+    }
+    cert.isCA = isCA;
+    cert.daysValid = days;
+    cert.sigType = CTC_SHA256wECDSA;
+
+    ret = wc_SetSubjectKeyIdFromPublicKey_ex(&cert, ECC_TYPE, &c->key);
+    if (ret == 0 && isCA)
+        ret = wc_SetKeyUsage(&cert, "keyCertSign,cRLSign");
+    if (ret == 0 && issuer != NULL) {
+        ret = wc_SetIssuerBuffer(&cert, issuer->der, issuer->derSz);
+        if (ret == 0 && akid)
+            ret = wc_SetAuthKeyIdFromCert(&cert, issuer->der, issuer->derSz);
+    }
+    else if (ret == 0) {
+        cert.selfSigned = 1;
+        if (akid)
+            ret = wc_SetAuthKeyIdFromPublicKey_ex(&cert, ECC_TYPE, &c->key);
+    }
+    if (ret == 0)
+        ret = wc_MakeCert(&cert, c->der, CM_TEST_CERT_SZ, NULL, &c->key, rng);
+    if (ret > 0)
+        ret = wc_SignCert(cert.bodySz, cert.sigType, c->der, CM_TEST_CERT_SZ,
+                          NULL, signKey, rng);
+    if (ret <= 0)
+        return (ret < 0) ? ret : -1;
+
+    c->derSz = ret;
+    return 0;
+}
+
+static int cm_test_make_cert(cm_test_cert* c, const char* cn, int isCA,
+    int days, cm_test_cert* issuer, int akid, WC_RNG* rng)
+{
+    return cm_test_make_cert_ex(c, cn, isCA, days, issuer, akid, NULL, 0, rng);
+}
+
+#if !defined(NO_WOLFSSL_CLIENT) && !defined(NO_WOLFSSL_SERVER) && \
+    (defined(WOLFSSL_CHAIN_CACHE) || defined(WOLFSSL_SEND_COALESCE) || \
+     defined(WOLFSSL_SESSION_CACHE_SHARDED))
+/* one direction of a memory transport, taking at most cap bytes */
+typedef struct cm_test_pipe {
+    byte* buf;
+    int   len;
+    int   pos;
+    int   cap;
+    int   sends; /* send callback calls that took data */
+} cm_test_pipe;
+
+/* Allocates the two pipes of a connection, cap bytes each. The pipes are
+ * zeroed first, so cm_test_pipes_free() can be called on failure */
+static int cm_test_pipes_new(cm_test_pipe* pipes, int cap)
+{
+    int i;
+
+    XMEMSET(pipes, 0, 2 * sizeof(cm_test_pipe));
+    for (i = 0; i < 2; i++) {
+        pipes[i].buf = (byte*)XMALLOC(cap, CM_TEST_HEAP,
+                                      DYNAMIC_TYPE_TMP_BUFFER);
+        if (pipes[i].buf == NULL)
+            return MEMORY_E;
+        pipes[i].cap = cap;
+    }
+
+    return 0;
+}
+
+static void cm_test_pipes_free(cm_test_pipe* pipes)
+{
+    XFREE(pipes[0].buf, CM_TEST_HEAP, DYNAMIC_TYPE_TMP_BUFFER);
+    XFREE(pipes[1].buf, CM_TEST_HEAP, DYNAMIC_TYPE_TMP_BUFFER);
+    pipes[0].buf = pipes[1].buf = NULL;
+}
+
+/* the read context is the pipe in, the write context the pipe out */
+static int cm_test_recv(WOLFSSL* ssl, char* buf, int sz, void* ctx)
+{
+    cm_test_pipe* p = (cm_test_pipe*)ctx;
+
+    (void)ssl;
+    if (p->pos == p->len)
+        return WOLFSSL_CBIO_ERR_WANT_READ;
+    if (sz > p->len - p->pos)
+        sz = p->len - p->pos;
+    XMEMCPY(buf, p->buf + p->pos, sz);
+    p->pos += sz;
+    if (p->pos == p->len)
+        p->pos = p->len = 0;
+
+    return sz;
+}
+
+static int cm_test_send(WOLFSSL* ssl, char* buf, int sz, void* ctx)
+{
+    cm_test_pipe* p = (cm_test_pipe*)ctx;
+
+    (void)ssl;
+    if (sz > p->cap - p->len)
+        sz = p->cap - p->len;
+    if (sz == 0)
+        return WOLFSSL_CBIO_ERR_WANT_WRITE;
+    XMEMCPY(p->buf + p->len, buf, sz);
+    p->len += sz;
+    p->sends++;
+
+    return sz;
+}
+
+static void cm_test_set_io(WOLFSSL_CTX* ctx)
+{
+    wolfSSL_SetIORecv(ctx, cm_test_recv);
+    wolfSSL_SetIOSend(ctx, cm_test_send);
+}
+
+/* Connects cli and srv through the emptied pipes and runs the handshake,
+ * returns 0 when both finish */
+static int cm_test_handshake(WOLFSSL* cli, WOLFSSL* srv, cm_test_pipe* pipes)
+{
+    int i, loops;
+    int cliDone = 0, srvDone = 0;
+
+    for (i = 0; i < 2; i++)
+        pipes[i].len = pipes[i].pos = pipes[i].sends = 0;
+    wolfSSL_SetIOReadCtx(cli, &pipes[0]);
+    wolfSSL_SetIOWriteCtx(cli, &pipes[1]);
+    wolfSSL_SetIOReadCtx(srv, &pipes[1]);
+    wolfSSL_SetIOWriteCtx(srv, &pipes[0]);
+
+    for (loops = 0; loops < 20 && !(cliDone && srvDone); loops++) {
+        if (!cliDone) {
+            if (wolfSSL_connect(cli) == WOLFSSL_SUCCESS)
+                cliDone = 1;
+            else if (wolfSSL_get_error(cli, 0) != WOLFSSL_ERROR_WANT_READ)
+                break;
+        }
+        if (!srvDone) {
+            if (wolfSSL_accept(srv) == WOLFSSL_SUCCESS)
+                srvDone = 1;
+            else if (wolfSSL_get_error(srv, 0) != WOLFSSL_ERROR_WANT_READ)
+                break;
+        }
+    }
+
+    return (cliDone && srvDone) ? 0 : -1;
+}
+#endif /* !NO_WOLFSSL_CLIENT && !NO_WOLFSSL_SERVER */
+#endif /* CM_TEST_CERTS */
+
+#if defined(WOLFSSL_CA_INDEX) && defined(CM_TEST_CERTS)
+#define CA_INDEX_TEST_FILL 40 /* more than half the first index size */
+
+/* Issuer lookups by key ID and by name through the CA index, across index
+ * growth, unload and reload. A re-issued CA (same subject, new key) is the
+ * one found by name, as the newest signer is in the CA table rows */
+int ca_index_test(void)
+{
+    int ret = 0, i;
+    cm_test_cert* ca;   /* [0] CA, [1] re-issued CA, [2] filler */
+    cm_test_cert* leaf; /* [0] names ca[0] key ID, [1] no key ID, by name */
+    byte* bundle = NULL;
+    char cn[CTC_NAME_SIZE];
+    WOLFSSL_CERT_MANAGER* cm = NULL;
+    WC_RNG rng;
+
+    ca = (cm_test_cert*)XMALLOC(5 * sizeof(cm_test_cert), CM_TEST_HEAP,
+                                DYNAMIC_TYPE_TMP_BUFFER);
+    if (ca == NULL)
+        return -13000;
+    XMEMSET(ca, 0, 5 * sizeof(cm_test_cert));
+    leaf = ca + 3;
+#ifndef HAVE_FIPS
+    ret = wc_InitRng_ex(&rng, CM_TEST_HEAP, devId);
+#else
+    ret = wc_InitRng(&rng);
+#endif
+    if (ret != 0) {
+        XFREE(ca, CM_TEST_HEAP, DYNAMIC_TYPE_TMP_BUFFER);
+        return -13001;
+    }
+    /* loading a CA makes a CTX, which would init the library for good */
+    wolfSSL_Init();
+
+    if (cm_test_make_cert(&ca[0], "CA Index Test", 1, 365, NULL, 1, &rng) != 0
+     || cm_test_make_cert(&ca[1], "CA Index Test", 1, 365, NULL, 1, &rng) != 0
+     || cm_test_make_cert(&leaf[0], "Leaf 0", 0, 365, &ca[0], 1, &rng) != 0
+     || cm_test_make_cert(&leaf[1], "Leaf 1", 0, 365, &ca[1], 0, &rng) != 0)
+        ERROR_OUT(-13002, done);
+
+    cm = wolfSSL_CertManagerNew_ex(CM_TEST_HEAP);
+    if (cm == NULL)
+        ERROR_OUT(-13003, done);
+
+    /* by key ID */
+    if (wolfSSL_CertManagerLoadCABuffer(cm, ca[0].der, ca[0].derSz,
+            WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS)
+        ERROR_OUT(-13004, done);
+    if (wolfSSL_CertManagerVerifyBuffer(cm, leaf[0].der, leaf[0].derSz,
+            WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS)
+        ERROR_OUT(-13005, done);
+    /* by name finds ca[0], whose key did not sign leaf[1] */
+    if (wolfSSL_CertManagerVerifyBuffer(cm, leaf[1].der, leaf[1].derSz,
+            WOLFSSL_FILETYPE_ASN1) == WOLFSSL_SUCCESS)
+        ERROR_OUT(-13006, done);
+
+    /* grow the index with the re-issued CA in between */
+    XSTRNCPY(cn, "CA Index Filler 00", sizeof(cn));
+    for (i = 0; i < CA_INDEX_TEST_FILL; i++) {
+        if (i == CA_INDEX_TEST_FILL / 2 &&
+                wolfSSL_CertManagerLoadCABuffer(cm, ca[1].der, ca[1].derSz,
+                    WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS)
+            ERROR_OUT(-13007, done);
+        cn[16] = (char)('0' + i / 10);
+        cn[17] = (char)('0' + i % 10);
+        ret = cm_test_make_cert(&ca[2], cn, 1, 365, NULL, 1, &rng);
+        if (ret == 0 && wolfSSL_CertManagerLoadCABuffer(cm, ca[2].der,
+                ca[2].derSz, WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS)
+            ret = -1;
+        wc_ecc_free(&ca[2].key);
+        if (ret != 0)
+            ERROR_OUT(-13008, done);
+    }
+
+    /* key ID still finds ca[0], name finds the newest ca[1] */
+    if (wolfSSL_CertManagerVerifyBuffer(cm, leaf[0].der, leaf[0].derSz,
+            WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS)
+        ERROR_OUT(-13009, done);
+    if (wolfSSL_CertManagerVerifyBuffer(cm, leaf[1].der, leaf[1].derSz,
+            WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS)
+        ERROR_OUT(-13010, done);
+
+    /* unload, nothing is found */
+    if (wolfSSL_CertManagerUnloadCAs(cm) != WOLFSSL_SUCCESS)
+        ERROR_OUT(-13011, done);
+    if (wolfSSL_CertManagerVerifyBuffer(cm, leaf[0].der, leaf[0].derSz,
+            WOLFSSL_FILETYPE_ASN1) == WOLFSSL_SUCCESS ||
+        wolfSSL_CertManagerVerifyBuffer(cm, leaf[1].der, leaf[1].derSz,
+            WOLFSSL_FILETYPE_ASN1) == WOLFSSL_SUCCESS)
+        ERROR_OUT(-13012, done);
+
+    /* reload both as a bundle */
+    bundle = (byte*)XMALLOC(ca[0].derSz + ca[1].derSz, CM_TEST_HEAP,
+                            DYNAMIC_TYPE_TMP_BUFFER);
+    if (bundle == NULL)
+        ERROR_OUT(-13013, done);
+    XMEMCPY(bundle, ca[0].der, ca[0].derSz);
+    XMEMCPY(bundle + ca[0].derSz, ca[1].der, ca[1].derSz);
+    if (wolfSSL_CertManagerLoadCABundle(cm, bundle,
+            ca[0].derSz + ca[1].derSz) != WOLFSSL_SUCCESS)
+        ERROR_OUT(-13014, done);
+    if (wolfSSL_CertManagerVerifyBuffer(cm, leaf[0].der, leaf[0].derSz,
+            WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS)
+        ERROR_OUT(-13015, done);
+    if (wolfSSL_CertManagerVerifyBuffer(cm, leaf[1].der, leaf[1].derSz,
+            WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS)
+        ERROR_OUT(-13016, done);
+
+    ret = 0;
+done:
+    wolfSSL_CertManagerFree(cm);
+    for (i = 0; i < 5; i++) {
+        if (i != 2)
+            wc_ecc_free(&ca[i].key);
+    }
+    XFREE(bundle, CM_TEST_HEAP, DYNAMIC_TYPE_TMP_BUFFER);
+    XFREE(ca, CM_TEST_HEAP, DYNAMIC_TYPE_TMP_BUFFER);
+    wc_FreeRng(&rng);
+    wolfSSL_Cleanup();
+
+    return ret;
+}
+#endif /* WOLFSSL_CA_INDEX && CM_TEST_CERTS */
+
+#if defined(WOLFSSL_CHAIN_CACHE) && defined(CM_TEST_CERTS) && \
+    !defined(NO_WOLFSSL_CLIENT) && !defined(NO_WOLFSSL_SERVER)
+#define CHAIN_CACHE_TEST_BUF_SZ (16 * 1024)
+
+static int chain_cache_verify_cb(int preverify, WOLFSSL_X509_STORE_CTX* store)
+{
+    (void)store;
+    return preverify;
+}
+
+/* New client and server connections on the CTXs and their handshake over
+ * pipes, returns 0 when both finish */
+static int chain_cache_handshake(WOLFSSL_CTX* cliCtx, WOLFSSL_CTX* srvCtx,
+    cm_test_pipe* pipes)
+{
+    int ret = -1;
+    WOLFSSL* cli = wolfSSL_new(cliCtx);
+    WOLFSSL* srv = wolfSSL_new(srvCtx);
+
+    if (cli != NULL && srv != NULL)
+        ret = cm_test_handshake(cli, srv, pipes);
+    wolfSSL_free(cli);
+    wolfSSL_free(srv);
+
+    return ret;
+}
+
+/* Verified chain cache: a chain seen before skips the chain signatures, but
+ * the leaf's dates and signer are still checked. Flush, a verify callback and
+ * CRL check all force a full verify */
+int chain_cache_test(void)
+{
+    int ret = 0, i;
+    cm_test_cert* c; /* root, intermediate, leaf, expired leaf */
+    cm_test_pipe pipes[2];
+    byte* buf = NULL;
+    int chainSz, keySz;
+    word32 hits;
+    WOLFSSL_CTX* cliCtx = NULL;
+    WOLFSSL_CTX* srvCtx[2] = { NULL, NULL };
+    WOLFSSL_CERT_MANAGER* cm;
+    WC_RNG rng;
+
+    c = (cm_test_cert*)XMALLOC(4 * sizeof(cm_test_cert), CM_TEST_HEAP,
+                               DYNAMIC_TYPE_TMP_BUFFER);
+    if (c == NULL)
+        return -13100;
+    XMEMSET(c, 0, 4 * sizeof(cm_test_cert));
+    XMEMSET(pipes, 0, sizeof(pipes));
+#ifndef HAVE_FIPS
+    ret = wc_InitRng_ex(&rng, CM_TEST_HEAP, devId);
+#else
+    ret = wc_InitRng(&rng);
+#endif
+    if (ret != 0) {
+        XFREE(c, CM_TEST_HEAP, DYNAMIC_TYPE_TMP_BUFFER);
+        return -13101;
+    }
+    wolfSSL_Init();
+
+    if (cm_test_make_cert(&c[0], "Chain Cache Root", 1, 365, NULL, 1,
+                          &rng) != 0
+     || cm_test_make_cert(&c[1], "Chain Cache CA", 1, 365, &c[0], 1,
+                          &rng) != 0
+     || cm_test_make_cert(&c[2], "localhost", 0, 365, &c[1], 1, &rng) != 0
+     || cm_test_make_cert(&c[3], "localhost", 0, -1, &c[1], 1, &rng) != 0)
+        ERROR_OUT(-13102, done);
+
+    buf = (byte*)XMALLOC(2 * CM_TEST_CERT_SZ, CM_TEST_HEAP,
+                         DYNAMIC_TYPE_TMP_BUFFER);
+    if (buf == NULL ||
+            cm_test_pipes_new(pipes, CHAIN_CACHE_TEST_BUF_SZ) != 0)
+        ERROR_OUT(-13103, done);
+
+#ifdef WOLFSSL_TLS13
+    cliCtx = wolfSSL_CTX_new(wolfTLSv1_3_client_method());
+#else
+    cliCtx = wolfSSL_CTX_new(wolfTLSv1_2_client_method());
+#endif
+    if (cliCtx == NULL || wolfSSL_CTX_load_verify_buffer(cliCtx, c[0].der,
+            c[0].derSz, WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS)
+        ERROR_OUT(-13104, done);
+    wolfSSL_CTX_set_verify(cliCtx, WOLFSSL_VERIFY_PEER, NULL);
+    cm_test_set_io(cliCtx);
+
+    /* server with the leaf, then with the expired leaf, both send the
+     * intermediate */
+    for (i = 0; i < 2; i++) {
+        cm_test_cert* leaf = &c[2 + i];
+
+    #ifdef WOLFSSL_TLS13
+        srvCtx[i] = wolfSSL_CTX_new(wolfTLSv1_3_server_method());
+    #else
+        srvCtx[i] = wolfSSL_CTX_new(wolfTLSv1_2_server_method());
+    #endif
+        XMEMCPY(buf, leaf->der, leaf->derSz);
+        XMEMCPY(buf + leaf->derSz, c[1].der, c[1].derSz);
+        chainSz = leaf->derSz + c[1].derSz;
+        keySz = wc_EccKeyToDer(&leaf->key, buf + chainSz,
+                               2 * CM_TEST_CERT_SZ - chainSz);
+        if (srvCtx[i] == NULL || keySz <= 0 ||
+            wolfSSL_CTX_use_certificate_chain_buffer_format(srvCtx[i], buf,
+                chainSz, WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS ||
+            wolfSSL_CTX_use_PrivateKey_buffer(srvCtx[i], buf + chainSz, keySz,
+                WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS)
+            ERROR_OUT(-13105, done);
+        cm_test_set_io(srvCtx[i]);
+    }
+    cm = wolfSSL_CTX_GetCertManager(cliCtx);
+
+    /* full verify, then found in the cache */
+    hits = cm->chainCacheHits;
+    if (chain_cache_handshake(cliCtx, srvCtx[0], pipes) != 0 ||
+            cm->chainCacheHits != hits)
+        ERROR_OUT(-13106, done);
+    if (chain_cache_handshake(cliCtx, srvCtx[0], pipes) != 0 ||
+            cm->chainCacheHits != hits + 1)
+        ERROR_OUT(-13107, done);
+
+    /* flush forces a full verify, which caches the chain again */
+    if (wolfSSL_CertManagerFlushChainCache(cm) != WOLFSSL_SUCCESS)
+        ERROR_OUT(-13108, done);
+    hits = cm->chainCacheHits;
+    if (chain_cache_handshake(cliCtx, srvCtx[0], pipes) != 0 ||
+            cm->chainCacheHits != hits)
+        ERROR_OUT(-13109, done);
+    if (chain_cache_handshake(cliCtx, srvCtx[0], pipes) != 0 ||
+            cm->chainCacheHits != hits + 1)
+        ERROR_OUT(-13110, done);
+
+    /* a verify callback sees every chain cert, no cache */
+    hits = cm->chainCacheHits;
+    wolfSSL_CTX_set_verify(cliCtx, WOLFSSL_VERIFY_PEER, chain_cache_verify_cb);
+    if (chain_cache_handshake(cliCtx, srvCtx[0], pipes) != 0 ||
+            cm->chainCacheHits != hits)
+        ERROR_OUT(-13111, done);
+    wolfSSL_CTX_set_verify(cliCtx, WOLFSSL_VERIFY_PEER, NULL);
+
+#ifdef HAVE_CRL
+    /* CRL check all, no CRL is loaded so the handshake fails */
+    if (wolfSSL_CertManagerEnableCRL(cm, WOLFSSL_CRL_CHECKALL)
+            != WOLFSSL_SUCCESS)
+        ERROR_OUT(-13112, done);
+    (void)chain_cache_handshake(cliCtx, srvCtx[0], pipes);
+    wolfSSL_CertManagerDisableCRL(cm);
+    if (cm->chainCacheHits != hits)
+        ERROR_OUT(-13113, done);
+#endif
+
+    /* expired leaf with the cached intermediate */
+    if (chain_cache_handshake(cliCtx, srvCtx[1], pipes) == 0)
+        ERROR_OUT(-13114, done);
+
+    /* once the first expiry in a cached chain is past it is verified in
+     * full again (the leaf's own dates are always checked) */
+    for (i = 0; i < WOLFSSL_CHAIN_CACHE_SZ; i++) {
+        if (cm->chainCache[i].lastUse != 0) {
+            XMEMSET(cm->chainCache[i].notAfter, 0, MAX_DATE_SIZE);
+            XMEMCPY(cm->chainCache[i].notAfter, "200101000000Z", 13);
+            cm->chainCache[i].notAfterFormat = ASN_UTC_TIME;
+        }
+    }
+    hits = cm->chainCacheHits;
+    if (chain_cache_handshake(cliCtx, srvCtx[0], pipes) != 0 ||
+            cm->chainCacheHits != hits)
+        ERROR_OUT(-13115, done);
+    if (chain_cache_handshake(cliCtx, srvCtx[0], pipes) != 0 ||
+            cm->chainCacheHits != hits + 1)
+        ERROR_OUT(-13116, done);
+
+    /* issuer unloaded, the cached chain is rejected */
+    if (wolfSSL_CertManagerUnloadCAs(cm) != WOLFSSL_SUCCESS)
+        ERROR_OUT(-13117, done);
+    hits = cm->chainCacheHits;
+    if (chain_cache_handshake(cliCtx, srvCtx[0], pipes) == 0 ||
+            cm->chainCacheHits != hits)
+        ERROR_OUT(-13118, done);
+    if (wolfSSL_CTX_load_verify_buffer(cliCtx, c[0].der, c[0].derSz,
+            WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS ||
+        chain_cache_handshake(cliCtx, srvCtx[0], pipes) != 0)
+        ERROR_OUT(-13119, done);
+
+    ret = 0;
+done:
+    wolfSSL_CTX_free(cliCtx);
+    wolfSSL_CTX_free(srvCtx[0]);
+    wolfSSL_CTX_free(srvCtx[1]);
+    for (i = 0; i < 4; i++)
+        wc_ecc_free(&c[i].key);
+    XFREE(buf, CM_TEST_HEAP, DYNAMIC_TYPE_TMP_BUFFER);
+    cm_test_pipes_free(pipes);
+    XFREE(c, CM_TEST_HEAP, DYNAMIC_TYPE_TMP_BUFFER);
+    wc_FreeRng(&rng);
+    wolfSSL_Cleanup();
+
+    return ret;
+}
+#endif /* WOLFSSL_CHAIN_CACHE && CM_TEST_CERTS */
+
+#if defined(WOLFSSL_SEND_COALESCE) && defined(CM_TEST_CERTS) && \
+    !defined(NO_WOLFSSL_CLIENT) && !defined(NO_WOLFSSL_SERVER)
+#define SEND_TEST_PIPE_SZ (128 * 1024)
+#define SEND_TEST_DATA_SZ (3 * MAX_RECORD_SIZE + 100) /* four records */
+#define SEND_TEST_USER_SZ (20 * 1024) /* caller output, less than a batch */
+#define SEND_TEST_CAP     5000        /* pipe size for the WANT_WRITE test */
+
+/* Reads on ssl until sz bytes or nothing is left, returns the bytes read */
+static int send_test_read(WOLFSSL* ssl, byte* out, int sz)
+{
+    int got = 0, ret;
+
+    while (got < sz) {
+        ret = wolfSSL_read(ssl, out + got, sz - got);
+        if (ret <= 0)
+            break;
+        got += ret;
+    }
+
+    return got;
+}
+
+/* Writes the test data on cli, with wolfSSL_writev when iov is set, and
+ * checks srv reads it back. On WANT_WRITE the pipe is drained and the write
+ * called again. wantWrites counts those retries */
+static int send_test_xfer(WOLFSSL* cli, WOLFSSL* srv, const byte* data,
+    const struct iovec* iov, int iovCnt, byte* rbuf, int* wantWrites)
+{
+    int ret = 0, got = 0, loops;
+
+    XMEMSET(rbuf, 0, SEND_TEST_DATA_SZ);
+    for (loops = 0; loops < 100; loops++) {
+    #ifdef WOLFSSL_SEND_IOV
+        if (iov != NULL)
+            ret = wolfSSL_writev(cli, iov, iovCnt);
+        else
+    #endif
+            ret = wolfSSL_write(cli, data, SEND_TEST_DATA_SZ);
+        if (ret == SEND_TEST_DATA_SZ)
+            break;
+        if (ret > 0 ||
+                wolfSSL_get_error(cli, ret) != WOLFSSL_ERROR_WANT_WRITE)
+            return -1;
+        (*wantWrites)++;
+        got += send_test_read(srv, rbuf + got, SEND_TEST_DATA_SZ - got);
+    }
+    (void)iov;
+    (void)iovCnt;
+    if (ret != SEND_TEST_DATA_SZ)
+        return -1;
+
+    got += send_test_read(srv, rbuf + got, SEND_TEST_DATA_SZ - got);
+    if (got != SEND_TEST_DATA_SZ ||
+            XMEMCMP(rbuf, data, SEND_TEST_DATA_SZ) != 0)
+        return -2;
+
+    return 0;
+}
+
+/* Coalesced writes, writev, WANT_WRITE resume and a caller output buffer on
+ * one connection. Returns 0 or the failed step */
+static int send_test_conn(WOLFSSL_CTX* cliCtx, WOLFSSL_CTX* srvCtx,
+    cm_test_pipe* pipes, const byte* data, byte* rbuf, byte* userBuf)
+{
+    int ret = -1, wantWrites = 0;
+    WOLFSSL* cli;
+    WOLFSSL* srv;
+#ifdef WOLFSSL_SEND_IOV
+    /* vectors that start and end part way through records */
+    struct iovec iov[5];
+    const int iovSz[5] = { 1, MAX_RECORD_SIZE - 2, 3, MAX_RECORD_SIZE + 5,
+                           MAX_RECORD_SIZE + 93 };
+    int i, off = 0;
+
+    for (i = 0; i < 5; i++) {
+        iov[i].iov_base = (void*)(data + off);
+        iov[i].iov_len  = iovSz[i];
+        off += iovSz[i];
+    }
+#endif
+
+    cli = wolfSSL_new(cliCtx);
+    srv = wolfSSL_new(srvCtx);
+    if (cli == NULL || srv == NULL ||
+            cm_test_handshake(cli, srv, pipes) != 0)
+        goto done;
+
+    /* four records in one send */
+    ret = -2;
+    pipes[1].sends = 0;
+    if (send_test_xfer(cli, srv, data, NULL, 0, rbuf, &wantWrites) != 0 ||
+            pipes[1].sends != 1)
+        goto done;
+
+#ifdef WOLFSSL_SEND_IOV
+    /* gathered into the records */
+    ret = -3;
+    pipes[1].sends = 0;
+    if (send_test_xfer(cli, srv, data, iov, 5, rbuf, &wantWrites) != 0 ||
+            pipes[1].sends != 1)
+        goto done;
+#endif
+    if (wantWrites != 0)
+        goto done;
+
+    /* short sends, resumed after each WANT_WRITE */
+    ret = -4;
+    pipes[1].cap = SEND_TEST_CAP;
+    if (send_test_xfer(cli, srv, data, NULL, 0, rbuf, &wantWrites) != 0 ||
+            wantWrites == 0)
+        goto done;
+#ifdef WOLFSSL_SEND_IOV
+    ret = -5;
+    wantWrites = 0;
+    if (send_test_xfer(cli, srv, data, iov, 5, rbuf, &wantWrites) != 0 ||
+            wantWrites == 0)
+        goto done;
+#endif
+    pipes[1].cap = SEND_TEST_PIPE_SZ;
+
+    /* caller output smaller than the batch, several sends and no dynamic
+     * buffer */
+    ret = -6;
+    if (wolfSSL_SetOutputBuffer(cli, userBuf, SEND_TEST_USER_SZ)
+            != WOLFSSL_SUCCESS)
+        goto done;
+    pipes[1].sends = 0;
+    if (send_test_xfer(cli, srv, data, NULL, 0, rbuf, &wantWrites) != 0 ||
+            pipes[1].sends < 3 ||
+            cli->buffers.outputBuffer.buffer != userBuf ||
+            cli->buffers.outputBuffer.dynamicFlag)
+        goto done;
+#ifdef WOLFSSL_SEND_IOV
+    ret = -7;
+    pipes[1].sends = 0;
+    if (send_test_xfer(cli, srv, data, iov, 5, rbuf, &wantWrites) != 0 ||
+            pipes[1].sends < 3 ||
+            cli->buffers.outputBuffer.buffer != userBuf ||
+            cli->buffers.outputBuffer.dynamicFlag)
+        goto done;
+#endif
+    ret = -8;
+    if (wolfSSL_SetOutputBuffer(cli, NULL, 0) != WOLFSSL_SUCCESS ||
+            cli->buffers.outputBuffer.buffer == userBuf)
+        goto done;
+
+    ret = 0;
+done:
+    wolfSSL_free(cli);
+    wolfSSL_free(srv);
+
+    return ret;
+}
+
+typedef struct send_test_suite {
+    WOLFSSL_METHOD* (*cliMethod)(void);
+    WOLFSSL_METHOD* (*srvMethod)(void);
+    const char*     cipher;
+} send_test_suite;
+
+/* Writes of several records are built back to back and sent at once, also
+ * through wolfSSL_writev, with WANT_WRITE and a caller output buffer.
+ * TLS 1.2 AEAD and CBC records and TLS 1.3 records */
+int send_coalesce_test(void)
+{
+    int ret = 0, i, keySz;
+    cm_test_cert* c = NULL;
+    cm_test_pipe pipes[2];
+    byte* data = NULL;
+    byte* rbuf = NULL;
+    byte* userBuf = NULL;
+    byte* keyDer = NULL;
+    WOLFSSL_CTX* cliCtx = NULL;
+    WOLFSSL_CTX* srvCtx = NULL;
+    WC_RNG rng;
+    const send_test_suite suites[] = {
+    #ifndef WOLFSSL_NO_TLS12
+        #ifdef BUILD_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256
+        { wolfTLSv1_2_client_method, wolfTLSv1_2_server_method,
+          "ECDHE-ECDSA-AES128-GCM-SHA256" },
+        #endif
+        #ifdef BUILD_TLS_ECDHE_ECDSA_WITH_AES_128_CBC_SHA256
+        { wolfTLSv1_2_client_method, wolfTLSv1_2_server_method,
+          "ECDHE-ECDSA-AES128-SHA256" },
+        #endif
+    #endif
+    #if defined(WOLFSSL_TLS13) && defined(BUILD_TLS_AES_128_GCM_SHA256)
+        { wolfTLSv1_3_client_method, wolfTLSv1_3_server_method,
+          "TLS13-AES128-GCM-SHA256" },
+    #endif
+        { NULL, NULL, NULL }
+    };
+
+    XMEMSET(pipes, 0, sizeof(pipes));
+#ifndef HAVE_FIPS
+    ret = wc_InitRng_ex(&rng, CM_TEST_HEAP, devId);
+#else
+    ret = wc_InitRng(&rng);
+#endif
+    if (ret != 0)
+        return -13200;
+    wolfSSL_Init();
+
+    c = (cm_test_cert*)XMALLOC(sizeof(cm_test_cert), CM_TEST_HEAP,
+                               DYNAMIC_TYPE_TMP_BUFFER);
+    data = (byte*)XMALLOC(2 * SEND_TEST_DATA_SZ + SEND_TEST_USER_SZ +
+                          CM_TEST_CERT_SZ, CM_TEST_HEAP,
+                          DYNAMIC_TYPE_TMP_BUFFER);
+    if (c == NULL || data == NULL ||
+            cm_test_pipes_new(pipes, SEND_TEST_PIPE_SZ) != 0)
+        ERROR_OUT(-13201, done);
+    XMEMSET(c, 0, sizeof(cm_test_cert));
+    rbuf = data + SEND_TEST_DATA_SZ;
+    userBuf = rbuf + SEND_TEST_DATA_SZ;
+    keyDer = userBuf + SEND_TEST_USER_SZ;
+    for (i = 0; i < SEND_TEST_DATA_SZ; i++)
+        data[i] = (byte)(i ^ (i >> 8));
+
+    if (cm_test_make_cert(c, "localhost", 0, 365, NULL, 0, &rng) != 0)
+        ERROR_OUT(-13202, done);
+    keySz = wc_EccKeyToDer(&c->key, keyDer, CM_TEST_CERT_SZ);
+    if (keySz <= 0)
+        ERROR_OUT(-13203, done);
+
+    for (i = 0; suites[i].cipher != NULL; i++) {
+        cliCtx = wolfSSL_CTX_new(suites[i].cliMethod());
+        srvCtx = wolfSSL_CTX_new(suites[i].srvMethod());
+        if (cliCtx == NULL || srvCtx == NULL ||
+            wolfSSL_CTX_set_cipher_list(cliCtx, suites[i].cipher)
+                != WOLFSSL_SUCCESS ||
+            wolfSSL_CTX_set_cipher_list(srvCtx, suites[i].cipher)
+                != WOLFSSL_SUCCESS ||
+            wolfSSL_CTX_use_certificate_buffer(srvCtx, c->der, c->derSz,
+                WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS ||
+            wolfSSL_CTX_use_PrivateKey_buffer(srvCtx, keyDer, keySz,
+                WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS)
+            ERROR_OUT(-13204 - 10 * i, done);
+        wolfSSL_CTX_set_verify(cliCtx, WOLFSSL_VERIFY_NONE, NULL);
+        cm_test_set_io(cliCtx);
+        cm_test_set_io(srvCtx);
+
+        /* -13205 handshake, -13206 to -13212 the steps */
+        ret = send_test_conn(cliCtx, srvCtx, pipes, data, rbuf, userBuf);
+        if (ret != 0)
+            ERROR_OUT(-13204 - 10 * i + ret, done);
+
+        wolfSSL_CTX_free(cliCtx);
+        wolfSSL_CTX_free(srvCtx);
+        cliCtx = srvCtx = NULL;
+    }
+
+    ret = 0;
+done:
+    wolfSSL_CTX_free(cliCtx);
+    wolfSSL_CTX_free(srvCtx);
+    if (c != NULL)
+        wc_ecc_free(&c->key);
+    cm_test_pipes_free(pipes);
+    XFREE(data, CM_TEST_HEAP, DYNAMIC_TYPE_TMP_BUFFER);
+    XFREE(c, CM_TEST_HEAP, DYNAMIC_TYPE_TMP_BUFFER);
+    wc_FreeRng(&rng);
+    wolfSSL_Cleanup();
+
+    return ret;
+}
+#endif /* WOLFSSL_SEND_COALESCE && CM_TEST_CERTS */
+
+#if defined(WOLFSSL_SESSION_CACHE_SHARDED) && defined(CM_TEST_CERTS) && \
+    !defined(NO_WOLFSSL_CLIENT) && !defined(NO_WOLFSSL_SERVER) && \
+    !defined(WOLFSSL_NO_TLS12) && !defined(NO_SESSION_CACHE) && \
+    !defined(NO_CLIENT_CACHE)
+#define SESSION_TEST_BUF_SZ   (16 * 1024)
+#define SESSION_TEST_SAVED    4
+#define SESSION_TEST_SERVERS  6
+#define SESSION_TEST_SPIN_MAX 100000000 /* waiting for a 1s timeout */
+#define SESSION_TEST_FLUSH_ALL 0x7FFFFFFFL /* every session expired by then */
+
+/* certificate, key and CTXs of the session cache test */
+typedef struct session_test_ctx {
+    cm_test_cert       cert;
+    byte               keyDer[CM_TEST_CERT_SZ];
+    int                keySz;
+    WOLFSSL_CTX*       cli;
+    WOLFSSL_CTX*       srv;
+    cm_test_pipe       pipes[2];
+    WOLFSSL_SESSION    saved[SESSION_TEST_SAVED];
+} session_test_ctx;
+
+/* Library init with a rows x sessionsPerRow cache and new CTXs on the test
+ * certificate. Returns 0 on success */
+static int session_test_init(session_test_ctx* t, word32 rows,
+    word32 sessionsPerRow)
+{
+    if (wolfSSL_SetSessionCacheSize(rows, sessionsPerRow) != WOLFSSL_SUCCESS)
+        return -1;
+    if (wolfSSL_Init() != WOLFSSL_SUCCESS)
+        return -1;
+    /* the table is in use now */
+    if (wolfSSL_SetSessionCacheSize(rows, sessionsPerRow) != BAD_STATE_E)
+        return -1;
+
+    t->cli = wolfSSL_CTX_new(wolfTLSv1_2_client_method());
+    t->srv = wolfSSL_CTX_new(wolfTLSv1_2_server_method());
+    if (t->cli == NULL || t->srv == NULL ||
+        wolfSSL_CTX_use_certificate_buffer(t->srv, t->cert.der,
+            t->cert.derSz, WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS ||
+        wolfSSL_CTX_use_PrivateKey_buffer(t->srv, t->keyDer, t->keySz,
+            WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS)
+        return -1;
+    wolfSSL_CTX_set_verify(t->cli, WOLFSSL_VERIFY_NONE, NULL);
+    cm_test_set_io(t->cli);
+    cm_test_set_io(t->srv);
+
+    return 0;
+}
+
+static void session_test_cleanup(session_test_ctx* t)
+{
+    wolfSSL_CTX_free(t->cli);
+    wolfSSL_CTX_free(t->srv);
+    t->cli = t->srv = NULL;
+    wolfSSL_Cleanup();
+}
+
+/* Client/server handshake over memory. The client offers resume, or looks up
+ * serverId in the client cache. A timeout in seconds is set on both sides
+ * when not 0. The session is copied into save, it is the cache entry.
+ * Returns 1 when resumed, 0 for a full handshake, -1 on error */
+static int session_test_conn(session_test_ctx* t, WOLFSSL_SESSION* resume,
+    const char* serverId, word32 timeout, WOLFSSL_SESSION* save)
+{
+    int ret = -1;
+    WOLFSSL* cli;
+    WOLFSSL* srv;
+    WOLFSSL_SESSION* session;
+
+    cli = wolfSSL_new(t->cli);
+    srv = wolfSSL_new(t->srv);
+    if (cli == NULL || srv == NULL)
+        goto done;
+    if (timeout != 0 && (wolfSSL_set_timeout(cli, timeout) != WOLFSSL_SUCCESS
+                    || wolfSSL_set_timeout(srv, timeout) != WOLFSSL_SUCCESS))
+        goto done;
+    /* an expired session is refused here, the handshake is then full */
+    if (resume != NULL)
+        wolfSSL_set_session(cli, resume);
+    if (serverId != NULL && wolfSSL_SetServerID(cli, (const byte*)serverId,
+                        (int)XSTRLEN(serverId), 0) != WOLFSSL_SUCCESS)
+        goto done;
+
+    if (cm_test_handshake(cli, srv, t->pipes) != 0 ||
+            wolfSSL_session_reused(cli) != wolfSSL_session_reused(srv))
+        goto done;
+
+    if (save != NULL) {
+        session = wolfSSL_get_session(cli);
+        if (session == NULL)
+            goto done;
+        XMEMCPY(save, session, sizeof(WOLFSSL_SESSION));
+    }
+    ret = wolfSSL_session_reused(cli) ? 1 : 0;
+done:
+    wolfSSL_free(cli);
+    wolfSSL_free(srv);
+
+    return ret;
+}
+
+/* Sharded session cache: client cache lookups with the server ID and the
+ * session in different rows, LRU and expired session eviction in a full row,
+ * wolfSSL_flush_sessions and sizing the cache before and after init */
+int session_cache_test(void)
+{
+    int ret = 0, i, spins;
+    char serverId[] = "session test 0";
+    session_test_ctx* t;
+    WOLFSSL_SESSION* s;
+    WOLFSSL* probe = NULL;
+    WC_RNG rng;
+
+    t = (session_test_ctx*)XMALLOC(sizeof(session_test_ctx), CM_TEST_HEAP,
+                                   DYNAMIC_TYPE_TMP_BUFFER);
+    if (t == NULL)
+        return -13300;
+    XMEMSET(t, 0, sizeof(session_test_ctx));
+    s = t->saved;
+#ifndef HAVE_FIPS
+    ret = wc_InitRng_ex(&rng, CM_TEST_HEAP, devId);
+#else
+    ret = wc_InitRng(&rng);
+#endif
+    if (ret != 0) {
+        XFREE(t, CM_TEST_HEAP, DYNAMIC_TYPE_TMP_BUFFER);
+        return -13301;
+    }
+    if (cm_test_pipes_new(t->pipes, SESSION_TEST_BUF_SZ) != 0 ||
+        cm_test_make_cert(&t->cert, "localhost", 0, 365, NULL, 0, &rng) != 0)
+        ERROR_OUT(-13302, done);
+    t->keySz = wc_EccKeyToDer(&t->cert.key, t->keyDer, CM_TEST_CERT_SZ);
+    if (t->keySz <= 0)
+        ERROR_OUT(-13303, done);
+
+    if (wolfSSL_SetSessionCacheSize(0x10000, 1) != BAD_FUNC_ARG ||
+            wolfSSL_SetSessionCacheSize(1, 0x10000) != BAD_FUNC_ARG)
+        ERROR_OUT(-13304, done);
+
+    /* client cache: 4 rows, room for every session so nothing is evicted.
+     * Rows come from hashes, most server IDs are in a different row than
+     * their session */
+    if (session_test_init(t, 4, 8) != 0)
+        ERROR_OUT(-13305, done);
+    for (i = 0; i < SESSION_TEST_SERVERS; i++) {
+        serverId[XSTRLEN(serverId) - 1] = (char)('0' + i);
+        if (session_test_conn(t, NULL, serverId, 0, NULL) != 0)
+            ERROR_OUT(-13306, done);
+    }
+    for (i = 0; i < SESSION_TEST_SERVERS; i++) {
+        serverId[XSTRLEN(serverId) - 1] = (char)('0' + i);
+        if (session_test_conn(t, NULL, serverId, 0, NULL) != 1)
+            ERROR_OUT(-13307, done);
+    }
+    /* unknown server ID */
+    if (session_test_conn(t, NULL, "session test x", 0, NULL) != 0)
+        ERROR_OUT(-13308, done);
+    session_test_cleanup(t);
+
+    /* one row of three sessions */
+    if (session_test_init(t, 1, 3) != 0)
+        ERROR_OUT(-13309, done);
+    for (i = 0; i < 3; i++) {
+        if (session_test_conn(t, NULL, NULL, 0, &s[i]) != 0)
+            ERROR_OUT(-13310, done);
+    }
+    /* s[0] used, s[1] is least recently used and makes room for s[3] */
+    if (session_test_conn(t, &s[0], NULL, 0, NULL) != 1)
+        ERROR_OUT(-13311, done);
+    if (session_test_conn(t, NULL, NULL, 0, &s[3]) != 0)
+        ERROR_OUT(-13312, done);
+    if (session_test_conn(t, &s[0], NULL, 0, NULL) != 1 ||
+            session_test_conn(t, &s[2], NULL, 0, NULL) != 1 ||
+            session_test_conn(t, &s[3], NULL, 0, NULL) != 1)
+        ERROR_OUT(-13313, done);
+    if (session_test_conn(t, &s[1], NULL, 0, NULL) != 0)
+        ERROR_OUT(-13314, done);
+
+    /* nothing has expired at time 0, everything has at the end of time */
+    if (session_test_conn(t, NULL, NULL, 0, &s[0]) != 0)
+        ERROR_OUT(-13315, done);
+    wolfSSL_flush_sessions(t->cli, 0);
+    if (session_test_conn(t, &s[0], NULL, 0, NULL) != 1)
+        ERROR_OUT(-13316, done);
+    wolfSSL_flush_sessions(t->cli, SESSION_TEST_FLUSH_ALL);
+    if (session_test_conn(t, &s[0], NULL, 0, NULL) != 0)
+        ERROR_OUT(-13317, done);
+
+    /* an expired session goes before the least recently used one */
+    wolfSSL_flush_sessions(t->cli, SESSION_TEST_FLUSH_ALL);
+    if (session_test_conn(t, NULL, NULL, 1, &s[0]) != 0 ||
+            session_test_conn(t, NULL, NULL, 0, &s[1]) != 0 ||
+            session_test_conn(t, NULL, NULL, 0, &s[2]) != 0)
+        ERROR_OUT(-13318, done);
+    /* s[0] most recently used, s[1] least */
+    if (session_test_conn(t, &s[0], NULL, 1, &s[0]) != 1)
+        ERROR_OUT(-13319, done);
+    probe = wolfSSL_new(t->cli);
+    if (probe == NULL)
+        ERROR_OUT(-13320, done);
+    for (spins = 0; spins < SESSION_TEST_SPIN_MAX; spins++) {
+        if (wolfSSL_set_session(probe, &s[0]) != WOLFSSL_SUCCESS)
+            break;
+    }
+    if (spins == SESSION_TEST_SPIN_MAX)
+        ERROR_OUT(-13321, done);
+    if (session_test_conn(t, NULL, NULL, 0, &s[3]) != 0)
+        ERROR_OUT(-13322, done);
+    if (session_test_conn(t, &s[1], NULL, 0, NULL) != 1 ||
+            session_test_conn(t, &s[2], NULL, 0, NULL) != 1 ||
+            session_test_conn(t, &s[3], NULL, 0, NULL) != 1)
+        ERROR_OUT(-13323, done);
+    wolfSSL_free(probe);
+    probe = NULL;
+    session_test_cleanup(t);
+
+    /* back to the default size */
+    if (wolfSSL_SetSessionCacheSize(0, 0) != WOLFSSL_SUCCESS)
+        ERROR_OUT(-13324, done);
+
+    ret = 0;
+done:
+    wolfSSL_free(probe);
+    if (t->cli != NULL || t->srv != NULL) {
+        session_test_cleanup(t);
+        wolfSSL_SetSessionCacheSize(0, 0);
+    }
+    cm_test_pipes_free(t->pipes);
+    wc_ecc_free(&t->cert.key);
+    XFREE(t, CM_TEST_HEAP, DYNAMIC_TYPE_TMP_BUFFER);
+    wc_FreeRng(&rng);
+
+    return ret;
+}
+#endif /* WOLFSSL_SESSION_CACHE_SHARDED && CM_TEST_CERTS */
+
+#if defined(WOLFSSL_CRL_INDEX) && defined(HAVE_CRL) && defined(CM_TEST_CERTS)
+#define CRL_INDEX_TEST_BUF_SZ   1024
+#define CRL_INDEX_TEST_REVOKED  8
+#define CRL_INDEX_TEST_LEAVES   5
+#define CRL_INDEX_TEST_SER_SZ   3 /* revoked serial size */
+
+/* revoked serials, out of order so the CRL load sorts them. [4] is the first
+ * in order and [1] the last */
+static const byte crlIndexTestRevoked[CRL_INDEX_TEST_REVOKED]
+                                     [CRL_INDEX_TEST_SER_SZ] = {
+    { 0x40, 0x55, 0x00 }, { 0x7f, 0xff, 0xfe }, { 0x10, 0x55, 0x00 },
+    { 0x60, 0x55, 0x00 }, { 0x01, 0x00, 0x01 }, { 0x20, 0x55, 0x00 },
+    { 0x50, 0x55, 0x00 }, { 0x30, 0x55, 0x00 }
+};
+
+/* leaf serials, [0] and [1] are revoked at the ends of the table, the rest
+ * are good: between entries, shorter than all and longer than all */
+static const byte crlIndexTestLeaf[CRL_INDEX_TEST_LEAVES][4] = {
+    { 0x01, 0x00, 0x01 }, { 0x7f, 0xff, 0xfe }, { 0x40, 0x00, 0x00 },
+    { 0x01, 0x00 }, { 0x01, 0x00, 0x00, 0x00 }
+};
+static const int crlIndexTestLeafSz[CRL_INDEX_TEST_LEAVES] = { 3, 3, 3, 2, 4 };
+
+/* DER header for len < 0x10000, returns its size */
+static word32 crl_index_test_hdr(byte* out, byte tag, word32 len)
+{
+    word32 i = 0;
+
+    out[i++] = tag;
+    if (len >= 0x100) {
+        out[i++] = 0x82;
+        out[i++] = (byte)(len >> 8);
+    }
+    else if (len >= 0x80)
+        out[i++] = 0x81;
+    out[i++] = (byte)len;
+
+    return i;
+}
+
+/* Content length of the DER item at der + idx, sets its header size */
+static word32 crl_index_test_len(const byte* der, word32 idx, word32* hdrSz)
+{
+    word32 len = der[idx + 1];
+    word32 i, n = 0;
+
+    if (len & 0x80) {
+        n = len & 0x7f;
+        for (len = 0, i = 0; i < n; i++)
+            len = (len << 8) | der[idx + 2 + i];
+    }
+    *hdrSz = 2 + n;
+
+    return len;
+}
+
+/* Makes a DER CRL signed by the self signed ca revoking crlIndexTestRevoked,
+ * returns its size or < 0 */
+static int crl_index_test_crl(cm_test_cert* ca, WC_RNG* rng, byte* out)
+{
+    static const byte ecdsaSha256[] = {
+        0x30, 0x0a, 0x06, 0x08, 0x2a, 0x86, 0x48, 0xce, 0x3d, 0x04, 0x03, 0x02
+    };
+    static const char lastDate[] = "200101000000Z";   /* UTCTime */
+    static const char nextDate[] = "20991231000000Z"; /* GeneralizedTime */
+    byte   hash[WC_SHA256_DIGEST_SIZE];
+    byte   sig[ECC_MAX_SIG_SIZE];
+    word32 sigSz = sizeof(sig);
+    word32 nameIdx, nameSz, listSz, tbsSz, idx, hdrSz, i;
+    byte*  tbs = out + 4; /* room for the outer header */
+    int    ret;
+
+    /* issuer is the CA's own, after version, serial and signature algorithm
+     * in its TBS */
+    (void)crl_index_test_len(ca->der, 0, &hdrSz);
+    idx = hdrSz;
+    (void)crl_index_test_len(ca->der, idx, &hdrSz);
+    idx += hdrSz;
+    for (i = 0; i < 3; i++) {
+        word32 len = crl_index_test_len(ca->der, idx, &hdrSz);
+        idx += hdrSz + len;
+    }
+    nameIdx = idx;
+    nameSz = crl_index_test_len(ca->der, idx, &hdrSz);
+    nameSz += hdrSz;
+    if (nameIdx + nameSz > (word32)ca->derSz)
+        return -1;
+
+    listSz = CRL_INDEX_TEST_REVOKED * (2 + 2 + CRL_INDEX_TEST_SER_SZ + 2 + 13);
+    tbsSz = 3 + sizeof(ecdsaSha256) + nameSz + 2 + 13 + 2 + 15;
+    tbsSz += crl_index_test_hdr(hash, ASN_SEQUENCE | ASN_CONSTRUCTED, listSz);
+    tbsSz += listSz;
+
+    idx = crl_index_test_hdr(tbs, ASN_SEQUENCE | ASN_CONSTRUCTED, tbsSz);
+    tbs[idx++] = ASN_INTEGER; tbs[idx++] = 1; tbs[idx++] = 1; /* v2 */
+    XMEMCPY(tbs + idx, ecdsaSha256, sizeof(ecdsaSha256));
+    idx += sizeof(ecdsaSha256);
+    XMEMCPY(tbs + idx, ca->der + nameIdx, nameSz);
+    idx += nameSz;
+    idx += crl_index_test_hdr(tbs + idx, ASN_UTC_TIME, 13);
+    XMEMCPY(tbs + idx, lastDate, 13);
+    idx += 13;
+    idx += crl_index_test_hdr(tbs + idx, ASN_GENERALIZED_TIME, 15);
+    XMEMCPY(tbs + idx, nextDate, 15);
+    idx += 15;
+    idx += crl_index_test_hdr(tbs + idx, ASN_SEQUENCE | ASN_CONSTRUCTED, listSz);
+    for (i = 0; i < CRL_INDEX_TEST_REVOKED; i++) {
+        idx += crl_index_test_hdr(tbs + idx, ASN_SEQUENCE | ASN_CONSTRUCTED,
+                                  2 + CRL_INDEX_TEST_SER_SZ + 2 + 13);
+        idx += crl_index_test_hdr(tbs + idx, ASN_INTEGER,
+                                  CRL_INDEX_TEST_SER_SZ);
+        XMEMCPY(tbs + idx, crlIndexTestRevoked[i], CRL_INDEX_TEST_SER_SZ);
+        idx += CRL_INDEX_TEST_SER_SZ;
+        idx += crl_index_test_hdr(tbs + idx, ASN_UTC_TIME, 13);
+        XMEMCPY(tbs + idx, lastDate, 13);
+        idx += 13;
+    }
+
+    ret = wc_Sha256Hash(tbs, idx, hash);
+    if (ret == 0)
+        ret = wc_ecc_sign_hash(hash, sizeof(hash), sig, &sigSz, rng, &ca->key);
+    if (ret != 0)
+        return ret;
+
+    XMEMCPY(tbs + idx, ecdsaSha256, sizeof(ecdsaSha256));
+    idx += sizeof(ecdsaSha256);
+    idx += crl_index_test_hdr(tbs + idx, ASN_BIT_STRING, sigSz + 1);
+    tbs[idx++] = 0;
+    XMEMCPY(tbs + idx, sig, sigSz);
+    idx += sigSz;
+
+    hdrSz = crl_index_test_hdr(hash, ASN_SEQUENCE | ASN_CONSTRUCTED, idx);
+    XMEMMOVE(out + hdrSz, tbs, idx);
+    XMEMCPY(out, hash, hdrSz);
+
+    return (int)(idx + hdrSz);
+}
+
+/* Verifies the leaves, 0 when [0] and [1] are revoked and the rest good */
+static int crl_index_test_check(WOLFSSL_CERT_MANAGER* cm, cm_test_cert* leaf)
+{
+    int i, ret;
+
+    for (i = 0; i < CRL_INDEX_TEST_LEAVES; i++) {
+        ret = wolfSSL_CertManagerVerifyBuffer(cm, leaf[i].der, leaf[i].derSz,
+                                              WOLFSSL_FILETYPE_ASN1);
+        if (ret != ((i < 2) ? CRL_CERT_REVOKED : WOLFSSL_SUCCESS))
+            return -1;
+    }
+
+    return 0;
+}
+
+/* Revoked serial lookups at both ends of the sorted table and good ones
+ * around them, from the parsed CRL and from its saved index. Truncated,
+ * corrupt and unsorted indexes are rejected and leave no CRL loaded */
+int crl_index_test(void)
+{
+    int ret = 0, i, crlSz;
+    cm_test_cert* c;    /* [0] CA, [1..] leaves with crlIndexTestLeaf serials */
+    byte* crl;          /* DER CRL */
+    byte* index;        /* saved index */
+    byte* bad;          /* damaged index */
+    word32 indexSz = 0, tblIdx;
+    const RevokedSerial* tbl;
+    WOLFSSL_CERT_MANAGER* cm = NULL;
+    WC_RNG rng;
+
+    c = (cm_test_cert*)XMALLOC((1 + CRL_INDEX_TEST_LEAVES) *
+                    sizeof(cm_test_cert), CM_TEST_HEAP, DYNAMIC_TYPE_TMP_BUFFER);
+    crl = (byte*)XMALLOC(3 * CRL_INDEX_TEST_BUF_SZ, CM_TEST_HEAP,
+                         DYNAMIC_TYPE_TMP_BUFFER);
+    if (c == NULL || crl == NULL) {
+        XFREE(c, CM_TEST_HEAP, DYNAMIC_TYPE_TMP_BUFFER);
+        XFREE(crl, CM_TEST_HEAP, DYNAMIC_TYPE_TMP_BUFFER);
+        return -13400;
+    }
+    XMEMSET(c, 0, (1 + CRL_INDEX_TEST_LEAVES) * sizeof(cm_test_cert));
+    index = crl + CRL_INDEX_TEST_BUF_SZ;
+    bad = index + CRL_INDEX_TEST_BUF_SZ;
+#ifndef HAVE_FIPS
+    ret = wc_InitRng_ex(&rng, CM_TEST_HEAP, devId);
+#else
+    ret = wc_InitRng(&rng);
+#endif
+    if (ret != 0) {
+        XFREE(crl, CM_TEST_HEAP, DYNAMIC_TYPE_TMP_BUFFER);
+        XFREE(c, CM_TEST_HEAP, DYNAMIC_TYPE_TMP_BUFFER);
+        return -13401;
+    }
+    /* loading a CA makes a CTX, which would init the library for good */
+    wolfSSL_Init();
+
+    if (cm_test_make_cert(&c[0], "CRL Index Test CA", 1, 365, NULL, 1,
+                          &rng) != 0)
+        ERROR_OUT(-13402, done);
+    for (i = 0; i < CRL_INDEX_TEST_LEAVES; i++) {
+        if (cm_test_make_cert_ex(&c[1 + i], "CRL Index Leaf", 0, 365, &c[0],
+                1, crlIndexTestLeaf[i], crlIndexTestLeafSz[i], &rng) != 0)
+            ERROR_OUT(-13403, done);
+    }
+    crlSz = crl_index_test_crl(&c[0], &rng, crl);
+    if (crlSz <= 0 || crlSz > CRL_INDEX_TEST_BUF_SZ)
+        ERROR_OUT(-13404, done);
+
+    /* parsed CRL */
+    cm = wolfSSL_CertManagerNew_ex(CM_TEST_HEAP);
+    if (cm == NULL)
+        ERROR_OUT(-13405, done);
+    if (wolfSSL_CertManagerLoadCABuffer(cm, c[0].der, c[0].derSz,
+            WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS)
+        ERROR_OUT(-13406, done);
+    if (wolfSSL_CertManagerLoadCRLBuffer(cm, crl, crlSz,
+            WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS)
+        ERROR_OUT(-13407, done);
+    if (crl_index_test_check(cm, c + 1) != 0)
+        ERROR_OUT(-13408, done);
+
+    /* save, the table is last and sorted with the revoked leaves at its ends */
+    if (wolfSSL_CertManagerSaveCRLIndex(cm, NULL, &indexSz) != LENGTH_ONLY_E ||
+            indexSz > CRL_INDEX_TEST_BUF_SZ ||
+            indexSz < CRL_INDEX_TEST_REVOKED * sizeof(RevokedSerial))
+        ERROR_OUT(-13409, done);
+    if (wolfSSL_CertManagerSaveCRLIndex(cm, index, &indexSz) !=
+            WOLFSSL_SUCCESS)
+        ERROR_OUT(-13410, done);
+    tblIdx = indexSz - CRL_INDEX_TEST_REVOKED * sizeof(RevokedSerial);
+    tbl = (const RevokedSerial*)(index + tblIdx);
+    if (tbl[0].serialSz != CRL_INDEX_TEST_SER_SZ ||
+            XMEMCMP(tbl[0].serialNumber, crlIndexTestLeaf[0],
+                    CRL_INDEX_TEST_SER_SZ) != 0 ||
+            tbl[CRL_INDEX_TEST_REVOKED - 1].serialSz != CRL_INDEX_TEST_SER_SZ ||
+            XMEMCMP(tbl[CRL_INDEX_TEST_REVOKED - 1].serialNumber,
+                    crlIndexTestLeaf[1], CRL_INDEX_TEST_SER_SZ) != 0)
+        ERROR_OUT(-13411, done);
+    wolfSSL_CertManagerFree(cm);
+
+    /* index load into a new manager, no CRL parse */
+    cm = wolfSSL_CertManagerNew_ex(CM_TEST_HEAP);
+    if (cm == NULL)
+        ERROR_OUT(-13412, done);
+    if (wolfSSL_CertManagerLoadCABuffer(cm, c[0].der, c[0].derSz,
+            WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS)
+        ERROR_OUT(-13413, done);
+    if (wolfSSL_CertManagerLoadCRLIndex(cm, index, indexSz) !=
+            WOLFSSL_SUCCESS)
+        ERROR_OUT(-13414, done);
+    if (crl_index_test_check(cm, c + 1) != 0)
+        ERROR_OUT(-13415, done);
+    wolfSSL_CertManagerFree(cm);
+
+    /* broken indexes, each leaves the new manager without a CRL */
+    cm = wolfSSL_CertManagerNew_ex(CM_TEST_HEAP);
+    if (cm == NULL)
+        ERROR_OUT(-13416, done);
+    if (wolfSSL_CertManagerLoadCABuffer(cm, c[0].der, c[0].derSz,
+            WOLFSSL_FILETYPE_ASN1) != WOLFSSL_SUCCESS)
+        ERROR_OUT(-13417, done);
+    for (i = 0; i < 5; i++) {
+        RevokedSerial* badTbl = (RevokedSerial*)(bad + tblIdx);
+        word32 badSz = indexSz;
+        int expect = ASN_PARSE_E;
+
+        XMEMCPY(bad, index, indexSz);
+        switch (i) {
+            case 0: /* corrupt magic */
+                bad[0] ^= 0x80;
+                break;
+            case 1: /* shorter than a header */
+                badSz = 8;
+                break;
+            case 2: /* table cut short */
+                badSz = indexSz - 1;
+                expect = BUFFER_E;
+                break;
+            case 3: /* first and last swapped */
+                badTbl[0] = tbl[CRL_INDEX_TEST_REVOKED - 1];
+                badTbl[CRL_INDEX_TEST_REVOKED - 1] = tbl[0];
+                break;
+            default: /* serial too long */
+                badTbl[0].serialSz = EXTERNAL_SERIAL_SIZE + 1;
+                break;
+        }
+        if (wolfSSL_CertManagerLoadCRLIndex(cm, bad, badSz) != expect)
+            ERROR_OUT(-13418 - i, done);
+        if (wolfSSL_CertManagerVerifyBuffer(cm, c[1].der, c[1].derSz,
+                WOLFSSL_FILETYPE_ASN1) != CRL_MISSING)
+            ERROR_OUT(-13423 - i, done);
+    }
+
+    ret = 0;
+done:
+    wolfSSL_CertManagerFree(cm);
+    for (i = 0; i < 1 + CRL_INDEX_TEST_LEAVES; i++)
+        wc_ecc_free(&c[i].key);
+    XFREE(crl, CM_TEST_HEAP, DYNAMIC_TYPE_TMP_BUFFER);
+    XFREE(c, CM_TEST_HEAP, DYNAMIC_TYPE_TMP_BUFFER);
+    wc_FreeRng(&rng);
+    wolfSSL_Cleanup();
+
+    return ret;
+}
+#endif /* WOLFSSL_CRL_INDEX && HAVE_CRL && CM_TEST_CERTS */
+
+
+#ifndef NO_DH
+
+static int dh_fips_generate_test(WC_RNG *rng)
+{
+    int    ret = 0;
+    DhKey  key;
+    static byte p[] = {
+        0xc5, 0x7c, 0xa2, 0x4f, 0x4b, 0xd6, 0x8c, 0x3c,
+        0xda, 0xc7, 0xba, 0xaa, 0xea, 0x2e, 0x5c, 0x1e,
+        0x18, 0xb2, 0x7b, 0x8c, 0x55, 0x65, 0x9f, 0xea,
+        0xe0, 0xa1, 0x36, 0x53, 0x2b, 0x36, 0xe0, 0x4e,
+        0x3e, 0x64, 0xa9, 0xe4, 0xfc, 0x8f, 0x32, 0x62,
+        0x97, 0xe4, 0xbe, 0xf7, 0xc1, 0xde, 0x07, 0x5a,
+        0x89, 0x28, 0xf3, 0xfe, 0x4f, 0xfe, 0x68, 0xbc,
+        0xfb, 0x0a, 0x7c, 0xa4, 0xb3, 0x14, 0x48, 0x89,
+        0x9f, 0xaf, 0xb8, 0x43, 0xe2, 0xa0, 0x62, 0x5c,
+        0xb4, 0x88, 0x3f, 0x06, 0x50, 0x11, 0xfe, 0x65,
+        0x8d, 0x49, 0xd2, 0xf5, 0x4b, 0x74, 0x79, 0xdb,
+        0x06, 0x62, 0x92, 0x89, 0xed, 0xda, 0xcb, 0x87,
+        0x37, 0x16, 0xd2, 0xa1, 0x7a, 0xe8, 0xde, 0x92,
+        0xee, 0x3e, 0x41, 0x4a, 0x91, 0x5e, 0xed, 0xf3,
+        0x6c, 0x6b, 0x7e, 0xfd, 0x15, 0x92, 0x18, 0xfc,
+        0xa7, 0xac, 0x42, 0x85, 0x57, 0xe9, 0xdc, 0xda,
+        0x55, 0xc9, 0x8b, 0x28, 0x9e, 0xc1, 0xc4, 0x46,
+        0x4d, 0x88, 0xed, 0x62, 0x8e, 0xdb, 0x3f, 0xb9,
+        0xd7, 0xc8, 0xe3, 0xcf, 0xb8, 0x34, 0x2c, 0xd2,
+        0x6f, 0x28, 0x06, 0x41, 0xe3, 0x66, 0x8c, 0xfc,
+        0x72, 0xff, 0x26, 0x3b, 0x6b, 0x6c, 0x6f, 0x73,
+        0xde, 0xf2, 0x90, 0x29, 0xe0, 0x61, 0x32, 0xc4,
+        0x12, 0x74, 0x09, 0x52, 0xec, 0xf3, 0x1b, 0xa6,
+        0x45, 0x98, 0xac, 0xf9, 0x1c, 0x65, 0x8e, 0x3a,
+        0x91, 0x84, 0x4b, 0x23, 0x8a, 0xb2, 0x3c, 0xc9,
+        0xfa, 0xea, 0xf1, 0x38, 0xce, 0xd8, 0x05, 0xe0,
+        0xfa, 0x44, 0x68, 0x1f, 0xeb, 0xd9, 0x57, 0xb8,
+        0x4a, 0x97, 0x5b, 0x88, 0xc5, 0xf1, 0xbb, 0xb0,
+        0x49, 0xc3, 0x91, 0x7c, 0xd3, 0x13, 0xb9, 0x47,
+        0xbb, 0x91, 0x8f, 0xe5, 0x26, 0x07, 0xab, 0xa9,
+        0xc5, 0xd0, 0x3d, 0x95, 0x41, 0x26, 0x92, 0x9d,
+        0x13, 0x67, 0xf2, 0x7e, 0x11, 0x88, 0xdc, 0x2d
+    };
+    static byte g[] = {
+        0x4a, 0x1a, 0xf3, 0xa4, 0x92, 0xe9, 0xee, 0x74,
+        0x6e, 0x57, 0xd5, 0x8c, 0x2c, 0x5b, 0x41, 0x41,
+        0x5e, 0xd4, 0x55, 0x19, 0xdc, 0xd9, 0x32, 0x91,
+        0xf7, 0xfd, 0xc2, 0x57, 0xff, 0x03, 0x14, 0xdb,
+        0xf1, 0xb7, 0x60, 0x0c, 0x43, 0x59, 0x3f, 0xff,
+        0xac, 0xf1, 0x80, 0x9a, 0x15, 0x6f, 0xd8, 0x6e,
+        0xb7, 0x85, 0x18, 0xc8, 0xec, 0x4e, 0x59, 0x4a,
+        0xe2, 0x91, 0x43, 0x4c, 0xeb, 0x95, 0xb6, 0x2e,
+        0x9a, 0xea, 0x53, 0x68, 0x80, 0x64, 0x69, 0x40,
+        0xf9, 0xec, 0xbd, 0x85, 0x89, 0x26, 0x97, 0x67,
+        0xaf, 0xb0, 0xad, 0x00, 0x1b, 0xd4, 0xfd, 0x94,
+        0xd3, 0xe9, 0x92, 0xb1, 0xb4, 0xbc, 0x5a, 0xaa,
+        0x92, 0x80, 0x89, 0x3b, 0x39, 0x05, 0x6c, 0x22,
+        0x26, 0xfe, 0x5a, 0x28, 0x6c, 0x37, 0x50, 0x5a,
+        0x38, 0x99, 0xcf, 0xf3, 0xc1, 0x96, 0x45, 0xdc,
+        0x01, 0xcb, 0x20, 0x87, 0xa5, 0x00, 0x8c, 0xf5,
+        0x4d, 0xc2, 0xef, 0xb8, 0x9b, 0xd1, 0x87, 0xbe,
+        0xed, 0xd5, 0x0a, 0x29, 0x15, 0x34, 0x59, 0x4c,
+        0x3a, 0x05, 0x22, 0x05, 0x44, 0x4f, 0x9f, 0xc8,
+        0x47, 0x12, 0x24, 0x8e, 0xa8, 0x79, 0xe4, 0x67,
+        0xba, 0x4d, 0x5b, 0x75, 0x56, 0x95, 0xeb, 0xe8,
+        0x8a, 0xfa, 0x8e, 0x01, 0x8c, 0x1b, 0x74, 0x63,
+        0xd9, 0x2f, 0xf7, 0xd3, 0x44, 0x8f, 0xa8, 0xf5,
+        0xaf, 0x6c, 0x4f, 0xdb, 0xe7, 0xc9, 0x6c, 0x71,
+        0x22, 0xa3, 0x1d, 0xf1, 0x40, 0xb2, 0xe0, 0x9a,
+        0xb6, 0x72, 0xc9, 0xc0, 0x13, 0x16, 0xa2, 0x4a,
+        0xe1, 0x92, 0xc7, 0x54, 0x23, 0xab, 0x9d, 0xa1,
+        0xa1, 0xe5, 0x0b, 0xed, 0xba, 0xe8, 0x84, 0x37,
+        0xb2, 0xe7, 0xfe, 0x32, 0x8d, 0xfa, 0x1c, 0x53,
+        0x77, 0x97, 0xc7, 0xf3, 0x48, 0xc9, 0xdb, 0x2d,
+        0x75, 0x52, 0x9d, 0x42, 0x51, 0x78, 0x62, 0x68,
+        0x05, 0x45, 0x15, 0xf8, 0xa2, 0x4e, 0xf3, 0x0b
+    };
+    static byte q[] = {
+        0xe0, 0x35, 0x37, 0xaf, 0xb2, 0x50, 0x91, 0x8e,
+        0xf2, 0x62, 0x2b, 0xd9, 0x9f, 0x6c, 0x11, 0x75,
+        0xec, 0x24, 0x5d, 0x78, 0x59, 0xe7, 0x8d, 0xb5,
         0x40, 0x52, 0xed, 0x41
     };
     static byte q0[] = {
@@ -17558,6 +19503,50 @@ int pbkdf2_test(void)
     if (XMEMCMP(derived, verify, sizeof(verify)) != 0)
         return -9200;
 
+    {
+        /* several output blocks (RFC 7914 section 11), and a password and
+         * salt longer than the SHA-256 block */
+        static const byte verify2[] = {
+            0x55, 0xac, 0x04, 0x6e, 0x56, 0xe3, 0x08, 0x9f, 0xec, 0x16, 0x91, 0xc2,
+            0x25, 0x44, 0xb6, 0x05, 0xf9, 0x41, 0x85, 0x21, 0x6d, 0xde, 0x04, 0x65,
+            0xe6, 0x8b, 0x9d, 0x57, 0xc2, 0x0d, 0xac, 0xbc, 0x49, 0xca, 0x9c, 0xcc,
+            0xf1, 0x79, 0xb6, 0x45, 0x99, 0x16, 0x64, 0xb3, 0x9d, 0x77, 0xef, 0x31,
+            0x7c, 0x71, 0xb8, 0x45, 0xb1, 0xe3, 0x0b, 0xd5, 0x09, 0x11, 0x20, 0x41,
+            0xd3, 0xa1, 0x97, 0x83
+        };
+        static const byte verify3[] = {
+            0x84, 0xd4, 0x75, 0x07, 0x9f, 0xad, 0x1a, 0x9c, 0x5b, 0xb6, 0x7e, 0x6e,
+            0x6b, 0xc7, 0x38, 0x9f, 0x89, 0x7c, 0x62, 0xa0, 0xdf, 0xfa, 0x7c, 0x9e,
+            0x76, 0x53, 0x4c, 0x4d, 0x6f, 0xa2, 0x36, 0xdd, 0xb1, 0x0a, 0xa9, 0xa0,
+            0x2c, 0xbc, 0xcf, 0xf1, 0x68, 0x99, 0x50, 0xc5, 0xe5, 0x66, 0xd0, 0xbb,
+            0x26, 0x2e, 0x39, 0x98, 0x87, 0x88, 0xb6, 0x66, 0x4b, 0x59, 0x4c, 0xbf,
+            0x67, 0x53, 0xb1, 0x8b, 0x3f, 0x11, 0x52, 0xf0, 0x93, 0x62, 0x3c, 0x59,
+            0xbe, 0x6c, 0xae, 0xa8, 0x9d, 0xa4, 0xa2, 0xaf, 0xa4, 0x60, 0xb9, 0xe9,
+            0x2b, 0x16, 0x14, 0x84, 0x28, 0xe5, 0x87, 0x13, 0x8d, 0xbf, 0xf3, 0xd9,
+            0x00, 0xb2, 0x5f, 0x54
+        };
+        byte derived3[100];
+        char passwd3[] = "passwordPASSWORDpassword" "passwordPASSWORDpassword"
+                         "passwordPASSWORDpassword";
+        const char salt3[] = "saltSALTsaltSALTsaltSALTsaltSALTsalt"
+                             "saltSALTsaltSALTsaltSALTsaltSALTsalt";
+
+        ret = wc_PBKDF2_ex(derived, (byte*)"passwd", 6, (const byte*)"salt", 4,
+                           1, (int)sizeof(verify2), WC_SHA256, HEAP_HINT, devId);
+        if (ret != 0)
+            return ret;
+        if (XMEMCMP(derived, verify2, sizeof(verify2)) != 0)
+            return -9201;
+
+        ret = wc_PBKDF2_ex(derived3, (byte*)passwd3, (int)XSTRLEN(passwd3),
+                           (const byte*)salt3, (int)XSTRLEN(salt3), 4096,
+                           (int)sizeof(verify3), WC_SHA256, HEAP_HINT, devId);
+        if (ret != 0)
+            return ret;
+        if (XMEMCMP(derived3, verify3, sizeof(verify3)) != 0)
+            return -9202;
+    }
+
     return 0;
 
 }
@@ -20639,6 +22628,165 @@ static int ecc_test_nonblock(WC_RNG* rng)
 }
 #endif /* WC_ECC_NONBLOCK && WOLFSSL_PUBLIC_MP && HAVE_ECC_SIGN && HAVE_ECC_VERIFY */
 
+#if defined(HAVE_ECC_SIGN) && defined(HAVE_ECC_VERIFY) && !defined(NO_ASN) && \
+    !defined(WOLFSSL_ATECC508A) && !defined(WOLFSSL_ATECC608A)
+#define ECC_BATCH_TEST_CNT 18 /* more than one WC_ECC_VERIFY_BATCH_SZ */
+static int ecc_test_verify_batch(WC_RNG* rng)
+{
+    int ret;
+    int i, res[ECC_BATCH_TEST_CNT];
+    ecc_key key[3];
+    ecc_key* keys[ECC_BATCH_TEST_CNT];
+    byte hash[ECC_BATCH_TEST_CNT][MAX_ECC_BYTES];
+    byte sig[ECC_BATCH_TEST_CNT][ECC_MAX_SIG_SIZE];
+    const byte* hashes[ECC_BATCH_TEST_CNT];
+    const byte* sigs[ECC_BATCH_TEST_CNT];
+    word32 hashLen[ECC_BATCH_TEST_CNT];
+    word32 sigLen[ECC_BATCH_TEST_CNT];
+    int keyCnt = 2;
+
+    XMEMSET(key, 0, sizeof(key));
+    for (i = 0; i < 3; i++) {
+        ret = wc_ecc_init_ex(&key[i], HEAP_HINT, devId);
+        if (ret != 0)
+            ERROR_OUT(-9835, done);
+    }
+    ret = wc_ecc_make_key(rng, 32, &key[0]);
+    if (ret == 0)
+        ret = wc_ecc_make_key(rng, 32, &key[1]);
+#if defined(HAVE_ECC384) || defined(HAVE_ALL_CURVES)
+    if (ret == 0) {
+        ret = wc_ecc_make_key(rng, 48, &key[2]);
+        keyCnt = 3;
+    }
+#endif
+#if defined(WOLFSSL_ASYNC_CRYPT)
+    for (i = 0; ret == 0 && i < keyCnt; i++)
+        ret = wc_AsyncWait(ret, &key[i].asyncDev, WC_ASYNC_FLAG_NONE);
+#endif
+    if (ret != 0)
+        ERROR_OUT(-9836, done);
+
+    for (i = 0; i < ECC_BATCH_TEST_CNT; i++) {
+        keys[i] = &key[i % keyCnt];
+        hashLen[i] = (word32)wc_ecc_size(keys[i]);
+        XMEMSET(hash[i], (byte)(i + 1), hashLen[i]);
+        sigLen[i] = sizeof(sig[i]);
+        do {
+        #if defined(WOLFSSL_ASYNC_CRYPT)
+            ret = wc_AsyncWait(ret, &keys[i]->asyncDev,
+                                                WC_ASYNC_FLAG_CALL_AGAIN);
+        #endif
+            if (ret >= 0)
+                ret = wc_ecc_sign_hash(hash[i], hashLen[i], sig[i],
+                                       &sigLen[i], rng, keys[i]);
+        } while (ret == WC_PENDING_E);
+        if (ret != 0)
+            ERROR_OUT(-9837, done);
+        hashes[i] = hash[i];
+        sigs[i] = sig[i];
+    }
+
+    ret = wc_ecc_verify_hash_batch(sigs, sigLen, hashes, hashLen, res, keys,
+                                   ECC_BATCH_TEST_CNT);
+    if (ret != 0)
+        ERROR_OUT(-9838, done);
+    for (i = 0; i < ECC_BATCH_TEST_CNT; i++) {
+        if (res[i] != 1)
+            ERROR_OUT(-9839, done);
+    }
+
+    /* altered hash, truncated signature and wrong key */
+    hash[3][0] ^= 0x80;
+    sigLen[7] -= 2;
+    keys[8] = (keys[8] == &key[1]) ? &key[0] : &key[1];
+    ret = wc_ecc_verify_hash_batch(sigs, sigLen, hashes, hashLen, res, keys,
+                                   ECC_BATCH_TEST_CNT);
+    if (ret != 0)
+        ERROR_OUT(-9840, done);
+    for (i = 0; i < ECC_BATCH_TEST_CNT; i++) {
+        if (res[i] != (i != 3 && i != 7 && i != 8))
+            ERROR_OUT(-9841, done);
+    }
+
+    /* single signature and empty batch */
+    ret = wc_ecc_verify_hash_batch(sigs, sigLen, hashes, hashLen, res, keys, 1);
+    if (ret != 0 || res[0] != 1)
+        ERROR_OUT(-9842, done);
+    ret = wc_ecc_verify_hash_batch(NULL, NULL, NULL, NULL, NULL, NULL, 0);
+    if (ret != 0)
+        ERROR_OUT(-9843, done);
+    ret = wc_ecc_verify_hash_batch(sigs, sigLen, NULL, hashLen, res, keys, 1);
+    if (ret != BAD_FUNC_ARG && ret != ECC_BAD_ARG_E)
+        ERROR_OUT(-9844, done);
+    ret = 0;
+
+done:
+    for (i = 0; i < 3; i++)
+        wc_ecc_free(&key[i]);
+    return ret;
+}
+#endif /* HAVE_ECC_SIGN && HAVE_ECC_VERIFY && !NO_ASN */
+
+#if defined(WOLFSSL_SP_VERIFY_CACHE) && defined(HAVE_ECC_SIGN) && \
+    !defined(NO_ASN) && !defined(NO_ECC256)
+/* Public key table cache: table generated on the second verify with a key
+ * and used from the third */
+static int ecc_test_verify_cache(WC_RNG* rng)
+{
+    int ret, i, verify;
+    ecc_key key;
+    ecc_verify_cache_stats stats;
+    byte hash[32];
+    byte sig[ECC_MAX_SIG_SIZE];
+    word32 sigLen = sizeof(sig);
+
+    ret = wc_ecc_verify_cache_stats(ECC_SECP256R1, &stats, 1);
+    if (ret == NOT_COMPILED_IN)
+        return 0;
+    if (ret != 0)
+        return -9845;
+
+    ret = wc_ecc_init_ex(&key, HEAP_HINT, devId);
+    if (ret != 0)
+        return -9846;
+    ret = wc_ecc_make_key(rng, 32, &key);
+    if (ret != 0)
+        ERROR_OUT(-9847, done);
+    XMEMSET(hash, 0x5a, sizeof(hash));
+    ret = wc_ecc_sign_hash(hash, sizeof(hash), sig, &sigLen, rng, &key);
+    if (ret != 0)
+        ERROR_OUT(-9848, done);
+
+    for (i = 0; i < 4; i++) {
+        ret = wc_ecc_verify_hash(sig, sigLen, hash, sizeof(hash), &verify,
+                                 &key);
+        if (ret != 0 || verify != 1)
+            ERROR_OUT(-9849, done);
+    }
+    ret = wc_ecc_verify_cache_stats(ECC_SECP256R1, &stats, 0);
+    if (ret != 0 || stats.hits != 2 || stats.misses != 2 ||
+            stats.tables != 1 || stats.entries < 1)
+        ERROR_OUT(-9850, done);
+
+    /* wrong hash with the table */
+    hash[0] ^= 1;
+    ret = wc_ecc_verify_hash(sig, sigLen, hash, sizeof(hash), &verify, &key);
+    if (ret != 0 || verify != 0)
+        ERROR_OUT(-9851, done);
+
+    ret = wc_ecc_verify_cache_clear(ECC_SECP256R1);
+    if (ret == 0)
+        ret = wc_ecc_verify_cache_stats(ECC_SECP256R1, &stats, 1);
+    if (ret != 0 || stats.entries != 0)
+        ERROR_OUT(-9852, done);
+
+done:
+    wc_ecc_free(&key);
+    return ret;
+}
+#endif /* WOLFSSL_SP_VERIFY_CACHE && HAVE_ECC_SIGN && !NO_ASN */
+
 int ecc_test(void)
 {
     int ret;
@@ -20783,6 +22931,23 @@ int ecc_test(void)
     }
 #endif
 
+#if defined(HAVE_ECC_SIGN) && defined(HAVE_ECC_VERIFY) && !defined(NO_ASN) && \
+    !defined(WOLFSSL_ATECC508A) && !defined(WOLFSSL_ATECC608A)
+    ret = ecc_test_verify_batch(&rng);
+    if (ret != 0) {
+        printf("ecc_test_verify_batch failed!: %d\n", ret);
+        goto done;
+    }
+#endif
+#if defined(WOLFSSL_SP_VERIFY_CACHE) && defined(HAVE_ECC_SIGN) && \
+    !defined(NO_ASN) && !defined(NO_ECC256)
+    ret = ecc_test_verify_cache(&rng);
+    if (ret != 0) {
+        printf("ecc_test_verify_cache failed!: %d\n", ret);
+        goto done;
+    }
+#endif
+
 #if defined(WC_ECC_NONBLOCK) && defined(WOLFSSL_PUBLIC_MP) && \
     defined(HAVE_ECC_SIGN) && defined(HAVE_ECC_VERIFY)
     ret = ecc_test_nonblock(&rng);
@@ -40,6 +40,10 @@ WOLFSSL_LOCAL void FreeCRL(WOLFSSL_CRL*, int dynamic);
 WOLFSSL_LOCAL int  LoadCRL(WOLFSSL_CRL* crl, const char* path, int type, int mon);
 WOLFSSL_LOCAL int  BufferLoadCRL(WOLFSSL_CRL*, const byte*, long, int, int);
 WOLFSSL_LOCAL int  CheckCertCRL(WOLFSSL_CRL*, DecodedCert*);
+#ifdef WOLFSSL_CRL_INDEX
+WOLFSSL_LOCAL int  BufferLoadCRLIndex(WOLFSSL_CRL*, const byte*, long);
+WOLFSSL_LOCAL int  SaveCRLIndex(WOLFSSL_CRL*, byte*, word32*);
+#endif
 
 
 #ifdef __cplusplus
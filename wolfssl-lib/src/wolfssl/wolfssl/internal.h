@@ -1791,6 +1791,20 @@ enum {
     #define STATIC_BUFFER_LEN RECORD_HEADER_SZ
 #endif
 
+#ifdef WOLFSSL_SEND_COALESCE
+    #ifdef WOLFSSL_ASYNC_CRYPT
+        #error WOLFSSL_SEND_COALESCE does not support WOLFSSL_ASYNC_CRYPT
+    #endif
+    /* plain text bytes put into records before one send, at least a record */
+    #ifndef WOLFSSL_SEND_COALESCE_SZ
+        #define WOLFSSL_SEND_COALESCE_SZ (4 * MAX_RECORD_SIZE)
+    #endif
+    /* wolfSSL_writev() gathers straight into the record */
+    #if !defined(USE_WINDOWS_API) && !defined(NO_WRITEV)
+        #define WOLFSSL_SEND_IOV
+    #endif
+#endif
+
 typedef struct {
     ALIGN16 byte staticBuffer[STATIC_BUFFER_LEN];
     byte*  buffer;       /* place holder for static or dynamic buffer */
@@ -1912,6 +1926,10 @@ struct CRL_Entry {
     byte    nextDateFormat;          /* next date format */
     RevokedCert* certs;              /* revoked cert list  */
     int          totalCerts;         /* number on list     */
+#ifdef WOLFSSL_CRL_INDEX
+    RevokedSerial* serials;          /* sorted serials instead of certs */
+    byte    serialsMapped;           /* serials point into a loaded index */
+#endif
     int     verified;
     byte*   toBeSigned;
     word32  tbsSz;
@@ -1968,13 +1986,96 @@ struct WOLFSSL_CRL {
 #ifndef CA_TABLE_SIZE
     #define CA_TABLE_SIZE 11
 #endif
+#ifdef WOLFSSL_CA_INDEX
+/* Open addressed index of the signers in caTable, by subject key ID hash and
+ * by subject name hash, so lookups don't walk long rows with big trust
+ * stores. Lookups don't take caLock: writers fill empty slots or publish a
+ * bigger copy, and a replaced copy is kept until the CAs are unloaded.
+ * Lookups are counted while they probe, unload takes the index away and
+ * waits for them before freeing signers. A newer signer with the same hash
+ * takes the older one's slot, so the newest is found like in caTable. */
+#ifndef CA_INDEX_MIN_SZ
+    #define CA_INDEX_MIN_SZ 64 /* slots, power of 2 */
+#endif
+typedef struct CaIndex {
+    struct CaIndex* retired;  /* copy this one replaced */
+    word32          size;     /* slots in each table, power of 2 */
+    word32          count;    /* signers, at most half of size */
+#ifndef NO_SKID
+    Signer**        byKeyId;
+#endif
+    Signer**        byName;
+} CaIndex;
+
+#if defined(__GNUC__) && !defined(SINGLE_THREADED)
+    #define CA_INDEX_LOAD(p)     __atomic_load_n(&(p), __ATOMIC_ACQUIRE)
+    #define CA_INDEX_STORE(p, v) __atomic_store_n(&(p), (v), __ATOMIC_RELEASE)
+    /* unload waits here for lookups still probing the index */
+    #ifndef CA_INDEX_WAIT
+        #ifdef FREERTOS
+            #include "task.h"
+            #define CA_INDEX_WAIT() vTaskDelay(1)
+        #else
+            #define CA_INDEX_WAIT()
+        #endif
+    #endif
+    #define CA_INDEX_ENTER(cm, idx) do {                                      \
+        __atomic_add_fetch(&(cm)->caIndexReaders, 1, __ATOMIC_SEQ_CST);       \
+        (idx) = __atomic_load_n(&(cm)->caIndex, __ATOMIC_SEQ_CST);            \
+    } while (0)
+    #define CA_INDEX_LEAVE(cm)                                                \
+        __atomic_sub_fetch(&(cm)->caIndexReaders, 1, __ATOMIC_RELEASE)
+    #define CA_INDEX_DETACH(cm) do {                                          \
+        __atomic_store_n(&(cm)->caIndex, (CaIndex*)NULL, __ATOMIC_SEQ_CST);   \
+        while (__atomic_load_n(&(cm)->caIndexReaders, __ATOMIC_SEQ_CST) != 0) \
+            CA_INDEX_WAIT();                                                  \
+    } while (0)
+#else
+    #ifndef SINGLE_THREADED
+        #define CA_INDEX_LOCK_LOOKUP /* no atomics, lookups take caLock */
+    #endif
+    #define CA_INDEX_LOAD(p)     (p)
+    #define CA_INDEX_STORE(p, v) ((p) = (v))
+    #define CA_INDEX_ENTER(cm, idx) ((idx) = (cm)->caIndex)
+    #define CA_INDEX_LEAVE(cm)
+    #define CA_INDEX_DETACH(cm)     ((cm)->caIndex = NULL)
+#endif
+#endif /* WOLFSSL_CA_INDEX */
 #ifdef WOLFSSL_TRUST_PEER_CERT
     #define TP_TABLE_SIZE 11
 #endif
+#ifdef WOLFSSL_CHAIN_CACHE
+/* Peer chains that passed verification, keyed by the SHA-256 of the chain DER.
+ * When a peer sends the same chain again the intermediates aren't decoded and
+ * no signatures are checked. The leaf is still decoded, date, name and
+ * revocation checked each time. Not used when CRL or OCSP checks all the
+ * chain, and flushed when the CAs are unloaded. */
+#ifdef NO_SHA256
+    #error WOLFSSL_CHAIN_CACHE needs SHA-256
+#endif
+#ifndef WOLFSSL_CHAIN_CACHE_SZ
+    #define WOLFSSL_CHAIN_CACHE_SZ 16 /* chains */
+#endif
+typedef struct ChainCacheEntry {
+    byte   hash[WC_SHA256_DIGEST_SIZE]; /* of the key sizes and chain DER */
+#ifndef NO_ASN_TIME
+    byte   notAfter[MAX_DATE_SIZE];     /* first expiry in the chain */
+    byte   notAfterFormat;
+#endif
+#if defined(OPENSSL_EXTRA) || defined(OPENSSL_EXTRA_X509_SMALL)
+    char   untrustedDepth;
+#endif
+    word32 lastUse;                     /* 0 when the entry is free */
+} ChainCacheEntry;
+#endif /* WOLFSSL_CHAIN_CACHE */
 
 /* wolfSSL Certificate Manager */
 struct WOLFSSL_CERT_MANAGER {
     Signer*         caTable[CA_TABLE_SIZE]; /* the CA signer table */
+#ifdef WOLFSSL_CA_INDEX
+    CaIndex*        caIndex;             /* index of caTable signers */
+    int             caIndexReaders;      /* lookups probing caIndex */
+#endif
     void*           heap;                /* heap helper */
 #ifdef WOLFSSL_TRUST_PEER_CERT
     TrustedPeerCert* tpTable[TP_TABLE_SIZE]; /* table of trusted peer certs */
@@ -1996,6 +2097,12 @@ struct WOLFSSL_CERT_MANAGER {
     CbOCSPIO        ocspIOCb;            /* I/O callback for OCSP lookup */
     CbOCSPRespFree  ocspRespFreeCb;      /* Frees OCSP Response from IO Cb */
     wolfSSL_Mutex   caLock;              /* CA list lock */
+#ifdef WOLFSSL_CHAIN_CACHE
+    ChainCacheEntry chainCache[WOLFSSL_CHAIN_CACHE_SZ]; /* verified chains */
+    word32          chainCacheUse;       /* LRU clock */
+    word32          chainCacheHits;      /* peer chains found verified */
+    wolfSSL_Mutex   chainLock;           /* chain cache lock */
+#endif
     byte            crlEnabled;          /* is CRL on ? */
     byte            crlCheckAll;         /* always leaf, but all ? */
     byte            ocspEnabled;         /* is OCSP on ? */
@@ -2019,6 +2126,13 @@ WOLFSSL_LOCAL int CM_MemRestoreCertCache(WOLFSSL_CERT_MANAGER*, const void*, int
 WOLFSSL_LOCAL int CM_GetCertCacheMemSize(WOLFSSL_CERT_MANAGER*);
 WOLFSSL_LOCAL int CM_VerifyBuffer_ex(WOLFSSL_CERT_MANAGER* cm, const byte* buff,
                                     long sz, int format, int err_val);
+#ifdef WOLFSSL_CHAIN_CACHE
+WOLFSSL_LOCAL int  ChainCacheGet(WOLFSSL_CERT_MANAGER* cm, const byte* hash,
+                                 ChainCacheEntry* entry);
+WOLFSSL_LOCAL void ChainCacheAdd(WOLFSSL_CERT_MANAGER* cm,
+                                 const ChainCacheEntry* entry);
+WOLFSSL_LOCAL void ChainCacheFlush(WOLFSSL_CERT_MANAGER* cm);
+#endif
 
 
 #ifndef NO_CERTS
@@ -2041,6 +2155,9 @@ typedef struct ProcPeerCertArgs {
 #endif
 #if defined(OPENSSL_EXTRA) || defined(OPENSSL_EXTRA_X509_SMALL)
     char   untrustedDepth;
+#endif
+#ifdef WOLFSSL_CHAIN_CACHE
+    ChainCacheEntry chain; /* cache key and what to store on success */
 #endif
     word16 fatal:1;
     word16 verifyErr:1;
@@ -2048,6 +2165,10 @@ typedef struct ProcPeerCertArgs {
 #ifdef WOLFSSL_TRUST_PEER_CERT
     word16 haveTrustPeer:1; /* was cert verified by loaded trusted peer cert */
 #endif
+#ifdef WOLFSSL_CHAIN_CACHE
+    word16 chainCache:1;    /* chain may be looked up and stored */
+    word16 chainCached:1;   /* chain was verified before, skip signatures */
+#endif
 } ProcPeerCertArgs;
 WOLFSSL_LOCAL int DoVerifyCallback(WOLFSSL_CERT_MANAGER* cm, WOLFSSL* ssl,
         int ret, ProcPeerCertArgs* args);
@@ -3292,6 +3413,14 @@ typedef struct Buffers {
                                               when got WANT_WRITE            */
     int             plainSz;               /* plain text bytes in buffer to send
                                               when got WANT_WRITE            */
+#ifdef WOLFSSL_SEND_COALESCE
+    byte*           userOutput;            /* caller owned output region */
+    word32          userOutputSz;          /* size of caller output region */
+#endif
+#ifdef WOLFSSL_SEND_IOV
+    const struct iovec* sendIov;           /* wolfSSL_writev() vectors */
+    int             sendIovCnt;            /* number of vectors in sendIov */
+#endif
     byte            weOwnCert;             /* SSL own cert flag */
     byte            weOwnCertChain;        /* SSL own cert chain flag */
     byte            weOwnKey;              /* SSL own key  flag */
@@ -3858,7 +3987,11 @@ typedef struct BuildMsgArgs {
 #endif
 
 #ifdef WOLFSSL_ASYNC_CRYPT
-    #define MAX_ASYNC_ARGS 18
+    #ifdef WOLFSSL_CHAIN_CACHE
+        #define MAX_ASYNC_ARGS 40 /* ProcPeerCertArgs has a ChainCacheEntry */
+    #else
+        #define MAX_ASYNC_ARGS 18
+    #endif
     typedef void (*FreeArgsCb)(struct WOLFSSL* ssl, void* pArgs);
 
     struct WOLFSSL_ASYNC {
@@ -769,6 +769,14 @@ WOLFSSL_API int wolfSSL_CTX_is_static_memory(WOLFSSL_CTX* ctx,
                                                  WOLFSSL_MEM_STATS* mem_stats);
 WOLFSSL_API int wolfSSL_is_static_memory(WOLFSSL* ssl,
                                             WOLFSSL_MEM_CONN_STATS* mem_stats);
+#ifdef WOLFSSL_MEM_PROFILE
+#ifndef WOLFSSL_MEM_PROFILE_GUARD
+#define WOLFSSL_MEM_PROFILE_GUARD
+    typedef struct WOLFSSL_MEM_CONN_PROFILE WOLFSSL_MEM_CONN_PROFILE;
+#endif
+WOLFSSL_API int wolfSSL_GetMemProfile(WOLFSSL* ssl,
+                                            WOLFSSL_MEM_CONN_PROFILE* profile);
+#endif
 #endif
 
 #if !defined(NO_FILESYSTEM) && !defined(NO_CERTS)
@@ -2289,6 +2297,12 @@ WOLFSSL_API int wolfSSL_make_eap_keys(WOLFSSL*, void* key, unsigned int len,
     #endif
 #endif
 
+#ifdef WOLFSSL_SEND_COALESCE
+    /* caller owned region for outgoing records */
+    WOLFSSL_API int wolfSSL_SetOutputBuffer(WOLFSSL* ssl, unsigned char* buf,
+                                            unsigned int sz);
+#endif
+
 
 #ifndef NO_CERTS
     /* SSL_CTX versions */
@@ -2727,7 +2741,12 @@ WOLFSSL_API void* wolfSSL_GetRsaDecCtx(WOLFSSL* ssl);
                                                                  const char* d);
     WOLFSSL_API int wolfSSL_CertManagerLoadCABuffer(WOLFSSL_CERT_MANAGER*,
                                   const unsigned char* in, long sz, int format);
+    WOLFSSL_API int wolfSSL_CertManagerLoadCABundle(WOLFSSL_CERT_MANAGER*,
+                                  const unsigned char* in, long sz);
     WOLFSSL_API int wolfSSL_CertManagerUnloadCAs(WOLFSSL_CERT_MANAGER* cm);
+#ifdef WOLFSSL_CHAIN_CACHE
+    WOLFSSL_API int wolfSSL_CertManagerFlushChainCache(WOLFSSL_CERT_MANAGER* cm);
+#endif
 #ifdef WOLFSSL_TRUST_PEER_CERT
     WOLFSSL_API int wolfSSL_CertManagerUnload_trust_peers(WOLFSSL_CERT_MANAGER* cm);
 #endif
@@ -2753,6 +2772,12 @@ WOLFSSL_API void* wolfSSL_GetRsaDecCtx(WOLFSSL* ssl);
     WOLFSSL_API int wolfSSL_CertManagerSetCRL_IOCb(WOLFSSL_CERT_MANAGER*,
                                                                        CbCrlIO);
 #endif
+#ifdef WOLFSSL_CRL_INDEX
+    WOLFSSL_API int wolfSSL_CertManagerLoadCRLIndex(WOLFSSL_CERT_MANAGER*,
+                                                 const unsigned char*, long sz);
+    WOLFSSL_API int wolfSSL_CertManagerSaveCRLIndex(WOLFSSL_CERT_MANAGER*,
+                                                 unsigned char*, word32* sz);
+#endif
 #if defined(HAVE_OCSP)
     WOLFSSL_API int wolfSSL_CertManagerCheckOCSPResponse(WOLFSSL_CERT_MANAGER *,
         byte *response, int responseSz, WOLFSSL_BUFFER_INFO *responseBuffer,
@@ -3180,6 +3205,10 @@ typedef int (*HandShakeDoneCb)(WOLFSSL*, void*);
 WOLFSSL_API int wolfSSL_SetHsDoneCb(WOLFSSL*, HandShakeDoneCb, void*);
 
 
+#ifdef WOLFSSL_SESSION_CACHE_SHARDED
+WOLFSSL_API int wolfSSL_SetSessionCacheSize(unsigned int rows,
+                                            unsigned int sessionsPerRow);
+#endif
 WOLFSSL_API int wolfSSL_PrintSessionStats(void);
 WOLFSSL_API int wolfSSL_get_session_stats(unsigned int* active,
                                           unsigned int* total,
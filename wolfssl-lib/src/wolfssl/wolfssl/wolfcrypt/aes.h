@@ -72,7 +72,11 @@ block cipher mechanism that uses n-bit binary string parameter key with 128-bits
 
 
 #ifdef WOLFSSL_XILINX_CRYPT
-#include "xsecure_aes.h"
+#ifdef WOLFSSL_XILINX_CRYPT_MODEL
+    #include <wolfssl/wolfcrypt/port/xilinx/xil-model.h>
+#else
+    #include "xsecure_aes.h"
+#endif
 #endif
 
 #if defined(WOLFSSL_AFALG) || defined(WOLFSSL_AFALG_XILINX_AES)
@@ -121,6 +125,14 @@ enum {
     #include <wolfssl/wolfcrypt/async.h>
 #endif
 
+/* AArch64 AES-GCM processes 8 blocks at a time with AES rounds interleaved
+ * with GHASH, using precomputed powers of H */
+#if defined(HAVE_AESGCM) && defined(WOLFSSL_ARMASM) && \
+    defined(__aarch64__) && !defined(WOLFSSL_NO_AESGCM_STITCH)
+    #define WOLFSSL_AESGCM_STITCH
+    #define GCM_STITCH_BLOCKS 8
+#endif
+
 enum {
     AES_ENC_TYPE   = WC_CIPHER_AES,   /* cipher unique type */
     AES_ENCRYPTION = 0,
@@ -168,6 +180,9 @@ struct Aes {
 #endif
 #ifdef HAVE_AESGCM
     ALIGN16 byte H[AES_BLOCK_SIZE];
+#ifdef WOLFSSL_AESGCM_STITCH
+    ALIGN16 byte Hpow[GCM_STITCH_BLOCKS][AES_BLOCK_SIZE]; /* H^1 .. H^8 */
+#endif
 #ifdef OPENSSL_EXTRA
     word32 aadH[4]; /* additional authenticated data GHASH */
     word32 aadLen;  /* additional authenticated data len */
@@ -204,6 +219,8 @@ struct Aes {
     XCsuDma     dma;
     word32      key_init[8];
     word32      kup;
+    byte*       xilBuf;   /* output staging when tag is not after output */
+    word32      xilBufSz;
 #endif
 #if defined(WOLFSSL_AFALG) || defined(WOLFSSL_AFALG_XILINX_AES)
     int alFd; /* server socket to bind to */
@@ -1353,6 +1353,18 @@ struct RevokedCert {
     RevokedCert* next;
 };
 
+#ifdef WOLFSSL_CRL_INDEX
+/* Revoked serial in a CRL's sorted table, byte members only so a table can be
+ * used in place from a saved index */
+typedef struct RevokedSerial {
+    byte         serialSz;
+    byte         serialNumber[EXTERNAL_SERIAL_SIZE]; /* zero padded */
+} RevokedSerial;
+
+WOLFSSL_LOCAL int CompareRevokedSerial(const RevokedSerial* a,
+                                       const byte* serial, int serialSz);
+#endif
+
 typedef struct DecodedCRL DecodedCRL;
 
 struct DecodedCRL {
@@ -1369,6 +1381,9 @@ struct DecodedCRL {
     byte    nextDateFormat;          /* format of next date */
     RevokedCert* certs;              /* revoked cert list  */
     int          totalCerts;         /* number on list     */
+#ifdef WOLFSSL_CRL_INDEX
+    RevokedSerial* serials;          /* sorted table instead of certs */
+#endif
     void*   heap;
 #ifndef NO_SKID
     byte    extAuthKeyIdSet;
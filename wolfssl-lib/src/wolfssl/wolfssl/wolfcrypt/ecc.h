@@ -527,6 +527,38 @@ int wc_ecc_verify_hash(const byte* sig, word32 siglen, const byte* hash,
 WOLFSSL_API
 int wc_ecc_verify_hash_ex(mp_int *r, mp_int *s, const byte* hash,
                           word32 hashlen, int* stat, ecc_key* key);
+#ifndef NO_ASN
+/* Signatures verified together with one shared inversion (SP P-256/P-384) */
+#ifndef WC_ECC_VERIFY_BATCH_SZ
+    #define WC_ECC_VERIFY_BATCH_SZ 16
+#endif
+WOLFSSL_API
+int wc_ecc_verify_hash_batch(const byte** sig, const word32* siglen,
+                             const byte** hash, const word32* hashlen,
+                             int* stat, ecc_key** key, int n);
+#endif
+
+#ifdef WOLFSSL_SP_VERIFY_CACHE
+/* Pre-computed tables for the public keys used with SP P-256/P-384 verify */
+#ifndef WOLFSSL_SP_VERIFY_CACHE_SZ
+    #define WOLFSSL_SP_VERIFY_CACHE_SZ (128 * 1024) /* bytes per curve */
+#endif
+typedef struct ecc_verify_cache_stats {
+    word32 hits;       /* verifies with the table of the key */
+    word32 misses;     /* verifies without a table (first or second use) */
+    word32 tables;     /* tables generated */
+    word32 evictions;  /* keys replaced by another key */
+    word32 entries;    /* tables in cache */
+    word32 maxEntries; /* keys that fit in WOLFSSL_SP_VERIFY_CACHE_SZ */
+    word32 bytes;      /* size of the cache */
+} ecc_verify_cache_stats;
+
+WOLFSSL_API
+int wc_ecc_verify_cache_stats(int curve_id, ecc_verify_cache_stats* stats,
+                              int reset);
+WOLFSSL_API
+int wc_ecc_verify_cache_clear(int curve_id);
+#endif
 #endif /* HAVE_ECC_VERIFY */
 
 WOLFSSL_API
@@ -148,12 +148,25 @@ WOLFSSL_API int wolfSSL_GetAllocators(wolfSSL_Malloc_cb*,
     #define WOLFMEM_IO_POOL       0x02
     #define WOLFMEM_IO_POOL_FIXED 0x04
     #define WOLFMEM_TRACK_STATS   0x08
+    #define WOLFMEM_ARENA         0x10
+    #ifdef WOLFSSL_MEM_PROFILE
+    #define WOLFMEM_TRACK_PROFILE 0x20
+    #endif
+
+    /* size of each connection's handshake arena */
+    #ifndef WOLFMEM_ARENA_SZ
+        #define WOLFMEM_ARENA_SZ     32768
+    #endif
 
     #ifndef WOLFSSL_MEM_GUARD
     #define WOLFSSL_MEM_GUARD
         typedef struct WOLFSSL_MEM_STATS      WOLFSSL_MEM_STATS;
         typedef struct WOLFSSL_MEM_CONN_STATS WOLFSSL_MEM_CONN_STATS;
     #endif
+    #if defined(WOLFSSL_MEM_PROFILE) && !defined(WOLFSSL_MEM_PROFILE_GUARD)
+    #define WOLFSSL_MEM_PROFILE_GUARD
+        typedef struct WOLFSSL_MEM_CONN_PROFILE WOLFSSL_MEM_CONN_PROFILE;
+    #endif
 
     struct WOLFSSL_MEM_CONN_STATS {
         word32 peakMem;   /* peak memory usage    */
@@ -175,10 +188,52 @@ WOLFSSL_API int wolfSSL_GetAllocators(wolfSSL_Malloc_cb*,
         word32 blockSz[WOLFMEM_MAX_BUCKETS]; /* block sizes in stacks */
         word32 avaBlock[WOLFMEM_MAX_BUCKETS];/* ava block sizes */
         word32 usedBlock[WOLFMEM_MAX_BUCKETS];
+        word32 avaArena;  /* available handshake arenas */
         int    flag; /* flag used */
     };
 
+#ifdef WOLFSSL_MEM_PROFILE
+    #ifndef WOLFMEM_PROFILE_PHASES
+        #define WOLFMEM_PROFILE_PHASES 24
+    #endif
+    #ifndef WOLFMEM_PROFILE_SITES
+        #define WOLFMEM_PROFILE_SITES  48
+    #endif
+
+    typedef struct WOLFSSL_MEM_PHASE {
+        word32 alloc;     /* allocations made in the phase */
+        word32 bytes;     /* bytes allocated in the phase */
+        word32 peakMem;   /* peak memory usage during the phase */
+    } WOLFSSL_MEM_PHASE;
+
+    /* With WOLFSSL_DEBUG_MEMORY a site is a function and line, otherwise
+     * func is NULL and line is the DYNAMIC_TYPE_ of the allocation. Once the
+     * table is full the least used site is replaced and its counts carried
+     * over, so counts of late sites are upper bounds. */
+    typedef struct WOLFSSL_MEM_SITE {
+        const char* func;
+        word32 line;
+        word32 alloc;     /* allocations from the site */
+        word32 bytes;     /* bytes allocated from the site */
+        byte   phase;
+    } WOLFSSL_MEM_SITE;
+
+    /* allocations of one connection, phases are the connectState (client) or
+     * acceptState (server) values at the time of the allocation */
+    struct WOLFSSL_MEM_CONN_PROFILE {
+        WOLFSSL_MEM_PHASE phase[WOLFMEM_PROFILE_PHASES];
+        WOLFSSL_MEM_SITE  site[WOLFMEM_PROFILE_SITES];
+        word32 alloc;      /* total allocations */
+        word32 curMem;     /* current memory usage */
+        word32 peakMem;    /* peak memory usage */
+        word32 arenaAlloc; /* allocations from the handshake arena */
+        word32 arenaPeak;  /* most bytes used in the handshake arena */
+        word32 sysAlloc;   /* allocations from the system heap */
+    };
+#endif /* WOLFSSL_MEM_PROFILE */
+
     typedef struct wc_Memory wc_Memory; /* internal structure for mem bucket */
+    typedef struct wc_Arena  wc_Arena;  /* internal structure for an arena */
     typedef struct WOLFSSL_HEAP {
         wc_Memory* ava[WOLFMEM_MAX_BUCKETS];
         wc_Memory* io;                  /* list of buffers to use for IO */
@@ -192,6 +247,10 @@ WOLFSSL_API int wolfSSL_GetAllocators(wolfSSL_Malloc_cb*,
         word32     ioUse;
         word32     alloc; /* total number of allocs */
         word32     frAlc; /* total number of frees  */
+        wc_Arena*  arena;               /* list of free handshake arenas */
+        byte*      arenaBase;           /* memory the arenas were made from */
+        byte*      arenaEnd;
+        byte       general;             /* general buckets were loaded */
         int        flag;
         wolfSSL_Mutex memory_mutex;
     } WOLFSSL_HEAP;
@@ -204,6 +263,11 @@ WOLFSSL_API int wolfSSL_GetAllocators(wolfSSL_Malloc_cb*,
         WOLFSSL_MEM_CONN_STATS* stats;  /* hold individual connection stats */
         wc_Memory*  outBuf; /* set if using fixed io buffers */
         wc_Memory*  inBuf;
+        wc_Arena*   arena;  /* set if using a handshake arena */
+    #ifdef WOLFSSL_MEM_PROFILE
+        WOLFSSL_MEM_CONN_PROFILE* profile; /* set if profiling allocations */
+        const byte* phase;  /* handshake state of the connection */
+    #endif
         byte        haFlag; /* flag used for checking handshake count */
     } WOLFSSL_HEAP_HINT;
 
@@ -217,6 +281,8 @@ WOLFSSL_API int wolfSSL_GetAllocators(wolfSSL_Malloc_cb*,
                                                       WOLFSSL_MEM_STATS* stats);
     WOLFSSL_LOCAL int SetFixedIO(WOLFSSL_HEAP* heap, wc_Memory** io);
     WOLFSSL_LOCAL int FreeFixedIO(WOLFSSL_HEAP* heap, wc_Memory** io);
+    WOLFSSL_LOCAL int SetArena(WOLFSSL_HEAP* heap, wc_Arena** arena);
+    WOLFSSL_LOCAL int ReleaseArena(WOLFSSL_HEAP* heap, wc_Arena** arena);
 
     WOLFSSL_API int wolfSSL_StaticBufferSz(byte* buffer, word32 sz, int flag);
     WOLFSSL_API int wolfSSL_MemoryPaddingSz(void);
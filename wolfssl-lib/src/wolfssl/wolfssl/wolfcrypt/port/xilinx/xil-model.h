@@ -0,0 +1,124 @@
+/* xil-model.h
+ *
+ * Copyright (C) 2006-2020 wolfSSL Inc.
+ *
+ * This file is part of wolfSSL.
+ *
+ * wolfSSL is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfSSL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+/* Software model of the Xilinx xilsecure CSU engines used by the
+ * WOLFSSL_XILINX_CRYPT port. Building with WOLFSSL_XILINX_CRYPT_MODEL replaces
+ * the Xilinx BSP headers (xsecure_aes.h, xsecure_sha.h, xparameters.h) with
+ * this one so the hardware code paths, wolfCrypt test and benchmark can be
+ * run on a host. Only the calls used by the port are provided and RSA is not
+ * modeled (build with NO_RSA). */
+
+#ifndef WOLF_XIL_CRYPT_MODEL_H
+#define WOLF_XIL_CRYPT_MODEL_H
+
+#ifdef WOLFSSL_XILINX_CRYPT_MODEL
+
+#include <wolfssl/wolfcrypt/types.h>
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+typedef unsigned char  u8;
+typedef unsigned short u16;
+typedef unsigned int   u32;
+typedef int            s32;
+typedef unsigned long  UINTPTR;
+
+#define XST_SUCCESS                       0L
+#define XST_FAILURE                       1L
+
+#define XSECURE_CSU_AES_KEY_SRC_KUP       0x0U
+#define XSECURE_CSU_AES_KEY_SRC_DEV       0x1U
+#define XSECURE_CSU_AES_GCM_TAG_MISMATCH  1L
+#define XSECURE_SECURE_GCM_TAG_SIZE       16U
+
+/* CSU DMA */
+typedef struct XCsuDma_Config {
+    u16     DeviceId;
+    UINTPTR BaseAddress;
+} XCsuDma_Config;
+
+typedef struct XCsuDma {
+    XCsuDma_Config Config;
+    u32            IsReady;
+} XCsuDma;
+
+WOLFSSL_LOCAL XCsuDma_Config* XCsuDma_LookupConfig(u16 DeviceId);
+WOLFSSL_LOCAL s32 XCsuDma_CfgInitialize(XCsuDma* InstancePtr,
+    XCsuDma_Config* CfgPtr, UINTPTR EffectiveAddr);
+
+/* CSU AES-GCM (256-bit key, 96-bit IV, no AAD) */
+typedef struct XSecure_Aes {
+    XCsuDma* CsuDmaPtr;
+    u32      KeySel;
+    u32*     Iv;
+    u32*     Key;
+    u8*      Destination;   /* output of the current operation */
+    u8*      GcmTag;        /* expected tag when decrypting */
+    u32      SizeofData;    /* total size set by Encrypt/DecryptInit */
+    u32      Done;          /* bytes processed so far */
+    u8       Ctr[16];
+    u8       Ghash[16];
+    u8       H[16];
+    u8       Ej0[16];
+} XSecure_Aes;
+
+WOLFSSL_LOCAL s32 XSecure_AesInitialize(XSecure_Aes* InstancePtr,
+    XCsuDma* CsuDmaPtr, u32 KeySel, u32* Iv, u32* Key);
+WOLFSSL_LOCAL s32 XSecure_AesEncryptInit(XSecure_Aes* InstancePtr,
+    u8* EncData, u32 Size);
+WOLFSSL_LOCAL s32 XSecure_AesEncryptUpdate(XSecure_Aes* InstancePtr,
+    const u8* Data, u32 Size);
+WOLFSSL_LOCAL s32 XSecure_AesEncryptData(XSecure_Aes* InstancePtr, u8* Dst,
+    const u8* Src, u32 Len);
+WOLFSSL_LOCAL s32 XSecure_AesDecryptInit(XSecure_Aes* InstancePtr,
+    u8* DecData, u32 Size, u8* GcmTagAddr);
+WOLFSSL_LOCAL s32 XSecure_AesDecryptUpdate(XSecure_Aes* InstancePtr,
+    u8* EncData, u32 Size);
+WOLFSSL_LOCAL s32 XSecure_AesDecryptData(XSecure_Aes* InstancePtr, u8* Dst,
+    const u8* Src, u32 Len, u8* Tag);
+
+/* CSU SHA3-384 */
+#define XSECURE_SHA3_HASH_LENGTH_IN_BITS  384U
+
+typedef struct XSecure_Sha3 {
+    XCsuDma* CsuDmaPtr;
+    word64   State[25];
+    u8       Partial[104];  /* SHA3-384 rate */
+    u32      PartialLen;
+    u32      Started;
+} XSecure_Sha3;
+
+WOLFSSL_LOCAL s32 XSecure_Sha3Initialize(XSecure_Sha3* InstancePtr,
+    XCsuDma* CsuDmaPtr);
+WOLFSSL_LOCAL void XSecure_Sha3Start(XSecure_Sha3* InstancePtr);
+WOLFSSL_LOCAL u32 XSecure_Sha3Update(XSecure_Sha3* InstancePtr, const u8* Data,
+    const u32 Size);
+WOLFSSL_LOCAL u32 XSecure_Sha3Finish(XSecure_Sha3* InstancePtr, u8* Hash);
+WOLFSSL_LOCAL void XSecure_Sha3_ReadHash(XSecure_Sha3* InstancePtr, u8* Hash);
+
+#ifdef __cplusplus
+    } /* extern "C" */
+#endif
+
+#endif /* WOLFSSL_XILINX_CRYPT_MODEL */
+#endif /* WOLF_XIL_CRYPT_MODEL_H */
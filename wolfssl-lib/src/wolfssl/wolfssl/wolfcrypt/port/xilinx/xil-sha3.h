@@ -24,18 +24,50 @@
 #define WOLF_XIL_CRYPT_SHA3_H
 
 #ifdef WOLFSSL_SHA3
-#include "xsecure_sha.h"
+#ifdef WOLFSSL_XILINX_CRYPT_MODEL
+    #include <wolfssl/wolfcrypt/port/xilinx/xil-model.h>
+#else
+    #include "xsecure_sha.h"
+#endif
 
 #ifdef __cplusplus
     extern "C" {
 #endif
 
-/* Sha3 digest */
+/* Software SHA3-384 state (Keccak code of sha3.c), used while another
+ * context streams to the engine */
+typedef struct wc_Sha3Sw {
+    word64 s[25];
+    byte   t[WC_SHA3_384_COUNT * 8];
+    byte   i;
+} wc_Sha3Sw;
+
+/* Sha3 digest
+ *
+ * The CSU has one SHA3 engine and its state can not be read back. Messages
+ * up to WOLFSSL_XILINX_SHA3_BUF_MAX are kept in the context and only run
+ * through the engine on Final / GetHash, so contexts can be copied and share
+ * the engine. A larger message streams to the engine, which it then holds
+ * until Final or Free. While the engine is held, other contexts hash in
+ * software (sw) instead of waiting on it. */
 typedef struct Sha3 {
     XSecure_Sha3 hw;
     XCsuDma      dma;
+    void*        heap;
+    byte*        msg;       /* buffered message */
+    word32       msgSz;
+    word32       msgMax;    /* allocated size of msg */
+    byte         tail[4];   /* streaming, engine is fed whole words */
+    word32       tailSz;
+    int          streaming; /* SHA3_XIL_STREAM_HW or _SW when not buffered */
+    wc_Sha3Sw    sw;
 } wc_Sha3;
 
+WOLFSSL_LOCAL int wc_Sha3Sw_Init(wc_Sha3Sw* sha3);
+WOLFSSL_LOCAL int wc_Sha3Sw_Update(wc_Sha3Sw* sha3, const byte* data,
+                                   word32 len);
+WOLFSSL_LOCAL int wc_Sha3Sw_Final(wc_Sha3Sw* sha3, byte* hash);
+
 #ifdef __cplusplus
     } /* extern "C" */
 #endif
@@ -1529,7 +1529,8 @@ extern void uITRON4_free(void *p) ;
         #define WOLFSSL_NOSHA3_256
         #define WOLFSSL_NOSHA3_512
     #endif
-    #ifdef WOLFSSL_AFALG_XILINX_AES
+    #if defined(WOLFSSL_AFALG_XILINX_AES) || defined(WOLFSSL_XILINX_CRYPT)
+        /* used for GMAC (no data) and by the host model of the engine */
         #undef  WOLFSSL_AES_DIRECT
         #define WOLFSSL_AES_DIRECT
     #endif
@@ -199,6 +199,19 @@ WOLFSSL_API int wc_Sha256Copy(wc_Sha256* src, wc_Sha256* dst);
 WOLFSSL_API void wc_Sha256SizeSet(wc_Sha256*, word32);
 #endif
 
+#ifdef WOLFSSL_SHA256_MULTI
+/* Multi-buffer SHA-256: hashes n independent contexts. With ARMv8 crypto
+ * extensions the blocks of up to WC_SHA256_MULTI_LANES contexts are gathered
+ * and transformed two at a time with the instructions interleaved. Each
+ * context is left in the same state as wc_Sha256Update/Final would leave it */
+#ifndef WC_SHA256_MULTI_LANES
+    #define WC_SHA256_MULTI_LANES 4
+#endif
+WOLFSSL_API int wc_Sha256MultiUpdate(wc_Sha256** sha256, const byte** data,
+                                     const word32* len, int n);
+WOLFSSL_API int wc_Sha256MultiFinal(wc_Sha256** sha256, byte** hash, int n);
+#endif
+
 #if defined(WOLFSSL_HASH_FLAGS) || defined(WOLF_CRYPTO_CB)
     WOLFSSL_API int wc_Sha256SetFlags(wc_Sha256* sha256, word32 flags);
     WOLFSSL_API int wc_Sha256GetFlags(wc_Sha256* sha256, word32* flags);
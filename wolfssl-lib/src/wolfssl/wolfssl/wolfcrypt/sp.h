@@ -154,6 +154,31 @@ int sp_ecc_verify_384_nb(sp_ecc_ctx_t* ctx, const byte* hash, word32 hashLen, mp
                       mp_int* pZ, mp_int* r, mp_int* sm, int* res, void* heap);
 #endif /* WOLFSSL_SP_NONBLOCK */
 
+/* Batch verify with one shared inversion - 64-bit C and ARM64 code only */
+#if !defined(WOLFSSL_SP_NO_MALLOC) && (defined(WOLFSSL_SP_ARM64_ASM) || \
+    (!defined(WOLFSSL_SP_ASM) && SP_WORD_SIZE == 64))
+    #define WOLFSSL_SP_VERIFY_BATCH
+
+int sp_ecc_verify_256_batch(int n, const byte** hash, const word32* hashLen,
+    mp_int** pX, mp_int** pY, mp_int** pZ, mp_int** r, mp_int** sm, int* res,
+    void* heap);
+int sp_ecc_verify_384_batch(int n, const byte** hash, const word32* hashLen,
+    mp_int** pX, mp_int** pY, mp_int** pZ, mp_int** r, mp_int** sm, int* res,
+    void* heap);
+#endif
+
+/* Cache of tables for verify public keys - 64-bit C and ARM64 code only */
+#if defined(WOLFSSL_SP_VERIFY_CACHE) && !defined(WOLFSSL_SP_SMALL) && \
+    (defined(WOLFSSL_SP_ARM64_ASM) || \
+    (!defined(WOLFSSL_SP_ASM) && SP_WORD_SIZE == 64))
+    #define WOLFSSL_SP_HAVE_VERIFY_CACHE
+
+int sp_ecc_verify_cache_stats_256(ecc_verify_cache_stats* stats, int reset);
+int sp_ecc_verify_cache_stats_384(ecc_verify_cache_stats* stats, int reset);
+void sp_ecc_verify_cache_clear_256(void);
+void sp_ecc_verify_cache_clear_384(void);
+#endif
+
 #endif /* WOLFSSL_HAVE_SP_ECC */
 
 
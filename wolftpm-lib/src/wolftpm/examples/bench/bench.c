@@ -24,6 +24,9 @@
 
 #include <wolftpm/tpm2.h>
 #include <wolftpm/tpm2_wrap.h>
+#ifdef WOLFTPM_SWTPM
+#include <wolftpm/tpm2_swtpm.h>
+#endif
 
 #if !defined(WOLFTPM2_NO_WRAPPER) && !defined(NO_TPM_BENCH)
 
@@ -121,6 +124,72 @@ static void bench_stats_asym_finish(const char* algo, int strength,
         count, total, milliEach, opsSec);
 }
 
+#ifdef WOLFTPM_SWTPM
+/* Simulator command latency with the kept connection and with a new
+ * connection for each command */
+static int bench_swtpm(WOLFTPM2_DEV* dev, byte* buf, int bufSz)
+{
+    int rc = 0;
+    int count;
+    int reconnect;
+    double start, total;
+
+    for (reconnect = 0; reconnect <= 1; reconnect++) {
+        bench_stats_start(&count, &start);
+        do {
+            rc = wolfTPM2_GetRandom(dev, buf, bufSz);
+            if (rc == 0 && reconnect)
+                rc = TPM2_SWTPM_Disconnect(&dev->ctx);
+            if (rc != 0) goto exit;
+        } while (bench_stats_check(start, &count, TPM2_BENCH_DURATION_SEC));
+        total = gettime_secs(0) - start;
+        printf("SWTPM %-10s %6d cmds took %5.3f sec, avg %6.3f ms,"
+            " %.3f cmds/sec\n", reconnect ? "connect" : "kept", count, total,
+            total * 1000 / count, count / total);
+    }
+
+exit:
+    return rc;
+}
+#endif /* WOLFTPM_SWTPM */
+
+/* Command rate for a small authorized command (hash sequence update). Run
+ * with -aes or -xor to include the session HMAC and parameter encryption */
+static int bench_session(WOLFTPM2_DEV* dev, TPM_ALG_ID paramEncAlg,
+    const byte* in, word32 inSz)
+{
+    int rc;
+    int count;
+    double start, total;
+    WOLFTPM2_HASH hash;
+    byte digest[TPM_SHA256_DIGEST_SIZE];
+    word32 digestSz = (word32)sizeof(digest);
+
+    XMEMSET(&hash, 0, sizeof(hash));
+    rc = wolfTPM2_HashStart(dev, &hash, TPM_ALG_SHA256,
+        (const byte*)gUsageAuth, sizeof(gUsageAuth)-1);
+    if (rc != 0) return rc;
+
+    bench_stats_start(&count, &start);
+    do {
+        rc = wolfTPM2_HashUpdate(dev, &hash, in, inSz);
+        if (rc != 0) goto exit;
+    } while (bench_stats_check(start, &count, TPM2_BENCH_DURATION_SEC));
+    total = gettime_secs(0) - start;
+    printf("Session %-4s %-6s %6d cmds took %5.3f sec, avg %6.3f ms,"
+        " %.3f cmds/sec\n", TPM2_GetAlgName(paramEncAlg),
+    #ifdef WOLFTPM_SESSION_CACHE
+        "cached",
+    #else
+        "",
+    #endif
+        count, total, total * 1000 / count, count / total);
+
+exit:
+    wolfTPM2_HashFinish(dev, &hash, digest, &digestSz);
+    return rc;
+}
+
 static int bench_sym_hash(WOLFTPM2_DEV* dev, const char* desc, int algo,
     const byte* in, word32 inSz, byte* digest, word32 digestSz)
 {
@@ -182,6 +251,79 @@ exit:
     return rc;
 }
 
+#ifdef WOLFTPM_KEY_CACHE
+#define TPM2_BENCH_CACHE_KEYS 8
+/* Sign in turn with more keys than the TPM has transient slots. Loading the
+ * key blob for each sign is compared with the key slot manager */
+static int bench_keycache(WOLFTPM2_DEV* dev, WOLFTPM2_KEY* storageKey,
+    TPMT_PUBLIC* publicTemplate, const byte* digest, int digestSz)
+{
+    int rc = 0;
+    int i, count;
+    double start;
+    static WOLFTPM2_KEY_CACHE cache;
+    static WOLFTPM2_KEYBLOB blob[TPM2_BENCH_CACHE_KEYS];
+    static WOLFTPM2_KEY key[TPM2_BENCH_CACHE_KEYS];
+    WOLFTPM2_KEY_CACHE_STATS stats;
+    WOLFTPM2_KEY signKey;
+    byte sig[MAX_ECC_BYTES * 2];
+    int sigSz;
+
+    XMEMSET(key, 0, sizeof(key));
+    for (i = 0; i < TPM2_BENCH_CACHE_KEYS; i++) {
+        rc = wolfTPM2_CreateKey(dev, &blob[i], &storageKey->handle,
+            publicTemplate, (byte*)gKeyAuth, sizeof(gKeyAuth)-1);
+        if (rc != 0) goto exit;
+    }
+
+    bench_stats_start(&count, &start);
+    do {
+        rc = wolfTPM2_LoadKey(dev, &blob[count % TPM2_BENCH_CACHE_KEYS],
+            &storageKey->handle);
+        if (rc != 0) goto exit;
+        XMEMCPY(&signKey, &blob[count % TPM2_BENCH_CACHE_KEYS],
+            sizeof(WOLFTPM2_KEY));
+        sigSz = (int)sizeof(sig);
+        rc = wolfTPM2_SignHash(dev, &signKey, digest, digestSz, sig, &sigSz);
+        wolfTPM2_UnloadHandle(dev, &signKey.handle);
+        if (rc != 0) goto exit;
+    } while (bench_stats_check(start, &count, TPM2_BENCH_DURATION_SEC));
+    bench_stats_asym_finish("ECDSA", 256, "load sign", count, start);
+
+    rc = wolfTPM2_KeyCacheInit(dev, &cache, 0);
+    if (rc != 0) goto exit;
+    for (i = 0; i < TPM2_BENCH_CACHE_KEYS; i++) {
+        rc = wolfTPM2_LoadKey(dev, &blob[i], &storageKey->handle);
+        if (rc != 0) goto exit;
+        XMEMCPY(&key[i], &blob[i], sizeof(WOLFTPM2_KEY));
+        rc = wolfTPM2_KeyCacheAdd(dev, &key[i]);
+        if (rc != 0) goto exit;
+    }
+
+    bench_stats_start(&count, &start);
+    do {
+        sigSz = (int)sizeof(sig);
+        rc = wolfTPM2_SignHash(dev, &key[count % TPM2_BENCH_CACHE_KEYS],
+            digest, digestSz, sig, &sigSz);
+        if (rc != 0) goto exit;
+    } while (bench_stats_check(start, &count, TPM2_BENCH_DURATION_SEC));
+    bench_stats_asym_finish("ECDSA", 256, "lru sign", count, start);
+
+    rc = wolfTPM2_KeyCacheGetStats(dev, &stats);
+    if (rc != 0) goto exit;
+    printf("Key cache: %d keys, %u evictions, %u saves, %u reloads, %u hits\n",
+        TPM2_BENCH_CACHE_KEYS, stats.evictions, stats.saves, stats.reloads,
+        stats.hits);
+
+exit:
+    for (i = 0; i < TPM2_BENCH_CACHE_KEYS; i++) {
+        wolfTPM2_UnloadHandle(dev, &key[i].handle);
+    }
+    wolfTPM2_KeyCacheCleanup(dev);
+    return rc;
+}
+#endif /* WOLFTPM_KEY_CACHE */
+
 static void usage(void)
 {
     printf("Expected usage:\n");
@@ -271,6 +413,16 @@ int TPM2_Wrapper_BenchArgs(void* userCtx, int argc, char *argv[])
     } while (bench_stats_check(start, &count, TPM2_BENCH_DURATION_SEC));
     bench_stats_sym_finish("RNG", count, sizeof(message.buffer), start);
 
+    /* Authorized command rate */
+    rc = bench_session(&dev, paramEncAlg, message.buffer, 32);
+    if (rc != 0) goto exit;
+
+#ifdef WOLFTPM_SWTPM
+    /* Simulator transport */
+    rc = bench_swtpm(&dev, message.buffer, 32);
+    if (rc != 0) goto exit;
+#endif
+
     /* AES Benchmarks */
     /* AES CBC */
     rc = bench_sym_aes(&dev, &storageKey, "AES-128-CBC-enc", TPM_ALG_CBC, 128,
@@ -441,6 +593,13 @@ int TPM2_Wrapper_BenchArgs(void* userCtx, int argc, char *argv[])
     rc = wolfTPM2_UnloadHandle(&dev, &eccKey.handle);
     if (rc != 0) goto exit;
 
+#ifdef WOLFTPM_KEY_CACHE
+    /* More ECDSA keys than transient slots */
+    rc = bench_keycache(&dev, &storageKey, &publicTemplate, message.buffer,
+        message.size);
+    if (rc != 0) goto exit;
+#endif
+
 
     /* Create an ECC key for ECDH */
     rc = wolfTPM2_GetKeyTemplate_ECC(&publicTemplate,
@@ -42,7 +42,7 @@ static volatile int gWolfCryptRefCount = 0;
 #define TPM2_INTERNAL_CLEANUP(ctx)
 #elif defined(WOLFTPM_SWTPM)
 #define INTERNAL_SEND_COMMAND      TPM2_SWTPM_SendCommand
-#define TPM2_INTERNAL_CLEANUP(ctx)
+#define TPM2_INTERNAL_CLEANUP(ctx) TPM2_SWTPM_Disconnect(ctx)
 #elif defined(WOLFTPM_WINAPI)
 #define INTERNAL_SEND_COMMAND      TPM2_WinApi_SendCommand
 #define TPM2_INTERNAL_CLEANUP(ctx) TPM2_WinApi_Cleanup(ctx)
@@ -54,12 +54,35 @@ static volatile int gWolfCryptRefCount = 0;
 /******************************************************************************/
 /* --- Local Functions -- */
 /******************************************************************************/
+
+/* Microsecond time source for command statistics. Wraps every ~71 min, only
+ * differences are used */
+#if defined(WOLFTPM_STATS) && !defined(XTPM_TIME_US)
+    #if defined(XTPM_ASYNC_TIME_US)
+        #define XTPM_TIME_US() XTPM_ASYNC_TIME_US()
+    #elif defined(__linux__) || defined(__APPLE__) || defined(__unix__)
+        #include <sys/time.h>
+        static word32 TPM2_TimeUs(void)
+        {
+            struct timeval tv;
+            gettimeofday(&tv, NULL);
+            return (word32)(tv.tv_sec * 1000000 + tv.tv_usec);
+        }
+        #define XTPM_TIME_US() TPM2_TimeUs()
+    #else
+        #define XTPM_TIME_US() 0 /* no statistics timing */
+    #endif
+#endif
+
 static TPM_RC TPM2_AcquireLock(TPM2_CTX* ctx)
 {
 #if defined(WOLFTPM2_NO_WOLFCRYPT) || defined(SINGLE_THREADED)
     (void)ctx;
 #else
     int ret;
+#ifdef WOLFTPM_STATS
+    word32 startUs = (ctx->stats != NULL) ? XTPM_TIME_US() : 0;
+#endif
 
     if (!ctx->hwLockInit) {
         if (wc_InitMutex(&ctx->hwLock) != 0) {
@@ -72,6 +95,10 @@ static TPM_RC TPM2_AcquireLock(TPM2_CTX* ctx)
     ret = wc_LockMutex(&ctx->hwLock);
     if (ret != 0)
         return TPM_RC_FAILURE;
+#ifdef WOLFTPM_STATS
+    if (ctx->stats != NULL)
+        ctx->statsLockUs += XTPM_TIME_US() - startUs;
+#endif
 #endif
     return TPM_RC_SUCCESS;
 }
@@ -109,6 +136,14 @@ static int TPM2_CommandProcess(TPM2_CTX* ctx, TPM2_Packet* packet,
     UINT32 authSz;
     BYTE *param, *encParam = NULL;
     int paramSz, encParamSz = 0, authPos, i;
+#ifndef WOLFTPM2_NO_WOLFCRYPT
+    TPMI_ALG_HASH cpHashAlg = TPM_ALG_NULL;
+    TPM2B_DIGEST hash;
+#endif
+
+#ifndef WOLFTPM2_NO_WOLFCRYPT
+    hash.size = 0;
+#endif
 
     /* Skip the header and handles area */
     packet->pos = TPM2_HEADER_SIZE + (info->inHandleCnt * sizeof(TPM_HANDLE));
@@ -160,11 +195,6 @@ static int TPM2_CommandProcess(TPM2_CTX* ctx, TPM2_Packet* packet,
         XMEMCPY(&authCmd, session, sizeof(TPMS_AUTH_COMMAND));
 
         if (session->sessionHandle != TPM_RS_PW) {
-        #ifndef WOLFTPM2_NO_WOLFCRYPT
-            TPM2B_NAME name1, name2, name3;
-            TPM2B_DIGEST hash;
-        #endif
-
             /* if param enc is not supported for this command then clear flag */
             /* session attribute flags are from TPM perspective */
             if ((info->flags & (CMD_FLAG_ENC2 | CMD_FLAG_ENC4)) == 0) {
@@ -184,31 +214,40 @@ static int TPM2_CommandProcess(TPM2_CTX* ctx, TPM2_Packet* packet,
             #endif
                     return rc;
                 }
+            #ifndef WOLFTPM2_NO_WOLFCRYPT
+                hash.size = 0; /* parameters changed */
+            #endif
             }
 
         #ifndef WOLFTPM2_NO_WOLFCRYPT
-            rc =  TPM2_GetName(ctx, info->inHandleCnt, 0, &name1);
-            rc |= TPM2_GetName(ctx, info->inHandleCnt, 1, &name2);
-            rc |= TPM2_GetName(ctx, info->inHandleCnt, 2, &name3);
-            if (rc != TPM_RC_SUCCESS) {
-            #ifdef DEBUG_WOLFTPM
-                printf("Error getting names for cpHash!\n");
-            #endif
-                return BAD_FUNC_ARG;
-            }
+            /* sessions using the same hash algorithm share the cpHash */
+            if (hash.size == 0 || session->authHash != cpHashAlg) {
+                TPM2B_NAME name1, name2, name3;
 
-            /* calculate "cpHash" hash for command code, names and parameters */
-            rc = TPM2_CalcCpHash(session->authHash, cmdCode, &name1,
-                &name2, &name3, param, paramSz, &hash);
-            if (rc != TPM_RC_SUCCESS) {
-            #ifdef DEBUG_WOLFTPM
-                printf("Error calculating cpHash!\n");
-            #endif
-                return rc;
+                rc =  TPM2_GetName(ctx, info->inHandleCnt, 0, &name1);
+                rc |= TPM2_GetName(ctx, info->inHandleCnt, 1, &name2);
+                rc |= TPM2_GetName(ctx, info->inHandleCnt, 2, &name3);
+                if (rc != TPM_RC_SUCCESS) {
+                #ifdef DEBUG_WOLFTPM
+                    printf("Error getting names for cpHash!\n");
+                #endif
+                    return BAD_FUNC_ARG;
+                }
+
+                /* calculate "cpHash" hash for command code, names and parameters */
+                rc = TPM2_CalcCpHash(session->authHash, cmdCode, &name1,
+                    &name2, &name3, param, paramSz, &hash);
+                if (rc != TPM_RC_SUCCESS) {
+                #ifdef DEBUG_WOLFTPM
+                    printf("Error calculating cpHash!\n");
+                #endif
+                    return rc;
+                }
+                cpHashAlg = session->authHash;
             }
             /* Calculate HMAC for policy, hmac or salted sessions */
             /* this is done after encryption */
-            rc = TPM2_CalcHmac(session->authHash, &session->auth, &hash,
+            rc = TPM2_CalcSessionHmac(session, &hash,
                 &session->nonceCaller, &session->nonceTPM,
                 authCmd.sessionAttributes, &authCmd.hmac);
             if (rc != TPM_RC_SUCCESS) {
@@ -236,6 +275,14 @@ static int TPM2_ResponseProcess(TPM2_CTX* ctx, TPM2_Packet* packet,
     BYTE *param, *decParam = NULL;
     UINT32 paramSz, decParamSz = 0, authPos;
     int i;
+#ifndef WOLFTPM2_NO_WOLFCRYPT
+    TPMI_ALG_HASH rpHashAlg = TPM_ALG_NULL;
+    TPM2B_DIGEST hash;
+#endif
+
+#ifndef WOLFTPM2_NO_WOLFCRYPT
+    hash.size = 0;
+#endif
 
     /* Skip the header output handles */
     packet->pos = TPM2_HEADER_SIZE + (info->outHandleCnt * sizeof(TPM_HANDLE));
@@ -286,21 +333,23 @@ static int TPM2_ResponseProcess(TPM2_CTX* ctx, TPM2_Packet* packet,
 
         #ifndef WOLFTPM2_NO_WOLFCRYPT
             if (authRsp.hmac.size > 0) {
-                TPM2B_DIGEST hash;
                 TPM2B_AUTH hmac;
 
                 /* calculate "rpHash" hash for command code and parameters */
-                rc = TPM2_CalcRpHash(session->authHash, cmdCode, param, paramSz,
-                    &hash);
-                if (rc != TPM_RC_SUCCESS) {
-                #ifdef DEBUG_WOLFTPM
-                    printf("Error calculating rpHash!\n");
-                #endif
-                    return rc;
+                if (hash.size == 0 || session->authHash != rpHashAlg) {
+                    rc = TPM2_CalcRpHash(session->authHash, cmdCode, param,
+                        paramSz, &hash);
+                    if (rc != TPM_RC_SUCCESS) {
+                    #ifdef DEBUG_WOLFTPM
+                        printf("Error calculating rpHash!\n");
+                    #endif
+                        return rc;
+                    }
+                    rpHashAlg = session->authHash;
                 }
 
                 /* Calculate HMAC prior to decryption */
-                rc = TPM2_CalcHmac(session->authHash, &session->auth, &hash,
+                rc = TPM2_CalcSessionHmac(session, &hash,
                     &session->nonceTPM, &session->nonceCaller,
                     authRsp.sessionAttributes, &hmac);
                 if (rc != TPM_RC_SUCCESS) {
@@ -332,6 +381,9 @@ static int TPM2_ResponseProcess(TPM2_CTX* ctx, TPM2_Packet* packet,
             #endif
                     return TPM_RC_FAILURE;
                 }
+            #ifndef WOLFTPM2_NO_WOLFCRYPT
+                hash.size = 0; /* parameters changed */
+            #endif
             }
         }
     }
@@ -339,6 +391,79 @@ static int TPM2_ResponseProcess(TPM2_CTX* ctx, TPM2_Packet* packet,
     return rc;
 }
 
+#ifdef WOLFTPM_STATS
+static TPM2_CMD_STATS* TPM2_StatsFind(TPM2_STATS* stats, TPM_CC cmdCode)
+{
+    int i;
+    for (i = 0; i < WOLFTPM_STATS_CMDS; i++) {
+        if (stats->cmd[i].count == 0)
+            stats->cmd[i].cmdCode = cmdCode;
+        if (stats->cmd[i].cmdCode == cmdCode)
+            return &stats->cmd[i];
+    }
+    return &stats->other;
+}
+
+/* Sends the command and records its latency, sizes and response code */
+static TPM_RC TPM2_StatsSendCommand(TPM2_CTX* ctx, TPM2_Packet* packet)
+{
+    TPM_RC rc;
+    TPM2_CMD_STATS* cmdStats;
+    UINT32 tmp, cmdSz = (UINT32)packet->pos;
+    TPM_CC cmdCode;
+    word32 startUs, us;
+    int bucket;
+
+    if (ctx->stats == NULL)
+        return (TPM_RC)INTERNAL_SEND_COMMAND(ctx, packet);
+
+    XMEMCPY(&tmp, &packet->buf[6], sizeof(tmp));
+    cmdCode = TPM2_Packet_SwapU32(tmp);
+
+    startUs = XTPM_TIME_US();
+    rc = (TPM_RC)INTERNAL_SEND_COMMAND(ctx, packet);
+    us = XTPM_TIME_US() - startUs;
+
+    ctx->stats->commands++;
+    cmdStats = TPM2_StatsFind(ctx->stats, cmdCode);
+    cmdStats->count++;
+    cmdStats->bytesOut += cmdSz;
+    cmdStats->totalUs += us;
+    if (us > cmdStats->maxUs)
+        cmdStats->maxUs = us;
+    for (bucket = 0; us > 0 && bucket < WOLFTPM_STATS_HIST_BUCKETS - 1;
+            bucket++) {
+        us >>= 1;
+    }
+    cmdStats->hist[bucket]++;
+    cmdStats->lockWaitUs += ctx->statsLockUs;
+    ctx->statsLockUs = 0;
+
+    if (rc == TPM_RC_SUCCESS) {
+        XMEMCPY(&tmp, &packet->buf[2], sizeof(tmp));
+        cmdStats->bytesIn += TPM2_Packet_SwapU32(tmp);
+        XMEMCPY(&tmp, &packet->buf[6], sizeof(tmp));
+        tmp = TPM2_Packet_SwapU32(tmp);
+        if (tmp == TPM_RC_RETRY || tmp == TPM_RC_YIELDED ||
+                tmp == TPM_RC_TESTING) {
+            cmdStats->retries++;
+        }
+        else if (tmp != TPM_RC_SUCCESS) {
+            cmdStats->errors++;
+        }
+    }
+    else {
+        cmdStats->errors++;
+    }
+
+    return rc;
+}
+    #define TPM2_INTERNAL_SEND(ctx, packet) TPM2_StatsSendCommand(ctx, packet)
+#else
+    #define TPM2_INTERNAL_SEND(ctx, packet) \
+        (TPM_RC)INTERNAL_SEND_COMMAND(ctx, packet)
+#endif /* WOLFTPM_STATS */
+
 static TPM_RC TPM2_SendCommandAuth(TPM2_CTX* ctx, TPM2_Packet* packet,
     CmdInfo_t* info)
 {
@@ -380,7 +505,7 @@ static TPM_RC TPM2_SendCommandAuth(TPM2_CTX* ctx, TPM2_Packet* packet,
     packet->pos = cmdSz;
 
     /* submit command and wait for response */
-    rc = (TPM_RC)INTERNAL_SEND_COMMAND(ctx, packet);
+    rc = TPM2_INTERNAL_SEND(ctx, packet);
     if (rc != 0)
         return rc;
 
@@ -411,7 +536,7 @@ static TPM_RC TPM2_SendCommand(TPM2_CTX* ctx, TPM2_Packet* packet)
         return BAD_FUNC_ARG;
 
     /* submit command and wait for response */
-    rc = (TPM_RC)INTERNAL_SEND_COMMAND(ctx, packet);
+    rc = TPM2_INTERNAL_SEND(ctx, packet);
     if (rc != 0)
         return rc;
 
@@ -475,6 +600,41 @@ TPM_RC TPM2_SetSessionAuth(TPM2_AUTH_SESSION* session)
     return rc;
 }
 
+#ifdef WOLFTPM_STATS
+TPM_RC TPM2_SetStats(TPM2_CTX* ctx, TPM2_STATS* stats)
+{
+    TPM_RC rc;
+
+    if (ctx == NULL)
+        return BAD_FUNC_ARG;
+
+    rc = TPM2_AcquireLock(ctx);
+    if (rc == TPM_RC_SUCCESS) {
+        ctx->stats = stats;
+        ctx->statsLockUs = 0;
+
+        TPM2_ReleaseLock(ctx);
+    }
+    return rc;
+}
+
+TPM_RC TPM2_GetStats(TPM2_CTX* ctx, TPM2_STATS* stats)
+{
+    TPM_RC rc;
+
+    if (ctx == NULL || stats == NULL || ctx->stats == NULL)
+        return BAD_FUNC_ARG;
+
+    rc = TPM2_AcquireLock(ctx);
+    if (rc == TPM_RC_SUCCESS) {
+        XMEMCPY(stats, ctx->stats, sizeof(*stats));
+
+        TPM2_ReleaseLock(ctx);
+    }
+    return rc;
+}
+#endif /* WOLFTPM_STATS */
+
 /* Finds the number of active Auth Session in the given TPM2 context */
 int TPM2_GetSessionAuthCount(TPM2_CTX* ctx)
 {
@@ -0,0 +1,396 @@
+/* tpm2_async.c
+ *
+ * Copyright (C) 2006-2020 wolfSSL Inc.
+ *
+ * This file is part of wolfTPM.
+ *
+ * wolfTPM is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfTPM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <wolftpm/tpm2_async.h>
+
+#ifdef WOLFTPM_ASYNC_QUEUE
+
+/******************************************************************************/
+/* --- Local Functions -- */
+/******************************************************************************/
+
+/* Microsecond time source used for latency statistics. Wraps every ~71 min,
+ * only differences are used */
+#ifndef XTPM_ASYNC_TIME_US
+    #if defined(__linux__) || defined(__APPLE__) || defined(__unix__)
+        #include <sys/time.h>
+        static word32 TPM2_Async_TimeUs(void)
+        {
+            struct timeval tv;
+            gettimeofday(&tv, NULL);
+            return (word32)(tv.tv_sec * 1000000 + tv.tv_usec);
+        }
+        #define XTPM_ASYNC_TIME_US() TPM2_Async_TimeUs()
+    #else
+        #define XTPM_ASYNC_TIME_US() 0 /* no statistics timing */
+    #endif
+#endif
+
+/* Request and task state are read without the queue lock. A DONE request
+ * state is stored with release semantics so the result and output written by
+ * the service task are visible to a task that loads DONE with acquire */
+#if defined(__GNUC__) || defined(__clang__)
+    #define TPM2_ASYNC_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+    #define TPM2_ASYNC_LOAD(p)     __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#else
+    #define TPM2_ASYNC_STORE(p, v) (*(p) = (v))
+    #define TPM2_ASYNC_LOAD(p)     (*(p))
+#endif
+
+static int TPM2_Async_Lock(TPM2_ASYNC_QUEUE* queue)
+{
+#if defined(WOLFTPM2_NO_WOLFCRYPT) || defined(SINGLE_THREADED)
+    (void)queue;
+#else
+    if (wc_LockMutex(&queue->lock) != 0)
+        return BAD_MUTEX_E;
+#endif
+    return TPM_RC_SUCCESS;
+}
+
+static void TPM2_Async_Unlock(TPM2_ASYNC_QUEUE* queue)
+{
+#if defined(WOLFTPM2_NO_WOLFCRYPT) || defined(SINGLE_THREADED)
+    (void)queue;
+#else
+    wc_UnLockMutex(&queue->lock);
+#endif
+}
+
+/* must be called with queue lock held */
+static void TPM2_Async_UpdateStats(TPM2_ASYNC_QUEUE* queue,
+    TPM2_ASYNC_REQ* req)
+{
+    int i;
+    word32 execUs = req->doneUs - req->startUs;
+    TPM2_ASYNC_CMD_STATS* cmd = NULL;
+
+    queue->stats.completed++;
+
+    for (i = 0; i < WOLFTPM_ASYNC_STATS_CMDS; i++) {
+        if (queue->stats.cmd[i].count == 0) {
+            /* first free slot */
+            cmd = &queue->stats.cmd[i];
+            cmd->cmdCode = req->cmdCode;
+            break;
+        }
+        if (queue->stats.cmd[i].cmdCode == req->cmdCode) {
+            cmd = &queue->stats.cmd[i];
+            break;
+        }
+    }
+    if (cmd == NULL)
+        return; /* table full, only totals are counted */
+
+    cmd->count++;
+    cmd->waitUs += req->startUs - req->submitUs;
+    cmd->execUs += execUs;
+    if (execUs > cmd->maxExecUs)
+        cmd->maxExecUs = execUs;
+}
+
+static TPM_RC TPM2_Async_GetRandomCb(TPM2_ASYNC_REQ* req)
+{
+    return TPM2_GetRandom((GetRandom_In*)req->in, (GetRandom_Out*)req->out);
+}
+
+static TPM_RC TPM2_Async_PCR_ExtendCb(TPM2_ASYNC_REQ* req)
+{
+    return TPM2_PCR_Extend((PCR_Extend_In*)req->in);
+}
+
+
+/******************************************************************************/
+/* --- Public Functions -- */
+/******************************************************************************/
+
+int TPM2_Async_Init(TPM2_CTX* ctx, TPM2_ASYNC_QUEUE* queue)
+{
+    if (ctx == NULL || queue == NULL)
+        return BAD_FUNC_ARG;
+
+    XMEMSET(queue, 0, sizeof(TPM2_ASYNC_QUEUE));
+#if !defined(WOLFTPM2_NO_WOLFCRYPT) && !defined(SINGLE_THREADED)
+    if (wc_InitMutex(&queue->lock) != 0) {
+    #ifdef DEBUG_WOLFTPM
+        printf("TPM2_Async_Init: mutex init failed\n");
+    #endif
+        return BAD_MUTEX_E;
+    }
+#endif
+    ctx->asyncQueue = queue;
+
+    return TPM_RC_SUCCESS;
+}
+
+int TPM2_Async_Cleanup(TPM2_CTX* ctx)
+{
+    if (ctx == NULL || ctx->asyncQueue == NULL)
+        return BAD_FUNC_ARG;
+
+    TPM2_Async_Stop(ctx);
+#if !defined(WOLFTPM2_NO_WOLFCRYPT) && !defined(SINGLE_THREADED)
+    wc_FreeMutex(&ctx->asyncQueue->lock);
+#endif
+    ctx->asyncQueue = NULL;
+
+    return TPM_RC_SUCCESS;
+}
+
+int TPM2_Async_Submit(TPM2_CTX* ctx, TPM2_ASYNC_REQ* req)
+{
+    int rc;
+    TPM2_ASYNC_QUEUE* queue;
+
+    if (ctx == NULL || ctx->asyncQueue == NULL || req == NULL ||
+            req->cmdCb == NULL) {
+        return BAD_FUNC_ARG;
+    }
+    queue = ctx->asyncQueue;
+
+    rc = TPM2_Async_Lock(queue);
+    if (rc != TPM_RC_SUCCESS)
+        return rc;
+
+    if (queue->head - queue->tail >= WOLFTPM_ASYNC_QUEUE_SZ) {
+        queue->stats.rejected++;
+        rc = BUFFER_E;
+    }
+    else {
+        req->rc = TPM_RC_SUCCESS;
+        req->submitUs = XTPM_ASYNC_TIME_US();
+        req->startUs = req->doneUs = req->submitUs;
+        TPM2_ASYNC_STORE(&req->state, TPM2_ASYNC_STATE_QUEUED);
+        queue->ring[queue->head & (WOLFTPM_ASYNC_QUEUE_SZ-1)] = req;
+        queue->head++;
+
+        queue->stats.submitted++;
+        queue->stats.depth = queue->head - queue->tail;
+        if (queue->stats.depth > queue->stats.maxDepth)
+            queue->stats.maxDepth = queue->stats.depth;
+    }
+
+    TPM2_Async_Unlock(queue);
+
+    if (rc == TPM_RC_SUCCESS) {
+        XTPM_ASYNC_WAKE(queue);
+    }
+
+    return rc;
+}
+
+int TPM2_Async_Poll(TPM2_ASYNC_REQ* req)
+{
+    if (req == NULL)
+        return BAD_FUNC_ARG;
+    if (TPM2_ASYNC_LOAD(&req->state) != TPM2_ASYNC_STATE_DONE)
+        return WC_PENDING_E;
+    return req->rc;
+}
+
+int TPM2_Async_Wait(TPM2_CTX* ctx, TPM2_ASYNC_REQ* req)
+{
+    int rc, task;
+
+    if (ctx == NULL || ctx->asyncQueue == NULL || req == NULL)
+        return BAD_FUNC_ARG;
+
+    while ((rc = TPM2_Async_Poll(req)) == WC_PENDING_E) {
+        task = TPM2_ASYNC_LOAD(&ctx->asyncQueue->task);
+        if (task == TPM2_ASYNC_TASK_STARTING ||
+                task == TPM2_ASYNC_TASK_RUNNING ||
+                task == TPM2_ASYNC_TASK_STOPPING) {
+            XTPM_ASYNC_YIELD();
+        }
+        else if (TPM2_Async_Service(ctx, 1) <= 0) {
+            /* nothing to run and not complete: not submitted */
+            rc = BAD_FUNC_ARG;
+            break;
+        }
+    }
+
+    return rc;
+}
+
+int TPM2_Async_Service(TPM2_CTX* ctx, int maxReqs)
+{
+    int processed = 0;
+    TPM2_ASYNC_QUEUE* queue;
+    TPM2_ASYNC_REQ* req;
+
+    if (ctx == NULL || ctx->asyncQueue == NULL)
+        return BAD_FUNC_ARG;
+    queue = ctx->asyncQueue;
+
+    while (maxReqs <= 0 || processed < maxReqs) {
+        if (TPM2_Async_Lock(queue) != TPM_RC_SUCCESS)
+            return BAD_MUTEX_E;
+        req = NULL;
+        if (queue->head != queue->tail) {
+            req = queue->ring[queue->tail & (WOLFTPM_ASYNC_QUEUE_SZ-1)];
+            queue->tail++;
+            queue->stats.depth = queue->head - queue->tail;
+        }
+        TPM2_Async_Unlock(queue);
+        if (req == NULL)
+            break;
+
+        TPM2_ASYNC_STORE(&req->state, TPM2_ASYNC_STATE_RUNNING);
+        req->startUs = XTPM_ASYNC_TIME_US();
+        req->rc = req->cmdCb(req);
+        req->doneUs = XTPM_ASYNC_TIME_US();
+
+        if (TPM2_Async_Lock(queue) == TPM_RC_SUCCESS) {
+            TPM2_Async_UpdateStats(queue, req);
+            TPM2_Async_Unlock(queue);
+        }
+
+        /* callback runs before the request is marked done, so the owner may
+         * not reuse the request until Poll returns a result */
+        if (req->doneCb)
+            req->doneCb(req);
+        TPM2_ASYNC_STORE(&req->state, TPM2_ASYNC_STATE_DONE);
+        processed++;
+    }
+
+    return processed;
+}
+
+int TPM2_Async_Start(TPM2_CTX* ctx, TPM2AsyncTaskCb createCb, void* userCtx)
+{
+    int rc, task;
+    TPM2_ASYNC_QUEUE* queue;
+
+    if (ctx == NULL || ctx->asyncQueue == NULL || createCb == NULL)
+        return BAD_FUNC_ARG;
+    queue = ctx->asyncQueue;
+
+    task = TPM2_ASYNC_LOAD(&queue->task);
+    if (task != TPM2_ASYNC_TASK_NONE && task != TPM2_ASYNC_TASK_STOPPED)
+        return BAD_STATE_E; /* already started */
+
+    /* the new task waits in STARTING until the result is known */
+    TPM2_ASYNC_STORE(&queue->task, TPM2_ASYNC_TASK_STARTING);
+    rc = createCb(ctx, userCtx);
+    TPM2_ASYNC_STORE(&queue->task, (rc == 0) ? TPM2_ASYNC_TASK_RUNNING :
+        TPM2_ASYNC_TASK_NONE);
+
+    return rc;
+}
+
+void TPM2_Async_ServiceTask(void* arg)
+{
+    TPM2_CTX* ctx = (TPM2_CTX*)arg;
+    TPM2_ASYNC_QUEUE* queue;
+
+    if (ctx == NULL || ctx->asyncQueue == NULL)
+        return;
+    queue = ctx->asyncQueue;
+
+    while (TPM2_ASYNC_LOAD(&queue->task) == TPM2_ASYNC_TASK_STARTING) {
+        XTPM_ASYNC_YIELD();
+    }
+    if (TPM2_ASYNC_LOAD(&queue->task) != TPM2_ASYNC_TASK_RUNNING)
+        return; /* not created by Start, the queue is not ours */
+
+    while (TPM2_ASYNC_LOAD(&queue->task) == TPM2_ASYNC_TASK_RUNNING) {
+        if (TPM2_Async_Service(ctx, 0) <= 0) {
+            XTPM_ASYNC_IDLE(queue);
+        }
+    }
+    /* drain anything submitted before stop */
+    TPM2_Async_Service(ctx, 0);
+
+    /* last access to the queue, Stop may free it once this is seen */
+    TPM2_ASYNC_STORE(&queue->task, TPM2_ASYNC_TASK_STOPPED);
+}
+
+int TPM2_Async_Stop(TPM2_CTX* ctx)
+{
+    TPM2_ASYNC_QUEUE* queue;
+
+    if (ctx == NULL || ctx->asyncQueue == NULL)
+        return BAD_FUNC_ARG;
+    queue = ctx->asyncQueue;
+
+    /* a Start on another task is still creating the service task */
+    while (TPM2_ASYNC_LOAD(&queue->task) == TPM2_ASYNC_TASK_STARTING) {
+        XTPM_ASYNC_YIELD();
+    }
+    if (TPM2_ASYNC_LOAD(&queue->task) == TPM2_ASYNC_TASK_RUNNING) {
+        TPM2_ASYNC_STORE(&queue->task, TPM2_ASYNC_TASK_STOPPING);
+        XTPM_ASYNC_WAKE(queue);
+    }
+    /* join: wait for the service task to return */
+    while (TPM2_ASYNC_LOAD(&queue->task) == TPM2_ASYNC_TASK_STOPPING) {
+        XTPM_ASYNC_YIELD();
+    }
+
+    return TPM_RC_SUCCESS;
+}
+
+int TPM2_Async_GetStats(TPM2_CTX* ctx, TPM2_ASYNC_STATS* stats)
+{
+    int rc;
+
+    if (ctx == NULL || ctx->asyncQueue == NULL || stats == NULL)
+        return BAD_FUNC_ARG;
+
+    rc = TPM2_Async_Lock(ctx->asyncQueue);
+    if (rc == TPM_RC_SUCCESS) {
+        XMEMCPY(stats, &ctx->asyncQueue->stats, sizeof(TPM2_ASYNC_STATS));
+        TPM2_Async_Unlock(ctx->asyncQueue);
+    }
+    return rc;
+}
+
+int TPM2_Async_GetRandom(TPM2_CTX* ctx, TPM2_ASYNC_REQ* req,
+    GetRandom_In* in, GetRandom_Out* out, TPM2AsyncDoneCb doneCb)
+{
+    if (req == NULL || in == NULL || out == NULL)
+        return BAD_FUNC_ARG;
+
+    XMEMSET(req, 0, sizeof(TPM2_ASYNC_REQ));
+    req->cmdCb = TPM2_Async_GetRandomCb;
+    req->doneCb = doneCb;
+    req->in = in;
+    req->out = out;
+    req->cmdCode = TPM_CC_GetRandom;
+
+    return TPM2_Async_Submit(ctx, req);
+}
+
+int TPM2_Async_PCR_Extend(TPM2_CTX* ctx, TPM2_ASYNC_REQ* req,
+    PCR_Extend_In* in, TPM2AsyncDoneCb doneCb)
+{
+    if (req == NULL || in == NULL)
+        return BAD_FUNC_ARG;
+
+    XMEMSET(req, 0, sizeof(TPM2_ASYNC_REQ));
+    req->cmdCb = TPM2_Async_PCR_ExtendCb;
+    req->doneCb = doneCb;
+    req->in = in;
+    req->cmdCode = TPM_CC_PCR_Extend;
+
+    return TPM2_Async_Submit(ctx, req);
+}
+
+#endif /* WOLFTPM_ASYNC_QUEUE */
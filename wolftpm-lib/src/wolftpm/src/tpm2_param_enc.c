@@ -162,10 +162,19 @@ int TPM2_KDFa(
         if (ret != 0)
             goto exit;
 
-        /* get result */
-        ret = wc_HmacFinal(&hmac_ctx, keyStream);
-        if (ret != 0)
-            goto exit;
+        /* get result - last block may be partial */
+        if (keySz - pos < (UINT32)hLen) {
+            byte digest[WC_MAX_DIGEST_SIZE];
+            ret = wc_HmacFinal(&hmac_ctx, digest);
+            if (ret != 0)
+                goto exit;
+            XMEMCPY(keyStream, digest, keySz - pos);
+        }
+        else {
+            ret = wc_HmacFinal(&hmac_ctx, keyStream);
+            if (ret != 0)
+                goto exit;
+        }
 
         keyStream += hLen;
     }
@@ -189,6 +198,227 @@ exit:
 #endif
 }
 
+#if defined(WOLFTPM_SESSION_CACHE) && !defined(WOLFTPM2_NO_WOLFCRYPT)
+/* Session HMAC pad cache
+ *
+ * Every HMAC keyed with the session auth (the command and response HMAC and
+ * each KDFa block for parameter encryption) starts by hashing the key XOR'd
+ * with the inner and outer pads. Those two hash states are derived once per
+ * session key and copied for each HMAC, which saves two hash blocks per HMAC.
+ * The KDFa outputs and AES keys are not cached, since they depend on the
+ * nonces that roll with every command.
+ */
+
+static int TPM2_HashCopy(enum wc_HashType hashType, wc_HashAlg* src,
+    wc_HashAlg* dst)
+{
+    int rc;
+    switch (hashType) {
+    #ifndef NO_SHA
+        case WC_HASH_TYPE_SHA:
+            rc = wc_ShaCopy(&src->sha, &dst->sha);
+            break;
+    #endif
+    #ifndef NO_SHA256
+        case WC_HASH_TYPE_SHA256:
+            rc = wc_Sha256Copy(&src->sha256, &dst->sha256);
+            break;
+    #endif
+    #ifdef WOLFSSL_SHA384
+        case WC_HASH_TYPE_SHA384:
+            rc = wc_Sha384Copy(&src->sha384, &dst->sha384);
+            break;
+    #endif
+    #ifdef WOLFSSL_SHA512
+        case WC_HASH_TYPE_SHA512:
+            rc = wc_Sha512Copy(&src->sha512, &dst->sha512);
+            break;
+    #endif
+        default:
+            rc = NOT_COMPILED_IN;
+            break;
+    }
+    return rc;
+}
+
+/* Clear memory holding key material, not optimized away */
+static void TPM2_ForceZero(void* mem, word32 len)
+{
+    volatile byte* p = (volatile byte*)mem;
+    while (len--)
+        *p++ = 0;
+}
+
+/* Free and zero the pad states and the key they were derived from */
+static void TPM2_HmacCacheClear(TPM2_HMAC_CACHE* cache)
+{
+    if (cache->authHash != 0) {
+        enum wc_HashType hashType =
+            (enum wc_HashType)TPM2_GetHashType(cache->authHash);
+        wc_HashFree(&cache->inner, hashType);
+        wc_HashFree(&cache->outer, hashType);
+    }
+    TPM2_ForceZero(cache, sizeof(*cache));
+}
+
+/* Derive the pad hash states, unless already done for this hash and key */
+static int TPM2_HmacCacheSetKey(TPM2_HMAC_CACHE* cache, TPMI_ALG_HASH authHash,
+    const TPM2B_AUTH* key)
+{
+    int rc, i, blockSz;
+    enum wc_HashType hashType;
+    byte pad[WC_MAX_BLOCK_SIZE];
+
+    if (cache->authHash == authHash && cache->key.size == key->size &&
+            XMEMCMP(cache->key.buffer, key->buffer, key->size) == 0) {
+        return 0;
+    }
+
+    hashType = (enum wc_HashType)TPM2_GetHashType(authHash);
+    blockSz = wc_HashGetBlockSize(hashType);
+    if (blockSz <= 0)
+        return NOT_COMPILED_IN;
+    /* auth is at most a digest, so it never needs hashing down */
+    if (key->size > blockSz || blockSz > (int)sizeof(pad))
+        return BUFFER_E;
+
+    /* auth replaced (or first use), drop the old key and states */
+    TPM2_HmacCacheClear(cache);
+
+    XMEMSET(pad, 0, sizeof(pad));
+    XMEMCPY(pad, key->buffer, key->size);
+    for (i = 0; i < blockSz; i++)
+        pad[i] ^= 0x36;
+    rc = wc_HashInit(&cache->inner, hashType);
+    if (rc == 0)
+        rc = wc_HashUpdate(&cache->inner, hashType, pad, blockSz);
+    for (i = 0; i < blockSz; i++)
+        pad[i] ^= (0x36 ^ 0x5c);
+    if (rc == 0)
+        rc = wc_HashInit(&cache->outer, hashType);
+    if (rc == 0)
+        rc = wc_HashUpdate(&cache->outer, hashType, pad, blockSz);
+    TPM2_ForceZero(pad, sizeof(pad));
+
+    if (rc == 0) {
+        cache->key.size = key->size;
+        XMEMCPY(cache->key.buffer, key->buffer, key->size);
+        cache->authHash = authHash;
+    }
+    else {
+        wc_HashFree(&cache->inner, hashType);
+        wc_HashFree(&cache->outer, hashType);
+        TPM2_ForceZero(cache, sizeof(*cache));
+    }
+    return rc;
+}
+
+/* Start an HMAC from the cached inner pad state */
+static int TPM2_HmacCacheStart(TPM2_HMAC_CACHE* cache, wc_HashAlg* hash_ctx)
+{
+    return TPM2_HashCopy((enum wc_HashType)TPM2_GetHashType(cache->authHash),
+        &cache->inner, hash_ctx);
+}
+
+/* Finish the inner hash, then the outer hash from the cached outer pad state */
+static int TPM2_HmacCacheFinal(TPM2_HMAC_CACHE* cache, wc_HashAlg* hash_ctx,
+    byte* digest)
+{
+    int rc;
+    enum wc_HashType hashType =
+        (enum wc_HashType)TPM2_GetHashType(cache->authHash);
+    byte innerDigest[WC_MAX_DIGEST_SIZE];
+
+    rc = wc_HashFinal(hash_ctx, hashType, innerDigest);
+    wc_HashFree(hash_ctx, hashType);
+    if (rc == 0)
+        rc = TPM2_HashCopy(hashType, &cache->outer, hash_ctx);
+    if (rc == 0) {
+        rc = wc_HashUpdate(hash_ctx, hashType, innerDigest,
+            (word32)wc_HashGetDigestSize(hashType));
+        if (rc == 0)
+            rc = wc_HashFinal(hash_ctx, hashType, digest);
+        wc_HashFree(hash_ctx, hashType);
+    }
+    TPM2_ForceZero(innerDigest, sizeof(innerDigest));
+    return rc;
+}
+
+/* KDFa (see TPM2_KDFa) keyed with the session auth using the cached pads */
+int TPM2_KDFaSession(TPM2_AUTH_SESSION* session, TPM2B_AUTH* keyIn,
+    const char* label, TPM2B_NONCE* contextU, TPM2B_NONCE* contextV,
+    BYTE* key, UINT32 keySz)
+{
+    int ret;
+    TPM2_HMAC_CACHE* cache = &session->hmacCache;
+    wc_HashAlg hash_ctx;
+    enum wc_HashType hashType;
+    word32 counter = 0;
+    int hLen, lLen = 0;
+    byte uint32Buf[sizeof(UINT32)];
+    byte digest[WC_MAX_DIGEST_SIZE];
+    UINT32 sizeInBits = keySz * 8, pos;
+
+    ret = TPM2_HmacCacheSetKey(cache, session->authHash, keyIn);
+    if (ret != 0)
+        return ret;
+    hashType = (enum wc_HashType)TPM2_GetHashType(session->authHash);
+    hLen = TPM2_GetHashDigestSize(session->authHash);
+    if (hLen <= 0)
+        return NOT_COMPILED_IN;
+
+    if (label != NULL) {
+        lLen = (int)XSTRLEN(label) + 1;
+    }
+
+    for (pos = 0; pos < keySz; pos += hLen) {
+        counter++;
+
+        ret = TPM2_HmacCacheStart(cache, &hash_ctx);
+        if (ret != 0)
+            break;
+
+        TPM2_Packet_U32ToByteArray(counter, uint32Buf);
+        ret = wc_HashUpdate(&hash_ctx, hashType, uint32Buf,
+            (word32)sizeof(uint32Buf));
+        if (ret == 0 && label != NULL)
+            ret = wc_HashUpdate(&hash_ctx, hashType, (byte*)label, lLen);
+        if (ret == 0 && contextU != NULL && contextU->size > 0)
+            ret = wc_HashUpdate(&hash_ctx, hashType, contextU->buffer,
+                contextU->size);
+        if (ret == 0 && contextV != NULL && contextV->size > 0)
+            ret = wc_HashUpdate(&hash_ctx, hashType, contextV->buffer,
+                contextV->size);
+        TPM2_Packet_U32ToByteArray(sizeInBits, uint32Buf);
+        if (ret == 0)
+            ret = wc_HashUpdate(&hash_ctx, hashType, uint32Buf,
+                (word32)sizeof(uint32Buf));
+        if (ret != 0) {
+            wc_HashFree(&hash_ctx, hashType);
+            break;
+        }
+
+        /* last block may be partial */
+        ret = TPM2_HmacCacheFinal(cache, &hash_ctx, digest);
+        if (ret != 0)
+            break;
+        XMEMCPY(&key[pos], digest,
+            (keySz - pos < (UINT32)hLen) ? keySz - pos : (UINT32)hLen);
+    }
+    TPM2_ForceZero(digest, sizeof(digest));
+
+    return (ret == 0) ? (int)keySz : ret;
+}
+#else
+int TPM2_KDFaSession(TPM2_AUTH_SESSION* session, TPM2B_AUTH* keyIn,
+    const char* label, TPM2B_NONCE* contextU, TPM2B_NONCE* contextV,
+    BYTE* key, UINT32 keySz)
+{
+    return TPM2_KDFa(session->authHash, (TPM2B_DATA*)keyIn, label, contextU,
+        contextV, key, keySz);
+}
+#endif /* WOLFTPM_SESSION_CACHE && !WOLFTPM2_NO_WOLFCRYPT */
+
 
 /* Perform XOR encryption over the first parameter of a TPM packet */
 static int TPM2_ParamEnc_XOR(TPM2_AUTH_SESSION *session, TPM2B_AUTH* keyIn,
@@ -205,7 +435,7 @@ static int TPM2_ParamEnc_XOR(TPM2_AUTH_SESSION *session, TPM2B_AUTH* keyIn,
 
     /* Generate XOR Mask stream matching paramater size */
     XMEMSET(mask.buffer, 0, sizeof(mask.buffer));
-    rc = TPM2_KDFa(session->authHash, (TPM2B_DATA*)keyIn, "XOR",
+    rc = TPM2_KDFaSession(session, keyIn, "XOR",
         nonceCaller, nonceTPM, mask.buffer, paramSz);
     if ((UINT32)rc != paramSz) {
     #ifdef DEBUG_WOLFTPM
@@ -240,7 +470,7 @@ static int TPM2_ParamDec_XOR(TPM2_AUTH_SESSION *session, TPM2B_AUTH* keyIn,
 
     /* Generate XOR Mask stream matching paramater size */
     XMEMSET(mask.buffer, 0, sizeof(mask.buffer));
-    rc = TPM2_KDFa(session->authHash, (TPM2B_DATA*)keyIn, "XOR",
+    rc = TPM2_KDFaSession(session, keyIn, "XOR",
         nonceTPM, nonceCaller, mask.buffer, paramSz);
     if ((UINT32)rc != paramSz) {
     #ifdef DEBUG_WOLFTPM
@@ -277,7 +507,7 @@ static int TPM2_ParamEnc_AESCFB(TPM2_AUTH_SESSION *session, TPM2B_AUTH* keyIn,
 
     /* Generate AES Key and IV */
     XMEMSET(symKey, 0, sizeof(symKey));
-    rc = TPM2_KDFa(session->authHash, (TPM2B_DATA*)keyIn, "CFB",
+    rc = TPM2_KDFaSession(session, keyIn, "CFB",
         nonceCaller, nonceTPM, symKey, symKeySz + symKeyIvSz);
     if (rc != symKeySz + symKeyIvSz) {
     #ifdef DEBUG_WOLFTPM
@@ -322,7 +552,7 @@ static int TPM2_ParamDec_AESCFB(TPM2_AUTH_SESSION *session, TPM2B_AUTH* keyIn,
 
     /* Generate AES Key and IV */
     XMEMSET(symKey, 0, sizeof(symKey));
-    rc = TPM2_KDFa(session->authHash, (TPM2B_DATA*)keyIn, "CFB",
+    rc = TPM2_KDFaSession(session, keyIn, "CFB",
         nonceTPM, nonceCaller, symKey, symKeySz + symKeyIvSz);
     if (rc != symKeySz + symKeyIvSz) {
     #ifdef DEBUG_WOLFTPM
@@ -522,8 +752,72 @@ int TPM2_CalcHmac(TPMI_ALG_HASH authHash, TPM2B_AUTH* auth,
 
     return rc;
 }
+
+/* Compute the session HMAC (see TPM2_CalcHmac) keyed with the session auth */
+int TPM2_CalcSessionHmac(TPM2_AUTH_SESSION* session,
+    const TPM2B_DIGEST* hash, const TPM2B_NONCE* nonceNew,
+    const TPM2B_NONCE* nonceOld, TPMA_SESSION sessionAttributes,
+    TPM2B_AUTH* hmac)
+{
+#ifdef WOLFTPM_SESSION_CACHE
+    int rc;
+    TPM2_HMAC_CACHE* cache = &session->hmacCache;
+    wc_HashAlg hash_ctx;
+    enum wc_HashType hashType;
+
+    hashType = (enum wc_HashType)TPM2_GetHashType(session->authHash);
+    rc = TPM2_GetHashDigestSize(session->authHash);
+    if (rc <= 0)
+        return BAD_FUNC_ARG;
+    hmac->size = rc;
+
+    rc = TPM2_HmacCacheSetKey(cache, session->authHash, &session->auth);
+    if (rc == 0)
+        rc = TPM2_HmacCacheStart(cache, &hash_ctx);
+    if (rc != 0)
+        return rc;
+
+    rc = wc_HashUpdate(&hash_ctx, hashType, hash->buffer, hash->size);
+    if (rc == 0)
+        rc = wc_HashUpdate(&hash_ctx, hashType, nonceNew->buffer,
+            nonceNew->size);
+    if (rc == 0)
+        rc = wc_HashUpdate(&hash_ctx, hashType, nonceOld->buffer,
+            nonceOld->size);
+    if (rc == 0)
+        rc = wc_HashUpdate(&hash_ctx, hashType, &sessionAttributes, 1);
+    if (rc == 0) {
+        rc = TPM2_HmacCacheFinal(cache, &hash_ctx, hmac->buffer);
+    }
+    else {
+        wc_HashFree(&hash_ctx, hashType);
+    }
+
+#ifdef WOLFTPM_DEBUG_VERBOSE
+    printf("HMAC Auth: attrib %x, size %d\n", sessionAttributes, hmac->size);
+    TPM2_PrintBin(hmac->buffer, hmac->size);
+#endif
+
+    return rc;
+#else
+    return TPM2_CalcHmac(session->authHash, &session->auth, hash, nonceNew,
+        nonceOld, sessionAttributes, hmac);
+#endif
+}
 #endif /* !WOLFTPM2_NO_WOLFCRYPT */
 
+/* Free and zero the session HMAC key cache, when the session is closed or
+ * before it is reused for another session / auth */
+void TPM2_SessionHmacFree(TPM2_AUTH_SESSION* session)
+{
+#if defined(WOLFTPM_SESSION_CACHE) && !defined(WOLFTPM2_NO_WOLFCRYPT)
+    if (session != NULL)
+        TPM2_HmacCacheClear(&session->hmacCache);
+#else
+    (void)session;
+#endif
+}
+
 TPM_RC TPM2_ParamEnc_CmdRequest(TPM2_AUTH_SESSION *session,
                                 BYTE *paramData, UINT32 paramSz)
 {
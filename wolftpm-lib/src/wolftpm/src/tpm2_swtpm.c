@@ -44,6 +44,13 @@
 
 #include <wolftpm/tpm2_socket.h>
 
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+/* A host starting with '/' is the path of a Unix domain socket, for example
+ * swtpm socket --server type=unixio,path=/tmp/swtpm.sock */
 #ifndef TPM2_SWTPM_HOST
 #define TPM2_SWTPM_HOST         "localhost"
 #endif
@@ -51,67 +58,126 @@
 #define TPM2_SWTPM_PORT         "2321"
 #endif
 
-static TPM_RC SwTpmTransmit(TPM2_CTX* ctx, const void* buffer, ssize_t bufSz)
-{
-    TPM_RC rc = TPM_RC_SUCCESS;
-    ssize_t wrc = 0;
-
-    if (ctx == NULL || ctx->tcpCtx.fd < 0 || buffer == NULL) {
-        return BAD_FUNC_ARG;
-    }
-
-    wrc = write(ctx->tcpCtx.fd, buffer, bufSz);
-    if (bufSz != wrc) {
-        rc = SOCKET_ERROR_E;
-    }
+/* size of the send command header: command, locality, size */
+#define SWTPM_CMD_HDR_SZ        (sizeof(uint32_t) + sizeof(uint8_t) + \
+                                 sizeof(uint32_t))
 
-#ifdef WOLFTPM_DEBUG_VERBOSE
-    if (wrc < 0) {
-        printf("Failed to send the TPM command to fd %d, got errno %d ="
-               "%s\n", ctx->tcpCtx.fd, errno, strerror(errno));
-    }
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL            0 /* SO_NOSIGPIPE is set instead */
 #endif
 
-    return rc;
-}
-
-static TPM_RC SwTpmReceive(TPM2_CTX* ctx, void* buffer, size_t rxSz)
+/* Send or receive all of iov, a closed peer is an error instead of SIGPIPE */
+static TPM_RC SwTpmXfer(TPM2_CTX* ctx, struct iovec* iov, int iovCnt,
+    int isRead)
 {
-    TPM_RC rc = TPM_RC_SUCCESS;
-    ssize_t wrc = 0;
-    size_t bytes_remaining = rxSz;
-    char* ptr = (char*)buffer;
+    struct msghdr msg;
+    ssize_t wrc;
 
-    if (ctx == NULL || ctx->tcpCtx.fd < 0 || buffer == NULL) {
+    if (ctx == NULL || ctx->tcpCtx.fd < 0 || iov == NULL) {
         return BAD_FUNC_ARG;
     }
 
-    while (bytes_remaining > 0) {
-        wrc = read(ctx->tcpCtx.fd, ptr, bytes_remaining);
+    while (iovCnt > 0) {
+        XMEMSET(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iovCnt;
+
+        if (isRead)
+            wrc = recvmsg(ctx->tcpCtx.fd, &msg, 0);
+        else
+            wrc = sendmsg(ctx->tcpCtx.fd, &msg, MSG_NOSIGNAL);
+        if (wrc < 0 && errno == EINTR) {
+            continue;
+        }
         if (wrc <= 0) {
             #ifdef DEBUG_WOLFTPM
             if (wrc == 0) {
-                printf("Failed to read from TPM socket: EOF\n");
+                printf("TPM socket %s failed: EOF\n", isRead ? "read" : "write");
             }
             else {
-                printf("Failed to read from TPM socket %d, got errno %d"
-                       " = %s\n", ctx->tcpCtx.fd, errno, strerror(errno));
+                printf("TPM socket %s failed on fd %d, got errno %d = %s\n",
+                    isRead ? "read" : "write", ctx->tcpCtx.fd, errno,
+                    strerror(errno));
             }
             #endif
-            rc = SOCKET_ERROR_E;
-            break;
+            return SOCKET_ERROR_E;
+        }
+
+        /* skip what was done */
+        while (iovCnt > 0 && (size_t)wrc >= iov->iov_len) {
+            wrc -= iov->iov_len;
+            iov++;
+            iovCnt--;
         }
+        if (iovCnt > 0) {
+            iov->iov_base = (char*)iov->iov_base + wrc;
+            iov->iov_len -= wrc;
+        }
+    }
 
-        bytes_remaining -= wrc;
-        ptr += wrc;
+    return TPM_RC_SUCCESS;
+}
 
-        #ifdef WOLFTPM_DEBUG_VERBOSE
-        printf("TPM socket received %zd waiting for %zu more\n",
-               wrc, bytes_remaining);
+static TPM_RC SwTpmTransmit(TPM2_CTX* ctx, const void* buffer, size_t bufSz)
+{
+    struct iovec iov;
+
+    iov.iov_base = (void*)buffer;
+    iov.iov_len = bufSz;
+    return SwTpmXfer(ctx, &iov, 1, 0);
+}
+
+static TPM_RC SwTpmReceive(TPM2_CTX* ctx, void* buffer, size_t rxSz)
+{
+    struct iovec iov;
+
+    iov.iov_base = buffer;
+    iov.iov_len = rxSz;
+    return SwTpmXfer(ctx, &iov, 1, 1);
+}
+
+static void SwTpmSetOptions(int fd, int isTcp)
+{
+    int on = 1;
+
+    /* commands are one write, don't wait for more */
+    if (isTcp) {
+        (void)setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    }
+#ifdef SO_NOSIGPIPE
+    (void)setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+    (void)on;
+}
+
+static TPM_RC SwTpmConnectUnix(TPM2_CTX* ctx, const char* path)
+{
+    struct sockaddr_un addr;
+    int fd;
+
+    if (XSTRLEN(path) >= sizeof(addr.sun_path)) {
+        return BAD_FUNC_ARG;
+    }
+
+    XMEMSET(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    XMEMCPY(addr.sun_path, path, XSTRLEN(path));
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1) {
+        return SOCKET_ERROR_E;
+    }
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == -1) {
+        #ifdef DEBUG_WOLFTPM
+        printf("Failed to connect to %s\n", path);
         #endif
+        close(fd);
+        return SOCKET_ERROR_E;
     }
+    SwTpmSetOptions(fd, 0);
+    ctx->tcpCtx.fd = fd;
 
-    return rc;
+    return TPM_RC_SUCCESS;
 }
 
 static TPM_RC SwTpmConnect(TPM2_CTX* ctx, const char* host, const char* port)
@@ -120,12 +186,16 @@ static TPM_RC SwTpmConnect(TPM2_CTX* ctx, const char* host, const char* port)
     struct addrinfo hints;
     struct addrinfo *result, *rp;
     int s;
-    int fd;
+    int fd = -1;
 
     if (ctx == NULL) {
         return BAD_FUNC_ARG;
     }
 
+    if (host[0] == '/') {
+        return SwTpmConnectUnix(ctx, host);
+    }
+
     XMEMSET(&hints, 0, sizeof(struct addrinfo));
     hints.ai_family = AF_UNSPEC;
     hints.ai_socktype = SOCK_STREAM;
@@ -133,6 +203,7 @@ static TPM_RC SwTpmConnect(TPM2_CTX* ctx, const char* host, const char* port)
     s = getaddrinfo(host, port, &hints, &result);
     if (s != 0) {
         fprintf(stderr, "getaddrinfo: %s\n", gai_strerror(s));
+        return rc;
     }
 
     for (rp = result; rp != NULL; rp = rp->ai_next) {
@@ -150,6 +221,7 @@ static TPM_RC SwTpmConnect(TPM2_CTX* ctx, const char* host, const char* port)
     freeaddrinfo(result);
 
     if (rp != NULL) {
+        SwTpmSetOptions(fd, 1);
         ctx->tcpCtx.fd = fd;
         rc = TPM_RC_SUCCESS;
     }
@@ -194,75 +266,68 @@ static TPM_RC SwTpmDisconnect(TPM2_CTX* ctx)
     return rc;
 }
 
-/* Talk to a TPM through socket
- * return TPM_RC_SUCCESS on success,
- *        SOCKET_ERROR_E on socket errors,
- *        TPM_RC_FAILURE on other errors
- */
-int TPM2_SWTPM_SendCommand(TPM2_CTX* ctx, TPM2_Packet* packet)
+/* A kept connection has nothing to read between commands, so one that reads
+ * EOF, an error or stray data without blocking is closed or out of sync */
+static int SwTpmIsStale(TPM2_CTX* ctx)
 {
-    int rc = TPM_RC_FAILURE;
-    int rspSz = 0;
-    uint32_t tss_word;
-
-    if (ctx == NULL) {
-        return BAD_FUNC_ARG;
-    }
+    byte b;
+    ssize_t rc = recv(ctx->tcpCtx.fd, &b, 1, MSG_PEEK | MSG_DONTWAIT);
 
-    if (ctx->tcpCtx.fd < 0) {
-        rc = SwTpmConnect(ctx, TPM2_SWTPM_HOST, TPM2_SWTPM_PORT);
-    }
+    return !(rc < 0 && (errno == EAGAIN || errno == EWOULDBLOCK ||
+                        errno == EINTR));
+}
 
-#ifdef WOLFTPM_DEBUG_VERBOSE
-    printf("Command size: %d\n", packet->pos);
-    TPM2_PrintBin(packet->buf, packet->pos);
-#endif
+/* Send one command and read its response into packet. sent is set once all
+ * of the command is written, the simulator may run it from then on */
+static TPM_RC SwTpmExchange(TPM2_CTX* ctx, TPM2_Packet* packet, int* rspSz,
+    int* sent)
+{
+    TPM_RC rc;
+    byte hdr[SWTPM_CMD_HDR_SZ];
+    uint32_t tss_word;
+    struct iovec iov[2];
 
-    /* send start */
+    /* start, locality, size and the command in one write */
     tss_word = TPM2_Packet_SwapU32(TPM_SEND_COMMAND);
-    if (rc == TPM_RC_SUCCESS) {
-        rc = SwTpmTransmit(ctx, &tss_word, sizeof(uint32_t));
-    }
-
-    /* locality */
-    if (rc == TPM_RC_SUCCESS) {
-        rc = SwTpmTransmit(ctx, &ctx->locality, sizeof(uint8_t));
-    }
-
-    /* buffer size */
+    XMEMCPY(hdr, &tss_word, sizeof(uint32_t));
+    hdr[sizeof(uint32_t)] = (byte)ctx->locality;
     tss_word = TPM2_Packet_SwapU32(packet->pos);
-    if (rc == TPM_RC_SUCCESS) {
-        rc = SwTpmTransmit(ctx, &tss_word, sizeof(uint32_t));
-    }
+    XMEMCPY(hdr + sizeof(uint32_t) + sizeof(uint8_t), &tss_word,
+        sizeof(uint32_t));
 
-    /* Send the TPM command buffer */
-    if (rc == TPM_RC_SUCCESS) {
-        rc = SwTpmTransmit(ctx, packet->buf, packet->pos);
-    }
+    iov[0].iov_base = hdr;
+    iov[0].iov_len = sizeof(hdr);
+    iov[1].iov_base = packet->buf;
+    iov[1].iov_len = packet->pos;
+    rc = SwTpmXfer(ctx, iov, 2, 0);
 
-    /* receive response */
+    /* receive response size */
     if (rc == TPM_RC_SUCCESS) {
+        *sent = 1;
         rc = SwTpmReceive(ctx, &tss_word, sizeof(uint32_t));
-        rspSz = TPM2_Packet_SwapU32(tss_word);
-        if (rspSz > packet->size) {
+    }
+    if (rc == TPM_RC_SUCCESS) {
+        *rspSz = (int)TPM2_Packet_SwapU32(tss_word);
+        if (*rspSz < 0 || *rspSz > packet->size) {
             #ifdef WOLFTPM_DEBUG_VERBOSE
             printf("Response size(%d) larger than command buffer(%d)\n",
-                   rspSz, packet->pos);
+                   *rspSz, packet->pos);
             #endif
             rc = SOCKET_ERROR_E;
         }
     }
 
-    /* This performs a blocking read and could hang. This means a
-     * misbehaving actor on the other end of the socket
+    /* Response and ack in one read. This performs a blocking read and could
+     * hang. This means a misbehaving actor on the other end of the socket
      */
     if (rc == TPM_RC_SUCCESS) {
-        rc = SwTpmReceive(ctx, packet->buf, rspSz);
+        iov[0].iov_base = packet->buf;
+        iov[0].iov_len = *rspSz;
+        iov[1].iov_base = &tss_word;
+        iov[1].iov_len = sizeof(uint32_t);
+        rc = SwTpmXfer(ctx, iov, 2, 1);
     }
-
-    /* receive ack */
     if (rc == TPM_RC_SUCCESS) {
-        rc = SwTpmReceive(ctx, &tss_word, sizeof(uint32_t));
         tss_word = TPM2_Packet_SwapU32(tss_word);
         #ifdef WOLFTPM_DEBUG
         if (tss_word != 0) {
@@ -271,6 +336,55 @@ int TPM2_SWTPM_SendCommand(TPM2_CTX* ctx, TPM2_Packet* packet)
         #endif
     }
 
+    return rc;
+}
+
+/* Talk to a TPM through socket. The connection is kept open for the next
+ * command and closed by TPM2_SWTPM_Disconnect or TPM2_Cleanup.
+ * return TPM_RC_SUCCESS on success,
+ *        SOCKET_ERROR_E on socket errors,
+ *        TPM_RC_FAILURE on other errors
+ */
+int TPM2_SWTPM_SendCommand(TPM2_CTX* ctx, TPM2_Packet* packet)
+{
+    int rc = TPM_RC_FAILURE;
+    int rspSz = 0;
+    int sent = 0;
+    int reused;
+
+    if (ctx == NULL || packet == NULL) {
+        return BAD_FUNC_ARG;
+    }
+
+#ifdef WOLFTPM_DEBUG_VERBOSE
+    printf("Command size: %d\n", packet->pos);
+    TPM2_PrintBin(packet->buf, packet->pos);
+#endif
+
+    /* the simulator may have closed the kept connection while idle */
+    if (ctx->tcpCtx.fd >= 0 && SwTpmIsStale(ctx)) {
+        close(ctx->tcpCtx.fd);
+        ctx->tcpCtx.fd = -1;
+    }
+
+    do {
+        reused = (ctx->tcpCtx.fd >= 0);
+        rc = TPM_RC_SUCCESS;
+        if (!reused) {
+            rc = SwTpmConnect(ctx, TPM2_SWTPM_HOST, TPM2_SWTPM_PORT);
+        }
+        if (rc == TPM_RC_SUCCESS) {
+            rc = SwTpmExchange(ctx, packet, &rspSz, &sent);
+        }
+        if (rc != TPM_RC_SUCCESS && ctx->tcpCtx.fd >= 0) {
+            /* the stream is out of sync, drop it */
+            close(ctx->tcpCtx.fd);
+            ctx->tcpCtx.fd = -1;
+        }
+        /* A kept connection that failed the write is sent again on a new
+         * one. Once the whole command is written it is not sent again, the
+         * simulator may have run it (PCR_Extend or NV_Increment twice) */
+    } while (rc != TPM_RC_SUCCESS && reused && !sent);
 
 #ifdef WOLFTPM_DEBUG_VERBOSE
     if (rspSz > 0) {
@@ -279,13 +393,18 @@ int TPM2_SWTPM_SendCommand(TPM2_CTX* ctx, TPM2_Packet* packet)
     }
 #endif
 
-    if (ctx->tcpCtx.fd >= 0) {
-        TPM_RC rc_disconnect = SwTpmDisconnect(ctx);
-        if (rc == TPM_RC_SUCCESS) {
-            rc = rc_disconnect;
-        }
+    return rc;
+}
+
+int TPM2_SWTPM_Disconnect(TPM2_CTX* ctx)
+{
+    if (ctx == NULL) {
+        return BAD_FUNC_ARG;
+    }
+    if (ctx->tcpCtx.fd < 0) {
+        return TPM_RC_SUCCESS;
     }
 
-    return rc;
+    return SwTpmDisconnect(ctx);
 }
 #endif /* WOLFTPM_SWTPM */
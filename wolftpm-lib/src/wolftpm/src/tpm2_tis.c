@@ -171,6 +171,44 @@ enum tpm_tis_int_flags {
 #endif
 
 
+#ifdef WOLFTPM_TIS_STATS
+int TPM2_TIS_SetStats(TPM2_CTX* ctx, TPM2_TIS_STATS* stats)
+{
+    if (ctx == NULL)
+        return BAD_FUNC_ARG;
+
+    if (stats != NULL)
+        XMEMSET(stats, 0, sizeof(*stats));
+    ctx->tisStats = stats;
+    ctx->tisCmdCode = 0;
+
+    return TPM_RC_SUCCESS;
+}
+
+TPM2_TIS_CC_STATS* TPM2_TIS_GetCcStats(TPM2_TIS_STATS* stats, TPM_CC cc)
+{
+    if (stats == NULL)
+        return NULL;
+    if (cc >= TPM_CC_FIRST && cc <= TPM_CC_LAST)
+        return &stats->cc[cc - TPM_CC_FIRST];
+    return &stats->other;
+}
+
+static void TPM2_TIS_CountXfer(TPM2_CTX* ctx, word32 len)
+{
+    TPM2_TIS_CC_STATS* ccStats = TPM2_TIS_GetCcStats(ctx->tisStats,
+        ctx->tisCmdCode);
+    if (ccStats != NULL) {
+        ccStats->xfers++;
+        ccStats->bytes += len + TPM_TIS_HEADER_SZ;
+    }
+}
+#define TPM2_TIS_COUNT_XFER(ctx, len) TPM2_TIS_CountXfer((ctx), (len))
+#else
+#define TPM2_TIS_COUNT_XFER(ctx, len)
+#endif /* WOLFTPM_TIS_STATS */
+
+
 int TPM2_TIS_Read(TPM2_CTX* ctx, word32 addr, byte* result,
     word32 len)
 {
@@ -202,6 +240,7 @@ int TPM2_TIS_Read(TPM2_CTX* ctx, word32 addr, byte* result,
 
     XMEMCPY(result, &rxBuf[TPM_TIS_HEADER_SZ], len);
 #endif
+    TPM2_TIS_COUNT_XFER(ctx, len);
     TPM2_TIS_UNLOCK();
 
     return rc;
@@ -236,6 +275,7 @@ int TPM2_TIS_Write(TPM2_CTX* ctx, word32 addr, const byte* value,
 
     rc = ctx->ioCb(ctx, txBuf, rxBuf, len + TPM_TIS_HEADER_SZ, ctx->userCtx);
 #endif
+    TPM2_TIS_COUNT_XFER(ctx, len);
     TPM2_TIS_UNLOCK();
 
     return rc;
@@ -411,24 +451,100 @@ int TPM2_TIS_GetBurstCount(TPM2_CTX* ctx, word16* burstCount)
     return rc;
 }
 
+#ifdef WOLFTPM_TIS_COALESCE
+/* Reads the status and burst count bytes of TPM_STS in one transaction */
+static int TPM2_TIS_StatusBurst(TPM2_CTX* ctx, byte* status,
+    word16* burstCount)
+{
+    int rc;
+    byte reg[3];
+
+    rc = TPM2_TIS_Read(ctx, TPM_STS(ctx->locality), reg, sizeof(reg));
+    if (rc == TPM_RC_SUCCESS) {
+        *status = reg[0];
+        *burstCount = (word16)(reg[1] | (reg[2] << 8));
+    #if defined(WOLFTPM_ST33) || defined(WOLFTPM_AUTODETECT)
+        if (TPM2_GetVendorID() == TPM_VENDOR_STM) {
+            *burstCount = 32; /* fixed value */
+        }
+    #endif
+    }
+    return rc;
+}
+
+/* Polls TPM_STS with a doubling interval. If burstCount is set the burst
+ * count is read with the status and must also be non-zero. The timeout is
+ * counted in XTPM_WAIT() intervals, so the total wait time is unchanged */
+static int TPM2_TIS_WaitForStatusBurst(TPM2_CTX* ctx, byte status,
+    byte status_mask, word16* burstCount)
+{
+    int rc;
+    int timeout = TPM_TIMEOUT_TRIES;
+    int waits = 1;
+    byte reg = 0;
+
+    do {
+        if (burstCount != NULL)
+            rc = TPM2_TIS_StatusBurst(ctx, &reg, burstCount);
+        else
+            rc = TPM2_TIS_Status(ctx, &reg);
+        if (rc == TPM_RC_SUCCESS && (reg & status) == status_mask &&
+                (burstCount == NULL || *burstCount > 0))
+            break;
+        XTPM_WAIT_N(waits);
+        timeout -= waits;
+        if (waits < TPM_TIS_POLL_MAX_WAITS)
+            waits <<= 1;
+    } while (rc == TPM_RC_SUCCESS && timeout > 0);
+#ifdef WOLFTPM_DEBUG_TIMEOUT
+    printf("TIS_WaitForStatusBurst: Timeout %d\n", TPM_TIMEOUT_TRIES - timeout);
+#endif
+    if (timeout <= 0)
+        return TPM_RC_TIMEOUT;
+    return rc;
+}
+
+    #define TPM2_TIS_STATUS(ctx, status, burstCount) \
+        TPM2_TIS_StatusBurst((ctx), (status), (burstCount))
+    #define TPM2_TIS_WAIT_STATUS(ctx, status, mask, burstCount) \
+        TPM2_TIS_WaitForStatusBurst((ctx), (status), (mask), (burstCount))
+#else
+    #define TPM2_TIS_STATUS(ctx, status, burstCount) \
+        TPM2_TIS_Status((ctx), (status))
+    #define TPM2_TIS_WAIT_STATUS(ctx, status, mask, burstCount) \
+        TPM2_TIS_WaitForStatus((ctx), (status), (mask))
+#endif /* WOLFTPM_TIS_COALESCE */
+
+/* With WOLFTPM_TIS_COALESCE the burst count read with TPM_STS is used for as
+ * many FIFO frames as it covers. TPM_STS is only read again once it runs out,
+ * or when the command phase changes. */
 int TPM2_TIS_SendCommand(TPM2_CTX* ctx, TPM2_Packet* packet)
 {
     int rc;
     int xferSz, pos, rspSz;
     byte access, status = 0;
-    word16 burstCount;
+    word16 burstCount = 0;
 
     rc = TPM2_TIS_LOCK();
     if (rc != 0)
         return rc;
 
+#ifdef WOLFTPM_TIS_STATS
+    if (ctx->tisStats != NULL && packet->pos >= TPM2_HEADER_SIZE) {
+        UINT32 cc;
+        XMEMCPY(&cc, &packet->buf[6], sizeof(UINT32));
+        ctx->tisCmdCode = TPM2_Packet_SwapU32(cc);
+        TPM2_TIS_GetCcStats(ctx->tisStats, ctx->tisCmdCode)->cmds++;
+    }
+#endif
+
 #ifdef WOLFTPM_DEBUG_VERBOSE
     printf("Command: %d\n", packet->pos);
     TPM2_PrintBin(packet->buf, packet->pos);
 #endif
 
     /* Make sure TPM is ready for command */
-    rc = TPM2_TIS_Status(ctx, &status);
+    rc = TPM2_TIS_STATUS(ctx, &status, &burstCount);
     if (rc != TPM_RC_SUCCESS)
         goto exit;
     if ((status & TPM_STS_COMMAND_READY) == 0) {
@@ -438,8 +554,8 @@ int TPM2_TIS_SendCommand(TPM2_CTX* ctx, TPM2_Packet* packet)
             goto exit;
 
         /* Wait for command ready (TPM_STS_COMMAND_READY = 1) */
-        rc = TPM2_TIS_WaitForStatus(ctx, TPM_STS_COMMAND_READY,
-                                         TPM_STS_COMMAND_READY);
+        rc = TPM2_TIS_WAIT_STATUS(ctx, TPM_STS_COMMAND_READY,
+                                       TPM_STS_COMMAND_READY, &burstCount);
         if (rc != TPM_RC_SUCCESS)
             goto exit;
     }
@@ -447,13 +563,27 @@ int TPM2_TIS_SendCommand(TPM2_CTX* ctx, TPM2_Packet* packet)
     /* Write Command */
     pos = 0;
     while (pos < packet->pos) {
+    #ifdef WOLFTPM_TIS_COALESCE
+        if (burstCount == 0) {
+            /* the TPM only expects data once the first byte is written */
+            rc = TPM2_TIS_WaitForStatusBurst(ctx,
+                pos == 0 ? TPM_STS_COMMAND_READY : TPM_STS_DATA_EXPECT,
+                pos == 0 ? TPM_STS_COMMAND_READY : TPM_STS_DATA_EXPECT,
+                &burstCount);
+            if (rc != TPM_RC_SUCCESS)
+                goto exit;
+        }
+    #else
         rc = TPM2_TIS_GetBurstCount(ctx, &burstCount);
         if (rc < 0)
             goto exit;
+    #endif
 
         xferSz = packet->pos - pos;
         if (xferSz > burstCount)
             xferSz = burstCount;
+        if (xferSz > MAX_SPI_FRAMESIZE)
+            xferSz = MAX_SPI_FRAMESIZE;
 
         rc = TPM2_TIS_Write(ctx, TPM_DATA_FIFO(ctx->locality), &packet->buf[pos],
                                xferSz);
@@ -461,6 +591,9 @@ int TPM2_TIS_SendCommand(TPM2_CTX* ctx, TPM2_Packet* packet)
             goto exit;
         pos += xferSz;
 
+    #ifdef WOLFTPM_TIS_COALESCE
+        burstCount -= xferSz;
+    #else
         if (pos < packet->pos) {
             /* Wait for expect more data (TPM_STS_DATA_EXPECT = 1) */
             rc = TPM2_TIS_WaitForStatus(ctx, TPM_STS_DATA_EXPECT,
@@ -472,6 +605,7 @@ int TPM2_TIS_SendCommand(TPM2_CTX* ctx, TPM2_Packet* packet)
                 goto exit;
             }
         }
+    #endif /* WOLFTPM_TIS_COALESCE */
     }
 
 #if defined(WOLFTPM_ST33) || defined(WOLFTPM_AUTODETECT)
@@ -479,8 +613,8 @@ int TPM2_TIS_SendCommand(TPM2_CTX* ctx, TPM2_Packet* packet)
 #endif
     {
         /* Wait for TPM_STS_DATA_EXPECT = 0 and TPM_STS_VALID = 1 */
-        rc = TPM2_TIS_WaitForStatus(ctx, TPM_STS_DATA_EXPECT | TPM_STS_VALID,
-                                        TPM_STS_VALID);
+        rc = TPM2_TIS_WAIT_STATUS(ctx, TPM_STS_DATA_EXPECT | TPM_STS_VALID,
+                                       TPM_STS_VALID, NULL);
         if (rc != TPM_RC_SUCCESS) {
         #ifdef DEBUG_WOLFTPM
             printf("TPM2_TIS_SendCommand status valid timeout!\n");
@@ -495,28 +629,38 @@ int TPM2_TIS_SendCommand(TPM2_CTX* ctx, TPM2_Packet* packet)
                            sizeof(access));
     if (rc != TPM_RC_SUCCESS)
         goto exit;
+    burstCount = 0;
 
     /* Read response */
     pos = 0;
     rspSz = TPM2_HEADER_SIZE; /* Read at least TPM header */
     while (pos < rspSz) {
-        /* Wait for data to be available (TPM_STS_DATA_AVAIL = 1) */
-        rc = TPM2_TIS_WaitForStatus(ctx, TPM_STS_DATA_AVAIL,
-                                         TPM_STS_DATA_AVAIL);
-        if (rc != TPM_RC_SUCCESS) {
-        #ifdef DEBUG_WOLFTPM
-            printf("TPM2_TIS_SendCommand read no data available!\n");
+    #ifdef WOLFTPM_TIS_COALESCE
+        if (burstCount == 0)
+    #endif
+        {
+            /* Wait for data to be available (TPM_STS_DATA_AVAIL = 1) */
+            rc = TPM2_TIS_WAIT_STATUS(ctx, TPM_STS_DATA_AVAIL,
+                                           TPM_STS_DATA_AVAIL, &burstCount);
+            if (rc != TPM_RC_SUCCESS) {
+            #ifdef DEBUG_WOLFTPM
+                printf("TPM2_TIS_SendCommand read no data available!\n");
+            #endif
+                goto exit;
+            }
+
+        #ifndef WOLFTPM_TIS_COALESCE
+            rc = TPM2_TIS_GetBurstCount(ctx, &burstCount);
+            if (rc < 0)
+                goto exit;
         #endif
-            goto exit;
         }
 
-        rc = TPM2_TIS_GetBurstCount(ctx, &burstCount);
-        if (rc < 0)
-            goto exit;
-
         xferSz = rspSz - pos;
         if (xferSz > burstCount)
             xferSz = burstCount;
+        if (xferSz > MAX_SPI_FRAMESIZE)
+            xferSz = MAX_SPI_FRAMESIZE;
 
         rc = TPM2_TIS_Read(ctx, TPM_DATA_FIFO(ctx->locality), &packet->buf[pos],
                               xferSz);
@@ -524,6 +668,7 @@ int TPM2_TIS_SendCommand(TPM2_CTX* ctx, TPM2_Packet* packet)
             goto exit;
 
         pos += xferSz;
+        burstCount -= xferSz;
 
         /* Get real response size */
         if (pos == TPM2_HEADER_SIZE) {
@@ -555,6 +700,9 @@ exit:
     if (rc == TPM_RC_SUCCESS)
         rc = TPM2_TIS_Ready(ctx);
 
+#ifdef WOLFTPM_TIS_STATS
+    ctx->tisCmdCode = 0;
+#endif
     TPM2_TIS_UNLOCK();
 
     return rc;
@@ -29,6 +29,26 @@
 
 /* Local Functions */
 static int wolfTPM2_GetCapabilities_NoDev(WOLFTPM2_CAPS* cap);
+#ifdef WOLFTPM_KEY_CACHE
+static WOLFTPM2_KEY_CACHE_ENTRY* wolfTPM2_KeyCacheFind(WOLFTPM2_DEV* dev,
+    const WOLFTPM2_HANDLE* handle);
+static int wolfTPM2_KeyCacheUse(WOLFTPM2_DEV* dev,
+    const WOLFTPM2_HANDLE* handle, const WOLFTPM2_HANDLE* keep);
+static int wolfTPM2_KeyCacheRetry(WOLFTPM2_DEV* dev, int rc,
+    const WOLFTPM2_HANDLE* keep);
+static int wolfTPM2_KeyCacheForget(WOLFTPM2_DEV* dev,
+    const WOLFTPM2_HANDLE* handle);
+
+/* make sure a tracked key is loaded, without evicting keep */
+#define KEY_CACHE_USE(dev, handle, keep) \
+    wolfTPM2_KeyCacheUse((dev), (handle), (keep))
+/* on out of object memory evict a tracked key and retry */
+#define KEY_CACHE_RETRY(dev, rc, keep) \
+    wolfTPM2_KeyCacheRetry((dev), (rc), (keep))
+#else
+#define KEY_CACHE_USE(dev, handle, keep)   TPM_RC_SUCCESS
+#define KEY_CACHE_RETRY(dev, rc, keep)     0
+#endif
 
 
 /******************************************************************************/
@@ -380,6 +400,7 @@ int wolfTPM2_SetAuth(WOLFTPM2_DEV* dev, int index,
     }
 
     session = &dev->session[index];
+    TPM2_SessionHmacFree(session);
     XMEMSET(session, 0, sizeof(TPM2_AUTH_SESSION));
     session->sessionHandle = sessionHandle;
     session->sessionAttributes = sessionAttributes;
@@ -426,6 +447,7 @@ int wolfTPM2_SetAuthSession(WOLFTPM2_DEV* dev, int index,
 
     if (tpmSession == NULL) {
         /* clearing auth session */
+        TPM2_SessionHmacFree(&dev->session[index]);
         XMEMSET(&dev->session[index], 0, sizeof(TPM2_AUTH_SESSION));
         return TPM_RC_SUCCESS;
     }
@@ -452,7 +474,7 @@ int wolfTPM2_SetAuthSession(WOLFTPM2_DEV* dev, int index,
 
 int wolfTPM2_Cleanup_ex(WOLFTPM2_DEV* dev, int doShutdown)
 {
-    int rc = 0;
+    int rc = 0, i;
 
     if (dev == NULL) {
         return BAD_FUNC_ARG;
@@ -478,6 +500,13 @@ int wolfTPM2_Cleanup_ex(WOLFTPM2_DEV* dev, int doShutdown)
         }
     }
 
+#ifdef WOLFTPM_KEY_CACHE
+    dev->keyCache = NULL;
+#endif
+    for (i = 0; i < MAX_SESSION_NUM; i++) {
+        TPM2_SessionHmacFree(&dev->session[i]);
+    }
+
     TPM2_Cleanup(&dev->ctx);
 
     return rc;
@@ -634,6 +663,16 @@ int wolfTPM2_StartSession(WOLFTPM2_DEV* dev, WOLFTPM2_SESSION* session,
         return NOT_COMPILED_IN;
     }
 
+    /* salt key and bind object must be loaded */
+    if (tpmKey) {
+        rc = KEY_CACHE_USE(dev, &tpmKey->handle, bind);
+        if (rc != TPM_RC_SUCCESS)
+            return rc;
+    }
+    rc = KEY_CACHE_USE(dev, bind, tpmKey ? &tpmKey->handle : NULL);
+    if (rc != TPM_RC_SUCCESS)
+        return rc;
+
     /* set session auth for key */
     if (tpmKey) {
         wolfTPM2_SetAuthHandle(dev, 0, &tpmKey->handle);
@@ -783,7 +822,9 @@ int wolfTPM2_CreatePrimaryKey(WOLFTPM2_DEV* dev, WOLFTPM2_KEY* key,
     }
     XMEMCPY(&createPriIn.inPublic.publicArea, publicTemplate,
         sizeof(TPMT_PUBLIC));
-    rc = TPM2_CreatePrimary(&createPriIn, &createPriOut);
+    do {
+        rc = TPM2_CreatePrimary(&createPriIn, &createPriOut);
+    } while (KEY_CACHE_RETRY(dev, rc, NULL));
     if (rc != TPM_RC_SUCCESS) {
     #ifdef DEBUG_WOLFTPM
         printf("TPM2_CreatePrimary: failed %d: %s\n", rc,
@@ -814,10 +855,19 @@ int wolfTPM2_ChangeAuthKey(WOLFTPM2_DEV* dev, WOLFTPM2_KEY* key,
     ObjectChangeAuth_Out changeOut;
     Load_In  loadIn;
     Load_Out loadOut;
+#ifdef WOLFTPM_KEY_CACHE
+    int tracked;
+#endif
 
     if (dev == NULL || key == NULL || parent == NULL)
         return BAD_FUNC_ARG;
 
+    rc = KEY_CACHE_USE(dev, parent, NULL);
+    if (rc == TPM_RC_SUCCESS)
+        rc = KEY_CACHE_USE(dev, &key->handle, parent);
+    if (rc != TPM_RC_SUCCESS)
+        return rc;
+
     /* set session auth for key */
     wolfTPM2_SetAuthHandle(dev, 0, &key->handle);
 
@@ -840,6 +890,10 @@ int wolfTPM2_ChangeAuthKey(WOLFTPM2_DEV* dev, WOLFTPM2_KEY* key,
         return rc;
     }
 
+#ifdef WOLFTPM_KEY_CACHE
+    tracked = (wolfTPM2_KeyCacheFind(dev, &key->handle) != NULL);
+#endif
+
     /* unload old key */
     wolfTPM2_UnloadHandle(dev, &key->handle);
 
@@ -851,7 +905,9 @@ int wolfTPM2_ChangeAuthKey(WOLFTPM2_DEV* dev, WOLFTPM2_KEY* key,
     loadIn.parentHandle = parent->hndl;
     loadIn.inPrivate = changeOut.outPrivate;
     loadIn.inPublic = key->pub;
-    rc = TPM2_Load(&loadIn, &loadOut);
+    do {
+        rc = TPM2_Load(&loadIn, &loadOut);
+    } while (KEY_CACHE_RETRY(dev, rc, parent));
     if (rc != TPM_RC_SUCCESS) {
     #ifdef DEBUG_WOLFTPM
         printf("TPM2_Load key failed %d: %s\n", rc, wolfTPM2_GetRCString(rc));
@@ -862,6 +918,12 @@ int wolfTPM2_ChangeAuthKey(WOLFTPM2_DEV* dev, WOLFTPM2_KEY* key,
     key->handle.auth = changeIn.newAuth;
     key->handle.name = loadOut.name;
 
+#ifdef WOLFTPM_KEY_CACHE
+    /* keep tracking the key under its new handle */
+    if (tracked)
+        rc = wolfTPM2_KeyCacheAdd(dev, key);
+#endif
+
 #ifdef DEBUG_WOLFTPM
     printf("wolfTPM2_ChangeAuthKey: Key Handle 0x%x\n", (word32)key->handle.hndl);
 #endif
@@ -883,6 +945,10 @@ int wolfTPM2_CreateKey(WOLFTPM2_DEV* dev, WOLFTPM2_KEYBLOB* keyBlob,
     /* clear output key buffer */
     XMEMSET(keyBlob, 0, sizeof(WOLFTPM2_KEYBLOB));
 
+    rc = KEY_CACHE_USE(dev, parent, NULL);
+    if (rc != TPM_RC_SUCCESS)
+        return rc;
+
     /* set session auth for parent key */
     wolfTPM2_SetAuthHandle(dev, 0, parent);
 
@@ -934,6 +1000,10 @@ int wolfTPM2_LoadKey(WOLFTPM2_DEV* dev, WOLFTPM2_KEYBLOB* keyBlob,
     if (dev == NULL || keyBlob == NULL || parent == NULL)
         return BAD_FUNC_ARG;
 
+    rc = KEY_CACHE_USE(dev, parent, NULL);
+    if (rc != TPM_RC_SUCCESS)
+        return rc;
+
     /* set session auth for parent key */
     if (dev->ctx.session) {
         wolfTPM2_SetAuthHandle(dev, 0, parent);
@@ -944,7 +1014,9 @@ int wolfTPM2_LoadKey(WOLFTPM2_DEV* dev, WOLFTPM2_KEYBLOB* keyBlob,
     loadIn.parentHandle = parent->hndl;
     loadIn.inPrivate = keyBlob->priv;
     loadIn.inPublic = keyBlob->pub;
-    rc = TPM2_Load(&loadIn, &loadOut);
+    do {
+        rc = TPM2_Load(&loadIn, &loadOut);
+    } while (KEY_CACHE_RETRY(dev, rc, parent));
     if (rc != TPM_RC_SUCCESS) {
     #ifdef DEBUG_WOLFTPM
         printf("TPM2_Load key failed %d: %s\n", rc, wolfTPM2_GetRCString(rc));
@@ -996,7 +1068,9 @@ int wolfTPM2_LoadPublicKey(WOLFTPM2_DEV* dev, WOLFTPM2_KEY* key,
     XMEMSET(&loadExtIn, 0, sizeof(loadExtIn));
     loadExtIn.inPublic = *pub;
     loadExtIn.hierarchy = TPM_RH_NULL;
-    rc = TPM2_LoadExternal(&loadExtIn, &loadExtOut);
+    do {
+        rc = TPM2_LoadExternal(&loadExtIn, &loadExtOut);
+    } while (KEY_CACHE_RETRY(dev, rc, NULL));
     if (rc != TPM_RC_SUCCESS) {
     #ifdef DEBUG_WOLFTPM
         printf("TPM2_LoadExternal: failed %d: %s\n", rc,
@@ -1231,6 +1305,10 @@ int wolfTPM2_ImportPrivateKey(WOLFTPM2_DEV* dev, const WOLFTPM2_KEY* parentKey,
 
     /* set session auth for key */
     if (parentKey != NULL) {
+        rc = KEY_CACHE_USE(dev, &parentKey->handle, NULL);
+        if (rc != TPM_RC_SUCCESS)
+            return rc;
+
         /* set session auth for parent key */
         wolfTPM2_SetAuthHandle(dev, 0, &parentKey->handle);
         parentHandle = parentKey->handle.hndl;
@@ -1821,6 +1899,10 @@ int wolfTPM2_NVStoreKey(WOLFTPM2_DEV* dev, TPM_HANDLE primaryHandle,
     if (key->handle.hndl == persistentHandle)
         return TPM_RC_SUCCESS;
 
+    rc = KEY_CACHE_USE(dev, &key->handle, NULL);
+    if (rc != TPM_RC_SUCCESS)
+        return rc;
+
     /* set session auth to blank */
     wolfTPM2_SetAuthPassword(dev, 0, NULL);
 
@@ -1924,6 +2006,10 @@ int wolfTPM2_SignHashScheme(WOLFTPM2_DEV* dev, WOLFTPM2_KEY* key,
         }
     }
 
+    rc = KEY_CACHE_USE(dev, &key->handle, NULL);
+    if (rc != TPM_RC_SUCCESS)
+        return rc;
+
     if (dev->ctx.session) {
         /* set session auth for key */
         wolfTPM2_SetAuthHandle(dev, 0, &key->handle);
@@ -2029,6 +2115,10 @@ int wolfTPM2_VerifyHashScheme(WOLFTPM2_DEV* dev, WOLFTPM2_KEY* key,
     if (digestSz > (int)sizeof(verifySigIn.digest.buffer))
         digestSz = (int)sizeof(verifySigIn.digest.buffer);
 
+    rc = KEY_CACHE_USE(dev, &key->handle, NULL);
+    if (rc != TPM_RC_SUCCESS)
+        return rc;
+
     /* set session auth for key */
     wolfTPM2_SetAuthHandle(dev, 0, &key->handle);
 
@@ -2145,6 +2235,10 @@ int wolfTPM2_ECDHGen(WOLFTPM2_DEV* dev, WOLFTPM2_KEY* privKey,
         return BAD_FUNC_ARG;
     }
 
+    rc = KEY_CACHE_USE(dev, &privKey->handle, NULL);
+    if (rc != TPM_RC_SUCCESS)
+        return rc;
+
     /* set session auth for key */
     wolfTPM2_SetAuthHandle(dev, 0, &privKey->handle);
 
@@ -2193,6 +2287,10 @@ int wolfTPM2_ECDHGenZ(WOLFTPM2_DEV* dev, WOLFTPM2_KEY* privKey,
         return BAD_FUNC_ARG;
     }
 
+    rc = KEY_CACHE_USE(dev, &privKey->handle, NULL);
+    if (rc != TPM_RC_SUCCESS)
+        return rc;
+
     /* set session auth for key */
     if (dev->ctx.session) {
         wolfTPM2_SetAuthHandle(dev, 0, &privKey->handle);
@@ -2275,6 +2373,10 @@ int wolfTPM2_ECDHEGenZ(WOLFTPM2_DEV* dev, WOLFTPM2_KEY* parentKey,
         return BAD_FUNC_ARG;
     }
 
+    rc = KEY_CACHE_USE(dev, &parentKey->handle, NULL);
+    if (rc != TPM_RC_SUCCESS)
+        return rc;
+
     /* set session auth for key */
     if (dev->ctx.session) {
         wolfTPM2_SetAuthHandle(dev, 0, &parentKey->handle);
@@ -2321,6 +2423,10 @@ int wolfTPM2_RsaEncrypt(WOLFTPM2_DEV* dev, WOLFTPM2_KEY* key,
         return BAD_FUNC_ARG;
     }
 
+    rc = KEY_CACHE_USE(dev, &key->handle, NULL);
+    if (rc != TPM_RC_SUCCESS)
+        return rc;
+
     /* set session auth for key */
     if (dev->ctx.session) {
         wolfTPM2_SetAuthHandle(dev, 0, &key->handle);
@@ -2372,6 +2478,10 @@ int wolfTPM2_RsaDecrypt(WOLFTPM2_DEV* dev, WOLFTPM2_KEY* key,
         return BAD_FUNC_ARG;
     }
 
+    rc = KEY_CACHE_USE(dev, &key->handle, NULL);
+    if (rc != TPM_RC_SUCCESS)
+        return rc;
+
     /* set session auth and name for key */
     if (dev->ctx.session) {
         wolfTPM2_SetAuthHandle(dev, 0, &key->handle);
@@ -2484,12 +2594,20 @@ int wolfTPM2_ExtendPCR(WOLFTPM2_DEV* dev, int pcrIndex, int hashAlg,
 
 int wolfTPM2_UnloadHandle(WOLFTPM2_DEV* dev, WOLFTPM2_HANDLE* handle)
 {
-    int rc;
+    int rc, i;
     FlushContext_In in;
 
     if (dev == NULL || handle == NULL)
         return BAD_FUNC_ARG;
 
+#ifdef WOLFTPM_KEY_CACHE
+    /* an evicted key is only held as a saved context */
+    if (wolfTPM2_KeyCacheForget(dev, handle)) {
+        handle->hndl = TPM_RH_NULL;
+        return TPM_RC_SUCCESS;
+    }
+#endif
+
     /* don't try and unload null or persistent handles */
     if (handle->hndl == 0 || handle->hndl == TPM_RH_NULL ||
         (handle->hndl >= PERSISTENT_FIRST && handle->hndl <= PERSISTENT_LAST)) {
@@ -2511,6 +2629,17 @@ int wolfTPM2_UnloadHandle(WOLFTPM2_DEV* dev, WOLFTPM2_HANDLE* handle)
     printf("TPM2_FlushContext: Closed handle 0x%x\n", (word32)handle->hndl);
 #endif
 
+#ifdef WOLFTPM_KEY_CACHE
+    /* a slot was freed, so more tracked keys may fit again */
+    if (dev->keyCache != NULL)
+        dev->keyCache->fitLoaded = 0;
+#endif
+    /* session closed, drop its cached HMAC key */
+    for (i = 0; i < MAX_SESSION_NUM; i++) {
+        if (dev->session[i].sessionHandle == handle->hndl)
+            TPM2_SessionHmacFree(&dev->session[i]);
+    }
+
     handle->hndl = TPM_RH_NULL;
 
     return TPM_RC_SUCCESS;
@@ -2910,7 +3039,9 @@ int wolfTPM2_HashStart(WOLFTPM2_DEV* dev, WOLFTPM2_HASH* hash,
     XMEMSET(&in, 0, sizeof(in));
     in.auth = hash->handle.auth;
     in.hashAlg = hashAlg;
-    rc = TPM2_HashSequenceStart(&in, &out);
+    do {
+        rc = TPM2_HashSequenceStart(&in, &out);
+    } while (KEY_CACHE_RETRY(dev, rc, NULL));
     if (rc != TPM_RC_SUCCESS) {
     #ifdef DEBUG_WOLFTPM
         printf("TPM2_HashSequenceStart failed 0x%x: %s\n", rc,
@@ -3149,7 +3280,9 @@ int wolfTPM2_LoadSymmetricKey(WOLFTPM2_DEV* dev, WOLFTPM2_KEY* key, int alg,
         goto exit;
 
     /* Load private key */
-    rc = TPM2_LoadExternal(&loadExtIn, &loadExtOut);
+    do {
+        rc = TPM2_LoadExternal(&loadExtIn, &loadExtOut);
+    } while (KEY_CACHE_RETRY(dev, rc, NULL));
     if (rc == TPM_RC_SUCCESS) {
         key->handle.hndl = loadExtOut.objectHandle;
         key->handle.symmetric = loadExtIn.inPublic.publicArea.parameters.asymDetail.symmetric;
@@ -3187,6 +3320,10 @@ int wolfTPM2_EncryptDecryptBlock(WOLFTPM2_DEV* dev, WOLFTPM2_KEY* key,
         return BAD_FUNC_ARG;
     }
 
+    rc = KEY_CACHE_USE(dev, &key->handle, NULL);
+    if (rc != TPM_RC_SUCCESS)
+        return rc;
+
     /* set session auth for key */
     if (dev->ctx.session) {
         wolfTPM2_SetAuthHandle(dev, 0, &key->handle);
@@ -3330,6 +3467,10 @@ int wolfTPM2_LoadKeyedHashKey(WOLFTPM2_DEV* dev, WOLFTPM2_KEY* key,
     /* clear output key buffer */
     XMEMSET(key, 0, sizeof(WOLFTPM2_KEY));
 
+    rc = KEY_CACHE_USE(dev, parent, NULL);
+    if (rc != TPM_RC_SUCCESS)
+        return rc;
+
     /* set session auth for parent key */
     if (dev->ctx.session) {
         wolfTPM2_SetAuthHandle(dev, 0, parent);
@@ -3371,7 +3512,9 @@ int wolfTPM2_LoadKeyedHashKey(WOLFTPM2_DEV* dev, WOLFTPM2_KEY* key,
     loadIn.parentHandle = parent->hndl;
     loadIn.inPrivate = createOut.outPrivate;
     loadIn.inPublic = key->pub;
-    rc = TPM2_Load(&loadIn, &loadOut);
+    do {
+        rc = TPM2_Load(&loadIn, &loadOut);
+    } while (KEY_CACHE_RETRY(dev, rc, parent));
     if (rc != TPM_RC_SUCCESS) {
     #ifdef DEBUG_WOLFTPM
         printf("TPM2_Load key failed %d: %s\n", rc, wolfTPM2_GetRCString(rc));
@@ -3408,6 +3551,11 @@ int wolfTPM2_HmacStart(WOLFTPM2_DEV* dev, WOLFTPM2_HMAC* hmac,
     hmac->hash.handle.auth.size = usageAuthSz;
     XMEMCPY(hmac->hash.handle.auth.buffer, usageAuth, usageAuthSz);
 
+    /* bring back a kept key that was evicted */
+    rc = KEY_CACHE_USE(dev, &hmac->key.handle, NULL);
+    if (rc != TPM_RC_SUCCESS)
+        return rc;
+
     if (!hmac->hmacKeyLoaded || hmac->key.handle.hndl == TPM_RH_NULL) {
         /* Load Keyed Hash Key */
         rc = wolfTPM2_LoadKeyedHashKey(dev, &hmac->key, parent, hashAlg, keyBuf, keySz,
@@ -3428,7 +3576,9 @@ int wolfTPM2_HmacStart(WOLFTPM2_DEV* dev, WOLFTPM2_HMAC* hmac,
     in.handle = hmac->key.handle.hndl;
     in.auth = hmac->hash.handle.auth;
     in.hashAlg = hashAlg;
-    rc = TPM2_HMAC_Start(&in, &out);
+    do {
+        rc = TPM2_HMAC_Start(&in, &out);
+    } while (KEY_CACHE_RETRY(dev, rc, &hmac->key.handle));
     if (rc != TPM_RC_SUCCESS) {
     #ifdef DEBUG_WOLFTPM
         printf("TPM2_HMAC_Start failed 0x%x: %s\n", rc,
@@ -3542,6 +3692,355 @@ int wolfTPM2_UnloadHandles_AllTransient(WOLFTPM2_DEV* dev)
     return wolfTPM2_UnloadHandles(dev, TRANSIENT_FIRST, MAX_HANDLE_NUM);
 }
 
+#ifdef WOLFTPM_KEY_CACHE
+static WOLFTPM2_KEY_CACHE_ENTRY* wolfTPM2_KeyCacheFind(WOLFTPM2_DEV* dev,
+    const WOLFTPM2_HANDLE* handle)
+{
+    int i;
+    WOLFTPM2_KEY_CACHE* cache = dev->keyCache;
+
+    if (cache == NULL || handle == NULL)
+        return NULL;
+    for (i = 0; i < WOLFTPM_KEY_CACHE_SZ; i++) {
+        if (cache->entry[i].handle == handle)
+            return &cache->entry[i];
+    }
+    return NULL;
+}
+
+/* Save and flush the least recently used loaded key (other than keep) */
+static int wolfTPM2_KeyCacheEvict(WOLFTPM2_DEV* dev,
+    const WOLFTPM2_HANDLE* keep)
+{
+    int i, rc;
+    WOLFTPM2_KEY_CACHE* cache = dev->keyCache;
+    WOLFTPM2_KEY_CACHE_ENTRY* lru = NULL;
+    ContextSave_In  saveIn;
+    ContextSave_Out saveOut;
+    FlushContext_In flushIn;
+
+    for (i = 0; i < WOLFTPM_KEY_CACHE_SZ; i++) {
+        WOLFTPM2_KEY_CACHE_ENTRY* entry = &cache->entry[i];
+        if (entry->handle != NULL && !entry->saved && entry->handle != keep &&
+                (lru == NULL || entry->lastUse < lru->lastUse)) {
+            lru = entry;
+        }
+    }
+    if (lru == NULL) {
+        /* nothing left we can free */
+        return TPM_RC_OBJECT_MEMORY;
+    }
+
+    /* A saved object context can be loaded again, so a key that was already
+     * swapped out once only needs to be flushed */
+    rc = TPM_RC_SUCCESS;
+    if (!lru->haveContext) {
+        XMEMSET(&saveIn, 0, sizeof(saveIn));
+        saveIn.saveHandle = lru->handle->hndl;
+        rc = TPM2_ContextSave(&saveIn, &saveOut);
+        if (rc == TPM_RC_SUCCESS) {
+            lru->context = saveOut.context;
+            lru->haveContext = 1;
+            cache->stats.saves++;
+        }
+    }
+    if (rc == TPM_RC_SUCCESS) {
+        XMEMSET(&flushIn, 0, sizeof(flushIn));
+        flushIn.flushHandle = lru->handle->hndl;
+        rc = TPM2_FlushContext(&flushIn);
+    }
+    if (rc != TPM_RC_SUCCESS) {
+    #ifdef DEBUG_WOLFTPM
+        printf("Key cache evict 0x%x failed %d: %s\n",
+            (word32)lru->handle->hndl, rc, wolfTPM2_GetRCString(rc));
+    #endif
+        return rc;
+    }
+
+#ifdef DEBUG_WOLFTPM
+    printf("Key cache evicted 0x%x\n", (word32)lru->handle->hndl);
+#endif
+
+    lru->saved = 1;
+    /* handle is not valid until reloaded */
+    lru->handle->hndl = TPM_RH_NULL;
+    cache->stats.evictions++;
+    cache->stats.loaded--;
+
+    return TPM_RC_SUCCESS;
+}
+
+/* Tracked keys allowed loaded at once, 0 if not known */
+static int wolfTPM2_KeyCacheLimit(WOLFTPM2_KEY_CACHE* cache)
+{
+    return (cache->maxLoaded > 0) ? cache->maxLoaded : cache->fitLoaded;
+}
+
+static int wolfTPM2_KeyCacheRetry(WOLFTPM2_DEV* dev, int rc,
+    const WOLFTPM2_HANDLE* keep)
+{
+    if (rc != TPM_RC_OBJECT_MEMORY || dev->keyCache == NULL)
+        return 0;
+    /* remember how many fit, so the next reload evicts first instead of
+     * failing */
+    dev->keyCache->fitLoaded = (int)dev->keyCache->stats.loaded;
+    return (wolfTPM2_KeyCacheEvict(dev, keep) == TPM_RC_SUCCESS);
+}
+
+static int wolfTPM2_KeyCacheUse(WOLFTPM2_DEV* dev,
+    const WOLFTPM2_HANDLE* handle, const WOLFTPM2_HANDLE* keep)
+{
+    int rc;
+    WOLFTPM2_KEY_CACHE* cache = dev->keyCache;
+    WOLFTPM2_KEY_CACHE_ENTRY* entry = wolfTPM2_KeyCacheFind(dev, handle);
+    ContextLoad_In  loadIn;
+    ContextLoad_Out loadOut;
+
+    if (entry == NULL) {
+        /* not tracked */
+        return TPM_RC_SUCCESS;
+    }
+
+    entry->lastUse = ++cache->useCount;
+    if (!entry->saved) {
+        cache->stats.hits++;
+        return TPM_RC_SUCCESS;
+    }
+
+    if (wolfTPM2_KeyCacheLimit(cache) > 0 &&
+            (int)cache->stats.loaded >= wolfTPM2_KeyCacheLimit(cache)) {
+        rc = wolfTPM2_KeyCacheEvict(dev, keep);
+        if (rc != TPM_RC_SUCCESS)
+            return rc;
+    }
+
+    XMEMSET(&loadIn, 0, sizeof(loadIn));
+    loadIn.context = entry->context;
+    do {
+        rc = TPM2_ContextLoad(&loadIn, &loadOut);
+    } while (wolfTPM2_KeyCacheRetry(dev, rc, keep));
+    if (rc != TPM_RC_SUCCESS) {
+    #ifdef DEBUG_WOLFTPM
+        printf("Key cache reload failed %d: %s\n", rc,
+            wolfTPM2_GetRCString(rc));
+    #endif
+        return rc;
+    }
+
+    entry->handle->hndl = loadOut.loadedHandle;
+    entry->saved = 0;
+    cache->stats.reloads++;
+    cache->stats.loaded++;
+
+#ifdef DEBUG_WOLFTPM
+    printf("Key cache reloaded 0x%x\n", (word32)loadOut.loadedHandle);
+#endif
+
+    return TPM_RC_SUCCESS;
+}
+
+/* Stops tracking handle. Returns 1 if it was evicted (nothing to flush) */
+static int wolfTPM2_KeyCacheForget(WOLFTPM2_DEV* dev,
+    const WOLFTPM2_HANDLE* handle)
+{
+    int saved;
+    WOLFTPM2_KEY_CACHE_ENTRY* entry = wolfTPM2_KeyCacheFind(dev, handle);
+
+    if (entry == NULL)
+        return 0;
+
+    saved = entry->saved;
+    entry->handle = NULL;
+    entry->saved = 0;
+    entry->haveContext = 0;
+    dev->keyCache->stats.tracked--;
+    if (!saved)
+        dev->keyCache->stats.loaded--;
+
+    return saved;
+}
+
+int wolfTPM2_KeyCacheInit(WOLFTPM2_DEV* dev, WOLFTPM2_KEY_CACHE* cache,
+    int maxLoaded)
+{
+    if (dev == NULL || cache == NULL || maxLoaded < 0)
+        return BAD_FUNC_ARG;
+
+    XMEMSET(cache, 0, sizeof(WOLFTPM2_KEY_CACHE));
+    cache->maxLoaded = maxLoaded;
+    dev->keyCache = cache;
+
+    return TPM_RC_SUCCESS;
+}
+
+/* Detaches the cache. Evicted keys are left unloaded (handle TPM_RH_NULL) */
+int wolfTPM2_KeyCacheCleanup(WOLFTPM2_DEV* dev)
+{
+    if (dev == NULL)
+        return BAD_FUNC_ARG;
+
+    dev->keyCache = NULL;
+
+    return TPM_RC_SUCCESS;
+}
+
+int wolfTPM2_KeyCacheAdd(WOLFTPM2_DEV* dev, WOLFTPM2_KEY* key)
+{
+    int i;
+    WOLFTPM2_KEY_CACHE* cache;
+    WOLFTPM2_KEY_CACHE_ENTRY* entry = NULL;
+
+    if (dev == NULL || key == NULL || dev->keyCache == NULL)
+        return BAD_FUNC_ARG;
+
+    cache = dev->keyCache;
+    if (wolfTPM2_KeyCacheFind(dev, &key->handle) != NULL)
+        return TPM_RC_SUCCESS; /* already tracked */
+
+    /* only loaded transient objects can be context saved */
+    if ((key->handle.hndl >> HR_SHIFT) != TPM_HT_TRANSIENT)
+        return BAD_FUNC_ARG;
+
+    for (i = 0; i < WOLFTPM_KEY_CACHE_SZ; i++) {
+        if (cache->entry[i].handle == NULL) {
+            entry = &cache->entry[i];
+            break;
+        }
+    }
+    if (entry == NULL)
+        return BUFFER_E;
+
+    entry->handle = &key->handle;
+    entry->saved = 0;
+    entry->haveContext = 0;
+    entry->lastUse = ++cache->useCount;
+    cache->stats.tracked++;
+    cache->stats.loaded++;
+
+    if (wolfTPM2_KeyCacheLimit(cache) > 0 &&
+            (int)cache->stats.loaded > wolfTPM2_KeyCacheLimit(cache)) {
+        return wolfTPM2_KeyCacheEvict(dev, &key->handle);
+    }
+
+    return TPM_RC_SUCCESS;
+}
+
+int wolfTPM2_KeyCacheRemove(WOLFTPM2_DEV* dev, WOLFTPM2_KEY* key)
+{
+    int rc;
+
+    if (dev == NULL || key == NULL)
+        return BAD_FUNC_ARG;
+
+    /* hand the key back loaded */
+    rc = wolfTPM2_KeyCacheUse(dev, &key->handle, NULL);
+    if (rc == TPM_RC_SUCCESS)
+        (void)wolfTPM2_KeyCacheForget(dev, &key->handle);
+
+    return rc;
+}
+
+int wolfTPM2_KeyCacheGetStats(WOLFTPM2_DEV* dev,
+    WOLFTPM2_KEY_CACHE_STATS* stats)
+{
+    if (dev == NULL || stats == NULL || dev->keyCache == NULL)
+        return BAD_FUNC_ARG;
+
+    *stats = dev->keyCache->stats;
+
+    return TPM_RC_SUCCESS;
+}
+#endif /* WOLFTPM_KEY_CACHE */
+
+#ifdef WOLFTPM_STATS
+int wolfTPM2_StatsInit(WOLFTPM2_DEV* dev, TPM2_STATS* stats)
+{
+    if (dev == NULL)
+        return BAD_FUNC_ARG;
+
+    if (stats != NULL) {
+        /* detach while clearing, in case these are the attached counters */
+        int rc = TPM2_SetStats(&dev->ctx, NULL);
+        if (rc != TPM_RC_SUCCESS)
+            return rc;
+        XMEMSET(stats, 0, sizeof(*stats));
+    }
+    return TPM2_SetStats(&dev->ctx, stats);
+}
+
+int wolfTPM2_GetStats(WOLFTPM2_DEV* dev, TPM2_STATS* stats)
+{
+    if (dev == NULL)
+        return BAD_FUNC_ARG;
+
+    return TPM2_GetStats(&dev->ctx, stats);
+}
+
+static int StatsJsonAdvance(word32* pos, word32 bufSz, int len)
+{
+    if (len < 0 || (word32)len >= bufSz - *pos)
+        return BUFFER_E;
+    *pos += (word32)len;
+    return 0;
+}
+
+int wolfTPM2_StatsToJson(const TPM2_STATS* stats, char* buf, word32 bufSz)
+{
+    int rc, i, b, first = 1;
+    word32 pos = 0;
+    const TPM2_CMD_STATS* cmd;
+
+    if (stats == NULL || buf == NULL || bufSz == 0)
+        return BAD_FUNC_ARG;
+
+    rc = StatsJsonAdvance(&pos, bufSz, XSNPRINTF(buf, bufSz,
+        "{\"commands\":%lu,\"cmds\":[", (unsigned long)stats->commands));
+    for (i = 0; rc == 0 && i <= WOLFTPM_STATS_CMDS; i++) {
+        cmd = (i < WOLFTPM_STATS_CMDS) ? &stats->cmd[i] : &stats->other;
+        if (cmd->count == 0)
+            continue;
+
+        if (i < WOLFTPM_STATS_CMDS) {
+            rc = StatsJsonAdvance(&pos, bufSz, XSNPRINTF(&buf[pos],
+                bufSz - pos, "%s{\"cc\":\"0x%08lX\",", first ? "" : ",",
+                (unsigned long)cmd->cmdCode));
+        }
+        else {
+            rc = StatsJsonAdvance(&pos, bufSz, XSNPRINTF(&buf[pos],
+                bufSz - pos, "%s{\"cc\":\"other\",", first ? "" : ","));
+        }
+        first = 0;
+        if (rc == 0) {
+            rc = StatsJsonAdvance(&pos, bufSz, XSNPRINTF(&buf[pos],
+                bufSz - pos, "\"count\":%lu,\"errors\":%lu,\"retries\":%lu,"
+                "\"bytesOut\":%llu,\"bytesIn\":%llu,\"totalUs\":%llu,"
+                "\"maxUs\":%lu,\"lockWaitUs\":%llu,\"hist\":[",
+                (unsigned long)cmd->count, (unsigned long)cmd->errors,
+                (unsigned long)cmd->retries,
+                (unsigned long long)cmd->bytesOut,
+                (unsigned long long)cmd->bytesIn,
+                (unsigned long long)cmd->totalUs, (unsigned long)cmd->maxUs,
+                (unsigned long long)cmd->lockWaitUs));
+        }
+        for (b = 0; rc == 0 && b < WOLFTPM_STATS_HIST_BUCKETS; b++) {
+            rc = StatsJsonAdvance(&pos, bufSz, XSNPRINTF(&buf[pos],
+                bufSz - pos, "%s%lu", b ? "," : "",
+                (unsigned long)cmd->hist[b]));
+        }
+        if (rc == 0) {
+            rc = StatsJsonAdvance(&pos, bufSz, XSNPRINTF(&buf[pos],
+                bufSz - pos, "]}"));
+        }
+    }
+    if (rc == 0) {
+        rc = StatsJsonAdvance(&pos, bufSz, XSNPRINTF(&buf[pos], bufSz - pos,
+            "]}"));
+    }
+
+    return (rc == 0) ? (int)pos : rc;
+}
+#endif /* WOLFTPM_STATS */
+
 
 /******************************************************************************/
 /* --- END Wrapper Device Functions-- */
@@ -25,6 +25,14 @@
 #include <wolftpm/tpm2.h>
 #include <wolftpm/tpm2_wrap.h>
 #include <wolftpm/tpm2_param_enc.h>
+#include <wolftpm/tpm2_async.h>
+#include <wolftpm/tpm2_tis.h>
+#ifdef WOLFTPM_SWTPM
+#include <wolftpm/tpm2_swtpm.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <pthread.h>
+#endif
 
 #include <examples/tpm_io.h>
 #include <examples/tpm_test.h>
@@ -236,6 +244,252 @@ static void test_wolfTPM2_GetRandom(void)
         rc == 0 ? "Passed" : "Failed");
 }
 
+#ifdef WOLFTPM_SWTPM
+/* Simulator end that reads one whole command and closes without responding */
+static void* test_TPM2_SWTPM_DropPeer(void* arg)
+{
+    int fd = *(int*)arg;
+    byte buf[MAX_COMMAND_SIZE];
+    int got = 0, need = 9; /* send command, locality and size */
+    ssize_t n;
+
+    while (got < need && (n = recv(fd, buf + got, need - got, 0)) > 0) {
+        got += (int)n;
+        if (got == 9) {
+            need += (buf[5] << 24) | (buf[6] << 16) | (buf[7] << 8) | buf[8];
+        }
+    }
+    close(fd);
+    *(int*)arg = (got == need) ? 1 : 0;
+    return NULL;
+}
+
+static void test_TPM2_SWTPM_Connection(void)
+{
+    int rc;
+    int fd;
+    int sv[2];
+    pthread_t peer;
+    WOLFTPM2_DEV dev;
+    WOLFTPM2_BUFFER rngData;
+
+    rc = TPM2_SWTPM_Disconnect(NULL);
+    AssertIntNE(rc, 0);
+
+    rc = wolfTPM2_Init(&dev, TPM2_IoCb, NULL);
+    AssertIntEQ(rc, 0);
+
+    /* connection is kept between commands */
+    rc = wolfTPM2_GetRandom(&dev, rngData.buffer, sizeof(rngData.buffer));
+    AssertIntEQ(rc, 0);
+    fd = dev.ctx.tcpCtx.fd;
+    AssertIntGE(fd, 0);
+    rc = wolfTPM2_GetRandom(&dev, rngData.buffer, sizeof(rngData.buffer));
+    AssertIntEQ(rc, 0);
+    AssertIntEQ(dev.ctx.tcpCtx.fd, fd);
+
+    /* next command connects again */
+    rc = TPM2_SWTPM_Disconnect(&dev.ctx);
+    AssertIntEQ(rc, 0);
+    AssertIntLT(dev.ctx.tcpCtx.fd, 0);
+    rc = wolfTPM2_GetRandom(&dev, rngData.buffer, sizeof(rngData.buffer));
+    AssertIntEQ(rc, 0);
+
+    /* a dropped connection is replaced */
+    shutdown(dev.ctx.tcpCtx.fd, SHUT_RDWR);
+    rc = wolfTPM2_GetRandom(&dev, rngData.buffer, sizeof(rngData.buffer));
+    AssertIntEQ(rc, 0);
+
+    /* a connection closed by the peer while idle is replaced */
+    rc = TPM2_SWTPM_Disconnect(&dev.ctx);
+    AssertIntEQ(rc, 0);
+    AssertIntEQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+    close(sv[1]);
+    dev.ctx.tcpCtx.fd = sv[0];
+    rc = wolfTPM2_GetRandom(&dev, rngData.buffer, sizeof(rngData.buffer));
+    AssertIntEQ(rc, 0);
+    AssertIntGE(dev.ctx.tcpCtx.fd, 0);
+
+    /* a command that was fully sent is not sent again, the peer may have run
+     * it */
+    rc = TPM2_SWTPM_Disconnect(&dev.ctx);
+    AssertIntEQ(rc, 0);
+    AssertIntEQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+    dev.ctx.tcpCtx.fd = sv[0];
+    AssertIntEQ(pthread_create(&peer, NULL, test_TPM2_SWTPM_DropPeer,
+        &sv[1]), 0);
+    rc = wolfTPM2_GetRandom(&dev, rngData.buffer, sizeof(rngData.buffer));
+    pthread_join(peer, NULL);
+    AssertIntNE(rc, 0);
+    AssertIntEQ(sv[1], 1);
+    AssertIntLT(dev.ctx.tcpCtx.fd, 0);
+    rc = wolfTPM2_GetRandom(&dev, rngData.buffer, sizeof(rngData.buffer));
+    AssertIntEQ(rc, 0);
+
+    wolfTPM2_Cleanup(&dev);
+    AssertIntLT(dev.ctx.tcpCtx.fd, 0);
+
+    printf("Test TPM2:		SWTPM Connection:	%s\n",
+        rc == 0 ? "Passed" : "Failed");
+}
+#endif /* WOLFTPM_SWTPM */
+
+#ifdef WOLFTPM_KEY_CACHE
+#define TEST_KEY_CACHE_KEYS 4
+static void test_wolfTPM2_KeyCache(void)
+{
+    int rc, i, round;
+    WOLFTPM2_DEV dev;
+    static WOLFTPM2_KEY_CACHE cache;
+    WOLFTPM2_KEY_CACHE_STATS stats;
+    WOLFTPM2_KEY srk;
+    WOLFTPM2_KEY key[TEST_KEY_CACHE_KEYS];
+    TPMT_PUBLIC publicTemplate;
+    byte digest[TPM_SHA256_DIGEST_SIZE];
+    byte sig[MAX_ECC_BYTES * 2];
+    int sigSz;
+
+    rc = wolfTPM2_Init(&dev, TPM2_IoCb, NULL);
+    AssertIntEQ(rc, 0);
+
+    /* Test arguments */
+    rc = wolfTPM2_KeyCacheInit(NULL, &cache, 0);
+    AssertIntNE(rc, 0);
+    rc = wolfTPM2_KeyCacheInit(&dev, &cache, -1);
+    AssertIntNE(rc, 0);
+    rc = wolfTPM2_KeyCacheAdd(&dev, &key[0]); /* no cache attached */
+    AssertIntNE(rc, 0);
+
+    /* two tracked keys plus the SRK fit the minimum of three slots */
+    rc = wolfTPM2_KeyCacheInit(&dev, &cache, 2);
+    AssertIntEQ(rc, 0);
+
+    rc = wolfTPM2_CreateSRK(&dev, &srk, TPM_ALG_ECC, NULL, 0);
+    AssertIntEQ(rc, 0);
+    rc = wolfTPM2_GetKeyTemplate_ECC(&publicTemplate,
+        TPMA_OBJECT_sensitiveDataOrigin | TPMA_OBJECT_userWithAuth |
+        TPMA_OBJECT_sign | TPMA_OBJECT_noDA, TPM_ECC_NIST_P256, TPM_ALG_ECDSA);
+    AssertIntEQ(rc, 0);
+
+    for (i = 0; i < TEST_KEY_CACHE_KEYS; i++) {
+        rc = wolfTPM2_CreateAndLoadKey(&dev, &key[i], &srk.handle,
+            &publicTemplate, NULL, 0);
+        AssertIntEQ(rc, 0);
+        rc = wolfTPM2_KeyCacheAdd(&dev, &key[i]);
+        AssertIntEQ(rc, 0);
+    }
+    rc = wolfTPM2_KeyCacheAdd(&dev, &key[0]); /* already tracked */
+    AssertIntEQ(rc, 0);
+
+    rc = wolfTPM2_KeyCacheGetStats(&dev, &stats);
+    AssertIntEQ(rc, 0);
+    AssertIntEQ(stats.tracked, TEST_KEY_CACHE_KEYS);
+    AssertIntEQ(stats.loaded, 2);
+    AssertIntEQ(key[0].handle.hndl, TPM_RH_NULL); /* oldest were evicted */
+
+    /* sign with each key in turn */
+    XMEMSET(digest, 0x11, sizeof(digest));
+    for (round = 0; round < 2; round++) {
+        for (i = 0; i < TEST_KEY_CACHE_KEYS; i++) {
+            sigSz = (int)sizeof(sig);
+            rc = wolfTPM2_SignHash(&dev, &key[i], digest, sizeof(digest),
+                sig, &sigSz);
+            AssertIntEQ(rc, 0);
+        }
+    }
+
+    rc = wolfTPM2_KeyCacheGetStats(&dev, &stats);
+    AssertIntEQ(rc, 0);
+    AssertIntEQ(stats.loaded, 2);
+    AssertIntGT(stats.reloads, 0);
+    AssertIntEQ(stats.evictions, stats.reloads + TEST_KEY_CACHE_KEYS - 2);
+    /* each key is only context saved once */
+    AssertIntEQ(stats.saves, TEST_KEY_CACHE_KEYS);
+
+    /* removed keys are handed back loaded */
+    rc = wolfTPM2_KeyCacheRemove(&dev, &key[0]);
+    AssertIntEQ(rc, 0);
+    AssertIntNE(key[0].handle.hndl, TPM_RH_NULL);
+
+    for (i = 0; i < TEST_KEY_CACHE_KEYS; i++) {
+        rc = wolfTPM2_UnloadHandle(&dev, &key[i].handle);
+        AssertIntEQ(rc, 0);
+    }
+    rc = wolfTPM2_KeyCacheGetStats(&dev, &stats);
+    AssertIntEQ(rc, 0);
+    AssertIntEQ(stats.tracked, 0);
+    AssertIntEQ(stats.loaded, 0);
+
+    wolfTPM2_UnloadHandle(&dev, &srk.handle);
+    wolfTPM2_KeyCacheCleanup(&dev);
+    wolfTPM2_Cleanup(&dev);
+
+    printf("Test TPM Wrapper:\tKey Cache:\t%s\n",
+        rc == 0 ? "Passed" : "Failed");
+}
+#endif /* WOLFTPM_KEY_CACHE */
+
+#ifdef WOLFTPM_STATS
+#define TEST_STATS_CMDS 4
+
+static void test_wolfTPM2_Stats(void)
+{
+    int rc, i, b;
+    word32 histSum = 0;
+    WOLFTPM2_DEV dev;
+    TPM2_STATS attached, stats;
+    TPM2_CMD_STATS* cmd = NULL;
+    byte rng[16];
+    char json[2048];
+
+    rc = wolfTPM2_Init(&dev, TPM2_IoCb, NULL);
+    AssertIntEQ(rc, 0);
+
+    /* Test arguments */
+    AssertIntNE(wolfTPM2_StatsInit(NULL, &attached), 0);
+    AssertIntNE(wolfTPM2_GetStats(&dev, &stats), 0); /* not attached */
+    AssertIntNE(wolfTPM2_StatsToJson(NULL, json, sizeof(json)), 0);
+
+    rc = wolfTPM2_StatsInit(&dev, &attached);
+    AssertIntEQ(rc, 0);
+    for (i = 0; i < TEST_STATS_CMDS; i++) {
+        rc = wolfTPM2_GetRandom(&dev, rng, sizeof(rng));
+        AssertIntEQ(rc, 0);
+    }
+
+    rc = wolfTPM2_GetStats(&dev, &stats);
+    AssertIntEQ(rc, 0);
+    AssertIntEQ(stats.commands, TEST_STATS_CMDS);
+    for (i = 0; i < WOLFTPM_STATS_CMDS; i++) {
+        if (stats.cmd[i].cmdCode == TPM_CC_GetRandom)
+            cmd = &stats.cmd[i];
+    }
+    AssertNotNull(cmd);
+    AssertIntEQ(cmd->count, TEST_STATS_CMDS);
+    AssertIntEQ(cmd->errors, 0);
+    AssertIntEQ(cmd->bytesOut, TEST_STATS_CMDS * (TPM2_HEADER_SIZE + 2));
+    AssertIntEQ(cmd->bytesIn,
+        TEST_STATS_CMDS * (TPM2_HEADER_SIZE + 2 + sizeof(rng)));
+    AssertTrue(cmd->totalUs >= cmd->maxUs);
+    for (b = 0; b < WOLFTPM_STATS_HIST_BUCKETS; b++)
+        histSum += cmd->hist[b];
+    AssertIntEQ(histSum, TEST_STATS_CMDS);
+
+    rc = wolfTPM2_StatsToJson(&stats, json, sizeof(json));
+    AssertIntGT(rc, 0);
+    AssertIntEQ(rc, (int)XSTRLEN(json));
+    AssertNotNull(strstr(json, "\"cc\":\"0x0000017B\",\"count\":4,"));
+    AssertIntEQ(wolfTPM2_StatsToJson(&stats, json, 32), BUFFER_E);
+
+    rc = wolfTPM2_StatsInit(&dev, NULL);
+    AssertIntEQ(rc, 0);
+    wolfTPM2_Cleanup(&dev);
+
+    printf("Test TPM Wrapper:\tStats:\t\t%s\n",
+        rc == 0 ? "Passed" : "Failed");
+}
+#endif /* WOLFTPM_STATS */
+
 static void test_wolfTPM2_Cleanup(void)
 {
     int rc;
@@ -287,6 +541,428 @@ static void test_TPM2_KDFa(void)
 
 #endif /* !WOLFTPM2_NO_WRAPPER */
 
+#ifndef WOLFTPM2_NO_WOLFCRYPT
+/* Session HMAC and KDFa (cached pads with WOLFTPM_SESSION_CACHE) must match
+ * TPM2_CalcHmac and TPM2_KDFa byte for byte */
+static void test_TPM2_SessionHmac(void)
+{
+    int rc, i, j, k;
+    TPM2_AUTH_SESSION session;
+    TPM2B_DIGEST hash;
+    TPM2B_NONCE nonceNew, nonceOld;
+    TPM2B_AUTH hmac, hmacExp;
+    byte key[64], keyExp[64];
+    const TPMI_ALG_HASH algs[] = {
+    #ifndef NO_SHA
+        TPM_ALG_SHA1,
+    #endif
+        TPM_ALG_SHA256,
+    #ifdef WOLFSSL_SHA384
+        TPM_ALG_SHA384,
+    #endif
+    };
+    /* AES-128 key, partial block, whole block, AES-256 key + IV */
+    const UINT32 keySzs[] = { 16, 20, 32, 48, 64 };
+
+    XMEMSET(&session, 0, sizeof(session));
+    XMEMSET(&hash, 0, sizeof(hash));
+    XMEMSET(&nonceNew, 0, sizeof(nonceNew));
+    XMEMSET(&nonceOld, 0, sizeof(nonceOld));
+    hash.size = 32;
+    nonceNew.size = nonceOld.size = 16;
+    for (i = 0; i < hash.size; i++)
+        hash.buffer[i] = (byte)i;
+    for (i = 0; i < nonceNew.size; i++) {
+        nonceNew.buffer[i] = (byte)(0x80 + i);
+        nonceOld.buffer[i] = (byte)(0xC0 + i);
+    }
+
+    for (i = 0; i < (int)(sizeof(algs) / sizeof(algs[0])); i++) {
+        session.authHash = algs[i];
+        /* empty auth, then the auth is replaced twice */
+        for (j = 0; j < 3; j++) {
+            session.auth.size = (UINT16)(j * 10);
+            for (k = 0; k < session.auth.size; k++)
+                session.auth.buffer[k] = (byte)(j * 0x11 + k);
+
+            rc = TPM2_CalcSessionHmac(&session, &hash, &nonceNew, &nonceOld,
+                TPMA_SESSION_continueSession, &hmac);
+            AssertIntEQ(rc, 0);
+            rc = TPM2_CalcHmac(session.authHash, &session.auth, &hash,
+                &nonceNew, &nonceOld, TPMA_SESSION_continueSession, &hmacExp);
+            AssertIntEQ(rc, 0);
+            AssertIntEQ(hmac.size, hmacExp.size);
+            AssertIntEQ(XMEMCMP(hmac.buffer, hmacExp.buffer, hmac.size), 0);
+
+            for (k = 0; k < (int)(sizeof(keySzs) / sizeof(keySzs[0])); k++) {
+                XMEMSET(key, 0xAA, sizeof(key));
+                XMEMSET(keyExp, 0xAA, sizeof(keyExp));
+                rc = TPM2_KDFaSession(&session, &session.auth, "CFB",
+                    &nonceNew, &nonceOld, key, keySzs[k]);
+                AssertIntEQ(rc, (int)keySzs[k]);
+                rc = TPM2_KDFa(session.authHash, (TPM2B_DATA*)&session.auth,
+                    "CFB", &nonceNew, &nonceOld, keyExp, keySzs[k]);
+                AssertIntEQ(rc, (int)keySzs[k]);
+                /* compare past keySz too, nothing may be written there */
+                AssertIntEQ(XMEMCMP(key, keyExp, sizeof(key)), 0);
+            }
+        }
+    }
+
+    TPM2_SessionHmacFree(&session);
+#ifdef WOLFTPM_SESSION_CACHE
+    for (i = 0; i < (int)sizeof(session.hmacCache); i++)
+        AssertIntEQ(((byte*)&session.hmacCache)[i], 0);
+#endif
+
+    printf("Test TPM2:\t\tSession HMAC / KDFa:\t%s\n", "Passed");
+}
+#endif /* !WOLFTPM2_NO_WOLFCRYPT */
+
+#ifdef WOLFTPM_ASYNC_QUEUE
+static int gAsyncDoneCount;
+
+static TPM_RC test_TPM2_Async_CmdCb(TPM2_ASYNC_REQ* req)
+{
+    /* echo the input value to output */
+    *(int*)req->out = *(int*)req->in;
+    return (*(int*)req->in < 0) ? TPM_RC_FAILURE : TPM_RC_SUCCESS;
+}
+
+static void test_TPM2_Async_DoneCb(TPM2_ASYNC_REQ* req)
+{
+    (void)req;
+    gAsyncDoneCount++;
+}
+
+static int test_TPM2_Async_CreateFail(TPM2_CTX* ctx, void* userCtx)
+{
+    (void)ctx;
+    (void)userCtx;
+    return MEMORY_E;
+}
+
+#if defined(__linux__) && !defined(SINGLE_THREADED)
+#include <pthread.h>
+
+static void* test_TPM2_Async_Task(void* arg)
+{
+    TPM2_Async_ServiceTask(arg);
+    return NULL;
+}
+
+static int test_TPM2_Async_Create(TPM2_CTX* ctx, void* userCtx)
+{
+    return pthread_create((pthread_t*)userCtx, NULL, test_TPM2_Async_Task,
+        ctx) == 0 ? 0 : MEMORY_E;
+}
+#endif
+
+static void test_TPM2_Async(void)
+{
+    int rc, i;
+    TPM2_CTX ctx;
+    TPM2_ASYNC_QUEUE queue;
+    TPM2_ASYNC_STATS stats;
+    TPM2_ASYNC_REQ req[WOLFTPM_ASYNC_QUEUE_SZ + 1];
+    int in[WOLFTPM_ASYNC_QUEUE_SZ + 1], out[WOLFTPM_ASYNC_QUEUE_SZ + 1];
+
+    XMEMSET(&ctx, 0, sizeof(ctx));
+    XMEMSET(req, 0, sizeof(req));
+    gAsyncDoneCount = 0;
+
+    /* Test arguments */
+    rc = TPM2_Async_Init(NULL, &queue);
+    AssertIntNE(rc, 0);
+    rc = TPM2_Async_Submit(&ctx, &req[0]);
+    AssertIntNE(rc, 0);
+    rc = TPM2_Async_Poll(NULL);
+    AssertIntNE(rc, 0);
+    rc = TPM2_Async_Start(NULL, test_TPM2_Async_CreateFail, NULL);
+    AssertIntNE(rc, 0);
+    rc = TPM2_Async_Stop(NULL);
+    AssertIntNE(rc, 0);
+
+    rc = TPM2_Async_Init(&ctx, &queue);
+    AssertIntEQ(rc, 0);
+    rc = TPM2_Async_Stop(&ctx); /* no service task, must not wait */
+    AssertIntEQ(rc, 0);
+    rc = TPM2_Async_Submit(&ctx, &req[0]); /* no command callback */
+    AssertIntEQ(rc, BAD_FUNC_ARG);
+    rc = TPM2_Async_Start(&ctx, NULL, NULL);
+    AssertIntEQ(rc, BAD_FUNC_ARG);
+    /* task not created, the queue is left without a task */
+    rc = TPM2_Async_Start(&ctx, test_TPM2_Async_CreateFail, NULL);
+    AssertIntEQ(rc, MEMORY_E);
+    AssertIntEQ(queue.task, TPM2_ASYNC_TASK_NONE);
+    rc = TPM2_Async_Stop(&ctx);
+    AssertIntEQ(rc, 0);
+
+    /* Fill queue, one extra must be rejected */
+    for (i = 0; i <= WOLFTPM_ASYNC_QUEUE_SZ; i++) {
+        in[i] = (i == 1) ? -1 : i;
+        out[i] = 0;
+        req[i].cmdCb = test_TPM2_Async_CmdCb;
+        req[i].doneCb = test_TPM2_Async_DoneCb;
+        req[i].in = &in[i];
+        req[i].out = &out[i];
+        req[i].cmdCode = (i & 1) ? TPM_CC_GetRandom : TPM_CC_PCR_Extend;
+        rc = TPM2_Async_Submit(&ctx, &req[i]);
+        if (i < WOLFTPM_ASYNC_QUEUE_SZ)
+            AssertIntEQ(rc, 0);
+        else
+            AssertIntEQ(rc, BUFFER_E);
+    }
+    AssertIntEQ(TPM2_Async_Poll(&req[0]), WC_PENDING_E);
+
+    /* Run two, then wait inline for the last (services the rest in order) */
+    AssertIntEQ(TPM2_Async_Service(&ctx, 2), 2);
+    AssertIntEQ(TPM2_Async_Poll(&req[0]), 0);
+    AssertIntEQ(TPM2_Async_Poll(&req[1]), TPM_RC_FAILURE);
+    rc = TPM2_Async_Wait(&ctx, &req[WOLFTPM_ASYNC_QUEUE_SZ-1]);
+    AssertIntEQ(rc, 0);
+    for (i = 0; i < WOLFTPM_ASYNC_QUEUE_SZ; i++) {
+        AssertIntEQ(out[i], in[i]);
+    }
+    AssertIntEQ(gAsyncDoneCount, WOLFTPM_ASYNC_QUEUE_SZ);
+
+    rc = TPM2_Async_GetStats(&ctx, &stats);
+    AssertIntEQ(rc, 0);
+    AssertIntEQ(stats.submitted, WOLFTPM_ASYNC_QUEUE_SZ);
+    AssertIntEQ(stats.completed, WOLFTPM_ASYNC_QUEUE_SZ);
+    AssertIntEQ(stats.rejected, 1);
+    AssertIntEQ(stats.depth, 0);
+    AssertIntEQ(stats.maxDepth, WOLFTPM_ASYNC_QUEUE_SZ);
+    AssertIntEQ(stats.cmd[0].count + stats.cmd[1].count,
+        WOLFTPM_ASYNC_QUEUE_SZ);
+
+#if defined(__linux__) && !defined(SINGLE_THREADED)
+    /* service task runs requests, stop joins it and a restart works */
+    for (i = 0; i < 2; i++) {
+        pthread_t task;
+        rc = TPM2_Async_Start(&ctx, test_TPM2_Async_Create, &task);
+        AssertIntEQ(rc, 0);
+        AssertIntEQ(TPM2_Async_Start(&ctx, test_TPM2_Async_Create, &task),
+            BAD_STATE_E);
+        in[0] = 100 + i;
+        rc = TPM2_Async_Submit(&ctx, &req[0]);
+        AssertIntEQ(rc, 0);
+        rc = TPM2_Async_Wait(&ctx, &req[0]);
+        AssertIntEQ(rc, 0);
+        AssertIntEQ(out[0], 100 + i);
+        rc = TPM2_Async_Stop(&ctx);
+        AssertIntEQ(rc, 0);
+        AssertIntEQ(queue.task, TPM2_ASYNC_TASK_STOPPED);
+        pthread_join(task, NULL);
+    }
+#endif
+
+    rc = TPM2_Async_Cleanup(&ctx);
+    AssertIntEQ(rc, 0);
+
+    printf("Test TPM2:		Async Queue:	%s\n",
+        rc == 0 ? "Passed" : "Failed");
+}
+#endif /* WOLFTPM_ASYNC_QUEUE */
+
+#if defined(WOLFTPM_TIS_STATS) && !defined(WOLFTPM_LINUX_DEV) && \
+    !defined(WOLFTPM_SWTPM) && !defined(WOLFTPM_WINAPI) && \
+    !defined(WOLFTPM_ADV_IO) && !defined(WOLFTPM_I2C)
+#define TEST_TIS_FIFO_SZ   32
+#define TEST_TIS_BUSY_POLLS 5
+
+/* Mock TIS SPI device: one locality, a TEST_TIS_FIFO_SZ byte FIFO and a
+ * command that completes after TEST_TIS_BUSY_POLLS status reads */
+typedef struct TestTisDev {
+    byte   cmd[MAX_COMMAND_SIZE];
+    byte   rsp[MAX_RESPONSE_SIZE];
+    int    cmdSz;
+    int    rspSz;
+    int    rspPos;
+    int    busy;
+    int    executing;
+    word32 xfers;
+    word32 bytes;
+} TestTisDev;
+
+static word32 test_TPM2_TIS_GetU32(const byte* buf)
+{
+    return ((word32)buf[0] << 24) | ((word32)buf[1] << 16) |
+           ((word32)buf[2] << 8) | buf[3];
+}
+
+static void test_TPM2_TIS_Execute(TestTisDev* dev)
+{
+    int i, sz = TPM2_HEADER_SIZE;
+
+    if (test_TPM2_TIS_GetU32(&dev->cmd[6]) == TPM_CC_GetRandom) {
+        int req = (dev->cmd[10] << 8) | dev->cmd[11];
+        dev->rsp[sz++] = (byte)(req >> 8);
+        dev->rsp[sz++] = (byte)req;
+        for (i = 0; i < req; i++)
+            dev->rsp[sz++] = (byte)i;
+    }
+    XMEMSET(dev->rsp, 0, TPM2_HEADER_SIZE);
+    dev->rsp[0] = (byte)(TPM_ST_NO_SESSIONS >> 8);
+    dev->rsp[1] = (byte)TPM_ST_NO_SESSIONS;
+    dev->rsp[4] = (byte)(sz >> 8);
+    dev->rsp[5] = (byte)sz;
+    dev->rspSz = sz;
+    dev->rspPos = 0;
+    dev->busy = TEST_TIS_BUSY_POLLS;
+    dev->executing = 1;
+}
+
+static void test_TPM2_TIS_ReadReg(TestTisDev* dev, word32 reg, byte* buf,
+    int len)
+{
+    int i;
+    byte sts[4];
+    word16 burst = 0;
+    word32 val = 0;
+
+    switch (reg) {
+        case 0x0000: /* TPM_ACCESS */
+            buf[0] = 0xA0; /* valid, active locality */
+            return;
+        case 0x0F00: /* TPM_DID_VID */
+            val = 0x001B15D1;
+            break;
+        case 0x0024: /* TPM_DATA_FIFO */
+            for (i = 0; i < len && dev->rspPos < dev->rspSz; i++)
+                buf[i] = dev->rsp[dev->rspPos++];
+            return;
+        default:
+            break;
+    }
+    if (reg >= 0x0018 && reg < 0x001C) { /* TPM_STS and burst count */
+        sts[0] = 0x80; /* valid */
+        if (dev->executing && dev->busy > 0) {
+            dev->busy--;
+        }
+        else if (dev->executing) {
+            if (dev->rspPos < dev->rspSz) {
+                sts[0] |= 0x10; /* data available */
+                burst = (word16)(dev->rspSz - dev->rspPos);
+            }
+        }
+        else {
+            if (dev->cmdSz == 0)
+                sts[0] |= 0x40; /* command ready */
+            else if (dev->cmdSz < TPM2_HEADER_SIZE ||
+                    (word32)dev->cmdSz < test_TPM2_TIS_GetU32(&dev->cmd[2]))
+                sts[0] |= 0x08; /* expect more data */
+            burst = TEST_TIS_FIFO_SZ;
+        }
+        if (burst > TEST_TIS_FIFO_SZ)
+            burst = TEST_TIS_FIFO_SZ;
+        sts[1] = (byte)burst;
+        sts[2] = (byte)(burst >> 8);
+        sts[3] = 0;
+        for (i = 0; i < len && (reg - 0x0018) + i < sizeof(sts); i++)
+            buf[i] = sts[(reg - 0x0018) + i];
+        return;
+    }
+    for (i = 0; i < len && i < (int)sizeof(val); i++)
+        buf[i] = (byte)(val >> (8 * i));
+}
+
+static void test_TPM2_TIS_WriteReg(TestTisDev* dev, word32 reg,
+    const byte* buf, int len)
+{
+    if (reg == 0x0018) { /* TPM_STS */
+        if (buf[0] & 0x40) { /* command ready: abort / finish */
+            dev->cmdSz = 0;
+            dev->executing = 0;
+        }
+        if ((buf[0] & 0x20) && !dev->executing) /* go */
+            test_TPM2_TIS_Execute(dev);
+    }
+    else if (reg == 0x0024 && !dev->executing &&
+            dev->cmdSz + len <= (int)sizeof(dev->cmd)) {
+        XMEMCPY(&dev->cmd[dev->cmdSz], buf, len);
+        dev->cmdSz += len;
+    }
+}
+
+static int test_TPM2_TIS_MockIoCb(TPM2_CTX* ctx, const byte* txBuf,
+    byte* rxBuf, word16 xferSz, void* userCtx)
+{
+    TestTisDev* dev = (TestTisDev*)userCtx;
+    int len = (txBuf[0] & 0x3F) + 1;
+    word32 reg = ((word32)txBuf[2] << 8 | txBuf[3]) & 0x0FFF;
+
+    if (xferSz != len + TPM_TIS_HEADER_SZ)
+        return TPM_RC_FAILURE;
+    XMEMSET(rxBuf, 0, xferSz);
+    rxBuf[TPM_TIS_HEADER_SZ-1] = TPM_TIS_READY_MASK;
+    if (txBuf[0] & TPM_TIS_READ)
+        test_TPM2_TIS_ReadReg(dev, reg, &rxBuf[TPM_TIS_HEADER_SZ], len);
+    else
+        test_TPM2_TIS_WriteReg(dev, reg, &txBuf[TPM_TIS_HEADER_SZ], len);
+    dev->xfers++;
+    dev->bytes += xferSz;
+
+    (void)ctx;
+    return TPM_RC_SUCCESS;
+}
+
+static void test_TPM2_TIS_Stats(void)
+{
+    int rc, i;
+    TPM2_CTX ctx;
+    TPM2_TIS_STATS stats;
+    TPM2_TIS_CC_STATS *getRand, *stir;
+    TestTisDev dev;
+    GetRandom_In getIn;
+    GetRandom_Out getOut;
+    StirRandom_In stirIn;
+
+    XMEMSET(&dev, 0, sizeof(dev));
+    rc = TPM2_Init(&ctx, test_TPM2_TIS_MockIoCb, &dev);
+    AssertIntEQ(rc, 0);
+
+    AssertIntNE(TPM2_TIS_SetStats(NULL, &stats), 0);
+    AssertNull(TPM2_TIS_GetCcStats(NULL, TPM_CC_GetRandom));
+    rc = TPM2_TIS_SetStats(&ctx, &stats);
+    AssertIntEQ(rc, 0);
+    dev.xfers = dev.bytes = 0;
+
+    /* response larger than the FIFO */
+    getIn.bytesRequested = 32;
+    rc = TPM2_GetRandom(&getIn, &getOut);
+    AssertIntEQ(rc, 0);
+    AssertIntEQ(getOut.randomBytes.size, 32);
+    for (i = 0; i < 32; i++) {
+        AssertIntEQ(getOut.randomBytes.buffer[i], i);
+    }
+
+    /* command larger than the FIFO */
+    XMEMSET(&stirIn, 0x5A, sizeof(stirIn));
+    stirIn.inData.size = 48;
+    rc = TPM2_StirRandom(&stirIn);
+    AssertIntEQ(rc, 0);
+    AssertIntEQ(dev.cmdSz, 0); /* command ready written at end */
+
+    getRand = TPM2_TIS_GetCcStats(&stats, TPM_CC_GetRandom);
+    stir = TPM2_TIS_GetCcStats(&stats, TPM_CC_StirRandom);
+    AssertIntEQ(getRand->cmds, 1);
+    AssertIntEQ(stir->cmds, 1);
+    AssertIntEQ(getRand->xfers + stir->xfers, dev.xfers);
+    AssertIntEQ(getRand->bytes + stir->bytes, dev.bytes);
+    AssertIntEQ(stats.other.xfers, 0);
+    AssertIntEQ(ctx.tisCmdCode, 0);
+
+    rc = TPM2_TIS_SetStats(&ctx, NULL);
+    AssertIntEQ(rc, 0);
+    TPM2_Cleanup(&ctx);
+
+    printf("Test TPM2:\t\tTIS Stats:\t%s (GetRandom %u xfers %u bytes, "
+        "StirRandom %u xfers %u bytes)\n", rc == 0 ? "Passed" : "Failed",
+        getRand->xfers, getRand->bytes, stir->xfers, stir->bytes);
+}
+#endif /* WOLFTPM_TIS_STATS && TIS transport */
+
 #ifndef NO_MAIN_DRIVER
 int main(int argc, char *argv[])
 #else
@@ -302,9 +978,29 @@ int unit_tests(int argc, char *argv[])
     test_wolfTPM2_GetCapabilities();
     test_wolfTPM2_ReadPublicKey();
     test_wolfTPM2_GetRandom();
+#ifdef WOLFTPM_SWTPM
+    test_TPM2_SWTPM_Connection();
+#endif
+#ifdef WOLFTPM_KEY_CACHE
+    test_wolfTPM2_KeyCache();
+#endif
+#ifdef WOLFTPM_STATS
+    test_wolfTPM2_Stats();
+#endif
     test_wolfTPM2_Cleanup();
     test_TPM2_KDFa();
 #endif /* !WOLFTPM2_NO_WRAPPER */
+#ifndef WOLFTPM2_NO_WOLFCRYPT
+    test_TPM2_SessionHmac();
+#endif
+#ifdef WOLFTPM_ASYNC_QUEUE
+    test_TPM2_Async();
+#endif
+#if defined(WOLFTPM_TIS_STATS) && !defined(WOLFTPM_LINUX_DEV) && \
+    !defined(WOLFTPM_SWTPM) && !defined(WOLFTPM_WINAPI) && \
+    !defined(WOLFTPM_ADV_IO) && !defined(WOLFTPM_I2C)
+    test_TPM2_TIS_Stats();
+#endif
 
     return 0;
 }
@@ -1578,6 +1578,16 @@ typedef struct TPMS_AUTH_RESPONSE {
     TPM2B_AUTH hmac;
 } TPMS_AUTH_RESPONSE;
 
+#if defined(WOLFTPM_SESSION_CACHE) && !defined(WOLFTPM2_NO_WOLFCRYPT)
+/* Session HMAC key with the hash states after the inner and outer pads */
+typedef struct TPM2_HMAC_CACHE {
+    TPMI_ALG_HASH authHash; /* zero when not yet derived */
+    TPM2B_AUTH key;         /* key the pad states were derived from */
+    wc_HashAlg inner;       /* hash of (key ^ ipad) */
+    wc_HashAlg outer;       /* hash of (key ^ opad) */
+} TPM2_HMAC_CACHE;
+#endif
+
 /* Implementation specific authorization session information */
 typedef struct TPM2_AUTH_SESSION {
     /* BEGIN */
@@ -1593,6 +1603,11 @@ typedef struct TPM2_AUTH_SESSION {
     TPMT_SYM_DEF symmetric;
     TPMI_ALG_HASH authHash;
     TPM2B_NAME name;
+#if defined(WOLFTPM_SESSION_CACHE) && !defined(WOLFTPM2_NO_WOLFCRYPT)
+    /* HMAC pads for the session auth, shared by the command / response
+     * HMAC and the parameter encryption KDFa (see tpm2_param_enc.c) */
+    TPM2_HMAC_CACHE hmacCache;
+#endif
 } TPM2_AUTH_SESSION;
 
 
@@ -1652,6 +1667,37 @@ typedef int (*TPM2HalIoCb)(struct TPM2_CTX*, const BYTE* txBuf, BYTE* rxBuf,
     #define WOLFTPM2_USE_WOLF_RNG
 #endif
 
+#ifdef WOLFTPM_STATS
+#ifndef WOLFTPM_STATS_CMDS
+    #define WOLFTPM_STATS_CMDS 24
+#endif
+#ifndef WOLFTPM_STATS_HIST_BUCKETS
+    #define WOLFTPM_STATS_HIST_BUCKETS 24
+#endif
+
+/* Counters for one command code. Latency is the transport and TPM execution
+ * time of the command. hist[0] counts 0us, hist[i] counts latencies of
+ * 2^(i-1) to 2^i - 1 us and the last bucket also everything longer */
+typedef struct TPM2_CMD_STATS {
+    TPM_CC cmdCode;
+    word32 count;
+    word32 errors;      /* transport errors and error response codes */
+    word32 retries;     /* TPM_RC_RETRY, TPM_RC_YIELDED or TPM_RC_TESTING */
+    word64 bytesOut;    /* command bytes */
+    word64 bytesIn;     /* response bytes */
+    word64 totalUs;
+    word32 maxUs;
+    word64 lockWaitUs;  /* time waiting for the TPM context lock */
+    word32 hist[WOLFTPM_STATS_HIST_BUCKETS];
+} TPM2_CMD_STATS;
+
+typedef struct TPM2_STATS {
+    word32 commands;
+    TPM2_CMD_STATS cmd[WOLFTPM_STATS_CMDS]; /* in order of first use */
+    TPM2_CMD_STATS other; /* commands once all cmd entries are used */
+} TPM2_STATS;
+#endif /* WOLFTPM_STATS */
+
 typedef struct TPM2_CTX {
     TPM2HalIoCb ioCb;
     void* userCtx;
@@ -1682,6 +1728,21 @@ typedef struct TPM2_CTX {
     /* Command / Response Buffer */
     byte cmdBuf[MAX_COMMAND_SIZE];
 
+#ifdef WOLFTPM_ASYNC_QUEUE
+    /* Asynchronous command queue (see tpm2_async.h) */
+    struct TPM2_ASYNC_QUEUE* asyncQueue;
+#endif
+#ifdef WOLFTPM_STATS
+    /* Command statistics (see TPM2_SetStats) */
+    TPM2_STATS* stats;
+    word32 statsLockUs; /* lock wait not yet assigned to a command */
+#endif
+#ifdef WOLFTPM_TIS_STATS
+    /* TIS transaction counters (see TPM2_TIS_SetStats) */
+    struct TPM2_TIS_STATS* tisStats;
+    TPM_CC tisCmdCode;
+#endif
+
     /* Informational Bits - use unsigned int for best compiler compatibility */
 #ifndef WOLFTPM2_NO_WOLFCRYPT
     #ifndef SINGLE_THREADED
@@ -2782,6 +2843,14 @@ WOLFTPM_API TPM_RC TPM2_ChipStartup(TPM2_CTX* ctx, int timeoutTries);
  */
 WOLFTPM_API TPM_RC TPM2_SetHalIoCb(TPM2_CTX* ctx, TPM2HalIoCb ioCb, void* userCtx);
 WOLFTPM_API TPM_RC TPM2_SetSessionAuth(TPM2_AUTH_SESSION *session);
+#ifdef WOLFTPM_STATS
+/* Attach (or detach with NULL) caller owned command statistics. Counting
+ * continues from the current values. TPM2_Init clears the context, so call
+ * this after init */
+WOLFTPM_API TPM_RC TPM2_SetStats(TPM2_CTX* ctx, TPM2_STATS* stats);
+/* Copies the attached statistics */
+WOLFTPM_API TPM_RC TPM2_GetStats(TPM2_CTX* ctx, TPM2_STATS* stats);
+#endif
 WOLFTPM_API int    TPM2_GetSessionAuthCount(TPM2_CTX* ctx);
 
 WOLFTPM_API void      TPM2_SetActiveCtx(TPM2_CTX* ctx);
@@ -0,0 +1,175 @@
+/* tpm2_async.h
+ *
+ * Copyright (C) 2006-2020 wolfSSL Inc.
+ *
+ * This file is part of wolfTPM.
+ *
+ * wolfTPM is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfTPM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef _TPM2_ASYNC_H_
+#define _TPM2_ASYNC_H_
+
+#include <wolftpm/tpm2.h>
+
+#ifdef WOLFTPM_ASYNC_QUEUE
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+/* Asynchronous TPM command submission
+ *
+ * Requests are placed on a per TPM2_CTX ring and executed in order by a
+ * dedicated service task that owns the TPM. The submitting task is free to
+ * do other (software crypto) work and later polls, waits or gets a completion
+ * callback. TPM2_Async_Start() creates the service task through an
+ * application callback, and the task calls TPM2_Async_ServiceTask(). That
+ * function returns after TPM2_Async_Stop(), so an RTOS task entry must wrap
+ * it and delete the task afterwards. Without a service task
+ * TPM2_Async_Wait() will run queued requests on the calling task.
+ */
+
+#ifndef WOLFTPM_ASYNC_QUEUE_SZ
+    #define WOLFTPM_ASYNC_QUEUE_SZ    8 /* must be power of 2 */
+#endif
+#ifndef WOLFTPM_ASYNC_STATS_CMDS
+    #define WOLFTPM_ASYNC_STATS_CMDS  8 /* unique command codes tracked */
+#endif
+
+/* Service task wait when the queue is empty. For an RTOS this should block,
+ * for example on a semaphore given by XTPM_ASYNC_WAKE, with a timeout */
+#ifndef XTPM_ASYNC_IDLE
+    #define XTPM_ASYNC_IDLE(queue) XTPM_WAIT()
+#endif
+/* Called after a request is queued or a stop is requested */
+#ifndef XTPM_ASYNC_WAKE
+    #define XTPM_ASYNC_WAKE(queue)
+#endif
+/* Wait between polls of a request or of the service task state. For an RTOS
+ * this should yield (for example vTaskDelay(1)) */
+#ifndef XTPM_ASYNC_YIELD
+    #define XTPM_ASYNC_YIELD() XTPM_WAIT()
+#endif
+
+typedef enum {
+    TPM2_ASYNC_STATE_IDLE = 0,
+    TPM2_ASYNC_STATE_QUEUED,
+    TPM2_ASYNC_STATE_RUNNING,
+    TPM2_ASYNC_STATE_DONE,
+} TPM2_ASYNC_STATE;
+
+typedef enum {
+    TPM2_ASYNC_TASK_NONE = 0,
+    TPM2_ASYNC_TASK_STARTING,  /* task being created by TPM2_Async_Start */
+    TPM2_ASYNC_TASK_RUNNING,
+    TPM2_ASYNC_TASK_STOPPING,  /* stop requested, draining the queue */
+    TPM2_ASYNC_TASK_STOPPED,   /* service task has returned */
+} TPM2_ASYNC_TASK_STATE;
+
+typedef struct TPM2_ASYNC_REQ TPM2_ASYNC_REQ;
+
+/* Performs the (blocking) TPM command(s) for a request on the service task */
+typedef TPM_RC (*TPM2AsyncCmdCb)(TPM2_ASYNC_REQ* req);
+/* Optional completion callback, called on the service task */
+typedef void (*TPM2AsyncDoneCb)(TPM2_ASYNC_REQ* req);
+/* Creates a task that calls TPM2_Async_ServiceTask(ctx). Returns 0 once the
+ * task is created */
+typedef int (*TPM2AsyncTaskCb)(TPM2_CTX* ctx, void* userCtx);
+
+struct TPM2_ASYNC_REQ {
+    TPM2AsyncCmdCb  cmdCb;
+    TPM2AsyncDoneCb doneCb;
+    void*           in;
+    void*           out;
+    void*           userCtx;
+    TPM_CC          cmdCode;    /* used for latency statistics */
+
+    /* set by async queue */
+    volatile int    state;      /* TPM2_ASYNC_STATE, DONE is stored with
+                                 * release after rc and the output */
+    TPM_RC          rc;
+    word32          submitUs;
+    word32          startUs;
+    word32          doneUs;
+};
+
+typedef struct TPM2_ASYNC_CMD_STATS {
+    TPM_CC cmdCode;
+    word32 count;
+    word32 waitUs;      /* total time queued */
+    word32 execUs;      /* total time executing */
+    word32 maxExecUs;
+} TPM2_ASYNC_CMD_STATS;
+
+typedef struct TPM2_ASYNC_STATS {
+    word32 submitted;
+    word32 completed;
+    word32 rejected;    /* queue full */
+    word32 depth;       /* current queue depth */
+    word32 maxDepth;
+    TPM2_ASYNC_CMD_STATS cmd[WOLFTPM_ASYNC_STATS_CMDS];
+} TPM2_ASYNC_STATS;
+
+typedef struct TPM2_ASYNC_QUEUE {
+    TPM2_ASYNC_REQ* ring[WOLFTPM_ASYNC_QUEUE_SZ];
+    word32 head;        /* producer index */
+    word32 tail;        /* consumer index */
+    volatile int task;  /* TPM2_ASYNC_TASK_STATE */
+    TPM2_ASYNC_STATS stats;
+#if !defined(WOLFTPM2_NO_WOLFCRYPT) && !defined(SINGLE_THREADED)
+    wolfSSL_Mutex lock;
+#endif
+} TPM2_ASYNC_QUEUE;
+
+
+WOLFTPM_API int TPM2_Async_Init(TPM2_CTX* ctx, TPM2_ASYNC_QUEUE* queue);
+/* Stops and joins the service task (if any) before freeing the queue lock */
+WOLFTPM_API int TPM2_Async_Cleanup(TPM2_CTX* ctx);
+
+/* Returns TPM_RC_SUCCESS when queued or BUFFER_E if the queue is full */
+WOLFTPM_API int TPM2_Async_Submit(TPM2_CTX* ctx, TPM2_ASYNC_REQ* req);
+/* Returns the request result or WC_PENDING_E if not complete */
+WOLFTPM_API int TPM2_Async_Poll(TPM2_ASYNC_REQ* req);
+WOLFTPM_API int TPM2_Async_Wait(TPM2_CTX* ctx, TPM2_ASYNC_REQ* req);
+
+/* Runs up to maxReqs queued requests (0 = all). Returns number processed */
+WOLFTPM_API int TPM2_Async_Service(TPM2_CTX* ctx, int maxReqs);
+/* Creates the service task with createCb and marks it running once created.
+ * Returns the createCb result, with the queue left without a task on error */
+WOLFTPM_API int TPM2_Async_Start(TPM2_CTX* ctx, TPM2AsyncTaskCb createCb,
+    void* userCtx);
+/* Service task body (arg is TPM2_CTX*). Returns after Stop once the queue is
+ * drained, or at once when not created by Start. Marking the task stopped is
+ * the last access to the queue */
+WOLFTPM_API void TPM2_Async_ServiceTask(void* arg);
+/* Requests a stop and waits until the service task has returned */
+WOLFTPM_API int TPM2_Async_Stop(TPM2_CTX* ctx);
+
+WOLFTPM_API int TPM2_Async_GetStats(TPM2_CTX* ctx, TPM2_ASYNC_STATS* stats);
+
+/* Async versions of commonly overlapped commands */
+WOLFTPM_API int TPM2_Async_GetRandom(TPM2_CTX* ctx, TPM2_ASYNC_REQ* req,
+    GetRandom_In* in, GetRandom_Out* out, TPM2AsyncDoneCb doneCb);
+WOLFTPM_API int TPM2_Async_PCR_Extend(TPM2_CTX* ctx, TPM2_ASYNC_REQ* req,
+    PCR_Extend_In* in, TPM2AsyncDoneCb doneCb);
+
+#ifdef __cplusplus
+    }  /* extern "C" */
+#endif
+
+#endif /* WOLFTPM_ASYNC_QUEUE */
+
+#endif /* _TPM2_ASYNC_H_ */
@@ -35,10 +35,21 @@ WOLFTPM_API int TPM2_KDFa(
     BYTE *key, UINT32 keySz
 );
 
-WOLFTPM_LOCAL int TPM2_CalcHmac(TPMI_ALG_HASH authHash, TPM2B_AUTH* auth,
+/* TPM2_KDFa with session->authHash. With WOLFTPM_SESSION_CACHE the HMAC pad
+ * states for keyIn are kept in the session (see TPM2_SessionHmacFree) */
+WOLFTPM_API int TPM2_KDFaSession(TPM2_AUTH_SESSION* session,
+    TPM2B_AUTH* keyIn, const char* label, TPM2B_NONCE* contextU,
+    TPM2B_NONCE* contextV, BYTE* key, UINT32 keySz);
+
+WOLFTPM_API int TPM2_CalcHmac(TPMI_ALG_HASH authHash, TPM2B_AUTH* auth,
+    const TPM2B_DIGEST* hash, const TPM2B_NONCE* nonceNew,
+    const TPM2B_NONCE* nonceOld, TPMA_SESSION sessionAttributes,
+    TPM2B_AUTH* hmac);
+WOLFTPM_API int TPM2_CalcSessionHmac(TPM2_AUTH_SESSION* session,
     const TPM2B_DIGEST* hash, const TPM2B_NONCE* nonceNew,
     const TPM2B_NONCE* nonceOld, TPMA_SESSION sessionAttributes,
     TPM2B_AUTH* hmac);
+WOLFTPM_API void TPM2_SessionHmacFree(TPM2_AUTH_SESSION* session);
 WOLFTPM_LOCAL int TPM2_CalcRpHash(TPMI_ALG_HASH authHash,
     TPM_CC cmdCode, BYTE* param, UINT32 paramSz, TPM2B_DIGEST* hash);
 WOLFTPM_LOCAL int TPM2_CalcCpHash(TPMI_ALG_HASH authHash, TPM_CC cmdCode,
@@ -45,6 +45,10 @@
 /* TPM2 IO for using TPM through a Socket connection */
 WOLFTPM_LOCAL int TPM2_SWTPM_SendCommand(TPM2_CTX* ctx, TPM2_Packet* packet);
 
+/* Ends the simulator session and closes the kept connection, the next
+ * command connects again */
+WOLFTPM_API int TPM2_SWTPM_Disconnect(TPM2_CTX* ctx);
+
 #ifdef __cplusplus
     }  /* extern "C" */
 #endif
@@ -41,6 +41,30 @@
 
 #define TPM_TIS_READY_MASK 0x01
 
+#ifdef WOLFTPM_TIS_STATS
+/* TIS register transactions (SPI chip select cycles) and bytes, including
+ * the 4 byte TIS header, for one command code */
+typedef struct TPM2_TIS_CC_STATS {
+    word32 cmds;
+    word32 xfers;
+    word32 bytes;
+} TPM2_TIS_CC_STATS;
+
+#define TPM2_TIS_STATS_CC_COUNT (TPM_CC_LAST - TPM_CC_FIRST + 1)
+
+typedef struct TPM2_TIS_STATS {
+    TPM2_TIS_CC_STATS cc[TPM2_TIS_STATS_CC_COUNT];
+    /* vendor commands and register access outside of a command */
+    TPM2_TIS_CC_STATS other;
+} TPM2_TIS_STATS;
+
+/* Attach (or detach with NULL) caller owned counters. TPM2_Init clears the
+ * context, so call this after init */
+WOLFTPM_API int TPM2_TIS_SetStats(TPM2_CTX* ctx, TPM2_TIS_STATS* stats);
+WOLFTPM_API TPM2_TIS_CC_STATS* TPM2_TIS_GetCcStats(TPM2_TIS_STATS* stats,
+    TPM_CC cc);
+#endif /* WOLFTPM_TIS_STATS */
+
 
 WOLFTPM_LOCAL int TPM2_TIS_GetBurstCount(TPM2_CTX* ctx, word16* burstCount);
 WOLFTPM_LOCAL int TPM2_TIS_SendCommand(TPM2_CTX* ctx, TPM2_Packet* packet);
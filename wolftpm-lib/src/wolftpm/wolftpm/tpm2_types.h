@@ -122,6 +122,8 @@ typedef int64_t  INT64;
     #define NOT_COMPILED_IN       -174  /* Feature not compiled in */
     #define BAD_MUTEX_E           -106  /* Bad mutex operation */
     #define WC_TIMEOUT_E          -107  /* timeout error */
+    #define WC_PENDING_E          -108  /* wolfCrypt operation pending (would block) */
+    #define BAD_STATE_E           -192  /* Bad state operation */
 
     /* Errors from wolfssl/error-ssl.h */
     #define SOCKET_ERROR_E        -308  /* error state on socket    */
@@ -132,6 +134,7 @@ typedef int64_t  INT64;
     #define XMEMCMP(s1,s2,n)  memcmp((s1),(s2),(n))
     #define XSTRLEN(s1)       strlen((s1))
     #define XSTRNCMP(s1,s2,n) strncmp((s1),(s2),(n))
+    #define XSNPRINTF         snprintf
 #endif /* !WOLFTPM_CUSTOM_TYPES */
 
     /* Endianess */
@@ -355,6 +358,24 @@ typedef int64_t  INT64;
 #endif
 #ifndef XTPM_WAIT
     #define XTPM_WAIT() /* just poll without delay by default */
+    /* without a poll delay there is nothing to back off */
+    #ifndef TPM_TIS_POLL_MAX_WAITS
+    #define TPM_TIS_POLL_MAX_WAITS 1
+    #endif
+#endif
+/* Wait for n poll intervals */
+#ifndef XTPM_WAIT_N
+    #define XTPM_WAIT_N(n) do {         \
+        int waitCnt_ = (n);             \
+        while (waitCnt_-- > 0) {        \
+            XTPM_WAIT();                \
+        }                               \
+    } while (0)
+#endif
+/* With WOLFTPM_TIS_COALESCE the poll interval doubles up to this many
+ * XTPM_WAIT() intervals while waiting on the TPM status */
+#ifndef TPM_TIS_POLL_MAX_WAITS
+#define TPM_TIS_POLL_MAX_WAITS 16
 #endif
 
 #ifndef BUFFER_ALIGNMENT
@@ -46,9 +46,52 @@ typedef struct WOLFTPM2_SESSION {
     TPMI_ALG_HASH   authHash;
 } WOLFTPM2_SESSION;
 
+#ifdef WOLFTPM_KEY_CACHE
+/* Transient key slot manager
+ *
+ * TPM's like the SLB9670 only have a few transient object slots. Keys added
+ * to the cache are swapped out LRU style with TPM2_ContextSave / FlushContext
+ * when the TPM runs out of object memory (or more than maxLoaded tracked keys
+ * are loaded) and brought back with TPM2_ContextLoad when next used by a
+ * wrapper function. The handle of a tracked key may change on reload, so the
+ * WOLFTPM2_KEY must stay at the same address while it is in the cache.
+ */
+#ifndef WOLFTPM_KEY_CACHE_SZ
+    #define WOLFTPM_KEY_CACHE_SZ 8 /* logical keys tracked */
+#endif
+
+typedef struct WOLFTPM2_KEY_CACHE_ENTRY {
+    WOLFTPM2_HANDLE* handle;    /* tracked key handle, NULL if unused */
+    word32           lastUse;
+    word16           saved:1;   /* evicted, needs ContextLoad before use */
+    word16           haveContext:1; /* context below is valid */
+    TPMS_CONTEXT     context;
+} WOLFTPM2_KEY_CACHE_ENTRY;
+
+typedef struct WOLFTPM2_KEY_CACHE_STATS {
+    word32 evictions;   /* keys flushed to free a slot */
+    word32 saves;       /* ContextSave's (an object context is reusable) */
+    word32 reloads;     /* keys brought back with ContextLoad */
+    word32 hits;        /* key was already loaded when used */
+    word32 tracked;     /* keys in cache */
+    word32 loaded;      /* tracked keys currently loaded */
+} WOLFTPM2_KEY_CACHE_STATS;
+
+typedef struct WOLFTPM2_KEY_CACHE {
+    WOLFTPM2_KEY_CACHE_ENTRY entry[WOLFTPM_KEY_CACHE_SZ];
+    word32 useCount;
+    int    maxLoaded;   /* 0 = learn the limit from TPM_RC_OBJECT_MEMORY */
+    int    fitLoaded;   /* tracked keys that fit with the other objects */
+    WOLFTPM2_KEY_CACHE_STATS stats;
+} WOLFTPM2_KEY_CACHE;
+#endif /* WOLFTPM_KEY_CACHE */
+
 typedef struct WOLFTPM2_DEV {
     TPM2_CTX ctx;
     TPM2_AUTH_SESSION session[MAX_SESSION_NUM];
+#ifdef WOLFTPM_KEY_CACHE
+    WOLFTPM2_KEY_CACHE* keyCache;
+#endif
 } WOLFTPM2_DEV;
 
 typedef struct WOLFTPM2_KEY {
@@ -337,6 +380,29 @@ WOLFTPM_API int wolfTPM2_UnloadHandles(WOLFTPM2_DEV* dev, word32 handleStart,
     word32 handleCount);
 WOLFTPM_API int wolfTPM2_UnloadHandles_AllTransient(WOLFTPM2_DEV* dev);
 
+#ifdef WOLFTPM_KEY_CACHE
+/* maxLoaded: tracked keys allowed loaded at once (0 = as many as fit) */
+WOLFTPM_API int wolfTPM2_KeyCacheInit(WOLFTPM2_DEV* dev,
+    WOLFTPM2_KEY_CACHE* cache, int maxLoaded);
+WOLFTPM_API int wolfTPM2_KeyCacheCleanup(WOLFTPM2_DEV* dev);
+/* Track a loaded key. Returns BUFFER_E if the cache is full */
+WOLFTPM_API int wolfTPM2_KeyCacheAdd(WOLFTPM2_DEV* dev, WOLFTPM2_KEY* key);
+/* Stop tracking a key, reloading it first if it was evicted */
+WOLFTPM_API int wolfTPM2_KeyCacheRemove(WOLFTPM2_DEV* dev, WOLFTPM2_KEY* key);
+WOLFTPM_API int wolfTPM2_KeyCacheGetStats(WOLFTPM2_DEV* dev,
+    WOLFTPM2_KEY_CACHE_STATS* stats);
+#endif
+
+#ifdef WOLFTPM_STATS
+/* Clears and attaches (or detaches with NULL) per command statistics */
+WOLFTPM_API int wolfTPM2_StatsInit(WOLFTPM2_DEV* dev, TPM2_STATS* stats);
+WOLFTPM_API int wolfTPM2_GetStats(WOLFTPM2_DEV* dev, TPM2_STATS* stats);
+/* Returns the JSON length (excluding the null) or BUFFER_E if buf is too
+ * small */
+WOLFTPM_API int wolfTPM2_StatsToJson(const TPM2_STATS* stats, char* buf,
+    word32 bufSz);
+#endif
+
 /* Utility functions */
 WOLFTPM_API int wolfTPM2_GetKeyTemplate_RSA(TPMT_PUBLIC* publicTemplate,
     TPMA_OBJECT objectAttributes);